@@ -33,10 +33,23 @@ typedef union _XSK_BUFFER_ADDRESS {
 
 C_ASSERT(sizeof(XSK_BUFFER_ADDRESS) == sizeof(UINT64));
 
+typedef enum _XSK_BUFFER_DESCRIPTOR_FLAGS {
+    XSK_BUFFER_DESCRIPTOR_FLAG_NONE = 0x0,
+    //
+    // The frame continues in the next descriptor of the same ring. A frame
+    // spans a chain of descriptors ending with the first descriptor that does
+    // not have this flag set.
+    //
+    XSK_BUFFER_DESCRIPTOR_FLAG_CONTINUED = 0x1,
+} XSK_BUFFER_DESCRIPTOR_FLAGS;
+
+DEFINE_ENUM_FLAG_OPERATORS(XSK_BUFFER_DESCRIPTOR_FLAGS);
+C_ASSERT(sizeof(XSK_BUFFER_DESCRIPTOR_FLAGS) == sizeof(UINT32));
+
 typedef struct _XSK_BUFFER_DESCRIPTOR {
     XSK_BUFFER_ADDRESS Address;
     UINT32 Length;
-    UINT32 Reserved;
+    UINT32 Flags; // XSK_BUFFER_DESCRIPTOR_FLAGS
 } XSK_BUFFER_DESCRIPTOR;
 
 typedef struct _XSK_FRAME_DESCRIPTOR {
@@ -100,6 +113,15 @@ typedef enum _XSK_NOTIFY_RESULT_FLAGS {
 DEFINE_ENUM_FLAG_OPERATORS(XSK_NOTIFY_RESULT_FLAGS)
 C_ASSERT(sizeof(XSK_NOTIFY_RESULT_FLAGS) == sizeof(UINT32));
 
+typedef struct _XSK_NOTIFY_SET_RESULT {
+    //
+    // The context supplied when the socket was added to the notification set.
+    //
+    VOID *Context;
+    XSK_NOTIFY_RESULT_FLAGS Flags;
+    UINT32 Reserved;
+} XSK_NOTIFY_SET_RESULT;
+
 //
 // Socket options
 //
@@ -238,6 +260,34 @@ XskGetNotifyAsyncResult(
     _Out_ XSK_NOTIFY_RESULT_FLAGS *Result
     );
 
+XDP_STATUS
+XskNotifySetCreate(
+    _Out_ HANDLE *NotifySet
+    );
+
+XDP_STATUS
+XskNotifySetAdd(
+    _In_ HANDLE NotifySet,
+    _In_ HANDLE Socket,
+    _In_ XSK_NOTIFY_FLAGS Flags,
+    _In_opt_ VOID *Context
+    );
+
+XDP_STATUS
+XskNotifySetRemove(
+    _In_ HANDLE NotifySet,
+    _In_ HANDLE Socket
+    );
+
+XDP_STATUS
+XskNotifySetWait(
+    _In_ HANDLE NotifySet,
+    _In_ UINT32 WaitTimeoutMilliseconds,
+    _Out_writes_to_(ResultCount, *ReadyCount) XSK_NOTIFY_SET_RESULT *Results,
+    _In_ UINT32 ResultCount,
+    _Out_ UINT32 *ReadyCount
+    );
+
 #define XSK_SOCKOPT_RX_ORIGINAL_LENGTH 1008
 
 #pragma warning(push)
@@ -258,6 +308,9 @@ typedef struct _XSK_FRAME_ORIGINAL_LENGTH {
 #define XSK_SOCKOPT_RX_FRAME_TIMESTAMP_EXTENSION 1012
 #define XSK_SOCKOPT_TX_OFFLOAD_TIMESTAMP 1013
 #define XSK_SOCKOPT_TX_FRAME_TIMESTAMP_EXTENSION 1014
+#define XSK_SOCKOPT_RX_ZERO_COPY 1015
+#define XSK_SOCKOPT_RX_MULTI_BUFFER 1016
+#define XSK_SOCKOPT_SHARED_UMEM 1017
 
 #include <xdp/details/afxdp.h>
 
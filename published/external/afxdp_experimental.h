@@ -11,6 +11,8 @@
 #ifndef AFXDP_EXPERIMENTAL_H
 #define AFXDP_EXPERIMENTAL_H
 
+#include <xdp/offload.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -46,8 +48,32 @@ typedef enum _XSK_POLL_MODE {
     // Expectation: XSK_RING_FLAG_NEED_POKE is usually TRUE.
     //
     XSK_POLL_MODE_SOCKET,
+
+    //
+    // Sets the XSK polling mode to a kernel busy loop while IO is flowing. If
+    // no IO is observed for the idle timeout, the socket reverts to the system
+    // default polling mode until the next RX frame or XskNotifySocket call.
+    // The idle timeout is set by XSK_SOCKOPT_POLL_ADAPTIVE_IDLE_TIMEOUT.
+    //
+    // Expectation: XSK_RING_FLAG_NEED_POKE is usually FALSE under load and
+    // varies when idle.
+    //
+    XSK_POLL_MODE_ADAPTIVE,
 } XSK_POLL_MODE;
 
+//
+// XSK_SOCKOPT_POLL_ADAPTIVE_IDLE_TIMEOUT
+//
+// Supports: set
+// Optval type: UINT32
+// Description: Sets the number of milliseconds without IO after which a socket
+//              in XSK_POLL_MODE_ADAPTIVE stops busy polling. The value must be
+//              non-zero, and takes effect the next time the socket checks for
+//              idleness. Default: 10.
+//
+
+#define XSK_SOCKOPT_POLL_ADAPTIVE_IDLE_TIMEOUT 1018
+
 //
 // XSK_SOCKOPT_TX_FRAME_LAYOUT_EXTENSION
 //
@@ -142,6 +168,78 @@ typedef enum _XSK_POLL_MODE {
 //
 #define XSK_SOCKOPT_RX_OFFLOAD_CHECKSUM 1007
 
+//
+// XSK_SOCKOPT_TX_FRAME_GSO_EXTENSION
+//
+// Supports: get
+// Optval type: UINT16
+// Description: Gets the XDP_FRAME_GSO descriptor extension for the TX frame
+//              ring. This requires the socket is bound, the TX ring size is
+//              set, and at least one socket option has enabled the GSO
+//              extension. The returned value is the offset of the XDP_FRAME_GSO
+//              structure from the start of each TX descriptor.
+//
+#define XSK_SOCKOPT_TX_FRAME_GSO_EXTENSION 1019
+
+//
+// XSK_SOCKOPT_TX_OFFLOAD_GSO
+//
+// Supports: set
+// Optval type: UINT32
+// Description: Sets whether segmentation transmit offload is enabled. This
+//              option requires the socket is bound and the TX frame ring size
+//              is not set. This option enables the XDP_FRAME_LAYOUT and
+//              XDP_FRAME_GSO extensions on the TX frame ring, and raises the
+//              maximum TX frame length to the interface's maximum segmentation
+//              offload size. Each TX frame with a nonzero MSS must describe its
+//              Ethernet, IP, and TCP or UDP headers in the layout extension.
+//              If the socket is bound to a queue that has already been
+//              activated by another socket without enabling segmentation
+//              offload, then enabling the offload on another socket is
+//              currently not supported. Disabling the offload after is has
+//              been enabled is also currently not supported.
+//
+#define XSK_SOCKOPT_TX_OFFLOAD_GSO 1020
+
+//
+// XSK_SOCKOPT_RX_FRAME_GRO_EXTENSION
+//
+// Supports: get
+// Optval type: UINT16
+// Description: Gets the XDP_FRAME_GRO descriptor extension for the RX frame
+//              ring. This requires the socket is bound, the RX ring size is
+//              set, and at least one socket option has enabled the GRO
+//              extension. The returned value is the offset of the XDP_FRAME_GRO
+//              structure from the start of each RX descriptor.
+//
+#define XSK_SOCKOPT_RX_FRAME_GRO_EXTENSION 1021
+
+//
+// XSK_SOCKOPT_RX_OFFLOAD_GRO
+//
+// Supports: set
+// Optval type: UINT32
+// Description: Sets whether UDP receive coalescing is enabled. This option
+//              requires the socket is bound and the RX frame ring size is not
+//              set. This option enables the XDP_FRAME_GRO extension on the RX
+//              frame ring. Consecutive datagrams of the same UDP flow may be
+//              delivered as a single RX frame no larger than the socket's UMEM
+//              chunk size, less headroom; XDP_FRAME_GRO describes how to split
+//              the frame into datagrams. XDP programs on the queue inspect
+//              coalesced frames, and their actions apply to every coalesced
+//              datagram. Coalesced frames that a program transmits, or whose
+//              bounds or headers a program modifies, are dropped. Coalesced
+//              frames are also dropped rather than delivered, directly or via
+//              an XSKMAP, to sockets that have not enabled the offload.
+//              If the socket is bound to a queue that has already been
+//              activated by another socket without enabling receive
+//              coalescing, or with a larger UMEM chunk size, then enabling the
+//              offload on another socket is currently not supported. Disabling
+//              the offload after is has been enabled is also currently not
+//              supported.
+//
+#define XSK_SOCKOPT_RX_OFFLOAD_GRO 1022
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -41,6 +41,13 @@ struct _XDP_CAPABILITIES_EX {
     BOOLEAN RxChecksumSupported;
     BOOLEAN RxTimestampSupported;
     BOOLEAN TxTimestampSupported;
+    BOOLEAN RxBufferProviderSupported;
+    BOOLEAN RxGroSupported;
+    //
+    // The interface applies changes to the data offset and length of a
+    // frame's first buffer made during RX inspection.
+    //
+    BOOLEAN RxFrameBoundsAdjustmentSupported;
 } XDP_CAPABILITIES_EX;
 
 #define XDP_CAPABILITIES_EX_REVISION_1 1
@@ -86,6 +86,11 @@ typedef enum _XDP_RX_ACTION {
     XDP_RX_ACTION_DROP,
     XDP_RX_ACTION_PASS,
     XDP_RX_ACTION_TX,
+    //
+    // The frame's buffer was posted by the RX queue's buffer provider and has
+    // been returned to the provider. The interface must not reuse the buffer.
+    //
+    XDP_RX_ACTION_CONSUMED,
 } XDP_RX_ACTION;
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
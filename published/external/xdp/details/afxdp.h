@@ -69,6 +69,17 @@ XskCreate(
 #define IOCTL_XSK_NOTIFY_ASYNC \
     CTL_CODE(FILE_DEVICE_NETWORK, 5, METHOD_NEITHER, FILE_WRITE_ACCESS)
 
+//
+// Define IOCTLs supported by an XSK notification set file handle.
+//
+
+#define IOCTL_XSK_NOTIFY_SET_ADD \
+    CTL_CODE(FILE_DEVICE_NETWORK, 6, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define IOCTL_XSK_NOTIFY_SET_REMOVE \
+    CTL_CODE(FILE_DEVICE_NETWORK, 7, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define IOCTL_XSK_NOTIFY_SET_WAIT \
+    CTL_CODE(FILE_DEVICE_NETWORK, 8, METHOD_NEITHER, FILE_WRITE_ACCESS)
+
 //
 // Input struct for IOCTL_XSK_BIND
 //
@@ -335,6 +346,132 @@ XskGetNotifyAsyncResult(
     return XDP_STATUS_SUCCESS;
 }
 
+inline
+XDP_STATUS
+XskNotifySetCreate(
+    _Out_ HANDLE *NotifySet
+    )
+{
+    CHAR EaBuffer[XDP_OPEN_EA_LENGTH];
+
+    _XdpInitializeEa(XDP_OBJECT_TYPE_XSK_NOTIFY_SET, EaBuffer, sizeof(EaBuffer));
+
+    return
+        _XdpOpenObjectType(
+            NotifySet, FILE_CREATE, EaBuffer, sizeof(EaBuffer), XDP_OBJECT_TYPE_XSK_NOTIFY_SET);
+}
+
+//
+// Input struct for IOCTL_XSK_NOTIFY_SET_ADD
+//
+typedef struct _XSK_NOTIFY_SET_ADD_IN {
+    HANDLE Socket;
+    XSK_NOTIFY_FLAGS Flags;
+    VOID *Context;
+} XSK_NOTIFY_SET_ADD_IN;
+
+inline
+XDP_STATUS
+XskNotifySetAdd(
+    _In_ HANDLE NotifySet,
+    _In_ HANDLE Socket,
+    _In_ XSK_NOTIFY_FLAGS Flags,
+    _In_opt_ VOID *Context
+    )
+{
+    XSK_NOTIFY_SET_ADD_IN Add = {0};
+
+    Add.Socket = Socket;
+    Add.Flags = Flags;
+    Add.Context = Context;
+
+    return
+        _XdpIoctl(
+            NotifySet,
+            IOCTL_XSK_NOTIFY_SET_ADD,
+            &Add,
+            sizeof(Add),
+            NULL,
+            0,
+            NULL,
+            NULL,
+            FALSE);
+}
+
+//
+// Input struct for IOCTL_XSK_NOTIFY_SET_REMOVE
+//
+typedef struct _XSK_NOTIFY_SET_REMOVE_IN {
+    HANDLE Socket;
+} XSK_NOTIFY_SET_REMOVE_IN;
+
+inline
+XDP_STATUS
+XskNotifySetRemove(
+    _In_ HANDLE NotifySet,
+    _In_ HANDLE Socket
+    )
+{
+    XSK_NOTIFY_SET_REMOVE_IN Remove = {0};
+
+    Remove.Socket = Socket;
+
+    return
+        _XdpIoctl(
+            NotifySet,
+            IOCTL_XSK_NOTIFY_SET_REMOVE,
+            &Remove,
+            sizeof(Remove),
+            NULL,
+            0,
+            NULL,
+            NULL,
+            FALSE);
+}
+
+//
+// Input struct for IOCTL_XSK_NOTIFY_SET_WAIT
+//
+typedef struct _XSK_NOTIFY_SET_WAIT_IN {
+    UINT32 WaitTimeoutMilliseconds;
+} XSK_NOTIFY_SET_WAIT_IN;
+
+inline
+XDP_STATUS
+XskNotifySetWait(
+    _In_ HANDLE NotifySet,
+    _In_ UINT32 WaitTimeoutMilliseconds,
+    _Out_writes_to_(ResultCount, *ReadyCount) XSK_NOTIFY_SET_RESULT *Results,
+    _In_ UINT32 ResultCount,
+    _Out_ UINT32 *ReadyCount
+    )
+{
+    XDP_STATUS Res;
+    DWORD BytesReturned;
+    XSK_NOTIFY_SET_WAIT_IN Wait = {0};
+
+    Wait.WaitTimeoutMilliseconds = WaitTimeoutMilliseconds;
+
+    Res =
+        _XdpIoctl(
+            NotifySet,
+            IOCTL_XSK_NOTIFY_SET_WAIT,
+            &Wait,
+            sizeof(Wait),
+            Results,
+            ResultCount * sizeof(*Results),
+            &BytesReturned,
+            NULL,
+            FALSE);
+    if (XDP_FAILED(Res)) {
+        return Res;
+    }
+
+    *ReadyCount = (UINT32)BytesReturned;
+
+    return Res;
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
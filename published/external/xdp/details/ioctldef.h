@@ -91,6 +91,7 @@ typedef enum _XDP_OBJECT_TYPE {
     XDP_OBJECT_TYPE_XSK,
     XDP_OBJECT_TYPE_INTERFACE,
     XDP_OBJECT_TYPE_MAP,
+    XDP_OBJECT_TYPE_XSK_NOTIFY_SET,
 } XDP_OBJECT_TYPE;
 
 //
@@ -107,6 +108,7 @@ _XdpObjectTypeDeviceName(
     case XDP_OBJECT_TYPE_XSK:       return XDP_XSK_DEVICE_NAME;
     case XDP_OBJECT_TYPE_INTERFACE: return XDP_INTERFACE_DEVICE_NAME;
     case XDP_OBJECT_TYPE_MAP:       return XDP_MAP_DEVICE_NAME;
+    case XDP_OBJECT_TYPE_XSK_NOTIFY_SET: return XDP_XSK_DEVICE_NAME;
     default:                        return XDP_DEVICE_NAME;
     }
 }
@@ -125,6 +127,7 @@ _XdpObjectTypeDeviceClassGuid(
     case XDP_OBJECT_TYPE_XSK:       return &XDP_XSK_DEVICE_CLASS_GUID;
     case XDP_OBJECT_TYPE_INTERFACE: return &XDP_INTERFACE_DEVICE_CLASS_GUID;
     case XDP_OBJECT_TYPE_MAP:       return &XDP_MAP_DEVICE_CLASS_GUID;
+    case XDP_OBJECT_TYPE_XSK_NOTIFY_SET: return &XDP_XSK_DEVICE_CLASS_GUID;
     default:                        return &XDP_DEVICE_CLASS_GUID;
     }
 }
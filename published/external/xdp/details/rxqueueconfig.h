@@ -97,6 +97,8 @@ typedef struct _XDP_RX_QUEUE_CONFIG_ACTIVATE_DISPATCH {
     XDP_RX_QUEUE_GET_EXTENSION              *GetExtension;
     XDP_RX_QUEUE_ACTIVATE_IS_ENABLED        *IsVirtualAddressEnabled;
     XDP_RX_QUEUE_ACTIVATE_IS_ENABLED        *IsChecksumOffloadEnabled;
+    XDP_RX_QUEUE_ACTIVATE_IS_ENABLED        *IsBufferProviderEnabled;
+    XDP_RX_QUEUE_GET_RING                   *GetBufferProviderRing;
 } XDP_RX_QUEUE_CONFIG_ACTIVATE_DISPATCH;
 
 #define XDP_RX_QUEUE_CONFIG_ACTIVATE_DISPATCH_REVISION_1 1
@@ -219,4 +221,34 @@ XDPEXPORT(XdpRxQueueIsChecksumOffloadEnabled)(
     }
 }
 
+inline
+BOOLEAN
+XDPEXPORT(XdpRxQueueIsBufferProviderEnabled)(
+    _In_ XDP_RX_QUEUE_CONFIG_ACTIVATE RxQueueConfig
+    )
+{
+    XDP_RX_QUEUE_CONFIG_ACTIVATE_DETAILS *Details = (XDP_RX_QUEUE_CONFIG_ACTIVATE_DETAILS *)RxQueueConfig;
+    if (Details->Dispatch->Header.Revision == XDP_RX_QUEUE_CONFIG_ACTIVATE_DISPATCH_REVISION_1 &&
+        Details->Dispatch->Header.Size >= RTL_SIZEOF_THROUGH_FIELD(XDP_RX_QUEUE_CONFIG_ACTIVATE_DISPATCH, IsBufferProviderEnabled)) {
+        return Details->Dispatch->IsBufferProviderEnabled(RxQueueConfig);
+    } else {
+        return FALSE;
+    }
+}
+
+inline
+XDP_RING *
+XDPEXPORT(XdpRxQueueGetBufferProviderRing)(
+    _In_ XDP_RX_QUEUE_CONFIG_ACTIVATE RxQueueConfig
+    )
+{
+    XDP_RX_QUEUE_CONFIG_ACTIVATE_DETAILS *Details = (XDP_RX_QUEUE_CONFIG_ACTIVATE_DETAILS *)RxQueueConfig;
+    if (Details->Dispatch->Header.Revision == XDP_RX_QUEUE_CONFIG_ACTIVATE_DISPATCH_REVISION_1 &&
+        Details->Dispatch->Header.Size >= RTL_SIZEOF_THROUGH_FIELD(XDP_RX_QUEUE_CONFIG_ACTIVATE_DISPATCH, GetBufferProviderRing)) {
+        return Details->Dispatch->GetBufferProviderRing(RxQueueConfig);
+    } else {
+        return NULL;
+    }
+}
+
 EXTERN_C_END
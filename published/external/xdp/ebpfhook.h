@@ -15,7 +15,7 @@ extern "C" {
 typedef struct xdp_md {
     void *data;               ///< Pointer to start of packet data.
     void *data_end;           ///< Pointer to end of packet data.
-    uint64_t data_meta;       ///< Packet metadata.
+    uint64_t data_meta;       ///< Pointer to start of packet metadata, which ends at data.
     uint32_t ingress_ifindex; ///< Ingress interface index.
 
     /* size: 26, cachelines: 1, members: 4 */
@@ -25,9 +25,20 @@ typedef struct xdp_md {
 typedef enum _xdp_action {
     XDP_PASS = 1, ///< Allow the packet to pass.
     XDP_DROP,     ///< Drop the packet.
-    XDP_TX        ///< Bounce the received packet back out the same NIC it arrived on.
+    XDP_TX,       ///< Bounce the received packet back out the same NIC it arrived on.
+    XDP_REDIRECT  ///< Redirect the packet to the target chosen by bpf_xdp_redirect_map.
 } xdp_action_t;
 
+/**
+ * @brief Optional attach parameters for XDP programs. Programs attached with
+ * only an interface index cannot redirect packets.
+ */
+typedef struct xdp_attach_params {
+    uint32_t ifindex; ///< Interface index to attach to.
+    uint32_t reserved;
+    uint64_t xskmap;  ///< Handle of the XDP_MAP_TYPE_XSKMAP used by bpf_xdp_redirect_map.
+} xdp_attach_params_t;
+
 /**
  * @brief Handle an incoming packet as early as possible.
  *
@@ -37,6 +48,7 @@ typedef enum _xdp_action {
  * @retval XDP_PASS Allow the packet to pass.
  * @retval XDP_DROP Drop the packet.
  * @retval XDP_TX Bounce the received packet back out the same NIC it arrived on.
+ * @retval XDP_REDIRECT Redirect the packet to the target chosen by bpf_xdp_redirect_map.
  */
 typedef
 xdp_action_t
@@ -44,6 +56,128 @@ xdp_hook_t(
     xdp_md_t *context
     );
 
+#ifdef EBPF_HELPER
+
+typedef enum {
+    BPF_FUNC_xdp_adjust_head = EBPF_MAX_GENERAL_HELPER_FUNCTION + 1,
+    BPF_FUNC_xdp_redirect_map,
+    BPF_FUNC_xdp_adjust_tail,
+    BPF_FUNC_xdp_adjust_meta,
+    BPF_FUNC_xdp_load_bytes,
+    BPF_FUNC_xdp_store_bytes,
+    BPF_FUNC_xdp_get_buff_len,
+} ebpf_xdp_helper_id_t;
+
+/**
+ * @brief Move the start of the packet data by delta bytes. A negative delta
+ * grows the packet into its headroom; a positive delta shrinks it. Any
+ * metadata moves along with the start of the packet.
+ *
+ * @param[in] context Packet metadata.
+ * @param[in] delta Number of bytes to move the start of the packet by.
+ * @retval 0 The operation was successful.
+ * @retval <0 The adjusted packet would not fit within its buffer or would be
+ * shorter than an Ethernet header.
+ */
+EBPF_HELPER(int, bpf_xdp_adjust_head, (xdp_md_t *context, int delta));
+#ifndef __doxygen
+#define bpf_xdp_adjust_head ((bpf_xdp_adjust_head_t)BPF_FUNC_xdp_adjust_head)
+#endif
+
+/**
+ * @brief Select the AF_XDP socket at the given key of the XSKMAP the program
+ * was attached with as the target of an XDP_REDIRECT verdict.
+ *
+ * @param[in] context Packet metadata.
+ * @param[in] key Key of the XSKMAP entry.
+ * @param[in] flags The lower two bits are the action returned if no socket
+ * is present at the key, where zero selects XDP_DROP. All other bits must be
+ * zero.
+ * @returns XDP_REDIRECT on success, or the fallback action on failure.
+ */
+EBPF_HELPER(long, bpf_xdp_redirect_map, (xdp_md_t *context, uint32_t key, uint64_t flags));
+#ifndef __doxygen
+#define bpf_xdp_redirect_map ((bpf_xdp_redirect_map_t)BPF_FUNC_xdp_redirect_map)
+#endif
+
+/**
+ * @brief Move the end of the packet data by delta bytes. A positive delta
+ * grows the packet into its tailroom, which is zeroed; a negative delta
+ * shrinks it. Not supported for packets spanning multiple buffers.
+ *
+ * @param[in] context Packet metadata.
+ * @param[in] delta Number of bytes to move the end of the packet by.
+ * @retval 0 The operation was successful.
+ * @retval <0 The adjustment is not supported or does not fit the buffer.
+ */
+EBPF_HELPER(int, bpf_xdp_adjust_tail, (xdp_md_t *context, int delta));
+#ifndef __doxygen
+#define bpf_xdp_adjust_tail ((bpf_xdp_adjust_tail_t)BPF_FUNC_xdp_adjust_tail)
+#endif
+
+/**
+ * @brief Move the start of the metadata area preceding the packet data by
+ * delta bytes. A negative delta grows the metadata. The metadata length must
+ * be a multiple of four bytes, at most 32 bytes, and fit in the headroom.
+ * Metadata of packets redirected to AF_XDP sockets is delivered immediately
+ * before the packet data in the UMEM chunk, if it fits in the UMEM headroom.
+ *
+ * @param[in] context Packet metadata.
+ * @param[in] delta Number of bytes to move the start of the metadata by.
+ * @retval 0 The operation was successful.
+ * @retval <0 The adjusted metadata is not valid.
+ */
+EBPF_HELPER(int, bpf_xdp_adjust_meta, (xdp_md_t *context, int delta));
+#ifndef __doxygen
+#define bpf_xdp_adjust_meta ((bpf_xdp_adjust_meta_t)BPF_FUNC_xdp_adjust_meta)
+#endif
+
+/**
+ * @brief Copy bytes from the packet into a buffer. Unlike direct packet
+ * access, which is limited to the first buffer of the packet, this may read
+ * any part of packets spanning multiple buffers.
+ *
+ * @param[in] context Packet metadata.
+ * @param[in] offset Offset from the start of the packet data.
+ * @param[out] buffer Buffer to copy the packet bytes into.
+ * @param[in] length Number of bytes to copy.
+ * @retval 0 The operation was successful.
+ * @retval <0 The range exceeds the packet.
+ */
+EBPF_HELPER(int, bpf_xdp_load_bytes, (xdp_md_t *context, uint32_t offset, void *buffer, uint32_t length));
+#ifndef __doxygen
+#define bpf_xdp_load_bytes ((bpf_xdp_load_bytes_t)BPF_FUNC_xdp_load_bytes)
+#endif
+
+/**
+ * @brief Copy bytes from a buffer into the packet. This may write any part of
+ * packets spanning multiple buffers.
+ *
+ * @param[in] context Packet metadata.
+ * @param[in] offset Offset from the start of the packet data.
+ * @param[in] buffer Buffer to copy into the packet.
+ * @param[in] length Number of bytes to copy.
+ * @retval 0 The operation was successful.
+ * @retval <0 The range exceeds the packet.
+ */
+EBPF_HELPER(int, bpf_xdp_store_bytes, (xdp_md_t *context, uint32_t offset, const void *buffer, uint32_t length));
+#ifndef __doxygen
+#define bpf_xdp_store_bytes ((bpf_xdp_store_bytes_t)BPF_FUNC_xdp_store_bytes)
+#endif
+
+/**
+ * @brief Get the total length of the packet data across all of its buffers.
+ *
+ * @param[in] context Packet metadata.
+ * @returns The packet length in bytes.
+ */
+EBPF_HELPER(uint64_t, bpf_xdp_get_buff_len, (xdp_md_t *context));
+#ifndef __doxygen
+#define bpf_xdp_get_buff_len ((bpf_xdp_get_buff_len_t)BPF_FUNC_xdp_get_buff_len)
+#endif
+
+#endif // EBPF_HELPER
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -0,0 +1,27 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+#pragma once
+
+EXTERN_C_START
+
+#include <xdp/offload.h>
+
+#define XDP_FRAME_EXTENSION_GRO_NAME L"ms_frame_gro"
+#define XDP_FRAME_EXTENSION_GRO_VERSION_1 1U
+
+#include <xdp/extension.h>
+
+inline
+XDP_FRAME_GRO *
+XdpGetGroExtension(
+    _In_ XDP_FRAME *Frame,
+    _In_ XDP_EXTENSION *Extension
+    )
+{
+    return (XDP_FRAME_GRO *)XdpGetExtensionData(Frame, Extension);
+}
+
+EXTERN_C_END
@@ -0,0 +1,27 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+#pragma once
+
+EXTERN_C_START
+
+#include <xdp/offload.h>
+
+#define XDP_FRAME_EXTENSION_GSO_NAME L"ms_frame_gso"
+#define XDP_FRAME_EXTENSION_GSO_VERSION_1 1U
+
+#include <xdp/extension.h>
+
+inline
+XDP_FRAME_GSO *
+XdpGetGsoExtension(
+    _In_ XDP_FRAME *Frame,
+    _In_ XDP_EXTENSION *Extension
+    )
+{
+    return (XDP_FRAME_GSO *)XdpGetExtensionData(Frame, Extension);
+}
+
+EXTERN_C_END
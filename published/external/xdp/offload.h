@@ -9,8 +9,9 @@ EXTERN_C_START
 
 //
 // NOTE: The definitions in this header are for informational purposes only.
-//       All offload structures are currently unsupported by XDP and subject to
-//       significant changes.
+//       Except for XDP_FRAME_GSO on the transmit path and XDP_FRAME_GRO for UDP
+//       on the receive path, all offload structures are currently unsupported
+//       by XDP and subject to significant changes.
 //
 
 
@@ -19,6 +20,11 @@ EXTERN_C_START
 #pragma warning(disable:4214) // nonstandard extension used: bit field types other than int
 #pragma warning(disable:4201) // nonstandard extension used: nameless struct/union
 
+//
+// Requests segmentation of a transmit frame into segments carrying at most Mss
+// bytes of L4 payload. The frame's XDP_FRAME_LAYOUT extension describes the
+// headers replicated onto each segment. An Mss of zero disables segmentation.
+//
 typedef struct _XDP_FRAME_GSO {
     union {
         struct {
@@ -40,6 +46,13 @@ C_ASSERT(sizeof(XDP_FRAME_GSO) == 4);
 #pragma warning(default:4820) // warn if the compiler inserted padding
 #pragma warning(disable:4201) // nonstandard extension used: nameless struct/union
 
+//
+// Describes a receive frame coalesced from consecutive datagrams of one flow.
+// For UDP, the frame's headers are those of the first datagram, followed by
+// the payloads of all coalesced datagrams. Each payload is MessageSize bytes,
+// except the last, which may be shorter. A MessageSize of zero indicates the
+// frame was not coalesced.
+//
 typedef struct _XDP_FRAME_GRO {
     union {
         struct {
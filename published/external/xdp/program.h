@@ -40,6 +40,8 @@ typedef enum _XDP_MATCH_TYPE {
     XDP_MATCH_INNER_IPV6_DST_MASK_UDP,
     XDP_MATCH_ICMPV4_ECHO_REPLY_IP_DST,
     XDP_MATCH_ICMPV6_ECHO_REPLY_IP_DST,
+    XDP_MATCH_QUIC_FLOW_SRC_CID_MAP,
+    XDP_MATCH_QUIC_FLOW_DST_CID_MAP,
 } XDP_MATCH_TYPE;
 
 typedef union _XDP_INET_ADDR {
@@ -96,6 +98,11 @@ typedef enum _XDP_RULE_ACTION {
     XDP_PROGRAM_ACTION_REDIRECT,
     XDP_PROGRAM_ACTION_L2FWD,
     XDP_PROGRAM_ACTION_EBPF, // Reserved for internal use.
+    //
+    // Frames exceeding the rate specified in XDP_RATE_LIMIT_PARAMS are
+    // dropped; conforming frames are subject to the conform action.
+    //
+    XDP_PROGRAM_ACTION_RATE_LIMIT,
 } XDP_RULE_ACTION;
 
 typedef enum _XDP_REDIRECT_TARGET_TYPE {
@@ -111,17 +118,101 @@ typedef enum _XDP_REDIRECT_TARGET_TYPE {
     // not of the XSKMAP itself.
     //
     XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_QUEUEID,
+    //
+    // Redirect frames to the XSK found by looking up the frame's QUIC
+    // connection ID in the target map. The target must be a map of type
+    // XDP_MAP_TYPE_QUIC_CID, and the rule must use one of the
+    // XDP_MATCH_QUIC_FLOW_*_CID_MAP match types; frames whose CID is not
+    // present in the map do not match the rule.
+    //
+    XDP_REDIRECT_TARGET_TYPE_QUIC_CID_MAP,
+    //
+    // Apply the action of the entry found by looking up the frame's TCP or
+    // UDP flow in the target map. The target must be a map of type
+    // XDP_MAP_TYPE_HASH; frames whose flow is not present in the map do not
+    // match the rule.
+    //
+    XDP_REDIRECT_TARGET_TYPE_HASH_MAP_BY_FLOW,
+    //
+    // Apply the action of the entry with the longest prefix matching the
+    // frame's IP source address in the target map. The target must be a map
+    // of type XDP_MAP_TYPE_LPM; frames matching no prefix do not match the
+    // rule.
+    //
+    XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_SRC_ADDR,
+    //
+    // As above, using the frame's IP destination address.
+    //
+    XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_DST_ADDR,
+    //
+    // Redirect frames to the XSK at key == hash(frame's flow) % FlowHashWidth
+    // in the target XSKMAP. If no entry is present at that key, the frame is
+    // dropped. All frames of a TCP or UDP flow hash to the same key, so a
+    // single rule can spread a queue's traffic across up to
+    // XDP_REDIRECT_MAX_FLOW_HASH_WIDTH XSKs without reordering any flow. The
+    // hash is keyed by a secret chosen when XDP starts. Frames without an IP
+    // header use key == RX queue ID % FlowHashWidth. The target must be a map
+    // of type XDP_MAP_TYPE_XSKMAP.
+    //
+    XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_FLOW_HASH,
+    //
+    // Transmit frames on the XDP transmit queue identified by IfIndex and
+    // QueueId, which may belong to a different interface than the program.
+    // Frames are copied into buffers owned by XDP and returned to them upon
+    // transmit completion; frames are dropped if no buffer is available or
+    // if they exceed the interface's maximum buffer size. The Target handle
+    // must be NULL.
+    //
+    XDP_REDIRECT_TARGET_TYPE_INTERFACE_TX,
 } XDP_REDIRECT_TARGET_TYPE;
 
+#define XDP_REDIRECT_MAX_FLOW_HASH_WIDTH 128
+
 typedef struct _XDP_REDIRECT_PARAMS {
     XDP_REDIRECT_TARGET_TYPE TargetType;
-    HANDLE Target;
+    //
+    // For XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_FLOW_HASH, the number of XSKMAP
+    // keys, starting from zero, across which flows are spread. Must be between
+    // 1 and XDP_REDIRECT_MAX_FLOW_HASH_WIDTH. Ignored by other target types.
+    //
+    UINT32 FlowHashWidth;
+    union {
+        HANDLE Target;
+        //
+        // For XDP_REDIRECT_TARGET_TYPE_INTERFACE_TX, the index of the target
+        // interface and the ID of its transmit queue.
+        //
+        struct {
+            UINT32 IfIndex;
+            UINT32 QueueId;
+        };
+    };
 } XDP_REDIRECT_PARAMS;
 
 typedef struct _XDP_EBPF_PARAMS {
     HANDLE Target;
+    //
+    // Optional XSKMAP from which bpf_xdp_redirect_map selects XSKs.
+    //
+    HANDLE XskMap;
 } XDP_EBPF_PARAMS;
 
+typedef struct _XDP_RATE_LIMIT_PARAMS {
+    //
+    // The sustained rate, in frames per second, and the maximum burst, in
+    // frames, of the rate limit. Both must be non-zero. Each processor limits
+    // the frames it inspects independently, so the aggregate rate scales with
+    // the number of processors receiving matching frames.
+    //
+    UINT32 FramesPerSecond;
+    UINT32 BurstSize;
+    //
+    // The action applied to conforming frames: either XDP_PROGRAM_ACTION_PASS
+    // or XDP_PROGRAM_ACTION_L2FWD.
+    //
+    XDP_RULE_ACTION ConformAction;
+} XDP_RATE_LIMIT_PARAMS;
+
 typedef struct _XDP_RULE {
     XDP_MATCH_TYPE Match;
     XDP_MATCH_PATTERN Pattern;
@@ -129,9 +220,17 @@ typedef struct _XDP_RULE {
     union {
         XDP_REDIRECT_PARAMS Redirect;
         XDP_EBPF_PARAMS Ebpf;
+        XDP_RATE_LIMIT_PARAMS RateLimit;
     };
 } XDP_RULE;
 
+#ifdef _WIN64
+//
+// XDP_RULE arrays are passed to the kernel by size; its layout must not change.
+//
+C_ASSERT(sizeof(XDP_RULE) == 72);
+#endif
+
 #pragma warning(pop)
 
 #ifdef __cplusplus
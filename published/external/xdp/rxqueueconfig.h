@@ -131,6 +131,50 @@ XdpRxQueueIsLayoutExtensionEnabled(
     _In_ XDP_RX_QUEUE_CONFIG_ACTIVATE RxQueueConfig
     );
 
+BOOLEAN
+XdpRxQueueIsGroOffloadEnabled(
+    _In_ XDP_RX_QUEUE_CONFIG_ACTIVATE RxQueueConfig
+    );
+
+//
+// Returns the largest frame, including headers, the interface may produce by
+// coalescing datagrams when the XDP_FRAME_GRO extension is enabled.
+//
+UINT32
+XdpRxQueueGetGroMaximumFrameLength(
+    _In_ XDP_RX_QUEUE_CONFIG_ACTIVATE RxQueueConfig
+    );
+
+//
+// A receive buffer posted by an RX queue buffer provider. When a provider is
+// enabled, XDP produces buffers into the provider ring and the interface
+// consumes them in order, receiving frames directly into the provided buffers
+// without changing VirtualAddress. DataOffset and DataLength must lie within
+// BufferLength. A provided buffer remains owned by the interface, which may
+// reuse it, until XDP completes a frame in the buffer with
+// XDP_RX_ACTION_CONSUMED. If the provider ring is empty, the interface may call
+// XdpFlushReceive to request more buffers.
+//
+typedef struct _XDP_RX_PROVIDED_BUFFER {
+    UCHAR *VirtualAddress;
+    UINT32 BufferLength;
+    UINT32 Reserved;
+} XDP_RX_PROVIDED_BUFFER;
+
+BOOLEAN
+XdpRxQueueIsBufferProviderEnabled(
+    _In_ XDP_RX_QUEUE_CONFIG_ACTIVATE RxQueueConfig
+    );
+
+//
+// Returns the ring of XDP_RX_PROVIDED_BUFFER elements, or NULL if no buffer
+// provider is enabled.
+//
+XDP_RING *
+XdpRxQueueGetBufferProviderRing(
+    _In_ XDP_RX_QUEUE_CONFIG_ACTIVATE RxQueueConfig
+    );
+
 #include <xdp/details/rxqueueconfig.h>
 
 EXTERN_C_END
@@ -33,6 +33,13 @@ typedef struct _XDP_TX_CAPABILITIES {
     UINT8 MaximumFragments;
     BOOLEAN OutOfOrderCompletionEnabled;
     BOOLEAN ChecksumOffload;
+
+    //
+    // The largest frame, including headers, the interface can segment when
+    // the XDP_FRAME_GSO extension is enabled. Zero if segmentation offload is
+    // not supported.
+    //
+    UINT32 MaximumSegmentationOffloadSize;
 } XDP_TX_CAPABILITIES;
 
 
@@ -183,6 +190,11 @@ XdpTxQueueIsTimestampOffloadEnabled(
     _In_ XDP_TX_QUEUE_CONFIG_ACTIVATE TxQueueConfig
     );
 
+BOOLEAN
+XdpTxQueueIsSegmentationOffloadEnabled(
+    _In_ XDP_TX_QUEUE_CONFIG_ACTIVATE TxQueueConfig
+    );
+
 #include <xdp/details/txqueueconfig.h>
 
 EXTERN_C_END
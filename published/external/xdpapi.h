@@ -36,8 +36,57 @@ C_ASSERT(sizeof(XDP_CREATE_PROGRAM_FLAGS) == sizeof(UINT32));
 //
 typedef enum _XDP_MAP_TYPE {
     XDP_MAP_TYPE_XSKMAP = 0,
+    XDP_MAP_TYPE_QUIC_CID = 1,
+    XDP_MAP_TYPE_HASH = 2,
+    XDP_MAP_TYPE_LPM = 3,
 } XDP_MAP_TYPE;
 
+//
+// Key for XDP_MAP_TYPE_QUIC_CID maps. Only the first CidLength bytes of
+// CidData are significant.
+//
+typedef struct _XDP_QUIC_CID_MAP_KEY {
+    UCHAR CidLength;
+    UCHAR CidData[XDP_QUIC_MAX_CID_LENGTH];
+} XDP_QUIC_CID_MAP_KEY;
+
+//
+// Key for XDP_MAP_TYPE_HASH maps: a TCP or UDP flow. AddressFamily is AF_INET
+// or AF_INET6 and IpProtocol is IPPROTO_TCP or IPPROTO_UDP. Ports are in
+// network byte order. For IPv4 flows, address bytes beyond the Ipv4 member
+// are ignored. Reserved must be zero.
+//
+typedef struct _XDP_HASH_MAP_KEY {
+    UINT8 AddressFamily;
+    UINT8 IpProtocol;
+    UINT16 Reserved;
+    XDP_TUPLE Tuple;
+} XDP_HASH_MAP_KEY;
+
+//
+// Key for XDP_MAP_TYPE_LPM maps: an IPv4 or IPv6 prefix. AddressFamily is
+// AF_INET or AF_INET6. Address bits beyond PrefixLength are ignored. Reserved
+// must be zero.
+//
+typedef struct _XDP_LPM_MAP_KEY {
+    UINT8 AddressFamily;
+    UINT8 PrefixLength;
+    UINT16 Reserved;
+    XDP_INET_ADDR Address;
+} XDP_LPM_MAP_KEY;
+
+//
+// Value for XDP_MAP_TYPE_HASH and XDP_MAP_TYPE_LPM maps: the action applied to
+// frames matching the entry. Action is XDP_PROGRAM_ACTION_DROP,
+// XDP_PROGRAM_ACTION_PASS, or XDP_PROGRAM_ACTION_REDIRECT; for redirects, Xsk
+// is a handle to the AF_XDP socket receiving the frames, and is otherwise
+// ignored.
+//
+typedef struct _XDP_MAP_ACTION_VALUE {
+    XDP_RULE_ACTION Action;
+    HANDLE Xsk;
+} XDP_MAP_ACTION_VALUE;
+
 #if !defined(XDP_API_VERSION) || (XDP_API_VERSION <= XDP_API_VERSION_2)
 #include <xdp/xdpapi_v1.h>
 #else
@@ -28,6 +28,8 @@
 #include <xdp/framechecksum.h>
 #include <xdp/framechecksumextension.h>
 #include <xdp/framefragment.h>
+#include <xdp/framegroextension.h>
+#include <xdp/framegsoextension.h>
 #include <xdp/frameinterfacecontext.h>
 #include <xdp/framelayout.h>
 #include <xdp/framelayoutextension.h>
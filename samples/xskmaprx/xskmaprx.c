@@ -49,6 +49,12 @@ CONST CHAR *UsageText =
 "       - Native: Use the native XDP interface provider\n"
 "       Default: System\n"
 "\n"
+"   -RxZeroCopy\n"
+"\n"
+"       Receive directly into the UMEM of each socket. Requires a native XDP\n"
+"       interface that supports buffer providers. The sample fails if no\n"
+"       packets are received.\n"
+"\n"
 "   -TimeoutSeconds <Seconds>\n"
 "\n"
 "       Exit cleanly after the given number of seconds. 0 (default) runs\n"
@@ -59,6 +65,7 @@ CONST CHAR *UsageText =
 "   xskmaprx.exe -IfIndex 6 -QueueCount 4\n"
 "   xskmaprx.exe -IfIndex 6 -QueueCount 2 -UdpDstPort 9000\n"
 "   xskmaprx.exe -IfIndex 6 -QueueCount 1 -IcmpOnly -TimeoutSeconds 30\n"
+"   xskmaprx.exe -IfIndex 6 -QueueCount 2 -XdpMode Native -RxZeroCopy\n"
 ;
 
 #define LOGERR(...) \
@@ -85,6 +92,7 @@ UINT32 QueueCount;
 UINT16 UdpDstPort;
 BOOLEAN UseUdpMatch;
 BOOLEAN UseIcmpMatch;
+BOOLEAN RxZeroCopy;
 UINT32 TimeoutSeconds;
 XDP_CREATE_PROGRAM_FLAGS ProgramFlags;
 
@@ -101,6 +109,7 @@ ParseArgs(
     UdpDstPort = 0;
     UseUdpMatch = FALSE;
     UseIcmpMatch = FALSE;
+    RxZeroCopy = FALSE;
     TimeoutSeconds = 0;
     ProgramFlags = XDP_CREATE_PROGRAM_FLAG_ALL_QUEUES;
 
@@ -143,6 +152,8 @@ ParseArgs(
             }
         } else if (!_stricmp(ArgV[i], "-IcmpOnly")) {
             UseIcmpMatch = TRUE;
+        } else if (!_stricmp(ArgV[i], "-RxZeroCopy")) {
+            RxZeroCopy = TRUE;
         } else if (!_stricmp(ArgV[i], "-TimeoutSeconds")) {
             if (++i >= ArgC) {
                 LOGERR("Missing TimeoutSeconds");
@@ -231,6 +242,19 @@ SetupQueueSocket(
         return XdpStatus;
     }
 
+    //
+    // Zero-copy RX must be enabled before the rings are created.
+    //
+    if (RxZeroCopy) {
+        UINT32 Enabled = TRUE;
+
+        XdpStatus = XskSetSockopt(Ctx->Socket, XSK_SOCKOPT_RX_ZERO_COPY, &Enabled, sizeof(Enabled));
+        if (FAILED(XdpStatus)) {
+            LOGERR("XSK_SOCKOPT_RX_ZERO_COPY failed for queue %u: %x", QueueId, XdpStatus);
+            return XdpStatus;
+        }
+    }
+
     //
     // Configure RX and fill ring sizes.
     //
@@ -445,11 +469,12 @@ main(
                     Ctx->BytesReceived += Desc->Length;
 
                     //
-                    // Re-post the same UMEM offsets. The order doesn't matter;
-                    // just cycle through the buffer pool.
+                    // Re-post the chunk the frame was received into. Received
+                    // chunks are only returned once, so this never posts a
+                    // chunk still owned by the interface.
                     //
                     *(UINT64 *)XskRingGetElement(&Ctx->RxFillRing, FillIndex + j) =
-                        (UINT64)((RxIndex + j) % RX_RING_SIZE) * FRAME_SIZE;
+                        Desc->Address.BaseAddress;
                 }
 
                 Ctx->PacketsDropped += (Available - Filled);
@@ -461,6 +486,19 @@ main(
 
     PrintStats(Queues, QueueCount);
 
+    if (RxZeroCopy) {
+        UINT64 TotalPackets = 0;
+
+        for (UINT32 i = 0; i < QueueCount; i++) {
+            TotalPackets += Queues[i].PacketsReceived;
+        }
+
+        if (TotalPackets == 0) {
+            LOGERR("No packets received with zero-copy RX");
+            return 1;
+        }
+    }
+
     //
     // Clean up.
     //
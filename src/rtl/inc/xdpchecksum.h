@@ -9,6 +9,21 @@
 
 #pragma once
 
+#if defined(_M_AMD64)
+#include <intrin.h>
+#elif defined(_M_ARM64)
+#include <arm64_neon.h>
+#endif
+
+//
+// Buffers of at least this many bytes are summed using vector instructions on
+// architectures that support them. SSE2 and NEON are part of the x64 and ARM64
+// baselines, respectively, so no runtime CPU feature detection is required.
+//
+#if defined(_M_AMD64) || defined(_M_ARM64)
+#define XDP_CHECKSUM_SIMD_BLOCK_SIZE 64
+#endif
+
 inline
 FORCEINLINE
 UINT16
@@ -22,6 +37,116 @@ XdpChecksumFold(
     return (UINT16)Checksum;
 }
 
+inline
+FORCEINLINE
+UINT32
+XdpChecksumFold64(
+    _In_ UINT64 Checksum
+    )
+{
+    Checksum = (UINT32)Checksum + (Checksum >> 32);
+    Checksum = (UINT32)Checksum + (Checksum >> 32);
+
+    return (UINT32)Checksum;
+}
+
+//
+// Adds a buffer to a 64-bit ones' complement accumulator 32 bits at a time.
+// Since 2^16 and 2^32 are both congruent to 1 modulo 2^16 - 1, folding the
+// accumulator yields the same result as summing 16-bit words in host order.
+//
+inline
+FORCEINLINE
+UINT64
+XdpChecksumAccumulateScalar(
+    _In_reads_bytes_(BufferLength) CONST UCHAR *Buffer,
+    _In_ UINT32 BufferLength,
+    _In_ UINT64 Checksum
+    )
+{
+    while (BufferLength >= sizeof(UINT32)) {
+        Checksum += *(UNALIGNED CONST UINT32 *)Buffer;
+        Buffer += sizeof(UINT32);
+        BufferLength -= sizeof(UINT32);
+    }
+
+    if (BufferLength >= sizeof(UINT16)) {
+        Checksum += *(UNALIGNED CONST UINT16 *)Buffer;
+        Buffer += sizeof(UINT16);
+        BufferLength -= sizeof(UINT16);
+    }
+
+    if (BufferLength > 0) {
+        Checksum += *Buffer;
+    }
+
+    return Checksum;
+}
+
+#if defined(XDP_CHECKSUM_SIMD_BLOCK_SIZE)
+
+//
+// Sums a buffer whose length is a multiple of XDP_CHECKSUM_SIMD_BLOCK_SIZE.
+// Each 32-bit word is widened into a 64-bit lane, so the lanes cannot overflow
+// for any buffer addressable by a UINT32 length.
+//
+inline
+FORCEINLINE
+UINT64
+XdpChecksumAccumulateSimd(
+    _In_reads_bytes_(BufferLength) CONST UCHAR *Buffer,
+    _In_ UINT32 BufferLength
+    )
+{
+#if defined(_M_AMD64)
+    __m128i Zero = _mm_setzero_si128();
+    __m128i Sum0 = _mm_setzero_si128();
+    __m128i Sum1 = _mm_setzero_si128();
+
+    ASSERT((BufferLength % XDP_CHECKSUM_SIMD_BLOCK_SIZE) == 0);
+
+    for (UINT32 Offset = 0; Offset < BufferLength; Offset += XDP_CHECKSUM_SIMD_BLOCK_SIZE) {
+        __m128i Data0 = _mm_loadu_si128((CONST __m128i *)&Buffer[Offset]);
+        __m128i Data1 = _mm_loadu_si128((CONST __m128i *)&Buffer[Offset + 16]);
+        __m128i Data2 = _mm_loadu_si128((CONST __m128i *)&Buffer[Offset + 32]);
+        __m128i Data3 = _mm_loadu_si128((CONST __m128i *)&Buffer[Offset + 48]);
+
+        Sum0 = _mm_add_epi64(Sum0, _mm_unpacklo_epi32(Data0, Zero));
+        Sum1 = _mm_add_epi64(Sum1, _mm_unpackhi_epi32(Data0, Zero));
+        Sum0 = _mm_add_epi64(Sum0, _mm_unpacklo_epi32(Data1, Zero));
+        Sum1 = _mm_add_epi64(Sum1, _mm_unpackhi_epi32(Data1, Zero));
+        Sum0 = _mm_add_epi64(Sum0, _mm_unpacklo_epi32(Data2, Zero));
+        Sum1 = _mm_add_epi64(Sum1, _mm_unpackhi_epi32(Data2, Zero));
+        Sum0 = _mm_add_epi64(Sum0, _mm_unpacklo_epi32(Data3, Zero));
+        Sum1 = _mm_add_epi64(Sum1, _mm_unpackhi_epi32(Data3, Zero));
+    }
+
+    Sum0 = _mm_add_epi64(Sum0, Sum1);
+
+    return
+        (UINT64)_mm_cvtsi128_si64(Sum0) +
+        (UINT64)_mm_cvtsi128_si64(_mm_unpackhi_epi64(Sum0, Sum0));
+#elif defined(_M_ARM64)
+    uint64x2_t Sum0 = vdupq_n_u64(0);
+    uint64x2_t Sum1 = vdupq_n_u64(0);
+
+    ASSERT((BufferLength % XDP_CHECKSUM_SIMD_BLOCK_SIZE) == 0);
+
+    for (UINT32 Offset = 0; Offset < BufferLength; Offset += XDP_CHECKSUM_SIMD_BLOCK_SIZE) {
+        Sum0 = vpadalq_u32(Sum0, vreinterpretq_u32_u8(vld1q_u8(&Buffer[Offset])));
+        Sum1 = vpadalq_u32(Sum1, vreinterpretq_u32_u8(vld1q_u8(&Buffer[Offset + 16])));
+        Sum0 = vpadalq_u32(Sum0, vreinterpretq_u32_u8(vld1q_u8(&Buffer[Offset + 32])));
+        Sum1 = vpadalq_u32(Sum1, vreinterpretq_u32_u8(vld1q_u8(&Buffer[Offset + 48])));
+    }
+
+    Sum0 = vaddq_u64(Sum0, Sum1);
+
+    return vgetq_lane_u64(Sum0, 0) + vgetq_lane_u64(Sum0, 1);
+#endif
+}
+
+#endif // defined(XDP_CHECKSUM_SIMD_BLOCK_SIZE)
+
 inline
 FORCEINLINE
 UINT16
@@ -30,17 +155,20 @@ XdpPartialChecksum(
     _In_ UINT32 BufferLength
     )
 {
-    UINT32 Checksum = 0;
-    CONST UINT16 *Buffer16 = (CONST UINT16 *)Buffer;
+    CONST UCHAR *Buffer8 = (CONST UCHAR *)Buffer;
+    UINT64 Checksum = 0;
 
-    while (BufferLength >= sizeof(*Buffer16)) {
-        Checksum += *Buffer16++;
-        BufferLength -= sizeof(*Buffer16);
-    }
+#if defined(XDP_CHECKSUM_SIMD_BLOCK_SIZE)
+    if (BufferLength >= XDP_CHECKSUM_SIMD_BLOCK_SIZE) {
+        UINT32 SimdLength = BufferLength & ~(XDP_CHECKSUM_SIMD_BLOCK_SIZE - 1);
 
-    if (BufferLength > 0) {
-        Checksum += *(UCHAR *)Buffer16;
+        Checksum = XdpChecksumAccumulateSimd(Buffer8, SimdLength);
+        Buffer8 += SimdLength;
+        BufferLength -= SimdLength;
     }
+#endif
+
+    Checksum = XdpChecksumAccumulateScalar(Buffer8, BufferLength, Checksum);
 
-    return XdpChecksumFold(Checksum);
+    return XdpChecksumFold(XdpChecksumFold64(Checksum));
 }
@@ -0,0 +1,126 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+//
+// Provides software Toeplitz hashing, as used by RSS.
+//
+
+#pragma once
+
+//
+// The largest RSS secret key and hash input: an IPv6 address pair followed by
+// a TCP or UDP port pair.
+//
+#define XDP_TOEPLITZ_MAX_KEY_SIZE 40
+#define XDP_TOEPLITZ_MAX_INPUT_SIZE (2 * 16 + 2 * sizeof(UINT16))
+
+//
+// Precomputed hash contributions of every possible byte value at every input
+// byte position, derived from a secret key. Hashing an input then costs one
+// lookup and XOR per input byte.
+//
+typedef struct _XDP_TOEPLITZ_TABLE {
+    UINT32 Entries[XDP_TOEPLITZ_MAX_INPUT_SIZE][256];
+} XDP_TOEPLITZ_TABLE;
+
+//
+// Returns the 32 key bits starting at the given bit offset. Bits beyond the
+// end of the key are zero.
+//
+inline
+UINT32
+XdpToeplitzKeyWindow(
+    _In_reads_bytes_(KeyLength) CONST UCHAR *Key,
+    _In_ UINT32 KeyLength,
+    _In_ UINT32 BitOffset
+    )
+{
+    UINT64 Bits = 0;
+
+    for (UINT32 Index = BitOffset / 8; Index < BitOffset / 8 + sizeof(Bits); Index++) {
+        Bits = (Bits << 8) | (Index < KeyLength ? Key[Index] : 0);
+    }
+
+    return (UINT32)((Bits << (BitOffset % 8)) >> 32);
+}
+
+//
+// Computes the hash one input bit at a time. Used to validate the table-driven
+// implementation.
+//
+inline
+UINT32
+XdpToeplitzHashScalar(
+    _In_reads_bytes_(KeyLength) CONST UCHAR *Key,
+    _In_ UINT32 KeyLength,
+    _In_reads_bytes_(InputLength) CONST UCHAR *Input,
+    _In_ UINT32 InputLength
+    )
+{
+    UINT32 Hash = 0;
+
+    for (UINT32 Bit = 0; Bit < InputLength * 8; Bit++) {
+        if (Input[Bit / 8] & (0x80 >> (Bit % 8))) {
+            Hash ^= XdpToeplitzKeyWindow(Key, KeyLength, Bit);
+        }
+    }
+
+    return Hash;
+}
+
+inline
+VOID
+XdpToeplitzInitializeTable(
+    _Out_ XDP_TOEPLITZ_TABLE *Table,
+    _In_reads_bytes_(KeyLength) CONST UCHAR *Key,
+    _In_ UINT32 KeyLength
+    )
+{
+    for (UINT32 Position = 0; Position < XDP_TOEPLITZ_MAX_INPUT_SIZE; Position++) {
+        UINT32 *Entries = Table->Entries[Position];
+        UINT32 Windows[8];
+
+        //
+        // Windows[Bit] is the contribution of the byte's least significant bit
+        // plus Bit, i.e. input bit (Position * 8 + 7 - Bit).
+        //
+        for (UINT32 Bit = 0; Bit < RTL_NUMBER_OF(Windows); Bit++) {
+            Windows[Bit] = XdpToeplitzKeyWindow(Key, KeyLength, Position * 8 + 7 - Bit);
+        }
+
+        //
+        // Each value's contribution is its lowest set bit's window combined
+        // with the already computed contribution of the remaining bits.
+        //
+        Entries[0] = 0;
+        for (UINT32 Value = 1; Value < RTL_NUMBER_OF(Table->Entries[0]); Value++) {
+            UINT32 LowestBit = 0;
+
+            while ((Value & (1 << LowestBit)) == 0) {
+                LowestBit++;
+            }
+
+            Entries[Value] = Entries[Value & (Value - 1)] ^ Windows[LowestBit];
+        }
+    }
+}
+
+inline
+FORCEINLINE
+UINT32
+XdpToeplitzHash(
+    _In_ CONST XDP_TOEPLITZ_TABLE *Table,
+    _In_reads_bytes_(InputLength) CONST UCHAR *Input,
+    _In_range_(0, XDP_TOEPLITZ_MAX_INPUT_SIZE) UINT32 InputLength
+    )
+{
+    UINT32 Hash = 0;
+
+    for (UINT32 Position = 0; Position < InputLength; Position++) {
+        Hash ^= Table->Entries[Position][Input[Position]];
+    }
+
+    return Hash;
+}
@@ -144,6 +144,7 @@ XdpIrpCreate(
     STRING ActualEaName = {0};
     XDP_FILE_CREATE_ROUTINE *CreateRoutine = NULL;
     XDP_DEVICE_EXTENSION *DevExt;
+    XDP_OBJECT_TYPE DeviceObjectType;
 
 #ifdef _WIN64
     if (IoIs32bitProcess(Irp)) {
@@ -180,6 +181,7 @@ XdpIrpCreate(
         goto Exit;
     }
     OpenPacket = (XDP_OPEN_PACKET *)(EaBuffer->EaName + EaBuffer->EaNameLength + 1);
+    DeviceObjectType = OpenPacket->ObjectType;
 
     switch (OpenPacket->ObjectType) {
     case XDP_OBJECT_TYPE_PROGRAM:
@@ -198,6 +200,11 @@ XdpIrpCreate(
         CreateRoutine = XdpMapIrpCreate;
         break;
 
+    case XDP_OBJECT_TYPE_XSK_NOTIFY_SET:
+        CreateRoutine = XskIrpCreateNotifySet;
+        DeviceObjectType = XDP_OBJECT_TYPE_XSK;
+        break;
+
     default:
         Status = STATUS_INVALID_PARAMETER;
         goto Exit;
@@ -206,10 +213,11 @@ XdpIrpCreate(
     //
     // Validate that the requested object type is allowed on this device.
     // Per-type devices only allow their corresponding object type. The common
-    // device allows any type for backward compatibility.
+    // device allows any type for backward compatibility. XSK notification sets
+    // are only useful alongside XSKs, so they share the XSK device.
     //
     DevExt = (XDP_DEVICE_EXTENSION *)DeviceObject->DeviceExtension;
-    if (DevExt->IsPerTypeDevice && OpenPacket->ObjectType != DevExt->AllowedObjectType) {
+    if (DevExt->IsPerTypeDevice && DeviceObjectType != DevExt->AllowedObjectType) {
         Status = STATUS_INVALID_PARAMETER;
         goto Exit;
     }
@@ -394,6 +402,11 @@ XdpFastDeviceIoControl(
             XskFastIo(
                 FileObjHeader, InputBuffer, InputBufferLength, OutputBuffer,
                 OutputBufferLength, IoControlCode, IoStatus);
+    case XDP_OBJECT_TYPE_XSK_NOTIFY_SET:
+        return
+            XskNotifySetFastIo(
+                FileObjHeader, InputBuffer, InputBufferLength, OutputBuffer,
+                OutputBufferLength, IoControlCode, IoStatus);
     default:
         return FALSE;
     }
@@ -33,6 +33,76 @@ static const ebpf_helper_function_prototype_t EbpfXdpHelperFunctionPrototype[] =
             EBPF_ARGUMENT_TYPE_PTR_TO_CTX,
             EBPF_ARGUMENT_TYPE_ANYTHING,
         },
+        //
+        // Packet pointers must be reloaded after adjusting the packet.
+        //
+        .flags = { .reallocate_packet = TRUE },
+    },
+    {
+        .header = EBPF_HELPER_FUNCTION_PROTOTYPE_HEADER,
+        .helper_id = XDP_EXT_HELPER_FUNCTION_START + 2,
+        .name = "bpf_xdp_redirect_map",
+        .return_type = EBPF_RETURN_TYPE_INTEGER,
+        .arguments = {
+            EBPF_ARGUMENT_TYPE_PTR_TO_CTX,
+            EBPF_ARGUMENT_TYPE_ANYTHING,
+            EBPF_ARGUMENT_TYPE_ANYTHING,
+        },
+    },
+    {
+        .header = EBPF_HELPER_FUNCTION_PROTOTYPE_HEADER,
+        .helper_id = XDP_EXT_HELPER_FUNCTION_START + 3,
+        .name = "bpf_xdp_adjust_tail",
+        .return_type = EBPF_RETURN_TYPE_INTEGER,
+        .arguments = {
+            EBPF_ARGUMENT_TYPE_PTR_TO_CTX,
+            EBPF_ARGUMENT_TYPE_ANYTHING,
+        },
+        .flags = { .reallocate_packet = TRUE },
+    },
+    {
+        .header = EBPF_HELPER_FUNCTION_PROTOTYPE_HEADER,
+        .helper_id = XDP_EXT_HELPER_FUNCTION_START + 4,
+        .name = "bpf_xdp_adjust_meta",
+        .return_type = EBPF_RETURN_TYPE_INTEGER,
+        .arguments = {
+            EBPF_ARGUMENT_TYPE_PTR_TO_CTX,
+            EBPF_ARGUMENT_TYPE_ANYTHING,
+        },
+        .flags = { .reallocate_packet = TRUE },
+    },
+    {
+        .header = EBPF_HELPER_FUNCTION_PROTOTYPE_HEADER,
+        .helper_id = XDP_EXT_HELPER_FUNCTION_START + 5,
+        .name = "bpf_xdp_load_bytes",
+        .return_type = EBPF_RETURN_TYPE_INTEGER,
+        .arguments = {
+            EBPF_ARGUMENT_TYPE_PTR_TO_CTX,
+            EBPF_ARGUMENT_TYPE_ANYTHING,
+            EBPF_ARGUMENT_TYPE_PTR_TO_WRITABLE_MEM,
+            EBPF_ARGUMENT_TYPE_CONST_SIZE,
+        },
+    },
+    {
+        .header = EBPF_HELPER_FUNCTION_PROTOTYPE_HEADER,
+        .helper_id = XDP_EXT_HELPER_FUNCTION_START + 6,
+        .name = "bpf_xdp_store_bytes",
+        .return_type = EBPF_RETURN_TYPE_INTEGER,
+        .arguments = {
+            EBPF_ARGUMENT_TYPE_PTR_TO_CTX,
+            EBPF_ARGUMENT_TYPE_ANYTHING,
+            EBPF_ARGUMENT_TYPE_PTR_TO_READABLE_MEM,
+            EBPF_ARGUMENT_TYPE_CONST_SIZE,
+        },
+    },
+    {
+        .header = EBPF_HELPER_FUNCTION_PROTOTYPE_HEADER,
+        .helper_id = XDP_EXT_HELPER_FUNCTION_START + 7,
+        .name = "bpf_xdp_get_buff_len",
+        .return_type = EBPF_RETURN_TYPE_INTEGER,
+        .arguments = {
+            EBPF_ARGUMENT_TYPE_PTR_TO_CTX,
+        },
     },
 };
 
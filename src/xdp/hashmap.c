@@ -0,0 +1,231 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+//
+// Hash map implementation. Object lifetime, IRP / IOCTL dispatch, and the
+// global map read/write lock are all owned by the common XDP map code in
+// map.c; this file only provides the flow hash table storage and the per-type
+// callbacks that map.c invokes.
+//
+// A single rule referencing a hash map can steer any number of flows, each to
+// its own action, with a constant-time lookup per frame.
+//
+
+#include "precomp.h"
+#include "hashmap.h"
+
+//
+// Maximum number of entries in a hash map.
+//
+#define XDP_HASH_MAP_MAX_SIZE 0x1000000
+
+typedef struct _XDP_HASH_MAP {
+    XDP_MAP Map;
+
+    //
+    // Hash table of actions keyed by XDP_HASH_MAP_KEY. Protected by the global
+    // map lock.
+    //
+    XDP_MAP_TABLE Table;
+} XDP_HASH_MAP;
+
+const SIZE_T XdpHashMapAllocationSize = sizeof(XDP_HASH_MAP);
+
+C_ASSERT(sizeof(XDP_HASH_MAP_KEY) % sizeof(UINT32) == 0);
+
+static XDP_MAP_INITIALIZE XdpHashMapInitialize;
+static XDP_MAP_CLEANUP XdpHashMapCleanup;
+static XDP_MAP_INSERT XdpHashMapInsert;
+static XDP_MAP_DELETE XdpHashMapDelete;
+
+static
+NTSTATUS
+XdpHashMapCaptureKey(
+    _In_ KPROCESSOR_MODE RequestorMode,
+    _In_ const VOID *Key,
+    _Out_ XDP_HASH_MAP_KEY *CapturedKey
+    )
+{
+    NTSTATUS Status;
+
+    Status =
+        XdpMapCaptureFromMode(
+            RequestorMode, Key, sizeof(*CapturedKey), PROBE_ALIGNMENT(XDP_HASH_MAP_KEY),
+            CapturedKey);
+    if (!NT_SUCCESS(Status)) {
+        return Status;
+    }
+
+    if (CapturedKey->Reserved != 0 ||
+        (CapturedKey->IpProtocol != IPPROTO_TCP && CapturedKey->IpProtocol != IPPROTO_UDP)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    switch (CapturedKey->AddressFamily) {
+    case AF_INET:
+        //
+        // The data path builds keys with the unused IPv4 address bytes cleared.
+        //
+        RtlZeroMemory(
+            RTL_PTR_ADD(&CapturedKey->Tuple.SourceAddress, sizeof(IN_ADDR)),
+            sizeof(XDP_INET_ADDR) - sizeof(IN_ADDR));
+        RtlZeroMemory(
+            RTL_PTR_ADD(&CapturedKey->Tuple.DestinationAddress, sizeof(IN_ADDR)),
+            sizeof(XDP_INET_ADDR) - sizeof(IN_ADDR));
+        break;
+
+    case AF_INET6:
+        break;
+
+    default:
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+static
+VOID
+XdpHashMapInitialize(
+    _In_ XDP_MAP *Map
+    )
+{
+    XDP_HASH_MAP *HashMap = CONTAINING_RECORD(Map, XDP_HASH_MAP, Map);
+
+    XdpMapTableInitialize(&HashMap->Table, sizeof(XDP_HASH_MAP_KEY), RtlRandomNumber());
+}
+
+static
+VOID
+XdpHashMapCleanup(
+    _In_ XDP_MAP *Map
+    )
+{
+    XDP_HASH_MAP *HashMap = CONTAINING_RECORD(Map, XDP_HASH_MAP, Map);
+
+    XdpMapTableCleanup(&HashMap->Table);
+}
+
+static
+NTSTATUS
+XdpHashMapInsert(
+    _In_ XDP_MAP *Map,
+    _In_ KPROCESSOR_MODE RequestorMode,
+    _In_ const VOID *Key,
+    _In_ const VOID *Value
+    )
+{
+    XDP_HASH_MAP *HashMap = CONTAINING_RECORD(Map, XDP_HASH_MAP, Map);
+    XDP_HASH_MAP_KEY KeyValue;
+    XDP_MAP_TABLE_ENTRY *Entry = NULL;
+    BOOLEAN EntryInserted;
+    NTSTATUS Status;
+
+    Status = XdpHashMapCaptureKey(RequestorMode, Key, &KeyValue);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    Entry = ExAllocatePoolZero(NonPagedPoolNx, sizeof(*Entry), XDP_POOLTAG_MAP);
+    if (Entry == NULL) {
+        Status = STATUS_NO_MEMORY;
+        goto Exit;
+    }
+
+    C_ASSERT(sizeof(KeyValue) <= sizeof(Entry->Key));
+    RtlCopyMemory(Entry->Key, &KeyValue, sizeof(KeyValue));
+
+    Status = XdpMapCaptureActionValue(RequestorMode, Value, &Entry->Value);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    Status =
+        XdpMapTableUpsert(
+            &HashMap->Table, Entry, NULL, XDP_HASH_MAP_MAX_SIZE, &EntryInserted);
+    if (NT_SUCCESS(Status) && EntryInserted) {
+        Entry = NULL;
+    }
+
+Exit:
+
+    //
+    // Release the replaced value, or the new value if it was not inserted.
+    //
+    if (Entry != NULL) {
+        XdpMapReleaseActionValue(&Entry->Value);
+        ExFreePoolWithTag(Entry, XDP_POOLTAG_MAP);
+    }
+
+    return Status;
+}
+
+static
+NTSTATUS
+XdpHashMapDelete(
+    _In_ XDP_MAP *Map,
+    _In_ KPROCESSOR_MODE RequestorMode,
+    _In_ const VOID *Key
+    )
+{
+    XDP_HASH_MAP *HashMap = CONTAINING_RECORD(Map, XDP_HASH_MAP, Map);
+    XDP_MAP_TABLE *Table = &HashMap->Table;
+    XDP_HASH_MAP_KEY KeyValue;
+    XDP_MAP_TABLE_ENTRY **Link;
+    XDP_MAP_TABLE_ENTRY *OldEntry = NULL;
+    UINT32 Hash;
+    LOCK_STATE_EX LockState;
+    NTSTATUS Status;
+
+    Status = XdpHashMapCaptureKey(RequestorMode, Key, &KeyValue);
+    if (!NT_SUCCESS(Status)) {
+        return Status;
+    }
+
+    Hash = XdpMapTableHash(Table, (const UINT32 *)&KeyValue);
+
+    //
+    // The bucket array is not shrunk when entries are deleted.
+    //
+    XdpMapAcquireWrite(&LockState);
+    Link = XdpMapTableFind(Table, Hash, (const UINT32 *)&KeyValue);
+    if (Link != NULL) {
+        OldEntry = XdpMapTableRemove(Table, Link);
+    }
+    XdpMapReleaseWrite(&LockState);
+
+    if (OldEntry != NULL) {
+        XdpMapReleaseActionValue(&OldEntry->Value);
+        ExFreePoolWithTag(OldEntry, XDP_POOLTAG_MAP);
+    }
+
+    return STATUS_SUCCESS;
+}
+
+const XDP_MAP_TYPE_DISPATCH XdpHashMapTypeDispatch = {
+    .Initialize = XdpHashMapInitialize,
+    .Cleanup = XdpHashMapCleanup,
+    .Insert = XdpHashMapInsert,
+    .Delete = XdpHashMapDelete,
+};
+
+_IRQL_requires_(DISPATCH_LEVEL)
+const XDP_MAP_TABLE_VALUE *
+XdpHashMapLookup(
+    _In_ XDP_MAP *Map,
+    _In_ const XDP_HASH_MAP_KEY *Key
+    )
+{
+    XDP_HASH_MAP *HashMap;
+
+    ASSERT(Map->Type == XDP_MAP_TYPE_HASH);
+
+    HashMap = CONTAINING_RECORD(Map, XDP_HASH_MAP, Map);
+
+    //
+    // Caller must hold the global map read lock.
+    //
+    return XdpMapTableLookup(&HashMap->Table, (const UINT32 *)Key);
+}
@@ -0,0 +1,33 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+#pragma once
+
+//
+// Hash map: a hash table mapping TCP and UDP flows to actions. The hash map is
+// plugged into the common XDP map abstraction (see map.h) via
+// XdpHashMapTypeDispatch.
+//
+
+//
+// Allocation size for a hash map, used by map.c when creating a new map.
+//
+extern const SIZE_T XdpHashMapAllocationSize;
+
+//
+// Type dispatch table registered with the common map code.
+//
+extern const XDP_MAP_TYPE_DISPATCH XdpHashMapTypeDispatch;
+
+//
+// Look up the action stored for the given flow. Caller must hold the global
+// map read lock (see XdpMapAcquireRead). Returns NULL if no entry exists.
+//
+_IRQL_requires_(DISPATCH_LEVEL)
+const XDP_MAP_TABLE_VALUE *
+XdpHashMapLookup(
+    _In_ XDP_MAP *Map,
+    _In_ const XDP_HASH_MAP_KEY *Key
+    );
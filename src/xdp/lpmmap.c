@@ -0,0 +1,257 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+//
+// LPM map implementation. Object lifetime, IRP / IOCTL dispatch, and the
+// global map read/write lock are all owned by the common XDP map code in
+// map.c; this file only provides the prefix table storage and the per-type
+// callbacks that map.c invokes.
+//
+// Prefixes are stored in one hash table per prefix length, so a lookup costs
+// at most one hash probe per distinct prefix length in use, regardless of the
+// number of prefixes.
+//
+
+#include "precomp.h"
+#include "lpmmap.h"
+
+//
+// Maximum number of prefixes in an LPM map, across both address families.
+//
+#define XDP_LPM_MAP_MAX_SIZE 0x100000
+
+typedef struct _XDP_LPM_MAP {
+    XDP_MAP Map;
+
+    //
+    // Per-prefix length hash tables of actions. Protected by the global map
+    // lock.
+    //
+    XDP_LPM_TABLE Table;
+} XDP_LPM_MAP;
+
+const SIZE_T XdpLpmMapAllocationSize = sizeof(XDP_LPM_MAP);
+
+static XDP_MAP_INITIALIZE XdpLpmMapInitialize;
+static XDP_MAP_CLEANUP XdpLpmMapCleanup;
+static XDP_MAP_INSERT XdpLpmMapInsert;
+static XDP_MAP_DELETE XdpLpmMapDelete;
+
+static
+XDP_LPM_TABLE_FAMILY *
+XdpLpmMapGetFamily(
+    _In_ XDP_LPM_MAP *LpmMap,
+    _In_ ADDRESS_FAMILY AddressFamily
+    )
+{
+    switch (AddressFamily) {
+    case AF_INET:
+        return &LpmMap->Table.Ipv4;
+    case AF_INET6:
+        return &LpmMap->Table.Ipv6;
+    default:
+        return NULL;
+    }
+}
+
+static
+NTSTATUS
+XdpLpmMapCaptureKey(
+    _In_ XDP_LPM_MAP *LpmMap,
+    _In_ KPROCESSOR_MODE RequestorMode,
+    _In_ const VOID *Key,
+    _Out_ XDP_LPM_MAP_KEY *CapturedKey,
+    _Out_ XDP_LPM_TABLE_FAMILY **Family
+    )
+{
+    NTSTATUS Status;
+
+    Status =
+        XdpMapCaptureFromMode(
+            RequestorMode, Key, sizeof(*CapturedKey), PROBE_ALIGNMENT(XDP_LPM_MAP_KEY),
+            CapturedKey);
+    if (!NT_SUCCESS(Status)) {
+        return Status;
+    }
+
+    *Family = XdpLpmMapGetFamily(LpmMap, CapturedKey->AddressFamily);
+    if (*Family == NULL || CapturedKey->Reserved != 0 ||
+        CapturedKey->PrefixLength > (*Family)->MaxPrefixLength) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+static
+VOID
+XdpLpmMapInitialize(
+    _In_ XDP_MAP *Map
+    )
+{
+    XDP_LPM_MAP *LpmMap = CONTAINING_RECORD(Map, XDP_LPM_MAP, Map);
+
+    XdpLpmTableInitialize(&LpmMap->Table, RtlRandomNumber());
+}
+
+static
+VOID
+XdpLpmMapCleanup(
+    _In_ XDP_MAP *Map
+    )
+{
+    XDP_LPM_MAP *LpmMap = CONTAINING_RECORD(Map, XDP_LPM_MAP, Map);
+
+    for (UINT32 i = 0; i <= LpmMap->Table.Ipv4.MaxPrefixLength; i++) {
+        XdpMapTableCleanup(&LpmMap->Table.Ipv4.Prefixes[i]);
+    }
+
+    for (UINT32 i = 0; i <= LpmMap->Table.Ipv6.MaxPrefixLength; i++) {
+        XdpMapTableCleanup(&LpmMap->Table.Ipv6.Prefixes[i]);
+    }
+}
+
+static
+NTSTATUS
+XdpLpmMapInsert(
+    _In_ XDP_MAP *Map,
+    _In_ KPROCESSOR_MODE RequestorMode,
+    _In_ const VOID *Key,
+    _In_ const VOID *Value
+    )
+{
+    XDP_LPM_MAP *LpmMap = CONTAINING_RECORD(Map, XDP_LPM_MAP, Map);
+    XDP_LPM_TABLE_FAMILY *Family;
+    XDP_MAP_TABLE *Table;
+    XDP_LPM_MAP_KEY KeyValue;
+    XDP_MAP_TABLE_ENTRY *Entry = NULL;
+    BOOLEAN EntryInserted;
+    LOCK_STATE_EX LockState;
+    NTSTATUS Status;
+
+    Status = XdpLpmMapCaptureKey(LpmMap, RequestorMode, Key, &KeyValue, &Family);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    Table = &Family->Prefixes[KeyValue.PrefixLength];
+
+    Entry = ExAllocatePoolZero(NonPagedPoolNx, sizeof(*Entry), XDP_POOLTAG_MAP);
+    if (Entry == NULL) {
+        Status = STATUS_NO_MEMORY;
+        goto Exit;
+    }
+
+    XdpLpmTableMaskAddress(
+        Entry->Key, (const UINT8 *)&KeyValue.Address, Table->KeyLength, KeyValue.PrefixLength);
+
+    Status = XdpMapCaptureActionValue(RequestorMode, Value, &Entry->Value);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    //
+    // Publish the prefix length before the entry itself; until the entry is
+    // inserted, lookups merely probe an empty table.
+    //
+    XdpMapAcquireWrite(&LockState);
+    XdpLpmTableSetPrefixLength(Family, KeyValue.PrefixLength);
+    XdpMapReleaseWrite(&LockState);
+
+    Status =
+        XdpMapTableUpsert(
+            Table, Entry, &LpmMap->Table.EntryCount, XDP_LPM_MAP_MAX_SIZE, &EntryInserted);
+    if (NT_SUCCESS(Status) && EntryInserted) {
+        Entry = NULL;
+    }
+
+Exit:
+
+    //
+    // Release the replaced value, or the new value if it was not inserted.
+    //
+    if (Entry != NULL) {
+        XdpMapReleaseActionValue(&Entry->Value);
+        ExFreePoolWithTag(Entry, XDP_POOLTAG_MAP);
+    }
+
+    return Status;
+}
+
+static
+NTSTATUS
+XdpLpmMapDelete(
+    _In_ XDP_MAP *Map,
+    _In_ KPROCESSOR_MODE RequestorMode,
+    _In_ const VOID *Key
+    )
+{
+    XDP_LPM_MAP *LpmMap = CONTAINING_RECORD(Map, XDP_LPM_MAP, Map);
+    XDP_LPM_TABLE_FAMILY *Family;
+    XDP_MAP_TABLE *Table;
+    XDP_LPM_MAP_KEY KeyValue;
+    UINT32 MaskedAddress[sizeof(IN6_ADDR) / sizeof(UINT32)];
+    XDP_MAP_TABLE_ENTRY **Link;
+    XDP_MAP_TABLE_ENTRY *OldEntry = NULL;
+    UINT32 Hash;
+    LOCK_STATE_EX LockState;
+    NTSTATUS Status;
+
+    Status = XdpLpmMapCaptureKey(LpmMap, RequestorMode, Key, &KeyValue, &Family);
+    if (!NT_SUCCESS(Status)) {
+        return Status;
+    }
+
+    Table = &Family->Prefixes[KeyValue.PrefixLength];
+    XdpLpmTableMaskAddress(
+        MaskedAddress, (const UINT8 *)&KeyValue.Address, Table->KeyLength,
+        KeyValue.PrefixLength);
+    Hash = XdpMapTableHash(Table, MaskedAddress);
+
+    XdpMapAcquireWrite(&LockState);
+    Link = XdpMapTableFind(Table, Hash, MaskedAddress);
+    if (Link != NULL) {
+        OldEntry = XdpMapTableRemove(Table, Link);
+        LpmMap->Table.EntryCount--;
+    }
+    XdpMapReleaseWrite(&LockState);
+
+    if (OldEntry != NULL) {
+        XdpMapReleaseActionValue(&OldEntry->Value);
+        ExFreePoolWithTag(OldEntry, XDP_POOLTAG_MAP);
+    }
+
+    return STATUS_SUCCESS;
+}
+
+const XDP_MAP_TYPE_DISPATCH XdpLpmMapTypeDispatch = {
+    .Initialize = XdpLpmMapInitialize,
+    .Cleanup = XdpLpmMapCleanup,
+    .Insert = XdpLpmMapInsert,
+    .Delete = XdpLpmMapDelete,
+};
+
+_IRQL_requires_(DISPATCH_LEVEL)
+const XDP_MAP_TABLE_VALUE *
+XdpLpmMapLookup(
+    _In_ XDP_MAP *Map,
+    _In_ ADDRESS_FAMILY AddressFamily,
+    _In_ const XDP_INET_ADDR *Address
+    )
+{
+    XDP_LPM_MAP *LpmMap;
+    const XDP_LPM_TABLE_FAMILY *Family;
+
+    ASSERT(Map->Type == XDP_MAP_TYPE_LPM);
+
+    LpmMap = CONTAINING_RECORD(Map, XDP_LPM_MAP, Map);
+    Family = XdpLpmMapGetFamily(LpmMap, AddressFamily);
+    ASSERT(Family != NULL);
+
+    //
+    // Caller must hold the global map read lock.
+    //
+    return XdpLpmTableLookup(Family, (const UINT8 *)Address);
+}
@@ -0,0 +1,35 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+#pragma once
+
+//
+// LPM map: a longest prefix match table mapping IPv4 and IPv6 prefixes to
+// actions. The LPM map is plugged into the common XDP map abstraction (see
+// map.h) via XdpLpmMapTypeDispatch.
+//
+
+//
+// Allocation size for an LPM map, used by map.c when creating a new map.
+//
+extern const SIZE_T XdpLpmMapAllocationSize;
+
+//
+// Type dispatch table registered with the common map code.
+//
+extern const XDP_MAP_TYPE_DISPATCH XdpLpmMapTypeDispatch;
+
+//
+// Look up the action stored for the longest prefix matching Address. Caller
+// must hold the global map read lock (see XdpMapAcquireRead). Returns NULL if
+// no prefix matches.
+//
+_IRQL_requires_(DISPATCH_LEVEL)
+const XDP_MAP_TABLE_VALUE *
+XdpLpmMapLookup(
+    _In_ XDP_MAP *Map,
+    _In_ ADDRESS_FAMILY AddressFamily,
+    _In_ const XDP_INET_ADDR *Address
+    );
@@ -7,22 +7,26 @@
 // Common driver-side implementation for XDP_OBJECT_TYPE_MAP. Owns the map
 // object's lifetime, IRP dispatch, IOCTL dispatch, and the single global
 // read/write lock used to synchronize data path lookups against control
-// path mutations. Type-specific behavior is delegated to a per-type
-// dispatch table populated when the map is created.
+// path mutations for map types that require it. Type-specific behavior is
+// delegated to a per-type dispatch table populated when the map is created.
 //
 
 #include "precomp.h"
 #include "map.h"
 #include "xskmap.h"
+#include "quiccidmap.h"
+#include "hashmap.h"
+#include "lpmmap.h"
 
 //
-// Single global lock protecting the contents of all XDP maps. This is for
+// Single global lock protecting the contents of XDP maps. This is for
 // simplicity; the built-in maps are a late feature addition and the eBPF
 // equivalent maps provide full RCU semantics and are the preferred option.
+// XSKMAP lookups are on the hot path of every redirected frame, so XSKMAP
+// entries are instead published locklessly (see xskmap.c).
 //
 static PNDIS_RW_LOCK_EX XdpMapLock;
 
-static
 VOID
 XdpMapReference(
     _In_ XDP_MAP *Map
@@ -57,6 +61,15 @@ XdpMapGetTypeDispatch(
     case XDP_MAP_TYPE_XSKMAP:
         *AllocationSize = XdpXskMapAllocationSize;
         return &XdpXskMapTypeDispatch;
+    case XDP_MAP_TYPE_QUIC_CID:
+        *AllocationSize = XdpQuicCidMapAllocationSize;
+        return &XdpQuicCidMapTypeDispatch;
+    case XDP_MAP_TYPE_HASH:
+        *AllocationSize = XdpHashMapAllocationSize;
+        return &XdpHashMapTypeDispatch;
+    case XDP_MAP_TYPE_LPM:
+        *AllocationSize = XdpLpmMapAllocationSize;
+        return &XdpLpmMapTypeDispatch;
     default:
         *AllocationSize = 0;
         return NULL;
@@ -121,6 +134,11 @@ XdpMapIrpCreate(
     Map->Header.Dispatch = &XdpMapFileDispatch;
     Map->Type = MapOpen->Type;
     Map->TypeDispatch = TypeDispatch;
+
+    if (TypeDispatch->Initialize != NULL) {
+        TypeDispatch->Initialize(Map);
+    }
+
     IrpSp->FileObject->FsContext = Map;
 
     Status = STATUS_SUCCESS;
@@ -253,6 +271,207 @@ XdpMapReleaseWrite(
     NdisReleaseRWLock(XdpMapLock, LockState);
 }
 
+NTSTATUS
+XdpMapCaptureFromMode(
+    _In_ KPROCESSOR_MODE RequestorMode,
+    _In_ const VOID *Buffer,
+    _In_ SIZE_T Length,
+    _In_ ULONG Alignment,
+    _Out_writes_bytes_(Length) VOID *CapturedBuffer
+    )
+{
+    if (RequestorMode == KernelMode) {
+        RtlCopyMemory(CapturedBuffer, Buffer, Length);
+        return STATUS_SUCCESS;
+    }
+
+    __try {
+        ProbeForRead((VOID *)Buffer, Length, Alignment);
+        RtlCopyVolatileMemory(CapturedBuffer, Buffer, Length);
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        return GetExceptionCode();
+    }
+
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS
+XdpMapCaptureActionValue(
+    _In_ KPROCESSOR_MODE RequestorMode,
+    _In_ const VOID *Value,
+    _Out_ XDP_MAP_TABLE_VALUE *CapturedValue
+    )
+{
+    XDP_MAP_ACTION_VALUE ActionValue;
+    NTSTATUS Status;
+
+    RtlZeroMemory(CapturedValue, sizeof(*CapturedValue));
+
+    Status =
+        XdpMapCaptureFromMode(
+            RequestorMode, Value, sizeof(ActionValue), PROBE_ALIGNMENT(XDP_MAP_ACTION_VALUE),
+            &ActionValue);
+    if (!NT_SUCCESS(Status)) {
+        return Status;
+    }
+
+    switch (ActionValue.Action) {
+    case XDP_PROGRAM_ACTION_DROP:
+    case XDP_PROGRAM_ACTION_PASS:
+        break;
+
+    case XDP_PROGRAM_ACTION_REDIRECT:
+        //
+        // The handle has already been captured into kernel memory.
+        //
+        Status =
+            XskReferenceDatapathHandle(
+                RequestorMode, &ActionValue.Xsk, TRUE, &CapturedValue->Target);
+        if (!NT_SUCCESS(Status)) {
+            return Status;
+        }
+        break;
+
+    default:
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    CapturedValue->Action = ActionValue.Action;
+
+    return STATUS_SUCCESS;
+}
+
+VOID
+XdpMapReleaseActionValue(
+    _In_ const XDP_MAP_TABLE_VALUE *Value
+    )
+{
+    if (Value->Target != NULL) {
+        ASSERT(Value->Action == XDP_PROGRAM_ACTION_REDIRECT);
+        XskDereferenceDatapathHandle(Value->Target);
+    }
+}
+
+NTSTATUS
+XdpMapTableUpsert(
+    _Inout_ XDP_MAP_TABLE *Table,
+    _Inout_ XDP_MAP_TABLE_ENTRY *Entry,
+    _Inout_opt_ UINT32 *MapEntryCount,
+    _In_ UINT32 MaxEntryCount,
+    _Out_ BOOLEAN *EntryInserted
+    )
+{
+    XDP_MAP_TABLE_ENTRY **Link;
+    XDP_MAP_TABLE_ENTRY **NewBuckets = NULL;
+    XDP_MAP_TABLE_ENTRY **OldBuckets = NULL;
+    UINT32 NewBucketCount = 0;
+    UINT32 BucketCount;
+    LOCK_STATE_EX LockState;
+    NTSTATUS Status;
+
+    *EntryInserted = FALSE;
+    Entry->Hash = XdpMapTableHash(Table, Entry->Key);
+
+Retry:
+
+    XdpMapAcquireWrite(&LockState);
+
+    Link = XdpMapTableFind(Table, Entry->Hash, Entry->Key);
+    if (Link != NULL) {
+        //
+        // Replace the existing entry's value and hand the previous value back
+        // to the caller in the unused entry.
+        //
+        XDP_MAP_TABLE_VALUE OldValue = (*Link)->Value;
+        (*Link)->Value = Entry->Value;
+        Entry->Value = OldValue;
+        XdpMapReleaseWrite(&LockState);
+        Status = STATUS_SUCCESS;
+        goto Exit;
+    }
+
+    if (((MapEntryCount != NULL) ? *MapEntryCount : Table->EntryCount) >= MaxEntryCount) {
+        XdpMapReleaseWrite(&LockState);
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto Exit;
+    }
+
+    BucketCount = XdpMapTableGetGrowthBucketCount(Table);
+    if (BucketCount != 0) {
+        if (NewBucketCount < BucketCount) {
+            //
+            // Pool allocations are made outside the lock. Size the bucket
+            // array for the current table, then retry; concurrent inserts may
+            // require a larger array by the time the lock is reacquired.
+            //
+            XdpMapReleaseWrite(&LockState);
+
+            if (NewBuckets != NULL) {
+                ExFreePoolWithTag(NewBuckets, XDP_POOLTAG_MAP);
+            }
+
+            NewBuckets =
+                ExAllocatePoolZero(
+                    NonPagedPoolNx, sizeof(*NewBuckets) * BucketCount, XDP_POOLTAG_MAP);
+            if (NewBuckets == NULL) {
+                Status = STATUS_NO_MEMORY;
+                goto Exit;
+            }
+
+            NewBucketCount = BucketCount;
+            goto Retry;
+        }
+
+        OldBuckets = Table->Buckets;
+        XdpMapTableRehash(Table, NewBuckets, NewBucketCount);
+        NewBuckets = NULL;
+    }
+
+    XdpMapTableInsert(Table, Entry);
+    if (MapEntryCount != NULL) {
+        (*MapEntryCount)++;
+    }
+    XdpMapReleaseWrite(&LockState);
+
+    *EntryInserted = TRUE;
+    Status = STATUS_SUCCESS;
+
+Exit:
+
+    if (NewBuckets != NULL) {
+        ExFreePoolWithTag(NewBuckets, XDP_POOLTAG_MAP);
+    }
+
+    if (OldBuckets != NULL) {
+        ExFreePoolWithTag(OldBuckets, XDP_POOLTAG_MAP);
+    }
+
+    return Status;
+}
+
+VOID
+XdpMapTableCleanup(
+    _Inout_ XDP_MAP_TABLE *Table
+    )
+{
+    if (Table->Buckets == NULL) {
+        return;
+    }
+
+    for (UINT32 i = 0; i <= Table->BucketMask; i++) {
+        while (Table->Buckets[i] != NULL) {
+            XDP_MAP_TABLE_ENTRY *Entry = XdpMapTableRemove(Table, &Table->Buckets[i]);
+
+            XdpMapReleaseActionValue(&Entry->Value);
+            ExFreePoolWithTag(Entry, XDP_POOLTAG_MAP);
+        }
+    }
+
+    ASSERT(Table->EntryCount == 0);
+    ExFreePoolWithTag(Table->Buckets, XDP_POOLTAG_MAP);
+    Table->Buckets = NULL;
+}
+
 NTSTATUS
 XdpMapReadUInt32FromMode(
     _In_ KPROCESSOR_MODE RequestorMode,
@@ -7,6 +7,16 @@
 
 typedef struct _XDP_MAP XDP_MAP;
 
+//
+// Type-specific Initialize callback, invoked once on a newly allocated,
+// zero-initialized map before it is visible to any caller.
+//
+typedef
+VOID
+XDP_MAP_INITIALIZE(
+    _In_ XDP_MAP *Map
+    );
+
 typedef
 VOID
 XDP_MAP_CLEANUP(
@@ -41,6 +51,7 @@ XDP_MAP_DELETE(
     );
 
 typedef struct _XDP_MAP_TYPE_DISPATCH {
+    XDP_MAP_INITIALIZE *Initialize;
     XDP_MAP_CLEANUP *Cleanup;
     XDP_MAP_INSERT *Insert;
     XDP_MAP_DELETE *Delete;
@@ -77,6 +88,14 @@ XdpMapReferenceDatapathHandle(
     _Out_ XDP_MAP **Map
     );
 
+//
+// Takes an additional reference on a map already referenced by the caller.
+//
+VOID
+XdpMapReference(
+    _In_ XDP_MAP *Map
+    );
+
 VOID
 XdpMapDereferenceDatapathHandle(
     _In_ XDP_MAP *Map
@@ -126,3 +145,56 @@ VOID
 XdpMapReleaseWrite(
     _In_ _IRQL_restores_ LOCK_STATE_EX *LockState
     );
+
+//
+// Capture a fixed-size key or value buffer from the requestor's address space.
+//
+NTSTATUS
+XdpMapCaptureFromMode(
+    _In_ KPROCESSOR_MODE RequestorMode,
+    _In_ const VOID *Buffer,
+    _In_ SIZE_T Length,
+    _In_ ULONG Alignment,
+    _Out_writes_bytes_(Length) VOID *CapturedBuffer
+    );
+
+//
+// Capture an XDP_MAP_ACTION_VALUE, taking a reference on its XSK if the action
+// is a redirect. The reference is released by XdpMapReleaseActionValue.
+//
+NTSTATUS
+XdpMapCaptureActionValue(
+    _In_ KPROCESSOR_MODE RequestorMode,
+    _In_ const VOID *Value,
+    _Out_ XDP_MAP_TABLE_VALUE *CapturedValue
+    );
+
+VOID
+XdpMapReleaseActionValue(
+    _In_ const XDP_MAP_TABLE_VALUE *Value
+    );
+
+//
+// Insert an entry into a map table under the global map lock, growing the
+// table as needed. If the key is already present, the existing entry's value
+// is replaced and the previous value is returned in Entry, which remains owned
+// by the caller; otherwise, the table takes ownership of Entry and
+// *EntryInserted is set. MapEntryCount, if provided, is the number of entries
+// across all tables of the map, otherwise the table's own entry count is used.
+//
+NTSTATUS
+XdpMapTableUpsert(
+    _Inout_ XDP_MAP_TABLE *Table,
+    _Inout_ XDP_MAP_TABLE_ENTRY *Entry,
+    _Inout_opt_ UINT32 *MapEntryCount,
+    _In_ UINT32 MaxEntryCount,
+    _Out_ BOOLEAN *EntryInserted
+    );
+
+//
+// Release every entry of a map table that is no longer referenced.
+//
+VOID
+XdpMapTableCleanup(
+    _Inout_ XDP_MAP_TABLE *Table
+    );
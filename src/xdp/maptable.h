@@ -0,0 +1,394 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+#pragma once
+
+//
+// Chained hash table of fixed-size keys, and a longest prefix match table
+// built from one such hash table per prefix length. These are the storage
+// behind XDP_MAP_TYPE_HASH, XDP_MAP_TYPE_LPM, and XDP_MAP_TYPE_QUIC_CID maps.
+// The tables contain no synchronization of their own and do not depend on
+// the kernel, so the user-mode test harnesses include them directly.
+//
+
+//
+// Initial number of hash buckets. The bucket array doubles whenever the
+// number of entries reaches the number of buckets.
+//
+#define XDP_MAP_TABLE_INITIAL_BUCKETS 64
+
+#define XDP_MAP_TABLE_MAX_KEY_LENGTH sizeof(XDP_HASH_MAP_KEY)
+
+C_ASSERT(XDP_MAP_TABLE_MAX_KEY_LENGTH % sizeof(UINT32) == 0);
+
+//
+// QUIC CID keys are the CID length followed by the CID, zero padded to a
+// whole number of words.
+//
+#define XDP_MAP_TABLE_QUIC_CID_KEY_LENGTH \
+    ((1 + XDP_QUIC_MAX_CID_LENGTH + sizeof(UINT32) - 1) & ~(sizeof(UINT32) - 1))
+
+C_ASSERT(XDP_MAP_TABLE_QUIC_CID_KEY_LENGTH <= XDP_MAP_TABLE_MAX_KEY_LENGTH);
+
+//
+// The action applied to frames matching an entry. Target is an XSK kernel
+// handle if Action is XDP_PROGRAM_ACTION_REDIRECT, and NULL otherwise.
+//
+typedef struct _XDP_MAP_TABLE_VALUE {
+    XDP_RULE_ACTION Action;
+    VOID *Target;
+} XDP_MAP_TABLE_VALUE;
+
+typedef struct _XDP_MAP_TABLE_ENTRY XDP_MAP_TABLE_ENTRY;
+
+struct _XDP_MAP_TABLE_ENTRY {
+    XDP_MAP_TABLE_ENTRY *Next;
+    XDP_MAP_TABLE_VALUE Value;
+    UINT32 Hash;
+    UINT32 Key[XDP_MAP_TABLE_MAX_KEY_LENGTH / sizeof(UINT32)];
+};
+
+typedef struct _XDP_MAP_TABLE {
+    //
+    // Array of BucketMask + 1 bucket heads, or NULL if the table has never
+    // contained an entry.
+    //
+    XDP_MAP_TABLE_ENTRY **Buckets;
+    UINT32 BucketMask;
+    UINT32 EntryCount;
+
+    //
+    // Number of significant key bytes; a multiple of sizeof(UINT32).
+    //
+    UINT32 KeyLength;
+
+    //
+    // Seed for the hash function. Flow keys are chosen by remote peers, so
+    // each table uses a random seed to keep bucket placement unpredictable.
+    //
+    UINT32 Seed;
+} XDP_MAP_TABLE;
+
+inline
+VOID
+XdpMapTableInitialize(
+    _Out_ XDP_MAP_TABLE *Table,
+    _In_ UINT32 KeyLength,
+    _In_ UINT32 Seed
+    )
+{
+    ASSERT(KeyLength <= XDP_MAP_TABLE_MAX_KEY_LENGTH);
+    ASSERT(KeyLength % sizeof(UINT32) == 0);
+
+    RtlZeroMemory(Table, sizeof(*Table));
+    Table->KeyLength = KeyLength;
+    Table->Seed = Seed;
+}
+
+inline
+UINT32
+XdpMapTableHash(
+    _In_ const XDP_MAP_TABLE *Table,
+    _In_ const UINT32 *Key
+    )
+{
+    //
+    // MurmurHash3 (x86, 32-bit) over the key words.
+    //
+    UINT32 Hash = Table->Seed;
+
+    for (UINT32 i = 0; i < Table->KeyLength / sizeof(UINT32); i++) {
+        UINT32 Word = Key[i];
+
+        Word *= 0xcc9e2d51ui32;
+        Word = _rotl(Word, 15);
+        Word *= 0x1b873593ui32;
+
+        Hash ^= Word;
+        Hash = _rotl(Hash, 13);
+        Hash = Hash * 5 + 0xe6546b64ui32;
+    }
+
+    Hash ^= Table->KeyLength;
+    Hash ^= Hash >> 16;
+    Hash *= 0x85ebca6bui32;
+    Hash ^= Hash >> 13;
+    Hash *= 0xc2b2ae35ui32;
+    Hash ^= Hash >> 16;
+
+    return Hash;
+}
+
+inline
+XDP_MAP_TABLE_ENTRY **
+XdpMapTableFind(
+    _In_ const XDP_MAP_TABLE *Table,
+    _In_ UINT32 Hash,
+    _In_ const UINT32 *Key
+    )
+{
+    XDP_MAP_TABLE_ENTRY **Link;
+
+    if (Table->Buckets == NULL) {
+        return NULL;
+    }
+
+    //
+    // Return the link referencing the matching entry so callers can unlink
+    // it in place.
+    //
+    Link = &Table->Buckets[Hash & Table->BucketMask];
+
+    while (*Link != NULL) {
+        const XDP_MAP_TABLE_ENTRY *Entry = *Link;
+
+        if (Entry->Hash == Hash && RtlEqualMemory(Entry->Key, Key, Table->KeyLength)) {
+            return Link;
+        }
+
+        Link = &(*Link)->Next;
+    }
+
+    return NULL;
+}
+
+inline
+const XDP_MAP_TABLE_VALUE *
+XdpMapTableLookup(
+    _In_ const XDP_MAP_TABLE *Table,
+    _In_ const UINT32 *Key
+    )
+{
+    XDP_MAP_TABLE_ENTRY **Link;
+
+    if (Table->EntryCount == 0) {
+        return NULL;
+    }
+
+    Link = XdpMapTableFind(Table, XdpMapTableHash(Table, Key), Key);
+
+    return (Link != NULL) ? &(*Link)->Value : NULL;
+}
+
+inline
+VOID
+XdpMapTableInitializeQuicCidKey(
+    _Out_writes_bytes_(XDP_MAP_TABLE_QUIC_CID_KEY_LENGTH) UINT32 *Key,
+    _In_reads_bytes_(CidLength) const UINT8 *Cid,
+    _In_ UINT8 CidLength
+    )
+{
+    UINT8 *KeyBytes = (UINT8 *)Key;
+
+    ASSERT(CidLength <= XDP_QUIC_MAX_CID_LENGTH);
+
+    RtlZeroMemory(Key, XDP_MAP_TABLE_QUIC_CID_KEY_LENGTH);
+    KeyBytes[0] = CidLength;
+    RtlCopyMemory(&KeyBytes[1], Cid, CidLength);
+}
+
+//
+// Returns the number of buckets the table must grow to before another entry
+// can be inserted, or zero if the current bucket array suffices.
+//
+inline
+UINT32
+XdpMapTableGetGrowthBucketCount(
+    _In_ const XDP_MAP_TABLE *Table
+    )
+{
+    if (Table->Buckets == NULL) {
+        return XDP_MAP_TABLE_INITIAL_BUCKETS;
+    }
+
+    if (Table->EntryCount > Table->BucketMask) {
+        return (Table->BucketMask + 1) * 2;
+    }
+
+    return 0;
+}
+
+inline
+VOID
+XdpMapTableRehash(
+    _Inout_ XDP_MAP_TABLE *Table,
+    _Out_writes_(BucketCount) XDP_MAP_TABLE_ENTRY **Buckets,
+    _In_ UINT32 BucketCount
+    )
+{
+    //
+    // Move every entry into a new, zero-initialized bucket array whose size
+    // is a power of two. The caller owns the previous bucket array.
+    //
+    ASSERT(BucketCount > 0 && (BucketCount & (BucketCount - 1)) == 0);
+
+    if (Table->Buckets != NULL) {
+        for (UINT32 i = 0; i <= Table->BucketMask; i++) {
+            XDP_MAP_TABLE_ENTRY *Entry = Table->Buckets[i];
+
+            while (Entry != NULL) {
+                XDP_MAP_TABLE_ENTRY *Next = Entry->Next;
+                XDP_MAP_TABLE_ENTRY **Bucket = &Buckets[Entry->Hash & (BucketCount - 1)];
+
+                Entry->Next = *Bucket;
+                *Bucket = Entry;
+                Entry = Next;
+            }
+        }
+    }
+
+    Table->Buckets = Buckets;
+    Table->BucketMask = BucketCount - 1;
+}
+
+inline
+VOID
+XdpMapTableInsert(
+    _Inout_ XDP_MAP_TABLE *Table,
+    _Inout_ XDP_MAP_TABLE_ENTRY *Entry
+    )
+{
+    XDP_MAP_TABLE_ENTRY **Bucket;
+
+    //
+    // The caller must have initialized the entry's key and hash, ensured the
+    // key is not already present, and provided a bucket array.
+    //
+    ASSERT(Table->Buckets != NULL);
+    Bucket = &Table->Buckets[Entry->Hash & Table->BucketMask];
+    Entry->Next = *Bucket;
+    *Bucket = Entry;
+    Table->EntryCount++;
+}
+
+inline
+XDP_MAP_TABLE_ENTRY *
+XdpMapTableRemove(
+    _Inout_ XDP_MAP_TABLE *Table,
+    _Inout_ XDP_MAP_TABLE_ENTRY **Link
+    )
+{
+    XDP_MAP_TABLE_ENTRY *Entry = *Link;
+
+    ASSERT(Table->EntryCount > 0);
+    *Link = Entry->Next;
+    Table->EntryCount--;
+
+    return Entry;
+}
+
+#define XDP_LPM_TABLE_MAX_PREFIX_LENGTH (sizeof(IN6_ADDR) * 8)
+
+//
+// The prefixes of a single address family. Prefixes[i] contains the prefixes
+// of length i, keyed by the address with all bits beyond the prefix cleared.
+//
+typedef struct _XDP_LPM_TABLE_FAMILY {
+    UINT32 MaxPrefixLength;
+
+    //
+    // Bitmap of the prefix lengths which may contain entries. Lookups probe
+    // only these lengths, from the longest to the shortest. Bits are never
+    // cleared, so concurrent inserts and deletes cannot hide an entry; probing
+    // an emptied table returns immediately.
+    //
+    UINT64 PrefixLengths[(XDP_LPM_TABLE_MAX_PREFIX_LENGTH + 64) / 64];
+
+    XDP_MAP_TABLE Prefixes[XDP_LPM_TABLE_MAX_PREFIX_LENGTH + 1];
+} XDP_LPM_TABLE_FAMILY;
+
+typedef struct _XDP_LPM_TABLE {
+    XDP_LPM_TABLE_FAMILY Ipv4;
+    XDP_LPM_TABLE_FAMILY Ipv6;
+    UINT32 EntryCount;
+} XDP_LPM_TABLE;
+
+inline
+VOID
+XdpLpmTableInitialize(
+    _Out_ XDP_LPM_TABLE *Table,
+    _In_ UINT32 Seed
+    )
+{
+    RtlZeroMemory(Table, sizeof(*Table));
+
+    Table->Ipv4.MaxPrefixLength = sizeof(IN_ADDR) * 8;
+    for (UINT32 i = 0; i <= Table->Ipv4.MaxPrefixLength; i++) {
+        XdpMapTableInitialize(&Table->Ipv4.Prefixes[i], sizeof(IN_ADDR), Seed);
+    }
+
+    Table->Ipv6.MaxPrefixLength = sizeof(IN6_ADDR) * 8;
+    for (UINT32 i = 0; i <= Table->Ipv6.MaxPrefixLength; i++) {
+        XdpMapTableInitialize(&Table->Ipv6.Prefixes[i], sizeof(IN6_ADDR), Seed);
+    }
+}
+
+inline
+VOID
+XdpLpmTableMaskAddress(
+    _Out_writes_bytes_(AddressLength) UINT32 *MaskedAddress,
+    _In_reads_bytes_(AddressLength) const UINT8 *Address,
+    _In_ UINT32 AddressLength,
+    _In_ UINT32 PrefixLength
+    )
+{
+    UINT8 *Masked = (UINT8 *)MaskedAddress;
+    UINT32 FullBytes = PrefixLength / 8;
+
+    ASSERT(PrefixLength <= AddressLength * 8);
+
+    RtlCopyMemory(Masked, Address, FullBytes);
+
+    if (FullBytes < AddressLength) {
+        Masked[FullBytes] = Address[FullBytes] & (UINT8)(0xff00 >> (PrefixLength % 8));
+        RtlZeroMemory(&Masked[FullBytes + 1], AddressLength - FullBytes - 1);
+    }
+}
+
+inline
+VOID
+XdpLpmTableSetPrefixLength(
+    _Inout_ XDP_LPM_TABLE_FAMILY *Family,
+    _In_ UINT32 PrefixLength
+    )
+{
+    Family->PrefixLengths[PrefixLength / 64] |= 1ui64 << (PrefixLength % 64);
+}
+
+inline
+const XDP_MAP_TABLE_VALUE *
+XdpLpmTableLookup(
+    _In_ const XDP_LPM_TABLE_FAMILY *Family,
+    _In_reads_bytes_(Family->MaxPrefixLength / 8) const UINT8 *Address
+    )
+{
+    UINT32 MaskedAddress[sizeof(IN6_ADDR) / sizeof(UINT32)];
+
+    //
+    // Probe each populated prefix length, longest first. The cost is bounded
+    // by the number of distinct prefix lengths, not the number of prefixes.
+    //
+    for (INT32 Word = RTL_NUMBER_OF(Family->PrefixLengths) - 1; Word >= 0; Word--) {
+        UINT64 PrefixLengths = Family->PrefixLengths[Word];
+        ULONG Bit;
+
+        while (_BitScanReverse64(&Bit, PrefixLengths)) {
+            UINT32 PrefixLength = Word * 64 + Bit;
+            const XDP_MAP_TABLE *Table = &Family->Prefixes[PrefixLength];
+            const XDP_MAP_TABLE_VALUE *Value;
+
+            PrefixLengths &= ~(1ui64 << Bit);
+
+            XdpLpmTableMaskAddress(
+                MaskedAddress, Address, Family->MaxPrefixLength / 8, PrefixLength);
+            Value = XdpMapTableLookup(Table, MaskedAddress);
+            if (Value != NULL) {
+                return Value;
+            }
+        }
+    }
+
+    return NULL;
+}
@@ -54,6 +54,8 @@
 #include <xdp/framechecksum.h>
 #include <xdp/framechecksumextension.h>
 #include <xdp/framefragment.h>
+#include <xdp/framegroextension.h>
+#include <xdp/framegsoextension.h>
 #include <xdp/frameinterfacecontext.h>
 #include <xdp/framelayout.h>
 #include <xdp/framelayoutextension.h>
@@ -67,6 +69,7 @@
 #include <xdpassert.h>
 #include <xdpetw.h>
 #include <xdpif.h>
+#include <xdplifetime.h>
 #include <xdplwf.h>
 #include <xdppcw.h>
 #include <xdpnmrprovider.h>
@@ -74,6 +77,8 @@
 #include <xdprefcount.h>
 #include <xdpregistry.h>
 #include <xdprtl.h>
+#include <xdptimer.h>
+#include <xdptoeplitz.h>
 #include <xdprxqueue_internal.h>
 #include <xdptrace.h>
 #include <xdptransport.h>
@@ -97,7 +102,12 @@
 #include "rx.h"
 #include "tx.h"
 #include "xsk.h"
+#include "txredirect.h"
+#include "maptable.h"
 #include "map.h"
 #include "xskmap.h"
+#include "quiccidmap.h"
+#include "hashmap.h"
+#include "lpmmap.h"
 
 #endif // USER_MODE
@@ -12,17 +12,69 @@
 #include "programinspect.h"
 #include "program.tmh"
 
+//
+// Packet data passed to BPF_PROG_TEST_RUN is copied into a buffer with room to
+// adjust the head and tail of the packet, as on the data path.
+//
+#define EBPF_PROG_TEST_RUN_HEADROOM 256
+#define EBPF_PROG_TEST_RUN_TAILROOM 256
+
 typedef struct _EBPF_PROG_TEST_RUN_CONTEXT {
     char* Data;
     SIZE_T DataSize;
+    XDP_BUFFER Buffer;
 } EBPF_PROG_TEST_RUN_CONTEXT;
 
 typedef struct _EBPF_XDP_MD {
     EBPF_CONTEXT_HEADER;
     xdp_md_t Base;
     EBPF_PROG_TEST_RUN_CONTEXT* ProgTestRunContext;
+    XDP_MAP *XskMap;
+    VOID *RedirectTarget;
+
+    //
+    // The frame's first buffer and its virtual address, which the head, tail
+    // and metadata adjustment helpers update in place. Adjusting the tail is
+    // not supported for discontiguous frames.
+    //
+    XDP_BUFFER *Buffer;
+    UCHAR *BufferVa;
+
+    //
+    // The remaining buffers of discontiguous frames, which are only accessible
+    // via the load and store bytes helpers.
+    //
+    XDP_RING *FragmentRing;
+    XDP_EXTENSION *VirtualAddressExtension;
+    UINT32 FragmentIndex;
+    UINT32 FragmentCount;
+
+    //
+    // Whether the head and tail adjustment helpers may change the frame's
+    // data bounds, and whether the data may extend beyond its original start
+    // and end.
+    //
+    BOOLEAN BoundsAdjustable;
+    BOOLEAN BoundsExtendable;
+    UINT32 OriginalDataOffset;
+    UINT32 OriginalDataEnd;
 } EBPF_XDP_MD;
 
+//
+// The metadata area, if any, immediately precedes the packet data.
+//
+#define EBPF_XDP_MAX_METADATA_LENGTH 32
+
+static
+FORCEINLINE
+UINT32
+EbpfXdpGetMetadataLength(
+    _In_ const EBPF_XDP_MD *XdpMd
+    )
+{
+    return (UINT32)((UCHAR *)XdpMd->Base.data - (UCHAR *)(ULONG_PTR)XdpMd->Base.data_meta);
+}
+
 static __forceinline NTSTATUS EbpfResultToNtStatus(ebpf_result_t Result)
 {
     switch (Result) {
@@ -103,21 +155,43 @@ XdpCreateContext(
         goto Exit;
     }
 
-    // Allocate buffer for data.
-    XdpMd->ProgTestRunContext->Data = (char*)ExAllocatePoolZero(NonPagedPoolNx, DataSizeIn, XDP_POOLTAG_PROGRAM_CONTEXT);
+    if (DataSizeIn > MAXUINT32 - EBPF_PROG_TEST_RUN_HEADROOM - EBPF_PROG_TEST_RUN_TAILROOM) {
+        EbpfResult = EBPF_INVALID_ARGUMENT;
+        goto Exit;
+    }
+
+    // Allocate buffer for data, including headroom and tailroom.
+    XdpMd->ProgTestRunContext->Data =
+        (char*)ExAllocatePoolZero(
+            NonPagedPoolNx,
+            EBPF_PROG_TEST_RUN_HEADROOM + DataSizeIn + EBPF_PROG_TEST_RUN_TAILROOM,
+            XDP_POOLTAG_PROGRAM_CONTEXT);
     if (XdpMd->ProgTestRunContext->Data == NULL) {
         EbpfResult = EBPF_NO_MEMORY;
         goto Exit;
     }
-    memcpy(XdpMd->ProgTestRunContext->Data, DataIn, DataSizeIn);
+    memcpy(XdpMd->ProgTestRunContext->Data + EBPF_PROG_TEST_RUN_HEADROOM, DataIn, DataSizeIn);
     XdpMd->ProgTestRunContext->DataSize = DataSizeIn;
 
-    XdpMd->Base.data = (void*)XdpMd->ProgTestRunContext->Data;
-    XdpMd->Base.data_end = (void*)(XdpMd->ProgTestRunContext->Data + XdpMd->ProgTestRunContext->DataSize);
+    XdpMd->Buffer = &XdpMd->ProgTestRunContext->Buffer;
+    XdpMd->Buffer->DataOffset = EBPF_PROG_TEST_RUN_HEADROOM;
+    XdpMd->Buffer->DataLength = (UINT32)DataSizeIn;
+    XdpMd->Buffer->BufferLength =
+        EBPF_PROG_TEST_RUN_HEADROOM + (UINT32)DataSizeIn + EBPF_PROG_TEST_RUN_TAILROOM;
+    XdpMd->BufferVa = (UCHAR*)XdpMd->ProgTestRunContext->Data;
+    XdpMd->BoundsAdjustable = TRUE;
+    XdpMd->BoundsExtendable = TRUE;
+    XdpMd->OriginalDataOffset = XdpMd->Buffer->DataOffset;
+    XdpMd->OriginalDataEnd = XdpMd->Buffer->DataOffset + XdpMd->Buffer->DataLength;
+
+    XdpMd->Base.data = (void*)(XdpMd->BufferVa + XdpMd->Buffer->DataOffset);
+    XdpMd->Base.data_end = (void*)((char*)XdpMd->Base.data + DataSizeIn);
+
+    // The metadata area is initially empty. The input data_meta is ignored.
+    XdpMd->Base.data_meta = (UINT64)(ULONG_PTR)XdpMd->Base.data;
 
     if (context_in != NULL && ContextSizeIn >= sizeof(xdp_md_t)) {
         xdp_md_t* xdp_context = (xdp_md_t*)context_in;
-        XdpMd->Base.data_meta = xdp_context->data_meta;
         XdpMd->Base.ingress_ifindex = xdp_context->ingress_ifindex;
     }
 
@@ -177,8 +251,10 @@ XdpDeleteContext(
             context_size = sizeof(xdp_md_t);
         }
 
+        // Report the metadata length rather than a kernel address.
         xdp_md_t* XdpContextOut = (xdp_md_t*)ContextOut;
-        XdpContextOut->data_meta = XdpMd->Base.data_meta;
+        XdpContextOut->data_meta =
+            (char*)(XdpMd->Base.data) - (char*)(ULONG_PTR)(XdpMd->Base.data_meta);
         XdpContextOut->ingress_ifindex = XdpMd->Base.ingress_ifindex;
         *ContextSizeOut = context_size;
     } else {
@@ -199,16 +275,17 @@ Exit:
 static
 XDP_RX_ACTION
 XdpInvokeEbpf(
-    _In_ HANDLE EbpfTarget,
+    _In_ const XDP_EBPF_PARAMS *Ebpf,
     _In_ XDP_INSPECTION_CONTEXT *InspectionContext,
     _In_ XDP_FRAME *Frame,
+    _In_ UINT32 FrameIndex,
     _In_opt_ XDP_RING *FragmentRing,
     _In_opt_ XDP_EXTENSION *FragmentExtension,
     _In_ UINT32 FragmentIndex,
     _In_ XDP_EXTENSION *VirtualAddressExtension
     )
 {
-    const EBPF_EXTENSION_CLIENT *Client = (const EBPF_EXTENSION_CLIENT *)EbpfTarget;
+    const EBPF_EXTENSION_CLIENT *Client = (const EBPF_EXTENSION_CLIENT *)Ebpf->Target;
     const VOID *ClientBindingContext = EbpfExtensionClientGetClientContext(Client);
     XDP_PCW_RX_QUEUE *RxQueueStats = XdpRxQueueGetStatsFromInspectionContext(InspectionContext);
     XDP_INSPECTION_EBPF_CONTEXT *EbpfContext = &InspectionContext->EbpfContext;
@@ -219,8 +296,6 @@ XdpInvokeEbpf(
     XDP_RX_ACTION RxAction;
     UINT32 Result;
 
-    UNREFERENCED_PARAMETER(FragmentIndex);
-
     ASSERT((FragmentRing == NULL) || (FragmentExtension != NULL));
 
     //
@@ -233,18 +308,34 @@ XdpInvokeEbpf(
     // https://github.com/microsoft/ebpf-for-windows/issues/3576
     // https://github.com/microsoft/xdp-for-windows/issues/517
     //
-    if (FragmentRing != NULL &&
-        XdpGetFragmentExtension(Frame, FragmentExtension)->FragmentBufferCount != 0) {
+    XdpMd.FragmentRing = FragmentRing;
+    XdpMd.VirtualAddressExtension = VirtualAddressExtension;
+    XdpMd.FragmentIndex = FragmentIndex;
+    XdpMd.FragmentCount =
+        (FragmentRing != NULL) ?
+            XdpGetFragmentExtension(Frame, FragmentExtension)->FragmentBufferCount : 0;
+    if (XdpMd.FragmentCount != 0) {
         STAT_INC(RxQueueStats, InspectFramesDiscontiguous);
     }
 
     Buffer = &Frame->Buffer;
     Va = XdpGetVirtualAddressExtension(Buffer, VirtualAddressExtension)->VirtualAddress;
+
+    XdpMd.Buffer = Buffer;
+    XdpMd.BufferVa = Va;
+    XdpMd.ProgTestRunContext = NULL;
+    XdpMd.XskMap = Ebpf->XskMap;
+    XdpMd.RedirectTarget = NULL;
+    XdpMd.BoundsAdjustable = InspectionContext->FrameBoundsAdjustable;
+    XdpMd.BoundsExtendable = InspectionContext->FrameBoundsExtendable;
+    XdpMd.OriginalDataOffset = Buffer->DataOffset;
+    XdpMd.OriginalDataEnd = Buffer->DataOffset + Buffer->DataLength;
+
     Va += Buffer->DataOffset;
 
     XdpMd.Base.data = Va;
     XdpMd.Base.data_end = Va + Buffer->DataLength;
-    XdpMd.Base.data_meta = 0;
+    XdpMd.Base.data_meta = (UINT64)(ULONG_PTR)Va;
     XdpMd.Base.ingress_ifindex = InspectionContext->IfIndex;
 
     ebpf_program_batch_invoke_function_t EbpfInvokeProgram =
@@ -269,6 +360,24 @@ XdpInvokeEbpf(
         STAT_INC(RxQueueStats, InspectFramesForwarded);
         break;
 
+    case XDP_REDIRECT:
+        //
+        // The target was selected by bpf_xdp_redirect_map. Programs returning
+        // XDP_REDIRECT without a successful lookup have their frames dropped.
+        //
+        RxAction = XDP_RX_ACTION_DROP;
+
+        if (XdpMd.RedirectTarget != NULL) {
+            XdpRedirect(
+                &InspectionContext->RedirectContext, FrameIndex, FragmentIndex,
+                EbpfXdpGetMetadataLength(&XdpMd), XDP_REDIRECT_TARGET_TYPE_XSK,
+                XdpMd.RedirectTarget);
+            STAT_INC(RxQueueStats, InspectFramesRedirected);
+        } else {
+            STAT_INC(RxQueueStats, InspectFramesDropped);
+        }
+        break;
+
     default:
         ASSERT(FALSE);
         __fallthrough;
@@ -308,7 +417,7 @@ XdpInspectEbpf(
 
     return
         XdpInvokeEbpf(
-            Program->Rules[0].Ebpf.Target, InspectionContext, Frame, FragmentRing,
+            &Program->Rules[0].Ebpf, InspectionContext, Frame, FrameIndex, FragmentRing,
             FragmentExtension, FragmentIndex, VirtualAddressExtension);
 }
 
@@ -602,6 +711,24 @@ XdpProgramTrace(
                 Program, i, Rule->Pattern.IpMask.Address.Ipv6.u.Byte);
             break;
 
+        case XDP_MATCH_QUIC_FLOW_SRC_CID_MAP:
+            TraceInfo(
+                TRACE_CORE,
+                "Program=%p Rule[%u]=XDP_MATCH_QUIC_FLOW_SRC_CID_MAP "
+                "Port=%u CidOffset=%u CidLength=%u",
+                Program, i, ntohs(Rule->Pattern.QuicFlow.UdpPort),
+                Rule->Pattern.QuicFlow.CidOffset, Rule->Pattern.QuicFlow.CidLength);
+            break;
+
+        case XDP_MATCH_QUIC_FLOW_DST_CID_MAP:
+            TraceInfo(
+                TRACE_CORE,
+                "Program=%p Rule[%u]=XDP_MATCH_QUIC_FLOW_DST_CID_MAP "
+                "Port=%u CidOffset=%u CidLength=%u",
+                Program, i, ntohs(Rule->Pattern.QuicFlow.UdpPort),
+                Rule->Pattern.QuicFlow.CidOffset, Rule->Pattern.QuicFlow.CidLength);
+            break;
+
         default:
             ASSERT(FALSE);
             break;
@@ -638,8 +765,17 @@ XdpProgramTrace(
             TraceInfo(
                 TRACE_CORE,
                 "Program=%p Rule[%u] Action=XDP_PROGRAM_ACTION_EBPF "
-                "Target=%p",
-                Program, i, Rule->Ebpf.Target);
+                "Target=%p XskMap=%p",
+                Program, i, Rule->Ebpf.Target, Rule->Ebpf.XskMap);
+            break;
+
+        case XDP_PROGRAM_ACTION_RATE_LIMIT:
+            TraceInfo(
+                TRACE_CORE,
+                "Program=%p Rule[%u] Action=XDP_PROGRAM_ACTION_RATE_LIMIT "
+                "FramesPerSecond=%u BurstSize=%u ConformAction=%u",
+                Program, i, Rule->RateLimit.FramesPerSecond, Rule->RateLimit.BurstSize,
+                Rule->RateLimit.ConformAction);
             break;
 
         default:
@@ -647,6 +783,16 @@ XdpProgramTrace(
             break;
         }
     }
+
+    if (Program->Classifier != NULL) {
+        for (UINT32 i = 0; i < Program->Classifier->SegmentCount; i++) {
+            const XDP_PROGRAM_CLASSIFIER_SEGMENT *Segment = &Program->Classifier->Segments[i];
+
+            TraceInfo(
+                TRACE_CORE, "Program=%p Segment[%u] Match=%u Rules=[%u, %u)",
+                Program, i, Segment->Match, Segment->RuleStart, Segment->RuleEnd);
+        }
+    }
 }
 
 static
@@ -662,6 +808,16 @@ XdpProgramTraceObject(
     XdpProgramTrace(&ProgramObject->Program);
 }
 
+//
+// The head, tail and metadata adjustment helpers return 0 on success and a
+// negative value if the adjustment does not fit within the buffer. Packets
+// must retain at least an Ethernet header. Interfaces that do not report
+// RxFrameBoundsAdjustmentSupported cannot apply new bounds, so the head and
+// tail helpers fail on their queues. On TX inspection queues, the data around
+// the frame belongs to upper layers, so frames cannot extend beyond their
+// original start or end.
+//
+
 static
 int
 EbpfXdpAdjustHead(
@@ -669,16 +825,266 @@ EbpfXdpAdjustHead(
     _In_ int Delta
     )
 {
+    EBPF_XDP_MD *XdpMd = CONTAINING_RECORD(Context, EBPF_XDP_MD, Base);
+    XDP_BUFFER *Buffer = XdpMd->Buffer;
+    UINT32 MetadataLength = EbpfXdpGetMetadataLength(XdpMd);
+    INT64 DataOffset = (INT64)Buffer->DataOffset + Delta;
+    UCHAR *Data;
+
+    if (!XdpMd->BoundsAdjustable ||
+        (!XdpMd->BoundsExtendable && DataOffset < XdpMd->OriginalDataOffset) ||
+        DataOffset < MetadataLength ||
+        DataOffset + (INT64)sizeof(ETHERNET_HEADER) >
+            (INT64)Buffer->DataOffset + Buffer->DataLength) {
+        return -1;
+    }
+
+    Data = XdpMd->BufferVa + DataOffset;
+
+    //
+    // Keep the metadata adjacent to the packet data.
+    //
+    if (MetadataLength > 0) {
+        RtlMoveMemory(Data - MetadataLength, (UCHAR *)Context->data - MetadataLength, MetadataLength);
+    }
+
+    Buffer->DataLength = (UINT32)((INT64)Buffer->DataLength - Delta);
+    Buffer->DataOffset = (UINT32)DataOffset;
+
+    Context->data = Data;
+    Context->data_meta = (UINT64)(ULONG_PTR)(Data - MetadataLength);
+
+    return 0;
+}
+
+static
+int
+EbpfXdpAdjustTail(
+    _Inout_ xdp_md_t *Context,
+    _In_ int Delta
+    )
+{
+    EBPF_XDP_MD *XdpMd = CONTAINING_RECORD(Context, EBPF_XDP_MD, Base);
+    XDP_BUFFER *Buffer = XdpMd->Buffer;
+    INT64 DataLength = (INT64)Buffer->DataLength + Delta;
+
+    //
+    // The program can only access the first buffer of discontiguous frames,
+    // so their tail cannot be adjusted.
+    //
+    if (!XdpMd->BoundsAdjustable ||
+        XdpMd->FragmentCount != 0 ||
+        DataLength < (INT64)sizeof(ETHERNET_HEADER) ||
+        (!XdpMd->BoundsExtendable && Buffer->DataOffset + DataLength > XdpMd->OriginalDataEnd) ||
+        Buffer->DataOffset + DataLength > Buffer->BufferLength) {
+        return -1;
+    }
+
+    //
+    // Do not expose stale buffer contents to the program.
+    //
+    if (Delta > 0) {
+        RtlZeroMemory(Context->data_end, Delta);
+    }
+
+    Buffer->DataLength = (UINT32)DataLength;
+    Context->data_end = (UCHAR *)Context->data + DataLength;
+
+    return 0;
+}
+
+static
+int
+EbpfXdpAdjustMeta(
+    _Inout_ xdp_md_t *Context,
+    _In_ int Delta
+    )
+{
+    EBPF_XDP_MD *XdpMd = CONTAINING_RECORD(Context, EBPF_XDP_MD, Base);
+    INT64 MetadataLength = (INT64)EbpfXdpGetMetadataLength(XdpMd) - Delta;
+
+    if (MetadataLength < 0 ||
+        MetadataLength > EBPF_XDP_MAX_METADATA_LENGTH ||
+        MetadataLength % (INT64)sizeof(UINT32) != 0 ||
+        MetadataLength > XdpMd->Buffer->DataOffset) {
+        return -1;
+    }
+
+    Context->data_meta = (UINT64)(ULONG_PTR)((UCHAR *)Context->data - MetadataLength);
+
+    return 0;
+}
+
+//
+// The lower bits of the redirect flags select the action returned when the
+// lookup fails.
+//
+#define EBPF_XDP_REDIRECT_FLAGS_ACTION_MASK 0x3
+
+static
+long
+EbpfXdpRedirectMap(
+    _Inout_ xdp_md_t *Context,
+    _In_ UINT32 Key,
+    _In_ UINT64 Flags
+    )
+{
+    EBPF_XDP_MD *XdpMd = CONTAINING_RECORD(Context, EBPF_XDP_MD, Base);
+    long FallbackAction;
+    VOID *XskTarget;
+
+    if (Flags & ~(UINT64)EBPF_XDP_REDIRECT_FLAGS_ACTION_MASK) {
+        return XDP_DROP;
+    }
+
+    FallbackAction = (long)(Flags & EBPF_XDP_REDIRECT_FLAGS_ACTION_MASK);
+    if (FallbackAction == 0) {
+        FallbackAction = XDP_DROP;
+    }
+
+    //
+    // Contexts created for BPF_PROG_TEST_RUN have no XSKMAP.
+    //
+    if (XdpMd->XskMap == NULL) {
+        return FallbackAction;
+    }
+
+    ASSERT(KeGetCurrentIrql() == DISPATCH_LEVEL);
+    XskTarget = XdpXskMapLookup(XdpMd->XskMap, Key);
+    if (XskTarget == NULL) {
+        return FallbackAction;
+    }
+
+    XdpMd->RedirectTarget = XskTarget;
+
+    return XDP_REDIRECT;
+}
+
+static
+UINT32
+EbpfXdpGetFrameLength(
+    _In_ const EBPF_XDP_MD *XdpMd
+    )
+{
+    UINT32 FrameLength = XdpMd->Buffer->DataLength;
+    UINT32 FragmentIndex = XdpMd->FragmentIndex;
+
+    for (UINT32 Index = 0; Index < XdpMd->FragmentCount; Index++) {
+        const XDP_BUFFER *Buffer = XdpRingGetElement(XdpMd->FragmentRing, FragmentIndex);
+        FrameLength += Buffer->DataLength;
+        FragmentIndex = (FragmentIndex + 1) & XdpMd->FragmentRing->Mask;
+    }
+
+    return FrameLength;
+}
+
+static
+int
+EbpfXdpCopyFrameBytes(
+    _In_ const EBPF_XDP_MD *XdpMd,
+    _In_ UINT32 Offset,
+    _Inout_updates_bytes_(Length) UCHAR *Data,
+    _In_ UINT32 Length,
+    _In_ BOOLEAN Store
+    )
+{
+    const XDP_BUFFER *Buffer = XdpMd->Buffer;
+    UCHAR *Va = XdpMd->BufferVa;
+    UINT32 FragmentIndex = XdpMd->FragmentIndex;
+    UINT32 FragmentsRemaining = XdpMd->FragmentCount;
+
     //
-    // Not implemented. Any return < 0 is an error.
+    // Fail without copying anything if the range exceeds the frame.
     //
-    UNREFERENCED_PARAMETER(Context);
-    UNREFERENCED_PARAMETER(Delta);
-    return -1;
+    if (Length == 0 || (UINT64)Offset + Length > EbpfXdpGetFrameLength(XdpMd)) {
+        return -1;
+    }
+
+    while (Length > 0) {
+        if (Offset >= Buffer->DataLength) {
+            Offset -= Buffer->DataLength;
+        } else {
+            UINT32 CopyLength = min(Length, Buffer->DataLength - Offset);
+            UCHAR *FrameData = Va + Buffer->DataOffset + Offset;
+
+            if (Store) {
+                RtlCopyMemory(FrameData, Data, CopyLength);
+            } else {
+                RtlCopyMemory(Data, FrameData, CopyLength);
+            }
+
+            Data += CopyLength;
+            Length -= CopyLength;
+            Offset = 0;
+
+            if (Length == 0) {
+                break;
+            }
+        }
+
+        ASSERT(FragmentsRemaining > 0);
+        FragmentsRemaining--;
+        Buffer = XdpRingGetElement(XdpMd->FragmentRing, FragmentIndex);
+        FragmentIndex = (FragmentIndex + 1) & XdpMd->FragmentRing->Mask;
+        Va = XdpGetVirtualAddressExtension(Buffer, XdpMd->VirtualAddressExtension)->VirtualAddress;
+    }
+
+    return 0;
+}
+
+//
+// The load and store bytes helpers access any part of the frame, including
+// the buffers of discontiguous frames beyond data_end. They return 0 on
+// success and a negative value if the range exceeds the frame.
+//
+
+static
+int
+EbpfXdpLoadBytes(
+    _In_ xdp_md_t *Context,
+    _In_ UINT32 Offset,
+    _Out_writes_bytes_(Length) VOID *Data,
+    _In_ UINT32 Length
+    )
+{
+    EBPF_XDP_MD *XdpMd = CONTAINING_RECORD(Context, EBPF_XDP_MD, Base);
+
+    return EbpfXdpCopyFrameBytes(XdpMd, Offset, Data, Length, FALSE);
+}
+
+static
+int
+EbpfXdpStoreBytes(
+    _Inout_ xdp_md_t *Context,
+    _In_ UINT32 Offset,
+    _In_reads_bytes_(Length) const VOID *Data,
+    _In_ UINT32 Length
+    )
+{
+    EBPF_XDP_MD *XdpMd = CONTAINING_RECORD(Context, EBPF_XDP_MD, Base);
+
+    return EbpfXdpCopyFrameBytes(XdpMd, Offset, (UCHAR *)Data, Length, TRUE);
+}
+
+static
+UINT64
+EbpfXdpGetBuffLen(
+    _In_ xdp_md_t *Context
+    )
+{
+    EBPF_XDP_MD *XdpMd = CONTAINING_RECORD(Context, EBPF_XDP_MD, Base);
+
+    return EbpfXdpGetFrameLength(XdpMd);
 }
 
 static const VOID *EbpfXdpHelperFunctions[] = {
     (VOID *)EbpfXdpAdjustHead,
+    (VOID *)EbpfXdpRedirectMap,
+    (VOID *)EbpfXdpAdjustTail,
+    (VOID *)EbpfXdpAdjustMeta,
+    (VOID *)EbpfXdpLoadBytes,
+    (VOID *)EbpfXdpStoreBytes,
+    (VOID *)EbpfXdpGetBuffLen,
 };
 
 static const ebpf_helper_function_addresses_t XdpHelperFunctionAddresses = {
@@ -718,6 +1124,17 @@ static const NPI_MODULEID EbpfXdpHookProviderModuleId = {
 static EBPF_EXTENSION_PROVIDER *EbpfXdpProgramInfoProvider;
 static EBPF_EXTENSION_PROVIDER *EbpfXdpProgramHookProvider;
 
+//
+// Distinguishes the performance counter instances of rules with the same index
+// in different program objects.
+//
+static LONG XdpProgramNextId;
+
+//
+// Keyed hash shared by every flow hash redirect rule.
+//
+static XDP_TOEPLITZ_TABLE *XdpProgramFlowHashTable;
+
 static
 _IRQL_requires_max_(DISPATCH_LEVEL)
 VOID
@@ -743,6 +1160,9 @@ XdpProgramUpdateCompiledProgram(
         XdpProgramTraceObject(BoundProgramObject);
 
         for (UINT32 i = 0; i < BoundProgramObject->Program.RuleCount; i++) {
+            Program->RateLimiters[RuleIndex] =
+                BoundProgramObject->Program.RateLimiters != NULL ?
+                    BoundProgramObject->Program.RateLimiters[i] : NULL;
             Program->Rules[RuleIndex++] = BoundProgramObject->Program.Rules[i];
         }
 
@@ -756,6 +1176,12 @@ XdpProgramUpdateCompiledProgram(
     ASSERT(Program->RuleCount >= RuleIndex);
     Program->RuleCount = RuleIndex;
 
+    //
+    // The classifier and rate limiter storage were sized for the original rule
+    // count, so both can always be rebuilt in place for the smaller program.
+    //
+    XdpProgramCompileClassifier(Program);
+
     TraceInfo(TRACE_CORE, "Updated Program=%p on RxQueue=%p", Program, RxQueue);
     XdpProgramTrace(Program);
     TraceExitSuccess(TRACE_CORE);
@@ -775,6 +1201,10 @@ XdpProgramCompileNewProgram(
     UINT32 RuleCount = 0;
     XDP_PROGRAM *NewProgram;
     SIZE_T AllocationSize;
+    SIZE_T ClassifierOffset;
+    SIZE_T ClassifierSize;
+    SIZE_T RateLimitersOffset;
+    SIZE_T RateLimitersSize;
 
     TraceEnter(TRACE_CORE, "Compiling new program on RxQueue=%p", RxQueue);
 
@@ -804,7 +1234,37 @@ XdpProgramCompileNewProgram(
         goto Exit;
     }
 
-    Status = RtlSizeTAdd(FIELD_OFFSET(XDP_PROGRAM, Rules), AllocationSize, &AllocationSize);
+    Status = RtlSizeTAdd(FIELD_OFFSET(XDP_PROGRAM, Rules), AllocationSize, &ClassifierOffset);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    //
+    // The classifier is allocated immediately after the rules.
+    //
+    C_ASSERT(sizeof(XDP_RULE) % TYPE_ALIGNMENT(XDP_PROGRAM_CLASSIFIER) == 0);
+
+    Status = XdpProgramGetClassifierSize(RuleCount, &ClassifierSize);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    Status = RtlSizeTAdd(ClassifierOffset, ClassifierSize, &RateLimitersOffset);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    //
+    // The rate limiter array is allocated after the classifier.
+    //
+    RateLimitersOffset = ALIGN_UP_BY(RateLimitersOffset, TYPE_ALIGNMENT(XDP_RATE_LIMITER *));
+
+    Status = RtlSizeTMult(sizeof(XDP_RATE_LIMITER *), RuleCount, &RateLimitersSize);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    Status = RtlSizeTAdd(RateLimitersOffset, RateLimitersSize, &AllocationSize);
     if (!NT_SUCCESS(Status)) {
         goto Exit;
     }
@@ -815,6 +1275,9 @@ XdpProgramCompileNewProgram(
         goto Exit;
     }
 
+    NewProgram->RateLimiters = RTL_PTR_ADD(NewProgram, RateLimitersOffset);
+    NewProgram->FlowHashTable = XdpProgramFlowHashTable;
+
     Entry = BindingListHead->Flink;
     while (Entry != BindingListHead) {
         XDP_PROGRAM_BINDING *ProgramBinding =
@@ -827,6 +1290,9 @@ XdpProgramCompileNewProgram(
         XdpProgramTraceObject(BoundProgramObject);
 
         for (UINT32 i = 0; i < BoundProgramObject->Program.RuleCount; i++) {
+            NewProgram->RateLimiters[NewProgram->RuleCount] =
+                BoundProgramObject->Program.RateLimiters != NULL ?
+                    BoundProgramObject->Program.RateLimiters[i] : NULL;
             NewProgram->Rules[NewProgram->RuleCount++] = BoundProgramObject->Program.Rules[i];
         }
 
@@ -835,17 +1301,57 @@ XdpProgramCompileNewProgram(
 
     ASSERT(NewProgram->RuleCount == RuleCount);
 
+    NewProgram->Classifier = RTL_PTR_ADD(NewProgram, ClassifierOffset);
+    XdpProgramInitializeClassifier(NewProgram->Classifier, RuleCount);
+    XdpProgramCompileClassifier(NewProgram);
+
     //
-    // Detect if any rule uses a redirect target type that requires the global
-    // map lock. The data path acquires the lock around each batch when set.
+    // Detect rules that need the global map lock, an XSKMAP read section, or
+    // DISPATCH_LEVEL for per-processor rate limiters; the data path enters the
+    // required section around each batch.
     //
     NewProgram->HasMap = FALSE;
+    NewProgram->HasXskMap = FALSE;
+    NewProgram->HasRateLimit = FALSE;
     for (UINT32 i = 0; i < NewProgram->RuleCount; i++) {
-        if (NewProgram->Rules[i].Action == XDP_PROGRAM_ACTION_REDIRECT &&
-            NewProgram->Rules[i].Redirect.TargetType ==
-                XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_QUEUEID) {
+        if (NewProgram->Rules[i].Action == XDP_PROGRAM_ACTION_RATE_LIMIT) {
+            NewProgram->HasRateLimit = TRUE;
+        }
+
+        if (NewProgram->Rules[i].Action == XDP_PROGRAM_ACTION_EBPF &&
+            NewProgram->Rules[i].Ebpf.XskMap != NULL) {
+            NewProgram->HasXskMap = TRUE;
+        }
+
+        if (NewProgram->Rules[i].Action != XDP_PROGRAM_ACTION_REDIRECT) {
+            continue;
+        }
+
+        switch (NewProgram->Rules[i].Redirect.TargetType) {
+        case XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_QUEUEID:
+        case XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_FLOW_HASH:
+            NewProgram->HasXskMap = TRUE;
+            break;
+        case XDP_REDIRECT_TARGET_TYPE_QUIC_CID_MAP:
+        case XDP_REDIRECT_TARGET_TYPE_HASH_MAP_BY_FLOW:
+        case XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_SRC_ADDR:
+        case XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_DST_ADDR:
             NewProgram->HasMap = TRUE;
             break;
+        default:
+            break;
+        }
+    }
+
+    //
+    // Programs that only match all frames gain nothing from parsing headers
+    // ahead of rule evaluation.
+    //
+    NewProgram->BatchParse = FALSE;
+    for (UINT32 i = 0; i < NewProgram->RuleCount; i++) {
+        if (NewProgram->Rules[i].Match != XDP_MATCH_ALL) {
+            NewProgram->BatchParse = TRUE;
+            break;
         }
     }
 
@@ -961,6 +1467,120 @@ Exit:
     return Status;
 }
 
+static
+VOID
+XdpProgramDeleteRateLimiter(
+    _In_ const XDP_PROGRAM_OBJECT *ProgramObject,
+    _In_ UINT32 RuleIndex,
+    _In_ XDP_RATE_LIMITER *RateLimiter
+    )
+{
+    UINT64 FramesConformed = 0;
+    UINT64 FramesExceeded = 0;
+
+    for (UINT32 i = 0; i < RateLimiter->BucketCount; i++) {
+        XDP_RATE_LIMIT_BUCKET *Bucket = &RateLimiter->Buckets[i];
+
+        if (Bucket->PcwInstance != NULL) {
+            PcwCloseInstance(Bucket->PcwInstance);
+            Bucket->PcwInstance = NULL;
+        }
+
+        FramesConformed += Bucket->Stats.FramesConformed;
+        FramesExceeded += Bucket->Stats.FramesExceeded;
+    }
+
+    TraceInfo(
+        TRACE_CORE,
+        "ProgramObject=%p Rule[%u] FramesConformed=%llu FramesExceeded=%llu",
+        ProgramObject, RuleIndex, FramesConformed, FramesExceeded);
+
+    ExFreePoolWithTag(RateLimiter, XDP_POOLTAG_RATE_LIMIT);
+}
+
+static
+NTSTATUS
+XdpProgramCreateRateLimiter(
+    _In_ UINT32 IfIndex,
+    _In_ UINT32 ProgramId,
+    _In_ UINT32 RuleIndex,
+    _In_ const XDP_RATE_LIMIT_PARAMS *Params,
+    _Out_ XDP_RATE_LIMITER **RateLimiter
+    )
+{
+    XDP_RATE_LIMITER *NewRateLimiter = NULL;
+    UINT32 BucketCount = KeQueryMaximumProcessorCountEx(ALL_PROCESSOR_GROUPS);
+    SIZE_T AllocationSize;
+    DECLARE_UNICODE_STRING_SIZE(
+        Name, ARRAYSIZE("if_" MAXUINT32_STR "_program_" MAXUINT32_STR "_rule_" MAXUINT32_STR));
+    NTSTATUS Status;
+
+    *RateLimiter = NULL;
+
+    Status = RtlSizeTMult(sizeof(NewRateLimiter->Buckets[0]), BucketCount, &AllocationSize);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    Status = RtlSizeTAdd(AllocationSize, sizeof(*NewRateLimiter), &AllocationSize);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    NewRateLimiter =
+        ExAllocatePoolZero(NonPagedPoolNxCacheAligned, AllocationSize, XDP_POOLTAG_RATE_LIMIT);
+    if (NewRateLimiter == NULL) {
+        Status = STATUS_NO_MEMORY;
+        goto Exit;
+    }
+
+    NewRateLimiter->Capacity = (UINT64)Params->BurstSize * XDP_RATE_LIMIT_TOKENS_PER_FRAME;
+    NewRateLimiter->FramesPerSecond = Params->FramesPerSecond;
+    NewRateLimiter->MaxRefillInterval =
+        NewRateLimiter->Capacity / NewRateLimiter->FramesPerSecond;
+    NewRateLimiter->BucketCount = BucketCount;
+
+    Status =
+        RtlUnicodeStringPrintf(
+            &Name, L"if_%u_program_%u_rule_%u", IfIndex, ProgramId, RuleIndex);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    //
+    // Each bucket starts out full.
+    //
+    for (UINT32 i = 0; i < BucketCount; i++) {
+        XDP_RATE_LIMIT_BUCKET *Bucket = &NewRateLimiter->Buckets[i];
+
+        Bucket->Tokens = NewRateLimiter->Capacity;
+        Bucket->LastRefillTime = KeQueryInterruptTime();
+
+        Status = XdpPcwCreateRateLimitRule(&Bucket->PcwInstance, &Name, &Bucket->Stats);
+        if (!NT_SUCCESS(Status)) {
+            goto Exit;
+        }
+    }
+
+    *RateLimiter = NewRateLimiter;
+    NewRateLimiter = NULL;
+    Status = STATUS_SUCCESS;
+
+Exit:
+
+    if (NewRateLimiter != NULL) {
+        for (UINT32 i = 0; i < BucketCount; i++) {
+            if (NewRateLimiter->Buckets[i].PcwInstance != NULL) {
+                PcwCloseInstance(NewRateLimiter->Buckets[i].PcwInstance);
+            }
+        }
+
+        ExFreePoolWithTag(NewRateLimiter, XDP_POOLTAG_RATE_LIMIT);
+    }
+
+    return Status;
+}
+
 static
 VOID
 XdpProgramDelete(
@@ -997,10 +1617,21 @@ XdpProgramDelete(
     // Clean up the XDP program after data path references are dropped.
     //
 
-    for (ULONG Index = 0; Index < ProgramObject->Program.RuleCount; Index++) {
-        XDP_RULE *Rule = &ProgramObject->Program.Rules[Index];
+    if (ProgramObject->Program.RateLimiters != NULL) {
+        for (ULONG Index = 0; Index < ProgramObject->Program.RuleCount; Index++) {
+            XDP_RATE_LIMITER *RateLimiter = ProgramObject->Program.RateLimiters[Index];
 
-        XdpProgramDeleteRule(Rule);
+            if (RateLimiter != NULL) {
+                XdpProgramDeleteRateLimiter(ProgramObject, Index, RateLimiter);
+            }
+        }
+
+        ExFreePoolWithTag(ProgramObject->Program.RateLimiters, XDP_POOLTAG_RATE_LIMIT);
+        ProgramObject->Program.RateLimiters = NULL;
+    }
+
+    for (ULONG Index = 0; Index < ProgramObject->Program.RuleCount; Index++) {
+        XdpProgramDeleteRule(&ProgramObject->Program.Rules[Index]);
     }
 
     TraceVerbose(TRACE_CORE, "Deleted ProgramObject=%p", ProgramObject);
@@ -1093,6 +1724,7 @@ static
 _IRQL_requires_max_(PASSIVE_LEVEL)
 NTSTATUS
 XdpCaptureProgram(
+    _In_ UINT32 IfIndex,
     _In_ const XDP_RULE *Rules,
     _In_ ULONG RuleCount,
     _In_ KPROCESSOR_MODE RequestorMode,
@@ -1102,6 +1734,7 @@ XdpCaptureProgram(
     NTSTATUS Status;
     XDP_PROGRAM_OBJECT *ProgramObject = NULL;
     XDP_PROGRAM *Program = NULL;
+    UINT32 ProgramId;
 
     TraceEnter(TRACE_CORE, "-");
 
@@ -1142,6 +1775,37 @@ XdpCaptureProgram(
         }
     }
 
+    //
+    // Allocate the token bucket state of rate limit rules outside the rules,
+    // which are copied into compiled programs.
+    //
+    ProgramId = (UINT32)InterlockedIncrement(&XdpProgramNextId);
+
+    for (ULONG Index = 0; Index < RuleCount; Index++) {
+        if (Program->Rules[Index].Action != XDP_PROGRAM_ACTION_RATE_LIMIT) {
+            continue;
+        }
+
+        if (Program->RateLimiters == NULL) {
+            Program->RateLimiters =
+                ExAllocatePoolZero(
+                    NonPagedPoolNx, sizeof(*Program->RateLimiters) * RuleCount,
+                    XDP_POOLTAG_RATE_LIMIT);
+            if (Program->RateLimiters == NULL) {
+                Status = STATUS_NO_MEMORY;
+                goto Exit;
+            }
+        }
+
+        Status =
+            XdpProgramCreateRateLimiter(
+                IfIndex, ProgramId, Index, &Program->Rules[Index].RateLimit,
+                &Program->RateLimiters[Index]);
+        if (!NT_SUCCESS(Status)) {
+            goto Exit;
+        }
+    }
+
     Status = STATUS_SUCCESS;
 
 Exit:
@@ -1193,7 +1857,9 @@ XdpProgramValidateIfQueue(
     for (ULONG Index = 0; Index < Program->RuleCount; Index++) {
         XDP_RULE *Rule = &Program->Rules[Index];
 
-        if (Rule->Action == XDP_PROGRAM_ACTION_L2FWD) {
+        if (Rule->Action == XDP_PROGRAM_ACTION_L2FWD ||
+            (Rule->Action == XDP_PROGRAM_ACTION_RATE_LIMIT &&
+                Rule->RateLimit.ConformAction == XDP_PROGRAM_ACTION_L2FWD)) {
             if (!XdpRxQueueIsTxActionSupported(XdpRxQueueGetConfig(RxQueue))) {
                 TraceError(
                     TRACE_CORE, "ProgramObject=%p RX queue does not support TX action",
@@ -1540,7 +2206,8 @@ RetryBinding:
     }
 
     Status =
-        XdpCaptureProgram(Params->Rules, Params->RuleCount, RequestorMode, &ProgramObject);
+        XdpCaptureProgram(
+            Params->IfIndex, Params->Rules, Params->RuleCount, RequestorMode, &ProgramObject);
     if (!NT_SUCCESS(Status)) {
         goto Exit;
     }
@@ -1718,6 +2385,7 @@ EbpfProgramOnClientAttach(
     const ebpf_extension_dispatch_table_t *ClientDispatch =
         EbpfExtensionClientGetDispatch(AttachingClient);
     UINT32 IfIndex;
+    XDP_MAP *XskMap = NULL;
     XDP_PROGRAM_OPEN OpenParams = {0};
     XDP_RULE XdpRule = {0};
     XDP_PROGRAM_OBJECT *ProgramObject;
@@ -1726,9 +2394,14 @@ EbpfProgramOnClientAttach(
     TraceEnter(
         TRACE_CORE, "AttachingProvider=%p AttachingClient=%p", AttachingProvider, AttachingClient);
 
+    //
+    // The attach parameters are either an interface index or an
+    // xdp_attach_params_t, which may also supply an XSKMAP for redirection.
+    //
     if (ClientData == NULL ||
         ClientData->header.version < EBPF_ATTACH_CLIENT_DATA_CURRENT_VERSION ||
-        ClientData->data_size != sizeof(IfIndex) ||
+        (ClientData->data_size != sizeof(IfIndex) &&
+            ClientData->data_size != sizeof(xdp_attach_params_t)) ||
         ClientData->data == NULL) {
         Status = STATUS_INVALID_PARAMETER;
         goto Exit;
@@ -1736,6 +2409,37 @@ EbpfProgramOnClientAttach(
 
     IfIndex = *(UINT32 *)ClientData->data;
 
+    if (ClientData->data_size == sizeof(xdp_attach_params_t)) {
+        const xdp_attach_params_t *AttachParams = ClientData->data;
+        HANDLE XskMapHandle = (HANDLE)(ULONG_PTR)AttachParams->xskmap;
+
+        C_ASSERT(FIELD_OFFSET(xdp_attach_params_t, ifindex) == 0);
+
+        if (AttachParams->reserved != 0) {
+            Status = STATUS_INVALID_PARAMETER;
+            goto Exit;
+        }
+
+        //
+        // The eBPF attach request is processed in the context of the
+        // requesting thread, so the handle is referenced with its access
+        // mode. The parameters themselves have already been captured.
+        //
+        if (XskMapHandle != NULL) {
+            Status =
+                XdpMapReferenceDatapathHandle(
+                    ExGetPreviousMode(), &XskMapHandle, TRUE, &XskMap);
+            if (!NT_SUCCESS(Status)) {
+                goto Exit;
+            }
+
+            if (XdpMapGetType(XskMap) != XDP_MAP_TYPE_XSKMAP) {
+                Status = STATUS_INVALID_PARAMETER;
+                goto Exit;
+            }
+        }
+    }
+
     if (IfIndex == IFI_UNSPECIFIED) {
         Status = STATUS_NOT_SUPPORTED;
         goto Exit;
@@ -1774,6 +2478,7 @@ EbpfProgramOnClientAttach(
     XdpRule.Match = XDP_MATCH_ALL;
     XdpRule.Action = XDP_PROGRAM_ACTION_EBPF;
     XdpRule.Ebpf.Target = (HANDLE)AttachingClient;
+    XdpRule.Ebpf.XskMap = XskMap;
 
     Status = XdpProgramCreate(&ProgramObject, &OpenParams, KernelMode);
     if (!NT_SUCCESS(Status)) {
@@ -1784,6 +2489,13 @@ EbpfProgramOnClientAttach(
 
 Exit:
 
+    //
+    // The program holds its own reference on the XSKMAP.
+    //
+    if (XskMap != NULL) {
+        XdpMapDereferenceDatapathHandle(XskMap);
+    }
+
     TraceExitStatus(TRACE_CORE);
 
     return Status;
@@ -1823,10 +2535,30 @@ XdpProgramStart(
         .ProviderData = &EbpfXdpHookAttachProviderData,
     };
     DWORD EbpfEnabled;
+    UINT32 FlowHashKey[XDP_TOEPLITZ_MAX_KEY_SIZE / sizeof(UINT32)];
     NTSTATUS Status;
 
     TraceEnter(TRACE_CORE, "-");
 
+    Status = XdpPcwRegisterRateLimitRule(NULL, NULL);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    XdpProgramFlowHashTable =
+        ExAllocatePoolZero(NonPagedPoolNx, sizeof(*XdpProgramFlowHashTable), XDP_POOLTAG_PROGRAM);
+    if (XdpProgramFlowHashTable == NULL) {
+        Status = STATUS_NO_MEMORY;
+        goto Exit;
+    }
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(FlowHashKey); i++) {
+        FlowHashKey[i] = RtlRandomNumber();
+    }
+
+    XdpToeplitzInitializeTable(
+        XdpProgramFlowHashTable, (const UCHAR *)FlowHashKey, sizeof(FlowHashKey));
+
     //
     // eBPF is disabled by default while reliability bugs are outstanding.
     //
@@ -1876,5 +2608,15 @@ XdpProgramStop(
         EbpfXdpProgramInfoProvider = NULL;
     }
 
+    if (XdpProgramFlowHashTable != NULL) {
+        ExFreePoolWithTag(XdpProgramFlowHashTable, XDP_POOLTAG_PROGRAM);
+        XdpProgramFlowHashTable = NULL;
+    }
+
+    if (XdpPcwRateLimitRule != NULL) {
+        PcwUnregister(XdpPcwRateLimitRule);
+        XdpPcwRateLimitRule = NULL;
+    }
+
     TraceExitSuccess(TRACE_CORE);
 }
@@ -17,6 +17,18 @@ typedef struct _XDP_INSPECTION_CONTEXT {
     XDP_REDIRECT_CONTEXT RedirectContext;
     ULONG IfIndex;
     LOCK_STATE_EX MapLockState;
+    KIRQL MapOldIrql;
+    //
+    // Frame buffers may be concurrently writable by user mode, so headers are
+    // copied before they are parsed.
+    //
+    BOOLEAN SnapshotHeaders;
+    //
+    // Whether the interface applies changes to the frame's data bounds, and
+    // whether the data may extend beyond its original start and end.
+    //
+    BOOLEAN FrameBoundsAdjustable;
+    BOOLEAN FrameBoundsExtendable;
 } XDP_INSPECTION_CONTEXT;
 
 //
@@ -40,6 +52,32 @@ XDP_RX_INSPECT_ROUTINE(
 XDP_RX_INSPECT_ROUTINE XdpInspect;
 XDP_RX_INSPECT_ROUTINE XdpInspectEbpf;
 
+//
+// Maximum number of frames whose headers are prefetched and parsed ahead of
+// rule evaluation by XdpInspectBatch.
+//
+#define XDP_INSPECT_BATCH_SIZE 16
+
+//
+// Inspects FrameCount consecutive frames starting at FrameIndex, prefetching
+// and parsing the headers of every frame in the batch before evaluating rules.
+// The frame and fragment indexes are masked ring indexes of the first frame.
+//
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+XdpInspectBatch(
+    _In_ XDP_PROGRAM *Program,
+    _In_ XDP_INSPECTION_CONTEXT *InspectionContext,
+    _In_ XDP_RING *FrameRing,
+    _In_ UINT32 FrameIndex,
+    _In_range_(1, XDP_INSPECT_BATCH_SIZE) UINT32 FrameCount,
+    _In_opt_ XDP_RING *FragmentRing,
+    _In_opt_ XDP_EXTENSION *FragmentExtension,
+    _In_ UINT32 FragmentIndex,
+    _In_ XDP_EXTENSION *VirtualAddressExtension,
+    _Out_writes_(FrameCount) XDP_RX_ACTION *Actions
+    );
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 _Success_(return)
 BOOLEAN
@@ -16,6 +16,13 @@
 #define ICMP6_ECHOREPLY_CODE 0
 #define TCP_HDR_LEN_TO_BYTES(x) (((UINT64)(x)) * 4)
 
+//
+// Number of bytes prefetched from the start of each frame by XdpInspectBatch:
+// enough for Ethernet, IPv6 and a TCP header without options.
+//
+#define XDP_INSPECT_PREFETCH_LENGTH \
+    (sizeof(ETHERNET_HEADER) + sizeof(IPV6_HEADER) + sizeof(TCP_HDR))
+
 //
 // Data path routines.
 //
@@ -510,13 +517,22 @@ XdpParseFrame(
     _In_ UINT32 FragmentIndex,
     _In_ XDP_EXTENSION *VirtualAddressExtension,
     _Out_ XDP_PROGRAM_FRAME_CACHE *Cache,
-    _Inout_ XDP_PROGRAM_FRAME_STORAGE *Storage
+    _Inout_opt_ XDP_PROGRAM_FRAME_STORAGE *Storage
     )
 {
     XDP_BUFFER *Buffer;
     UCHAR *Va;
     IPPROTO IpProto = IPPROTO_MAX;
     UINT32 Offset = 0;
+    UINT32 DataLength;
+
+    if (Cache->SnapshotHeaders && Storage == NULL) {
+        //
+        // Snapshots are copied into storage shared by every frame inspected by
+        // the program, so the frame is parsed when a rule first inspects it.
+        //
+        return;
+    }
 
     //
     // This routine always attempts to parse Ethernet through TCP/UDP headers.
@@ -537,8 +553,19 @@ XdpParseFrame(
     Buffer = &Frame->Buffer;
     Va = XdpGetVirtualAddressExtension(Buffer, VirtualAddressExtension)->VirtualAddress;
     Va += Buffer->DataOffset;
+    DataLength = Buffer->DataLength;
+
+    if (Cache->SnapshotHeaders) {
+        //
+        // The buffer may be concurrently written by user mode; parse a copy
+        // of the headers so each field is validated and matched exactly once.
+        //
+        DataLength = min(DataLength, sizeof(Storage->HeaderSnapshot));
+        RtlCopyMemory(Storage->HeaderSnapshot, Va, DataLength);
+        Va = Storage->HeaderSnapshot;
+    }
 
-    if (Buffer->DataLength < sizeof(*Cache->EthHdr)) {
+    if (DataLength < sizeof(*Cache->EthHdr)) {
         goto BufferTooSmall;
     }
     Cache->EthHdr = (ETHERNET_HEADER *)&Va[Offset];
@@ -546,7 +573,7 @@ XdpParseFrame(
     Offset += sizeof(*Cache->EthHdr);
 
     if (Cache->EthHdr->Type == htons(ETHERNET_TYPE_IPV4)) {
-        if (Buffer->DataLength < Offset + sizeof(*Cache->Ip4Hdr)) {
+        if (DataLength < Offset + sizeof(*Cache->Ip4Hdr)) {
             goto BufferTooSmall;
         }
         Cache->Ip4Hdr = (IPV4_HEADER *)&Va[Offset];
@@ -557,7 +584,7 @@ XdpParseFrame(
         Offset += sizeof(*Cache->Ip4Hdr);
         IpProto = Cache->Ip4Hdr->Protocol;
     } else if (Cache->EthHdr->Type == htons(ETHERNET_TYPE_IPV6)) {
-        if (Buffer->DataLength < Offset + sizeof(*Cache->Ip6Hdr)) {
+        if (DataLength < Offset + sizeof(*Cache->Ip6Hdr)) {
             goto BufferTooSmall;
         }
         Cache->Ip6Hdr = (IPV6_HEADER *)&Va[Offset];
@@ -569,7 +596,7 @@ XdpParseFrame(
     }
 
     if (IpProto == IPPROTO_UDP) {
-        if (Buffer->DataLength < Offset + sizeof(*Cache->UdpHdr)) {
+        if (DataLength < Offset + sizeof(*Cache->UdpHdr)) {
             goto BufferTooSmall;
         }
         Cache->UdpHdr = (UDP_HDR *)&Va[Offset];
@@ -581,12 +608,12 @@ XdpParseFrame(
         Cache->TransportPayloadValid = TRUE;
     } else if (IpProto == IPPROTO_TCP) {
         UINT32 HeaderLength;
-        if (Buffer->DataLength < Offset + sizeof(*Cache->TcpHdr)) {
+        if (DataLength < Offset + sizeof(*Cache->TcpHdr)) {
             goto BufferTooSmall;
         }
 
         HeaderLength = TCP_HDR_LEN_TO_BYTES(((TCP_HDR *)&Va[Offset])->th_len);
-        if (Buffer->DataLength < Offset + HeaderLength) {
+        if (DataLength < Offset + HeaderLength) {
             goto BufferTooSmall;
         }
 
@@ -610,6 +637,18 @@ BufferTooSmall:
 
     if (FragmentRing != NULL) {
         ASSERT(FragmentExtension);
+
+        if (Storage == NULL) {
+            //
+            // Discontiguous headers are copied into storage shared by every
+            // frame inspected by the program, so they cannot be parsed ahead
+            // of rule evaluation. Discard the partial results; the frame will
+            // be parsed again when a rule first inspects its headers.
+            //
+            XdpInitializeFrameCache(Cache);
+            return;
+        }
+
         XdpParseFragmentedFrame(
             Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
             Offset, Cache, Storage);
@@ -689,6 +728,86 @@ QuicCidMatch(
     return memcmp(&QuicHeader->QuicCid[Flow->CidOffset], Flow->CidData, Flow->CidLength) == 0;
 }
 
+static
+VOID *
+QuicCidMapLookup(
+    _In_ XDP_MATCH_TYPE Type,
+    _In_ const XDP_PROGRAM_FRAME_CACHE *QuicHeader,
+    _In_ const XDP_QUIC_FLOW *Flow,
+    _In_ XDP_MAP *Map
+    )
+{
+    if ((Type == XDP_MATCH_QUIC_FLOW_SRC_CID_MAP) != (QuicHeader->QuicIsLongHeader == 1)) {
+        return NULL;
+    }
+    ASSERT(Flow->CidOffset + Flow->CidLength <= XDP_QUIC_MAX_CID_LENGTH);
+    if (QuicHeader->QuicCidLength < Flow->CidOffset + Flow->CidLength) {
+        return NULL;
+    }
+    return XdpQuicCidMapLookup(Map, &QuicHeader->QuicCid[Flow->CidOffset], Flow->CidLength);
+}
+
+static
+BOOLEAN
+XdpIsActionMapTarget(
+    _In_ XDP_REDIRECT_TARGET_TYPE TargetType
+    )
+{
+    return
+        TargetType == XDP_REDIRECT_TARGET_TYPE_HASH_MAP_BY_FLOW ||
+        TargetType == XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_SRC_ADDR ||
+        TargetType == XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_DST_ADDR;
+}
+
+static
+const XDP_MAP_TABLE_VALUE *
+ActionMapLookup(
+    _In_ XDP_REDIRECT_TARGET_TYPE TargetType,
+    _In_ XDP_MAP *Map,
+    _In_ const XDP_PROGRAM_FRAME_CACHE *Cache
+    )
+{
+    XDP_HASH_MAP_KEY Key = {0};
+
+    if (Cache->Ip4Valid) {
+        Key.AddressFamily = AF_INET;
+        Key.Tuple.SourceAddress.Ipv4 = Cache->Ip4Hdr->SourceAddress;
+        Key.Tuple.DestinationAddress.Ipv4 = Cache->Ip4Hdr->DestinationAddress;
+    } else if (Cache->Ip6Valid) {
+        Key.AddressFamily = AF_INET6;
+        Key.Tuple.SourceAddress.Ipv6 = Cache->Ip6Hdr->SourceAddress;
+        Key.Tuple.DestinationAddress.Ipv6 = Cache->Ip6Hdr->DestinationAddress;
+    } else {
+        return NULL;
+    }
+
+    switch (TargetType) {
+    case XDP_REDIRECT_TARGET_TYPE_HASH_MAP_BY_FLOW:
+        if (Cache->UdpValid) {
+            Key.IpProtocol = IPPROTO_UDP;
+            Key.Tuple.SourcePort = Cache->UdpHdr->uh_sport;
+            Key.Tuple.DestinationPort = Cache->UdpHdr->uh_dport;
+        } else if (Cache->TcpValid) {
+            Key.IpProtocol = IPPROTO_TCP;
+            Key.Tuple.SourcePort = Cache->TcpHdr->th_sport;
+            Key.Tuple.DestinationPort = Cache->TcpHdr->th_dport;
+        } else {
+            return NULL;
+        }
+        return XdpHashMapLookup(Map, &Key);
+
+    case XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_SRC_ADDR:
+        return XdpLpmMapLookup(Map, Key.AddressFamily, &Key.Tuple.SourceAddress);
+
+    case XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_DST_ADDR:
+        return XdpLpmMapLookup(Map, Key.AddressFamily, &Key.Tuple.DestinationAddress);
+
+    default:
+        ASSERT(FALSE);
+        return NULL;
+    }
+}
+
 static
 _Success_(return != FALSE)
 BOOLEAN
@@ -984,7 +1103,12 @@ XdpL2Fwd(
     Cache->EthHdr->Destination = Cache->EthHdr->Source;
     Cache->EthHdr->Source = TempDlAddress;
 
-    if (Frame->Buffer.DataLength < sizeof(*Cache->EthHdr)) {
+    if (Cache->SnapshotHeaders && Frame->Buffer.DataLength >= sizeof(*Cache->EthHdr)) {
+        UCHAR *Va =
+            XdpGetVirtualAddressExtension(
+                &Frame->Buffer, VirtualAddressExtension)->VirtualAddress;
+        RtlCopyMemory(Va + Frame->Buffer.DataOffset, Cache->EthHdr, sizeof(*Cache->EthHdr));
+    } else if (Frame->Buffer.DataLength < sizeof(*Cache->EthHdr)) {
         ASSERT(FragmentRing != NULL);
         ASSERT(FragmentExtension != NULL);
         XdpCopyMemoryToFrame(
@@ -997,407 +1121,947 @@ XdpL2Fwd(
     return XDP_RX_ACTION_TX;
 }
 
-_IRQL_requires_max_(DISPATCH_LEVEL)
-XDP_RX_ACTION
-XdpInspect(
-    _In_ XDP_PROGRAM *Program,
-    _In_ XDP_INSPECTION_CONTEXT *InspectionContext,
-    _In_ XDP_RING *FrameRing,
-    _In_ UINT32 FrameIndex,
-    _In_opt_ XDP_RING *FragmentRing,
-    _In_opt_ XDP_EXTENSION *FragmentExtension,
-    _In_ UINT32 FragmentIndex,
-    _In_ XDP_EXTENSION *VirtualAddressExtension
+//
+// Returns TRUE if the frame conforms to the rate limit. The token bucket of
+// the current processor is refilled based on the interrupt time elapsed since
+// its last refill; the caller must be at DISPATCH_LEVEL.
+//
+static
+BOOLEAN
+XdpRateLimitConform(
+    _Inout_ XDP_RATE_LIMITER *RateLimiter
     )
 {
-    XDP_RX_ACTION Action = XDP_RX_ACTION_PASS;
-    XDP_PROGRAM_FRAME_CACHE FrameCache;
-    XDP_FRAME *Frame;
-    BOOLEAN Matched = FALSE;
-    XDP_PCW_RX_QUEUE *RxQueueStats = XdpRxQueueGetStatsFromInspectionContext(InspectionContext);
-
-    ASSERT(FrameIndex <= FrameRing->Mask);
-    ASSERT(
-        (FragmentRing == NULL && FragmentIndex == 0) ||
-        (FragmentRing && FragmentIndex <= FragmentRing->Mask));
-
-    XdpInitializeFrameCache(&FrameCache);
-    Frame = XdpRingGetElement(FrameRing, FrameIndex);
+    XDP_RATE_LIMIT_BUCKET *Bucket;
+    UINT32 ProcessorIndex = KeGetCurrentProcessorIndex();
+    UINT64 CurrentTime = KeQueryInterruptTime();
+    UINT64 Elapsed;
 
-    for (ULONG RuleIndex = 0; RuleIndex < Program->RuleCount; RuleIndex++) {
-        XDP_RULE *Rule = &Program->Rules[RuleIndex];
+    ASSERT(ProcessorIndex < RateLimiter->BucketCount);
+    Bucket = &RateLimiter->Buckets[ProcessorIndex];
 
+    Elapsed = CurrentTime - Bucket->LastRefillTime;
+    if (Elapsed > 0) {
         //
-        // Check the match conditions.
+        // Avoid overflow by refilling the bucket outright after long idle
+        // intervals.
         //
-
-        switch (Rule->Match) {
-        case XDP_MATCH_ALL:
-            Matched = TRUE;
-            break;
-
-        case XDP_MATCH_UDP:
-            if (!FrameCache.UdpCached) {
-                XdpParseFrame(
-                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
-            }
-            if (FrameCache.UdpValid) {
-                Matched = TRUE;
+        if (Elapsed >= RateLimiter->MaxRefillInterval) {
+            Bucket->Tokens = RateLimiter->Capacity;
+        } else {
+            Bucket->Tokens += Elapsed * RateLimiter->FramesPerSecond;
+            if (Bucket->Tokens > RateLimiter->Capacity) {
+                Bucket->Tokens = RateLimiter->Capacity;
             }
-            break;
+        }
+        Bucket->LastRefillTime = CurrentTime;
+    }
 
-        case XDP_MATCH_UDP_DST:
-            if (!FrameCache.UdpCached) {
-                XdpParseFrame(
-                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
-            }
-            if (FrameCache.UdpValid &&
-                FrameCache.UdpHdr->uh_dport == Rule->Pattern.Port) {
-                Matched = TRUE;
-            }
-            break;
+    if (Bucket->Tokens < XDP_RATE_LIMIT_TOKENS_PER_FRAME) {
+        STAT_INC(&Bucket->Stats, FramesExceeded);
+        return FALSE;
+    }
 
-        case XDP_MATCH_IPV4_DST_MASK:
-            if (!FrameCache.Ip4Cached) {
-                XdpParseFrame(
-                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
-            }
-            if (FrameCache.Ip4Valid &&
-                Ipv4PrefixMatch(
-                    &FrameCache.Ip4Hdr->DestinationAddress, &Rule->Pattern.IpMask.Address.Ipv4,
-                    &Rule->Pattern.IpMask.Mask.Ipv4)) {
-                Matched = TRUE;
-            }
-            break;
+    Bucket->Tokens -= XDP_RATE_LIMIT_TOKENS_PER_FRAME;
+    STAT_INC(&Bucket->Stats, FramesConformed);
+    return TRUE;
+}
 
-        case XDP_MATCH_IPV6_DST_MASK:
-            if (!FrameCache.Ip6Cached) {
-                XdpParseFrame(
-                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
-            }
-            if (FrameCache.Ip6Valid &&
-                Ipv6PrefixMatch(
-                    &FrameCache.Ip6Hdr->DestinationAddress,
-                    &Rule->Pattern.IpMask.Address.Ipv6,
-                    &Rule->Pattern.IpMask.Mask.Ipv6)) {
-                Matched = TRUE;
-            }
-            break;
+#define XDP_CLASSIFIER_HASH_BASIS 2166136261ui32
+#define XDP_CLASSIFIER_HASH_PRIME 16777619ui32
 
-        case XDP_MATCH_INNER_IPV4_DST_MASK_UDP:
-            if (!FrameCache.Ip4Cached) {
-                XdpParseFrame(
-                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
-            }
+static
+UINT32
+XdpClassifierHash(
+    _In_ UINT32 Hash,
+    _In_reads_bytes_(Length) const VOID *Data,
+    _In_ UINT32 Length
+    )
+{
+    const UINT8 *Bytes = Data;
 
-            if (!FrameCache.IpPayloadValid) {
-                break;
-            }
+    //
+    // FNV-1a over the key bytes.
+    //
+    for (UINT32 i = 0; i < Length; i++) {
+        Hash = (Hash ^ Bytes[i]) * XDP_CLASSIFIER_HASH_PRIME;
+    }
 
-            if (!FrameCache.InnerIpCached) {
-                XdpParseInnerIpHeader(
-                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache.IpPayload, &Program->FrameStorage, &FrameCache);
-            }
+    return Hash;
+}
 
-            if (FrameCache.InnerIp4Valid &&
-                FrameCache.InnerIp4Hdr->Protocol == IPPROTO_UDP &&
-                Ipv4PrefixMatch(
-                    &FrameCache.InnerIp4Hdr->DestinationAddress, &Rule->Pattern.IpMask.Address.Ipv4,
-                    &Rule->Pattern.IpMask.Mask.Ipv4)) {
-                Matched = TRUE;
-            }
-            break;
+static
+UINT32
+XdpClassifierHashTuple(
+    _In_reads_bytes_(AddressLength) const VOID *SourceAddress,
+    _In_reads_bytes_(AddressLength) const VOID *DestinationAddress,
+    _In_ UINT32 AddressLength,
+    _In_ UINT16 SourcePort,
+    _In_ UINT16 DestinationPort
+    )
+{
+    UINT32 Hash = XDP_CLASSIFIER_HASH_BASIS;
 
-        case XDP_MATCH_INNER_IPV6_DST_MASK_UDP:
-            if (!FrameCache.Ip6Cached) {
-                XdpParseFrame(
-                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
-            }
+    Hash = XdpClassifierHash(Hash, SourceAddress, AddressLength);
+    Hash = XdpClassifierHash(Hash, DestinationAddress, AddressLength);
+    Hash = XdpClassifierHash(Hash, &SourcePort, sizeof(SourcePort));
+    return XdpClassifierHash(Hash, &DestinationPort, sizeof(DestinationPort));
+}
 
-            if (!FrameCache.IpPayloadValid) {
-                break;
-            }
+static
+UINT32
+XdpFlowHashToKey(
+    _In_ const XDP_PROGRAM_FRAME_CACHE *Cache,
+    _In_ const XDP_TOEPLITZ_TABLE *FlowHashTable,
+    _In_ UINT32 QueueId,
+    _In_ UINT32 Width
+    )
+{
+    UCHAR Input[XDP_TOEPLITZ_MAX_INPUT_SIZE];
+    UINT32 AddressLength;
+    UINT32 InputLength;
+    UINT32 Hash;
 
-            if (!FrameCache.InnerIpCached) {
-                XdpParseInnerIpHeader(
-                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache.IpPayload, &Program->FrameStorage, &FrameCache);
-            }
+    //
+    // Hash the 5-tuple of TCP and UDP frames, and the address pair of other IP
+    // frames, so every frame of a flow maps to the same key. The input is laid
+    // out as for RSS, and the hash is keyed by a random secret so remote peers
+    // cannot steer their flows onto a chosen key.
+    //
+    if (Cache->Ip4Valid) {
+        AddressLength = sizeof(IN_ADDR);
+        RtlCopyMemory(&Input[0], &Cache->Ip4Hdr->SourceAddress, AddressLength);
+        RtlCopyMemory(&Input[AddressLength], &Cache->Ip4Hdr->DestinationAddress, AddressLength);
+    } else if (Cache->Ip6Valid) {
+        AddressLength = sizeof(IN6_ADDR);
+        RtlCopyMemory(&Input[0], &Cache->Ip6Hdr->SourceAddress, AddressLength);
+        RtlCopyMemory(&Input[AddressLength], &Cache->Ip6Hdr->DestinationAddress, AddressLength);
+    } else {
+        //
+        // Frames without an IP header have no flow; spread them by RX queue
+        // instead of collapsing them all onto key zero.
+        //
+        return QueueId % Width;
+    }
 
-            if (FrameCache.InnerIp6Valid &&
-                FrameCache.InnerIp6Hdr->NextHeader == IPPROTO_UDP &&
-                Ipv6PrefixMatch(
-                    &FrameCache.InnerIp6Hdr->DestinationAddress,
-                    &Rule->Pattern.IpMask.Address.Ipv6,
-                    &Rule->Pattern.IpMask.Mask.Ipv6)) {
-                Matched = TRUE;
-            }
-            break;
+    InputLength = AddressLength * 2;
+
+    if (Cache->UdpValid) {
+        RtlCopyMemory(&Input[InputLength], &Cache->UdpHdr->uh_sport, sizeof(UINT16));
+        RtlCopyMemory(
+            &Input[InputLength + sizeof(UINT16)], &Cache->UdpHdr->uh_dport, sizeof(UINT16));
+        InputLength += 2 * sizeof(UINT16);
+    } else if (Cache->TcpValid) {
+        RtlCopyMemory(&Input[InputLength], &Cache->TcpHdr->th_sport, sizeof(UINT16));
+        RtlCopyMemory(
+            &Input[InputLength + sizeof(UINT16)], &Cache->TcpHdr->th_dport, sizeof(UINT16));
+        InputLength += 2 * sizeof(UINT16);
+    }
 
-        case XDP_MATCH_QUIC_FLOW_SRC_CID:
-        case XDP_MATCH_QUIC_FLOW_DST_CID:
-            if (!FrameCache.UdpCached || !FrameCache.TransportPayloadCached) {
-                XdpParseFrame(
-                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
-            }
+    Hash = XdpToeplitzHash(FlowHashTable, Input, InputLength);
 
-            if (!FrameCache.UdpValid || !FrameCache.TransportPayloadValid ||
-                FrameCache.UdpHdr->uh_dport != Rule->Pattern.QuicFlow.UdpPort) {
-                break;
-            }
+    //
+    // Map the hash onto [0, Width) with a multiply and shift rather than a
+    // division.
+    //
+    return (UINT32)(((UINT64)Hash * Width) >> 32);
+}
 
-            if (!FrameCache.QuicCached) {
-                XdpParseQuicHeader(
-                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache.TransportPayload, &Program->FrameStorage, &FrameCache);
-            }
+static
+BOOLEAN
+XdpClassifierGetBit(
+    _In_ const UINT8 *Address,
+    _In_ UINT32 BitIndex
+    )
+{
+    return (Address[BitIndex / 8] >> (7 - (BitIndex % 8))) & 0x1;
+}
 
-            if (FrameCache.QuicValid &&
-                QuicCidMatch(
-                    Rule->Match,
-                    &FrameCache,
-                    &Rule->Pattern.QuicFlow)) {
-                Matched = TRUE;
-            }
-            break;
+static
+BOOLEAN
+XdpClassifierPrefixMatch(
+    _In_ const UINT8 *Address,
+    _In_ const UINT8 *Prefix,
+    _In_ UINT32 PrefixLength
+    )
+{
+    UINT32 Bytes = PrefixLength / 8;
+    UINT32 Bits = PrefixLength % 8;
 
-        case XDP_MATCH_IPV4_UDP_TUPLE:
-        case XDP_MATCH_IPV6_UDP_TUPLE:
-            if (!FrameCache.UdpCached) {
-                XdpParseFrame(
-                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
-            }
-            if (FrameCache.UdpValid &&
-                UdpTupleMatch(
-                    Rule->Match,
-                    &FrameCache,
-                    &Rule->Pattern.Tuple)) {
-                Matched = TRUE;
-            }
-            break;
+    if (!RtlEqualMemory(Address, Prefix, Bytes)) {
+        return FALSE;
+    }
 
-        case XDP_MATCH_UDP_PORT_SET:
-            if (!FrameCache.UdpCached) {
-                XdpParseFrame(
-                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
-            }
-            if (FrameCache.UdpValid &&
-                XdpTestBitNoFence(Rule->Pattern.PortSet.PortSet, FrameCache.UdpHdr->uh_dport)) {
-                Matched = TRUE;
-            }
-            break;
+    return
+        Bits == 0 ||
+        ((Address[Bytes] ^ Prefix[Bytes]) & (UINT8)(0xFF << (8 - Bits))) == 0;
+}
 
-        case XDP_MATCH_IPV4_UDP_PORT_SET:
-            if (!FrameCache.UdpCached) {
-                XdpParseFrame(
-                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
-            }
-            if (FrameCache.Ip4Valid &&
-                IN4_ADDR_EQUAL(
-                    &FrameCache.Ip4Hdr->DestinationAddress,
-                    &Rule->Pattern.IpPortSet.Address.Ipv4) &&
-                FrameCache.UdpValid &&
-                XdpTestBitNoFence(Rule->Pattern.IpPortSet.PortSet.PortSet, FrameCache.UdpHdr->uh_dport)) {
-                Matched = TRUE;
-            }
-            break;
+static
+BOOLEAN
+XdpClassifierKeyMatch(
+    _In_ const XDP_RULE *Rule,
+    _In_ const XDP_PROGRAM_FRAME_CACHE *Cache
+    )
+{
+    switch (Rule->Match) {
+    case XDP_MATCH_UDP_DST:
+        return Cache->UdpHdr->uh_dport == Rule->Pattern.Port;
 
-        case XDP_MATCH_IPV6_UDP_PORT_SET:
-            if (!FrameCache.UdpCached) {
-                XdpParseFrame(
-                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
-            }
-            if (FrameCache.Ip6Valid &&
-                IN6_ADDR_EQUAL(
-                    &FrameCache.Ip6Hdr->DestinationAddress,
-                    &Rule->Pattern.IpPortSet.Address.Ipv6) &&
-                FrameCache.UdpValid &&
-                XdpTestBitNoFence(Rule->Pattern.IpPortSet.PortSet.PortSet, FrameCache.UdpHdr->uh_dport)) {
-                Matched = TRUE;
-            }
-            break;
+    case XDP_MATCH_TCP_DST:
+        return Cache->TcpHdr->th_dport == Rule->Pattern.Port;
 
-        case XDP_MATCH_IPV4_TCP_PORT_SET:
-            if (!FrameCache.TcpCached) {
-                XdpParseFrame(
-                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
+    case XDP_MATCH_IPV4_UDP_TUPLE:
+    case XDP_MATCH_IPV6_UDP_TUPLE:
+        return UdpTupleMatch(Rule->Match, Cache, &Rule->Pattern.Tuple);
+
+    case XDP_MATCH_QUIC_FLOW_SRC_CID:
+    case XDP_MATCH_QUIC_FLOW_DST_CID:
+    case XDP_MATCH_TCP_QUIC_FLOW_SRC_CID:
+    case XDP_MATCH_TCP_QUIC_FLOW_DST_CID:
+        return QuicCidMatch(Rule->Match, Cache, &Rule->Pattern.QuicFlow);
+
+    default:
+        ASSERT(FALSE);
+        return FALSE;
+    }
+}
+
+static
+UINT32
+XdpClassifierHashLookup(
+    _In_ const XDP_PROGRAM *Program,
+    _In_ const XDP_PROGRAM_CLASSIFIER_SEGMENT *Segment,
+    _In_ UINT32 Hash,
+    _In_ const XDP_PROGRAM_FRAME_CACHE *Cache
+    )
+{
+    UINT32 Slot = Hash & Segment->Hash.SlotMask;
+
+    //
+    // Rules are inserted in order with linear probing, so the first rule with
+    // a matching key is also the lowest-indexed one. The table always has free
+    // slots, which terminates unsuccessful probes.
+    //
+    for (;;) {
+        UINT32 RuleIndex = Segment->Hash.Slots[Slot];
+
+        if (RuleIndex == XDP_PROGRAM_CLASSIFIER_NONE) {
+            return Segment->RuleEnd;
+        }
+
+        if (XdpClassifierKeyMatch(&Program->Rules[RuleIndex], Cache)) {
+            return RuleIndex;
+        }
+
+        Slot = (Slot + 1) & Segment->Hash.SlotMask;
+    }
+}
+
+static
+UINT32
+XdpClassifierTrieLookup(
+    _In_ const XDP_PROGRAM_CLASSIFIER_SEGMENT *Segment,
+    _In_ const UINT8 *Address,
+    _In_ UINT32 AddressLength
+    )
+{
+    UINT32 Result = Segment->RuleEnd;
+    UINT32 NodeIndex = Segment->Trie.Root;
+
+    //
+    // Every prefix that matches the address lies on the path from the root, so
+    // walk the entire path and keep the lowest rule index.
+    //
+    while (NodeIndex != XDP_PROGRAM_CLASSIFIER_NONE) {
+        const XDP_PROGRAM_CLASSIFIER_NODE *Node = &Segment->Trie.Nodes[NodeIndex];
+
+        if (!XdpClassifierPrefixMatch(Address, Node->Prefix, Node->PrefixLength)) {
+            break;
+        }
+
+        Result = min(Result, Node->RuleIndex);
+
+        if (Node->PrefixLength == AddressLength) {
+            break;
+        }
+
+        NodeIndex = Node->Child[XdpClassifierGetBit(Address, Node->PrefixLength)];
+    }
+
+    return Result;
+}
+
+static
+UINT32
+XdpClassifierQuicCidLookup(
+    _In_ XDP_PROGRAM *Program,
+    _In_ const XDP_PROGRAM_CLASSIFIER_SEGMENT *Segment,
+    _In_ XDP_FRAME *Frame,
+    _In_opt_ XDP_RING *FragmentRing,
+    _In_opt_ XDP_EXTENSION *FragmentExtension,
+    _In_ UINT32 FragmentIndex,
+    _In_ XDP_EXTENSION *VirtualAddressExtension,
+    _Inout_ XDP_PROGRAM_FRAME_CACHE *FrameCache
+    )
+{
+    //
+    // All rules in the segment share the same CID offset and length.
+    //
+    const XDP_QUIC_FLOW *Flow = &Program->Rules[Segment->RuleStart].Pattern.QuicFlow;
+    UINT32 Hash;
+
+    if (!FrameCache->QuicCached) {
+        XdpParseQuicHeader(
+            Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+            &FrameCache->TransportPayload, &Program->FrameStorage, FrameCache);
+    }
+
+    if (!FrameCache->QuicValid ||
+        FrameCache->QuicCidLength < Flow->CidOffset + Flow->CidLength) {
+        return Segment->RuleEnd;
+    }
+
+    Hash =
+        XdpClassifierHash(
+            XDP_CLASSIFIER_HASH_BASIS, &FrameCache->QuicCid[Flow->CidOffset], Flow->CidLength);
+
+    return XdpClassifierHashLookup(Program, Segment, Hash, FrameCache);
+}
+
+//
+// Returns the index of the first rule within the segment that may match the
+// frame, or the end of the segment if none can match.
+//
+static
+UINT32
+XdpClassifierLookup(
+    _In_ XDP_PROGRAM *Program,
+    _In_ const XDP_PROGRAM_CLASSIFIER_SEGMENT *Segment,
+    _In_ XDP_FRAME *Frame,
+    _In_opt_ XDP_RING *FragmentRing,
+    _In_opt_ XDP_EXTENSION *FragmentExtension,
+    _In_ UINT32 FragmentIndex,
+    _In_ XDP_EXTENSION *VirtualAddressExtension,
+    _Inout_ XDP_PROGRAM_FRAME_CACHE *FrameCache
+    )
+{
+    const XDP_RULE *FirstRule = &Program->Rules[Segment->RuleStart];
+    UINT32 Hash;
+
+    switch (Segment->Match) {
+    case XDP_MATCH_UDP_DST:
+        if (!FrameCache->UdpCached) {
+            XdpParseFrame(
+                Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                FrameCache, &Program->FrameStorage);
+        }
+        if (!FrameCache->UdpValid) {
+            break;
+        }
+        Hash =
+            XdpClassifierHash(
+                XDP_CLASSIFIER_HASH_BASIS, &FrameCache->UdpHdr->uh_dport,
+                sizeof(FrameCache->UdpHdr->uh_dport));
+        return XdpClassifierHashLookup(Program, Segment, Hash, FrameCache);
+
+    case XDP_MATCH_TCP_DST:
+        if (!FrameCache->TcpCached) {
+            XdpParseFrame(
+                Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                FrameCache, &Program->FrameStorage);
+        }
+        if (!FrameCache->TcpValid) {
+            break;
+        }
+        Hash =
+            XdpClassifierHash(
+                XDP_CLASSIFIER_HASH_BASIS, &FrameCache->TcpHdr->th_dport,
+                sizeof(FrameCache->TcpHdr->th_dport));
+        return XdpClassifierHashLookup(Program, Segment, Hash, FrameCache);
+
+    case XDP_MATCH_IPV4_UDP_TUPLE:
+        if (!FrameCache->UdpCached) {
+            XdpParseFrame(
+                Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                FrameCache, &Program->FrameStorage);
+        }
+        if (!FrameCache->UdpValid || !FrameCache->Ip4Valid) {
+            break;
+        }
+        Hash =
+            XdpClassifierHashTuple(
+                &FrameCache->Ip4Hdr->SourceAddress, &FrameCache->Ip4Hdr->DestinationAddress,
+                sizeof(IN_ADDR), FrameCache->UdpHdr->uh_sport, FrameCache->UdpHdr->uh_dport);
+        return XdpClassifierHashLookup(Program, Segment, Hash, FrameCache);
+
+    case XDP_MATCH_IPV6_UDP_TUPLE:
+        if (!FrameCache->UdpCached) {
+            XdpParseFrame(
+                Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                FrameCache, &Program->FrameStorage);
+        }
+        if (!FrameCache->UdpValid || !FrameCache->Ip6Valid) {
+            break;
+        }
+        Hash =
+            XdpClassifierHashTuple(
+                &FrameCache->Ip6Hdr->SourceAddress, &FrameCache->Ip6Hdr->DestinationAddress,
+                sizeof(IN6_ADDR), FrameCache->UdpHdr->uh_sport, FrameCache->UdpHdr->uh_dport);
+        return XdpClassifierHashLookup(Program, Segment, Hash, FrameCache);
+
+    case XDP_MATCH_QUIC_FLOW_SRC_CID:
+    case XDP_MATCH_QUIC_FLOW_DST_CID:
+        if (!FrameCache->UdpCached || !FrameCache->TransportPayloadCached) {
+            XdpParseFrame(
+                Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                FrameCache, &Program->FrameStorage);
+        }
+        if (!FrameCache->UdpValid || !FrameCache->TransportPayloadValid ||
+            FrameCache->UdpHdr->uh_dport != FirstRule->Pattern.QuicFlow.UdpPort) {
+            break;
+        }
+        return
+            XdpClassifierQuicCidLookup(
+                Program, Segment, Frame, FragmentRing, FragmentExtension, FragmentIndex,
+                VirtualAddressExtension, FrameCache);
+
+    case XDP_MATCH_TCP_QUIC_FLOW_SRC_CID:
+    case XDP_MATCH_TCP_QUIC_FLOW_DST_CID:
+        if (!FrameCache->TcpCached || !FrameCache->TransportPayloadCached) {
+            XdpParseFrame(
+                Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                FrameCache, &Program->FrameStorage);
+        }
+        if (!FrameCache->TcpValid || !FrameCache->TransportPayloadValid ||
+            FrameCache->TcpHdr->th_dport != FirstRule->Pattern.QuicFlow.UdpPort) {
+            break;
+        }
+        return
+            XdpClassifierQuicCidLookup(
+                Program, Segment, Frame, FragmentRing, FragmentExtension, FragmentIndex,
+                VirtualAddressExtension, FrameCache);
+
+    case XDP_MATCH_IPV4_DST_MASK:
+        if (!FrameCache->Ip4Cached) {
+            XdpParseFrame(
+                Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                FrameCache, &Program->FrameStorage);
+        }
+        if (!FrameCache->Ip4Valid) {
+            break;
+        }
+        return
+            XdpClassifierTrieLookup(
+                Segment, (const UINT8 *)&FrameCache->Ip4Hdr->DestinationAddress,
+                sizeof(IN_ADDR) * 8);
+
+    case XDP_MATCH_IPV6_DST_MASK:
+        if (!FrameCache->Ip6Cached) {
+            XdpParseFrame(
+                Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                FrameCache, &Program->FrameStorage);
+        }
+        if (!FrameCache->Ip6Valid) {
+            break;
+        }
+        return
+            XdpClassifierTrieLookup(
+                Segment, (const UINT8 *)&FrameCache->Ip6Hdr->DestinationAddress,
+                sizeof(IN6_ADDR) * 8);
+
+    default:
+        ASSERT(FALSE);
+        break;
+    }
+
+    return Segment->RuleEnd;
+}
+
+static
+FORCEINLINE
+XDP_RX_ACTION
+XdpInspectFrame(
+    _In_ XDP_PROGRAM *Program,
+    _In_ XDP_INSPECTION_CONTEXT *InspectionContext,
+    _In_ XDP_RING *FrameRing,
+    _In_ UINT32 FrameIndex,
+    _In_opt_ XDP_RING *FragmentRing,
+    _In_opt_ XDP_EXTENSION *FragmentExtension,
+    _In_ UINT32 FragmentIndex,
+    _In_ XDP_EXTENSION *VirtualAddressExtension,
+    _Inout_ XDP_PROGRAM_FRAME_CACHE *FrameCache
+    )
+{
+    XDP_RX_ACTION Action = XDP_RX_ACTION_PASS;
+    XDP_FRAME *Frame;
+    BOOLEAN Matched = FALSE;
+    XDP_PCW_RX_QUEUE *RxQueueStats = XdpRxQueueGetStatsFromInspectionContext(InspectionContext);
+    VOID *CidMapTarget = NULL;
+    const XDP_MAP_TABLE_VALUE *MapValue = NULL;
+    const XDP_PROGRAM_CLASSIFIER_SEGMENT *Segment = NULL;
+    const XDP_PROGRAM_CLASSIFIER_SEGMENT *SegmentEnd = NULL;
+
+    ASSERT(FrameIndex <= FrameRing->Mask);
+    ASSERT(
+        (FragmentRing == NULL && FragmentIndex == 0) ||
+        (FragmentRing && FragmentIndex <= FragmentRing->Mask));
+
+    Frame = XdpRingGetElement(FrameRing, FrameIndex);
+
+    if (Program->Classifier != NULL) {
+        Segment = Program->Classifier->Segments;
+        SegmentEnd = Segment + Program->Classifier->SegmentCount;
+    }
+
+    for (ULONG RuleIndex = 0; RuleIndex < Program->RuleCount; RuleIndex++) {
+        XDP_RULE *Rule;
+
+        //
+        // When reaching an indexed segment, skip directly to the first rule in
+        // the segment that may match, or past the segment entirely. The match
+        // conditions of the candidate rule are still evaluated below.
+        //
+        while (Segment < SegmentEnd && Segment->RuleStart == RuleIndex) {
+            RuleIndex =
+                XdpClassifierLookup(
+                    Program, Segment, Frame, FragmentRing, FragmentExtension, FragmentIndex,
+                    VirtualAddressExtension, FrameCache);
+            Segment++;
+        }
+
+        if (RuleIndex >= Program->RuleCount) {
+            break;
+        }
+
+        Rule = &Program->Rules[RuleIndex];
+
+        //
+        // Check the match conditions.
+        //
+
+        switch (Rule->Match) {
+        case XDP_MATCH_ALL:
+            Matched = TRUE;
+            break;
+
+        case XDP_MATCH_UDP:
+            if (!FrameCache->UdpCached) {
+                XdpParseFrame(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache, &Program->FrameStorage);
             }
-            if (FrameCache.Ip4Valid &&
-                IN4_ADDR_EQUAL(
-                    &FrameCache.Ip4Hdr->DestinationAddress,
-                    &Rule->Pattern.IpPortSet.Address.Ipv4) &&
-                FrameCache.TcpValid &&
-                XdpTestBitNoFence(Rule->Pattern.IpPortSet.PortSet.PortSet, FrameCache.TcpHdr->th_dport)) {
+            if (FrameCache->UdpValid) {
                 Matched = TRUE;
             }
             break;
 
-        case XDP_MATCH_IPV6_TCP_PORT_SET:
-            if (!FrameCache.TcpCached) {
+        case XDP_MATCH_UDP_DST:
+            if (!FrameCache->UdpCached) {
                 XdpParseFrame(
                     Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
+                    FrameCache, &Program->FrameStorage);
             }
-            if (FrameCache.Ip6Valid &&
-                IN6_ADDR_EQUAL(
-                    &FrameCache.Ip6Hdr->DestinationAddress,
-                    &Rule->Pattern.IpPortSet.Address.Ipv6) &&
-                FrameCache.TcpValid &&
-                XdpTestBitNoFence(Rule->Pattern.IpPortSet.PortSet.PortSet, FrameCache.TcpHdr->th_dport)) {
+            if (FrameCache->UdpValid &&
+                FrameCache->UdpHdr->uh_dport == Rule->Pattern.Port) {
                 Matched = TRUE;
             }
             break;
 
-        case XDP_MATCH_TCP_DST:
-            if (!FrameCache.TcpCached) {
+        case XDP_MATCH_IPV4_DST_MASK:
+            if (!FrameCache->Ip4Cached) {
                 XdpParseFrame(
                     Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
+                    FrameCache, &Program->FrameStorage);
             }
-            if (FrameCache.TcpValid &&
-                FrameCache.TcpHdr->th_dport == Rule->Pattern.Port) {
+            if (FrameCache->Ip4Valid &&
+                Ipv4PrefixMatch(
+                    FrameCache->Ip4Hdr->DestinationAddress, &Rule->Pattern.IpMask.Address.Ipv4,
+                    &Rule->Pattern.IpMask.Mask.Ipv4)) {
                 Matched = TRUE;
             }
             break;
 
-        case XDP_MATCH_TCP_QUIC_FLOW_SRC_CID:
-        case XDP_MATCH_TCP_QUIC_FLOW_DST_CID:
-            if (!FrameCache.TcpCached || !FrameCache.TransportPayloadCached) {
+        case XDP_MATCH_IPV6_DST_MASK:
+            if (!FrameCache->Ip6Cached) {
+                XdpParseFrame(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache, &Program->FrameStorage);
+            }
+            if (FrameCache->Ip6Valid &&
+                Ipv6PrefixMatch(
+                    FrameCache->Ip6Hdr->DestinationAddress,
+                    &Rule->Pattern.IpMask.Address.Ipv6,
+                    &Rule->Pattern.IpMask.Mask.Ipv6)) {
+                Matched = TRUE;
+            }
+            break;
+
+        case XDP_MATCH_INNER_IPV4_DST_MASK_UDP:
+            if (!FrameCache->Ip4Cached) {
                 XdpParseFrame(
                     Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
+                    FrameCache, &Program->FrameStorage);
             }
 
-            if (!FrameCache.TcpValid || !FrameCache.TransportPayloadValid ||
-                FrameCache.TcpHdr->th_dport != Rule->Pattern.QuicFlow.UdpPort) {
+            if (!FrameCache->IpPayloadValid) {
                 break;
             }
 
-            if (!FrameCache.QuicCached) {
-                XdpParseQuicHeader(
+            if (!FrameCache->InnerIpCached) {
+                XdpParseInnerIpHeader(
                     Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache.TransportPayload, &Program->FrameStorage, &FrameCache);
+                    FrameCache->IpPayload, &Program->FrameStorage, FrameCache);
             }
 
-            if (FrameCache.QuicValid &&
-                QuicCidMatch(
-                    Rule->Match,
-                    &FrameCache,
-                    &Rule->Pattern.QuicFlow)) {
+            if (FrameCache->InnerIp4Valid &&
+                FrameCache->InnerIp4Hdr->Protocol == IPPROTO_UDP &&
+                Ipv4PrefixMatch(
+                    FrameCache->InnerIp4Hdr->DestinationAddress, &Rule->Pattern.IpMask.Address.Ipv4,
+                    &Rule->Pattern.IpMask.Mask.Ipv4)) {
                 Matched = TRUE;
             }
             break;
 
-        case XDP_MATCH_TCP_CONTROL_DST:
-            if (!FrameCache.TcpCached) {
+        case XDP_MATCH_INNER_IPV6_DST_MASK_UDP:
+            if (!FrameCache->Ip6Cached) {
                 XdpParseFrame(
                     Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
+                    FrameCache, &Program->FrameStorage);
             }
-            if (FrameCache.TcpValid &&
-                FrameCache.TcpHdr->th_dport == Rule->Pattern.Port &&
-                (FrameCache.TcpHdr->th_flags & (TH_SYN | TH_FIN | TH_RST)) != 0) {
-                Matched = TRUE;
+
+            if (!FrameCache->IpPayloadValid) {
+                break;
             }
-            break;
 
-        case XDP_MATCH_IP_NEXT_HEADER:
-            if (!(FrameCache.Ip4Cached || FrameCache.Ip6Cached)) {
-                XdpParseFrame(
+            if (!FrameCache->InnerIpCached) {
+                XdpParseInnerIpHeader(
                     Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
+                    FrameCache->IpPayload, &Program->FrameStorage, FrameCache);
             }
-            if ((FrameCache.Ip4Valid && FrameCache.Ip4Hdr->Protocol == Rule->Pattern.NextHeader) ||
-                (FrameCache.Ip6Valid && FrameCache.Ip6Hdr->NextHeader == Rule->Pattern.NextHeader)) {
+
+            if (FrameCache->InnerIp6Valid &&
+                FrameCache->InnerIp6Hdr->NextHeader == IPPROTO_UDP &&
+                Ipv6PrefixMatch(
+                    FrameCache->InnerIp6Hdr->DestinationAddress,
+                    &Rule->Pattern.IpMask.Address.Ipv6,
+                    &Rule->Pattern.IpMask.Mask.Ipv6)) {
                 Matched = TRUE;
             }
             break;
 
-        case XDP_MATCH_ICMPV4_ECHO_REPLY_IP_DST:
-            if (!FrameCache.Ip4Cached) {
+        case XDP_MATCH_QUIC_FLOW_SRC_CID:
+        case XDP_MATCH_QUIC_FLOW_DST_CID:
+            if (!FrameCache->UdpCached || !FrameCache->TransportPayloadCached) {
                 XdpParseFrame(
                     Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
+                    FrameCache, &Program->FrameStorage);
             }
 
-            if (!FrameCache.IpPayloadValid || !FrameCache.Ip4Valid) {
+            if (!FrameCache->UdpValid || !FrameCache->TransportPayloadValid ||
+                FrameCache->UdpHdr->uh_dport != Rule->Pattern.QuicFlow.UdpPort) {
                 break;
             }
 
-            if (!FrameCache.Icmp4Cached) {
-                XdpParseIcmp4Header(
+            if (!FrameCache->QuicCached) {
+                XdpParseQuicHeader(
                     Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache.IpPayload, &Program->FrameStorage, &FrameCache);
+                    FrameCache->TransportPayload, &Program->FrameStorage, FrameCache);
             }
 
-            if (FrameCache.Icmp4Valid &&
-                FrameCache.Icmpv4Hdr->Type == ICMP4_ECHOREPLY_TYPE &&
-                FrameCache.Icmpv4Hdr->Code == ICMP4_ECHOREPLY_CODE &&
-                IN4_ADDR_EQUAL(
-                    &FrameCache.Ip4Hdr->DestinationAddress,
-                    &Rule->Pattern.IpMask.Address.Ipv4)) {
-                ASSERT(FrameCache.Ip4Valid);
+            if (FrameCache->QuicValid &&
+                QuicCidMatch(
+                    Rule->Match,
+                    FrameCache,
+                    &Rule->Pattern.QuicFlow)) {
                 Matched = TRUE;
             }
             break;
 
-        case XDP_MATCH_ICMPV6_ECHO_REPLY_IP_DST:
-            if (!FrameCache.Ip6Cached) {
+        case XDP_MATCH_QUIC_FLOW_SRC_CID_MAP:
+        case XDP_MATCH_QUIC_FLOW_DST_CID_MAP:
+            if (!FrameCache->UdpCached || !FrameCache->TransportPayloadCached) {
                 XdpParseFrame(
                     Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache, &Program->FrameStorage);
+                    FrameCache, &Program->FrameStorage);
             }
 
-            if (!FrameCache.IpPayloadValid || !FrameCache.Ip6Valid) {
+            if (!FrameCache->UdpValid || !FrameCache->TransportPayloadValid ||
+                FrameCache->UdpHdr->uh_dport != Rule->Pattern.QuicFlow.UdpPort) {
                 break;
             }
 
-            if (!FrameCache.Icmp6Cached) {
-                XdpParseIcmp6Header(
+            if (!FrameCache->QuicCached) {
+                XdpParseQuicHeader(
                     Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
-                    &FrameCache.IpPayload, &Program->FrameStorage, &FrameCache);
+                    FrameCache->TransportPayload, &Program->FrameStorage, FrameCache);
             }
 
-            if (FrameCache.Icmp6Valid &&
-                FrameCache.Icmpv6Hdr->Type == ICMP6_ECHOREPLY_TYPE &&
-                FrameCache.Icmpv6Hdr->Code == ICMP6_ECHOREPLY_CODE &&
-                IN6_ADDR_EQUAL(
-                    &FrameCache.Ip6Hdr->DestinationAddress,
-                    &Rule->Pattern.IpMask.Address.Ipv6)) {
-                ASSERT(FrameCache.Ip6Valid);
+            if (!FrameCache->QuicValid) {
+                break;
+            }
+
+            //
+            // The rule matches only if the CID is present in the map; the XSK
+            // found by the lookup is the redirect target.
+            //
+            CidMapTarget =
+                QuicCidMapLookup(
+                    Rule->Match,
+                    FrameCache,
+                    &Rule->Pattern.QuicFlow,
+                    Rule->Redirect.Target);
+            if (CidMapTarget != NULL) {
                 Matched = TRUE;
             }
             break;
 
-        default:
-            ASSERT(FALSE);
+        case XDP_MATCH_IPV4_UDP_TUPLE:
+        case XDP_MATCH_IPV6_UDP_TUPLE:
+            if (!FrameCache->UdpCached) {
+                XdpParseFrame(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache, &Program->FrameStorage);
+            }
+            if (FrameCache->UdpValid &&
+                UdpTupleMatch(
+                    Rule->Match,
+                    FrameCache,
+                    &Rule->Pattern.Tuple)) {
+                Matched = TRUE;
+            }
             break;
-        }
 
-        if (Matched) {
-            //
-            // Apply the action.
-            //
-            switch (Rule->Action) {
-
-            case XDP_PROGRAM_ACTION_REDIRECT:
-                switch (Rule->Redirect.TargetType) {
+        case XDP_MATCH_UDP_PORT_SET:
+            if (!FrameCache->UdpCached) {
+                XdpParseFrame(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache, &Program->FrameStorage);
+            }
+            if (FrameCache->UdpValid &&
+                XdpTestBitNoFence(Rule->Pattern.PortSet.PortSet, FrameCache->UdpHdr->uh_dport)) {
+                Matched = TRUE;
+            }
+            break;
+
+        case XDP_MATCH_IPV4_UDP_PORT_SET:
+            if (!FrameCache->UdpCached) {
+                XdpParseFrame(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache, &Program->FrameStorage);
+            }
+            if (FrameCache->Ip4Valid &&
+                IN4_ADDR_EQUAL(
+                    FrameCache->Ip4Hdr->DestinationAddress,
+                    &Rule->Pattern.IpPortSet.Address.Ipv4) &&
+                FrameCache->UdpValid &&
+                XdpTestBitNoFence(Rule->Pattern.IpPortSet.PortSet.PortSet, FrameCache->UdpHdr->uh_dport)) {
+                Matched = TRUE;
+            }
+            break;
+
+        case XDP_MATCH_IPV6_UDP_PORT_SET:
+            if (!FrameCache->UdpCached) {
+                XdpParseFrame(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache, &Program->FrameStorage);
+            }
+            if (FrameCache->Ip6Valid &&
+                IN6_ADDR_EQUAL(
+                    FrameCache->Ip6Hdr->DestinationAddress,
+                    &Rule->Pattern.IpPortSet.Address.Ipv6) &&
+                FrameCache->UdpValid &&
+                XdpTestBitNoFence(Rule->Pattern.IpPortSet.PortSet.PortSet, FrameCache->UdpHdr->uh_dport)) {
+                Matched = TRUE;
+            }
+            break;
+
+        case XDP_MATCH_IPV4_TCP_PORT_SET:
+            if (!FrameCache->TcpCached) {
+                XdpParseFrame(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache, &Program->FrameStorage);
+            }
+            if (FrameCache->Ip4Valid &&
+                IN4_ADDR_EQUAL(
+                    FrameCache->Ip4Hdr->DestinationAddress,
+                    &Rule->Pattern.IpPortSet.Address.Ipv4) &&
+                FrameCache->TcpValid &&
+                XdpTestBitNoFence(Rule->Pattern.IpPortSet.PortSet.PortSet, FrameCache->TcpHdr->th_dport)) {
+                Matched = TRUE;
+            }
+            break;
+
+        case XDP_MATCH_IPV6_TCP_PORT_SET:
+            if (!FrameCache->TcpCached) {
+                XdpParseFrame(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache, &Program->FrameStorage);
+            }
+            if (FrameCache->Ip6Valid &&
+                IN6_ADDR_EQUAL(
+                    FrameCache->Ip6Hdr->DestinationAddress,
+                    &Rule->Pattern.IpPortSet.Address.Ipv6) &&
+                FrameCache->TcpValid &&
+                XdpTestBitNoFence(Rule->Pattern.IpPortSet.PortSet.PortSet, FrameCache->TcpHdr->th_dport)) {
+                Matched = TRUE;
+            }
+            break;
+
+        case XDP_MATCH_TCP_DST:
+            if (!FrameCache->TcpCached) {
+                XdpParseFrame(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache, &Program->FrameStorage);
+            }
+            if (FrameCache->TcpValid &&
+                FrameCache->TcpHdr->th_dport == Rule->Pattern.Port) {
+                Matched = TRUE;
+            }
+            break;
+
+        case XDP_MATCH_TCP_QUIC_FLOW_SRC_CID:
+        case XDP_MATCH_TCP_QUIC_FLOW_DST_CID:
+            if (!FrameCache->TcpCached || !FrameCache->TransportPayloadCached) {
+                XdpParseFrame(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache, &Program->FrameStorage);
+            }
+
+            if (!FrameCache->TcpValid || !FrameCache->TransportPayloadValid ||
+                FrameCache->TcpHdr->th_dport != Rule->Pattern.QuicFlow.UdpPort) {
+                break;
+            }
+
+            if (!FrameCache->QuicCached) {
+                XdpParseQuicHeader(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache->TransportPayload, &Program->FrameStorage, FrameCache);
+            }
+
+            if (FrameCache->QuicValid &&
+                QuicCidMatch(
+                    Rule->Match,
+                    FrameCache,
+                    &Rule->Pattern.QuicFlow)) {
+                Matched = TRUE;
+            }
+            break;
+
+        case XDP_MATCH_TCP_CONTROL_DST:
+            if (!FrameCache->TcpCached) {
+                XdpParseFrame(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache, &Program->FrameStorage);
+            }
+            if (FrameCache->TcpValid &&
+                FrameCache->TcpHdr->th_dport == Rule->Pattern.Port &&
+                (FrameCache->TcpHdr->th_flags & (TH_SYN | TH_FIN | TH_RST)) != 0) {
+                Matched = TRUE;
+            }
+            break;
+
+        case XDP_MATCH_IP_NEXT_HEADER:
+            if (!(FrameCache->Ip4Cached || FrameCache->Ip6Cached)) {
+                XdpParseFrame(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache, &Program->FrameStorage);
+            }
+            if ((FrameCache->Ip4Valid && FrameCache->Ip4Hdr->Protocol == Rule->Pattern.NextHeader) ||
+                (FrameCache->Ip6Valid && FrameCache->Ip6Hdr->NextHeader == Rule->Pattern.NextHeader)) {
+                Matched = TRUE;
+            }
+            break;
+
+        case XDP_MATCH_ICMPV4_ECHO_REPLY_IP_DST:
+            if (!FrameCache->Ip4Cached) {
+                XdpParseFrame(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache, &Program->FrameStorage);
+            }
+
+            if (!FrameCache->IpPayloadValid || !FrameCache->Ip4Valid) {
+                break;
+            }
+
+            if (!FrameCache->Icmp4Cached) {
+                XdpParseIcmp4Header(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache->IpPayload, &Program->FrameStorage, FrameCache);
+            }
+
+            if (FrameCache->Icmp4Valid &&
+                FrameCache->Icmpv4Hdr->Type == ICMP4_ECHOREPLY_TYPE &&
+                FrameCache->Icmpv4Hdr->Code == ICMP4_ECHOREPLY_CODE &&
+                IN4_ADDR_EQUAL(
+                    FrameCache->Ip4Hdr->DestinationAddress,
+                    &Rule->Pattern.IpMask.Address.Ipv4)) {
+                ASSERT(FrameCache->Ip4Valid);
+                Matched = TRUE;
+            }
+            break;
+
+        case XDP_MATCH_ICMPV6_ECHO_REPLY_IP_DST:
+            if (!FrameCache->Ip6Cached) {
+                XdpParseFrame(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache, &Program->FrameStorage);
+            }
+
+            if (!FrameCache->IpPayloadValid || !FrameCache->Ip6Valid) {
+                break;
+            }
+
+            if (!FrameCache->Icmp6Cached) {
+                XdpParseIcmp6Header(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache->IpPayload, &Program->FrameStorage, FrameCache);
+            }
+
+            if (FrameCache->Icmp6Valid &&
+                FrameCache->Icmpv6Hdr->Type == ICMP6_ECHOREPLY_TYPE &&
+                FrameCache->Icmpv6Hdr->Code == ICMP6_ECHOREPLY_CODE &&
+                IN6_ADDR_EQUAL(
+                    FrameCache->Ip6Hdr->DestinationAddress,
+                    &Rule->Pattern.IpMask.Address.Ipv6)) {
+                ASSERT(FrameCache->Ip6Valid);
+                Matched = TRUE;
+            }
+            break;
+
+        default:
+            ASSERT(FALSE);
+            break;
+        }
+
+        //
+        // Rules redirecting via a hash or LPM map match only frames found in
+        // the map; the map entry supplies the action.
+        //
+        if (Matched && Rule->Action == XDP_PROGRAM_ACTION_REDIRECT &&
+            XdpIsActionMapTarget(Rule->Redirect.TargetType)) {
+            if (!FrameCache->UdpCached || !FrameCache->TcpCached) {
+                XdpParseFrame(
+                    Frame, FragmentRing, FragmentExtension, FragmentIndex, VirtualAddressExtension,
+                    FrameCache, &Program->FrameStorage);
+            }
+
+            MapValue =
+                ActionMapLookup(Rule->Redirect.TargetType, Rule->Redirect.Target, FrameCache);
+            Matched = (MapValue != NULL);
+        }
+
+        if (Matched) {
+            //
+            // Apply the action.
+            //
+            switch (Rule->Action) {
+
+            case XDP_PROGRAM_ACTION_REDIRECT:
+                switch (Rule->Redirect.TargetType) {
                 case XDP_REDIRECT_TARGET_TYPE_XSK:
                     XdpRedirect(
-                        &InspectionContext->RedirectContext, FrameIndex, FragmentIndex,
+                        &InspectionContext->RedirectContext, FrameIndex, FragmentIndex, 0,
                         XDP_REDIRECT_TARGET_TYPE_XSK, Rule->Redirect.Target);
                     STAT_INC(RxQueueStats, InspectFramesRedirected);
                     break;
@@ -1414,7 +2078,38 @@ XdpInspect(
 
                     if (XskTarget != NULL) {
                         XdpRedirect(
-                            &InspectionContext->RedirectContext, FrameIndex, FragmentIndex,
+                            &InspectionContext->RedirectContext, FrameIndex, FragmentIndex, 0,
+                            XDP_REDIRECT_TARGET_TYPE_XSK, XskTarget);
+                        STAT_INC(RxQueueStats, InspectFramesRedirected);
+                    } else {
+                        STAT_INC(RxQueueStats, InspectFramesDropped);
+                    }
+                    break;
+                }
+
+                case XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_FLOW_HASH:
+                {
+                    VOID *XskTarget;
+
+                    if (!FrameCache->UdpCached || !FrameCache->TcpCached) {
+                        XdpParseFrame(
+                            Frame, FragmentRing, FragmentExtension, FragmentIndex,
+                            VirtualAddressExtension, FrameCache, &Program->FrameStorage);
+                    }
+
+                    ASSERT(
+                        XdpMapGetType(Rule->Redirect.Target) == XDP_MAP_TYPE_XSKMAP);
+                    XskTarget =
+                        XdpXskMapLookup(
+                            Rule->Redirect.Target,
+                            XdpFlowHashToKey(
+                                FrameCache, Program->FlowHashTable,
+                                XdpRxQueueGetQueueIdFromInspectionContext(InspectionContext),
+                                Rule->Redirect.FlowHashWidth));
+
+                    if (XskTarget != NULL) {
+                        XdpRedirect(
+                            &InspectionContext->RedirectContext, FrameIndex, FragmentIndex, 0,
                             XDP_REDIRECT_TARGET_TYPE_XSK, XskTarget);
                         STAT_INC(RxQueueStats, InspectFramesRedirected);
                     } else {
@@ -1423,6 +2118,49 @@ XdpInspect(
                     break;
                 }
 
+                case XDP_REDIRECT_TARGET_TYPE_QUIC_CID_MAP:
+                    //
+                    // The XSK was looked up while evaluating the match.
+                    //
+                    ASSERT(CidMapTarget != NULL);
+                    XdpRedirect(
+                        &InspectionContext->RedirectContext, FrameIndex, FragmentIndex, 0,
+                        XDP_REDIRECT_TARGET_TYPE_XSK, CidMapTarget);
+                    STAT_INC(RxQueueStats, InspectFramesRedirected);
+                    break;
+
+                case XDP_REDIRECT_TARGET_TYPE_INTERFACE_TX:
+                    XdpRedirect(
+                        &InspectionContext->RedirectContext, FrameIndex, FragmentIndex, 0,
+                        XDP_REDIRECT_TARGET_TYPE_INTERFACE_TX, Rule->Redirect.Target);
+                    STAT_INC(RxQueueStats, InspectFramesRedirected);
+                    break;
+
+                case XDP_REDIRECT_TARGET_TYPE_HASH_MAP_BY_FLOW:
+                case XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_SRC_ADDR:
+                case XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_DST_ADDR:
+                    //
+                    // The map entry was looked up while evaluating the match.
+                    //
+                    ASSERT(MapValue != NULL);
+
+                    if (MapValue->Action == XDP_PROGRAM_ACTION_PASS) {
+                        Action = XDP_RX_ACTION_PASS;
+                        STAT_INC(RxQueueStats, InspectFramesPassed);
+                        goto Done;
+                    }
+
+                    if (MapValue->Action == XDP_PROGRAM_ACTION_REDIRECT) {
+                        XdpRedirect(
+                            &InspectionContext->RedirectContext, FrameIndex, FragmentIndex, 0,
+                            XDP_REDIRECT_TARGET_TYPE_XSK, MapValue->Target);
+                        STAT_INC(RxQueueStats, InspectFramesRedirected);
+                    } else {
+                        ASSERT(MapValue->Action == XDP_PROGRAM_ACTION_DROP);
+                        STAT_INC(RxQueueStats, InspectFramesDropped);
+                    }
+                    break;
+
                 default:
                     ASSERT(FALSE);
                     break;
@@ -1453,7 +2191,30 @@ XdpInspect(
                 Action =
                     XdpL2Fwd(
                         Frame, FragmentRing, FragmentExtension, FragmentIndex,
-                        VirtualAddressExtension, &FrameCache, &Program->FrameStorage, RxQueueStats);
+                        VirtualAddressExtension, FrameCache, &Program->FrameStorage, RxQueueStats);
+                break;
+
+            case XDP_PROGRAM_ACTION_RATE_LIMIT:
+                if (!XdpRateLimitConform(Program->RateLimiters[RuleIndex])) {
+                    Action = XDP_RX_ACTION_DROP;
+                    STAT_INC(RxQueueStats, InspectFramesRateLimitExceeded);
+                    STAT_INC(RxQueueStats, InspectFramesDropped);
+                    break;
+                }
+
+                STAT_INC(RxQueueStats, InspectFramesRateLimitConformed);
+
+                if (Rule->RateLimit.ConformAction == XDP_PROGRAM_ACTION_L2FWD) {
+                    Action =
+                        XdpL2Fwd(
+                            Frame, FragmentRing, FragmentExtension, FragmentIndex,
+                            VirtualAddressExtension, FrameCache, &Program->FrameStorage,
+                            RxQueueStats);
+                } else {
+                    ASSERT(Rule->RateLimit.ConformAction == XDP_PROGRAM_ACTION_PASS);
+                    Action = XDP_RX_ACTION_PASS;
+                    STAT_INC(RxQueueStats, InspectFramesPassed);
+                }
                 break;
 
             default:
@@ -1476,59 +2237,205 @@ Done:
     return Action;
 }
 
-//
-// Control path routines.
-//
-
-VOID
-XdpProgramDeleteRule(
-    _Inout_ XDP_RULE *Rule
+_IRQL_requires_max_(DISPATCH_LEVEL)
+XDP_RX_ACTION
+XdpInspect(
+    _In_ XDP_PROGRAM *Program,
+    _In_ XDP_INSPECTION_CONTEXT *InspectionContext,
+    _In_ XDP_RING *FrameRing,
+    _In_ UINT32 FrameIndex,
+    _In_opt_ XDP_RING *FragmentRing,
+    _In_opt_ XDP_EXTENSION *FragmentExtension,
+    _In_ UINT32 FragmentIndex,
+    _In_ XDP_EXTENSION *VirtualAddressExtension
     )
 {
-    if (Rule->Match == XDP_MATCH_IPV4_UDP_PORT_SET ||
-        Rule->Match == XDP_MATCH_IPV6_UDP_PORT_SET ||
-        Rule->Match == XDP_MATCH_IPV4_TCP_PORT_SET ||
-        Rule->Match == XDP_MATCH_IPV6_TCP_PORT_SET) {
-        XdpProgramReleasePortSet(&Rule->Pattern.IpPortSet.PortSet);
-    }
+    XDP_PROGRAM_FRAME_CACHE FrameCache;
 
-    if (Rule->Match == XDP_MATCH_UDP_PORT_SET) {
-        XdpProgramReleasePortSet(&Rule->Pattern.PortSet);
-    }
+    XdpInitializeFrameCache(&FrameCache);
+    FrameCache.SnapshotHeaders = InspectionContext->SnapshotHeaders;
 
-    if (Rule->Action == XDP_PROGRAM_ACTION_REDIRECT) {
-        switch (Rule->Redirect.TargetType) {
-        case XDP_REDIRECT_TARGET_TYPE_XSK:
-            if (Rule->Redirect.Target != NULL) {
-                XskDereferenceDatapathHandle(Rule->Redirect.Target);
-                Rule->Redirect.Target = NULL;
-            }
-            break;
-        case XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_QUEUEID:
-            if (Rule->Redirect.Target != NULL) {
-                ASSERT(
-                    XdpMapGetType(Rule->Redirect.Target) == XDP_MAP_TYPE_XSKMAP);
-                XdpMapDereferenceDatapathHandle(Rule->Redirect.Target);
-                Rule->Redirect.Target = NULL;
-            }
-            break;
-        default:
-            ASSERT(Rule->Redirect.Target == NULL);
-            break;
-        }
-    }
+    return
+        XdpInspectFrame(
+            Program, InspectionContext, FrameRing, FrameIndex, FragmentRing, FragmentExtension,
+            FragmentIndex, VirtualAddressExtension, &FrameCache);
 }
 
-NTSTATUS
-XdpProgramValidateQuicFlow(
-    _Out_ XDP_QUIC_FLOW *ValidatedFlow,
-    _In_ const XDP_QUIC_FLOW *UserFlow
+static
+FORCEINLINE
+VOID
+XdpPrefetchHeaders(
+    _In_ XDP_FRAME *Frame,
+    _In_ XDP_EXTENSION *VirtualAddressExtension
     )
 {
-    NTSTATUS Status;
-    UINT32 TotalSize;
+    XDP_BUFFER *Buffer = &Frame->Buffer;
+    UCHAR *Va = XdpGetVirtualAddressExtension(Buffer, VirtualAddressExtension)->VirtualAddress;
+    UINT32 Length = min(Buffer->DataLength, XDP_INSPECT_PREFETCH_LENGTH);
 
-    RtlZeroMemory(ValidatedFlow, sizeof(*ValidatedFlow));
+    //
+    // Prefetch every cache line spanned by the Ethernet, IP and transport
+    // headers in the first buffer.
+    //
+    Va += Buffer->DataOffset;
+
+    for (UINT32 Offset = 0; Offset < Length; Offset += SYSTEM_CACHE_ALIGNMENT_SIZE) {
+        PreFetchCacheLine(PF_TEMPORAL_LEVEL_1, Va + Offset);
+    }
+
+    if (Length > 0) {
+        PreFetchCacheLine(PF_TEMPORAL_LEVEL_1, Va + Length - 1);
+    }
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+XdpInspectBatch(
+    _In_ XDP_PROGRAM *Program,
+    _In_ XDP_INSPECTION_CONTEXT *InspectionContext,
+    _In_ XDP_RING *FrameRing,
+    _In_ UINT32 FrameIndex,
+    _In_range_(1, XDP_INSPECT_BATCH_SIZE) UINT32 FrameCount,
+    _In_opt_ XDP_RING *FragmentRing,
+    _In_opt_ XDP_EXTENSION *FragmentExtension,
+    _In_ UINT32 FragmentIndex,
+    _In_ XDP_EXTENSION *VirtualAddressExtension,
+    _Out_writes_(FrameCount) XDP_RX_ACTION *Actions
+    )
+{
+    UINT32 FragmentIndexes[XDP_INSPECT_BATCH_SIZE];
+    UINT32 Index;
+
+    ASSERT(FrameCount > 0 && FrameCount <= XDP_INSPECT_BATCH_SIZE);
+    ASSERT(FrameIndex <= FrameRing->Mask);
+    ASSERT(
+        (FragmentRing == NULL && FragmentIndex == 0) ||
+        (FragmentRing && FragmentIndex <= FragmentRing->Mask));
+
+    //
+    // Issue prefetches for the headers of every frame in the batch, so the
+    // cache misses overlap rather than stalling rule evaluation one frame at
+    // a time.
+    //
+    for (UINT32 i = 0; i < FrameCount; i++) {
+        XDP_FRAME *Frame = XdpRingGetElement(FrameRing, (FrameIndex + i) & FrameRing->Mask);
+
+        XdpPrefetchHeaders(Frame, VirtualAddressExtension);
+    }
+
+    //
+    // Parse the headers of each frame. Frames with discontiguous headers are
+    // left unparsed and are parsed on demand during rule evaluation.
+    //
+    Index = FragmentIndex;
+    for (UINT32 i = 0; i < FrameCount; i++) {
+        XDP_FRAME *Frame = XdpRingGetElement(FrameRing, (FrameIndex + i) & FrameRing->Mask);
+        XDP_PROGRAM_FRAME_CACHE *FrameCache = &Program->FrameCaches[i];
+
+        XdpInitializeFrameCache(FrameCache);
+        FrameCache->SnapshotHeaders = InspectionContext->SnapshotHeaders;
+        XdpParseFrame(
+            Frame, FragmentRing, FragmentExtension, Index, VirtualAddressExtension,
+            FrameCache, NULL);
+
+        FragmentIndexes[i] = Index;
+
+        if (FragmentRing != NULL) {
+            XDP_FRAME_FRAGMENT *Fragment = XdpGetFragmentExtension(Frame, FragmentExtension);
+            Index = (Index + Fragment->FragmentBufferCount) & FragmentRing->Mask;
+        }
+    }
+
+    for (UINT32 i = 0; i < FrameCount; i++) {
+        Actions[i] =
+            XdpInspectFrame(
+                Program, InspectionContext, FrameRing, (FrameIndex + i) & FrameRing->Mask,
+                FragmentRing, FragmentExtension, FragmentIndexes[i], VirtualAddressExtension,
+                &Program->FrameCaches[i]);
+    }
+}
+
+//
+// Control path routines.
+//
+
+VOID
+XdpProgramDeleteRule(
+    _Inout_ XDP_RULE *Rule
+    )
+{
+    if (Rule->Match == XDP_MATCH_IPV4_UDP_PORT_SET ||
+        Rule->Match == XDP_MATCH_IPV6_UDP_PORT_SET ||
+        Rule->Match == XDP_MATCH_IPV4_TCP_PORT_SET ||
+        Rule->Match == XDP_MATCH_IPV6_TCP_PORT_SET) {
+        XdpProgramReleasePortSet(&Rule->Pattern.IpPortSet.PortSet);
+    }
+
+    if (Rule->Match == XDP_MATCH_UDP_PORT_SET) {
+        XdpProgramReleasePortSet(&Rule->Pattern.PortSet);
+    }
+
+    if (Rule->Action == XDP_PROGRAM_ACTION_REDIRECT) {
+        switch (Rule->Redirect.TargetType) {
+        case XDP_REDIRECT_TARGET_TYPE_XSK:
+            if (Rule->Redirect.Target != NULL) {
+                XskDereferenceDatapathHandle(Rule->Redirect.Target);
+                Rule->Redirect.Target = NULL;
+            }
+            break;
+        case XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_QUEUEID:
+        case XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_FLOW_HASH:
+            if (Rule->Redirect.Target != NULL) {
+                ASSERT(
+                    XdpMapGetType(Rule->Redirect.Target) == XDP_MAP_TYPE_XSKMAP);
+                XdpMapDereferenceDatapathHandle(Rule->Redirect.Target);
+                Rule->Redirect.Target = NULL;
+            }
+            break;
+        case XDP_REDIRECT_TARGET_TYPE_QUIC_CID_MAP:
+            if (Rule->Redirect.Target != NULL) {
+                ASSERT(
+                    XdpMapGetType(Rule->Redirect.Target) == XDP_MAP_TYPE_QUIC_CID);
+                XdpMapDereferenceDatapathHandle(Rule->Redirect.Target);
+                Rule->Redirect.Target = NULL;
+            }
+            break;
+        case XDP_REDIRECT_TARGET_TYPE_HASH_MAP_BY_FLOW:
+        case XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_SRC_ADDR:
+        case XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_DST_ADDR:
+            if (Rule->Redirect.Target != NULL) {
+                XdpMapDereferenceDatapathHandle(Rule->Redirect.Target);
+                Rule->Redirect.Target = NULL;
+            }
+            break;
+        case XDP_REDIRECT_TARGET_TYPE_INTERFACE_TX:
+            if (Rule->Redirect.Target != NULL) {
+                XdpTxRedirectDereference(Rule->Redirect.Target);
+                Rule->Redirect.Target = NULL;
+            }
+            break;
+        default:
+            ASSERT(Rule->Redirect.Target == NULL);
+            break;
+        }
+    }
+
+    if (Rule->Action == XDP_PROGRAM_ACTION_EBPF && Rule->Ebpf.XskMap != NULL) {
+        XdpMapDereferenceDatapathHandle(Rule->Ebpf.XskMap);
+        Rule->Ebpf.XskMap = NULL;
+    }
+}
+
+NTSTATUS
+XdpProgramValidateQuicFlow(
+    _Out_ XDP_QUIC_FLOW *ValidatedFlow,
+    _In_ const XDP_QUIC_FLOW *UserFlow
+    )
+{
+    NTSTATUS Status;
+    UINT32 TotalSize;
+
+    RtlZeroMemory(ValidatedFlow, sizeof(*ValidatedFlow));
 
     Status = RtlUInt32Add(UserFlow->CidOffset, UserFlow->CidLength, &TotalSize);
     if (!NT_SUCCESS(Status)) {
@@ -1566,7 +2473,7 @@ XdpProgramValidateRule(
     //
     RtlZeroMemory(ValidatedRule, sizeof(*ValidatedRule));
 
-    if (UserRule->Match < XDP_MATCH_ALL || UserRule->Match > XDP_MATCH_ICMPV6_ECHO_REPLY_IP_DST) {
+    if (UserRule->Match < XDP_MATCH_ALL || UserRule->Match > XDP_MATCH_QUIC_FLOW_DST_CID_MAP) {
         Status = STATUS_INVALID_PARAMETER;
         goto Exit;
     }
@@ -1582,6 +2489,8 @@ XdpProgramValidateRule(
     case XDP_MATCH_QUIC_FLOW_DST_CID:
     case XDP_MATCH_TCP_QUIC_FLOW_SRC_CID:
     case XDP_MATCH_TCP_QUIC_FLOW_DST_CID:
+    case XDP_MATCH_QUIC_FLOW_SRC_CID_MAP:
+    case XDP_MATCH_QUIC_FLOW_DST_CID_MAP:
         Status =
             XdpProgramValidateQuicFlow(
                 &ValidatedRule->Pattern.QuicFlow, &UserRule->Pattern.QuicFlow);
@@ -1616,7 +2525,7 @@ XdpProgramValidateRule(
     }
 
     if (UserRule->Action < XDP_PROGRAM_ACTION_DROP ||
-        UserRule->Action > XDP_PROGRAM_ACTION_EBPF) {
+        UserRule->Action > XDP_PROGRAM_ACTION_RATE_LIMIT) {
         Status = STATUS_INVALID_PARAMETER;
         goto Exit;
     }
@@ -1662,6 +2571,94 @@ XdpProgramValidateRule(
             break;
         }
 
+        case XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_FLOW_HASH:
+        {
+            XDP_MAP *Map;
+
+            if (UserRule->Redirect.FlowHashWidth == 0 ||
+                UserRule->Redirect.FlowHashWidth > XDP_REDIRECT_MAX_FLOW_HASH_WIDTH) {
+                Status = STATUS_INVALID_PARAMETER;
+                break;
+            }
+
+            Status =
+                XdpMapReferenceDatapathHandle(
+                    RequestorMode, &UserRule->Redirect.Target, TRUE, &Map);
+            if (!NT_SUCCESS(Status)) {
+                break;
+            }
+            if (XdpMapGetType(Map) != XDP_MAP_TYPE_XSKMAP) {
+                XdpMapDereferenceDatapathHandle(Map);
+                Status = STATUS_INVALID_PARAMETER;
+                break;
+            }
+            ValidatedRule->Redirect.FlowHashWidth = UserRule->Redirect.FlowHashWidth;
+            ValidatedRule->Redirect.Target = Map;
+            break;
+        }
+
+        case XDP_REDIRECT_TARGET_TYPE_QUIC_CID_MAP:
+        {
+            XDP_MAP *Map;
+
+            Status =
+                XdpMapReferenceDatapathHandle(
+                    RequestorMode, &UserRule->Redirect.Target, TRUE, &Map);
+            if (!NT_SUCCESS(Status)) {
+                break;
+            }
+            if (XdpMapGetType(Map) != XDP_MAP_TYPE_QUIC_CID) {
+                XdpMapDereferenceDatapathHandle(Map);
+                Status = STATUS_INVALID_PARAMETER;
+                break;
+            }
+            ValidatedRule->Redirect.Target = Map;
+            break;
+        }
+
+        case XDP_REDIRECT_TARGET_TYPE_HASH_MAP_BY_FLOW:
+        case XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_SRC_ADDR:
+        case XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_DST_ADDR:
+        {
+            XDP_MAP *Map;
+            XDP_MAP_TYPE MapType =
+                (UserRule->Redirect.TargetType == XDP_REDIRECT_TARGET_TYPE_HASH_MAP_BY_FLOW) ?
+                    XDP_MAP_TYPE_HASH : XDP_MAP_TYPE_LPM;
+
+            Status =
+                XdpMapReferenceDatapathHandle(
+                    RequestorMode, &UserRule->Redirect.Target, TRUE, &Map);
+            if (!NT_SUCCESS(Status)) {
+                break;
+            }
+            if (XdpMapGetType(Map) != MapType) {
+                XdpMapDereferenceDatapathHandle(Map);
+                Status = STATUS_INVALID_PARAMETER;
+                break;
+            }
+            ValidatedRule->Redirect.Target = Map;
+            break;
+        }
+
+        case XDP_REDIRECT_TARGET_TYPE_INTERFACE_TX:
+        {
+            XDP_TX_REDIRECT *TxRedirect;
+
+            //
+            // The TX queue is identified by interface index and queue ID, which
+            // share storage with the target handle; the kernel replaces them
+            // with its own redirect target.
+            //
+            Status =
+                XdpTxRedirectCreate(
+                    UserRule->Redirect.IfIndex, UserRule->Redirect.QueueId, &TxRedirect);
+            if (!NT_SUCCESS(Status)) {
+                break;
+            }
+            ValidatedRule->Redirect.Target = TxRedirect;
+            break;
+        }
+
         default:
             Status = STATUS_INVALID_PARAMETER;
             break;
@@ -1691,9 +2688,50 @@ XdpProgramValidateRule(
         ASSERT(RuleIndex == 0);
         ValidatedRule->Ebpf.Target = UserRule->Ebpf.Target;
 
+        //
+        // The XSKMAP is referenced by the eBPF attach routine in the context
+        // of the attaching thread.
+        //
+        if (UserRule->Ebpf.XskMap != NULL) {
+            ASSERT(XdpMapGetType(UserRule->Ebpf.XskMap) == XDP_MAP_TYPE_XSKMAP);
+            XdpMapReference(UserRule->Ebpf.XskMap);
+            ValidatedRule->Ebpf.XskMap = UserRule->Ebpf.XskMap;
+        }
+
+        break;
+
+    case XDP_PROGRAM_ACTION_RATE_LIMIT:
+        //
+        // The token bucket state is allocated by the program object, not the
+        // rule itself.
+        //
+        if (UserRule->RateLimit.FramesPerSecond == 0 ||
+            UserRule->RateLimit.BurstSize == 0 ||
+            (UserRule->RateLimit.ConformAction != XDP_PROGRAM_ACTION_PASS &&
+                UserRule->RateLimit.ConformAction != XDP_PROGRAM_ACTION_L2FWD)) {
+            Status = STATUS_INVALID_PARAMETER;
+            goto Exit;
+        }
+
+        ValidatedRule->RateLimit.FramesPerSecond = UserRule->RateLimit.FramesPerSecond;
+        ValidatedRule->RateLimit.BurstSize = UserRule->RateLimit.BurstSize;
+        ValidatedRule->RateLimit.ConformAction = UserRule->RateLimit.ConformAction;
         break;
     }
 
+    //
+    // The QUIC CID map match types look up the redirect target while matching
+    // the frame, so they are valid only with the QUIC CID map target type,
+    // and vice versa.
+    //
+    if ((ValidatedRule->Match == XDP_MATCH_QUIC_FLOW_SRC_CID_MAP ||
+         ValidatedRule->Match == XDP_MATCH_QUIC_FLOW_DST_CID_MAP) !=
+        (ValidatedRule->Action == XDP_PROGRAM_ACTION_REDIRECT &&
+         ValidatedRule->Redirect.TargetType == XDP_REDIRECT_TARGET_TYPE_QUIC_CID_MAP)) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto Exit;
+    }
+
     Status = STATUS_SUCCESS;
 
 Exit:
@@ -1704,3 +2742,462 @@ Exit:
 
     return Status;
 }
+
+static
+BOOLEAN
+XdpClassifierGetPrefixLength(
+    _In_reads_bytes_(MaskLength) const UINT8 *Mask,
+    _In_ UINT32 MaskLength,
+    _Out_ UINT8 *PrefixLength
+    )
+{
+    UINT32 Length = 0;
+
+    while (Length < MaskLength * 8 && XdpClassifierGetBit(Mask, Length)) {
+        Length++;
+    }
+
+    //
+    // Only contiguous masks can be represented as a prefix.
+    //
+    for (UINT32 i = Length; i < MaskLength * 8; i++) {
+        if (XdpClassifierGetBit(Mask, i)) {
+            return FALSE;
+        }
+    }
+
+    *PrefixLength = (UINT8)Length;
+    return TRUE;
+}
+
+static
+BOOLEAN
+XdpClassifierIsRuleIndexable(
+    _In_ const XDP_RULE *Rule
+    )
+{
+    UINT8 PrefixLength;
+
+    switch (Rule->Match) {
+    case XDP_MATCH_UDP_DST:
+    case XDP_MATCH_TCP_DST:
+    case XDP_MATCH_IPV4_UDP_TUPLE:
+    case XDP_MATCH_IPV6_UDP_TUPLE:
+    case XDP_MATCH_QUIC_FLOW_SRC_CID:
+    case XDP_MATCH_QUIC_FLOW_DST_CID:
+    case XDP_MATCH_TCP_QUIC_FLOW_SRC_CID:
+    case XDP_MATCH_TCP_QUIC_FLOW_DST_CID:
+        return TRUE;
+
+    case XDP_MATCH_IPV4_DST_MASK:
+        return
+            XdpClassifierGetPrefixLength(
+                (const UINT8 *)&Rule->Pattern.IpMask.Mask.Ipv4, sizeof(IN_ADDR), &PrefixLength);
+
+    case XDP_MATCH_IPV6_DST_MASK:
+        return
+            XdpClassifierGetPrefixLength(
+                (const UINT8 *)&Rule->Pattern.IpMask.Mask.Ipv6, sizeof(IN6_ADDR), &PrefixLength);
+
+    default:
+        return FALSE;
+    }
+}
+
+static
+BOOLEAN
+XdpClassifierIsRuleCompatible(
+    _In_ const XDP_RULE *FirstRule,
+    _In_ const XDP_RULE *Rule
+    )
+{
+    if (Rule->Match != FirstRule->Match || !XdpClassifierIsRuleIndexable(Rule)) {
+        return FALSE;
+    }
+
+    switch (Rule->Match) {
+    case XDP_MATCH_QUIC_FLOW_SRC_CID:
+    case XDP_MATCH_QUIC_FLOW_DST_CID:
+    case XDP_MATCH_TCP_QUIC_FLOW_SRC_CID:
+    case XDP_MATCH_TCP_QUIC_FLOW_DST_CID:
+        //
+        // The CID key is extracted once per segment, so every flow must use the
+        // same port and CID slice.
+        //
+        return
+            Rule->Pattern.QuicFlow.UdpPort == FirstRule->Pattern.QuicFlow.UdpPort &&
+            Rule->Pattern.QuicFlow.CidOffset == FirstRule->Pattern.QuicFlow.CidOffset &&
+            Rule->Pattern.QuicFlow.CidLength == FirstRule->Pattern.QuicFlow.CidLength;
+
+    default:
+        return TRUE;
+    }
+}
+
+static
+UINT32
+XdpClassifierHashRule(
+    _In_ const XDP_RULE *Rule
+    )
+{
+    const XDP_TUPLE *Tuple = &Rule->Pattern.Tuple;
+    const XDP_QUIC_FLOW *Flow = &Rule->Pattern.QuicFlow;
+
+    switch (Rule->Match) {
+    case XDP_MATCH_UDP_DST:
+    case XDP_MATCH_TCP_DST:
+        return
+            XdpClassifierHash(
+                XDP_CLASSIFIER_HASH_BASIS, &Rule->Pattern.Port, sizeof(Rule->Pattern.Port));
+
+    case XDP_MATCH_IPV4_UDP_TUPLE:
+        return
+            XdpClassifierHashTuple(
+                &Tuple->SourceAddress.Ipv4, &Tuple->DestinationAddress.Ipv4, sizeof(IN_ADDR),
+                Tuple->SourcePort, Tuple->DestinationPort);
+
+    case XDP_MATCH_IPV6_UDP_TUPLE:
+        return
+            XdpClassifierHashTuple(
+                &Tuple->SourceAddress.Ipv6, &Tuple->DestinationAddress.Ipv6, sizeof(IN6_ADDR),
+                Tuple->SourcePort, Tuple->DestinationPort);
+
+    case XDP_MATCH_QUIC_FLOW_SRC_CID:
+    case XDP_MATCH_QUIC_FLOW_DST_CID:
+    case XDP_MATCH_TCP_QUIC_FLOW_SRC_CID:
+    case XDP_MATCH_TCP_QUIC_FLOW_DST_CID:
+        return XdpClassifierHash(XDP_CLASSIFIER_HASH_BASIS, Flow->CidData, Flow->CidLength);
+
+    default:
+        ASSERT(FALSE);
+        return 0;
+    }
+}
+
+static
+VOID
+XdpClassifierBuildHash(
+    _In_ const XDP_PROGRAM *Program,
+    _Inout_ XDP_PROGRAM_CLASSIFIER *Classifier,
+    _Inout_ XDP_PROGRAM_CLASSIFIER_SEGMENT *Segment,
+    _Inout_ UINT32 *SlotsUsed
+    )
+{
+    UINT32 SlotCount = 1;
+
+    //
+    // Keep the load factor at or below one half.
+    //
+    while (SlotCount < (Segment->RuleEnd - Segment->RuleStart) * 2) {
+        SlotCount <<= 1;
+    }
+
+    ASSERT(*SlotsUsed + SlotCount <= Classifier->SlotCapacity);
+    Segment->Hash.Slots = &Classifier->Slots[*SlotsUsed];
+    Segment->Hash.SlotMask = SlotCount - 1;
+    *SlotsUsed += SlotCount;
+
+    for (UINT32 i = 0; i < SlotCount; i++) {
+        Segment->Hash.Slots[i] = XDP_PROGRAM_CLASSIFIER_NONE;
+    }
+
+    for (UINT32 RuleIndex = Segment->RuleStart; RuleIndex < Segment->RuleEnd; RuleIndex++) {
+        UINT32 Slot = XdpClassifierHashRule(&Program->Rules[RuleIndex]) & Segment->Hash.SlotMask;
+
+        while (Segment->Hash.Slots[Slot] != XDP_PROGRAM_CLASSIFIER_NONE) {
+            Slot = (Slot + 1) & Segment->Hash.SlotMask;
+        }
+
+        Segment->Hash.Slots[Slot] = RuleIndex;
+    }
+}
+
+static
+UINT32
+XdpClassifierAllocateNode(
+    _Inout_ XDP_PROGRAM_CLASSIFIER *Classifier,
+    _Inout_ XDP_PROGRAM_CLASSIFIER_SEGMENT *Segment,
+    _Inout_ UINT32 *NodesUsed,
+    _In_ const UINT8 *Prefix,
+    _In_ UINT8 PrefixLength,
+    _In_ UINT32 RuleIndex
+    )
+{
+    UINT32 NodeIndex = (UINT32)(&Classifier->Nodes[*NodesUsed] - Segment->Trie.Nodes);
+    XDP_PROGRAM_CLASSIFIER_NODE *Node = &Classifier->Nodes[*NodesUsed];
+
+    ASSERT(*NodesUsed < Classifier->NodeCapacity);
+    *NodesUsed += 1;
+
+    RtlZeroMemory(Node, sizeof(*Node));
+    Node->Child[0] = XDP_PROGRAM_CLASSIFIER_NONE;
+    Node->Child[1] = XDP_PROGRAM_CLASSIFIER_NONE;
+    Node->RuleIndex = RuleIndex;
+    Node->PrefixLength = PrefixLength;
+
+    RtlCopyMemory(Node->Prefix, Prefix, PrefixLength / 8);
+    if (PrefixLength % 8 != 0) {
+        Node->Prefix[PrefixLength / 8] =
+            Prefix[PrefixLength / 8] & (UINT8)(0xFF << (8 - PrefixLength % 8));
+    }
+
+    return NodeIndex;
+}
+
+static
+VOID
+XdpClassifierTrieInsert(
+    _Inout_ XDP_PROGRAM_CLASSIFIER *Classifier,
+    _Inout_ XDP_PROGRAM_CLASSIFIER_SEGMENT *Segment,
+    _Inout_ UINT32 *NodesUsed,
+    _In_ const UINT8 *Prefix,
+    _In_ UINT8 PrefixLength,
+    _In_ UINT32 RuleIndex
+    )
+{
+    UINT32 *Link = &Segment->Trie.Root;
+
+    //
+    // Insert into a path-compressed binary trie. Each insertion adds at most
+    // one leaf and one branch node.
+    //
+    for (;;) {
+        XDP_PROGRAM_CLASSIFIER_NODE *Node;
+        UINT32 NewIndex;
+        UINT8 Common = 0;
+
+        if (*Link == XDP_PROGRAM_CLASSIFIER_NONE) {
+            *Link =
+                XdpClassifierAllocateNode(
+                    Classifier, Segment, NodesUsed, Prefix, PrefixLength, RuleIndex);
+            return;
+        }
+
+        Node = &Segment->Trie.Nodes[*Link];
+
+        while (Common < min(PrefixLength, Node->PrefixLength) &&
+            XdpClassifierGetBit(Prefix, Common) == XdpClassifierGetBit(Node->Prefix, Common)) {
+            Common++;
+        }
+
+        if (Common == Node->PrefixLength) {
+            if (Common == PrefixLength) {
+                //
+                // Rules are inserted in order, so an existing rule with the same
+                // prefix takes precedence.
+                //
+                if (Node->RuleIndex == XDP_PROGRAM_CLASSIFIER_NONE) {
+                    Node->RuleIndex = RuleIndex;
+                }
+                return;
+            }
+
+            Link = &Node->Child[XdpClassifierGetBit(Prefix, Common)];
+            continue;
+        }
+
+        //
+        // The new prefix either covers the existing node or diverges from it;
+        // splice in a node at the common prefix.
+        //
+        NewIndex =
+            XdpClassifierAllocateNode(
+                Classifier, Segment, NodesUsed, Prefix, Common,
+                (Common == PrefixLength) ? RuleIndex : XDP_PROGRAM_CLASSIFIER_NONE);
+        Segment->Trie.Nodes[NewIndex].Child[XdpClassifierGetBit(Node->Prefix, Common)] = *Link;
+
+        if (Common != PrefixLength) {
+            UINT32 LeafIndex =
+                XdpClassifierAllocateNode(
+                    Classifier, Segment, NodesUsed, Prefix, PrefixLength, RuleIndex);
+            Segment->Trie.Nodes[NewIndex].Child[XdpClassifierGetBit(Prefix, Common)] = LeafIndex;
+        }
+
+        *Link = NewIndex;
+        return;
+    }
+}
+
+static
+VOID
+XdpClassifierBuildTrie(
+    _In_ const XDP_PROGRAM *Program,
+    _Inout_ XDP_PROGRAM_CLASSIFIER *Classifier,
+    _Inout_ XDP_PROGRAM_CLASSIFIER_SEGMENT *Segment,
+    _Inout_ UINT32 *NodesUsed
+    )
+{
+    UINT32 AddressLength =
+        (Segment->Match == XDP_MATCH_IPV4_DST_MASK) ? sizeof(IN_ADDR) : sizeof(IN6_ADDR);
+
+    Segment->Trie.Nodes = &Classifier->Nodes[*NodesUsed];
+    Segment->Trie.Root = XDP_PROGRAM_CLASSIFIER_NONE;
+
+    for (UINT32 RuleIndex = Segment->RuleStart; RuleIndex < Segment->RuleEnd; RuleIndex++) {
+        const XDP_IP_ADDRESS_MASK *IpMask = &Program->Rules[RuleIndex].Pattern.IpMask;
+        const UINT8 *Address = (const UINT8 *)&IpMask->Address;
+        const UINT8 *Mask = (const UINT8 *)&IpMask->Mask;
+        UINT8 PrefixLength;
+        BOOLEAN Canonical = TRUE;
+
+        if (!XdpClassifierGetPrefixLength(Mask, AddressLength, &PrefixLength)) {
+            ASSERT(FALSE);
+            continue;
+        }
+
+        //
+        // A rule with address bits outside its mask can never match.
+        //
+        for (UINT32 i = 0; i < AddressLength; i++) {
+            if ((Address[i] & Mask[i]) != Address[i]) {
+                Canonical = FALSE;
+                break;
+            }
+        }
+
+        if (Canonical) {
+            XdpClassifierTrieInsert(
+                Classifier, Segment, NodesUsed, Address, PrefixLength, RuleIndex);
+        }
+    }
+}
+
+NTSTATUS
+XdpProgramGetClassifierSize(
+    _In_ UINT32 RuleCount,
+    _Out_ SIZE_T *ClassifierSize
+    )
+{
+    NTSTATUS Status;
+    SIZE_T Size;
+    SIZE_T ElementsSize;
+
+    if (RuleCount > MAXUINT32 / 4) {
+        Status = STATUS_INTEGER_OVERFLOW;
+        goto Exit;
+    }
+
+    //
+    // Reserve enough storage for the worst case of any program with up to
+    // RuleCount rules: every segment contains at least the minimum number of
+    // rules, hash tables use fewer than four slots per rule, and tries use at
+    // most two nodes per rule.
+    //
+    Size = sizeof(XDP_PROGRAM_CLASSIFIER);
+
+    Status =
+        RtlSizeTMult(
+            sizeof(XDP_PROGRAM_CLASSIFIER_SEGMENT), RuleCount / XDP_PROGRAM_CLASSIFIER_MIN_RULES,
+            &ElementsSize);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    Status = RtlSizeTAdd(Size, ElementsSize, &Size);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    Status = RtlSizeTMult(sizeof(XDP_PROGRAM_CLASSIFIER_NODE) * 2, RuleCount, &ElementsSize);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    Status = RtlSizeTAdd(Size, ElementsSize, &Size);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    Status = RtlSizeTMult(sizeof(UINT32) * 4, RuleCount, &ElementsSize);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    Status = RtlSizeTAdd(Size, ElementsSize, &Size);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    *ClassifierSize = Size;
+
+Exit:
+
+    return Status;
+}
+
+VOID
+XdpProgramInitializeClassifier(
+    _Out_ XDP_PROGRAM_CLASSIFIER *Classifier,
+    _In_ UINT32 RuleCount
+    )
+{
+    //
+    // The caller must have sized the storage with XdpProgramGetClassifierSize.
+    //
+    RtlZeroMemory(Classifier, sizeof(*Classifier));
+    Classifier->SegmentCapacity = RuleCount / XDP_PROGRAM_CLASSIFIER_MIN_RULES;
+    Classifier->NodeCapacity = RuleCount * 2;
+    Classifier->SlotCapacity = RuleCount * 4;
+    Classifier->Segments = (XDP_PROGRAM_CLASSIFIER_SEGMENT *)(Classifier + 1);
+    Classifier->Nodes =
+        (XDP_PROGRAM_CLASSIFIER_NODE *)(Classifier->Segments + Classifier->SegmentCapacity);
+    Classifier->Slots = (UINT32 *)(Classifier->Nodes + Classifier->NodeCapacity);
+}
+
+VOID
+XdpProgramCompileClassifier(
+    _Inout_ XDP_PROGRAM *Program
+    )
+{
+    XDP_PROGRAM_CLASSIFIER *Classifier = Program->Classifier;
+    UINT32 SlotsUsed = 0;
+    UINT32 NodesUsed = 0;
+    UINT32 RuleStart = 0;
+
+    if (Classifier == NULL) {
+        return;
+    }
+
+    Classifier->SegmentCount = 0;
+
+    //
+    // Partition the rules into maximal runs of consecutive, compatible rules.
+    // Runs long enough to benefit from an index become segments; all other
+    // rules are evaluated linearly.
+    //
+    while (RuleStart < Program->RuleCount) {
+        const XDP_RULE *FirstRule = &Program->Rules[RuleStart];
+        UINT32 RuleEnd = RuleStart + 1;
+        XDP_PROGRAM_CLASSIFIER_SEGMENT *Segment;
+
+        if (!XdpClassifierIsRuleIndexable(FirstRule)) {
+            RuleStart = RuleEnd;
+            continue;
+        }
+
+        while (RuleEnd < Program->RuleCount &&
+            XdpClassifierIsRuleCompatible(FirstRule, &Program->Rules[RuleEnd])) {
+            RuleEnd++;
+        }
+
+        if (RuleEnd - RuleStart < XDP_PROGRAM_CLASSIFIER_MIN_RULES) {
+            RuleStart = RuleEnd;
+            continue;
+        }
+
+        ASSERT(Classifier->SegmentCount < Classifier->SegmentCapacity);
+        Segment = &Classifier->Segments[Classifier->SegmentCount++];
+        Segment->Match = FirstRule->Match;
+        Segment->RuleStart = RuleStart;
+        Segment->RuleEnd = RuleEnd;
+
+        if (Segment->Match == XDP_MATCH_IPV4_DST_MASK ||
+            Segment->Match == XDP_MATCH_IPV6_DST_MASK) {
+            XdpClassifierBuildTrie(Program, Classifier, Segment, &NodesUsed);
+        } else {
+            XdpClassifierBuildHash(Program, Classifier, Segment, &SlotsUsed);
+        }
+
+        RuleStart = RuleEnd;
+    }
+}
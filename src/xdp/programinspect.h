@@ -56,6 +56,10 @@ typedef struct _XDP_PROGRAM_FRAME_STORAGE {
         sizeof(QUIC_HEADER_INVARIANT) +
         sizeof(UCHAR) +
         XDP_QUIC_MAX_CID_LENGTH * 2];
+    // Copy of the leading bytes of the first buffer, up to the largest headers
+    // parsed in a single pass.
+    UINT8 HeaderSnapshot[
+        sizeof(ETHERNET_HEADER) + sizeof(IPV6_HEADER) + sizeof(TCP_HDR) + 40];
 } XDP_PROGRAM_FRAME_STORAGE;
 
 typedef struct _XDP_PROGRAM_PAYLOAD_CACHE {
@@ -116,11 +120,90 @@ typedef struct _XDP_PROGRAM_FRAME_CACHE {
     const UINT8 *QuicCid; // Src CID for long header, Dest CID for short header
     XDP_PROGRAM_PAYLOAD_CACHE TransportPayload;
     XDP_PROGRAM_PAYLOAD_CACHE IpPayload;
+    BOOLEAN SnapshotHeaders;
 } XDP_PROGRAM_FRAME_CACHE;
 
+//
+// The compiled classifier indexes runs of consecutive rules sharing a match
+// type that can be looked up by key rather than evaluated one by one. Each
+// lookup yields the lowest-indexed rule in the run that can match the frame,
+// so first-match semantics across the whole program are preserved.
+//
+#define XDP_PROGRAM_CLASSIFIER_MIN_RULES 4
+#define XDP_PROGRAM_CLASSIFIER_NONE MAXUINT32
+
+typedef struct _XDP_PROGRAM_CLASSIFIER_NODE {
+    UINT32 Child[2];
+    UINT32 RuleIndex;
+    UINT8 PrefixLength;
+    UINT8 Prefix[sizeof(IN6_ADDR)];
+} XDP_PROGRAM_CLASSIFIER_NODE;
+
+typedef struct _XDP_PROGRAM_CLASSIFIER_SEGMENT {
+    XDP_MATCH_TYPE Match;
+    UINT32 RuleStart;
+    UINT32 RuleEnd;
+    union {
+        struct {
+            UINT32 *Slots;
+            UINT32 SlotMask;
+        } Hash;
+        struct {
+            XDP_PROGRAM_CLASSIFIER_NODE *Nodes;
+            UINT32 Root;
+        } Trie;
+    };
+} XDP_PROGRAM_CLASSIFIER_SEGMENT;
+
+typedef struct _XDP_PROGRAM_CLASSIFIER {
+    //
+    // Storage is sized for the rule count at allocation time, which allows
+    // the classifier to be rebuilt in place when the program shrinks.
+    //
+    UINT32 SegmentCapacity;
+    UINT32 SlotCapacity;
+    UINT32 NodeCapacity;
+    UINT32 SegmentCount;
+    XDP_PROGRAM_CLASSIFIER_SEGMENT *Segments;
+    XDP_PROGRAM_CLASSIFIER_NODE *Nodes;
+    UINT32 *Slots;
+} XDP_PROGRAM_CLASSIFIER;
+
 #pragma warning(push)
 #pragma warning(disable:4324) // structure was padded due to alignment specifier
 
+//
+// Rate limit tokens are measured in interrupt time units (100ns) per second.
+//
+#define XDP_RATE_LIMIT_TOKENS_PER_FRAME 10000000ui64
+
+//
+// Token bucket state for a rate limit rule. Each processor owns a bucket, so
+// the data path updates it without synchronization at DISPATCH_LEVEL.
+//
+typedef struct DECLSPEC_CACHEALIGN _XDP_RATE_LIMIT_BUCKET {
+    UINT64 Tokens;
+    UINT64 LastRefillTime;
+    XDP_PCW_RATE_LIMIT_RULE Stats;
+    //
+    // Every bucket of a rule publishes its counters under the same PCW
+    // instance name, and PCW sums them.
+    //
+    PCW_INSTANCE *PcwInstance;
+} XDP_RATE_LIMIT_BUCKET;
+
+typedef struct _XDP_RATE_LIMITER {
+    //
+    // Tokens are scaled by the interrupt time frequency, so each frame costs
+    // one second's worth of ticks and each tick refills FramesPerSecond.
+    //
+    UINT64 Capacity;
+    UINT64 FramesPerSecond;
+    UINT64 MaxRefillInterval;
+    UINT32 BucketCount;
+    XDP_RATE_LIMIT_BUCKET Buckets[0];
+} XDP_RATE_LIMITER;
+
 typedef struct _XDP_PROGRAM {
     //
     // Storage for discontiguous headers.
@@ -128,12 +211,58 @@ typedef struct _XDP_PROGRAM {
     XDP_PROGRAM_FRAME_STORAGE FrameStorage;
 
     //
-    // Set if any rule references an XDP map via a redirect target type. The
-    // data path holds the global map lock for the duration of each batch when
-    // this is set.
+    // Storage for the headers of a batch of frames parsed ahead of rule
+    // evaluation. Only used by XdpInspectBatch.
+    //
+    XDP_PROGRAM_FRAME_CACHE FrameCaches[XDP_INSPECT_BATCH_SIZE];
+
+    //
+    // Set if any rule references an XDP map protected by the global map lock.
+    // The data path holds the global map lock for the duration of each batch
+    // when this is set.
     //
     BOOLEAN HasMap;
 
+    //
+    // Set if any rule references an XSKMAP. XSKMAP lookups are lock-free, but
+    // the data path must remain at DISPATCH_LEVEL for the duration of each
+    // batch so that redirected XSKs cannot be released mid-batch.
+    //
+    BOOLEAN HasXskMap;
+
+    //
+    // Set if any rule has a rate limit action. The data path must remain at
+    // DISPATCH_LEVEL for the duration of each batch so that per-processor
+    // token buckets are updated without interruption.
+    //
+    BOOLEAN HasRateLimit;
+
+    //
+    // Set if any rule matches on frame headers. The data path inspects such
+    // programs with XdpInspectBatch, which parses headers for several frames
+    // before evaluating rules.
+    //
+    BOOLEAN BatchParse;
+
+    //
+    // Optional rule index built when the program is compiled for an RX queue.
+    // If NULL, the rules are evaluated linearly.
+    //
+    XDP_PROGRAM_CLASSIFIER *Classifier;
+
+    //
+    // Optional token bucket state of each rule, indexed like Rules. Entries
+    // are NULL for rules without a rate limit action. The limiters are owned
+    // by the program objects the rules were captured into.
+    //
+    XDP_RATE_LIMITER **RateLimiters;
+
+    //
+    // Toeplitz hash table, derived from a secret key, used to spread flows
+    // across XSKMAP keys.
+    //
+    const XDP_TOEPLITZ_TABLE *FlowHashTable;
+
     DECLSPEC_CACHEALIGN
     UINT32 RuleCount;
     XDP_RULE Rules[0];
@@ -157,6 +286,23 @@ XdpProgramValidateRule(
     _In_ UINT32 RuleIndex
     );
 
+NTSTATUS
+XdpProgramGetClassifierSize(
+    _In_ UINT32 RuleCount,
+    _Out_ SIZE_T *ClassifierSize
+    );
+
+VOID
+XdpProgramInitializeClassifier(
+    _Out_ XDP_PROGRAM_CLASSIFIER *Classifier,
+    _In_ UINT32 RuleCount
+    );
+
+VOID
+XdpProgramCompileClassifier(
+    _Inout_ XDP_PROGRAM *Program
+    );
+
 VOID
 XdpProgramReleasePortSet(
     _Inout_ XDP_PORT_SET *PortSet
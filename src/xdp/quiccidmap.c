@@ -0,0 +1,226 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+//
+// QUIC CID map implementation. Object lifetime, IRP / IOCTL dispatch, and
+// the global map read/write lock are all owned by the common XDP map code in
+// map.c; this file only provides the CID hash table storage and the per-type
+// callbacks that map.c invokes.
+//
+// Entries are inserted and deleted individually, so QUIC connections can be
+// added to or removed from a receive queue without recompiling its program.
+//
+
+#include "precomp.h"
+#include "quiccidmap.h"
+
+//
+// Maximum number of entries in a QUIC CID map.
+//
+#define QUIC_CID_MAP_MAX_SIZE 0x100000
+
+typedef struct _XDP_QUIC_CID_MAP {
+    XDP_MAP Map;
+
+    //
+    // Hash table of XSK redirect actions keyed by CID. Protected by the global
+    // map lock.
+    //
+    XDP_MAP_TABLE Table;
+} XDP_QUIC_CID_MAP;
+
+const SIZE_T XdpQuicCidMapAllocationSize = sizeof(XDP_QUIC_CID_MAP);
+
+static XDP_MAP_INITIALIZE XdpQuicCidMapInitialize;
+static XDP_MAP_CLEANUP XdpQuicCidMapCleanup;
+static XDP_MAP_INSERT XdpQuicCidMapInsert;
+static XDP_MAP_DELETE XdpQuicCidMapDelete;
+
+static
+NTSTATUS
+XdpQuicCidMapCaptureKey(
+    _In_ KPROCESSOR_MODE RequestorMode,
+    _In_ const VOID *Key,
+    _Out_writes_bytes_(XDP_MAP_TABLE_QUIC_CID_KEY_LENGTH) UINT32 *CapturedKey
+    )
+{
+    XDP_QUIC_CID_MAP_KEY KeyValue;
+    NTSTATUS Status;
+
+    Status =
+        XdpMapCaptureFromMode(
+            RequestorMode, Key, sizeof(KeyValue), PROBE_ALIGNMENT(XDP_QUIC_CID_MAP_KEY),
+            &KeyValue);
+    if (!NT_SUCCESS(Status)) {
+        return Status;
+    }
+
+    if (KeyValue.CidLength > RTL_FIELD_SIZE(XDP_QUIC_CID_MAP_KEY, CidData)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    //
+    // The data path builds keys with the CID bytes beyond CidLength cleared.
+    //
+    XdpMapTableInitializeQuicCidKey(CapturedKey, KeyValue.CidData, KeyValue.CidLength);
+
+    return STATUS_SUCCESS;
+}
+
+static
+VOID
+XdpQuicCidMapInitialize(
+    _In_ XDP_MAP *Map
+    )
+{
+    XDP_QUIC_CID_MAP *CidMap = CONTAINING_RECORD(Map, XDP_QUIC_CID_MAP, Map);
+
+    XdpMapTableInitialize(
+        &CidMap->Table, XDP_MAP_TABLE_QUIC_CID_KEY_LENGTH, RtlRandomNumber());
+}
+
+static
+VOID
+XdpQuicCidMapCleanup(
+    _In_ XDP_MAP *Map
+    )
+{
+    XDP_QUIC_CID_MAP *CidMap = CONTAINING_RECORD(Map, XDP_QUIC_CID_MAP, Map);
+
+    XdpMapTableCleanup(&CidMap->Table);
+}
+
+static
+NTSTATUS
+XdpQuicCidMapInsert(
+    _In_ XDP_MAP *Map,
+    _In_ KPROCESSOR_MODE RequestorMode,
+    _In_ const VOID *Key,
+    _In_ const VOID *Value
+    )
+{
+    XDP_QUIC_CID_MAP *CidMap = CONTAINING_RECORD(Map, XDP_QUIC_CID_MAP, Map);
+    XDP_MAP_TABLE_ENTRY *Entry = NULL;
+    BOOLEAN EntryInserted;
+    NTSTATUS Status;
+
+    Entry = ExAllocatePoolZero(NonPagedPoolNx, sizeof(*Entry), XDP_POOLTAG_MAP);
+    if (Entry == NULL) {
+        Status = STATUS_NO_MEMORY;
+        goto Exit;
+    }
+
+    Status = XdpQuicCidMapCaptureKey(RequestorMode, Key, Entry->Key);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    //
+    // Reference the XSK handle in the context of the calling process. The
+    // Value buffer is a raw user pointer; XskReferenceDatapathHandle probes
+    // it as required.
+    //
+    Status =
+        XskReferenceDatapathHandle(RequestorMode, Value, FALSE, &Entry->Value.Target);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    Entry->Value.Action = XDP_PROGRAM_ACTION_REDIRECT;
+
+    Status =
+        XdpMapTableUpsert(
+            &CidMap->Table, Entry, NULL, QUIC_CID_MAP_MAX_SIZE, &EntryInserted);
+    if (NT_SUCCESS(Status) && EntryInserted) {
+        Entry = NULL;
+    }
+
+Exit:
+
+    //
+    // Release the replaced XSK, or the new XSK if it was not inserted.
+    //
+    if (Entry != NULL) {
+        XdpMapReleaseActionValue(&Entry->Value);
+        ExFreePoolWithTag(Entry, XDP_POOLTAG_MAP);
+    }
+
+    return Status;
+}
+
+static
+NTSTATUS
+XdpQuicCidMapDelete(
+    _In_ XDP_MAP *Map,
+    _In_ KPROCESSOR_MODE RequestorMode,
+    _In_ const VOID *Key
+    )
+{
+    XDP_QUIC_CID_MAP *CidMap = CONTAINING_RECORD(Map, XDP_QUIC_CID_MAP, Map);
+    XDP_MAP_TABLE *Table = &CidMap->Table;
+    UINT32 KeyValue[XDP_MAP_TABLE_QUIC_CID_KEY_LENGTH / sizeof(UINT32)];
+    XDP_MAP_TABLE_ENTRY **Link;
+    XDP_MAP_TABLE_ENTRY *OldEntry = NULL;
+    UINT32 Hash;
+    LOCK_STATE_EX LockState;
+    NTSTATUS Status;
+
+    Status = XdpQuicCidMapCaptureKey(RequestorMode, Key, KeyValue);
+    if (!NT_SUCCESS(Status)) {
+        return Status;
+    }
+
+    Hash = XdpMapTableHash(Table, KeyValue);
+
+    //
+    // The bucket array is not shrunk when entries are deleted.
+    //
+    XdpMapAcquireWrite(&LockState);
+    Link = XdpMapTableFind(Table, Hash, KeyValue);
+    if (Link != NULL) {
+        OldEntry = XdpMapTableRemove(Table, Link);
+    }
+    XdpMapReleaseWrite(&LockState);
+
+    if (OldEntry != NULL) {
+        XdpMapReleaseActionValue(&OldEntry->Value);
+        ExFreePoolWithTag(OldEntry, XDP_POOLTAG_MAP);
+    }
+
+    return STATUS_SUCCESS;
+}
+
+const XDP_MAP_TYPE_DISPATCH XdpQuicCidMapTypeDispatch = {
+    .Initialize = XdpQuicCidMapInitialize,
+    .Cleanup = XdpQuicCidMapCleanup,
+    .Insert = XdpQuicCidMapInsert,
+    .Delete = XdpQuicCidMapDelete,
+};
+
+_IRQL_requires_(DISPATCH_LEVEL)
+VOID *
+XdpQuicCidMapLookup(
+    _In_ XDP_MAP *Map,
+    _In_reads_bytes_(CidLength) const UINT8 *Cid,
+    _In_ UINT8 CidLength
+    )
+{
+    XDP_QUIC_CID_MAP *CidMap;
+    UINT32 Key[XDP_MAP_TABLE_QUIC_CID_KEY_LENGTH / sizeof(UINT32)];
+    const XDP_MAP_TABLE_VALUE *Value;
+
+    ASSERT(Map->Type == XDP_MAP_TYPE_QUIC_CID);
+
+    CidMap = CONTAINING_RECORD(Map, XDP_QUIC_CID_MAP, Map);
+
+    XdpMapTableInitializeQuicCidKey(Key, Cid, CidLength);
+
+    //
+    // Caller must hold the global map read lock.
+    //
+    Value = XdpMapTableLookup(&CidMap->Table, Key);
+
+    return (Value != NULL) ? Value->Target : NULL;
+}
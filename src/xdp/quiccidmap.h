@@ -0,0 +1,35 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+#pragma once
+
+//
+// QUIC CID map: a hash table mapping QUIC connection IDs to AF_XDP socket
+// handles. The QUIC CID map is plugged into the common XDP map abstraction
+// (see map.h) via XdpQuicCidMapTypeDispatch.
+//
+
+//
+// Allocation size for a QUIC CID map, used by map.c when creating a new map.
+//
+extern const SIZE_T XdpQuicCidMapAllocationSize;
+
+//
+// Type dispatch table registered with the common map code.
+//
+extern const XDP_MAP_TYPE_DISPATCH XdpQuicCidMapTypeDispatch;
+
+//
+// Look up the XSK kernel handle stored for the given CID. Caller must hold the
+// global map read lock (see XdpMapAcquireRead). Returns NULL if no entry
+// exists.
+//
+_IRQL_requires_(DISPATCH_LEVEL)
+VOID *
+XdpQuicCidMapLookup(
+    _In_ XDP_MAP *Map,
+    _In_reads_bytes_(CidLength) const UINT8 *Cid,
+    _In_ UINT8 CidLength
+    );
@@ -18,6 +18,10 @@ XdpFlushRedirectBatch(
         XskReceive(Batch);
         break;
 
+    case XDP_REDIRECT_TARGET_TYPE_INTERFACE_TX:
+        XdpTxRedirectReceive(Batch);
+        break;
+
     default:
         ASSERT(FALSE);
     }
@@ -31,13 +35,15 @@ XdpFlushRedirect(
     _In_ XDP_REDIRECT_CONTEXT *Redirect
     )
 {
-    for (ULONG Index = 0; Index < RTL_NUMBER_OF(Redirect->RedirectBatches); Index++) {
+    for (ULONG Index = 0; Index < Redirect->BatchCount; Index++) {
         XDP_REDIRECT_BATCH *Batch = &Redirect->RedirectBatches[Index];
 
         if (Batch->Count > 0) {
             XdpFlushRedirectBatch(Batch);
         }
     }
+
+    Redirect->BatchCount = 0;
 }
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -46,29 +52,66 @@ XdpRedirect(
     _In_ XDP_REDIRECT_CONTEXT *Redirect,
     _In_ UINT32 FrameIndex,
     _In_ UINT32 FragmentIndex,
+    _In_ UINT32 MetadataLength,
     _In_ XDP_REDIRECT_TARGET_TYPE TargetType,
     _In_ VOID *Target
     )
 {
-    XDP_REDIRECT_BATCH *Batch = &Redirect->RedirectBatches[0];
+    XDP_REDIRECT_BATCH *Batch = NULL;
+    UINT32 OrderIndex;
 
-    if (Batch->Count > 0 &&
-        (Batch->TargetType != TargetType ||
-         Batch->Target != Target ||
-         Batch->Count == RTL_NUMBER_OF(Batch->FrameIndexes))) {
-        //
-        // Flush the batch.
-        //
-        XdpFlushRedirectBatch(Batch);
+    //
+    // Find the pending batch for this target, starting with the most recently
+    // used batch.
+    //
+    for (OrderIndex = 0; OrderIndex < Redirect->BatchCount; OrderIndex++) {
+        Batch = &Redirect->RedirectBatches[Redirect->BatchOrder[OrderIndex]];
+
+        if (Batch->TargetType == TargetType && Batch->Target == Target) {
+            break;
+        }
     }
 
-    if (Batch->Count == 0) {
+    if (OrderIndex == Redirect->BatchCount) {
+        if (Redirect->BatchCount < RTL_NUMBER_OF(Redirect->RedirectBatches)) {
+            //
+            // Batches are only released all at once, so the next unused batch
+            // always follows the pending batches.
+            //
+            Redirect->BatchOrder[OrderIndex] = (UINT8)Redirect->BatchCount;
+            Redirect->BatchCount++;
+        } else {
+            //
+            // Flush the least recently used batch and reuse it for this target.
+            //
+            OrderIndex = Redirect->BatchCount - 1;
+            XdpFlushRedirectBatch(&Redirect->RedirectBatches[Redirect->BatchOrder[OrderIndex]]);
+        }
+
         //
         // Start a redirect batch.
         //
+        Batch = &Redirect->RedirectBatches[Redirect->BatchOrder[OrderIndex]];
         Batch->TargetType = TargetType;
         Batch->Target = Target;
         Batch->RxQueue = XdpRxQueueFromRedirectContext(Redirect);
+    } else if (Batch->Count == RTL_NUMBER_OF(Batch->FrameIndexes)) {
+        //
+        // Flush the batch.
+        //
+        XdpFlushRedirectBatch(Batch);
+    }
+
+    //
+    // Move the batch to the front of the most recently used order.
+    //
+    if (OrderIndex > 0) {
+        UINT8 BatchIndex = Redirect->BatchOrder[OrderIndex];
+
+        RtlMoveMemory(
+            &Redirect->BatchOrder[1], &Redirect->BatchOrder[0],
+            OrderIndex * sizeof(Redirect->BatchOrder[0]));
+        Redirect->BatchOrder[0] = BatchIndex;
     }
 
     //
@@ -77,5 +120,6 @@ XdpRedirect(
     ASSERT(Batch->Count < RTL_NUMBER_OF(Batch->FrameIndexes));
     Batch->FrameIndexes[Batch->Count].FrameIndex = FrameIndex;
     Batch->FrameIndexes[Batch->Count].FragmentIndex = FragmentIndex;
+    Batch->FrameIndexes[Batch->Count].MetadataLength = MetadataLength;
     Batch->Count++;
 }
@@ -10,6 +10,10 @@ typedef struct _XDP_RX_QUEUE XDP_RX_QUEUE;
 typedef struct _XDP_REDIRECT_FRAME {
     UINT32 FrameIndex;
     UINT32 FragmentIndex;
+    //
+    // Length of the metadata immediately preceding the frame's data.
+    //
+    UINT32 MetadataLength;
 } XDP_REDIRECT_FRAME;
 
 typedef struct _XDP_REDIRECT_BATCH {
@@ -20,8 +24,21 @@ typedef struct _XDP_REDIRECT_BATCH {
     XDP_REDIRECT_FRAME FrameIndexes[32];
 } XDP_REDIRECT_BATCH;
 
+//
+// Number of redirect targets that can be batched concurrently. Frames
+// interleaved across up to this many targets are still delivered in full
+// batches; beyond that, the least recently used batch is flushed early.
+//
+#define XDP_REDIRECT_BATCH_COUNT 8
+
 typedef struct _XDP_REDIRECT_CONTEXT {
-    XDP_REDIRECT_BATCH RedirectBatches[1];
+    //
+    // The first BatchCount entries of RedirectBatches hold pending frames.
+    // BatchOrder lists their indexes from most to least recently used.
+    //
+    UINT32 BatchCount;
+    UINT8 BatchOrder[XDP_REDIRECT_BATCH_COUNT];
+    XDP_REDIRECT_BATCH RedirectBatches[XDP_REDIRECT_BATCH_COUNT];
 } XDP_REDIRECT_CONTEXT;
 
 _IRQL_requires_max_(DISPATCH_LEVEL)
@@ -30,6 +47,7 @@ XdpRedirect(
     _In_ XDP_REDIRECT_CONTEXT *Redirect,
     _In_ UINT32 FrameIndex,
     _In_ UINT32 FragmentIndex,
+    _In_ UINT32 MetadataLength,
     _In_ XDP_REDIRECT_TARGET_TYPE TargetType,
     _In_ VOID *Target
     );
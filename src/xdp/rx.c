@@ -35,6 +35,13 @@ typedef struct _XDP_RX_QUEUE {
     XDP_EXTENSION FragmentExtension;
     XDP_EXTENSION RxActionExtension;
 
+    //
+    // The optional buffer provider, which posts receive buffers to the
+    // interface via the provider ring.
+    //
+    VOID *BufferProvider;
+    XDP_RING *BufferProviderRing;
+
 #if DBG
     //
     // Tracks the internally-consumed frames. We use this to verify a single
@@ -91,6 +98,15 @@ typedef struct _XDP_RX_QUEUE {
 
     BOOLEAN IsChecksumOffloadEnabled;
     BOOLEAN IsTimestampOffloadEnabled;
+    BOOLEAN IsGroOffloadEnabled;
+    UINT32 GroMaximumFrameLength;
+
+    //
+    // The buffer provider was disabled while the interface queue was active,
+    // so its buffers may still be posted to the interface. The provider is
+    // released once the interface queue is detached.
+    //
+    BOOLEAN BufferProviderRevoked;
 
     XDP_IF_OFFLOAD_HANDLE InterfaceOffloadHandle;
     PCW_INSTANCE *PcwInstance;
@@ -127,10 +143,50 @@ XdpRxQueueFromRedirectContext(
     return CONTAINING_RECORD(RedirectContext, XDP_RX_QUEUE, InspectionContext.RedirectContext);
 }
 
+VOID
+XdpRxQueueGetFrameRings(
+    _In_ XDP_RX_QUEUE *RxQueue,
+    _Out_ XDP_RING **FrameRing,
+    _Out_ XDP_RING **FragmentRing,
+    _Out_ XDP_EXTENSION **FragmentExtension,
+    _Out_ XDP_EXTENSION **VirtualAddressExtension
+    )
+{
+    //
+    // Redirect targets use these to read frames batched from this queue. The
+    // fragment extension is valid only if the fragment ring is non-NULL.
+    //
+    *FrameRing = RxQueue->FrameRing;
+    *FragmentRing = RxQueue->FragmentRing;
+    *FragmentExtension = &RxQueue->FragmentExtension;
+    *VirtualAddressExtension = &RxQueue->VirtualAddressExtension;
+}
+
+static
+FORCEINLINE
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+XdpRxQueueProvideBuffers(
+    _In_ XDP_RX_QUEUE *RxQueue
+    )
+{
+    //
+    // Replenish the interface's receive buffers from the buffer provider. This
+    // runs at the end of each batch, after the provider has consumed any
+    // frames redirected to it.
+    //
+    if (RxQueue->BufferProviderRing != NULL) {
+        XskProvideRxBuffers(RxQueue->BufferProvider, RxQueue->BufferProviderRing);
+    }
+}
+
 //
 // XdpReceiveBatchStart / XdpReceiveBatchComplete acquire and release the
-// global map read lock as a pair. The IRQL is balanced across the pair via the
-// LockState saved in the inspection context.
+// global map read lock as a pair. Programs that only use lock-free XSKMAP
+// lookups or rate limit rules instead raise to DISPATCH_LEVEL for the batch,
+// which holds off the release of replaced map entries and keeps per-processor
+// token buckets private to the batch. The IRQL is balanced across the pair via
+// the state saved in the inspection context.
 //
 #pragma warning(push)
 #pragma warning(disable: 28167)
@@ -143,8 +199,12 @@ XdpReceiveBatchStart(
     XdbgEnterQueueEc(RxQueue);
     STAT_INC(XdpRxQueueGetStats(RxQueue), InspectBatches);
 
-    if (RxQueue->Program != NULL && RxQueue->Program->HasMap) {
-        XdpMapAcquireRead(&RxQueue->InspectionContext.MapLockState);
+    if (RxQueue->Program != NULL) {
+        if (RxQueue->Program->HasMap) {
+            XdpMapAcquireRead(&RxQueue->InspectionContext.MapLockState);
+        } else if (RxQueue->Program->HasXskMap || RxQueue->Program->HasRateLimit) {
+            KeRaiseIrql(DISPATCH_LEVEL, &RxQueue->InspectionContext.MapOldIrql);
+        }
     }
 }
 
@@ -154,10 +214,15 @@ XdpReceiveBatchComplete(
     _In_ XDP_RX_QUEUE *RxQueue
     )
 {
-    if (RxQueue->Program != NULL && RxQueue->Program->HasMap) {
-        XdpMapReleaseRead(&RxQueue->InspectionContext.MapLockState);
+    if (RxQueue->Program != NULL) {
+        if (RxQueue->Program->HasMap) {
+            XdpMapReleaseRead(&RxQueue->InspectionContext.MapLockState);
+        } else if (RxQueue->Program->HasXskMap || RxQueue->Program->HasRateLimit) {
+            KeLowerIrql(RxQueue->InspectionContext.MapOldIrql);
+        }
     }
 
+    XdpRxQueueProvideBuffers(RxQueue);
     XdpQueueDatapathSync(&RxQueue->Sync);
 
     XdbgExitQueueEc(RxQueue);
@@ -201,6 +266,7 @@ XdpFlushReceive(
 
     XdbgEnterQueueEc(RxQueue);
     XdppFlushReceive(RxQueue);
+    XdpRxQueueProvideBuffers(RxQueue);
     XdpQueueDatapathSync(&RxQueue->Sync);
     XdbgExitQueueEc(RxQueue);
 }
@@ -237,14 +303,26 @@ XdppReceiveBatch(
             Fragment = XdpGetFragmentExtension(Frame, &RxQueue->FragmentExtension);
         }
 
+        ActionExtension = XdpGetRxActionExtension(Frame, &RxQueue->RxActionExtension);
+
+        if (RxQueue->BufferProviderRing != NULL) {
+            ActionExtension->RxAction = XDP_RX_ACTION_DROP;
+        }
+
         Action =
             InspectRoutine(
                 RxQueue->Program, &RxQueue->InspectionContext, RxQueue->FrameRing, FrameIndex,
                 RxQueue->FragmentRing, &RxQueue->FragmentExtension, FragmentIndex,
                 &RxQueue->VirtualAddressExtension);
 
-        ActionExtension = XdpGetRxActionExtension(Frame, &RxQueue->RxActionExtension);
-        ActionExtension->RxAction = Action;
+        //
+        // A redirect flush during inspection may have already returned the
+        // buffer to its provider.
+        //
+        if (RxQueue->BufferProviderRing == NULL ||
+            ActionExtension->RxAction != XDP_RX_ACTION_CONSUMED) {
+            ActionExtension->RxAction = Action;
+        }
 
         FrameRing->ConsumerIndex++;
 
@@ -258,6 +336,109 @@ XdppReceiveBatch(
     }
 }
 
+static
+VOID
+XdpRxQueueResetRxActions(
+    _In_ XDP_RX_QUEUE *RxQueue,
+    _In_ UINT32 FrameCount
+    )
+{
+    XDP_RING *FrameRing = RxQueue->FrameRing;
+
+    //
+    // Frames redirected to the buffer provider are marked consumed by the
+    // provider itself, so clear any stale actions before inspection.
+    //
+    for (UINT32 i = 0; i < FrameCount; i++) {
+        XDP_FRAME *Frame =
+            XdpRingGetElement(FrameRing, (FrameRing->ConsumerIndex + i) & FrameRing->Mask);
+
+        XdpGetRxActionExtension(Frame, &RxQueue->RxActionExtension)->RxAction =
+            XDP_RX_ACTION_DROP;
+    }
+}
+
+static
+FORCEINLINE
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+XdppReceiveBatchParsed(
+    _In_ XDP_RX_QUEUE *RxQueue
+    )
+{
+    XDP_RING *FrameRing = RxQueue->FrameRing;
+    XDP_RX_ACTION Actions[XDP_INSPECT_BATCH_SIZE];
+
+    //
+    // Inspect the ring in chunks of up to XDP_INSPECT_BATCH_SIZE frames,
+    // allowing the headers of each chunk to be prefetched and parsed before
+    // any rules are evaluated.
+    //
+
+    while (XdpRingCount(FrameRing) > 0) {
+        UINT32 FrameCount = min(XdpRingCount(FrameRing), XDP_INSPECT_BATCH_SIZE);
+        UINT32 FragmentIndex = 0;
+
+        if (RxQueue->FragmentRing != NULL) {
+            FragmentIndex = RxQueue->FragmentRing->ConsumerIndex & RxQueue->FragmentRing->Mask;
+        }
+
+        if (RxQueue->BufferProviderRing != NULL) {
+            XdpRxQueueResetRxActions(RxQueue, FrameCount);
+        }
+
+        XdpInspectBatch(
+            RxQueue->Program, &RxQueue->InspectionContext, FrameRing,
+            FrameRing->ConsumerIndex & FrameRing->Mask, FrameCount, RxQueue->FragmentRing,
+            &RxQueue->FragmentExtension, FragmentIndex, &RxQueue->VirtualAddressExtension,
+            Actions);
+
+        for (UINT32 i = 0; i < FrameCount; i++) {
+            XDP_FRAME *Frame;
+            XDP_FRAME_RX_ACTION *ActionExtension;
+
+            Frame = XdpRingGetElement(FrameRing, FrameRing->ConsumerIndex & FrameRing->Mask);
+
+            ActionExtension = XdpGetRxActionExtension(Frame, &RxQueue->RxActionExtension);
+
+            //
+            // A redirect flush during inspection may have already returned the
+            // buffer to its provider.
+            //
+            if (RxQueue->BufferProviderRing == NULL ||
+                ActionExtension->RxAction != XDP_RX_ACTION_CONSUMED) {
+                ActionExtension->RxAction = Actions[i];
+            }
+
+            FrameRing->ConsumerIndex++;
+
+            if (RxQueue->FragmentRing != NULL) {
+                RxQueue->FragmentRing->ConsumerIndex +=
+                    XdpGetFragmentExtension(Frame, &RxQueue->FragmentExtension)->FragmentBufferCount;
+            }
+        }
+
+#if DBG
+        RxQueue->FrameConsumerIndex = FrameRing->ConsumerIndex;
+#endif
+    }
+}
+
+static
+FORCEINLINE
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+XdppReceiveInspect(
+    _In_ XDP_RX_QUEUE *RxQueue
+    )
+{
+    if (RxQueue->Program->BatchParse) {
+        XdppReceiveBatchParsed(RxQueue);
+    } else {
+        XdppReceiveBatch(RxQueue, XdpInspect);
+    }
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 VOID
 XdpReceive(
@@ -268,7 +449,7 @@ XdpReceive(
 
     XdpReceiveBatchStart(RxQueue);
 
-    XdppReceiveBatch(RxQueue, XdpInspect);
+    XdppReceiveInspect(RxQueue);
     XdppFlushReceive(RxQueue);
 
     XdpReceiveBatchComplete(RxQueue);
@@ -289,7 +470,7 @@ XdpReceiveEbpf(
         XdppReceiveBatch(RxQueue, XdpInspectEbpf);
         XdpInspectEbpfEndBatch(RxQueue->Program, &RxQueue->InspectionContext);
     } else {
-        XdppReceiveBatch(RxQueue, XdpInspect);
+        XdppReceiveInspect(RxQueue);
     }
 
     XdppFlushReceive(RxQueue);
@@ -342,7 +523,7 @@ XdpReceiveXskExclusiveBatch(
         //
         // XSK could not process the batch, so fall back to the common code path.
         //
-        XdppReceiveBatch(RxQueue, XdpInspect);
+        XdppReceiveInspect(RxQueue);
         XdppFlushReceive(RxQueue);
     }
 
@@ -429,6 +610,13 @@ static const XDP_EXTENSION_REGISTRATION XdpRxFrameExtensions[] = {
         .Size                   = sizeof(XDP_FRAME_TIMESTAMP),
         .Alignment              = __alignof(XDP_FRAME_TIMESTAMP),
     },
+    {
+        .Info.ExtensionName     = XDP_FRAME_EXTENSION_GRO_NAME,
+        .Info.ExtensionVersion  = XDP_FRAME_EXTENSION_GRO_VERSION_1,
+        .Info.ExtensionType     = XDP_EXTENSION_TYPE_FRAME,
+        .Size                   = sizeof(XDP_FRAME_GRO),
+        .Alignment              = __alignof(XDP_FRAME_GRO),
+    },
 };
 
 static const XDP_EXTENSION_REGISTRATION XdpRxBufferExtensions[] = {
@@ -700,6 +888,46 @@ XdpRxQueueIsLayoutExtensionEnabled(
             RxQueue->FrameExtensionSet, XDP_FRAME_EXTENSION_LAYOUT_NAME);
 }
 
+BOOLEAN
+XdpRxQueueIsGroOffloadEnabled(
+    _In_ XDP_RX_QUEUE_CONFIG_ACTIVATE RxQueueConfig
+    )
+{
+    XDP_RX_QUEUE *RxQueue = XdpRxQueueFromConfigActivate(RxQueueConfig);
+
+    return RxQueue->IsGroOffloadEnabled;
+}
+
+UINT32
+XdpRxQueueGetGroMaximumFrameLength(
+    _In_ XDP_RX_QUEUE_CONFIG_ACTIVATE RxQueueConfig
+    )
+{
+    XDP_RX_QUEUE *RxQueue = XdpRxQueueFromConfigActivate(RxQueueConfig);
+
+    return RxQueue->GroMaximumFrameLength;
+}
+
+BOOLEAN
+XdpRxQueueIsBufferProviderEnabled(
+    _In_ XDP_RX_QUEUE_CONFIG_ACTIVATE RxQueueConfig
+    )
+{
+    XDP_RX_QUEUE *RxQueue = XdpRxQueueFromConfigActivate(RxQueueConfig);
+
+    return RxQueue->BufferProviderRing != NULL;
+}
+
+XDP_RING *
+XdpRxQueueGetBufferProviderRing(
+    _In_ XDP_RX_QUEUE_CONFIG_ACTIVATE RxQueueConfig
+    )
+{
+    XDP_RX_QUEUE *RxQueue = XdpRxQueueFromConfigActivate(RxQueueConfig);
+
+    return RxQueue->BufferProviderRing;
+}
+
 static
 CONST XDP_HOOK_ID *
 XdppRxQueueGetHookId(
@@ -887,13 +1115,15 @@ static const XDP_RX_QUEUE_CONFIG_CREATE_DISPATCH XdpRxConfigCreateDispatch = {
 static const XDP_RX_QUEUE_CONFIG_ACTIVATE_DISPATCH XdpRxConfigActivateDispatch = {
     .Header                     = {
         .Revision               = XDP_RX_QUEUE_CONFIG_ACTIVATE_DISPATCH_REVISION_1,
-        .Size                   = XDP_SIZEOF_RX_QUEUE_CONFIG_ACTIVATE_DISPATCH_REVISION_1
+        .Size                   = sizeof(XdpRxConfigActivateDispatch),
     },
     .GetFrameRing               = XdpRxQueueGetFrameRing,
     .GetFragmentRing            = XdpRxQueueGetFragmentRing,
     .GetExtension               = XdpRxQueueGetExtension,
     .IsVirtualAddressEnabled    = XdpRxQueueIsVirtualAddressEnabled,
     .IsChecksumOffloadEnabled   = XdpRxQueueIsChecksumOffloadEnabled,
+    .IsBufferProviderEnabled    = XdpRxQueueIsBufferProviderEnabled,
+    .GetBufferProviderRing      = XdpRxQueueGetBufferProviderRing,
 };
 
 static const XDP_RX_QUEUE_NOTIFY_DISPATCH XdpRxNotifyDispatch = {
@@ -942,6 +1172,22 @@ XdpRxQueueDetachInterface(
         RxQueue->FrameRing = NULL;
     }
 
+    if (RxQueue->BufferProviderRing != NULL) {
+        XdpRingFreeRing(RxQueue->BufferProviderRing);
+        RxQueue->BufferProviderRing = NULL;
+        RxQueue->InspectionContext.SnapshotHeaders = FALSE;
+    }
+
+    if (RxQueue->BufferProviderRevoked) {
+        //
+        // The interface has returned all provided buffers, so the revoked
+        // provider can finally be released.
+        //
+        XskDereferenceRxBufferProvider(RxQueue->BufferProvider);
+        RxQueue->BufferProvider = NULL;
+        RxQueue->BufferProviderRevoked = FALSE;
+    }
+
     XdpExtensionSetInitialize(
         XDP_EXTENSION_TYPE_FRAME, XdpRxFrameExtensions, RTL_NUMBER_OF(XdpRxFrameExtensions),
         RxQueue->FrameExtensionSet);
@@ -1003,6 +1249,11 @@ XdpRxQueueAttachInterface(
             RxQueue->FrameExtensionSet, XDP_FRAME_EXTENSION_TIMESTAMP_NAME);
     }
 
+    if (RxQueue->IsGroOffloadEnabled) {
+        XdpExtensionSetEnableEntry(
+            RxQueue->FrameExtensionSet, XDP_FRAME_EXTENSION_GRO_NAME);
+    }
+
     RxQueue->ConfigCreate.Dispatch = &XdpRxConfigCreateDispatch;
 
     Status =
@@ -1055,6 +1306,23 @@ XdpRxQueueAttachInterface(
         }
     }
 
+    if (RxQueue->BufferProvider != NULL &&
+        RxQueue->InterfaceRxCapabilities.MaximumFragments == 0) {
+        Status =
+            XdpRingAllocate(
+                sizeof(XDP_RX_PROVIDED_BUFFER), XdpRxRingSize,
+                __alignof(XDP_RX_PROVIDED_BUFFER), &RxQueue->BufferProviderRing);
+        if (!NT_SUCCESS(Status)) {
+            goto Exit;
+        }
+
+        //
+        // Provided buffers are mapped into user mode; inspect copies of their
+        // headers.
+        //
+        RxQueue->InspectionContext.SnapshotHeaders = TRUE;
+    }
+
     XdpInitializeExtensionInfo(
         &ExtensionInfo, XDP_FRAME_EXTENSION_RX_ACTION_NAME,
         XDP_FRAME_EXTENSION_RX_ACTION_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
@@ -1168,6 +1436,7 @@ XdpRxQueueCreate(
     DECLARE_UNICODE_STRING_SIZE(
         Name, ARRAYSIZE("if_" MAXUINT32_STR "_queue_" MAXUINT32_STR "_tx"));
     const WCHAR *DirectionString;
+    const XDP_CAPABILITIES_INTERNAL *IfCapabilities;
 
     *NewRxQueue = NULL;
 
@@ -1213,6 +1482,20 @@ XdpRxQueueCreate(
     RxQueue->Binding = Binding;
     RxQueue->Key = Key;
     RxQueue->InspectionContext.IfIndex = XdpIfGetIfIndex(Binding);
+
+    //
+    // Frames inspected on the TX path are owned by upper layers, which may
+    // store their own data in front of or after the frame.
+    //
+    IfCapabilities = XdpIfGetCapabilities(Binding);
+    RxQueue->InspectionContext.FrameBoundsAdjustable =
+        RTL_CONTAINS_FIELD(
+            IfCapabilities->CapabilitiesEx,
+            IfCapabilities->CapabilitiesEx->Header.Size,
+            RxFrameBoundsAdjustmentSupported) &&
+        IfCapabilities->CapabilitiesEx->RxFrameBoundsAdjustmentSupported;
+    RxQueue->InspectionContext.FrameBoundsExtendable =
+        RxQueue->InspectionContext.FrameBoundsAdjustable && HookId->Direction == XDP_HOOK_RX;
     XdpInitializeQueueInfo(&RxQueue->QueueInfo, XDP_QUEUE_TYPE_DEFAULT_RSS, QueueId);
     XdbgInitializeQueueEc(RxQueue);
 
@@ -1467,6 +1750,128 @@ Exit:
     return Status;
 }
 
+NTSTATUS
+XdpRxQueueEnableGroOffload(
+    _In_ XDP_RX_QUEUE *RxQueue,
+    _In_ UINT32 MaximumFrameLength
+    )
+{
+    NTSTATUS Status;
+
+    TraceEnter(
+        TRACE_CORE, "RxQueue=%p MaximumFrameLength=%u", RxQueue, MaximumFrameLength);
+
+    if (RxQueue->State == XdpRxQueueStateUnbound) {
+        if (!RxQueue->IsGroOffloadEnabled) {
+            const XDP_CAPABILITIES_INTERNAL *IfCapabilities =
+                XdpIfGetCapabilities(RxQueue->Binding);
+            if (RTL_CONTAINS_FIELD(
+                    IfCapabilities->CapabilitiesEx,
+                    IfCapabilities->CapabilitiesEx->Header.Size,
+                    RxGroSupported) &&
+                IfCapabilities->CapabilitiesEx->RxGroSupported) {
+                XdpExtensionSetEnableEntry(
+                    RxQueue->FrameExtensionSet, XDP_FRAME_EXTENSION_GRO_NAME);
+                RxQueue->IsGroOffloadEnabled = TRUE;
+                RxQueue->GroMaximumFrameLength = MaximumFrameLength;
+            } else {
+                Status = STATUS_NOT_SUPPORTED;
+                goto Exit;
+            }
+        }
+
+        //
+        // Coalesced frames must fit every client that enabled the offload.
+        //
+        RxQueue->GroMaximumFrameLength =
+            min(RxQueue->GroMaximumFrameLength, MaximumFrameLength);
+        Status = STATUS_SUCCESS;
+    } else if (RxQueue->IsGroOffloadEnabled &&
+        RxQueue->GroMaximumFrameLength <= MaximumFrameLength) {
+        ASSERT(XdpExtensionSetIsExtensionEnabled(
+            RxQueue->FrameExtensionSet, XDP_FRAME_EXTENSION_GRO_NAME));
+        Status = STATUS_SUCCESS;
+    } else {
+        Status = STATUS_INVALID_DEVICE_STATE;
+    }
+
+Exit:
+
+    TraceExitStatus(TRACE_CORE);
+
+    return Status;
+}
+
+NTSTATUS
+XdpRxQueueEnableBufferProvider(
+    _In_ XDP_RX_QUEUE *RxQueue,
+    _In_ VOID *BufferProvider
+    )
+{
+    NTSTATUS Status;
+    const XDP_CAPABILITIES_INTERNAL *IfCapabilities;
+
+    TraceEnter(TRACE_CORE, "RxQueue=%p BufferProvider=%p", RxQueue, BufferProvider);
+
+    if (RxQueue->BufferProvider != NULL || RxQueue->State != XdpRxQueueStateUnbound) {
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+
+    IfCapabilities = XdpIfGetCapabilities(RxQueue->Binding);
+    if (!RTL_CONTAINS_FIELD(
+            IfCapabilities->CapabilitiesEx,
+            IfCapabilities->CapabilitiesEx->Header.Size,
+            RxBufferProviderSupported) ||
+        !IfCapabilities->CapabilitiesEx->RxBufferProviderSupported) {
+        Status = STATUS_NOT_SUPPORTED;
+        goto Exit;
+    }
+
+    //
+    // The caller's reference on the provider is transferred to the RX queue.
+    // The provider ring is allocated when the interface queue is attached.
+    //
+    RxQueue->BufferProvider = BufferProvider;
+    Status = STATUS_SUCCESS;
+
+Exit:
+
+    TraceExitStatus(TRACE_CORE);
+
+    return Status;
+}
+
+VOID
+XdpRxQueueDisableBufferProvider(
+    _In_ XDP_RX_QUEUE *RxQueue,
+    _In_ VOID *BufferProvider
+    )
+{
+    TraceEnter(TRACE_CORE, "RxQueue=%p BufferProvider=%p", RxQueue, BufferProvider);
+
+    if (RxQueue->BufferProvider != BufferProvider || RxQueue->BufferProviderRevoked) {
+        goto Exit;
+    }
+
+    if (RxQueue->State == XdpRxQueueStateUnbound) {
+        ASSERT(RxQueue->BufferProviderRing == NULL);
+        RxQueue->BufferProvider = NULL;
+        XskDereferenceRxBufferProvider(BufferProvider);
+    } else {
+        //
+        // The interface may still own buffers posted by the provider, so keep
+        // the provider referenced until the interface queue is detached. The
+        // provider stops posting buffers once its datapath is detached.
+        //
+        RxQueue->BufferProviderRevoked = TRUE;
+    }
+
+Exit:
+
+    TraceExitSuccess(TRACE_CORE);
+}
+
 VOID
 XdpRxQueueSync(
     _In_ XDP_RX_QUEUE *RxQueue,
@@ -1647,6 +2052,8 @@ XdpRxQueueDereference(
     if (XdpDecrementReferenceCount(&RxQueue->ReferenceCount)) {
         TraceInfo(TRACE_CORE, "Deleting RxQueue=%p", RxQueue);
 
+        ASSERT(RxQueue->BufferProvider == NULL);
+
         if (RxQueue->InterfaceOffloadHandle != NULL) {
             XdpIfCloseInterfaceOffloadHandle(
                 XdpIfGetIfSetHandle(RxQueue->Binding), RxQueue->InterfaceOffloadHandle);
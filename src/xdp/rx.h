@@ -79,6 +79,24 @@ XdpRxQueueEnableTimestampOffload(
     _In_ XDP_RX_QUEUE *RxQueue
     );
 
+NTSTATUS
+XdpRxQueueEnableGroOffload(
+    _In_ XDP_RX_QUEUE *RxQueue,
+    _In_ UINT32 MaximumFrameLength
+    );
+
+NTSTATUS
+XdpRxQueueEnableBufferProvider(
+    _In_ XDP_RX_QUEUE *RxQueue,
+    _In_ VOID *BufferProvider
+    );
+
+VOID
+XdpRxQueueDisableBufferProvider(
+    _In_ XDP_RX_QUEUE *RxQueue,
+    _In_ VOID *BufferProvider
+    );
+
 VOID
 XdpRxQueueDereference(
     _In_ XDP_RX_QUEUE *RxQueue
@@ -111,6 +129,15 @@ XdpRxQueueFromRedirectContext(
     _In_ XDP_REDIRECT_CONTEXT *RedirectContext
     );
 
+VOID
+XdpRxQueueGetFrameRings(
+    _In_ XDP_RX_QUEUE *RxQueue,
+    _Out_ XDP_RING **FrameRing,
+    _Out_ XDP_RING **FragmentRing,
+    _Out_ XDP_EXTENSION **FragmentExtension,
+    _Out_ XDP_EXTENSION **VirtualAddressExtension
+    );
+
 LIST_ENTRY *
 XdpRxQueueGetProgramBindingList(
     _In_ XDP_RX_QUEUE *RxQueue
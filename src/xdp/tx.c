@@ -46,6 +46,7 @@ typedef struct _XDP_TX_QUEUE {
     XDP_TX_QUEUE_CONFIG_ACTIVATE_DETAILS ConfigActivate;
     BOOLEAN IsChecksumOffloadEnabled;
     BOOLEAN IsTimestampOffloadEnabled;
+    BOOLEAN IsSegmentationOffloadEnabled;
 
     XDP_IF_OFFLOAD_HANDLE InterfaceOffloadHandle;
 
@@ -65,6 +66,7 @@ typedef struct _XDP_TX_QUEUE {
     XDP_INTERFACE_HANDLE InterfaceTxQueue;
     XDP_INTERFACE_TX_QUEUE_DISPATCH *InterfaceTxDispatch;
     XDP_RING *FrameRing;
+    XDP_RING *FragmentRing;
     XDP_RING *CompletionRing;
     XDP_EXTENSION_SET *FrameExtensionSet;
     XDP_EXTENSION_SET *BufferExtensionSet;
@@ -84,6 +86,39 @@ typedef struct _XDP_TX_QUEUE {
 // Data path routines.
 //
 
+static
+FORCEINLINE
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+XdpTxQueueClientFillCompletion(
+    _In_ XDP_TX_QUEUE_DATAPATH_CLIENT_ENTRY *ClientEntry
+    )
+{
+    if (ClientEntry->Type == XDP_TX_QUEUE_DATAPATH_CLIENT_TYPE_REDIRECT) {
+        XdpTxRedirectFillTxCompletion(ClientEntry);
+    } else {
+        ASSERT(ClientEntry->Type == XDP_TX_QUEUE_DATAPATH_CLIENT_TYPE_XSK);
+        XskFillTxCompletion(ClientEntry);
+    }
+}
+
+static
+FORCEINLINE
+_IRQL_requires_max_(DISPATCH_LEVEL)
+UINT32
+XdpTxQueueClientFill(
+    _In_ XDP_TX_QUEUE_DATAPATH_CLIENT_ENTRY *ClientEntry,
+    _In_ UINT32 FrameQuota
+    )
+{
+    if (ClientEntry->Type == XDP_TX_QUEUE_DATAPATH_CLIENT_TYPE_REDIRECT) {
+        return XdpTxRedirectFillTx(ClientEntry, FrameQuota);
+    } else {
+        ASSERT(ClientEntry->Type == XDP_TX_QUEUE_DATAPATH_CLIENT_TYPE_XSK);
+        return XskFillTx(ClientEntry, FrameQuota);
+    }
+}
+
 VOID
 XdpTxQueueInvokeInterfaceNotify(
     _In_ XDP_TX_QUEUE *TxQueue,
@@ -125,7 +160,7 @@ XdpTxQueueDatapathComplete(
             //
             // Consumes one or more completions via the completion ring.
             //
-            XskFillTxCompletion(CompletionContext->Context);
+            XdpTxQueueClientFillCompletion(CompletionContext->Context);
         }
     } else {
         XDP_RING *CompletionRing = TxQueue->CompletionRing;
@@ -142,7 +177,7 @@ XdpTxQueueDatapathComplete(
             //
             // Consumes one or more completions via the frame ring.
             //
-            XskFillTxCompletion(CompletionContext->Context);
+            XdpTxQueueClientFillCompletion(CompletionContext->Context);
         }
     }
 }
@@ -174,7 +209,7 @@ XdpTxQueueDatapathFill(
         }
 
         FrameCount =
-            XskFillTx(
+            XdpTxQueueClientFill(
                 CONTAINING_RECORD(TxQueue->FillEntry, XDP_TX_QUEUE_DATAPATH_CLIENT_ENTRY, Link),
                 TxAvailable);
 
@@ -259,6 +294,13 @@ XdpTxQueueInterlockedDereference(
 }
 
 static const XDP_EXTENSION_REGISTRATION XdpTxFrameExtensions[] = {
+    {
+        .Info.ExtensionName     = XDP_FRAME_EXTENSION_FRAGMENT_NAME,
+        .Info.ExtensionVersion  = XDP_FRAME_EXTENSION_FRAGMENT_VERSION_1,
+        .Info.ExtensionType     = XDP_EXTENSION_TYPE_FRAME,
+        .Size                   = sizeof(XDP_FRAME_FRAGMENT),
+        .Alignment              = __alignof(XDP_FRAME_FRAGMENT),
+    },
     {
         .Info.ExtensionName     = XDP_TX_FRAME_COMPLETION_CONTEXT_EXTENSION_NAME,
         .Info.ExtensionVersion  = XDP_TX_FRAME_COMPLETION_CONTEXT_EXTENSION_VERSION_1,
@@ -294,6 +336,13 @@ static const XDP_EXTENSION_REGISTRATION XdpTxFrameExtensions[] = {
         .Size                   = sizeof(XDP_FRAME_TIMESTAMP),
         .Alignment              = __alignof(XDP_FRAME_TIMESTAMP),
     },
+    {
+        .Info.ExtensionName     = XDP_FRAME_EXTENSION_GSO_NAME,
+        .Info.ExtensionVersion  = XDP_FRAME_EXTENSION_GSO_VERSION_1,
+        .Info.ExtensionType     = XDP_EXTENSION_TYPE_FRAME,
+        .Size                   = sizeof(XDP_FRAME_GSO),
+        .Alignment              = __alignof(XDP_FRAME_GSO),
+    },
 };
 
 static const XDP_EXTENSION_REGISTRATION XdpTxBufferExtensions[] = {
@@ -407,7 +456,6 @@ XdpTxQueueSetCapabilities(
     //
     FRE_ASSERT(Capabilities->Header.Revision >= XDP_TX_CAPABILITIES_REVISION_1);
     FRE_ASSERT(Capabilities->Header.Size >= XDP_SIZEOF_TX_CAPABILITIES_REVISION_1);
-    FRE_ASSERT(Capabilities->MaximumFragments <= 1);
     FRE_ASSERT(
         Capabilities->VirtualAddressEnabled ||
         Capabilities->MdlEnabled ||
@@ -432,6 +480,14 @@ XdpTxQueueSetCapabilities(
         XdpExtensionSetEnableEntry(
             TxQueue->BufferExtensionSet, XDP_BUFFER_EXTENSION_LOGICAL_ADDRESS_NAME);
     }
+
+    //
+    // Fragment buffers are reclaimed alongside their frame, so fragmentation
+    // is supported only with in-order completion.
+    //
+    if (Capabilities->MaximumFragments > 0 && !Capabilities->OutOfOrderCompletionEnabled) {
+        XdpExtensionSetEnableEntry(TxQueue->FrameExtensionSet, XDP_FRAME_EXTENSION_FRAGMENT_NAME);
+    }
 }
 
 VOID
@@ -522,12 +578,11 @@ XdpTxQueueGetFragmentRing(
     _In_ XDP_TX_QUEUE_CONFIG_ACTIVATE TxQueueConfig
     )
 {
-    UNREFERENCED_PARAMETER(TxQueueConfig);
+    XDP_TX_QUEUE *TxQueue = XdpTxQueueFromConfigActivate(TxQueueConfig);
 
-    //
-    // TODO: Not implemented.
-    //
-    FRE_ASSERT(FALSE);
+    FRE_ASSERT(TxQueue->FragmentRing != NULL);
+
+    return TxQueue->FragmentRing;
 }
 
 XDP_RING *
@@ -573,9 +628,9 @@ XdpTxQueueIsFragmentationEnabled(
     _In_ XDP_TX_QUEUE_CONFIG_ACTIVATE TxQueueConfig
     )
 {
-    UNREFERENCED_PARAMETER(TxQueueConfig);
+    XDP_TX_QUEUE *TxQueue = XdpTxQueueFromConfigActivate(TxQueueConfig);
 
-    return FALSE;
+    return TxQueue->FragmentRing != NULL;
 }
 
 BOOLEAN
@@ -608,6 +663,16 @@ XdpTxQueueIsTimestampOffloadEnabled(
     return TxQueue->IsTimestampOffloadEnabled;
 }
 
+BOOLEAN
+XdpTxQueueIsSegmentationOffloadEnabled(
+    _In_ XDP_TX_QUEUE_CONFIG_ACTIVATE TxQueueConfig
+    )
+{
+    XDP_TX_QUEUE *TxQueue = XdpTxQueueFromConfigActivate(TxQueueConfig);
+
+    return TxQueue->IsSegmentationOffloadEnabled;
+}
+
 static
 CONST XDP_HOOK_ID *
 XdppTxQueueGetHookId(
@@ -1043,6 +1108,10 @@ XdpTxQueueDeleteRings(
         XdpRingFreeRing(TxQueue->CompletionRing);
         TxQueue->CompletionRing = NULL;
     }
+    if (TxQueue->FragmentRing != NULL) {
+        XdpRingFreeRing(TxQueue->FragmentRing);
+        TxQueue->FragmentRing = NULL;
+    }
     if (TxQueue->FrameRing != NULL) {
         XdpRingFreeRing(TxQueue->FrameRing);
         TxQueue->FrameRing = NULL;
@@ -1114,6 +1183,17 @@ XdpTxQueueActivate(
         goto Exit;
     }
 
+    if (XdpExtensionSetIsExtensionEnabled(
+            TxQueue->FrameExtensionSet, XDP_FRAME_EXTENSION_FRAGMENT_NAME)) {
+        Status =
+            XdpRingAllocate(
+                BufferSize, max(TxQueue->InterfaceTxCapabilities.MaximumFragments, FrameCount),
+                BufferAlignment, &TxQueue->FragmentRing);
+        if (!NT_SUCCESS(Status)) {
+            goto Exit;
+        }
+    }
+
     if (TxQueue->InterfaceTxCapabilities.OutOfOrderCompletionEnabled) {
         Status =
             XdpExtensionSetAssignLayout(
@@ -1287,6 +1367,41 @@ XdpTxQueueEnableChecksumOffload(
     return Status;
 }
 
+NTSTATUS
+XdpTxQueueEnableSegmentationOffload(
+    _In_ XDP_TX_QUEUE *TxQueue
+    )
+{
+    NTSTATUS Status;
+
+    TraceEnter(TRACE_CORE, "TxQueue=%p", TxQueue);
+
+    if (TxQueue->IsSegmentationOffloadEnabled) {
+        ASSERT(XdpExtensionSetIsExtensionEnabled(
+            TxQueue->FrameExtensionSet, XDP_FRAME_EXTENSION_LAYOUT_NAME));
+        ASSERT(XdpExtensionSetIsExtensionEnabled(
+            TxQueue->FrameExtensionSet, XDP_FRAME_EXTENSION_GSO_NAME));
+        Status = STATUS_SUCCESS;
+    } else if (TxQueue->State == XdpTxQueueStateCreated) {
+        if (TxQueue->InterfaceTxCapabilities.MaximumSegmentationOffloadSize > 0) {
+            XdpExtensionSetEnableEntry(
+                TxQueue->FrameExtensionSet, XDP_FRAME_EXTENSION_LAYOUT_NAME);
+            XdpExtensionSetEnableEntry(
+                TxQueue->FrameExtensionSet, XDP_FRAME_EXTENSION_GSO_NAME);
+            TxQueue->IsSegmentationOffloadEnabled = TRUE;
+            Status = STATUS_SUCCESS;
+        } else {
+            Status = STATUS_NOT_SUPPORTED;
+        }
+    } else {
+        Status = STATUS_INVALID_DEVICE_STATE;
+    }
+
+    TraceExitStatus(TRACE_CORE);
+
+    return Status;
+}
+
 NTSTATUS
 XdpTxQueueEnableTimestampOffload(
     _In_ XDP_TX_QUEUE *TxQueue
@@ -1385,14 +1500,17 @@ XdpTxQueueAddDatapathClient(
 
     TraceEnter(TRACE_CORE, "TxQueue=%p TxClientEntry=%p", TxQueue, TxClientEntry);
 
-    ASSERT(TxClientType == XDP_TX_QUEUE_DATAPATH_CLIENT_TYPE_XSK);
-    UNREFERENCED_PARAMETER(TxClientType);
+    ASSERT(
+        TxClientType == XDP_TX_QUEUE_DATAPATH_CLIENT_TYPE_XSK ||
+        TxClientType == XDP_TX_QUEUE_DATAPATH_CLIENT_TYPE_REDIRECT);
 
     if (TxQueue->State != XdpTxQueueStateActive) {
         Status = STATUS_INVALID_DEVICE_STATE;
         goto Exit;
     }
 
+    TxClientEntry->Type = TxClientType;
+
     SyncParams.TxQueue = TxQueue;
     SyncParams.TxClientEntry = TxClientEntry;
     XdpTxQueueSync(TxQueue, XdpTxQueueSyncAddDatapathClient, &SyncParams);
@@ -85,12 +85,19 @@ XdpTxQueueEnableTimestampOffload(
     _In_ XDP_TX_QUEUE *TxQueue
     );
 
+NTSTATUS
+XdpTxQueueEnableSegmentationOffload(
+    _In_ XDP_TX_QUEUE *TxQueue
+    );
+
 typedef enum _XDP_TX_QUEUE_DATAPATH_CLIENT_TYPE {
     XDP_TX_QUEUE_DATAPATH_CLIENT_TYPE_XSK,
+    XDP_TX_QUEUE_DATAPATH_CLIENT_TYPE_REDIRECT,
 } XDP_TX_QUEUE_DATAPATH_CLIENT_TYPE;
 
 typedef struct _XDP_TX_QUEUE_DATAPATH_CLIENT_ENTRY {
     LIST_ENTRY Link;
+    XDP_TX_QUEUE_DATAPATH_CLIENT_TYPE Type;
 } XDP_TX_QUEUE_DATAPATH_CLIENT_ENTRY;
 
 NTSTATUS
@@ -0,0 +1,906 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+//
+// This module implements the interface TX redirect target, which transmits
+// frames redirected by XDP programs on an XDP TX queue. The TX queue may belong
+// to any interface, including the interface the frames were received on.
+//
+// Redirected frames are copied into a pool of XDP-owned buffers and queued
+// until the TX queue's execution context fills them into the XDP TX ring as a
+// regular TX queue datapath client. Buffers are returned to the pool upon TX
+// completion; frames are dropped if no buffer is available. Interface
+// notifications require PASSIVE_LEVEL and are issued from a work item.
+//
+
+#include "precomp.h"
+#include "txredirect.tmh"
+
+//
+// Each buffer holds an entire frame; larger frames are dropped.
+//
+#define XDP_TX_REDIRECT_BUFFER_SIZE 2048
+#define XDP_TX_REDIRECT_BUFFER_COUNT 256
+
+C_ASSERT(RTL_IS_POWER_OF_TWO(XDP_TX_REDIRECT_BUFFER_COUNT));
+
+typedef struct _XDP_TX_REDIRECT_PENDING_FRAME {
+    UINT32 BufferIndex;
+    UINT32 DataLength;
+} XDP_TX_REDIRECT_PENDING_FRAME;
+
+typedef struct _XDP_TX_REDIRECT {
+    XDP_REFERENCE_COUNT ReferenceCount;
+    UINT32 IfIndex;
+    UINT32 QueueId;
+    XDP_HOOK_ID HookId;
+
+    //
+    // Synchronizes the data path fields below, as well as clearing the
+    // interface handle from the binding work queue.
+    //
+    KSPIN_LOCK Lock;
+
+    //
+    // Control path fields, serialized by the interface binding work queue.
+    //
+    XDP_BINDING_HANDLE IfHandle;
+    XDP_TX_QUEUE *Queue;
+    XDP_TX_QUEUE_NOTIFICATION_ENTRY QueueNotificationEntry;
+    XDP_TX_QUEUE_DATAPATH_CLIENT_ENTRY DatapathClientEntry;
+    XDP_BINDING_WORKITEM DeleteWorkItem;
+    EX_RUNDOWN_REF NotifyRundown;
+    IO_WORKITEM *NotifyWorkItem;
+    KEVENT OutstandingFlushComplete;
+    BOOLEAN QueueInserted;
+
+    //
+    // Data path fields.
+    //
+    BOOLEAN Active;
+    LONG NotifyQueued;
+    struct {
+        BOOLEAN OutOfOrderCompletion : 1;
+        BOOLEAN CompletionContext : 1;
+        BOOLEAN VirtualAddressExt : 1;
+        BOOLEAN MdlExt : 1;
+        BOOLEAN LayoutExt : 1;
+        BOOLEAN ChecksumExt : 1;
+        BOOLEAN GsoExt : 1;
+    } Flags;
+    XDP_RING *FrameRing;
+    XDP_RING *FragmentRing;
+    XDP_RING *CompletionRing;
+    XDP_EXTENSION FragmentExtension;
+    XDP_EXTENSION FrameTxCompletionExtension;
+    XDP_EXTENSION TxCompletionExtension;
+    XDP_EXTENSION VaExtension;
+    XDP_EXTENSION MdlExtension;
+    XDP_EXTENSION LayoutExtension;
+    XDP_EXTENSION ChecksumExtension;
+    XDP_EXTENSION GsoExtension;
+    UINT32 OutstandingFrames;
+
+    //
+    // Buffer pool. Free buffers are tracked by a stack of buffer indexes, and
+    // frames awaiting transmit by a ring of pending frames. Since each pending
+    // frame holds a buffer, the pending ring never overflows.
+    //
+    UCHAR *BufferMemory;
+    MDL *BufferMdl;
+    UINT32 BufferSize;
+    UINT32 FreeCount;
+    UINT32 FreeBuffers[XDP_TX_REDIRECT_BUFFER_COUNT];
+    UINT32 PendingProducerIndex;
+    UINT32 PendingConsumerIndex;
+    XDP_TX_REDIRECT_PENDING_FRAME PendingFrames[XDP_TX_REDIRECT_BUFFER_COUNT];
+} XDP_TX_REDIRECT;
+
+typedef struct _XDP_TX_REDIRECT_WORKITEM {
+    XDP_BINDING_WORKITEM IfWorkItem;
+    XDP_TX_REDIRECT *TxRedirect;
+    KEVENT CompletionEvent;
+    NTSTATUS CompletionStatus;
+} XDP_TX_REDIRECT_WORKITEM;
+
+static XDP_TX_QUEUE_NOTIFICATION_ROUTINE XdpTxRedirectNotifyTxQueue;
+static IO_WORKITEM_ROUTINE_EX XdpTxRedirectNotifyWorker;
+
+//
+// Data path routines.
+//
+
+static
+FORCEINLINE
+UINT32
+XdpTxRedirectCopyFrame(
+    _In_ XDP_TX_REDIRECT *TxRedirect,
+    _In_ XDP_FRAME *Frame,
+    _In_opt_ XDP_RING *FragmentRing,
+    _In_ XDP_EXTENSION *FragmentExtension,
+    _In_ UINT32 FragmentIndex,
+    _In_ XDP_EXTENSION *VirtualAddressExtension,
+    _Out_writes_bytes_(TxRedirect->BufferSize) UCHAR *Destination
+    )
+{
+    XDP_BUFFER *Buffer = &Frame->Buffer;
+    XDP_BUFFER_VIRTUAL_ADDRESS *Va;
+    UINT32 FragmentCount = 0;
+    UINT32 FrameLength = Buffer->DataLength;
+
+    //
+    // Returns the frame length, or zero if the frame does not fit in a buffer.
+    //
+
+    if (FragmentRing != NULL) {
+        FragmentCount = XdpGetFragmentExtension(Frame, FragmentExtension)->FragmentBufferCount;
+
+        for (UINT32 Index = 0; Index < FragmentCount; Index++) {
+            Buffer = XdpRingGetElement(FragmentRing, (FragmentIndex + Index) & FragmentRing->Mask);
+            FrameLength += Buffer->DataLength;
+        }
+    }
+
+    if (FrameLength == 0 || FrameLength > TxRedirect->BufferSize) {
+        return 0;
+    }
+
+    Buffer = &Frame->Buffer;
+    Va = XdpGetVirtualAddressExtension(Buffer, VirtualAddressExtension);
+    RtlCopyMemory(Destination, Va->VirtualAddress + Buffer->DataOffset, Buffer->DataLength);
+    Destination += Buffer->DataLength;
+
+    for (UINT32 Index = 0; Index < FragmentCount; Index++) {
+        Buffer = XdpRingGetElement(FragmentRing, (FragmentIndex + Index) & FragmentRing->Mask);
+        Va = XdpGetVirtualAddressExtension(Buffer, VirtualAddressExtension);
+        RtlCopyMemory(Destination, Va->VirtualAddress + Buffer->DataOffset, Buffer->DataLength);
+        Destination += Buffer->DataLength;
+    }
+
+    return FrameLength;
+}
+
+static
+_IRQL_requires_(PASSIVE_LEVEL)
+VOID
+XdpTxRedirectNotifyWorker(
+    _In_ VOID *IoObject,
+    _In_opt_ VOID *Context,
+    _In_ IO_WORKITEM *IoWorkItem
+    )
+{
+    XDP_TX_REDIRECT *TxRedirect = Context;
+
+    UNREFERENCED_PARAMETER(IoObject);
+    UNREFERENCED_PARAMETER(IoWorkItem);
+    ASSERT(TxRedirect != NULL);
+
+    //
+    // Frames queued after this point require another notification.
+    //
+    InterlockedExchange(&TxRedirect->NotifyQueued, FALSE);
+
+    XdpTxQueueInvokeInterfaceNotify(TxRedirect->Queue, XDP_NOTIFY_QUEUE_FLAG_TX);
+
+    //
+    // Rundown protection was acquired when the work item was queued.
+    //
+    ExReleaseRundownProtection(&TxRedirect->NotifyRundown);
+}
+
+static
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+XdpTxRedirectQueueNotify(
+    _In_ XDP_TX_REDIRECT *TxRedirect
+    )
+{
+    //
+    // Interfaces are notified at PASSIVE_LEVEL, so defer the notification to a
+    // worker. At most one notification is queued.
+    //
+    if (InterlockedCompareExchange(&TxRedirect->NotifyQueued, TRUE, FALSE) == FALSE) {
+        if (ExAcquireRundownProtection(&TxRedirect->NotifyRundown)) {
+            IoQueueWorkItemEx(
+                TxRedirect->NotifyWorkItem, XdpTxRedirectNotifyWorker, DelayedWorkQueue,
+                TxRedirect);
+        } else {
+            InterlockedExchange(&TxRedirect->NotifyQueued, FALSE);
+        }
+    }
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+XdpTxRedirectReceive(
+    _In_ XDP_REDIRECT_BATCH *Batch
+    )
+{
+    XDP_TX_REDIRECT *TxRedirect = Batch->Target;
+    XDP_RING *FrameRing;
+    XDP_RING *FragmentRing;
+    XDP_EXTENSION *FragmentExtension;
+    XDP_EXTENSION *VirtualAddressExtension;
+    UINT32 Queued = 0;
+    BOOLEAN NeedNotify = FALSE;
+    KIRQL OldIrql;
+
+    XdpRxQueueGetFrameRings(
+        Batch->RxQueue, &FrameRing, &FragmentRing, &FragmentExtension, &VirtualAddressExtension);
+
+    KeAcquireSpinLock(&TxRedirect->Lock, &OldIrql);
+
+    if (!TxRedirect->Active) {
+        KeReleaseSpinLock(&TxRedirect->Lock, OldIrql);
+        return;
+    }
+
+    for (UINT32 Index = 0; Index < Batch->Count && TxRedirect->FreeCount > 0; Index++) {
+        XDP_FRAME *Frame = XdpRingGetElement(FrameRing, Batch->FrameIndexes[Index].FrameIndex);
+        XDP_TX_REDIRECT_PENDING_FRAME *Pending;
+        UINT32 BufferIndex = TxRedirect->FreeBuffers[TxRedirect->FreeCount - 1];
+        UINT32 FrameLength;
+
+        //
+        // Metadata preceding the frame is not transmitted.
+        //
+        FrameLength =
+            XdpTxRedirectCopyFrame(
+                TxRedirect, Frame, FragmentRing, FragmentExtension,
+                Batch->FrameIndexes[Index].FragmentIndex, VirtualAddressExtension,
+                TxRedirect->BufferMemory + (SIZE_T)BufferIndex * TxRedirect->BufferSize);
+        if (FrameLength == 0) {
+            continue;
+        }
+
+        TxRedirect->FreeCount--;
+        Pending =
+            &TxRedirect->PendingFrames[
+                TxRedirect->PendingProducerIndex & (XDP_TX_REDIRECT_BUFFER_COUNT - 1)];
+        Pending->BufferIndex = BufferIndex;
+        Pending->DataLength = FrameLength;
+
+        //
+        // The TX queue drains all pending frames it can, and is flushed again
+        // upon completion of any frames it cannot. It therefore only needs a
+        // notification when the pending ring becomes non-empty.
+        //
+        NeedNotify |= (TxRedirect->PendingProducerIndex == TxRedirect->PendingConsumerIndex);
+        TxRedirect->PendingProducerIndex++;
+        Queued++;
+    }
+
+    STAT_ADD(XdpTxQueueGetStats(TxRedirect->Queue), RedirectFramesQueued, Queued);
+    STAT_ADD(XdpTxQueueGetStats(TxRedirect->Queue), RedirectFramesDropped, Batch->Count - Queued);
+
+    KeReleaseSpinLock(&TxRedirect->Lock, OldIrql);
+
+    if (NeedNotify) {
+        XdpTxRedirectQueueNotify(TxRedirect);
+    }
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+UINT32
+XdpTxRedirectFillTx(
+    _In_ XDP_TX_QUEUE_DATAPATH_CLIENT_ENTRY *DatapathClientEntry,
+    _In_ UINT32 FrameQuota
+    )
+{
+    XDP_TX_REDIRECT *TxRedirect =
+        CONTAINING_RECORD(DatapathClientEntry, XDP_TX_REDIRECT, DatapathClientEntry);
+    XDP_RING *FrameRing = TxRedirect->FrameRing;
+    UINT32 Count;
+    KIRQL OldIrql;
+
+    KeAcquireSpinLock(&TxRedirect->Lock, &OldIrql);
+
+    if (!TxRedirect->Active) {
+        Count = 0;
+        goto Exit;
+    }
+
+    Count = min(FrameQuota, TxRedirect->PendingProducerIndex - TxRedirect->PendingConsumerIndex);
+
+    for (UINT32 Index = 0; Index < Count; Index++) {
+        XDP_TX_REDIRECT_PENDING_FRAME *Pending =
+            &TxRedirect->PendingFrames[
+                TxRedirect->PendingConsumerIndex++ & (XDP_TX_REDIRECT_BUFFER_COUNT - 1)];
+        XDP_FRAME *Frame =
+            XdpRingGetElement(FrameRing, FrameRing->ProducerIndex++ & FrameRing->Mask);
+        XDP_BUFFER *Buffer = &Frame->Buffer;
+        UINT32 BufferOffset = Pending->BufferIndex * TxRedirect->BufferSize;
+
+        Buffer->DataOffset = 0;
+        Buffer->DataLength = Pending->DataLength;
+        Buffer->BufferLength = TxRedirect->BufferSize;
+
+        if (TxRedirect->Flags.VirtualAddressExt) {
+            XdpGetVirtualAddressExtension(Buffer, &TxRedirect->VaExtension)->VirtualAddress =
+                TxRedirect->BufferMemory + BufferOffset;
+        }
+        if (TxRedirect->Flags.MdlExt) {
+            XDP_BUFFER_MDL *Mdl = XdpGetMdlExtension(Buffer, &TxRedirect->MdlExtension);
+            Mdl->Mdl = TxRedirect->BufferMdl;
+            Mdl->MdlOffset = BufferOffset;
+        }
+        if (TxRedirect->FragmentRing != NULL) {
+            XdpGetFragmentExtension(Frame, &TxRedirect->FragmentExtension)->FragmentBufferCount = 0;
+        }
+        if (TxRedirect->Flags.CompletionContext) {
+            XdpGetFrameTxCompletionContextExtension(
+                Frame, &TxRedirect->FrameTxCompletionExtension)->Context =
+                    &TxRedirect->DatapathClientEntry;
+        }
+
+        //
+        // Offloads enabled on the TX queue by other clients do not apply to
+        // redirected frames.
+        //
+        if (TxRedirect->Flags.LayoutExt) {
+            RtlZeroMemory(
+                XdpGetLayoutExtension(Frame, &TxRedirect->LayoutExtension),
+                sizeof(XDP_FRAME_LAYOUT));
+        }
+        if (TxRedirect->Flags.ChecksumExt) {
+            RtlZeroMemory(
+                XdpGetChecksumExtension(Frame, &TxRedirect->ChecksumExtension),
+                sizeof(XDP_FRAME_CHECKSUM));
+        }
+        if (TxRedirect->Flags.GsoExt) {
+            RtlZeroMemory(
+                XdpGetGsoExtension(Frame, &TxRedirect->GsoExtension), sizeof(XDP_FRAME_GSO));
+        }
+    }
+
+    TxRedirect->OutstandingFrames += Count;
+
+Exit:
+
+    KeReleaseSpinLock(&TxRedirect->Lock, OldIrql);
+
+    return Count;
+}
+
+static
+FORCEINLINE
+VOID
+XdpTxRedirectReturnBuffer(
+    _In_ XDP_TX_REDIRECT *TxRedirect,
+    _In_ UINT64 BufferOffset
+    )
+{
+    ASSERT(TxRedirect->FreeCount < XDP_TX_REDIRECT_BUFFER_COUNT);
+    TxRedirect->FreeBuffers[TxRedirect->FreeCount++] =
+        (UINT32)(BufferOffset / TxRedirect->BufferSize);
+}
+
+static
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+XdpTxRedirectCompleteRundown(
+    _In_opt_ VOID *Context
+    )
+{
+    XDP_TX_REDIRECT *TxRedirect = Context;
+    KIRQL OldIrql;
+
+    ASSERT(TxRedirect != NULL);
+
+    KeAcquireSpinLock(&TxRedirect->Lock, &OldIrql);
+    if (!TxRedirect->Active && TxRedirect->OutstandingFrames == 0) {
+        KeSetEvent(&TxRedirect->OutstandingFlushComplete, 0, FALSE);
+    }
+    KeReleaseSpinLock(&TxRedirect->Lock, OldIrql);
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+XdpTxRedirectFillTxCompletion(
+    _In_ XDP_TX_QUEUE_DATAPATH_CLIENT_ENTRY *DatapathClientEntry
+    )
+{
+    XDP_TX_REDIRECT *TxRedirect =
+        CONTAINING_RECORD(DatapathClientEntry, XDP_TX_REDIRECT, DatapathClientEntry);
+    UINT32 Count = 0;
+    KIRQL OldIrql;
+
+    KeAcquireSpinLock(&TxRedirect->Lock, &OldIrql);
+
+    if (TxRedirect->Flags.OutOfOrderCompletion) {
+        XDP_RING *XdpRing = TxRedirect->CompletionRing;
+        XDP_TX_FRAME_COMPLETION *Completion;
+
+        ASSERT(XdpRingCount(XdpRing) > 0);
+        do {
+            Completion = XdpRingGetElement(XdpRing, XdpRing->ConsumerIndex & XdpRing->Mask);
+
+            if (TxRedirect->Flags.CompletionContext &&
+                XdpGetTxCompletionContextExtension(
+                    Completion, &TxRedirect->TxCompletionExtension)->Context !=
+                        &TxRedirect->DatapathClientEntry) {
+                //
+                // We must have completed at least the first frame.
+                //
+                ASSERT(Count > 0);
+                break;
+            }
+
+            //
+            // The completion carries the buffer's virtual address, or its MDL
+            // offset if virtual addresses are not enabled.
+            //
+            XdpTxRedirectReturnBuffer(
+                TxRedirect,
+                TxRedirect->Flags.VirtualAddressExt ?
+                    Completion->BufferAddress - (UINT64)TxRedirect->BufferMemory :
+                    Completion->BufferAddress);
+            XdpRing->ConsumerIndex++;
+            Count++;
+        } while (XdpRingCount(XdpRing) > 0);
+    } else {
+        XDP_RING *XdpRing = TxRedirect->FrameRing;
+        XDP_FRAME *Frame;
+
+        ASSERT((XdpRing->ConsumerIndex - XdpRing->Reserved) > 0);
+        do {
+            Frame = XdpRingGetElement(XdpRing, XdpRing->Reserved & XdpRing->Mask);
+
+            if (TxRedirect->Flags.CompletionContext &&
+                XdpGetFrameTxCompletionContextExtension(
+                    Frame, &TxRedirect->FrameTxCompletionExtension)->Context !=
+                        &TxRedirect->DatapathClientEntry) {
+                //
+                // We must have completed at least the first frame.
+                //
+                ASSERT(Count > 0);
+                break;
+            }
+
+            if (TxRedirect->Flags.VirtualAddressExt) {
+                XdpTxRedirectReturnBuffer(
+                    TxRedirect,
+                    XdpGetVirtualAddressExtension(
+                        &Frame->Buffer, &TxRedirect->VaExtension)->VirtualAddress -
+                            TxRedirect->BufferMemory);
+            } else {
+                XdpTxRedirectReturnBuffer(
+                    TxRedirect,
+                    XdpGetMdlExtension(&Frame->Buffer, &TxRedirect->MdlExtension)->MdlOffset);
+            }
+
+            //
+            // Redirected frames never have fragment buffers.
+            //
+            XdpRing->Reserved++;
+            Count++;
+        } while ((XdpRing->ConsumerIndex - XdpRing->Reserved) > 0);
+    }
+
+    ASSERT(TxRedirect->OutstandingFrames >= Count);
+    TxRedirect->OutstandingFrames -= Count;
+
+    if (!TxRedirect->Active && TxRedirect->OutstandingFrames == 0) {
+        KeSetEvent(&TxRedirect->OutstandingFlushComplete, 0, FALSE);
+    }
+
+    KeReleaseSpinLock(&TxRedirect->Lock, OldIrql);
+}
+
+//
+// Control path routines.
+//
+
+static
+VOID
+XdpTxRedirectDetachTxIf(
+    _In_ XDP_TX_REDIRECT *TxRedirect
+    )
+{
+    KIRQL OldIrql;
+
+    TraceEnter(TRACE_CORE, "TxRedirect=%p", TxRedirect);
+
+    if (TxRedirect->Queue != NULL) {
+        //
+        // Stop accepting redirected frames and wait for queued and in-flight
+        // notifications, then wait for all outstanding TX frames to complete.
+        // If no frames are outstanding, an extra callback is required to
+        // compare the count to zero within the data path's execution context.
+        //
+        KeAcquireSpinLock(&TxRedirect->Lock, &OldIrql);
+        TxRedirect->Active = FALSE;
+        KeReleaseSpinLock(&TxRedirect->Lock, OldIrql);
+
+        ExWaitForRundownProtectionRelease(&TxRedirect->NotifyRundown);
+
+        if (TxRedirect->QueueInserted) {
+            XdpTxQueueSync(TxRedirect->Queue, XdpTxRedirectCompleteRundown, TxRedirect);
+            KeWaitForSingleObject(
+                &TxRedirect->OutstandingFlushComplete, Executive, KernelMode, FALSE, NULL);
+            ASSERT(TxRedirect->OutstandingFrames == 0);
+
+            XdpTxQueueRemoveDatapathClient(TxRedirect->Queue, &TxRedirect->DatapathClientEntry);
+            TxRedirect->QueueInserted = FALSE;
+        }
+
+        XdpTxQueueDeregisterNotifications(
+            TxRedirect->Queue, &TxRedirect->QueueNotificationEntry);
+        XdpTxQueueDereference(TxRedirect->Queue);
+        TxRedirect->Queue = NULL;
+    }
+
+    if (TxRedirect->IfHandle != NULL) {
+        XdpIfDereferenceBinding(TxRedirect->IfHandle);
+
+        //
+        // Synchronize with non-binding-workers while clearing the interface
+        // handle.
+        //
+        KeAcquireSpinLock(&TxRedirect->Lock, &OldIrql);
+        TxRedirect->IfHandle = NULL;
+        KeReleaseSpinLock(&TxRedirect->Lock, OldIrql);
+    }
+
+    TraceExitSuccess(TRACE_CORE);
+}
+
+static
+VOID
+XdpTxRedirectNotifyTxQueue(
+    _In_ XDP_TX_QUEUE_NOTIFICATION_ENTRY *NotificationEntry,
+    _In_ XDP_TX_QUEUE_NOTIFICATION_TYPE NotificationType
+    )
+{
+    XDP_TX_REDIRECT *TxRedirect =
+        CONTAINING_RECORD(NotificationEntry, XDP_TX_REDIRECT, QueueNotificationEntry);
+
+    if (NotificationType == XDP_TX_QUEUE_NOTIFICATION_DETACH) {
+        //
+        // This detach event is executing in the context of XDP binding work
+        // queue processing on the TX queue, so it is synchronized with the
+        // other detach instances. Subsequently redirected frames are dropped.
+        //
+        XdpTxRedirectDetachTxIf(TxRedirect);
+    }
+}
+
+static
+VOID
+XdpTxRedirectFree(
+    _In_ XDP_TX_REDIRECT *TxRedirect
+    )
+{
+    ASSERT(TxRedirect->Queue == NULL);
+    ASSERT(TxRedirect->IfHandle == NULL);
+
+    if (TxRedirect->NotifyWorkItem != NULL) {
+        IoUninitializeWorkItem(TxRedirect->NotifyWorkItem);
+        ExFreePoolWithTag(TxRedirect->NotifyWorkItem, XDP_POOLTAG_TX_REDIRECT);
+    }
+    if (TxRedirect->BufferMdl != NULL) {
+        IoFreeMdl(TxRedirect->BufferMdl);
+    }
+    if (TxRedirect->BufferMemory != NULL) {
+        ExFreePoolWithTag(TxRedirect->BufferMemory, XDP_POOLTAG_TX_REDIRECT);
+    }
+    ExFreePoolWithTag(TxRedirect, XDP_POOLTAG_TX_REDIRECT);
+}
+
+static
+VOID
+XdpTxRedirectDeleteWorker(
+    _In_ XDP_BINDING_WORKITEM *Item
+    )
+{
+    XDP_TX_REDIRECT *TxRedirect = CONTAINING_RECORD(Item, XDP_TX_REDIRECT, DeleteWorkItem);
+
+    XdpTxRedirectDetachTxIf(TxRedirect);
+    XdpTxRedirectFree(TxRedirect);
+}
+
+static
+NTSTATUS
+XdpTxRedirectAllocateBuffers(
+    _In_ XDP_TX_REDIRECT *TxRedirect
+    )
+{
+    const XDP_TX_CAPABILITIES *InterfaceCapabilities;
+    UINT32 PoolSize;
+    NTSTATUS Status;
+
+    InterfaceCapabilities = XdpTxQueueGetCapabilities(TxRedirect->Queue);
+    TxRedirect->BufferSize =
+        min(XDP_TX_REDIRECT_BUFFER_SIZE,
+            min(InterfaceCapabilities->MaximumBufferSize,
+                InterfaceCapabilities->MaximumFrameSize));
+    if (TxRedirect->BufferSize == 0) {
+        Status = STATUS_NOT_SUPPORTED;
+        goto Exit;
+    }
+
+    PoolSize = TxRedirect->BufferSize * XDP_TX_REDIRECT_BUFFER_COUNT;
+    TxRedirect->BufferMemory =
+        ExAllocatePoolZero(NonPagedPoolNx, PoolSize, XDP_POOLTAG_TX_REDIRECT);
+    if (TxRedirect->BufferMemory == NULL) {
+        Status = STATUS_NO_MEMORY;
+        goto Exit;
+    }
+
+    TxRedirect->BufferMdl = IoAllocateMdl(TxRedirect->BufferMemory, PoolSize, FALSE, FALSE, NULL);
+    if (TxRedirect->BufferMdl == NULL) {
+        Status = STATUS_NO_MEMORY;
+        goto Exit;
+    }
+
+    MmBuildMdlForNonPagedPool(TxRedirect->BufferMdl);
+
+    for (UINT32 Index = 0; Index < XDP_TX_REDIRECT_BUFFER_COUNT; Index++) {
+        TxRedirect->FreeBuffers[Index] = XDP_TX_REDIRECT_BUFFER_COUNT - 1 - Index;
+    }
+    TxRedirect->FreeCount = XDP_TX_REDIRECT_BUFFER_COUNT;
+
+    Status = STATUS_SUCCESS;
+
+Exit:
+
+    return Status;
+}
+
+static
+VOID
+XdpTxRedirectBindTxIf(
+    _In_ XDP_BINDING_WORKITEM *Item
+    )
+{
+    XDP_TX_REDIRECT_WORKITEM *WorkItem = (XDP_TX_REDIRECT_WORKITEM *)Item;
+    XDP_TX_REDIRECT *TxRedirect = WorkItem->TxRedirect;
+    XDP_TX_QUEUE_CONFIG_ACTIVATE Config;
+    XDP_EXTENSION_INFO ExtensionInfo;
+    KIRQL OldIrql;
+    NTSTATUS Status;
+
+    TraceEnter(TRACE_CORE, "TxRedirect=%p", TxRedirect);
+
+    ASSERT(TxRedirect->IfHandle == NULL);
+    TxRedirect->IfHandle = WorkItem->IfWorkItem.BindingHandle;
+
+    Status =
+        XdpTxQueueFindOrCreate(
+            TxRedirect->IfHandle, &TxRedirect->HookId, TxRedirect->QueueId, &TxRedirect->Queue);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    XdpTxQueueRegisterNotifications(
+        TxRedirect->Queue, &TxRedirect->QueueNotificationEntry, XdpTxRedirectNotifyTxQueue);
+
+    Status = XdpTxQueueActivate(TxRedirect->Queue);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    Config = XdpTxQueueGetConfig(TxRedirect->Queue);
+    TxRedirect->Flags.OutOfOrderCompletion = XdpTxQueueIsOutOfOrderCompletionEnabled(Config);
+    TxRedirect->Flags.CompletionContext = XdpTxQueueIsTxCompletionContextEnabled(Config);
+    TxRedirect->Flags.VirtualAddressExt = XdpTxQueueIsVirtualAddressEnabled(Config);
+    TxRedirect->Flags.MdlExt = XdpTxQueueIsMdlEnabled(Config);
+    TxRedirect->FrameRing = XdpTxQueueGetFrameRing(Config);
+
+    if (!TxRedirect->Flags.VirtualAddressExt && !TxRedirect->Flags.MdlExt) {
+        //
+        // Interfaces supporting only logical addresses are not supported.
+        //
+        Status = STATUS_NOT_SUPPORTED;
+        goto Exit;
+    }
+
+    if (XdpTxQueueIsFragmentationEnabled(Config)) {
+        TxRedirect->FragmentRing = XdpTxQueueGetFragmentRing(Config);
+
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_FRAGMENT_NAME,
+            XDP_FRAME_EXTENSION_FRAGMENT_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        XdpTxQueueGetExtension(Config, &ExtensionInfo, &TxRedirect->FragmentExtension);
+    }
+
+    if (TxRedirect->Flags.CompletionContext) {
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_TX_FRAME_COMPLETION_CONTEXT_EXTENSION_NAME,
+            XDP_TX_FRAME_COMPLETION_CONTEXT_EXTENSION_VERSION_1,
+            XDP_EXTENSION_TYPE_FRAME);
+        XdpTxQueueGetExtension(Config, &ExtensionInfo, &TxRedirect->FrameTxCompletionExtension);
+    }
+
+    if (TxRedirect->Flags.OutOfOrderCompletion) {
+        TxRedirect->CompletionRing = XdpTxQueueGetCompletionRing(Config);
+
+        if (TxRedirect->Flags.CompletionContext) {
+            XdpInitializeExtensionInfo(
+                &ExtensionInfo, XDP_TX_FRAME_COMPLETION_CONTEXT_EXTENSION_NAME,
+                XDP_TX_FRAME_COMPLETION_CONTEXT_EXTENSION_VERSION_1,
+                XDP_EXTENSION_TYPE_TX_FRAME_COMPLETION);
+            XdpTxQueueGetExtension(Config, &ExtensionInfo, &TxRedirect->TxCompletionExtension);
+        }
+    }
+
+    if (TxRedirect->Flags.VirtualAddressExt) {
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_BUFFER_EXTENSION_VIRTUAL_ADDRESS_NAME,
+            XDP_BUFFER_EXTENSION_VIRTUAL_ADDRESS_VERSION_1, XDP_EXTENSION_TYPE_BUFFER);
+        XdpTxQueueGetExtension(Config, &ExtensionInfo, &TxRedirect->VaExtension);
+    }
+
+    if (TxRedirect->Flags.MdlExt) {
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_BUFFER_EXTENSION_MDL_NAME,
+            XDP_BUFFER_EXTENSION_MDL_VERSION_1, XDP_EXTENSION_TYPE_BUFFER);
+        XdpTxQueueGetExtension(Config, &ExtensionInfo, &TxRedirect->MdlExtension);
+    }
+
+    TxRedirect->Flags.LayoutExt = XdpTxQueueIsLayoutExtensionEnabled(Config);
+    if (TxRedirect->Flags.LayoutExt) {
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_LAYOUT_NAME,
+            XDP_FRAME_EXTENSION_LAYOUT_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        XdpTxQueueGetExtension(Config, &ExtensionInfo, &TxRedirect->LayoutExtension);
+    }
+
+    TxRedirect->Flags.ChecksumExt = XdpTxQueueIsChecksumOffloadEnabled(Config);
+    if (TxRedirect->Flags.ChecksumExt) {
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_CHECKSUM_NAME,
+            XDP_FRAME_EXTENSION_CHECKSUM_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        XdpTxQueueGetExtension(Config, &ExtensionInfo, &TxRedirect->ChecksumExtension);
+    }
+
+    TxRedirect->Flags.GsoExt = XdpTxQueueIsSegmentationOffloadEnabled(Config);
+    if (TxRedirect->Flags.GsoExt) {
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_GSO_NAME,
+            XDP_FRAME_EXTENSION_GSO_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        XdpTxQueueGetExtension(Config, &ExtensionInfo, &TxRedirect->GsoExtension);
+    }
+
+    Status = XdpTxRedirectAllocateBuffers(TxRedirect);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    KeAcquireSpinLock(&TxRedirect->Lock, &OldIrql);
+    TxRedirect->Active = TRUE;
+    KeReleaseSpinLock(&TxRedirect->Lock, OldIrql);
+
+    Status =
+        XdpTxQueueAddDatapathClient(
+            TxRedirect->Queue, &TxRedirect->DatapathClientEntry,
+            XDP_TX_QUEUE_DATAPATH_CLIENT_TYPE_REDIRECT);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    TxRedirect->QueueInserted = TRUE;
+
+Exit:
+
+    if (!NT_SUCCESS(Status)) {
+        XdpTxRedirectDetachTxIf(TxRedirect);
+    }
+
+    TraceExitStatus(TRACE_CORE);
+
+    WorkItem->CompletionStatus = Status;
+    KeSetEvent(&WorkItem->CompletionEvent, 0, FALSE);
+}
+
+_IRQL_requires_(PASSIVE_LEVEL)
+NTSTATUS
+XdpTxRedirectCreate(
+    _In_ UINT32 IfIndex,
+    _In_ UINT32 QueueId,
+    _Out_ XDP_TX_REDIRECT **TxRedirect
+    )
+{
+    XDP_TX_REDIRECT *NewTxRedirect;
+    XDP_TX_REDIRECT_WORKITEM WorkItem = {0};
+    NTSTATUS Status;
+
+    TraceEnter(TRACE_CORE, "IfIndex=%u QueueId=%u", IfIndex, QueueId);
+
+    NewTxRedirect =
+        ExAllocatePoolZero(NonPagedPoolNx, sizeof(*NewTxRedirect), XDP_POOLTAG_TX_REDIRECT);
+    if (NewTxRedirect == NULL) {
+        Status = STATUS_NO_MEMORY;
+        goto Exit;
+    }
+
+    XdpInitializeReferenceCount(&NewTxRedirect->ReferenceCount);
+    NewTxRedirect->IfIndex = IfIndex;
+    NewTxRedirect->QueueId = QueueId;
+    NewTxRedirect->HookId.Layer = XDP_HOOK_L2;
+    NewTxRedirect->HookId.Direction = XDP_HOOK_TX;
+    NewTxRedirect->HookId.SubLayer = XDP_HOOK_INJECT;
+    KeInitializeSpinLock(&NewTxRedirect->Lock);
+    ExInitializeRundownProtection(&NewTxRedirect->NotifyRundown);
+    KeInitializeEvent(&NewTxRedirect->OutstandingFlushComplete, NotificationEvent, FALSE);
+    InitializeListHead(&NewTxRedirect->DatapathClientEntry.Link);
+
+    NewTxRedirect->NotifyWorkItem =
+        ExAllocatePoolZero(NonPagedPoolNx, IoSizeofWorkItem(), XDP_POOLTAG_TX_REDIRECT);
+    if (NewTxRedirect->NotifyWorkItem == NULL) {
+        Status = STATUS_NO_MEMORY;
+        goto Exit;
+    }
+    IoInitializeWorkItem(XdpDriverObject, NewTxRedirect->NotifyWorkItem);
+
+    //
+    // The target interface may differ from the interface of the program, so
+    // queue the bind to the target interface's binding work queue and wait for
+    // it to complete.
+    //
+    KeInitializeEvent(&WorkItem.CompletionEvent, NotificationEvent, FALSE);
+    WorkItem.TxRedirect = NewTxRedirect;
+    WorkItem.IfWorkItem.WorkRoutine = XdpTxRedirectBindTxIf;
+    WorkItem.IfWorkItem.BindingHandle =
+        XdpIfFindAndReferenceBinding(IfIndex, &NewTxRedirect->HookId, 1, NULL);
+    if (WorkItem.IfWorkItem.BindingHandle == NULL) {
+        Status = STATUS_NOT_FOUND;
+        goto Exit;
+    }
+
+    XdpIfQueueWorkItem(&WorkItem.IfWorkItem);
+
+    KeWaitForSingleObject(&WorkItem.CompletionEvent, Executive, KernelMode, FALSE, NULL);
+    Status = WorkItem.CompletionStatus;
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    *TxRedirect = NewTxRedirect;
+    NewTxRedirect = NULL;
+
+Exit:
+
+    if (NewTxRedirect != NULL) {
+        //
+        // The bind worker detaches upon failure.
+        //
+        XdpTxRedirectFree(NewTxRedirect);
+    }
+
+    TraceExitStatus(TRACE_CORE);
+
+    return Status;
+}
+
+VOID
+XdpTxRedirectDereference(
+    _In_ XDP_TX_REDIRECT *TxRedirect
+    )
+{
+    KIRQL OldIrql;
+
+    if (XdpDecrementReferenceCount(&TxRedirect->ReferenceCount)) {
+        TraceVerbose(TRACE_CORE, "TxRedirect=%p deleting", TxRedirect);
+
+        //
+        // If still attached, detach on the TX queue's binding work queue and
+        // free the object asynchronously: the caller may itself be executing
+        // on a binding work queue.
+        //
+        KeAcquireSpinLock(&TxRedirect->Lock, &OldIrql);
+
+        if (TxRedirect->IfHandle != NULL) {
+            TxRedirect->DeleteWorkItem.WorkRoutine = XdpTxRedirectDeleteWorker;
+            TxRedirect->DeleteWorkItem.BindingHandle = TxRedirect->IfHandle;
+            XdpIfQueueWorkItem(&TxRedirect->DeleteWorkItem);
+
+            KeReleaseSpinLock(&TxRedirect->Lock, OldIrql);
+        } else {
+            KeReleaseSpinLock(&TxRedirect->Lock, OldIrql);
+            XdpTxRedirectFree(TxRedirect);
+        }
+    }
+}
@@ -0,0 +1,48 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+#pragma once
+
+typedef struct _XDP_TX_REDIRECT XDP_TX_REDIRECT;
+
+//
+// Data path routines.
+//
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+XdpTxRedirectReceive(
+    _In_ XDP_REDIRECT_BATCH *Batch
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+UINT32
+XdpTxRedirectFillTx(
+    _In_ XDP_TX_QUEUE_DATAPATH_CLIENT_ENTRY *DatapathClientEntry,
+    _In_ UINT32 FrameQuota
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+XdpTxRedirectFillTxCompletion(
+    _In_ XDP_TX_QUEUE_DATAPATH_CLIENT_ENTRY *DatapathClientEntry
+    );
+
+//
+// Control path routines.
+//
+
+_IRQL_requires_(PASSIVE_LEVEL)
+NTSTATUS
+XdpTxRedirectCreate(
+    _In_ UINT32 IfIndex,
+    _In_ UINT32 QueueId,
+    _Out_ XDP_TX_REDIRECT **TxRedirect
+    );
+
+VOID
+XdpTxRedirectDereference(
+    _In_ XDP_TX_REDIRECT *TxRedirect
+    );
@@ -28,7 +28,9 @@
 #define XDP_POOLTAG_PROGRAM             'PpdX' // XdpP
 #define XDP_POOLTAG_PROGRAM_OBJECT      'OpdX' // XdpO
 #define XDP_POOLTAG_PROGRAM_BINDING     'bPdX' // XdPb
+#define XDP_POOLTAG_RATE_LIMIT          'LpdX' // XdpL
 #define XDP_POOLTAG_RING                'rpdX' // Xdpr
 #define XDP_POOLTAG_RXQUEUE             'RpdX' // XdpR
 #define XDP_POOLTAG_TXQUEUE             'TpdX' // XdpT
+#define XDP_POOLTAG_TX_REDIRECT         'tpdX' // Xdpt
 #define XDP_POOLTAG_PROGRAM_CONTEXT     'cpdX' // Xdpc
@@ -86,6 +86,7 @@ typedef struct _XSK_RX_XDP {
     XDP_EXTENSION LayoutExtension;
     XDP_EXTENSION ChecksumExtension;
     XDP_EXTENSION TimestampExtension;
+    XDP_EXTENSION GroExtension;
     NDIS_POLL_BACKCHANNEL *PollHandle;
     struct {
         UINT8 NotificationsRegistered : 1;
@@ -111,16 +112,20 @@ typedef struct _XSK_RX {
             UINT8 Checksum : 1;
             UINT8 OriginalLength : 1;
             UINT8 Timestamp : 1;
+            UINT8 Gro : 1;
         };
         UINT8 Value;
     } ExtensionFlags;
     struct {
         BOOLEAN Activated : 1;
+        BOOLEAN ZeroCopy : 1;
+        BOOLEAN MultiBuffer : 1;
     } Flags;
     UINT16 LayoutExtensionOffset;
     UINT16 ChecksumExtensionOffset;
     UINT16 OriginalLengthExtensionOffset;
     UINT16 TimestampExtensionOffset;
+    UINT16 GroExtensionOffset;
     XDP_EXTENSION_SET *FrameExtensionSet;
     union {
         struct {
@@ -128,6 +133,13 @@ typedef struct _XSK_RX {
         };
         UINT8 Value;
     } OffloadChangeFlags;
+    //
+    // In zero-copy mode, the UMEM address (plus one) of the buffer posted to
+    // the interface in each chunk-sized slot of the UMEM, or zero if none.
+    // Posted buffers span a whole chunk, so at most one is posted per slot.
+    //
+    UINT64 *PostedChunks;
+    UINT32 PostedChunkCount;
 } XSK_RX;
 
 typedef struct _XSK_TX_XDP {
@@ -135,18 +147,29 @@ typedef struct _XSK_TX_XDP {
     // XDP data path fields.
     //
     XDP_RING *FrameRing;
+    XDP_RING *FragmentRing;
     XDP_RING *CompletionRing;
     XDP_EXTENSION VaExtension;
     XDP_EXTENSION LaExtension;
     XDP_EXTENSION MdlExtension;
+    XDP_EXTENSION FragmentExtension;
     XDP_EXTENSION FrameTxCompletionExtension;
     XDP_EXTENSION TxCompletionExtension;
     XDP_EXTENSION LayoutExtension;
     XDP_EXTENSION ChecksumExtension;
+    XDP_EXTENSION GsoExtension;
     XDP_EXTENSION TimestampCompletionExtension;
+    //
+    // Number of XSK TX completions owed to the application: one per buffer.
+    //
     UINT32 OutstandingFrames;
     UINT32 MaxBufferLength;
     UINT32 MaxFrameLength;
+    UINT8 MaxFragments;
+    //
+    // Set while dropping the remaining descriptors of an oversized chain.
+    //
+    BOOLEAN DiscardChain;
     struct {
         BOOLEAN VirtualAddressExt : 1;
         BOOLEAN LogicalAddressExt : 1;
@@ -175,12 +198,19 @@ typedef struct _XSK_TX {
     //
     XSK_KERNEL_RING Ring;
     XSK_KERNEL_RING CompletionRing;
+    //
+    // This socket's view of the UMEM. The UMEM may be shared with other
+    // sockets, so the DMA mapping for this socket's TX queue is kept here
+    // rather than in the UMEM.
+    //
+    UMEM_MAPPING UmemMapping;
     UMEM_BOUNCE Bounce;
     XSK_TX_XDP Xdp;
     union {
         struct {
             UINT8 Checksum : 1;
             UINT8 Timestamp : 1;
+            UINT8 Gso : 1;
         };
         UINT8 Value;
     } OffloadFlags;
@@ -189,6 +219,7 @@ typedef struct _XSK_TX {
     } Flags;
     UINT16 LayoutExtensionOffset;
     UINT16 ChecksumExtensionOffset;
+    UINT16 GsoExtensionOffset;
     UINT16 TimestampCompletionExtensionOffset;
 
     //
@@ -205,6 +236,30 @@ typedef struct _XSK_TX {
     } OffloadChangeFlags;
 } XSK_TX;
 
+typedef struct _XSK_NOTIFY_SET XSK_NOTIFY_SET;
+
+typedef struct _XSK_NOTIFY_SET_MEMBER {
+    LIST_ENTRY Link;
+    XSK_NOTIFY_SET *NotifySet;
+    FILE_OBJECT *FileObject;
+    struct _XSK *Xsk;
+    UINT32 Flags;
+    VOID *Context;
+} XSK_NOTIFY_SET_MEMBER;
+
+typedef struct _XSK_NOTIFY_SET {
+    XDP_FILE_OBJECT_HEADER Header;
+    EX_PUSH_LOCK Lock;
+    LIST_ENTRY Members;
+    BOOLEAN WaitActive;
+    BOOLEAN Closing;
+
+    //
+    // Signaled by any member socket whose armed wait condition is satisfied.
+    //
+    KEVENT Event;
+} XSK_NOTIFY_SET;
+
 typedef struct _XSK {
     XDP_FILE_OBJECT_HEADER Header;
     XDP_REFERENCE_COUNT ReferenceCount;
@@ -218,12 +273,32 @@ typedef struct _XSK {
     XSK_IO_WAIT_FLAGS IoWaitInternalFlags;
     KEVENT IoWaitEvent;
     IRP *IoWaitIrp;
+
+    //
+    // The notification set this socket belongs to, if any, and the wait flags
+    // armed by a wait in progress on that set. Protected by Lock.
+    //
+    XSK_NOTIFY_SET_MEMBER *NotifySetMember;
+    UINT32 NotifySetWaitFlags;
     XSK_STATISTICS Statistics;
     EX_PUSH_LOCK PollLock;
     XSK_POLL_MODE PollMode;
     BOOLEAN PollBusy;
     ULONG PollWaiters;
     KEVENT PollRequested;
+
+    //
+    // Adaptive poll mode state. Protected by PollLock, except Idle, which is
+    // read by the RX data path.
+    //
+    struct {
+        XDP_TIMER *IdleTimer;
+        IO_WORKITEM *ResumeWorkItem;
+        UINT32 IdleTimeoutMs;
+        UINT32 LastActivity;
+        BOOLEAN Idle;
+        LONG ResumeQueued;
+    } AdaptivePoll;
     KPROCESSOR_MODE CreatorMode;
 } XSK;
 
@@ -249,10 +324,13 @@ XskPoke(
     );
 
 #define POOLTAG_BOUNCE 'BksX' // XskB
+#define POOLTAG_NOTIFY 'NksX' // XskN
 #define POOLTAG_RING   'RksX' // XskR
 #define POOLTAG_UMEM   'UksX' // XskU
 #define POOLTAG_XSK    'kksX' // Xskk
 
+#define XSK_ADAPTIVE_POLL_DEFAULT_IDLE_TIMEOUT_MS 10
+
 static XSK_GLOBALS XskGlobals;
 static XDP_REG_WATCHER_CLIENT_ENTRY XskRegWatcherEntry;
 static XDP_FILE_IRP_ROUTINE XskIrpDeviceIoControl;
@@ -264,6 +342,15 @@ static XDP_FILE_DISPATCH XskFileDispatch = {
     .Close      = XskIrpClose,
 };
 
+static XDP_FILE_IRP_ROUTINE XskNotifySetIrpDeviceIoControl;
+static XDP_FILE_IRP_ROUTINE XskNotifySetIrpCleanup;
+static XDP_FILE_IRP_ROUTINE XskNotifySetIrpClose;
+static XDP_FILE_DISPATCH XskNotifySetFileDispatch = {
+    .IoControl  = XskNotifySetIrpDeviceIoControl,
+    .Cleanup    = XskNotifySetIrpCleanup,
+    .Close      = XskNotifySetIrpClose,
+};
+
 static const XDP_EXTENSION_REGISTRATION XskTxFrameExtensions[] = {
     {
         .Info.ExtensionName     = XDP_FRAME_EXTENSION_LAYOUT_NAME,
@@ -281,6 +368,14 @@ static const XDP_EXTENSION_REGISTRATION XskTxFrameExtensions[] = {
         .Alignment              = __alignof(XDP_FRAME_CHECKSUM),
         .InternalExtension      = TRUE,
     },
+    {
+        .Info.ExtensionName     = XDP_FRAME_EXTENSION_GSO_NAME,
+        .Info.ExtensionVersion  = XDP_FRAME_EXTENSION_GSO_VERSION_1,
+        .Info.ExtensionType     = XDP_EXTENSION_TYPE_FRAME,
+        .Size                   = sizeof(XDP_FRAME_GSO),
+        .Alignment              = __alignof(XDP_FRAME_GSO),
+        .InternalExtension      = TRUE,
+    },
 };
 
 static const XDP_EXTENSION_REGISTRATION XskTxCompletionExtensions[] = {
@@ -327,6 +422,14 @@ static const XDP_EXTENSION_REGISTRATION XskRxFrameExtensions[] = {
         .Alignment              = __alignof(XDP_FRAME_TIMESTAMP),
         .InternalExtension      = TRUE,
     },
+    {
+        .Info.ExtensionName     = XDP_FRAME_EXTENSION_GRO_NAME,
+        .Info.ExtensionVersion  = XDP_FRAME_EXTENSION_GRO_VERSION_1,
+        .Info.ExtensionType     = XDP_EXTENSION_TYPE_FRAME,
+        .Size                   = sizeof(XDP_FRAME_GRO),
+        .Alignment              = __alignof(XDP_FRAME_GRO),
+        .InternalExtension      = TRUE,
+    },
 };
 
 static
@@ -351,6 +454,13 @@ XskDereference(
     )
 {
     if (XdpDecrementReferenceCount(&Xsk->ReferenceCount)) {
+        if (Xsk->AdaptivePoll.ResumeWorkItem != NULL) {
+            IoUninitializeWorkItem(Xsk->AdaptivePoll.ResumeWorkItem);
+            ExFreePoolWithTag(Xsk->AdaptivePoll.ResumeWorkItem, POOLTAG_XSK);
+        }
+        if (Xsk->Rx.PostedChunks != NULL) {
+            ExFreePoolWithTag(Xsk->Rx.PostedChunks, POOLTAG_XSK);
+        }
         ExFreePoolWithTag(Xsk, POOLTAG_XSK);
     }
 }
@@ -393,6 +503,15 @@ XskSignalReadyIo(
     ASSERT((ReadyFlags & (XSK_NOTIFY_FLAG_WAIT_RX | XSK_NOTIFY_FLAG_WAIT_TX)) == ReadyFlags);
 
     KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
+    if ((Xsk->NotifySetWaitFlags & ReadyFlags) != 0) {
+        //
+        // Wake the notification set waiter. Only the first ready socket needs
+        // to signal the set, so disarm this socket until the next wait.
+        //
+        ASSERT(Xsk->NotifySetMember != NULL);
+        Xsk->NotifySetWaitFlags = 0;
+        (VOID)KeSetEvent(&Xsk->NotifySetMember->NotifySet->Event, IO_NETWORK_INCREMENT, FALSE);
+    }
     if ((Xsk->IoWaitFlags & ReadyFlags) != 0) {
         if (Xsk->IoWaitIrp != NULL) {
             Irp = Xsk->IoWaitIrp;
@@ -420,6 +539,26 @@ XskSignalReadyIo(
     }
 }
 
+static
+FORCEINLINE
+BOOLEAN
+XskHasReadyIoWaiter(
+    _In_ XSK *Xsk,
+    _In_ UINT32 ReadyFlag
+    )
+{
+    //
+    // Checks, without acquiring the socket lock, whether a socket wait or a
+    // notification set wait may need to be satisfied by newly produced IO.
+    //
+    if ((ReadUInt32Acquire(&Xsk->IoWaitFlags) & ReadyFlag) &&
+        (KeReadStateEvent(&Xsk->IoWaitEvent) == 0 || Xsk->IoWaitIrp != NULL)) {
+        return TRUE;
+    }
+
+    return (ReadUInt32Acquire(&Xsk->NotifySetWaitFlags) & ReadyFlag) != 0;
+}
+
 static
 UINT32
 XskRingProdReserve(
@@ -558,7 +697,7 @@ XskGetTxMapping(
 {
     return
         (Xsk->Tx.Bounce.Tracker != NULL)
-            ? &Xsk->Tx.Bounce.Mapping : &Xsk->Umem->Mapping;
+            ? &Xsk->Tx.Bounce.Mapping : &Xsk->Tx.UmemMapping;
 }
 
 static
@@ -604,6 +743,7 @@ _Success_(return != FALSE)
 BOOLEAN
 XskBounceBuffer(
     _In_ UMEM *Umem,
+    _In_ UMEM_MAPPING *UmemMapping,
     _In_ UMEM_BOUNCE *Bounce,
     _In_ XDP_BUFFER *Buffer,
     _In_ UINT64 RelativeAddress,
@@ -616,7 +756,7 @@ XskBounceBuffer(
         //
         // No bounce is required.
         //
-        *Mapping = &Umem->Mapping;
+        *Mapping = UmemMapping;
         return TRUE;
     }
 
@@ -758,6 +898,125 @@ XskGetAvailableTxCompletion(
     return XskCompletionAvailable - Xsk->Tx.Xdp.OutstandingFrames;
 }
 
+static
+FORCEINLINE
+UINT64
+XskGetTxBufferRelativeAddress(
+    _In_ XSK *Xsk,
+    _In_ XDP_BUFFER *Buffer,
+    _In_ UMEM_MAPPING *Mapping
+    )
+{
+    if (Xsk->Tx.Xdp.Flags.VirtualAddressExt) {
+        XDP_BUFFER_VIRTUAL_ADDRESS *Va;
+        Va = XdpGetVirtualAddressExtension(Buffer, &Xsk->Tx.Xdp.VaExtension);
+        return Va->VirtualAddress - Mapping->SystemAddress;
+    } else if (Xsk->Tx.Xdp.Flags.LogicalAddressExt) {
+        XDP_BUFFER_LOGICAL_ADDRESS *La;
+        La = XdpGetLogicalAddressExtension(Buffer, &Xsk->Tx.Xdp.LaExtension);
+        return La->LogicalAddress - Mapping->DmaAddress.QuadPart;
+    } else if (Xsk->Tx.Xdp.Flags.MdlExt) {
+        XDP_BUFFER_MDL *Mdl;
+        Mdl = XdpGetMdlExtension(Buffer, &Xsk->Tx.Xdp.MdlExtension);
+        return Mdl->MdlOffset;
+    } else {
+        //
+        // One of the above extensions must have be enabled.
+        //
+        ASSERT(FALSE);
+        return 0;
+    }
+}
+
+static
+FORCEINLINE
+VOID
+XskTxInvalidDescriptors(
+    _In_ XSK *Xsk,
+    _In_ UINT32 Count
+    )
+{
+    Xsk->Statistics.TxInvalidDescriptors += Count;
+    STAT_ADD(XdpTxQueueGetStats(Xsk->Tx.Xdp.Queue), XskInvalidDescriptors, Count);
+}
+
+static
+FORCEINLINE
+BOOLEAN
+XskFillTxBuffer(
+    _In_ XSK *Xsk,
+    _In_ XSK_BUFFER_DESCRIPTOR *XskBuffer,
+    _Inout_ XDP_BUFFER *Buffer
+    )
+{
+    NTSTATUS Status;
+    ULONGLONG Result;
+    XSK_BUFFER_ADDRESS AddressDescriptor;
+    UMEM_MAPPING *Mapping;
+
+    AddressDescriptor.AddressAndOffset =
+        ReadUInt64NoFence(&XskBuffer->Address.AddressAndOffset);
+    Buffer->DataOffset = (UINT32)AddressDescriptor.Offset;
+    Buffer->DataLength = ReadUInt32NoFence(&XskBuffer->Length);
+    Buffer->BufferLength = Buffer->DataLength + Buffer->DataOffset;
+
+    Status = RtlUInt64Add(AddressDescriptor.BaseAddress, Buffer->DataLength, &Result);
+    Status |= RtlUInt64Add(Buffer->DataOffset, Result, &Result);
+    if (Result > Xsk->Umem->Reg.TotalSize ||
+        Buffer->DataLength == 0 ||
+        Status != STATUS_SUCCESS) {
+        return FALSE;
+    }
+
+    if (Buffer->DataLength > Xsk->Tx.Xdp.MaxBufferLength) {
+        return FALSE;
+    }
+
+    if (!XskBounceBuffer(
+            Xsk->Umem, &Xsk->Tx.UmemMapping, &Xsk->Tx.Bounce, Buffer,
+            AddressDescriptor.BaseAddress, &Mapping)) {
+        return FALSE;
+    }
+
+    if (Xsk->Tx.Xdp.Flags.VirtualAddressExt) {
+        XDP_BUFFER_VIRTUAL_ADDRESS *Va;
+        Va = XdpGetVirtualAddressExtension(Buffer, &Xsk->Tx.Xdp.VaExtension);
+        Va->VirtualAddress = &Mapping->SystemAddress[AddressDescriptor.BaseAddress];
+    }
+    if (Xsk->Tx.Xdp.Flags.LogicalAddressExt) {
+        XDP_BUFFER_LOGICAL_ADDRESS *La;
+        La = XdpGetLogicalAddressExtension(Buffer, &Xsk->Tx.Xdp.LaExtension);
+        La->LogicalAddress = Mapping->DmaAddress.QuadPart + AddressDescriptor.BaseAddress;
+    }
+    if (Xsk->Tx.Xdp.Flags.MdlExt) {
+        XDP_BUFFER_MDL *Mdl;
+        Mdl = XdpGetMdlExtension(Buffer, &Xsk->Tx.Xdp.MdlExtension);
+        Mdl->Mdl = Mapping->Mdl;
+        Mdl->MdlOffset = AddressDescriptor.BaseAddress;
+    }
+
+    return TRUE;
+}
+
+static
+FORCEINLINE
+XDP_BUFFER *
+XskGetTxFrameBuffer(
+    _In_ XSK *Xsk,
+    _In_ XDP_FRAME *Frame,
+    _In_ UINT32 FragmentIndex,
+    _In_ UINT32 BufferIndex
+    )
+{
+    XDP_RING *FragmentRing = Xsk->Tx.Xdp.FragmentRing;
+
+    if (BufferIndex == 0) {
+        return &Frame->Buffer;
+    }
+
+    return XdpRingGetElement(FragmentRing, (FragmentIndex + BufferIndex - 1) & FragmentRing->Mask);
+}
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 UINT32
 XskFillTx(
@@ -766,16 +1025,17 @@ XskFillTx(
     )
 {
     XSK *Xsk = CONTAINING_RECORD(DatapathClientEntry, XSK, Tx.Xdp.DatapathClientEntry);
-    NTSTATUS Status;
-    ULONGLONG Result;
     XSK_FRAME_DESCRIPTOR *XskFrame;
-    XSK_BUFFER_DESCRIPTOR *XskBuffer;
     UINT32 Count;
+    UINT32 Index = 0;
+    UINT32 ConsumerIndex;
     UINT32 FrameCount = 0;
-    UINT32 TxIndex;
+    UINT32 BufferCount = 0;
     UINT32 XskCompletionAvailable;
     UINT32 XskTxAvailable;
+    UINT32 XdpFragmentAvailable = 0;
     XDP_RING *FrameRing = Xsk->Tx.Xdp.FrameRing;
+    XDP_RING *FragmentRing = Xsk->Tx.Xdp.FragmentRing;
 
     if (Xsk->State != XskActive) {
         return 0;
@@ -785,90 +1045,157 @@ XskFillTx(
     // The need poke flag is cleared when a poke request is submitted. If no
     // input is available and no packets are outstanding, or if the TX queue is
     // blocked by a full TX completion queue, set the need poke flag and then
-    // re-check for available TX/completion.
+    // re-check for available TX/completion. With multi-buffer TX, available
+    // input may be an incomplete descriptor chain, so set the flag whenever
+    // no packets are outstanding; it is cleared below if input is processed.
     //
     if (Xsk->Tx.Xdp.PollHandle == NULL &&
-        ((XskRingConsPeek(&Xsk->Tx.Ring, 1) == 0 && Xsk->Tx.Xdp.OutstandingFrames == 0) ||
+        ((Xsk->Tx.Xdp.OutstandingFrames == 0 &&
+          (Xsk->Tx.Xdp.FragmentRing != NULL || XskRingConsPeek(&Xsk->Tx.Ring, 1) == 0)) ||
          (XskGetAvailableTxCompletion(Xsk, 1) == 0)) &&
          !(Xsk->Tx.Ring.Shared->Flags & XSK_RING_FLAG_NEED_POKE)) {
         InterlockedOrAcquire((LONG *)&Xsk->Tx.Ring.Shared->Flags, XSK_RING_FLAG_NEED_POKE);
     }
 
     //
-    // Number of buffers we can move from the XSK TX ring to the XDP TX ring is
+    // Number of buffers we can move from the XSK TX ring to the XDP TX rings is
     // the minimum of these values:
     //
-    // 1) XDP TX frames available for production
+    // 1) XDP TX frames and fragment buffers available for production
     // 2) XSK TX descriptors available for consumption
     // 3) XSK TX completion descriptors available for production
     //    - XSK TX operations outstanding
     //
+    // Each XSK TX descriptor is a single buffer, and each buffer is completed
+    // individually. A frame consumes one XDP TX frame plus one fragment buffer
+    // for each chained descriptor beyond the first.
+    //
+
+    if (FragmentRing != NULL) {
+        XdpFragmentAvailable =
+            (FragmentRing->Mask + 1) - (FragmentRing->ProducerIndex - FragmentRing->Reserved);
+    }
 
-    XskTxAvailable = XskRingConsPeek(&Xsk->Tx.Ring, XdpTxAvailable);
+    XskTxAvailable = XskRingConsPeek(&Xsk->Tx.Ring, XdpTxAvailable + XdpFragmentAvailable);
     XskCompletionAvailable = XskGetAvailableTxCompletion(Xsk, XskTxAvailable);
     Count = XskCompletionAvailable;
 
-    ASSERT(Count == min(min(XdpTxAvailable, XskTxAvailable), XskCompletionAvailable));
+    ASSERT(
+        Count ==
+            min(min(XdpTxAvailable + XdpFragmentAvailable, XskTxAvailable),
+                XskCompletionAvailable));
+
+    ConsumerIndex = ReadUInt32NoFence(&Xsk->Tx.Ring.Shared->ConsumerIndex);
 
-    for (ULONG i = 0; i < Count; i++) {
+    while (Index < Count && FrameCount < XdpTxAvailable) {
         XDP_FRAME *Frame;
-        XDP_BUFFER *Buffer;
-        XSK_BUFFER_ADDRESS AddressDescriptor;
-        UMEM_MAPPING *Mapping;
+        XSK_FRAME_DESCRIPTOR *FirstXskFrame;
         XDP_TX_FRAME_COMPLETION_CONTEXT *CompletionContext;
+        UINT32 ChainLength = 0;
+        UINT32 FragmentIndex;
+        UINT32 FilledCount;
+        UINT64 FrameLength = 0;
+        BOOLEAN Continued;
 
-        TxIndex =
-            (ReadUInt32NoFence(&Xsk->Tx.Ring.Shared->ConsumerIndex) + i) & (Xsk->Tx.Ring.Mask);
-        XskFrame = XskKernelRingGetElement(&Xsk->Tx.Ring, TxIndex);
-        XskBuffer = &XskFrame->Buffer;
-
-        Frame = XdpRingGetElement(FrameRing, FrameRing->ProducerIndex & FrameRing->Mask);
-        Buffer = &Frame->Buffer;
-
-        AddressDescriptor.AddressAndOffset =
-            ReadUInt64NoFence(&XskBuffer->Address.AddressAndOffset);
-        Buffer->DataOffset = (UINT32)AddressDescriptor.Offset;
-        Buffer->DataLength = ReadUInt32NoFence(&XskBuffer->Length);
-        Buffer->BufferLength = Buffer->DataLength + Buffer->DataOffset;
-
-        Status = RtlUInt64Add(AddressDescriptor.BaseAddress, Buffer->DataLength, &Result);
-        Status |= RtlUInt64Add(Buffer->DataOffset, Result, &Result);
-        if (Result > Xsk->Umem->Reg.TotalSize ||
-            Buffer->DataLength == 0 ||
-            Status != STATUS_SUCCESS) {
-            Xsk->Statistics.TxInvalidDescriptors++;
-            STAT_INC(XdpTxQueueGetStats(Xsk->Tx.Xdp.Queue), XskInvalidDescriptors);
+        if (Xsk->Tx.Xdp.DiscardChain) {
+            //
+            // Drop the remainder of an oversized chain, through the first
+            // descriptor without the continuation flag.
+            //
+            XskFrame =
+                XskKernelRingGetElement(
+                    &Xsk->Tx.Ring, (ConsumerIndex + Index) & (Xsk->Tx.Ring.Mask));
+            Xsk->Tx.Xdp.DiscardChain =
+                !!(ReadUInt32NoFence(&XskFrame->Buffer.Flags) &
+                    XSK_BUFFER_DESCRIPTOR_FLAG_CONTINUED);
+            XskTxInvalidDescriptors(Xsk, 1);
+            Index++;
             continue;
         }
 
-        if (Buffer->DataLength > min(Xsk->Tx.Xdp.MaxBufferLength, Xsk->Tx.Xdp.MaxFrameLength)) {
-            Xsk->Statistics.TxInvalidDescriptors++;
-            STAT_INC(XdpTxQueueGetStats(Xsk->Tx.Xdp.Queue), XskInvalidDescriptors);
-            continue;
+        //
+        // Find the end of the frame's descriptor chain. The scan stops at the
+        // last descriptor available to this batch, or as soon as the chain
+        // exceeds the interface's fragment limit.
+        //
+        do {
+            XskFrame =
+                XskKernelRingGetElement(
+                    &Xsk->Tx.Ring, (ConsumerIndex + Index + ChainLength) & (Xsk->Tx.Ring.Mask));
+            Continued =
+                !!(ReadUInt32NoFence(&XskFrame->Buffer.Flags) &
+                    XSK_BUFFER_DESCRIPTOR_FLAG_CONTINUED);
+            ChainLength++;
+        } while (Continued && ChainLength <= Xsk->Tx.Xdp.MaxFragments &&
+                 Index + ChainLength < Count);
+
+        if (Continued) {
+            if (ChainLength > Xsk->Tx.Xdp.MaxFragments) {
+                //
+                // The frame has more buffers than the interface supports (or
+                // the interface does not support fragmentation): drop the
+                // entire chain.
+                //
+                Xsk->Tx.Xdp.DiscardChain = TRUE;
+                XskTxInvalidDescriptors(Xsk, ChainLength);
+                Index += ChainLength;
+                continue;
+            }
+
+            //
+            // The rest of the chain has not been posted yet, or does not fit
+            // within this batch. Wait for more input or resources.
+            //
+            break;
         }
 
-        if (!XskBounceBuffer(
-                Xsk->Umem, &Xsk->Tx.Bounce, Buffer, AddressDescriptor.BaseAddress, &Mapping)) {
-            Xsk->Statistics.TxInvalidDescriptors++;
-            STAT_INC(XdpTxQueueGetStats(Xsk->Tx.Xdp.Queue), XskInvalidDescriptors);
-            continue;
+        if (ChainLength - 1 > XdpFragmentAvailable) {
+            break;
         }
 
-        if (Xsk->Tx.Xdp.Flags.VirtualAddressExt) {
-            XDP_BUFFER_VIRTUAL_ADDRESS *Va;
-            Va = XdpGetVirtualAddressExtension(Buffer, &Xsk->Tx.Xdp.VaExtension);
-            Va->VirtualAddress = &Mapping->SystemAddress[AddressDescriptor.BaseAddress];
+        FirstXskFrame =
+            XskKernelRingGetElement(&Xsk->Tx.Ring, (ConsumerIndex + Index) & (Xsk->Tx.Ring.Mask));
+        Frame = XdpRingGetElement(FrameRing, FrameRing->ProducerIndex & FrameRing->Mask);
+        FragmentIndex = (FragmentRing != NULL) ? FragmentRing->ProducerIndex : 0;
+
+        for (FilledCount = 0; FilledCount < ChainLength; FilledCount++) {
+            XDP_BUFFER *Buffer;
+
+            XskFrame =
+                XskKernelRingGetElement(
+                    &Xsk->Tx.Ring, (ConsumerIndex + Index + FilledCount) & (Xsk->Tx.Ring.Mask));
+            Buffer = XskGetTxFrameBuffer(Xsk, Frame, FragmentIndex, FilledCount);
+
+            if (!XskFillTxBuffer(Xsk, &XskFrame->Buffer, Buffer)) {
+                break;
+            }
+
+            FrameLength += Buffer->DataLength;
         }
-        if (Xsk->Tx.Xdp.Flags.LogicalAddressExt) {
-            XDP_BUFFER_LOGICAL_ADDRESS *La;
-            La = XdpGetLogicalAddressExtension(Buffer, &Xsk->Tx.Xdp.LaExtension);
-            La->LogicalAddress = Mapping->DmaAddress.QuadPart + AddressDescriptor.BaseAddress;
+
+        if (FilledCount < ChainLength || FrameLength > Xsk->Tx.Xdp.MaxFrameLength) {
+            //
+            // Release any buffers already bounced for this frame, then drop
+            // the entire chain.
+            //
+            if (Xsk->Tx.Bounce.Tracker != NULL) {
+                for (UINT32 i = 0; i < FilledCount; i++) {
+                    XDP_BUFFER *Buffer = XskGetTxFrameBuffer(Xsk, Frame, FragmentIndex, i);
+
+                    XskReleaseBounceBuffer(
+                        Xsk->Umem, &Xsk->Tx.Bounce,
+                        XskGetTxBufferRelativeAddress(Xsk, Buffer, XskGetTxMapping(Xsk)));
+                }
+            }
+
+            XskTxInvalidDescriptors(Xsk, ChainLength);
+            Index += ChainLength;
+            continue;
         }
-        if (Xsk->Tx.Xdp.Flags.MdlExt) {
-            XDP_BUFFER_MDL *Mdl;
-            Mdl = XdpGetMdlExtension(Buffer, &Xsk->Tx.Xdp.MdlExtension);
-            Mdl->Mdl = Mapping->Mdl;
-            Mdl->MdlOffset = AddressDescriptor.BaseAddress;
+
+        if (FragmentRing != NULL) {
+            XdpGetFragmentExtension(Frame, &Xsk->Tx.Xdp.FragmentExtension)->FragmentBufferCount =
+                (UINT8)(ChainLength - 1);
         }
         if (Xsk->Tx.Xdp.Flags.CompletionContext) {
             CompletionContext =
@@ -880,13 +1207,14 @@ XskFillTx(
             //
             // Gate all offload features behind a single flag union, to minimize
             // code complexity for the common case of non-offloading sockets.
+            // Offloads are specified by the first descriptor of each frame.
             //
 
             if (Xsk->Tx.LayoutExtensionOffset != 0) {
                 XDP_FRAME_LAYOUT *XdpLayout =
                     XdpGetLayoutExtension(Frame, &Xsk->Tx.Xdp.LayoutExtension);
                 const XDP_FRAME_LAYOUT *XskLayout =
-                    RTL_PTR_ADD(XskFrame, Xsk->Tx.LayoutExtensionOffset);
+                    RTL_PTR_ADD(FirstXskFrame, Xsk->Tx.LayoutExtensionOffset);
 
                 C_ASSERT(sizeof(*XdpLayout) == sizeof(*XskLayout));
                 ASSERT(Xsk->Tx.Xdp.LayoutExtension.Reserved != 0);
@@ -902,7 +1230,7 @@ XskFillTx(
                 XDP_FRAME_CHECKSUM *XdpChecksum =
                     XdpGetChecksumExtension(Frame, &Xsk->Tx.Xdp.ChecksumExtension);
                 const XDP_FRAME_CHECKSUM *XskChecksum =
-                    RTL_PTR_ADD(XskFrame, Xsk->Tx.ChecksumExtensionOffset);
+                    RTL_PTR_ADD(FirstXskFrame, Xsk->Tx.ChecksumExtensionOffset);
 
                 C_ASSERT(sizeof(*XdpChecksum) == sizeof(*XskChecksum));
                 ASSERT(Xsk->Tx.Xdp.ChecksumExtension.Reserved != 0);
@@ -913,22 +1241,40 @@ XskFillTx(
                 //
                 RtlCopyVolatileMemory(XdpChecksum, XskChecksum, sizeof(*XdpChecksum));
             }
+
+            if (Xsk->Tx.GsoExtensionOffset != 0) {
+                XDP_FRAME_GSO *XdpGso = XdpGetGsoExtension(Frame, &Xsk->Tx.Xdp.GsoExtension);
+                const XDP_FRAME_GSO *XskGso = RTL_PTR_ADD(FirstXskFrame, Xsk->Tx.GsoExtensionOffset);
+
+                C_ASSERT(sizeof(*XdpGso) == sizeof(*XskGso));
+                ASSERT(Xsk->Tx.Xdp.GsoExtension.Reserved != 0);
+
+                //
+                // The interface validates the headers and MSS of each frame.
+                //
+                RtlCopyVolatileMemory(XdpGso, XskGso, sizeof(*XdpGso));
+            }
         }
 
         EventWriteXskTxEnqueue(
-            &MICROSOFT_XDP_PROVIDER, Xsk, Xsk->Tx.Ring.Shared->ConsumerIndex + i,
-            FrameRing->ProducerIndex);
+            &MICROSOFT_XDP_PROVIDER, Xsk, ConsumerIndex + Index, FrameRing->ProducerIndex);
 
         FrameRing->ProducerIndex++;
+        if (FragmentRing != NULL) {
+            FragmentRing->ProducerIndex += ChainLength - 1;
+            XdpFragmentAvailable -= ChainLength - 1;
+        }
         FrameCount++;
+        BufferCount += ChainLength;
+        Index += ChainLength;
     }
 
-    if (Count > 0) {
-        XskRingConsRelease(&Xsk->Tx.Ring, Count);
+    if (Index > 0) {
+        XskRingConsRelease(&Xsk->Tx.Ring, Index);
         XskKernelRingUpdateIdealProcessor(&Xsk->Tx.Ring);
     }
 
-    Xsk->Tx.Xdp.OutstandingFrames += FrameCount;
+    Xsk->Tx.Xdp.OutstandingFrames += BufferCount;
 
     //
     // If input was processed, clear the need poke flag.
@@ -1072,25 +1418,7 @@ XskFillTxCompletion(
                 }
             }
 
-            if (Xsk->Tx.Xdp.Flags.VirtualAddressExt) {
-                XDP_BUFFER_VIRTUAL_ADDRESS *Va;
-                Va = XdpGetVirtualAddressExtension(&Frame->Buffer, &Xsk->Tx.Xdp.VaExtension);
-                RelativeAddress = Va->VirtualAddress - Mapping->SystemAddress;
-            } else if (Xsk->Tx.Xdp.Flags.LogicalAddressExt) {
-                XDP_BUFFER_LOGICAL_ADDRESS *La;
-                La = XdpGetLogicalAddressExtension(&Frame->Buffer, &Xsk->Tx.Xdp.LaExtension);
-                RelativeAddress = La->LogicalAddress - Mapping->DmaAddress.QuadPart;
-            } else if (Xsk->Tx.Xdp.Flags.MdlExt) {
-                XDP_BUFFER_MDL *Mdl;
-                Mdl = XdpGetMdlExtension(&Frame->Buffer, &Xsk->Tx.Xdp.MdlExtension);
-                RelativeAddress = Mdl->MdlOffset;
-            } else {
-                //
-                // One of the above extensions must have be enabled.
-                //
-                ASSERT(FALSE);
-                RelativeAddress = 0;
-            }
+            RelativeAddress = XskGetTxBufferRelativeAddress(Xsk, &Frame->Buffer, Mapping);
 
             if (Xsk->Tx.OffloadFlags.Timestamp) {
                 XdpTimestamp =
@@ -1099,6 +1427,28 @@ XskFillTxCompletion(
             }
 
             XskWriteUmemTxCompletion(Xsk, ProducerIndex++, RelativeAddress, XdpTimestamp);
+
+            if (Xsk->Tx.Xdp.FragmentRing != NULL) {
+                XDP_RING *FragmentRing = Xsk->Tx.Xdp.FragmentRing;
+                UINT8 FragmentCount =
+                    XdpGetFragmentExtension(
+                        Frame, &Xsk->Tx.Xdp.FragmentExtension)->FragmentBufferCount;
+
+                //
+                // Each fragment buffer is completed individually, in the order
+                // it was chained.
+                //
+                ASSERT((FragmentRing->ConsumerIndex - FragmentRing->Reserved) >= FragmentCount);
+
+                for (UINT8 i = 0; i < FragmentCount; i++) {
+                    XDP_BUFFER *Buffer =
+                        XdpRingGetElement(
+                            FragmentRing, FragmentRing->Reserved++ & FragmentRing->Mask);
+
+                    RelativeAddress = XskGetTxBufferRelativeAddress(Xsk, Buffer, Mapping);
+                    XskWriteUmemTxCompletion(Xsk, ProducerIndex++, RelativeAddress, XdpTimestamp);
+                }
+            }
         } while ((XdpRing->ConsumerIndex - ++XdpRing->Reserved) > 0);
     }
 
@@ -1124,8 +1474,7 @@ XskFillTxCompletion(
         //
         XdpBarrierBetweenReleaseAndAcquire();
 
-        if ((ReadUInt32Acquire(&Xsk->IoWaitFlags) & XSK_NOTIFY_FLAG_WAIT_TX) &&
-            (KeReadStateEvent(&Xsk->IoWaitEvent) == 0 || Xsk->IoWaitIrp != NULL)) {
+        if (XskHasReadyIoWaiter(Xsk, XSK_NOTIFY_FLAG_WAIT_TX)) {
             XskSignalReadyIo(Xsk, XSK_NOTIFY_FLAG_WAIT_TX);
         }
 
@@ -1236,6 +1585,7 @@ XskIrpCreateSocket(
     KeInitializeEvent(&Xsk->IoWaitEvent, NotificationEvent, TRUE);
     KeInitializeEvent(&Xsk->PollRequested, SynchronizationEvent, FALSE);
     KeInitializeEvent(&Xsk->Tx.Xdp.OutstandingFlushComplete, NotificationEvent, FALSE);
+    Xsk->AdaptivePoll.IdleTimeoutMs = XSK_ADAPTIVE_POLL_DEFAULT_IDLE_TIMEOUT_MS;
     Xsk->CreatorMode = Irp->RequestorMode;
 
     //
@@ -1743,83 +2093,288 @@ XskEnterPollModeBusy(
 }
 
 static
-_Requires_exclusive_lock_held_(&Xsk->PollLock)
-NTSTATUS
-XskSetPollMode(
-    _In_ XSK *Xsk,
-    _In_ XSK_POLL_MODE PollMode
+UINT32
+XskGetPollActivity(
+    _In_ XSK *Xsk
     )
 {
-    NTSTATUS Status = STATUS_SUCCESS;
-
-    if (Xsk->State != XskActive && PollMode != XSK_POLL_MODE_DEFAULT) {
-        Status = STATUS_INVALID_DEVICE_STATE;
-        goto Exit;
-    }
+    UINT32 Activity = 0;
 
     //
-    // Exit the old polling mode and return to the default state.
+    // Both indices are advanced only by the kernel, so any change indicates RX
+    // or TX progress since the previous sample.
     //
-    switch (Xsk->PollMode) {
-
-    case XSK_POLL_MODE_DEFAULT:
-        // Nothing to do.
-        break;
-
-    case XSK_POLL_MODE_BUSY:
-        XskExitPollModeBusy(Xsk);
-        break;
-
-    case XSK_POLL_MODE_SOCKET:
-        XskExitPollModeSocket(Xsk);
-        break;
-
-    default:
-        ASSERT(FALSE);
+    if (Xsk->Rx.Ring.Size > 0) {
+        Activity += ReadUInt32NoFence(&Xsk->Rx.Ring.Shared->ProducerIndex);
     }
 
-    ASSERT(Xsk->PollMode == XSK_POLL_MODE_DEFAULT);
-
-    //
-    // Enter the new polling mode.
-    //
-    switch (PollMode) {
-
-    case XSK_POLL_MODE_DEFAULT:
-        // Nothing to do.
-        break;
-
-    case XSK_POLL_MODE_BUSY:
-        Status = XskEnterPollModeBusy(Xsk);
-        if (!NT_SUCCESS(Status)) {
-            goto Exit;
-        }
-        goto Exit;
-
-    case XSK_POLL_MODE_SOCKET:
-        Status = XskEnterPollModeSocket(Xsk);
-        if (!NT_SUCCESS(Status)) {
-            goto Exit;
-        }
-        break;
-
-    default:
-        Status = STATUS_INVALID_PARAMETER;
-        goto Exit;
+    if (Xsk->Tx.Ring.Size > 0) {
+        Activity += ReadUInt32NoFence(&Xsk->Tx.Ring.Shared->ConsumerIndex);
     }
 
-Exit:
+    return Activity;
+}
 
-    return Status;
+static
+_Requires_exclusive_lock_held_(&Xsk->PollLock)
+VOID
+XskStartAdaptivePollIdleTimer(
+    _In_ XSK *Xsk
+    )
+{
+    Xsk->AdaptivePoll.LastActivity = XskGetPollActivity(Xsk);
+    XdpTimerStart(Xsk->AdaptivePoll.IdleTimer, Xsk->AdaptivePoll.IdleTimeoutMs, NULL);
 }
 
 static
+_Requires_exclusive_lock_held_(&Xsk->PollLock)
 VOID
-XskNotifyDetachRxQueue(
+XskResumeAdaptivePoll(
     _In_ XSK *Xsk
     )
 {
-    XskAcquirePollLock(Xsk);
+    ASSERT(Xsk->PollMode == XSK_POLL_MODE_ADAPTIVE);
+
+    WriteBooleanNoFence(&Xsk->AdaptivePoll.Idle, FALSE);
+    XskAcquirePollModeBusy(Xsk);
+    XskStartAdaptivePollIdleTimer(Xsk);
+}
+
+static
+_IRQL_requires_(PASSIVE_LEVEL)
+VOID
+XskAdaptivePollIdleTimeout(
+    _In_ VOID *Context
+    )
+{
+    XSK *Xsk = Context;
+
+    XskAcquirePollLock(Xsk);
+
+    if (Xsk->PollMode != XSK_POLL_MODE_ADAPTIVE || Xsk->AdaptivePoll.Idle) {
+        goto Exit;
+    }
+
+    if (XskGetPollActivity(Xsk) != Xsk->AdaptivePoll.LastActivity) {
+        XskStartAdaptivePollIdleTimer(Xsk);
+        goto Exit;
+    }
+
+    //
+    // No IO was observed for an entire idle timeout, so stop busy polling and
+    // let the interface revert to interrupts until the next frame arrives or
+    // the application notifies the socket.
+    //
+    XskReleasePollModeBusyTx(Xsk);
+    XskReleasePollModeBusyRx(Xsk);
+    WriteBooleanRelease(&Xsk->AdaptivePoll.Idle, TRUE);
+
+    TraceInfo(TRACE_XSK, "Xsk=%p Adaptive poll idle", Xsk);
+
+Exit:
+
+    XskReleasePollLock(Xsk);
+}
+
+static
+_Function_class_(IO_WORKITEM_ROUTINE_EX)
+_IRQL_requires_(PASSIVE_LEVEL)
+VOID
+XskAdaptivePollResumeWorker(
+    _In_ VOID *IoObject,
+    _In_opt_ VOID *Context,
+    _In_ IO_WORKITEM *IoWorkItem
+    )
+{
+    XSK *Xsk = Context;
+
+    UNREFERENCED_PARAMETER(IoObject);
+    UNREFERENCED_PARAMETER(IoWorkItem);
+    ASSERT(Xsk != NULL);
+
+    XskAcquirePollLock(Xsk);
+
+    InterlockedExchange(&Xsk->AdaptivePoll.ResumeQueued, FALSE);
+
+    if (Xsk->State == XskActive && Xsk->PollMode == XSK_POLL_MODE_ADAPTIVE &&
+        Xsk->AdaptivePoll.Idle) {
+        XskResumeAdaptivePoll(Xsk);
+    }
+
+    XskReleasePollLock(Xsk);
+
+    XskDereference(Xsk);
+}
+
+static
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+XskQueueAdaptivePollResume(
+    _In_ XSK *Xsk
+    )
+{
+    //
+    // Busy poll references can only be acquired at passive level, so defer
+    // resuming busy polling to a worker. At most one resume is queued.
+    //
+    if (InterlockedCompareExchange(&Xsk->AdaptivePoll.ResumeQueued, TRUE, FALSE) == FALSE) {
+        XskReference(Xsk);
+        IoQueueWorkItemEx(
+            Xsk->AdaptivePoll.ResumeWorkItem, XskAdaptivePollResumeWorker, NormalWorkQueue, Xsk);
+    }
+}
+
+static
+_Requires_exclusive_lock_held_(&Xsk->PollLock)
+VOID
+XskExitPollModeAdaptive(
+    _In_ XSK *Xsk
+    )
+{
+    Xsk->PollMode = XSK_POLL_MODE_DEFAULT;
+    WriteBooleanNoFence(&Xsk->AdaptivePoll.Idle, FALSE);
+
+    //
+    // If the idle timeout is already executing, it observes the new poll mode
+    // once it acquires the poll lock.
+    //
+    XdpTimerCancel(Xsk->AdaptivePoll.IdleTimer);
+    XskReleasePollModeBusyTx(Xsk);
+    XskReleasePollModeBusyRx(Xsk);
+}
+
+static
+_Requires_exclusive_lock_held_(&Xsk->PollLock)
+NTSTATUS
+XskEnterPollModeAdaptive(
+    _In_ XSK *Xsk
+    )
+{
+    NTSTATUS Status;
+
+    if (Xsk->AdaptivePoll.IdleTimer == NULL) {
+        Xsk->AdaptivePoll.IdleTimer =
+            XdpTimerCreate(XskAdaptivePollIdleTimeout, Xsk, XdpDriverObject, NULL);
+        if (Xsk->AdaptivePoll.IdleTimer == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto Exit;
+        }
+    }
+
+    if (Xsk->AdaptivePoll.ResumeWorkItem == NULL) {
+        Xsk->AdaptivePoll.ResumeWorkItem =
+            ExAllocatePoolZero(NonPagedPoolNx, IoSizeofWorkItem(), POOLTAG_XSK);
+        if (Xsk->AdaptivePoll.ResumeWorkItem == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto Exit;
+        }
+
+        IoInitializeWorkItem(XdpDriverObject, Xsk->AdaptivePoll.ResumeWorkItem);
+    }
+
+    Xsk->PollMode = XSK_POLL_MODE_ADAPTIVE;
+
+    //
+    // Start busy polling immediately; as with busy poll mode, silently continue
+    // if busy polling is not available.
+    //
+    XskResumeAdaptivePoll(Xsk);
+    Status = STATUS_SUCCESS;
+
+Exit:
+
+    return Status;
+}
+
+static
+_Requires_exclusive_lock_held_(&Xsk->PollLock)
+NTSTATUS
+XskSetPollMode(
+    _In_ XSK *Xsk,
+    _In_ XSK_POLL_MODE PollMode
+    )
+{
+    NTSTATUS Status = STATUS_SUCCESS;
+
+    if (Xsk->State != XskActive && PollMode != XSK_POLL_MODE_DEFAULT) {
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+
+    //
+    // Exit the old polling mode and return to the default state.
+    //
+    switch (Xsk->PollMode) {
+
+    case XSK_POLL_MODE_DEFAULT:
+        // Nothing to do.
+        break;
+
+    case XSK_POLL_MODE_BUSY:
+        XskExitPollModeBusy(Xsk);
+        break;
+
+    case XSK_POLL_MODE_SOCKET:
+        XskExitPollModeSocket(Xsk);
+        break;
+
+    case XSK_POLL_MODE_ADAPTIVE:
+        XskExitPollModeAdaptive(Xsk);
+        break;
+
+    default:
+        ASSERT(FALSE);
+    }
+
+    ASSERT(Xsk->PollMode == XSK_POLL_MODE_DEFAULT);
+
+    //
+    // Enter the new polling mode.
+    //
+    switch (PollMode) {
+
+    case XSK_POLL_MODE_DEFAULT:
+        // Nothing to do.
+        break;
+
+    case XSK_POLL_MODE_BUSY:
+        Status = XskEnterPollModeBusy(Xsk);
+        if (!NT_SUCCESS(Status)) {
+            goto Exit;
+        }
+        goto Exit;
+
+    case XSK_POLL_MODE_SOCKET:
+        Status = XskEnterPollModeSocket(Xsk);
+        if (!NT_SUCCESS(Status)) {
+            goto Exit;
+        }
+        break;
+
+    case XSK_POLL_MODE_ADAPTIVE:
+        Status = XskEnterPollModeAdaptive(Xsk);
+        if (!NT_SUCCESS(Status)) {
+            goto Exit;
+        }
+        break;
+
+    default:
+        Status = STATUS_INVALID_PARAMETER;
+        goto Exit;
+    }
+
+Exit:
+
+    return Status;
+}
+
+static
+VOID
+XskNotifyDetachRxQueue(
+    _In_ XSK *Xsk
+    )
+{
+    XskAcquirePollLock(Xsk);
 
     //
     // This socket is being unbound from an RX queue, so release all polling
@@ -1828,6 +2383,7 @@ XskNotifyDetachRxQueue(
     switch (Xsk->PollMode) {
 
     case XSK_POLL_MODE_BUSY:
+    case XSK_POLL_MODE_ADAPTIVE:
         XskReleasePollModeBusyRx(Xsk);
         break;
 
@@ -1896,6 +2452,13 @@ XskNotifyAttachRxQueue(
         XdpRxQueueGetExtension(Config, &ExtensionInfo, &Xsk->Rx.Xdp.TimestampExtension);
     }
 
+    if (XdpRxQueueIsGroOffloadEnabled(Config)) {
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_GRO_NAME,
+            XDP_FRAME_EXTENSION_GRO_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        XdpRxQueueGetExtension(Config, &ExtensionInfo, &Xsk->Rx.Xdp.GroExtension);
+    }
+
     if (XdpRxQueueGetMaximumFragments(Config) > 1) {
         Xsk->Rx.Xdp.FragmentRing = XdpRxQueueGetFragmentRing(Config);
 
@@ -1922,6 +2485,12 @@ XskNotifyAttachRxQueue(
             XskAcquirePollModeSocket(Xsk);
             break;
 
+        case XSK_POLL_MODE_ADAPTIVE:
+            if (!Xsk->AdaptivePoll.Idle) {
+                XskAcquirePollModeBusyRx(Xsk);
+            }
+            break;
+
         }
     }
 
@@ -1983,6 +2552,7 @@ XskIrpCleanup(
     XSK *Xsk;
     KIRQL OldIrql;
     UINT32 IoWaitFlags;
+    XDP_TIMER *AdaptivePollIdleTimer;
 
     UNREFERENCED_PARAMETER(Irp);
 
@@ -1997,7 +2567,7 @@ XskIrpCleanup(
 
     KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
     Xsk->State = XskClosing;
-    IoWaitFlags = Xsk->IoWaitFlags;
+    IoWaitFlags = Xsk->IoWaitFlags | Xsk->NotifySetWaitFlags;
     KeReleaseSpinLock(&Xsk->Lock, OldIrql);
 
     //
@@ -2005,8 +2575,19 @@ XskIrpCleanup(
     //
     NT_VERIFY(XskSetPollMode(Xsk, XSK_POLL_MODE_DEFAULT) == STATUS_SUCCESS);
 
+    AdaptivePollIdleTimer = Xsk->AdaptivePoll.IdleTimer;
+    Xsk->AdaptivePoll.IdleTimer = NULL;
+
     XskReleasePollLock(Xsk);
 
+    //
+    // The socket is closing, so the adaptive poll idle timer cannot be
+    // restarted. Wait for any executing timeout before the socket is freed.
+    //
+    if (AdaptivePollIdleTimer != NULL) {
+        XdpTimerShutdown(AdaptivePollIdleTimer, TRUE, TRUE);
+    }
+
     if (IoWaitFlags != 0) {
         XskSignalReadyIo(Xsk, IoWaitFlags);
     }
@@ -2122,7 +2703,7 @@ XskSetupDma(
     //
     if (!XskRequiresTxBounceBuffer(Xsk) &&
         RTL_CONTAINS_FIELD(DmaOperations, DmaOperations->Size, CreateCommonBufferFromMdl)) {
-        Mapping = &Xsk->Umem->Mapping;
+        Mapping = &Xsk->Tx.UmemMapping;
         Status =
             DmaOperations->CreateCommonBufferFromMdl(
                 Xsk->Tx.DmaAdapter, Mapping->Mdl, NULL, 0, &Mapping->DmaAddress);
@@ -2213,6 +2794,11 @@ XskDetachRxIf(
 
         XskNotifyDetachRxQueue(Xsk);
         XskNotifyDetachRxQueueComplete(Xsk);
+
+        if (Xsk->Rx.Flags.ZeroCopy) {
+            XdpRxQueueDisableBufferProvider(Xsk->Rx.Xdp.Queue, Xsk);
+        }
+
         XdpRxQueueDereference(Xsk->Rx.Xdp.Queue);
         Xsk->Rx.Xdp.Queue = NULL;
     }
@@ -2601,10 +3187,24 @@ XskActivateTxIf(
     }
 
     Config = XdpTxQueueGetConfig(Xsk->Tx.Xdp.Queue);
+    Xsk->Tx.UmemMapping.Mdl = Xsk->Umem->Mapping.Mdl;
+    Xsk->Tx.UmemMapping.SystemAddress = Xsk->Umem->Mapping.SystemAddress;
+    Xsk->Tx.UmemMapping.DmaAddress.QuadPart = 0;
     Xsk->Tx.Xdp.Flags.OutOfOrderCompletion = XdpTxQueueIsOutOfOrderCompletionEnabled(Config);
     Xsk->Tx.Xdp.Flags.CompletionContext = XdpTxQueueIsTxCompletionContextEnabled(Config);
     Xsk->Tx.Xdp.FrameRing = XdpTxQueueGetFrameRing(Config);
 
+    if (XdpTxQueueIsFragmentationEnabled(Config)) {
+        ASSERT(!Xsk->Tx.Xdp.Flags.OutOfOrderCompletion);
+        Xsk->Tx.Xdp.FragmentRing = XdpTxQueueGetFragmentRing(Config);
+        Xsk->Tx.Xdp.MaxFragments = XdpTxQueueGetCapabilities(Xsk->Tx.Xdp.Queue)->MaximumFragments;
+
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_FRAGMENT_NAME,
+            XDP_FRAME_EXTENSION_FRAGMENT_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        XdpTxQueueGetExtension(Config, &ExtensionInfo, &Xsk->Tx.Xdp.FragmentExtension);
+    }
+
     if (Xsk->Tx.Xdp.Flags.CompletionContext) {
         XdpInitializeExtensionInfo(
             &ExtensionInfo, XDP_TX_FRAME_COMPLETION_CONTEXT_EXTENSION_NAME,
@@ -2668,6 +3268,13 @@ XskActivateTxIf(
         XdpTxQueueGetExtension(Config, &ExtensionInfo, &Xsk->Tx.Xdp.ChecksumExtension);
     }
 
+    if (XdpTxQueueIsSegmentationOffloadEnabled(Config)) {
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_GSO_NAME,
+            XDP_FRAME_EXTENSION_GSO_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        XdpTxQueueGetExtension(Config, &ExtensionInfo, &Xsk->Tx.Xdp.GsoExtension);
+    }
+
     if (XdpTxQueueIsTimestampOffloadEnabled(Config)) {
         if (Xsk->Tx.Xdp.Flags.OutOfOrderCompletion) {
             XdpInitializeExtensionInfo(
@@ -2781,6 +3388,22 @@ XskDereferenceUmem(
     }
 }
 
+VOID
+XskDereferenceRxBufferProvider(
+    _In_ VOID *Target
+    )
+{
+    XSK *Xsk = Target;
+
+    //
+    // Release the references taken when the socket was enabled as an RX queue
+    // buffer provider. The UMEM must outlive any buffers posted to the
+    // interface.
+    //
+    XskDereferenceUmem(Xsk->Umem);
+    XskDereference(Xsk);
+}
+
 static
 VOID
 XskClose(
@@ -3469,54 +4092,143 @@ Exit:
 
 static
 NTSTATUS
-XskSockoptSetRingSize(
+XskSockoptSetSharedUmem(
     _In_ XSK *Xsk,
     _In_ XSK_SET_SOCKOPT_IN *Sockopt,
     _In_ KPROCESSOR_MODE RequestorMode
     )
 {
     NTSTATUS Status;
-    const VOID *SockoptInputBuffer;
-    UINT32 SockoptInputBufferLength;
-    XSK_SHARED_RING *Shared = NULL;
-    MDL *Mdl = NULL;
-    VOID *UserVa = NULL;
-    XSK_KERNEL_RING *Ring = NULL;
-    UINT32 NumDescriptors;
-    UINT32 DescriptorSize;
-    ULONG AllocationSize;
-    XDP_EXTENSION_SET *ExtensionSet = NULL;
+    HANDLE SourceHandle = NULL;
+    XSK *SourceXsk;
+    UMEM *Umem = NULL;
     KIRQL OldIrql = {0};
     BOOLEAN IsLockHeld = FALSE;
-    BOOLEAN IsPushLockHeld = FALSE;
 
     TraceEnter(TRACE_XSK, "Xsk=%p", Xsk);
 
-    //
-    // This is a nested buffer not copied by IO manager, so it needs special care.
-    //
-    SockoptInputBuffer = Sockopt->InputBuffer;
-    SockoptInputBufferLength = Sockopt->InputBufferLength;
-
-    if (SockoptInputBufferLength < sizeof(UINT32)) {
+    if (Sockopt->InputBufferLength < sizeof(HANDLE)) {
         Status = STATUS_INVALID_PARAMETER;
         goto Exit;
     }
 
-    __try {
-        if (RequestorMode != KernelMode) {
-            ProbeForRead((VOID*)SockoptInputBuffer, SockoptInputBufferLength, PROBE_ALIGNMENT(UINT32));
-        }
-        NumDescriptors = ReadUInt32NoFence(SockoptInputBuffer);
-    } __except (EXCEPTION_EXECUTE_HANDLER) {
-        Status = GetExceptionCode();
+    //
+    // This is a nested buffer not copied by IO manager; the handle reference
+    // routine probes it.
+    //
+    Status =
+        XskReferenceDatapathHandle(RequestorMode, Sockopt->InputBuffer, FALSE, &SourceHandle);
+    if (!NT_SUCCESS(Status)) {
+        SourceHandle = NULL;
         goto Exit;
     }
 
-    if (NumDescriptors > MAXUINT32 || !RTL_IS_POWER_OF_TWO(NumDescriptors)) {
-        Status = STATUS_INVALID_PARAMETER;
-        goto Exit;
-    }
+    SourceXsk = SourceHandle;
+
+    //
+    // The source socket's UMEM is immutable once registered and released only
+    // after the socket starts closing, so a reference taken under its lock
+    // remains valid after the lock is released.
+    //
+    KeAcquireSpinLock(&SourceXsk->Lock, &OldIrql);
+    if (SourceXsk->State != XskClosing) {
+        Umem = SourceXsk->Umem;
+        if (Umem != NULL) {
+            XskReferenceUmem(Umem);
+        }
+    }
+    KeReleaseSpinLock(&SourceXsk->Lock, OldIrql);
+
+    if (Umem == NULL) {
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+
+    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
+    IsLockHeld = TRUE;
+
+    if (Xsk->State >= XskActivating) {
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+    if (Xsk->Umem != NULL) {
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+
+    TraceInfo(TRACE_XSK, "Xsk=%p Set shared Umem=%p SourceXsk=%p", Xsk, Umem, SourceXsk);
+
+    Status = STATUS_SUCCESS;
+    Xsk->Umem = Umem;
+    Umem = NULL;
+
+Exit:
+
+    if (IsLockHeld) {
+        KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+    }
+    if (Umem != NULL) {
+        XskDereferenceUmem(Umem);
+    }
+    if (SourceHandle != NULL) {
+        XskDereferenceDatapathHandle(SourceHandle);
+    }
+
+    TraceExitStatus(TRACE_XSK);
+
+    return Status;
+}
+
+static
+NTSTATUS
+XskSockoptSetRingSize(
+    _In_ XSK *Xsk,
+    _In_ XSK_SET_SOCKOPT_IN *Sockopt,
+    _In_ KPROCESSOR_MODE RequestorMode
+    )
+{
+    NTSTATUS Status;
+    const VOID *SockoptInputBuffer;
+    UINT32 SockoptInputBufferLength;
+    XSK_SHARED_RING *Shared = NULL;
+    MDL *Mdl = NULL;
+    VOID *UserVa = NULL;
+    XSK_KERNEL_RING *Ring = NULL;
+    UINT32 NumDescriptors;
+    UINT32 DescriptorSize;
+    ULONG AllocationSize;
+    XDP_EXTENSION_SET *ExtensionSet = NULL;
+    KIRQL OldIrql = {0};
+    BOOLEAN IsLockHeld = FALSE;
+    BOOLEAN IsPushLockHeld = FALSE;
+
+    TraceEnter(TRACE_XSK, "Xsk=%p", Xsk);
+
+    //
+    // This is a nested buffer not copied by IO manager, so it needs special care.
+    //
+    SockoptInputBuffer = Sockopt->InputBuffer;
+    SockoptInputBufferLength = Sockopt->InputBufferLength;
+
+    if (SockoptInputBufferLength < sizeof(UINT32)) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto Exit;
+    }
+
+    __try {
+        if (RequestorMode != KernelMode) {
+            ProbeForRead((VOID*)SockoptInputBuffer, SockoptInputBufferLength, PROBE_ALIGNMENT(UINT32));
+        }
+        NumDescriptors = ReadUInt32NoFence(SockoptInputBuffer);
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        Status = GetExceptionCode();
+        goto Exit;
+    }
+
+    if (NumDescriptors > MAXUINT32 || !RTL_IS_POWER_OF_TWO(NumDescriptors)) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto Exit;
+    }
 
     RtlAcquirePushLockExclusive(&Xsk->PushLock);
     IsPushLockHeld = TRUE;
@@ -3697,6 +4409,14 @@ XskSockoptSetRingSize(
                 ExtensionSet, &ExtensionInfo, &Extension);
             Xsk->Tx.ChecksumExtensionOffset = Extension.Reserved;
         }
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_GSO_NAME,
+            XDP_FRAME_EXTENSION_GSO_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        if (XdpExtensionSetIsExtensionEnabled(ExtensionSet, ExtensionInfo.ExtensionName)) {
+            XdpExtensionSetGetExtension(
+                ExtensionSet, &ExtensionInfo, &Extension);
+            Xsk->Tx.GsoExtensionOffset = Extension.Reserved;
+        }
         break;
     }
     case XSK_SOCKOPT_TX_COMPLETION_RING_SIZE:
@@ -3749,6 +4469,14 @@ XskSockoptSetRingSize(
                 ExtensionSet, &ExtensionInfo, &Extension);
             Xsk->Rx.TimestampExtensionOffset = Extension.Reserved;
         }
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_GRO_NAME,
+            XDP_FRAME_EXTENSION_GRO_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        if (XdpExtensionSetIsExtensionEnabled(ExtensionSet, ExtensionInfo.ExtensionName)) {
+            XdpExtensionSetGetExtension(
+                ExtensionSet, &ExtensionInfo, &Extension);
+            Xsk->Rx.GroExtensionOffset = Extension.Reserved;
+        }
         break;
     }
     }
@@ -4027,6 +4755,36 @@ XskSetTxOffloadChecksumWorker(
     KeSetEvent(&WorkItem->CompletionEvent, 0, FALSE);
 }
 
+static
+VOID
+XskSetTxOffloadGsoWorker(
+    _In_ XDP_BINDING_WORKITEM *Item
+    )
+{
+    XSK_BINDING_WORKITEM *WorkItem = (XSK_BINDING_WORKITEM *)Item;
+    XSK *Xsk = WorkItem->Xsk;
+
+    if (Xsk->Tx.Xdp.Queue != NULL) {
+        WorkItem->CompletionStatus = XdpTxQueueEnableSegmentationOffload(Xsk->Tx.Xdp.Queue);
+        if (NT_SUCCESS(WorkItem->CompletionStatus)) {
+            const XDP_TX_CAPABILITIES *InterfaceCapabilities =
+                XdpTxQueueGetCapabilities(Xsk->Tx.Xdp.Queue);
+
+            //
+            // Frames larger than the MTU are accepted and segmented by the
+            // interface.
+            //
+            Xsk->Tx.Xdp.MaxFrameLength =
+                max(Xsk->Tx.Xdp.MaxFrameLength,
+                    InterfaceCapabilities->MaximumSegmentationOffloadSize);
+        }
+    } else {
+        WorkItem->CompletionStatus = STATUS_INVALID_DEVICE_STATE;
+    }
+
+    KeSetEvent(&WorkItem->CompletionEvent, 0, FALSE);
+}
+
 static
 VOID
 XskSetRxOffloadChecksumWorker(
@@ -4045,6 +4803,36 @@ XskSetRxOffloadChecksumWorker(
     KeSetEvent(&WorkItem->CompletionEvent, 0, FALSE);
 }
 
+static
+VOID
+XskSetRxZeroCopyWorker(
+    _In_ XDP_BINDING_WORKITEM *Item
+    )
+{
+    XSK_BINDING_WORKITEM *WorkItem = (XSK_BINDING_WORKITEM *)Item;
+    XSK *Xsk = WorkItem->Xsk;
+
+    if (Xsk->Rx.Xdp.Queue != NULL) {
+        //
+        // The RX queue holds a reference on the socket and its UMEM for as
+        // long as the socket's buffers may be posted to the interface.
+        //
+        XskReference(Xsk);
+        XskReferenceUmem(Xsk->Umem);
+
+        WorkItem->CompletionStatus = XdpRxQueueEnableBufferProvider(Xsk->Rx.Xdp.Queue, Xsk);
+
+        if (!NT_SUCCESS(WorkItem->CompletionStatus)) {
+            XskDereferenceUmem(Xsk->Umem);
+            XskDereference(Xsk);
+        }
+    } else {
+        WorkItem->CompletionStatus = STATUS_INVALID_DEVICE_STATE;
+    }
+
+    KeSetEvent(&WorkItem->CompletionEvent, 0, FALSE);
+}
+
 static
 NTSTATUS
 XskSockoptSetTxOffloadChecksum(
@@ -4144,7 +4932,7 @@ Exit:
 
 static
 NTSTATUS
-XskSockoptSetRxOffloadChecksum(
+XskSockoptSetTxOffloadGso(
     _In_ XSK *Xsk,
     _In_ XSK_SET_SOCKOPT_IN *Sockopt,
     _In_ KPROCESSOR_MODE RequestorMode
@@ -4191,8 +4979,8 @@ XskSockoptSetRxOffloadChecksum(
         Status = STATUS_INVALID_DEVICE_STATE;
         goto Exit;
     }
-    if (Xsk->Rx.ExtensionFlags.Checksum || Xsk->Rx.Xdp.Queue == NULL ||
-        Xsk->Rx.Ring.Size != 0 || Xsk->Rx.FillRing.Size != 0) {
+    if (Xsk->Tx.OffloadFlags.Gso || Xsk->Tx.Xdp.Queue == NULL ||
+        Xsk->Tx.Ring.Size != 0 || Xsk->Tx.CompletionRing.Size != 0) {
         Status = STATUS_INVALID_DEVICE_STATE;
         goto Exit;
     }
@@ -4203,8 +4991,8 @@ XskSockoptSetRxOffloadChecksum(
 
     KeInitializeEvent(&WorkItem.CompletionEvent, NotificationEvent, FALSE);
     WorkItem.Xsk = Xsk;
-    WorkItem.IfWorkItem.BindingHandle = Xsk->Rx.Xdp.IfHandle;
-    WorkItem.IfWorkItem.WorkRoutine = XskSetRxOffloadChecksumWorker;
+    WorkItem.IfWorkItem.BindingHandle = Xsk->Tx.Xdp.IfHandle;
+    WorkItem.IfWorkItem.WorkRoutine = XskSetTxOffloadGsoWorker;
     XdpIfQueueWorkItem(&WorkItem.IfWorkItem);
 
     KeReleaseSpinLock(&Xsk->Lock, OldIrql);
@@ -4219,10 +5007,10 @@ XskSockoptSetRxOffloadChecksum(
     KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
     IsLockHeld = TRUE;
 
-    XdpExtensionSetEnableEntry(Xsk->Rx.FrameExtensionSet, XDP_FRAME_EXTENSION_LAYOUT_NAME);
-    XdpExtensionSetEnableEntry(Xsk->Rx.FrameExtensionSet, XDP_FRAME_EXTENSION_CHECKSUM_NAME);
+    XdpExtensionSetEnableEntry(Xsk->Tx.FrameExtensionSet, XDP_FRAME_EXTENSION_LAYOUT_NAME);
+    XdpExtensionSetEnableEntry(Xsk->Tx.FrameExtensionSet, XDP_FRAME_EXTENSION_GSO_NAME);
 
-    Xsk->Rx.ExtensionFlags.Checksum = TRUE;
+    Xsk->Tx.OffloadFlags.Gso = TRUE;
     Status = STATUS_SUCCESS;
 
 Exit:
@@ -4239,27 +5027,9 @@ Exit:
     return Status;
 }
 
-static
-VOID
-XskSetRxOffloadTimestampWorker(
-    _In_ XDP_BINDING_WORKITEM *Item
-    )
-{
-    XSK_BINDING_WORKITEM *WorkItem = (XSK_BINDING_WORKITEM *)Item;
-    XSK *Xsk = WorkItem->Xsk;
-
-    if (Xsk->Rx.Xdp.Queue != NULL) {
-        WorkItem->CompletionStatus = XdpRxQueueEnableTimestampOffload(Xsk->Rx.Xdp.Queue);
-    } else {
-        WorkItem->CompletionStatus = STATUS_INVALID_DEVICE_STATE;
-    }
-
-    KeSetEvent(&WorkItem->CompletionEvent, IO_NO_INCREMENT, FALSE);
-}
-
 static
 NTSTATUS
-XskSockoptSetRxOffloadTimestamp(
+XskSockoptSetRxOffloadChecksum(
     _In_ XSK *Xsk,
     _In_ XSK_SET_SOCKOPT_IN *Sockopt,
     _In_ KPROCESSOR_MODE RequestorMode
@@ -4306,7 +5076,7 @@ XskSockoptSetRxOffloadTimestamp(
         Status = STATUS_INVALID_DEVICE_STATE;
         goto Exit;
     }
-    if (Xsk->Rx.ExtensionFlags.Timestamp || Xsk->Rx.Xdp.Queue == NULL ||
+    if (Xsk->Rx.ExtensionFlags.Checksum || Xsk->Rx.Xdp.Queue == NULL ||
         Xsk->Rx.Ring.Size != 0 || Xsk->Rx.FillRing.Size != 0) {
         Status = STATUS_INVALID_DEVICE_STATE;
         goto Exit;
@@ -4319,7 +5089,7 @@ XskSockoptSetRxOffloadTimestamp(
     KeInitializeEvent(&WorkItem.CompletionEvent, NotificationEvent, FALSE);
     WorkItem.Xsk = Xsk;
     WorkItem.IfWorkItem.BindingHandle = Xsk->Rx.Xdp.IfHandle;
-    WorkItem.IfWorkItem.WorkRoutine = XskSetRxOffloadTimestampWorker;
+    WorkItem.IfWorkItem.WorkRoutine = XskSetRxOffloadChecksumWorker;
     XdpIfQueueWorkItem(&WorkItem.IfWorkItem);
 
     KeReleaseSpinLock(&Xsk->Lock, OldIrql);
@@ -4334,9 +5104,10 @@ XskSockoptSetRxOffloadTimestamp(
     KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
     IsLockHeld = TRUE;
 
-    XdpExtensionSetEnableEntry(Xsk->Rx.FrameExtensionSet, XDP_FRAME_EXTENSION_TIMESTAMP_NAME);
+    XdpExtensionSetEnableEntry(Xsk->Rx.FrameExtensionSet, XDP_FRAME_EXTENSION_LAYOUT_NAME);
+    XdpExtensionSetEnableEntry(Xsk->Rx.FrameExtensionSet, XDP_FRAME_EXTENSION_CHECKSUM_NAME);
 
-    Xsk->Rx.ExtensionFlags.Timestamp = TRUE;
+    Xsk->Rx.ExtensionFlags.Checksum = TRUE;
     Status = STATUS_SUCCESS;
 
 Exit:
@@ -4353,27 +5124,9 @@ Exit:
     return Status;
 }
 
-static
-VOID
-XskSetTxOffloadTimestampWorker(
-    _In_ XDP_BINDING_WORKITEM *Item
-    )
-{
-    XSK_BINDING_WORKITEM *WorkItem = (XSK_BINDING_WORKITEM *)Item;
-    XSK *Xsk = WorkItem->Xsk;
-
-    if (Xsk->Tx.Xdp.Queue != NULL) {
-        WorkItem->CompletionStatus = XdpTxQueueEnableTimestampOffload(Xsk->Tx.Xdp.Queue);
-    } else {
-        WorkItem->CompletionStatus = STATUS_INVALID_DEVICE_STATE;
-    }
-
-    KeSetEvent(&WorkItem->CompletionEvent, IO_NO_INCREMENT, FALSE);
-}
-
 static
 NTSTATUS
-XskSockoptSetTxOffloadTimestamp(
+XskSockoptSetRxZeroCopy(
     _In_ XSK *Xsk,
     _In_ XSK_SET_SOCKOPT_IN *Sockopt,
     _In_ KPROCESSOR_MODE RequestorMode
@@ -4420,8 +5173,8 @@ XskSockoptSetTxOffloadTimestamp(
         Status = STATUS_INVALID_DEVICE_STATE;
         goto Exit;
     }
-    if (Xsk->Tx.OffloadFlags.Timestamp || Xsk->Tx.Xdp.Queue == NULL ||
-        Xsk->Tx.Ring.Size != 0 || Xsk->Tx.CompletionRing.Size != 0) {
+    if (Xsk->Rx.Flags.ZeroCopy || Xsk->Rx.Xdp.Queue == NULL || Xsk->Umem == NULL ||
+        Xsk->Rx.Ring.Size != 0 || Xsk->Rx.FillRing.Size != 0) {
         Status = STATUS_INVALID_DEVICE_STATE;
         goto Exit;
     }
@@ -4430,10 +5183,24 @@ XskSockoptSetTxOffloadTimestamp(
         goto Exit;
     }
 
+    if (Xsk->Rx.PostedChunks == NULL) {
+        UINT32 PostedChunkCount = (UINT32)(Xsk->Umem->Reg.TotalSize / Xsk->Umem->Reg.ChunkSize);
+
+        Xsk->Rx.PostedChunks =
+            ExAllocatePoolZero(
+                NonPagedPoolNx, (SIZE_T)PostedChunkCount * sizeof(*Xsk->Rx.PostedChunks),
+                POOLTAG_XSK);
+        if (Xsk->Rx.PostedChunks == NULL) {
+            Status = STATUS_NO_MEMORY;
+            goto Exit;
+        }
+        Xsk->Rx.PostedChunkCount = PostedChunkCount;
+    }
+
     KeInitializeEvent(&WorkItem.CompletionEvent, NotificationEvent, FALSE);
     WorkItem.Xsk = Xsk;
-    WorkItem.IfWorkItem.BindingHandle = Xsk->Tx.Xdp.IfHandle;
-    WorkItem.IfWorkItem.WorkRoutine = XskSetTxOffloadTimestampWorker;
+    WorkItem.IfWorkItem.BindingHandle = Xsk->Rx.Xdp.IfHandle;
+    WorkItem.IfWorkItem.WorkRoutine = XskSetRxZeroCopyWorker;
     XdpIfQueueWorkItem(&WorkItem.IfWorkItem);
 
     KeReleaseSpinLock(&Xsk->Lock, OldIrql);
@@ -4448,9 +5215,7 @@ XskSockoptSetTxOffloadTimestamp(
     KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
     IsLockHeld = TRUE;
 
-    XdpExtensionSetEnableEntry(Xsk->Tx.CompletionExtensionSet, XDP_FRAME_EXTENSION_TIMESTAMP_NAME);
-
-    Xsk->Tx.OffloadFlags.Timestamp = TRUE;
+    Xsk->Rx.Flags.ZeroCopy = TRUE;
     Status = STATUS_SUCCESS;
 
 Exit:
@@ -4467,9 +5232,27 @@ Exit:
     return Status;
 }
 
+static
+VOID
+XskSetRxOffloadTimestampWorker(
+    _In_ XDP_BINDING_WORKITEM *Item
+    )
+{
+    XSK_BINDING_WORKITEM *WorkItem = (XSK_BINDING_WORKITEM *)Item;
+    XSK *Xsk = WorkItem->Xsk;
+
+    if (Xsk->Rx.Xdp.Queue != NULL) {
+        WorkItem->CompletionStatus = XdpRxQueueEnableTimestampOffload(Xsk->Rx.Xdp.Queue);
+    } else {
+        WorkItem->CompletionStatus = STATUS_INVALID_DEVICE_STATE;
+    }
+
+    KeSetEvent(&WorkItem->CompletionEvent, IO_NO_INCREMENT, FALSE);
+}
+
 static
 NTSTATUS
-XskSockoptSetRxOriginalLength(
+XskSockoptSetRxOffloadTimestamp(
     _In_ XSK *Xsk,
     _In_ XSK_SET_SOCKOPT_IN *Sockopt,
     _In_ KPROCESSOR_MODE RequestorMode
@@ -4482,6 +5265,7 @@ XskSockoptSetRxOriginalLength(
     KIRQL OldIrql = {0};
     BOOLEAN IsLockHeld = FALSE;
     BOOLEAN IsPushLockHeld = FALSE;
+    XSK_BINDING_WORKITEM WorkItem = {0};
 
     TraceEnter(TRACE_XSK, "Xsk=%p", Xsk);
 
@@ -4515,7 +5299,7 @@ XskSockoptSetRxOriginalLength(
         Status = STATUS_INVALID_DEVICE_STATE;
         goto Exit;
     }
-    if (Xsk->Rx.ExtensionFlags.OriginalLength || Xsk->Rx.Xdp.Queue == NULL ||
+    if (Xsk->Rx.ExtensionFlags.Timestamp || Xsk->Rx.Xdp.Queue == NULL ||
         Xsk->Rx.Ring.Size != 0 || Xsk->Rx.FillRing.Size != 0) {
         Status = STATUS_INVALID_DEVICE_STATE;
         goto Exit;
@@ -4525,16 +5309,34 @@ XskSockoptSetRxOriginalLength(
         goto Exit;
     }
 
-    XdpExtensionSetEnableEntry(Xsk->Rx.FrameExtensionSet, XSK_FRAME_EXTENSION_ORIGINAL_LENGTH_NAME);
-
-    Xsk->Rx.ExtensionFlags.OriginalLength = TRUE;
-    Status = STATUS_SUCCESS;
+    KeInitializeEvent(&WorkItem.CompletionEvent, NotificationEvent, FALSE);
+    WorkItem.Xsk = Xsk;
+    WorkItem.IfWorkItem.BindingHandle = Xsk->Rx.Xdp.IfHandle;
+    WorkItem.IfWorkItem.WorkRoutine = XskSetRxOffloadTimestampWorker;
+    XdpIfQueueWorkItem(&WorkItem.IfWorkItem);
 
-Exit:
+    KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+    IsLockHeld = FALSE;
 
-    if (IsLockHeld) {
-        KeReleaseSpinLock(&Xsk->Lock, OldIrql);
-    }
+    KeWaitForSingleObject(&WorkItem.CompletionEvent, Executive, KernelMode, FALSE, NULL);
+    if (!NT_SUCCESS(WorkItem.CompletionStatus)) {
+        Status = WorkItem.CompletionStatus;
+        goto Exit;
+    }
+
+    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
+    IsLockHeld = TRUE;
+
+    XdpExtensionSetEnableEntry(Xsk->Rx.FrameExtensionSet, XDP_FRAME_EXTENSION_TIMESTAMP_NAME);
+
+    Xsk->Rx.ExtensionFlags.Timestamp = TRUE;
+    Status = STATUS_SUCCESS;
+
+Exit:
+
+    if (IsLockHeld) {
+        KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+    }
     if (IsPushLockHeld) {
         RtlReleasePushLockExclusive(&Xsk->PushLock);
     }
@@ -4545,340 +5347,315 @@ Exit:
 }
 
 static
-NTSTATUS
-XskSockoptGetError(
-    _In_ XSK *Xsk,
-    _In_ UINT32 Option,
-    _In_ IRP *Irp,
-    _In_ IO_STACK_LOCATION *IrpSp
+VOID
+XskSetRxOffloadGroWorker(
+    _In_ XDP_BINDING_WORKITEM *Item
     )
 {
-    NTSTATUS Status;
-    XSK_ERROR *XskError = Irp->AssociatedIrp.SystemBuffer;
-
-    TraceEnter(TRACE_XSK, "Xsk=%p", Xsk);
-
-    if (IrpSp->Parameters.DeviceIoControl.OutputBufferLength < sizeof(*XskError)) {
-        Status = STATUS_INVALID_PARAMETER;
-        goto Exit;
-    }
-
-    switch (Option) {
-    case XSK_SOCKOPT_RX_ERROR:
-        *XskError = Xsk->Rx.Ring.Error;
-        break;
-
-    case XSK_SOCKOPT_RX_FILL_ERROR:
-        *XskError = Xsk->Rx.FillRing.Error;
-        break;
-
-    case XSK_SOCKOPT_TX_ERROR:
-        *XskError = Xsk->Tx.Ring.Error;
-        break;
-
-    case XSK_SOCKOPT_TX_COMPLETION_ERROR:
-        *XskError = Xsk->Tx.CompletionRing.Error;
-        break;
+    XSK_BINDING_WORKITEM *WorkItem = (XSK_BINDING_WORKITEM *)Item;
+    XSK *Xsk = WorkItem->Xsk;
 
-    default:
-        Status = STATUS_NOT_SUPPORTED;
-        goto Exit;
+    if (Xsk->Rx.Xdp.Queue != NULL) {
+        //
+        // Coalesced frames must fit in a single UMEM chunk after headroom.
+        //
+        WorkItem->CompletionStatus =
+            XdpRxQueueEnableGroOffload(
+                Xsk->Rx.Xdp.Queue, Xsk->Umem->Reg.ChunkSize - Xsk->Umem->Reg.Headroom);
+    } else {
+        WorkItem->CompletionStatus = STATUS_INVALID_DEVICE_STATE;
     }
 
-    Status = STATUS_SUCCESS;
-    Irp->IoStatus.Information = sizeof(*XskError);
-
-Exit:
-
-    TraceExitStatus(TRACE_XSK);
-
-    return Status;
+    KeSetEvent(&WorkItem->CompletionEvent, IO_NO_INCREMENT, FALSE);
 }
 
 static
 NTSTATUS
-XskSockoptGetExtension(
+XskSockoptSetRxOffloadGro(
     _In_ XSK *Xsk,
-    _In_ UINT32 Option,
-    _In_ IRP *Irp,
-    _In_ IO_STACK_LOCATION *IrpSp
+    _In_ XSK_SET_SOCKOPT_IN *Sockopt,
+    _In_ KPROCESSOR_MODE RequestorMode
     )
 {
     NTSTATUS Status;
-    UINT16 *ExtensionOut = Irp->AssociatedIrp.SystemBuffer;
-    XDP_EXTENSION_INFO ExtensionInfo;
-    XDP_EXTENSION Extension;
-    XDP_EXTENSION_SET *ExtensionSet;
+    const VOID *SockoptIn;
+    UINT32 SockoptInSize;
+    UINT32 Enabled;
+    KIRQL OldIrql = {0};
+    BOOLEAN IsLockHeld = FALSE;
+    BOOLEAN IsPushLockHeld = FALSE;
+    XSK_BINDING_WORKITEM WorkItem = {0};
 
     TraceEnter(TRACE_XSK, "Xsk=%p", Xsk);
 
-    if (IrpSp->Parameters.DeviceIoControl.OutputBufferLength < sizeof(*ExtensionOut)) {
-        Status = STATUS_INVALID_PARAMETER;
+    //
+    // This is a nested buffer not copied by IO manager, so it needs special care.
+    //
+    SockoptIn = Sockopt->InputBuffer;
+    SockoptInSize = Sockopt->InputBufferLength;
+
+    if (SockoptInSize < sizeof(Enabled)) {
+        Status = STATUS_BUFFER_TOO_SMALL;
         goto Exit;
     }
 
-    RtlAcquirePushLockExclusive(&Xsk->PushLock);
-
-    switch (Option) {
-    case XSK_SOCKOPT_TX_FRAME_LAYOUT_EXTENSION:
-        ExtensionSet = Xsk->Tx.FrameExtensionSet;
-        XdpInitializeExtensionInfo(
-            &ExtensionInfo, XDP_FRAME_EXTENSION_LAYOUT_NAME,
-            XDP_FRAME_EXTENSION_LAYOUT_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
-        break;
-
-    case XSK_SOCKOPT_TX_FRAME_CHECKSUM_EXTENSION:
-        ExtensionSet = Xsk->Tx.FrameExtensionSet;
-        XdpInitializeExtensionInfo(
-            &ExtensionInfo, XDP_FRAME_EXTENSION_CHECKSUM_NAME,
-            XDP_FRAME_EXTENSION_CHECKSUM_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
-        break;
-
-    case XSK_SOCKOPT_RX_FRAME_CHECKSUM_EXTENSION:
-        ExtensionSet = Xsk->Rx.FrameExtensionSet;
-        XdpInitializeExtensionInfo(
-            &ExtensionInfo, XDP_FRAME_EXTENSION_CHECKSUM_NAME,
-            XDP_FRAME_EXTENSION_CHECKSUM_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
-        break;
+    __try {
+        if (RequestorMode != KernelMode) {
+            ProbeForRead((VOID*)SockoptIn, SockoptInSize, PROBE_ALIGNMENT(UINT32));
+        }
+        RtlCopyVolatileMemory(&Enabled, SockoptIn, sizeof(Enabled));
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        Status = GetExceptionCode();
+        goto Exit;
+    }
 
-    case XSK_SOCKOPT_RX_FRAME_LAYOUT_EXTENSION:
-        ExtensionSet = Xsk->Rx.FrameExtensionSet;
-        XdpInitializeExtensionInfo(
-            &ExtensionInfo, XDP_FRAME_EXTENSION_LAYOUT_NAME,
-            XDP_FRAME_EXTENSION_LAYOUT_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
-        break;
+    RtlAcquirePushLockExclusive(&Xsk->PushLock);
+    IsPushLockHeld = TRUE;
+    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
+    IsLockHeld = TRUE;
 
-    case XSK_SOCKOPT_RX_FRAME_ORIGINAL_LENGTH_EXTENSION:
-        ExtensionSet = Xsk->Rx.FrameExtensionSet;
-        XdpInitializeExtensionInfo(
-            &ExtensionInfo, XSK_FRAME_EXTENSION_ORIGINAL_LENGTH_NAME,
-            XSK_FRAME_EXTENSION_ORIGINAL_LENGTH_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
-        break;
+    if (Xsk->State != XskBound) {
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+    if (Xsk->Rx.ExtensionFlags.Gro || Xsk->Rx.Xdp.Queue == NULL || Xsk->Umem == NULL ||
+        Xsk->Rx.Ring.Size != 0 || Xsk->Rx.FillRing.Size != 0) {
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+    if (!Enabled) {
+        Status = STATUS_SUCCESS;
+        goto Exit;
+    }
 
-    case XSK_SOCKOPT_RX_FRAME_TIMESTAMP_EXTENSION:
-        ExtensionSet = Xsk->Rx.FrameExtensionSet;
-        XdpInitializeExtensionInfo(
-            &ExtensionInfo, XDP_FRAME_EXTENSION_TIMESTAMP_NAME,
-            XDP_FRAME_EXTENSION_TIMESTAMP_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
-        break;
+    KeInitializeEvent(&WorkItem.CompletionEvent, NotificationEvent, FALSE);
+    WorkItem.Xsk = Xsk;
+    WorkItem.IfWorkItem.BindingHandle = Xsk->Rx.Xdp.IfHandle;
+    WorkItem.IfWorkItem.WorkRoutine = XskSetRxOffloadGroWorker;
+    XdpIfQueueWorkItem(&WorkItem.IfWorkItem);
 
-    case XSK_SOCKOPT_TX_FRAME_TIMESTAMP_EXTENSION:
-        ExtensionSet = Xsk->Tx.CompletionExtensionSet;
-        XdpInitializeExtensionInfo(
-            &ExtensionInfo, XDP_FRAME_EXTENSION_TIMESTAMP_NAME,
-            XDP_FRAME_EXTENSION_TIMESTAMP_VERSION_1, XDP_EXTENSION_TYPE_TX_FRAME_COMPLETION);
-        break;
+    KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+    IsLockHeld = FALSE;
 
-    default:
-        Status = STATUS_NOT_SUPPORTED;
+    KeWaitForSingleObject(&WorkItem.CompletionEvent, Executive, KernelMode, FALSE, NULL);
+    if (!NT_SUCCESS(WorkItem.CompletionStatus)) {
+        Status = WorkItem.CompletionStatus;
         goto Exit;
     }
 
-    if (!XdpExtensionSetIsLayoutAssigned(ExtensionSet) ||
-        !XdpExtensionSetIsExtensionEnabled(ExtensionSet, ExtensionInfo.ExtensionName)) {
-        Status = STATUS_NOT_FOUND;
-        goto Exit;
-    }
+    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
+    IsLockHeld = TRUE;
 
-    XdpExtensionSetGetExtension(ExtensionSet, &ExtensionInfo, &Extension);
+    XdpExtensionSetEnableEntry(Xsk->Rx.FrameExtensionSet, XDP_FRAME_EXTENSION_GRO_NAME);
 
-    *ExtensionOut = Extension.Reserved;
-    Irp->IoStatus.Information = sizeof(*ExtensionOut);
+    Xsk->Rx.ExtensionFlags.Gro = TRUE;
     Status = STATUS_SUCCESS;
 
 Exit:
 
-    RtlReleasePushLockExclusive(&Xsk->PushLock);
+    if (IsLockHeld) {
+        KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+    }
+    if (IsPushLockHeld) {
+        RtlReleasePushLockExclusive(&Xsk->PushLock);
+    }
 
     TraceExitStatus(TRACE_XSK);
 
     return Status;
 }
 
-typedef
-XDP_IF_OFFLOAD_HANDLE
-XSK_GET_IF_OFFLOAD_HANDLE(
-    _In_ XSK *Xsk
-    );
-
 static
-XDP_IF_OFFLOAD_HANDLE
-XskSockoptGetTxOffloadHandle(
-    _In_ XSK *Xsk
+VOID
+XskSetTxOffloadTimestampWorker(
+    _In_ XDP_BINDING_WORKITEM *Item
     )
 {
-    if (Xsk->Tx.Xdp.Queue == NULL) {
-        return NULL;
-    }
-
-    return XdpTxQueueGetInterfaceOffloadHandle(Xsk->Tx.Xdp.Queue);
-}
+    XSK_BINDING_WORKITEM *WorkItem = (XSK_BINDING_WORKITEM *)Item;
+    XSK *Xsk = WorkItem->Xsk;
 
-static
-XDP_IF_OFFLOAD_HANDLE
-XskSockoptGetRxOffloadHandle(
-    _In_ XSK *Xsk
-    )
-{
-    if (Xsk->Rx.Xdp.Queue == NULL) {
-        return NULL;
+    if (Xsk->Tx.Xdp.Queue != NULL) {
+        WorkItem->CompletionStatus = XdpTxQueueEnableTimestampOffload(Xsk->Tx.Xdp.Queue);
+    } else {
+        WorkItem->CompletionStatus = STATUS_INVALID_DEVICE_STATE;
     }
 
-    return XdpRxQueueGetInterfaceOffloadHandle(Xsk->Rx.Xdp.Queue);
+    KeSetEvent(&WorkItem->CompletionEvent, IO_NO_INCREMENT, FALSE);
 }
 
-typedef struct _XSK_OFFLOAD_WORKITEM {
-    XDP_BINDING_WORKITEM IfWorkItem;
-    XSK *Xsk;
-    XSK_GET_IF_OFFLOAD_HANDLE *GetIfOffloadHandle;
-    XDP_INTERFACE_OFFLOAD_TYPE OffloadType;
-    UINT32 OffloadParamsSize;
-    VOID *OutputBuffer;
-    KEVENT CompletionEvent;
-    NTSTATUS CompletionStatus;
-} XSK_OFFLOAD_WORKITEM;
-
 static
-VOID
-XskGetOffloadWorker(
-    _In_ XDP_BINDING_WORKITEM *Item
+NTSTATUS
+XskSockoptSetTxOffloadTimestamp(
+    _In_ XSK *Xsk,
+    _In_ XSK_SET_SOCKOPT_IN *Sockopt,
+    _In_ KPROCESSOR_MODE RequestorMode
     )
 {
-    XSK_OFFLOAD_WORKITEM *WorkItem = CONTAINING_RECORD(Item, XSK_OFFLOAD_WORKITEM, IfWorkItem);
-    XSK *Xsk = WorkItem->Xsk;
     NTSTATUS Status;
+    const VOID *SockoptIn;
+    UINT32 SockoptInSize;
+    UINT32 Enabled;
+    KIRQL OldIrql = {0};
+    BOOLEAN IsLockHeld = FALSE;
+    BOOLEAN IsPushLockHeld = FALSE;
+    XSK_BINDING_WORKITEM WorkItem = {0};
 
-    TraceEnter(TRACE_XSK, "Xsk=%p", Xsk);
-
-    if (WorkItem->OffloadType == XdpTxOffloadChecksum && Xsk->Tx.Xdp.Queue == NULL) {
-        Status = STATUS_INVALID_DEVICE_STATE;
+    TraceEnter(TRACE_XSK, "Xsk=%p", Xsk);
+
+    //
+    // This is a nested buffer not copied by IO manager, so it needs special care.
+    //
+    SockoptIn = Sockopt->InputBuffer;
+    SockoptInSize = Sockopt->InputBufferLength;
+
+    if (SockoptInSize < sizeof(Enabled)) {
+        Status = STATUS_BUFFER_TOO_SMALL;
         goto Exit;
     }
 
-    if (WorkItem->OffloadType == XdpRxOffloadChecksum && Xsk->Rx.Xdp.Queue == NULL) {
-        Status = STATUS_INVALID_DEVICE_STATE;
+    __try {
+        if (RequestorMode != KernelMode) {
+            ProbeForRead((VOID*)SockoptIn, SockoptInSize, PROBE_ALIGNMENT(UINT32));
+        }
+        RtlCopyVolatileMemory(&Enabled, SockoptIn, sizeof(Enabled));
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        Status = GetExceptionCode();
         goto Exit;
     }
 
-    XDP_IF_OFFLOAD_HANDLE OffloadHandle = WorkItem->GetIfOffloadHandle(Xsk);
-    if (OffloadHandle == NULL) {
+    RtlAcquirePushLockExclusive(&Xsk->PushLock);
+    IsPushLockHeld = TRUE;
+    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
+    IsLockHeld = TRUE;
+
+    if (Xsk->State != XskBound) {
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+    if (Xsk->Tx.OffloadFlags.Timestamp || Xsk->Tx.Xdp.Queue == NULL ||
+        Xsk->Tx.Ring.Size != 0 || Xsk->Tx.CompletionRing.Size != 0) {
         Status = STATUS_INVALID_DEVICE_STATE;
         goto Exit;
     }
+    if (!Enabled) {
+        Status = STATUS_SUCCESS;
+        goto Exit;
+    }
 
-    Status =
-        XdpIfGetInterfaceOffload(
-            XdpIfGetIfSetHandle(Item->BindingHandle), OffloadHandle,
-            WorkItem->OffloadType, WorkItem->OutputBuffer, &WorkItem->OffloadParamsSize);
-    if (!NT_SUCCESS(Status)) {
+    KeInitializeEvent(&WorkItem.CompletionEvent, NotificationEvent, FALSE);
+    WorkItem.Xsk = Xsk;
+    WorkItem.IfWorkItem.BindingHandle = Xsk->Tx.Xdp.IfHandle;
+    WorkItem.IfWorkItem.WorkRoutine = XskSetTxOffloadTimestampWorker;
+    XdpIfQueueWorkItem(&WorkItem.IfWorkItem);
+
+    KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+    IsLockHeld = FALSE;
+
+    KeWaitForSingleObject(&WorkItem.CompletionEvent, Executive, KernelMode, FALSE, NULL);
+    if (!NT_SUCCESS(WorkItem.CompletionStatus)) {
+        Status = WorkItem.CompletionStatus;
         goto Exit;
     }
 
+    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
+    IsLockHeld = TRUE;
+
+    XdpExtensionSetEnableEntry(Xsk->Tx.CompletionExtensionSet, XDP_FRAME_EXTENSION_TIMESTAMP_NAME);
+
+    Xsk->Tx.OffloadFlags.Timestamp = TRUE;
+    Status = STATUS_SUCCESS;
+
 Exit:
 
+    if (IsLockHeld) {
+        KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+    }
+    if (IsPushLockHeld) {
+        RtlReleasePushLockExclusive(&Xsk->PushLock);
+    }
+
     TraceExitStatus(TRACE_XSK);
 
-    WorkItem->CompletionStatus = Status;
-    NT_VERIFY(NT_SUCCESS(KeSetEvent(&WorkItem->CompletionEvent, IO_NO_INCREMENT, FALSE)));
+    return Status;
 }
 
 static
 NTSTATUS
-XskSockoptGetOffload(
+XskSockoptSetRxMultiBuffer(
     _In_ XSK *Xsk,
-    _In_ UINT32 Option,
-    _In_ IRP *Irp,
-    _In_ IO_STACK_LOCATION *IrpSp
+    _In_ XSK_SET_SOCKOPT_IN *Sockopt,
+    _In_ KPROCESSOR_MODE RequestorMode
     )
 {
     NTSTATUS Status;
-    KIRQL OldIrql;
+    const VOID *SockoptIn;
+    UINT32 SockoptInSize;
+    UINT32 Enabled;
+    KIRQL OldIrql = {0};
     BOOLEAN IsLockHeld = FALSE;
-    XSK_OFFLOAD_WORKITEM WorkItem;
-    XSK_SHARED_RING *Ring = NULL;
-    VOID *OutputBuffer = Irp->AssociatedIrp.SystemBuffer;
-    UINT32 OutputBufferLength = IrpSp->Parameters.DeviceIoControl.OutputBufferLength;
-    SIZE_T *BytesReturned = &Irp->IoStatus.Information;
-    BOOLEAN ResetChangeFlag = FALSE;
+    BOOLEAN IsPushLockHeld = FALSE;
 
     TraceEnter(TRACE_XSK, "Xsk=%p", Xsk);
 
-    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
-    IsLockHeld = TRUE;
+    //
+    // This is a nested buffer not copied by IO manager, so it needs special care.
+    //
+    SockoptIn = Sockopt->InputBuffer;
+    SockoptInSize = Sockopt->InputBufferLength;
 
-    switch (Option) {
-    case XSK_SOCKOPT_TX_OFFLOAD_CURRENT_CONFIG_CHECKSUM:
-        if (Xsk->Tx.Xdp.IfHandle == NULL) {
-            Status = STATUS_INVALID_DEVICE_STATE;
-            goto Exit;
-        }
-        WorkItem.IfWorkItem.BindingHandle = Xsk->Tx.Xdp.IfHandle;
-        WorkItem.GetIfOffloadHandle = XskSockoptGetTxOffloadHandle;
-        WorkItem.OffloadType = XdpTxOffloadChecksum;
-        Ring = Xsk->Tx.Ring.Shared;
-        Xsk->Tx.OffloadChangeFlags.CurrentConfig = FALSE;
-        ResetChangeFlag = Xsk->Tx.OffloadChangeFlags.Value == 0;
-        break;
+    if (SockoptInSize < sizeof(Enabled)) {
+        Status = STATUS_BUFFER_TOO_SMALL;
+        goto Exit;
+    }
 
-    case XSK_SOCKOPT_RX_OFFLOAD_CURRENT_CONFIG_CHECKSUM:
-        if (Xsk->Rx.Xdp.IfHandle == NULL) {
-            Status = STATUS_INVALID_DEVICE_STATE;
-            goto Exit;
+    __try {
+        if (RequestorMode != KernelMode) {
+            ProbeForRead((VOID*)SockoptIn, SockoptInSize, PROBE_ALIGNMENT(UINT32));
         }
-        WorkItem.IfWorkItem.BindingHandle = Xsk->Rx.Xdp.IfHandle;
-        WorkItem.GetIfOffloadHandle = XskSockoptGetRxOffloadHandle;
-        WorkItem.OffloadType = XdpRxOffloadChecksum;
-        Ring = Xsk->Rx.Ring.Shared;
-        Xsk->Rx.OffloadChangeFlags.CurrentConfig = FALSE;
-        ResetChangeFlag = Xsk->Rx.OffloadChangeFlags.Value == 0;
-        break;
-
-    default:
-        Status = STATUS_NOT_SUPPORTED;
+        RtlCopyVolatileMemory(&Enabled, SockoptIn, sizeof(Enabled));
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        Status = GetExceptionCode();
         goto Exit;
     }
 
-    ASSERT(WorkItem.IfWorkItem.BindingHandle != NULL);
-    ASSERT(WorkItem.GetIfOffloadHandle != NULL);
+    RtlAcquirePushLockExclusive(&Xsk->PushLock);
+    IsPushLockHeld = TRUE;
+    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
+    IsLockHeld = TRUE;
 
-    if (Ring != NULL && ResetChangeFlag) {
-        InterlockedAndNoFence((LONG *)&Ring->Flags, ~XSK_RING_FLAG_OFFLOAD_CHANGED);
+    if (Xsk->State != XskBound) {
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
     }
-
-    KeInitializeEvent(&WorkItem.CompletionEvent, NotificationEvent, FALSE);
-    WorkItem.Xsk = Xsk;
-    WorkItem.IfWorkItem.WorkRoutine = XskGetOffloadWorker;
-    WorkItem.OffloadParamsSize = OutputBufferLength;
-    WorkItem.OutputBuffer = OutputBuffer;
-    XdpIfQueueWorkItem(&WorkItem.IfWorkItem);
-
-    KeReleaseSpinLock(&Xsk->Lock, OldIrql);
-    IsLockHeld = FALSE;
-
-    KeWaitForSingleObject(
-        &WorkItem.CompletionEvent, Executive, KernelMode, FALSE, NULL);
-
-    Status = WorkItem.CompletionStatus;
-    if (!NT_SUCCESS(Status)) {
+    if (Xsk->Rx.Flags.MultiBuffer || Xsk->Rx.Xdp.Queue == NULL || Xsk->Umem == NULL ||
+        Xsk->Rx.Ring.Size != 0 || Xsk->Rx.FillRing.Size != 0) {
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+    if (!Enabled) {
+        Status = STATUS_SUCCESS;
         goto Exit;
     }
 
-    *BytesReturned = WorkItem.OffloadParamsSize;
-
-    if ((OutputBufferLength == 0) && (Irp->Flags & IRP_INPUT_OPERATION) == 0) {
-        Status = STATUS_BUFFER_OVERFLOW;
+    //
+    // Every buffer in a chain must be able to hold at least one byte of data.
+    //
+    if (Xsk->Umem->Reg.Headroom >= Xsk->Umem->Reg.ChunkSize) {
+        Status = STATUS_INVALID_PARAMETER;
         goto Exit;
     }
 
+    Xsk->Rx.Flags.MultiBuffer = TRUE;
+    Status = STATUS_SUCCESS;
+
 Exit:
 
     if (IsLockHeld) {
         KeReleaseSpinLock(&Xsk->Lock, OldIrql);
     }
-
-    TraceInfo(
-        TRACE_XSK, "Xsk=%p Status=%!STATUS! OutputBuffer=%!HEXDUMP!",
-        Xsk, Status, WppHexDump(OutputBuffer, OutputBufferLength));
+    if (IsPushLockHeld) {
+        RtlReleasePushLockExclusive(&Xsk->PushLock);
+    }
 
     TraceExitStatus(TRACE_XSK);
 
@@ -4886,48 +5663,480 @@ Exit:
 }
 
 static
-UINT32
-XskQueryReadyIo(
-    _In_ XSK* Xsk,
-    _In_ UINT32 InFlags
+NTSTATUS
+XskSockoptSetRxOriginalLength(
+    _In_ XSK *Xsk,
+    _In_ XSK_SET_SOCKOPT_IN *Sockopt,
+    _In_ KPROCESSOR_MODE RequestorMode
     )
 {
-    UINT32 SatisfiedFlags = 0;
-
-    if (InFlags & XSK_NOTIFY_FLAG_WAIT_TX && !XskRingProdIsEmpty(&Xsk->Tx.CompletionRing)) {
-        SatisfiedFlags |= XSK_NOTIFY_FLAG_WAIT_TX;
-    }
-    if (InFlags & XSK_NOTIFY_FLAG_WAIT_RX && !XskRingProdIsEmpty(&Xsk->Rx.Ring)) {
-        SatisfiedFlags |= XSK_NOTIFY_FLAG_WAIT_RX;
-    }
+    NTSTATUS Status;
+    const VOID *SockoptIn;
+    UINT32 SockoptInSize;
+    UINT32 Enabled;
+    KIRQL OldIrql = {0};
+    BOOLEAN IsLockHeld = FALSE;
+    BOOLEAN IsPushLockHeld = FALSE;
 
-    return SatisfiedFlags;
-}
+    TraceEnter(TRACE_XSK, "Xsk=%p", Xsk);
 
-static
-_Requires_exclusive_lock_held_(&Xsk->PollLock)
-BOOLEAN
-XskPollInvoke(
-    _In_ XSK *Xsk,
-    _In_ UINT32 RxQuota,
-    _In_ UINT32 TxQuota
-    )
-{
-    BOOLEAN MoreData = FALSE;
+    //
+    // This is a nested buffer not copied by IO manager, so it needs special care.
+    //
+    SockoptIn = Sockopt->InputBuffer;
+    SockoptInSize = Sockopt->InputBufferLength;
 
-    ASSERT(Xsk->Rx.Xdp.PollHandle != NULL || Xsk->Tx.Xdp.PollHandle != NULL);
+    if (SockoptInSize < sizeof(Enabled)) {
+        Status = STATUS_BUFFER_TOO_SMALL;
+        goto Exit;
+    }
 
-    if (Xsk->Rx.Xdp.PollHandle == Xsk->Tx.Xdp.PollHandle) {
-        //
-        // Typically the RX and TX poll contexts are the same.
-        //
-        MoreData = XdpPollInvoke(Xsk->Rx.Xdp.PollHandle, RxQuota, TxQuota);
-    } else {
-        if (Xsk->Rx.Xdp.PollHandle != NULL) {
-            MoreData |= XdpPollInvoke(Xsk->Rx.Xdp.PollHandle, RxQuota, TxQuota);
-        }
-        if (Xsk->Tx.Xdp.PollHandle != NULL) {
-            MoreData |= XdpPollInvoke(Xsk->Tx.Xdp.PollHandle, RxQuota, TxQuota);
+    __try {
+        if (RequestorMode != KernelMode) {
+            ProbeForRead((VOID*)SockoptIn, SockoptInSize, PROBE_ALIGNMENT(UINT32));
+        }
+        RtlCopyVolatileMemory(&Enabled, SockoptIn, sizeof(Enabled));
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        Status = GetExceptionCode();
+        goto Exit;
+    }
+
+    RtlAcquirePushLockExclusive(&Xsk->PushLock);
+    IsPushLockHeld = TRUE;
+    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
+    IsLockHeld = TRUE;
+
+    if (Xsk->State != XskBound) {
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+    if (Xsk->Rx.ExtensionFlags.OriginalLength || Xsk->Rx.Xdp.Queue == NULL ||
+        Xsk->Rx.Ring.Size != 0 || Xsk->Rx.FillRing.Size != 0) {
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+    if (!Enabled) {
+        Status = STATUS_SUCCESS;
+        goto Exit;
+    }
+
+    XdpExtensionSetEnableEntry(Xsk->Rx.FrameExtensionSet, XSK_FRAME_EXTENSION_ORIGINAL_LENGTH_NAME);
+
+    Xsk->Rx.ExtensionFlags.OriginalLength = TRUE;
+    Status = STATUS_SUCCESS;
+
+Exit:
+
+    if (IsLockHeld) {
+        KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+    }
+    if (IsPushLockHeld) {
+        RtlReleasePushLockExclusive(&Xsk->PushLock);
+    }
+
+    TraceExitStatus(TRACE_XSK);
+
+    return Status;
+}
+
+static
+NTSTATUS
+XskSockoptGetError(
+    _In_ XSK *Xsk,
+    _In_ UINT32 Option,
+    _In_ IRP *Irp,
+    _In_ IO_STACK_LOCATION *IrpSp
+    )
+{
+    NTSTATUS Status;
+    XSK_ERROR *XskError = Irp->AssociatedIrp.SystemBuffer;
+
+    TraceEnter(TRACE_XSK, "Xsk=%p", Xsk);
+
+    if (IrpSp->Parameters.DeviceIoControl.OutputBufferLength < sizeof(*XskError)) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto Exit;
+    }
+
+    switch (Option) {
+    case XSK_SOCKOPT_RX_ERROR:
+        *XskError = Xsk->Rx.Ring.Error;
+        break;
+
+    case XSK_SOCKOPT_RX_FILL_ERROR:
+        *XskError = Xsk->Rx.FillRing.Error;
+        break;
+
+    case XSK_SOCKOPT_TX_ERROR:
+        *XskError = Xsk->Tx.Ring.Error;
+        break;
+
+    case XSK_SOCKOPT_TX_COMPLETION_ERROR:
+        *XskError = Xsk->Tx.CompletionRing.Error;
+        break;
+
+    default:
+        Status = STATUS_NOT_SUPPORTED;
+        goto Exit;
+    }
+
+    Status = STATUS_SUCCESS;
+    Irp->IoStatus.Information = sizeof(*XskError);
+
+Exit:
+
+    TraceExitStatus(TRACE_XSK);
+
+    return Status;
+}
+
+static
+NTSTATUS
+XskSockoptGetExtension(
+    _In_ XSK *Xsk,
+    _In_ UINT32 Option,
+    _In_ IRP *Irp,
+    _In_ IO_STACK_LOCATION *IrpSp
+    )
+{
+    NTSTATUS Status;
+    UINT16 *ExtensionOut = Irp->AssociatedIrp.SystemBuffer;
+    XDP_EXTENSION_INFO ExtensionInfo;
+    XDP_EXTENSION Extension;
+    XDP_EXTENSION_SET *ExtensionSet;
+
+    TraceEnter(TRACE_XSK, "Xsk=%p", Xsk);
+
+    if (IrpSp->Parameters.DeviceIoControl.OutputBufferLength < sizeof(*ExtensionOut)) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto Exit;
+    }
+
+    RtlAcquirePushLockExclusive(&Xsk->PushLock);
+
+    switch (Option) {
+    case XSK_SOCKOPT_TX_FRAME_LAYOUT_EXTENSION:
+        ExtensionSet = Xsk->Tx.FrameExtensionSet;
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_LAYOUT_NAME,
+            XDP_FRAME_EXTENSION_LAYOUT_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        break;
+
+    case XSK_SOCKOPT_TX_FRAME_CHECKSUM_EXTENSION:
+        ExtensionSet = Xsk->Tx.FrameExtensionSet;
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_CHECKSUM_NAME,
+            XDP_FRAME_EXTENSION_CHECKSUM_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        break;
+
+    case XSK_SOCKOPT_TX_FRAME_GSO_EXTENSION:
+        ExtensionSet = Xsk->Tx.FrameExtensionSet;
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_GSO_NAME,
+            XDP_FRAME_EXTENSION_GSO_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        break;
+
+    case XSK_SOCKOPT_RX_FRAME_CHECKSUM_EXTENSION:
+        ExtensionSet = Xsk->Rx.FrameExtensionSet;
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_CHECKSUM_NAME,
+            XDP_FRAME_EXTENSION_CHECKSUM_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        break;
+
+    case XSK_SOCKOPT_RX_FRAME_LAYOUT_EXTENSION:
+        ExtensionSet = Xsk->Rx.FrameExtensionSet;
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_LAYOUT_NAME,
+            XDP_FRAME_EXTENSION_LAYOUT_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        break;
+
+    case XSK_SOCKOPT_RX_FRAME_ORIGINAL_LENGTH_EXTENSION:
+        ExtensionSet = Xsk->Rx.FrameExtensionSet;
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XSK_FRAME_EXTENSION_ORIGINAL_LENGTH_NAME,
+            XSK_FRAME_EXTENSION_ORIGINAL_LENGTH_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        break;
+
+    case XSK_SOCKOPT_RX_FRAME_TIMESTAMP_EXTENSION:
+        ExtensionSet = Xsk->Rx.FrameExtensionSet;
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_TIMESTAMP_NAME,
+            XDP_FRAME_EXTENSION_TIMESTAMP_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        break;
+
+    case XSK_SOCKOPT_RX_FRAME_GRO_EXTENSION:
+        ExtensionSet = Xsk->Rx.FrameExtensionSet;
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_GRO_NAME,
+            XDP_FRAME_EXTENSION_GRO_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        break;
+
+    case XSK_SOCKOPT_TX_FRAME_TIMESTAMP_EXTENSION:
+        ExtensionSet = Xsk->Tx.CompletionExtensionSet;
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_TIMESTAMP_NAME,
+            XDP_FRAME_EXTENSION_TIMESTAMP_VERSION_1, XDP_EXTENSION_TYPE_TX_FRAME_COMPLETION);
+        break;
+
+    default:
+        Status = STATUS_NOT_SUPPORTED;
+        goto Exit;
+    }
+
+    if (!XdpExtensionSetIsLayoutAssigned(ExtensionSet) ||
+        !XdpExtensionSetIsExtensionEnabled(ExtensionSet, ExtensionInfo.ExtensionName)) {
+        Status = STATUS_NOT_FOUND;
+        goto Exit;
+    }
+
+    XdpExtensionSetGetExtension(ExtensionSet, &ExtensionInfo, &Extension);
+
+    *ExtensionOut = Extension.Reserved;
+    Irp->IoStatus.Information = sizeof(*ExtensionOut);
+    Status = STATUS_SUCCESS;
+
+Exit:
+
+    RtlReleasePushLockExclusive(&Xsk->PushLock);
+
+    TraceExitStatus(TRACE_XSK);
+
+    return Status;
+}
+
+typedef
+XDP_IF_OFFLOAD_HANDLE
+XSK_GET_IF_OFFLOAD_HANDLE(
+    _In_ XSK *Xsk
+    );
+
+static
+XDP_IF_OFFLOAD_HANDLE
+XskSockoptGetTxOffloadHandle(
+    _In_ XSK *Xsk
+    )
+{
+    if (Xsk->Tx.Xdp.Queue == NULL) {
+        return NULL;
+    }
+
+    return XdpTxQueueGetInterfaceOffloadHandle(Xsk->Tx.Xdp.Queue);
+}
+
+static
+XDP_IF_OFFLOAD_HANDLE
+XskSockoptGetRxOffloadHandle(
+    _In_ XSK *Xsk
+    )
+{
+    if (Xsk->Rx.Xdp.Queue == NULL) {
+        return NULL;
+    }
+
+    return XdpRxQueueGetInterfaceOffloadHandle(Xsk->Rx.Xdp.Queue);
+}
+
+typedef struct _XSK_OFFLOAD_WORKITEM {
+    XDP_BINDING_WORKITEM IfWorkItem;
+    XSK *Xsk;
+    XSK_GET_IF_OFFLOAD_HANDLE *GetIfOffloadHandle;
+    XDP_INTERFACE_OFFLOAD_TYPE OffloadType;
+    UINT32 OffloadParamsSize;
+    VOID *OutputBuffer;
+    KEVENT CompletionEvent;
+    NTSTATUS CompletionStatus;
+} XSK_OFFLOAD_WORKITEM;
+
+static
+VOID
+XskGetOffloadWorker(
+    _In_ XDP_BINDING_WORKITEM *Item
+    )
+{
+    XSK_OFFLOAD_WORKITEM *WorkItem = CONTAINING_RECORD(Item, XSK_OFFLOAD_WORKITEM, IfWorkItem);
+    XSK *Xsk = WorkItem->Xsk;
+    NTSTATUS Status;
+
+    TraceEnter(TRACE_XSK, "Xsk=%p", Xsk);
+
+    if (WorkItem->OffloadType == XdpTxOffloadChecksum && Xsk->Tx.Xdp.Queue == NULL) {
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+
+    if (WorkItem->OffloadType == XdpRxOffloadChecksum && Xsk->Rx.Xdp.Queue == NULL) {
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+
+    XDP_IF_OFFLOAD_HANDLE OffloadHandle = WorkItem->GetIfOffloadHandle(Xsk);
+    if (OffloadHandle == NULL) {
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+
+    Status =
+        XdpIfGetInterfaceOffload(
+            XdpIfGetIfSetHandle(Item->BindingHandle), OffloadHandle,
+            WorkItem->OffloadType, WorkItem->OutputBuffer, &WorkItem->OffloadParamsSize);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+Exit:
+
+    TraceExitStatus(TRACE_XSK);
+
+    WorkItem->CompletionStatus = Status;
+    NT_VERIFY(NT_SUCCESS(KeSetEvent(&WorkItem->CompletionEvent, IO_NO_INCREMENT, FALSE)));
+}
+
+static
+NTSTATUS
+XskSockoptGetOffload(
+    _In_ XSK *Xsk,
+    _In_ UINT32 Option,
+    _In_ IRP *Irp,
+    _In_ IO_STACK_LOCATION *IrpSp
+    )
+{
+    NTSTATUS Status;
+    KIRQL OldIrql;
+    BOOLEAN IsLockHeld = FALSE;
+    XSK_OFFLOAD_WORKITEM WorkItem;
+    XSK_SHARED_RING *Ring = NULL;
+    VOID *OutputBuffer = Irp->AssociatedIrp.SystemBuffer;
+    UINT32 OutputBufferLength = IrpSp->Parameters.DeviceIoControl.OutputBufferLength;
+    SIZE_T *BytesReturned = &Irp->IoStatus.Information;
+    BOOLEAN ResetChangeFlag = FALSE;
+
+    TraceEnter(TRACE_XSK, "Xsk=%p", Xsk);
+
+    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
+    IsLockHeld = TRUE;
+
+    switch (Option) {
+    case XSK_SOCKOPT_TX_OFFLOAD_CURRENT_CONFIG_CHECKSUM:
+        if (Xsk->Tx.Xdp.IfHandle == NULL) {
+            Status = STATUS_INVALID_DEVICE_STATE;
+            goto Exit;
+        }
+        WorkItem.IfWorkItem.BindingHandle = Xsk->Tx.Xdp.IfHandle;
+        WorkItem.GetIfOffloadHandle = XskSockoptGetTxOffloadHandle;
+        WorkItem.OffloadType = XdpTxOffloadChecksum;
+        Ring = Xsk->Tx.Ring.Shared;
+        Xsk->Tx.OffloadChangeFlags.CurrentConfig = FALSE;
+        ResetChangeFlag = Xsk->Tx.OffloadChangeFlags.Value == 0;
+        break;
+
+    case XSK_SOCKOPT_RX_OFFLOAD_CURRENT_CONFIG_CHECKSUM:
+        if (Xsk->Rx.Xdp.IfHandle == NULL) {
+            Status = STATUS_INVALID_DEVICE_STATE;
+            goto Exit;
+        }
+        WorkItem.IfWorkItem.BindingHandle = Xsk->Rx.Xdp.IfHandle;
+        WorkItem.GetIfOffloadHandle = XskSockoptGetRxOffloadHandle;
+        WorkItem.OffloadType = XdpRxOffloadChecksum;
+        Ring = Xsk->Rx.Ring.Shared;
+        Xsk->Rx.OffloadChangeFlags.CurrentConfig = FALSE;
+        ResetChangeFlag = Xsk->Rx.OffloadChangeFlags.Value == 0;
+        break;
+
+    default:
+        Status = STATUS_NOT_SUPPORTED;
+        goto Exit;
+    }
+
+    ASSERT(WorkItem.IfWorkItem.BindingHandle != NULL);
+    ASSERT(WorkItem.GetIfOffloadHandle != NULL);
+
+    if (Ring != NULL && ResetChangeFlag) {
+        InterlockedAndNoFence((LONG *)&Ring->Flags, ~XSK_RING_FLAG_OFFLOAD_CHANGED);
+    }
+
+    KeInitializeEvent(&WorkItem.CompletionEvent, NotificationEvent, FALSE);
+    WorkItem.Xsk = Xsk;
+    WorkItem.IfWorkItem.WorkRoutine = XskGetOffloadWorker;
+    WorkItem.OffloadParamsSize = OutputBufferLength;
+    WorkItem.OutputBuffer = OutputBuffer;
+    XdpIfQueueWorkItem(&WorkItem.IfWorkItem);
+
+    KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+    IsLockHeld = FALSE;
+
+    KeWaitForSingleObject(
+        &WorkItem.CompletionEvent, Executive, KernelMode, FALSE, NULL);
+
+    Status = WorkItem.CompletionStatus;
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
+
+    *BytesReturned = WorkItem.OffloadParamsSize;
+
+    if ((OutputBufferLength == 0) && (Irp->Flags & IRP_INPUT_OPERATION) == 0) {
+        Status = STATUS_BUFFER_OVERFLOW;
+        goto Exit;
+    }
+
+Exit:
+
+    if (IsLockHeld) {
+        KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+    }
+
+    TraceInfo(
+        TRACE_XSK, "Xsk=%p Status=%!STATUS! OutputBuffer=%!HEXDUMP!",
+        Xsk, Status, WppHexDump(OutputBuffer, OutputBufferLength));
+
+    TraceExitStatus(TRACE_XSK);
+
+    return Status;
+}
+
+static
+UINT32
+XskQueryReadyIo(
+    _In_ XSK* Xsk,
+    _In_ UINT32 InFlags
+    )
+{
+    UINT32 SatisfiedFlags = 0;
+
+    if (InFlags & XSK_NOTIFY_FLAG_WAIT_TX && !XskRingProdIsEmpty(&Xsk->Tx.CompletionRing)) {
+        SatisfiedFlags |= XSK_NOTIFY_FLAG_WAIT_TX;
+    }
+    if (InFlags & XSK_NOTIFY_FLAG_WAIT_RX && !XskRingProdIsEmpty(&Xsk->Rx.Ring)) {
+        SatisfiedFlags |= XSK_NOTIFY_FLAG_WAIT_RX;
+    }
+
+    return SatisfiedFlags;
+}
+
+static
+_Requires_exclusive_lock_held_(&Xsk->PollLock)
+BOOLEAN
+XskPollInvoke(
+    _In_ XSK *Xsk,
+    _In_ UINT32 RxQuota,
+    _In_ UINT32 TxQuota
+    )
+{
+    BOOLEAN MoreData = FALSE;
+
+    ASSERT(Xsk->Rx.Xdp.PollHandle != NULL || Xsk->Tx.Xdp.PollHandle != NULL);
+
+    if (Xsk->Rx.Xdp.PollHandle == Xsk->Tx.Xdp.PollHandle) {
+        //
+        // Typically the RX and TX poll contexts are the same.
+        //
+        MoreData = XdpPollInvoke(Xsk->Rx.Xdp.PollHandle, RxQuota, TxQuota);
+    } else {
+        if (Xsk->Rx.Xdp.PollHandle != NULL) {
+            MoreData |= XdpPollInvoke(Xsk->Rx.Xdp.PollHandle, RxQuota, TxQuota);
+        }
+        if (Xsk->Tx.Xdp.PollHandle != NULL) {
+            MoreData |= XdpPollInvoke(Xsk->Tx.Xdp.PollHandle, RxQuota, TxQuota);
         }
     }
 
@@ -4935,843 +6144,1635 @@ XskPollInvoke(
 }
 
 static
-_Requires_exclusive_lock_held_(&Xsk->PollLock)
-VOID
-XskPollSetNotifications(
+_Requires_exclusive_lock_held_(&Xsk->PollLock)
+VOID
+XskPollSetNotifications(
+    _In_ XSK *Xsk,
+    _In_ BOOLEAN EnableNotifications
+    )
+{
+    ASSERT(Xsk->Rx.Xdp.PollHandle != NULL || Xsk->Tx.Xdp.PollHandle != NULL);
+
+    if (Xsk->Rx.Xdp.PollHandle == Xsk->Tx.Xdp.PollHandle) {
+        //
+        // Typically the RX and TX poll contexts are the same.
+        //
+        XdpPollSetNotifications(Xsk->Rx.Xdp.PollHandle, EnableNotifications);
+    } else {
+        if (Xsk->Rx.Xdp.PollHandle != NULL) {
+            XdpPollSetNotifications(Xsk->Rx.Xdp.PollHandle, EnableNotifications);
+        }
+        if (Xsk->Tx.Xdp.PollHandle != NULL) {
+            XdpPollSetNotifications(Xsk->Tx.Xdp.PollHandle, EnableNotifications);
+        }
+    }
+}
+
+static
+_Requires_exclusive_lock_held_(&Xsk->PollLock)
+NTSTATUS
+XskPollSocket(
+    _In_ XSK *Xsk,
+    _In_ UINT32 Flags,
+    _In_ UINT32 TimeoutMs
+    )
+{
+    NTSTATUS Status;
+    BOOLEAN MoreData;
+    UINT32 WaitFlags;
+    BOOLEAN NotificationsArmed = FALSE;
+    UINT64 DueTime = 0;
+    UINT64 CurrentTime;
+    LARGE_INTEGER WaitTime;
+    LARGE_INTEGER *WaitTimePtr = NULL;
+
+    WaitFlags = Flags & (XSK_NOTIFY_FLAG_WAIT_RX | XSK_NOTIFY_FLAG_WAIT_TX);
+
+    if (TimeoutMs != XDP_INFINITE) {
+        WaitTimePtr = &WaitTime;
+        DueTime = KeQueryInterruptTime();
+        DueTime += RTL_MILLISEC_TO_100NANOSEC(TimeoutMs);
+    }
+
+    while (TRUE) {
+        UINT32 RxQuota = 256;
+        UINT32 TxQuota = 256;
+
+        if (ReadULongNoFence(&Xsk->PollWaiters) > 0) {
+            //
+            // Give the control path a chance to acquire the poll lock.
+            //
+            RtlReleasePushLockExclusive(&Xsk->PollLock);
+            RtlAcquirePushLockExclusive(&Xsk->PollLock);
+
+            if (Xsk->PollMode != XSK_POLL_MODE_SOCKET ||
+                (Xsk->Rx.Xdp.PollHandle == NULL && Xsk->Tx.Xdp.PollHandle == NULL)) {
+                return STATUS_SUCCESS;
+            }
+        }
+
+        //
+        // TODO: Optimize RX and TX quotas.
+        // TODO: Optimize common case where RX and TX share a poll handle.
+        //
+        if (Xsk->Rx.Xdp.PollHandle != NULL) {
+            RxQuota = XskRingConsPeek(&Xsk->Rx.FillRing, RxQuota);
+            RxQuota = XskRingProdReserve(&Xsk->Rx.Ring, RxQuota);
+        }
+        if (Xsk->Tx.Xdp.PollHandle != NULL) {
+            TxQuota = XskRingConsPeek(&Xsk->Tx.Ring, TxQuota);
+            TxQuota = XskRingProdReserve(&Xsk->Tx.CompletionRing, TxQuota);
+        }
+
+        MoreData = XskPollInvoke(Xsk, RxQuota, TxQuota);
+
+        //
+        // TODO: Optimize return conditions: should we try to completely fill
+        // all buffers, or return as soon as a single buffer is available, or
+        // something in between?
+        //
+        if (!WaitFlags || XskQueryReadyIo(Xsk, WaitFlags)) {
+            return STATUS_SUCCESS;
+        }
+
+        //
+        // Check if the wait interval has timed out.
+        // Review: should we use a higher precision time source?
+        //
+        if (TimeoutMs != XDP_INFINITE) {
+            CurrentTime = KeQueryInterruptTime();
+            if (CurrentTime >= DueTime) {
+                return STATUS_TIMEOUT;
+            }
+
+            WaitTime.QuadPart = -(LONG64)(DueTime - CurrentTime);
+        }
+
+        //
+        // If no data is available, attempt to arm notifications and enter
+        // the waiting state.
+        //
+        if (!MoreData && !Xsk->PollBusy) {
+            if (!NotificationsArmed) {
+                XskPollSetNotifications(Xsk, TRUE);
+                NotificationsArmed = TRUE;
+            } else {
+                Status =
+                    KeWaitForSingleObject(
+                        &Xsk->PollRequested, UserRequest, ExGetPreviousMode(), FALSE, WaitTimePtr);
+                if (Status != STATUS_SUCCESS) {
+                    return Status;
+                }
+                MoreData = TRUE;
+            }
+        }
+
+        if (MoreData) {
+            NotificationsArmed = FALSE;
+        }
+    }
+}
+
+static
+NTSTATUS
+XskSockoptSetPollMode(
+    _In_ XSK *Xsk,
+    _In_ XSK_SET_SOCKOPT_IN *Sockopt,
+    _In_ KPROCESSOR_MODE RequestorMode
+    )
+{
+    NTSTATUS Status;
+    const VOID *SockoptInputBuffer;
+    UINT32 SockoptInputBufferLength;
+    XSK_POLL_MODE PollMode;
+
+    TraceEnter(TRACE_XSK, "Xsk=%p", Xsk);
+
+    //
+    // This is a nested buffer not copied by IO manager, so it needs special care.
+    //
+    SockoptInputBuffer = Sockopt->InputBuffer;
+    SockoptInputBufferLength = Sockopt->InputBufferLength;
+
+    if (SockoptInputBufferLength < sizeof(XSK_POLL_MODE)) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto Exit;
+    }
+
+    __try {
+        if (RequestorMode != KernelMode) {
+            ProbeForRead(
+                (VOID*)SockoptInputBuffer, SockoptInputBufferLength, PROBE_ALIGNMENT(XSK_POLL_MODE));
+        }
+        RtlCopyVolatileMemory(&PollMode, SockoptInputBuffer, sizeof(XSK_POLL_MODE));
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        Status = GetExceptionCode();
+        goto Exit;
+    }
+
+    XskAcquirePollLock(Xsk);
+    Status = XskSetPollMode(Xsk, PollMode);
+    XskReleasePollLock(Xsk);
+
+    if (NT_SUCCESS(Status)) {
+        TraceInfo(TRACE_XSK, "Xsk=%p Set poll mode PollMode=%u", Xsk, PollMode);
+    }
+
+Exit:
+
+    TraceExitStatus(TRACE_XSK);
+
+    return Status;
+}
+
+
+
+static
+NTSTATUS
+XskSockoptSetPollAdaptiveIdleTimeout(
+    _In_ XSK *Xsk,
+    _In_ XSK_SET_SOCKOPT_IN *Sockopt,
+    _In_ KPROCESSOR_MODE RequestorMode
+    )
+{
+    NTSTATUS Status;
+    const VOID *SockoptIn;
+    UINT32 SockoptInSize;
+    UINT32 IdleTimeoutMs;
+
+    TraceEnter(TRACE_XSK, "Xsk=%p", Xsk);
+
+    //
+    // This is a nested buffer not copied by IO manager, so it needs special care.
+    //
+    SockoptIn = Sockopt->InputBuffer;
+    SockoptInSize = Sockopt->InputBufferLength;
+
+    if (SockoptInSize < sizeof(IdleTimeoutMs)) {
+        Status = STATUS_BUFFER_TOO_SMALL;
+        goto Exit;
+    }
+
+    __try {
+        if (RequestorMode != KernelMode) {
+            ProbeForRead((VOID*)SockoptIn, SockoptInSize, PROBE_ALIGNMENT(UINT32));
+        }
+        RtlCopyVolatileMemory(&IdleTimeoutMs, SockoptIn, sizeof(IdleTimeoutMs));
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        Status = GetExceptionCode();
+        goto Exit;
+    }
+
+    if (IdleTimeoutMs == 0) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto Exit;
+    }
+
+    XskAcquirePollLock(Xsk);
+    Xsk->AdaptivePoll.IdleTimeoutMs = IdleTimeoutMs;
+    XskReleasePollLock(Xsk);
+
+    TraceInfo(TRACE_XSK, "Xsk=%p Set adaptive poll IdleTimeoutMs=%u", Xsk, IdleTimeoutMs);
+    Status = STATUS_SUCCESS;
+
+Exit:
+
+    TraceExitStatus(TRACE_XSK);
+
+    return Status;
+}
+
+static
+NTSTATUS
+XskIrpGetSockopt(
+    _In_ IRP *Irp,
+    _In_ IO_STACK_LOCATION *IrpSp
+    )
+{
+    NTSTATUS Status = STATUS_SUCCESS;
+    XSK *Xsk;
+    UINT32 Option = 0;
+
+    Xsk = IrpSp->FileObject->FsContext;
+
+    if (IrpSp->Parameters.DeviceIoControl.InputBufferLength < sizeof(Option)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    Option = *(UINT32 *)Irp->AssociatedIrp.SystemBuffer;
+
+    switch (Option) {
+    case XSK_SOCKOPT_RING_INFO:
+        Status = XskSockoptGetRingInfo(Xsk, Irp, IrpSp);
+        break;
+    case XSK_SOCKOPT_STATISTICS:
+        Status = XskSockoptGetStatistics(Xsk, Irp, IrpSp);
+        break;
+    case XSK_SOCKOPT_RX_HOOK_ID:
+    case XSK_SOCKOPT_TX_HOOK_ID:
+        Status = XskSockoptGetHookId(Xsk, Option, Irp, IrpSp);
+        break;
+    case XSK_SOCKOPT_RX_ERROR:
+    case XSK_SOCKOPT_RX_FILL_ERROR:
+    case XSK_SOCKOPT_TX_ERROR:
+    case XSK_SOCKOPT_TX_COMPLETION_ERROR:
+        Status = XskSockoptGetError(Xsk, Option, Irp, IrpSp);
+        break;
+    case XSK_SOCKOPT_TX_FRAME_LAYOUT_EXTENSION:
+    case XSK_SOCKOPT_TX_FRAME_CHECKSUM_EXTENSION:
+    case XSK_SOCKOPT_TX_FRAME_GSO_EXTENSION:
+    case XSK_SOCKOPT_RX_FRAME_CHECKSUM_EXTENSION:
+    case XSK_SOCKOPT_RX_FRAME_LAYOUT_EXTENSION:
+    case XSK_SOCKOPT_RX_FRAME_ORIGINAL_LENGTH_EXTENSION:
+    case XSK_SOCKOPT_RX_FRAME_TIMESTAMP_EXTENSION:
+    case XSK_SOCKOPT_RX_FRAME_GRO_EXTENSION:
+    case XSK_SOCKOPT_TX_FRAME_TIMESTAMP_EXTENSION:
+        Status = XskSockoptGetExtension(Xsk, Option, Irp, IrpSp);
+        break;
+    case XSK_SOCKOPT_TX_OFFLOAD_CURRENT_CONFIG_CHECKSUM:
+    case XSK_SOCKOPT_RX_OFFLOAD_CURRENT_CONFIG_CHECKSUM:
+        Status = XskSockoptGetOffload(Xsk, Option, Irp, IrpSp);
+        break;
+    default:
+        Status = STATUS_NOT_SUPPORTED;
+        break;
+    }
+
+    TraceInfo(TRACE_XSK, "Xsk=%p Option=%u Status=%!STATUS!", Xsk, Option, Status);
+
+    return Status;
+}
+
+static
+_Success_(NT_SUCCESS(IoStatus->Status))
+VOID
+XskGetIdealProcessor(
+    _In_ XSK *Xsk,
+    _Inout_ XSK_KERNEL_RING *Ring,
+    _In_ KPROCESSOR_MODE PreviousMode,
+    _Out_ VOID *OutputBuffer,
+    _In_ UINT32 OutputBufferLength,
+    _Out_ IO_STATUS_BLOCK *IoStatus
+    )
+{
+    UINT32 ProcIndex;
+    PROCESSOR_NUMBER ProcNumber;
+
+    //
+    // N.B. This function must be called within a try/catch block.
+    //
+
+    if (ReadUInt32Acquire((UINT32 *)&Xsk->State) < XskActive || Ring->Size == 0) {
+        IoStatus->Status = STATUS_INVALID_DEVICE_STATE;
+        return;
+    }
+
+    if (OutputBufferLength < sizeof(PROCESSOR_NUMBER)) {
+        IoStatus->Status = STATUS_BUFFER_TOO_SMALL;
+        return;
+    }
+
+    if (PreviousMode != KernelMode) {
+        #pragma prefast(suppress:6001) // Using uninitialized memory '*OutputBuffer'
+        ProbeForWrite(
+            OutputBuffer, sizeof(PROCESSOR_NUMBER), PROBE_ALIGNMENT(PROCESSOR_NUMBER));
+    }
+
+    //
+    // Reset the affinity flag before reading the affinity value.
+    //
+    InterlockedAndAcquire((LONG *)&Ring->Shared->Flags, ~XSK_RING_FLAG_AFFINITY_CHANGED);
+
+    ProcIndex = ReadUInt32NoFence(&Ring->IdealProcessor);
+    if (ProcIndex == INVALID_PROCESSOR_INDEX) {
+        IoStatus->Status = STATUS_DEVICE_NOT_READY;
+        return;
+    }
+
+    NT_VERIFY(NT_SUCCESS(KeGetProcessorNumberFromIndex(ProcIndex, &ProcNumber)));
+
+    *(PROCESSOR_NUMBER *)OutputBuffer = ProcNumber;
+    IoStatus->Information = sizeof(PROCESSOR_NUMBER);
+    IoStatus->Status = STATUS_SUCCESS;
+}
+
+#pragma warning(push)
+#pragma warning(disable:6101) // We don't set OutputBuffer in some paths
+static
+BOOLEAN
+XskFastGetSockopt(
+    _In_ XDP_FILE_OBJECT_HEADER *FileObjectHeader,
+    _In_opt_ VOID *InputBuffer,
+    _In_ UINT32 InputBufferLength,
+    _Out_opt_ VOID *OutputBuffer,
+    _In_ UINT32 OutputBufferLength,
+    _Out_ IO_STATUS_BLOCK *IoStatus
+    )
+{
+    XSK *Xsk = (XSK *)FileObjectHeader;
+    const KPROCESSOR_MODE PreviousMode = ExGetPreviousMode();
+    UINT32 Option = 0;
+
+    __try {
+        #pragma prefast(push)
+        #pragma prefast(disable:6011) // Dereferencing NULL pointer is safe within try/catch.
+        #pragma prefast(disable:6387) // Dereferencing NULL pointer is safe within try/catch.
+
+        if (InputBufferLength < sizeof(Option)) {
+            IoStatus->Status = STATUS_INVALID_PARAMETER;
+            goto Exit;
+        }
+
+        if (PreviousMode != KernelMode) {
+            ProbeForRead(
+                (VOID *)InputBuffer, InputBufferLength, PROBE_ALIGNMENT(UINT32));
+        }
+
+        Option = ReadUInt32NoFence(InputBuffer);
+
+        switch (Option) {
+        case XSK_SOCKOPT_RX_PROCESSOR_AFFINITY:
+            XskGetIdealProcessor(
+                Xsk, &Xsk->Rx.Ring, PreviousMode, OutputBuffer, OutputBufferLength, IoStatus);
+            break;
+
+        case XSK_SOCKOPT_TX_PROCESSOR_AFFINITY:
+            XskGetIdealProcessor(
+                Xsk, &Xsk->Tx.Ring, PreviousMode, OutputBuffer, OutputBufferLength, IoStatus);
+            break;
+
+        default:
+            //
+            // Fall back to the IRP-based socket option path.
+            //
+            return FALSE;
+        }
+
+        #pragma prefast(pop)
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        IoStatus->Status = GetExceptionCode();
+        goto Exit;
+    }
+
+Exit:
+
+    return TRUE;
+}
+#pragma warning(pop)
+
+static
+NTSTATUS
+XskIrpSetSockopt(
+    _In_ IRP *Irp,
+    _In_ IO_STACK_LOCATION *IrpSp
+    )
+{
+    NTSTATUS Status = STATUS_SUCCESS;
+    XSK *Xsk;
+    XSK_SET_SOCKOPT_IN *Sockopt = NULL;
+
+    Xsk = IrpSp->FileObject->FsContext;
+
+    if (IrpSp->Parameters.DeviceIoControl.InputBufferLength < sizeof(XSK_SET_SOCKOPT_IN)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    Sockopt = Irp->AssociatedIrp.SystemBuffer;
+
+    switch (Sockopt->Option) {
+    case XSK_SOCKOPT_UMEM_REG:
+        Status = XskSockoptSetUmem(Xsk, Sockopt, Irp->RequestorMode);
+        break;
+    case XSK_SOCKOPT_SHARED_UMEM:
+        Status = XskSockoptSetSharedUmem(Xsk, Sockopt, Irp->RequestorMode);
+        break;
+    case XSK_SOCKOPT_TX_RING_SIZE:
+    case XSK_SOCKOPT_RX_RING_SIZE:
+    case XSK_SOCKOPT_RX_FILL_RING_SIZE:
+    case XSK_SOCKOPT_TX_COMPLETION_RING_SIZE:
+        Status = XskSockoptSetRingSize(Xsk, Sockopt, Irp->RequestorMode);
+        break;
+    case XSK_SOCKOPT_RX_HOOK_ID:
+    case XSK_SOCKOPT_TX_HOOK_ID:
+        Status = XskSockoptSetHookId(Xsk, Sockopt, Irp->RequestorMode);
+        break;
+    case XSK_SOCKOPT_RX_PROCESSOR_AFFINITY:
+    case XSK_SOCKOPT_TX_PROCESSOR_AFFINITY:
+        Status = XskSockoptSetIdealProcessor(Xsk, Sockopt, Irp->RequestorMode);
+        break;
+    case XSK_SOCKOPT_TX_OFFLOAD_CHECKSUM:
+        Status = XskSockoptSetTxOffloadChecksum(Xsk, Sockopt, Irp->RequestorMode);
+        break;
+    case XSK_SOCKOPT_TX_OFFLOAD_GSO:
+        Status = XskSockoptSetTxOffloadGso(Xsk, Sockopt, Irp->RequestorMode);
+        break;
+    case XSK_SOCKOPT_RX_OFFLOAD_CHECKSUM:
+        Status = XskSockoptSetRxOffloadChecksum(Xsk, Sockopt, Irp->RequestorMode);
+        break;
+    case XSK_SOCKOPT_RX_ZERO_COPY:
+        Status = XskSockoptSetRxZeroCopy(Xsk, Sockopt, Irp->RequestorMode);
+        break;
+    case XSK_SOCKOPT_RX_OFFLOAD_TIMESTAMP:
+        Status = XskSockoptSetRxOffloadTimestamp(Xsk, Sockopt, Irp->RequestorMode);
+        break;
+    case XSK_SOCKOPT_RX_OFFLOAD_GRO:
+        Status = XskSockoptSetRxOffloadGro(Xsk, Sockopt, Irp->RequestorMode);
+        break;
+    case XSK_SOCKOPT_TX_OFFLOAD_TIMESTAMP:
+        Status = XskSockoptSetTxOffloadTimestamp(Xsk, Sockopt, Irp->RequestorMode);
+        break;
+    case XSK_SOCKOPT_RX_ORIGINAL_LENGTH:
+        Status = XskSockoptSetRxOriginalLength(Xsk, Sockopt, Irp->RequestorMode);
+        break;
+    case XSK_SOCKOPT_RX_MULTI_BUFFER:
+        Status = XskSockoptSetRxMultiBuffer(Xsk, Sockopt, Irp->RequestorMode);
+        break;
+#if !defined(XDP_OFFICIAL_BUILD)
+    case XSK_SOCKOPT_POLL_MODE:
+        Status = XskSockoptSetPollMode(Xsk, Sockopt, Irp->RequestorMode);
+        break;
+
+    case XSK_SOCKOPT_POLL_ADAPTIVE_IDLE_TIMEOUT:
+        Status = XskSockoptSetPollAdaptiveIdleTimeout(Xsk, Sockopt, Irp->RequestorMode);
+        break;
+#endif // !defined(XDP_OFFICIAL_BUILD)
+    default:
+        Status = STATUS_NOT_SUPPORTED;
+        break;
+    }
+
+    TraceInfo(
+        TRACE_XSK, "Xsk=%p Option=%u Status=%!STATUS! Value=%!HEXDUMP!",
+        Xsk, Sockopt->Option, Status, WppHexDump(Sockopt->InputBuffer, Sockopt->InputBufferLength));
+
+    return Status;
+}
+
+static
+NTSTATUS
+XskNotifyValidateParams(
     _In_ XSK *Xsk,
-    _In_ BOOLEAN EnableNotifications
+    _In_opt_ VOID *InputBuffer,
+    _In_ ULONG InputBufferLength,
+    _Out_ PUINT32 TimeoutMilliseconds,
+    _Out_ PUINT32 InFlags
     )
 {
-    ASSERT(Xsk->Rx.Xdp.PollHandle != NULL || Xsk->Tx.Xdp.PollHandle != NULL);
+    if (Xsk->State != XskActive){
+        return STATUS_INVALID_DEVICE_STATE;
+    }
 
-    if (Xsk->Rx.Xdp.PollHandle == Xsk->Tx.Xdp.PollHandle) {
+    if (InputBufferLength < sizeof(XSK_NOTIFY_IN)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    __try {
+        ASSERT(InputBuffer);
+        if (ExGetPreviousMode() != KernelMode) {
+            ProbeForRead(
+                (VOID*)InputBuffer, InputBufferLength, PROBE_ALIGNMENT(XSK_NOTIFY_IN));
+        }
+
+        *InFlags = ReadUInt32NoFence((UINT32 *)&((XSK_NOTIFY_IN *)InputBuffer)->Flags);
+        *TimeoutMilliseconds =
+            ReadUInt32NoFence(&((XSK_NOTIFY_IN *)InputBuffer)->WaitTimeoutMilliseconds);
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        return GetExceptionCode();
+    }
+
+    if (*InFlags == 0 || *InFlags &
+            ~(XSK_NOTIFY_FLAG_POKE_RX | XSK_NOTIFY_FLAG_POKE_TX | XSK_NOTIFY_FLAG_WAIT_RX | XSK_NOTIFY_FLAG_WAIT_TX)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if ((*InFlags & (XSK_NOTIFY_FLAG_POKE_RX | XSK_NOTIFY_FLAG_WAIT_RX) && !Xsk->Rx.Flags.Activated) ||
+        (*InFlags & (XSK_NOTIFY_FLAG_POKE_TX | XSK_NOTIFY_FLAG_WAIT_TX) && !Xsk->Tx.Flags.Activated)) {
+        return STATUS_INVALID_DEVICE_STATE;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+static
+NTSTATUS
+XskPoke(
+    _In_ XSK *Xsk,
+    _In_ UINT32 Flags,
+    _In_ UINT32 TimeoutMs
+    )
+{
+    NTSTATUS Status = STATUS_SUCCESS;
+
+    EventWriteXskNotifyPokeStart(&MICROSOFT_XDP_PROVIDER, Xsk, Flags);
+
+    RtlAcquirePushLockExclusive(&Xsk->PollLock);
+
+    if (Xsk->PollMode == XSK_POLL_MODE_SOCKET &&
+        (Xsk->Rx.Xdp.PollHandle != NULL || Xsk->Tx.Xdp.PollHandle != NULL)) {
         //
-        // Typically the RX and TX poll contexts are the same.
+        // Socket polling mode is active, so poll the interfaces synchronously.
         //
-        XdpPollSetNotifications(Xsk->Rx.Xdp.PollHandle, EnableNotifications);
+        Status = XskPollSocket(Xsk, Flags, TimeoutMs);
     } else {
-        if (Xsk->Rx.Xdp.PollHandle != NULL) {
-            XdpPollSetNotifications(Xsk->Rx.Xdp.PollHandle, EnableNotifications);
+        //
+        // Notify the underlying interfaces that data is available.
+        //
+
+        if (Flags & XSK_NOTIFY_FLAG_POKE_RX) {
+            ASSERT(Xsk->Rx.Ring.Size > 0);
+            ASSERT(Xsk->Rx.FillRing.Size > 0);
+            //
+            // TODO: Driver poke routine for zero copy RX.
+            //
+            ASSERT(Status == STATUS_SUCCESS);
         }
-        if (Xsk->Tx.Xdp.PollHandle != NULL) {
-            XdpPollSetNotifications(Xsk->Tx.Xdp.PollHandle, EnableNotifications);
+
+        if (Flags & XSK_NOTIFY_FLAG_POKE_TX) {
+            XDP_NOTIFY_QUEUE_FLAGS NotifyFlags = XDP_NOTIFY_QUEUE_FLAG_TX;
+            //
+            // Before invoking the poke routine, atomically clear the need poke
+            // flag on the TX ring. The poke routine is required to execute a
+            // FlushTransmit, which guarantees the need poke flag can be set.
+            //
+            InterlockedAndNoFence((LONG *)&Xsk->Tx.Ring.Shared->Flags, ~XSK_RING_FLAG_NEED_POKE);
+
+            if (Xsk->Tx.Xdp.Flags.QueueActive) {
+                XdpTxQueueInvokeInterfaceNotify(Xsk->Tx.Xdp.Queue, NotifyFlags);
+            } else {
+                Status = STATUS_DEVICE_REMOVED;
+            }
         }
     }
+
+    RtlReleasePushLockExclusive(&Xsk->PollLock);
+
+    EventWriteXskNotifyPokeStop(&MICROSOFT_XDP_PROVIDER, Xsk, Flags);
+
+    return Status;
+}
+
+static DRIVER_CANCEL XskCancelNotify;
+
+static
+_Use_decl_annotations_
+VOID
+XskCancelNotify(
+    DEVICE_OBJECT *DeviceObject,
+    IRP *Irp
+    )
+{
+    XSK *Xsk;
+    IO_STACK_LOCATION *IrpSp;
+
+    UNREFERENCED_PARAMETER(DeviceObject);
+
+    IoReleaseCancelSpinLock(DISPATCH_LEVEL);
+
+    IrpSp = IoGetCurrentIrpStackLocation(Irp);
+    Xsk = IrpSp->FileObject->FsContext;
+
+    KeAcquireSpinLockAtDpcLevel(&Xsk->Lock);
+
+    //
+    // If the data path hasn't already dropped the IRP, reset the wait state
+    // here.
+    //
+
+    if (Xsk->IoWaitIrp == Irp) {
+        Xsk->IoWaitFlags = 0;
+        Xsk->IoWaitIrp = NULL;
+    }
+
+    KeReleaseSpinLock(&Xsk->Lock, Irp->CancelIrql);
+
+    Irp->IoStatus.Status = STATUS_CANCELLED;
+
+    EventWriteXskNotifyAsyncComplete(&MICROSOFT_XDP_PROVIDER, Xsk, Irp, Irp->IoStatus.Status);
+    IoCompleteRequest(Irp, IO_NETWORK_INCREMENT);
 }
 
 static
-_Requires_exclusive_lock_held_(&Xsk->PollLock)
+_Success_(return == STATUS_SUCCESS)
 NTSTATUS
-XskPollSocket(
+XskNotify(
     _In_ XSK *Xsk,
-    _In_ UINT32 Flags,
-    _In_ UINT32 TimeoutMs
+    _In_opt_ VOID *InputBuffer,
+    _In_ ULONG InputBufferLength,
+    _Out_ ULONG_PTR *Information,
+    _Inout_opt_ IRP *Irp
     )
 {
+    UINT32 TimeoutMilliseconds;
+    UINT32 ReadyFlags;
+    UINT32 InFlags;
+    UINT32 OutFlags = 0;
+    KIRQL OldIrql;
+    LARGE_INTEGER Timeout;
     NTSTATUS Status;
-    BOOLEAN MoreData;
-    UINT32 WaitFlags;
-    BOOLEAN NotificationsArmed = FALSE;
-    UINT64 DueTime = 0;
-    UINT64 CurrentTime;
-    LARGE_INTEGER WaitTime;
-    LARGE_INTEGER *WaitTimePtr = NULL;
-
-    WaitFlags = Flags & (XSK_NOTIFY_FLAG_WAIT_RX | XSK_NOTIFY_FLAG_WAIT_TX);
+    XSK_IO_WAIT_FLAGS InternalFlags;
+    const UINT32 WaitMask = (XSK_NOTIFY_FLAG_WAIT_RX | XSK_NOTIFY_FLAG_WAIT_TX);
 
-    if (TimeoutMs != XDP_INFINITE) {
-        WaitTimePtr = &WaitTime;
-        DueTime = KeQueryInterruptTime();
-        DueTime += RTL_MILLISEC_TO_100NANOSEC(TimeoutMs);
+    Status =
+        XskNotifyValidateParams(
+            Xsk, InputBuffer, InputBufferLength, &TimeoutMilliseconds, &InFlags);
+    if (Status != STATUS_SUCCESS) {
+        TraceError(TRACE_XSK, "Xsk=%p Notify failed: Invalid params", Xsk);
+        goto Exit;
     }
 
-    while (TRUE) {
-        UINT32 RxQuota = 256;
-        UINT32 TxQuota = 256;
+    EventWriteXskNotifyStart(&MICROSOFT_XDP_PROVIDER, Xsk, Irp, InFlags, TimeoutMilliseconds);
 
-        if (ReadULongNoFence(&Xsk->PollWaiters) > 0) {
-            //
-            // Give the control path a chance to acquire the poll lock.
-            //
-            RtlReleasePushLockExclusive(&Xsk->PollLock);
-            RtlAcquirePushLockExclusive(&Xsk->PollLock);
+    if (ReadBooleanNoFence(&Xsk->AdaptivePoll.Idle)) {
+        //
+        // The application is requesting IO on an idle adaptive polling socket,
+        // so resume busy polling before poking or waiting.
+        //
+        XskAcquirePollLock(Xsk);
+        if (Xsk->State == XskActive && Xsk->PollMode == XSK_POLL_MODE_ADAPTIVE &&
+            Xsk->AdaptivePoll.Idle) {
+            XskResumeAdaptivePoll(Xsk);
+        }
+        XskReleasePollLock(Xsk);
+    }
 
-            if (Xsk->PollMode != XSK_POLL_MODE_SOCKET ||
-                (Xsk->Rx.Xdp.PollHandle == NULL && Xsk->Tx.Xdp.PollHandle == NULL)) {
-                return STATUS_SUCCESS;
-            }
+    //
+    // Snap the XSK notification state before performing the poke and/or wait.
+    //
+    InternalFlags = ReadULongAcquire((ULONG *)&Xsk->IoWaitInternalFlags);
+
+    if (InFlags & (XSK_NOTIFY_FLAG_POKE_RX | XSK_NOTIFY_FLAG_POKE_TX)) {
+        Status = XskPoke(Xsk, InFlags, TimeoutMilliseconds);
+        if (Status != STATUS_SUCCESS) {
+            TraceError(
+                TRACE_XSK, "Xsk=%p Notify failed: Poke failed Status=%!STATUS!",
+                Xsk, Status);
+            goto Exit;
         }
+    }
 
+    if ((InFlags & (XSK_NOTIFY_FLAG_WAIT_RX | XSK_NOTIFY_FLAG_WAIT_TX)) == 0) {
         //
-        // TODO: Optimize RX and TX quotas.
-        // TODO: Optimize common case where RX and TX share a poll handle.
+        // Not interested in waiting for IO.
         //
-        if (Xsk->Rx.Xdp.PollHandle != NULL) {
-            RxQuota = XskRingConsPeek(&Xsk->Rx.FillRing, RxQuota);
-            RxQuota = XskRingProdReserve(&Xsk->Rx.Ring, RxQuota);
-        }
-        if (Xsk->Tx.Xdp.PollHandle != NULL) {
-            TxQuota = XskRingConsPeek(&Xsk->Tx.Ring, TxQuota);
-            TxQuota = XskRingProdReserve(&Xsk->Tx.CompletionRing, TxQuota);
-        }
+        ASSERT(Status == STATUS_SUCCESS);
+        goto Exit;
+    }
 
-        MoreData = XskPollInvoke(Xsk, RxQuota, TxQuota);
+    //
+    // Opportunistic check for ready IO to avoid setting up a wait context.
+    //
+    ReadyFlags = XskQueryReadyIo(Xsk, InFlags);
+    if (ReadyFlags != 0) {
+        OutFlags |= XskWaitInFlagsToOutFlags(ReadyFlags);
+        ASSERT(Status == STATUS_SUCCESS);
+        goto Exit;
+    }
 
+    //
+    // Set up the wait context.
+    //
+    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
+    if (Xsk->State != XskActive) {
+        KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+        TraceInfo(TRACE_XSK, "Xsk=%p Notify wait failed: XSK not bound", Xsk);
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+    if (Xsk->IoWaitFlags != 0) {
         //
-        // TODO: Optimize return conditions: should we try to completely fill
-        // all buffers, or return as soon as a single buffer is available, or
-        // something in between?
+        // There is currently a wait active. Only a single wait is allowed.
         //
-        if (!WaitFlags || XskQueryReadyIo(Xsk, WaitFlags)) {
-            return STATUS_SUCCESS;
-        }
+        KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+        TraceError(TRACE_XSK, "Xsk=%p Notify wait failed: Wait already active", Xsk);
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+    Xsk->IoWaitFlags = InFlags & WaitMask;
+    if (Irp != NULL) {
+        Xsk->IoWaitIrp = Irp;
 
         //
-        // Check if the wait interval has timed out.
-        // Review: should we use a higher precision time source?
+        // Mark the IRP as pending prior to enabling cancellation; once we mark
+        // an IRP as pending, we must return STATUS_PENDING to the IO manager.
         //
-        if (TimeoutMs != XDP_INFINITE) {
-            CurrentTime = KeQueryInterruptTime();
-            if (CurrentTime >= DueTime) {
-                return STATUS_TIMEOUT;
+        IoMarkIrpPending(Irp);
+        Status = STATUS_PENDING;
+
+        //
+        // Enable cancellation and synchronize with the IO manager.
+        //
+        IoSetCancelRoutine(Irp, XskCancelNotify);
+        if (Irp->Cancel) {
+            if (IoSetCancelRoutine(Irp, NULL) != NULL) {
+                //
+                // The cancellation routine will not run; cancel the IRP here
+                // and bail.
+                //
+                Xsk->IoWaitIrp = NULL;
+                Xsk->IoWaitFlags = 0;
+                KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+                Irp->IoStatus.Status = STATUS_CANCELLED;
+                EventWriteXskNotifyAsyncComplete(
+                    &MICROSOFT_XDP_PROVIDER, Xsk, Irp, Irp->IoStatus.Status);
+                IoCompleteRequest(Irp, IO_NETWORK_INCREMENT);
+            } else {
+                //
+                // The cancellation routine will run; bail.
+                //
+                KeReleaseSpinLock(&Xsk->Lock, OldIrql);
             }
 
-            WaitTime.QuadPart = -(LONG64)(DueTime - CurrentTime);
+            goto Exit;
         }
+    } else {
+        KeClearEvent(&Xsk->IoWaitEvent);
+    }
+    KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+
+    //
+    // N.B. A memory barrier between the write of the wait event and the read of
+    // completed IO is needed in order to prevent a race condition when these
+    // operations are re-ordered. The race is between this thread and a thread
+    // completing IO. Memory barriers are also needed to protect against a
+    // similar race condition when the inverse of these operations are done
+    // during IO completion.
+    //
+    XdpBarrierBetweenReleaseAndAcquire();
+
+    //
+    // Check for ready IO.
+    //
+    ReadyFlags = XskQueryReadyIo(Xsk, InFlags);
+    if (ReadyFlags != 0) {
+        XskSignalReadyIo(Xsk, ReadyFlags);
+    }
+
+    //
+    // If the notification state changed while processing this request, abandon
+    // the wait and allow the application to re-examine the shared ring flags.
+    //
+    if (InternalFlags != Xsk->IoWaitInternalFlags) {
+        XskSignalReadyIo(Xsk, InFlags & WaitMask);
+    }
+
+    if (Irp == NULL) {
+        //
+        // Wait for IO.
+        //
+        Timeout.QuadPart = -1 * RTL_MILLISEC_TO_100NANOSEC(TimeoutMilliseconds);
+        Status =
+            KeWaitForSingleObject(
+                &Xsk->IoWaitEvent, UserRequest, ExGetPreviousMode(), FALSE,
+                (TimeoutMilliseconds == XDP_INFINITE) ? NULL : &Timeout);
+    } else {
+        ASSERT(Status == STATUS_PENDING);
+        goto Exit;
+    }
+
+    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
+    Xsk->IoWaitFlags = 0;
+    KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+
+    //
+    // Re-query ready IO regardless of the wait status.
+    //
+    ReadyFlags = XskQueryReadyIo(Xsk, InFlags);
+    if (ReadyFlags != 0) {
+        Status = STATUS_SUCCESS;
+        OutFlags |= XskWaitInFlagsToOutFlags(ReadyFlags);
+    }
+
+Exit:
+
+    //
+    // This IOCTL is assumed to never pend for fast IO, and code elsewhere takes
+    // advantage of this assumption.
+    //
+    ASSERT(Irp != NULL || Status != STATUS_PENDING);
+
+    if (Status != STATUS_PENDING) {
+        *Information = OutFlags;
+    }
+
+    EventWriteXskNotifyStop(&MICROSOFT_XDP_PROVIDER, Xsk, Irp, OutFlags, Status);
+
+    return Status;
+}
+
+#pragma warning(push)
+#pragma warning(disable:6101) // We don't set OutputBuffer in some paths
+BOOLEAN
+XskFastIo(
+    _In_ XDP_FILE_OBJECT_HEADER *FileObjectHeader,
+    _In_opt_ VOID *InputBuffer,
+    _In_ ULONG InputBufferLength,
+    _Out_opt_ VOID *OutputBuffer,
+    _In_ ULONG OutputBufferLength,
+    _In_ ULONG IoControlCode,
+    _Out_ IO_STATUS_BLOCK *IoStatus
+    )
+{
+    XSK *Xsk = CONTAINING_RECORD(FileObjectHeader, XSK, Header);
 
-        //
-        // If no data is available, attempt to arm notifications and enter
-        // the waiting state.
-        //
-        if (!MoreData && !Xsk->PollBusy) {
-            if (!NotificationsArmed) {
-                XskPollSetNotifications(Xsk, TRUE);
-                NotificationsArmed = TRUE;
-            } else {
-                Status =
-                    KeWaitForSingleObject(
-                        &Xsk->PollRequested, UserRequest, ExGetPreviousMode(), FALSE, WaitTimePtr);
-                if (Status != STATUS_SUCCESS) {
-                    return Status;
-                }
-                MoreData = TRUE;
-            }
-        }
+    switch (IoControlCode) {
+    case IOCTL_XSK_NOTIFY:
+        IoStatus->Status =
+            XskNotify(Xsk, InputBuffer, InputBufferLength, &IoStatus->Information, NULL);
+        return TRUE;
 
-        if (MoreData) {
-            NotificationsArmed = FALSE;
-        }
+    case IOCTL_XSK_GET_SOCKOPT:
+        return
+            XskFastGetSockopt(
+                FileObjectHeader, InputBuffer, InputBufferLength, OutputBuffer,
+                OutputBufferLength, IoStatus);
     }
+
+    return FALSE;
 }
+#pragma warning(pop)
 
-static
+_IRQL_requires_max_(PASSIVE_LEVEL)
+_IRQL_requires_same_
 NTSTATUS
-XskSockoptSetPollMode(
-    _In_ XSK *Xsk,
-    _In_ XSK_SET_SOCKOPT_IN *Sockopt,
-    _In_ KPROCESSOR_MODE RequestorMode
+XskIrpCreateNotifySet(
+    _Inout_ IRP *Irp,
+    _Inout_ IO_STACK_LOCATION *IrpSp,
+    _In_ UCHAR Disposition,
+    _In_ const XDP_OPEN_PACKET *OpenPacket,
+    _In_ VOID *InputBuffer,
+    _In_ SIZE_T InputBufferLength
     )
 {
     NTSTATUS Status;
-    const VOID *SockoptInputBuffer;
-    UINT32 SockoptInputBufferLength;
-    XSK_POLL_MODE PollMode;
+    XSK_NOTIFY_SET *NotifySet = NULL;
 
-    TraceEnter(TRACE_XSK, "Xsk=%p", Xsk);
-
-    //
-    // This is a nested buffer not copied by IO manager, so it needs special care.
-    //
-    SockoptInputBuffer = Sockopt->InputBuffer;
-    SockoptInputBufferLength = Sockopt->InputBufferLength;
+    UNREFERENCED_PARAMETER(Irp);
+    UNREFERENCED_PARAMETER(Disposition);
+    UNREFERENCED_PARAMETER(OpenPacket);
+    UNREFERENCED_PARAMETER(InputBuffer);
+    UNREFERENCED_PARAMETER(InputBufferLength);
 
-    if (SockoptInputBufferLength < sizeof(XSK_POLL_MODE)) {
-        Status = STATUS_INVALID_PARAMETER;
-        goto Exit;
-    }
+    TraceEnter(TRACE_XSK, "-");
 
-    __try {
-        if (RequestorMode != KernelMode) {
-            ProbeForRead(
-                (VOID*)SockoptInputBuffer, SockoptInputBufferLength, PROBE_ALIGNMENT(XSK_POLL_MODE));
-        }
-        RtlCopyVolatileMemory(&PollMode, SockoptInputBuffer, sizeof(XSK_POLL_MODE));
-    } __except (EXCEPTION_EXECUTE_HANDLER) {
-        Status = GetExceptionCode();
+    NotifySet = ExAllocatePoolZero(NonPagedPoolNx, sizeof(*NotifySet), POOLTAG_NOTIFY);
+    if (NotifySet == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
         goto Exit;
     }
 
-    XskAcquirePollLock(Xsk);
-    Status = XskSetPollMode(Xsk, PollMode);
-    XskReleasePollLock(Xsk);
+    NotifySet->Header.ObjectType = XDP_OBJECT_TYPE_XSK_NOTIFY_SET;
+    NotifySet->Header.Dispatch = &XskNotifySetFileDispatch;
+    ExInitializePushLock(&NotifySet->Lock);
+    InitializeListHead(&NotifySet->Members);
+    KeInitializeEvent(&NotifySet->Event, NotificationEvent, FALSE);
 
-    if (NT_SUCCESS(Status)) {
-        TraceInfo(TRACE_XSK, "Xsk=%p Set poll mode PollMode=%u", Xsk, PollMode);
-    }
+    IrpSp->FileObject->FsContext = NotifySet;
+    Status = STATUS_SUCCESS;
 
 Exit:
 
+    TraceInfo(TRACE_XSK, "NotifySet=%p Status=%!STATUS!", NotifySet, Status);
     TraceExitStatus(TRACE_XSK);
 
     return Status;
 }
 
+static
+_Requires_exclusive_lock_held_(&NotifySet->Lock)
+XSK_NOTIFY_SET_MEMBER *
+XskNotifySetFindMember(
+    _In_ XSK_NOTIFY_SET *NotifySet,
+    _In_ const XSK *Xsk
+    )
+{
+    for (LIST_ENTRY *Entry = NotifySet->Members.Flink; Entry != &NotifySet->Members;
+            Entry = Entry->Flink) {
+        XSK_NOTIFY_SET_MEMBER *Member = CONTAINING_RECORD(Entry, XSK_NOTIFY_SET_MEMBER, Link);
+
+        if (Member->Xsk == Xsk) {
+            return Member;
+        }
+    }
 
+    return NULL;
+}
 
 static
-NTSTATUS
-XskIrpGetSockopt(
-    _In_ IRP *Irp,
-    _In_ IO_STACK_LOCATION *IrpSp
+_Requires_exclusive_lock_held_(&NotifySet->Lock)
+VOID
+XskNotifySetRemoveMember(
+    _In_ XSK_NOTIFY_SET *NotifySet,
+    _In_ XSK_NOTIFY_SET_MEMBER *Member
     )
 {
-    NTSTATUS Status = STATUS_SUCCESS;
-    XSK *Xsk;
-    UINT32 Option = 0;
+    XSK *Xsk = Member->Xsk;
+    KIRQL OldIrql;
 
-    Xsk = IrpSp->FileObject->FsContext;
+    UNREFERENCED_PARAMETER(NotifySet);
 
-    if (IrpSp->Parameters.DeviceIoControl.InputBufferLength < sizeof(Option)) {
-        return STATUS_INVALID_PARAMETER;
-    }
+    //
+    // Once the socket no longer points to the member, the data path cannot
+    // signal the set through it.
+    //
+    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
+    ASSERT(Xsk->NotifySetMember == Member);
+    Xsk->NotifySetMember = NULL;
+    Xsk->NotifySetWaitFlags = 0;
+    KeReleaseSpinLock(&Xsk->Lock, OldIrql);
 
-    Option = *(UINT32 *)Irp->AssociatedIrp.SystemBuffer;
+    RemoveEntryList(&Member->Link);
+    ObDereferenceObject(Member->FileObject);
+    ExFreePoolWithTag(Member, POOLTAG_NOTIFY);
+}
 
-    switch (Option) {
-    case XSK_SOCKOPT_RING_INFO:
-        Status = XskSockoptGetRingInfo(Xsk, Irp, IrpSp);
-        break;
-    case XSK_SOCKOPT_STATISTICS:
-        Status = XskSockoptGetStatistics(Xsk, Irp, IrpSp);
-        break;
-    case XSK_SOCKOPT_RX_HOOK_ID:
-    case XSK_SOCKOPT_TX_HOOK_ID:
-        Status = XskSockoptGetHookId(Xsk, Option, Irp, IrpSp);
-        break;
-    case XSK_SOCKOPT_RX_ERROR:
-    case XSK_SOCKOPT_RX_FILL_ERROR:
-    case XSK_SOCKOPT_TX_ERROR:
-    case XSK_SOCKOPT_TX_COMPLETION_ERROR:
-        Status = XskSockoptGetError(Xsk, Option, Irp, IrpSp);
-        break;
-    case XSK_SOCKOPT_TX_FRAME_LAYOUT_EXTENSION:
-    case XSK_SOCKOPT_TX_FRAME_CHECKSUM_EXTENSION:
-    case XSK_SOCKOPT_RX_FRAME_CHECKSUM_EXTENSION:
-    case XSK_SOCKOPT_RX_FRAME_LAYOUT_EXTENSION:
-    case XSK_SOCKOPT_RX_FRAME_ORIGINAL_LENGTH_EXTENSION:
-    case XSK_SOCKOPT_RX_FRAME_TIMESTAMP_EXTENSION:
-    case XSK_SOCKOPT_TX_FRAME_TIMESTAMP_EXTENSION:
-        Status = XskSockoptGetExtension(Xsk, Option, Irp, IrpSp);
-        break;
-    case XSK_SOCKOPT_TX_OFFLOAD_CURRENT_CONFIG_CHECKSUM:
-    case XSK_SOCKOPT_RX_OFFLOAD_CURRENT_CONFIG_CHECKSUM:
-        Status = XskSockoptGetOffload(Xsk, Option, Irp, IrpSp);
-        break;
-    default:
-        Status = STATUS_NOT_SUPPORTED;
-        break;
-    }
+static
+_Requires_exclusive_lock_held_(&NotifySet->Lock)
+VOID
+XskNotifySetArmMember(
+    _In_ XSK_NOTIFY_SET *NotifySet,
+    _In_ XSK_NOTIFY_SET_MEMBER *Member
+    )
+{
+    XSK *Xsk = Member->Xsk;
+    KIRQL OldIrql;
 
-    TraceInfo(TRACE_XSK, "Xsk=%p Option=%u Status=%!STATUS!", Xsk, Option, Status);
+    UNREFERENCED_PARAMETER(NotifySet);
 
-    return Status;
+    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
+    Xsk->NotifySetWaitFlags = Member->Flags;
+    KeReleaseSpinLock(&Xsk->Lock, OldIrql);
 }
 
 static
-_Success_(NT_SUCCESS(IoStatus->Status))
+_Requires_exclusive_lock_held_(&NotifySet->Lock)
 VOID
-XskGetIdealProcessor(
-    _In_ XSK *Xsk,
-    _Inout_ XSK_KERNEL_RING *Ring,
-    _In_ KPROCESSOR_MODE PreviousMode,
-    _Out_ VOID *OutputBuffer,
-    _In_ UINT32 OutputBufferLength,
-    _Out_ IO_STATUS_BLOCK *IoStatus
+XskNotifySetSignalReadyMember(
+    _In_ XSK_NOTIFY_SET *NotifySet,
+    _In_ XSK_NOTIFY_SET_MEMBER *Member
     )
 {
-    UINT32 ProcIndex;
-    PROCESSOR_NUMBER ProcNumber;
+    UINT32 ReadyFlags;
+
+    UNREFERENCED_PARAMETER(NotifySet);
 
     //
-    // N.B. This function must be called within a try/catch block.
+    // Catch IO produced before the member was armed, which the data path did
+    // not signal.
     //
-
-    if (ReadUInt32Acquire((UINT32 *)&Xsk->State) < XskActive || Ring->Size == 0) {
-        IoStatus->Status = STATUS_INVALID_DEVICE_STATE;
-        return;
-    }
-
-    if (OutputBufferLength < sizeof(PROCESSOR_NUMBER)) {
-        IoStatus->Status = STATUS_BUFFER_TOO_SMALL;
-        return;
+    ReadyFlags = XskQueryReadyIo(Member->Xsk, Member->Flags);
+    if (ReadyFlags != 0) {
+        XskSignalReadyIo(Member->Xsk, ReadyFlags);
     }
+}
 
-    if (PreviousMode != KernelMode) {
-        #pragma prefast(suppress:6001) // Using uninitialized memory '*OutputBuffer'
-        ProbeForWrite(
-            OutputBuffer, sizeof(PROCESSOR_NUMBER), PROBE_ALIGNMENT(PROCESSOR_NUMBER));
-    }
+static
+_Requires_exclusive_lock_held_(&NotifySet->Lock)
+UINT32
+XskNotifySetQueryReadyIo(
+    _In_ XSK_NOTIFY_SET *NotifySet,
+    _Out_writes_to_(ResultCount, return) XSK_NOTIFY_SET_RESULT *Results,
+    _In_ UINT32 ResultCount
+    )
+{
+    LIST_ENTRY *Entry;
+    UINT32 ReadyCount = 0;
 
     //
-    // Reset the affinity flag before reading the affinity value.
+    // The results buffer may be a user mode address; the caller must guard
+    // this routine with an exception handler.
     //
-    InterlockedAndAcquire((LONG *)&Ring->Shared->Flags, ~XSK_RING_FLAG_AFFINITY_CHANGED);
-
-    ProcIndex = ReadUInt32NoFence(&Ring->IdealProcessor);
-    if (ProcIndex == INVALID_PROCESSOR_INDEX) {
-        IoStatus->Status = STATUS_DEVICE_NOT_READY;
-        return;
+    for (Entry = NotifySet->Members.Flink;
+            Entry != &NotifySet->Members && ReadyCount < ResultCount;
+            Entry = Entry->Flink) {
+        XSK_NOTIFY_SET_MEMBER *Member = CONTAINING_RECORD(Entry, XSK_NOTIFY_SET_MEMBER, Link);
+        UINT32 ReadyFlags = XskQueryReadyIo(Member->Xsk, Member->Flags);
+
+        if (ReadyFlags != 0) {
+            WritePointerNoFence(&Results[ReadyCount].Context, Member->Context);
+            WriteUInt32NoFence(
+                (UINT32 *)&Results[ReadyCount].Flags, XskWaitInFlagsToOutFlags(ReadyFlags));
+            WriteUInt32NoFence(&Results[ReadyCount].Reserved, 0);
+            ReadyCount++;
+        }
     }
 
-    NT_VERIFY(NT_SUCCESS(KeGetProcessorNumberFromIndex(ProcIndex, &ProcNumber)));
+    if (ReadyCount == ResultCount && Entry != &NotifySet->Members) {
+        //
+        // The results buffer filled up before every member was examined. Rotate
+        // the list so the next query starts with the first unexamined member,
+        // preventing members at the head from starving the rest.
+        //
+        RemoveEntryList(&NotifySet->Members);
+        InsertTailList(Entry, &NotifySet->Members);
+    }
 
-    *(PROCESSOR_NUMBER *)OutputBuffer = ProcNumber;
-    IoStatus->Information = sizeof(PROCESSOR_NUMBER);
-    IoStatus->Status = STATUS_SUCCESS;
+    return ReadyCount;
 }
 
-#pragma warning(push)
-#pragma warning(disable:6101) // We don't set OutputBuffer in some paths
 static
-BOOLEAN
-XskFastGetSockopt(
-    _In_ XDP_FILE_OBJECT_HEADER *FileObjectHeader,
+NTSTATUS
+XskNotifySetWait(
+    _In_ XSK_NOTIFY_SET *NotifySet,
     _In_opt_ VOID *InputBuffer,
-    _In_ UINT32 InputBufferLength,
+    _In_ ULONG InputBufferLength,
     _Out_opt_ VOID *OutputBuffer,
-    _In_ UINT32 OutputBufferLength,
-    _Out_ IO_STATUS_BLOCK *IoStatus
+    _In_ ULONG OutputBufferLength,
+    _Out_ ULONG_PTR *Information
     )
 {
-    XSK *Xsk = (XSK *)FileObjectHeader;
-    const KPROCESSOR_MODE PreviousMode = ExGetPreviousMode();
-    UINT32 Option = 0;
+    XSK_NOTIFY_SET_RESULT *Results = OutputBuffer;
+    UINT32 ResultCount = OutputBufferLength / sizeof(*Results);
+    UINT32 ReadyCount = 0;
+    UINT32 TimeoutMilliseconds;
+    LARGE_INTEGER Timeout;
+    BOOLEAN IsLockHeld = FALSE;
+    NTSTATUS Status;
+
+    if (InputBufferLength < sizeof(XSK_NOTIFY_SET_WAIT_IN) || ResultCount == 0) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto Exit;
+    }
 
     __try {
-        #pragma prefast(push)
-        #pragma prefast(disable:6011) // Dereferencing NULL pointer is safe within try/catch.
-        #pragma prefast(disable:6387) // Dereferencing NULL pointer is safe within try/catch.
+        ASSERT(InputBuffer);
+        ASSERT(OutputBuffer);
+        if (ExGetPreviousMode() != KernelMode) {
+            ProbeForRead(InputBuffer, InputBufferLength, PROBE_ALIGNMENT(XSK_NOTIFY_SET_WAIT_IN));
+            ProbeForWrite(
+                OutputBuffer, OutputBufferLength, PROBE_ALIGNMENT(XSK_NOTIFY_SET_RESULT));
+        }
+
+        TimeoutMilliseconds =
+            ReadUInt32NoFence(&((XSK_NOTIFY_SET_WAIT_IN *)InputBuffer)->WaitTimeoutMilliseconds);
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        Status = GetExceptionCode();
+        goto Exit;
+    }
+
+    RtlAcquirePushLockExclusive(&NotifySet->Lock);
+    IsLockHeld = TRUE;
+
+    if (NotifySet->Closing || NotifySet->WaitActive) {
+        //
+        // Only a single wait is allowed.
+        //
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+
+    //
+    // Opportunistic check for ready IO to avoid arming every member.
+    //
+    __try {
+        ReadyCount = XskNotifySetQueryReadyIo(NotifySet, Results, ResultCount);
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        Status = GetExceptionCode();
+        goto Exit;
+    }
+
+    if (ReadyCount > 0) {
+        Status = STATUS_SUCCESS;
+        goto Exit;
+    }
+
+    //
+    // Set up the wait context on every member socket.
+    //
+    NotifySet->WaitActive = TRUE;
+    KeClearEvent(&NotifySet->Event);
+
+    for (LIST_ENTRY *Entry = NotifySet->Members.Flink; Entry != &NotifySet->Members;
+            Entry = Entry->Flink) {
+        XskNotifySetArmMember(
+            NotifySet, CONTAINING_RECORD(Entry, XSK_NOTIFY_SET_MEMBER, Link));
+    }
+
+    //
+    // N.B. See comment in XskNotify.
+    //
+    XdpBarrierBetweenReleaseAndAcquire();
 
-        if (InputBufferLength < sizeof(Option)) {
-            IoStatus->Status = STATUS_INVALID_PARAMETER;
-            goto Exit;
-        }
+    for (LIST_ENTRY *Entry = NotifySet->Members.Flink; Entry != &NotifySet->Members;
+            Entry = Entry->Flink) {
+        XskNotifySetSignalReadyMember(
+            NotifySet, CONTAINING_RECORD(Entry, XSK_NOTIFY_SET_MEMBER, Link));
+    }
 
-        if (PreviousMode != KernelMode) {
-            ProbeForRead(
-                (VOID *)InputBuffer, InputBufferLength, PROBE_ALIGNMENT(UINT32));
-        }
+    //
+    // Release the lock while waiting so that members can be added or removed.
+    //
+    RtlReleasePushLockExclusive(&NotifySet->Lock);
+    IsLockHeld = FALSE;
 
-        Option = ReadUInt32NoFence(InputBuffer);
+    Timeout.QuadPart = -1 * RTL_MILLISEC_TO_100NANOSEC(TimeoutMilliseconds);
+    Status =
+        KeWaitForSingleObject(
+            &NotifySet->Event, UserRequest, ExGetPreviousMode(), FALSE,
+            (TimeoutMilliseconds == XDP_INFINITE) ? NULL : &Timeout);
 
-        switch (Option) {
-        case XSK_SOCKOPT_RX_PROCESSOR_AFFINITY:
-            XskGetIdealProcessor(
-                Xsk, &Xsk->Rx.Ring, PreviousMode, OutputBuffer, OutputBufferLength, IoStatus);
-            break;
+    RtlAcquirePushLockExclusive(&NotifySet->Lock);
+    IsLockHeld = TRUE;
 
-        case XSK_SOCKOPT_TX_PROCESSOR_AFFINITY:
-            XskGetIdealProcessor(
-                Xsk, &Xsk->Tx.Ring, PreviousMode, OutputBuffer, OutputBufferLength, IoStatus);
-            break;
+    for (LIST_ENTRY *Entry = NotifySet->Members.Flink; Entry != &NotifySet->Members;
+            Entry = Entry->Flink) {
+        XSK *Xsk = CONTAINING_RECORD(Entry, XSK_NOTIFY_SET_MEMBER, Link)->Xsk;
+        KIRQL OldIrql;
 
-        default:
-            //
-            // Fall back to the IRP-based socket option path.
-            //
-            return FALSE;
-        }
+        KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
+        Xsk->NotifySetWaitFlags = 0;
+        KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+    }
 
-        #pragma prefast(pop)
+    NotifySet->WaitActive = FALSE;
+
+    //
+    // Re-query ready IO regardless of the wait status.
+    //
+    __try {
+        ReadyCount = XskNotifySetQueryReadyIo(NotifySet, Results, ResultCount);
     } __except (EXCEPTION_EXECUTE_HANDLER) {
-        IoStatus->Status = GetExceptionCode();
+        Status = GetExceptionCode();
         goto Exit;
     }
 
+    if (ReadyCount > 0) {
+        Status = STATUS_SUCCESS;
+    }
+
 Exit:
 
-    return TRUE;
+    if (IsLockHeld) {
+        RtlReleasePushLockExclusive(&NotifySet->Lock);
+    }
+
+    *Information = NT_SUCCESS(Status) ? ReadyCount : 0;
+
+    return Status;
 }
-#pragma warning(pop)
 
 static
 NTSTATUS
-XskIrpSetSockopt(
+XskNotifySetAdd(
     _In_ IRP *Irp,
     _In_ IO_STACK_LOCATION *IrpSp
     )
 {
-    NTSTATUS Status = STATUS_SUCCESS;
-    XSK *Xsk;
-    XSK_SET_SOCKOPT_IN *Sockopt = NULL;
+    XSK_NOTIFY_SET *NotifySet = IrpSp->FileObject->FsContext;
+    XSK_NOTIFY_SET_ADD_IN Add;
+    XSK_NOTIFY_SET_MEMBER *Member = NULL;
+    FILE_OBJECT *FileObject = NULL;
+    XSK *Xsk = NULL;
+    KIRQL OldIrql;
+    BOOLEAN IsLockHeld = FALSE;
+    NTSTATUS Status;
+    const UINT32 WaitMask = (XSK_NOTIFY_FLAG_WAIT_RX | XSK_NOTIFY_FLAG_WAIT_TX);
 
-    Xsk = IrpSp->FileObject->FsContext;
+    if (IrpSp->Parameters.DeviceIoControl.InputBufferLength < sizeof(Add)) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto Exit;
+    }
 
-    if (IrpSp->Parameters.DeviceIoControl.InputBufferLength < sizeof(XSK_SET_SOCKOPT_IN)) {
-        return STATUS_INVALID_PARAMETER;
+    Add = *(XSK_NOTIFY_SET_ADD_IN *)Irp->AssociatedIrp.SystemBuffer;
+
+    TraceEnter(
+        TRACE_XSK, "NotifySet=%p Socket=%p Flags=%x", NotifySet, Add.Socket, Add.Flags);
+
+    if (Add.Flags == 0 || (Add.Flags & ~WaitMask) != 0) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto Exit;
     }
 
-    Sockopt = Irp->AssociatedIrp.SystemBuffer;
+    Status =
+        XdpReferenceObjectByHandle(
+            Add.Socket, XDP_OBJECT_TYPE_XSK, Irp->RequestorMode, FILE_GENERIC_WRITE,
+            &FileObject);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
 
-    switch (Sockopt->Option) {
-    case XSK_SOCKOPT_UMEM_REG:
-        Status = XskSockoptSetUmem(Xsk, Sockopt, Irp->RequestorMode);
-        break;
-    case XSK_SOCKOPT_TX_RING_SIZE:
-    case XSK_SOCKOPT_RX_RING_SIZE:
-    case XSK_SOCKOPT_RX_FILL_RING_SIZE:
-    case XSK_SOCKOPT_TX_COMPLETION_RING_SIZE:
-        Status = XskSockoptSetRingSize(Xsk, Sockopt, Irp->RequestorMode);
-        break;
-    case XSK_SOCKOPT_RX_HOOK_ID:
-    case XSK_SOCKOPT_TX_HOOK_ID:
-        Status = XskSockoptSetHookId(Xsk, Sockopt, Irp->RequestorMode);
-        break;
-    case XSK_SOCKOPT_RX_PROCESSOR_AFFINITY:
-    case XSK_SOCKOPT_TX_PROCESSOR_AFFINITY:
-        Status = XskSockoptSetIdealProcessor(Xsk, Sockopt, Irp->RequestorMode);
-        break;
-    case XSK_SOCKOPT_TX_OFFLOAD_CHECKSUM:
-        Status = XskSockoptSetTxOffloadChecksum(Xsk, Sockopt, Irp->RequestorMode);
-        break;
-    case XSK_SOCKOPT_RX_OFFLOAD_CHECKSUM:
-        Status = XskSockoptSetRxOffloadChecksum(Xsk, Sockopt, Irp->RequestorMode);
-        break;
-    case XSK_SOCKOPT_RX_OFFLOAD_TIMESTAMP:
-        Status = XskSockoptSetRxOffloadTimestamp(Xsk, Sockopt, Irp->RequestorMode);
-        break;
-    case XSK_SOCKOPT_TX_OFFLOAD_TIMESTAMP:
-        Status = XskSockoptSetTxOffloadTimestamp(Xsk, Sockopt, Irp->RequestorMode);
-        break;
-    case XSK_SOCKOPT_RX_ORIGINAL_LENGTH:
-        Status = XskSockoptSetRxOriginalLength(Xsk, Sockopt, Irp->RequestorMode);
-        break;
-#if !defined(XDP_OFFICIAL_BUILD)
-    case XSK_SOCKOPT_POLL_MODE:
-        Status = XskSockoptSetPollMode(Xsk, Sockopt, Irp->RequestorMode);
-        break;
-#endif // !defined(XDP_OFFICIAL_BUILD)
-    default:
-        Status = STATUS_NOT_SUPPORTED;
-        break;
+    Xsk = FileObject->FsContext;
+
+    Member = ExAllocatePoolZero(NonPagedPoolNx, sizeof(*Member), POOLTAG_NOTIFY);
+    if (Member == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto Exit;
     }
 
-    TraceInfo(
-        TRACE_XSK, "Xsk=%p Option=%u Status=%!STATUS! Value=%!HEXDUMP!",
-        Xsk, Sockopt->Option, Status, WppHexDump(Sockopt->InputBuffer, Sockopt->InputBufferLength));
+    Member->NotifySet = NotifySet;
+    Member->FileObject = FileObject;
+    Member->Xsk = Xsk;
+    Member->Flags = Add.Flags;
+    Member->Context = Add.Context;
 
-    return Status;
-}
+    RtlAcquirePushLockExclusive(&NotifySet->Lock);
+    IsLockHeld = TRUE;
 
-static
-NTSTATUS
-XskNotifyValidateParams(
-    _In_ XSK *Xsk,
-    _In_opt_ VOID *InputBuffer,
-    _In_ ULONG InputBufferLength,
-    _Out_ PUINT32 TimeoutMilliseconds,
-    _Out_ PUINT32 InFlags
-    )
-{
-    if (Xsk->State != XskActive){
-        return STATUS_INVALID_DEVICE_STATE;
+    if (NotifySet->Closing) {
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
     }
 
-    if (InputBufferLength < sizeof(XSK_NOTIFY_IN)) {
-        return STATUS_INVALID_PARAMETER;
+    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
+
+    //
+    // A socket can belong to a single notification set, and only activated
+    // rings can satisfy a wait.
+    //
+    if (Xsk->State != XskActive || Xsk->NotifySetMember != NULL ||
+        (Add.Flags & XSK_NOTIFY_FLAG_WAIT_RX && !Xsk->Rx.Flags.Activated) ||
+        (Add.Flags & XSK_NOTIFY_FLAG_WAIT_TX && !Xsk->Tx.Flags.Activated)) {
+        KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+        Status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
     }
 
-    __try {
-        ASSERT(InputBuffer);
-        if (ExGetPreviousMode() != KernelMode) {
-            ProbeForRead(
-                (VOID*)InputBuffer, InputBufferLength, PROBE_ALIGNMENT(XSK_NOTIFY_IN));
-        }
+    Xsk->NotifySetMember = Member;
+    KeReleaseSpinLock(&Xsk->Lock, OldIrql);
 
-        *InFlags = ReadUInt32NoFence((UINT32 *)&((XSK_NOTIFY_IN *)InputBuffer)->Flags);
-        *TimeoutMilliseconds =
-            ReadUInt32NoFence(&((XSK_NOTIFY_IN *)InputBuffer)->WaitTimeoutMilliseconds);
-    } __except (EXCEPTION_EXECUTE_HANDLER) {
-        return GetExceptionCode();
+    InsertTailList(&NotifySet->Members, &Member->Link);
+
+    if (NotifySet->WaitActive) {
+        //
+        // Join the wait in progress.
+        //
+        XskNotifySetArmMember(NotifySet, Member);
+        XdpBarrierBetweenReleaseAndAcquire();
+        XskNotifySetSignalReadyMember(NotifySet, Member);
     }
 
-    if (*InFlags == 0 || *InFlags &
-            ~(XSK_NOTIFY_FLAG_POKE_RX | XSK_NOTIFY_FLAG_POKE_TX | XSK_NOTIFY_FLAG_WAIT_RX | XSK_NOTIFY_FLAG_WAIT_TX)) {
-        return STATUS_INVALID_PARAMETER;
+    //
+    // The member now owns the socket file object reference.
+    //
+    Member = NULL;
+    FileObject = NULL;
+    Status = STATUS_SUCCESS;
+
+Exit:
+
+    if (IsLockHeld) {
+        RtlReleasePushLockExclusive(&NotifySet->Lock);
     }
 
-    if ((*InFlags & (XSK_NOTIFY_FLAG_POKE_RX | XSK_NOTIFY_FLAG_WAIT_RX) && !Xsk->Rx.Flags.Activated) ||
-        (*InFlags & (XSK_NOTIFY_FLAG_POKE_TX | XSK_NOTIFY_FLAG_WAIT_TX) && !Xsk->Tx.Flags.Activated)) {
-        return STATUS_INVALID_DEVICE_STATE;
+    if (Member != NULL) {
+        ExFreePoolWithTag(Member, POOLTAG_NOTIFY);
     }
 
-    return STATUS_SUCCESS;
+    if (FileObject != NULL) {
+        ObDereferenceObject(FileObject);
+    }
+
+    TraceInfo(TRACE_XSK, "NotifySet=%p Xsk=%p Status=%!STATUS!", NotifySet, Xsk, Status);
+    TraceExitStatus(TRACE_XSK);
+
+    return Status;
 }
 
 static
 NTSTATUS
-XskPoke(
-    _In_ XSK *Xsk,
-    _In_ UINT32 Flags,
-    _In_ UINT32 TimeoutMs
+XskNotifySetRemove(
+    _In_ IRP *Irp,
+    _In_ IO_STACK_LOCATION *IrpSp
     )
 {
-    NTSTATUS Status = STATUS_SUCCESS;
+    XSK_NOTIFY_SET *NotifySet = IrpSp->FileObject->FsContext;
+    XSK_NOTIFY_SET_REMOVE_IN Remove;
+    XSK_NOTIFY_SET_MEMBER *Member;
+    FILE_OBJECT *FileObject = NULL;
+    XSK *Xsk = NULL;
+    NTSTATUS Status;
 
-    EventWriteXskNotifyPokeStart(&MICROSOFT_XDP_PROVIDER, Xsk, Flags);
+    if (IrpSp->Parameters.DeviceIoControl.InputBufferLength < sizeof(Remove)) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto Exit;
+    }
 
-    RtlAcquirePushLockExclusive(&Xsk->PollLock);
+    Remove = *(XSK_NOTIFY_SET_REMOVE_IN *)Irp->AssociatedIrp.SystemBuffer;
 
-    if (Xsk->PollMode == XSK_POLL_MODE_SOCKET &&
-        (Xsk->Rx.Xdp.PollHandle != NULL || Xsk->Tx.Xdp.PollHandle != NULL)) {
-        //
-        // Socket polling mode is active, so poll the interfaces synchronously.
-        //
-        Status = XskPollSocket(Xsk, Flags, TimeoutMs);
-    } else {
-        //
-        // Notify the underlying interfaces that data is available.
-        //
+    TraceEnter(TRACE_XSK, "NotifySet=%p Socket=%p", NotifySet, Remove.Socket);
 
-        if (Flags & XSK_NOTIFY_FLAG_POKE_RX) {
-            ASSERT(Xsk->Rx.Ring.Size > 0);
-            ASSERT(Xsk->Rx.FillRing.Size > 0);
-            //
-            // TODO: Driver poke routine for zero copy RX.
-            //
-            ASSERT(Status == STATUS_SUCCESS);
-        }
+    Status =
+        XdpReferenceObjectByHandle(
+            Remove.Socket, XDP_OBJECT_TYPE_XSK, Irp->RequestorMode, FILE_GENERIC_WRITE,
+            &FileObject);
+    if (!NT_SUCCESS(Status)) {
+        goto Exit;
+    }
 
-        if (Flags & XSK_NOTIFY_FLAG_POKE_TX) {
-            XDP_NOTIFY_QUEUE_FLAGS NotifyFlags = XDP_NOTIFY_QUEUE_FLAG_TX;
-            //
-            // Before invoking the poke routine, atomically clear the need poke
-            // flag on the TX ring. The poke routine is required to execute a
-            // FlushTransmit, which guarantees the need poke flag can be set.
-            //
-            InterlockedAndNoFence((LONG *)&Xsk->Tx.Ring.Shared->Flags, ~XSK_RING_FLAG_NEED_POKE);
+    Xsk = FileObject->FsContext;
 
-            if (Xsk->Tx.Xdp.Flags.QueueActive) {
-                XdpTxQueueInvokeInterfaceNotify(Xsk->Tx.Xdp.Queue, NotifyFlags);
-            } else {
-                Status = STATUS_DEVICE_REMOVED;
-            }
-        }
+    RtlAcquirePushLockExclusive(&NotifySet->Lock);
+
+    Member = XskNotifySetFindMember(NotifySet, Xsk);
+    if (Member != NULL) {
+        XskNotifySetRemoveMember(NotifySet, Member);
+        Status = STATUS_SUCCESS;
+    } else {
+        Status = STATUS_NOT_FOUND;
     }
 
-    RtlReleasePushLockExclusive(&Xsk->PollLock);
+    RtlReleasePushLockExclusive(&NotifySet->Lock);
+
+Exit:
+
+    if (FileObject != NULL) {
+        ObDereferenceObject(FileObject);
+    }
 
-    EventWriteXskNotifyPokeStop(&MICROSOFT_XDP_PROVIDER, Xsk, Flags);
+    TraceInfo(TRACE_XSK, "NotifySet=%p Xsk=%p Status=%!STATUS!", NotifySet, Xsk, Status);
+    TraceExitStatus(TRACE_XSK);
 
     return Status;
 }
 
-static DRIVER_CANCEL XskCancelNotify;
-
 static
 _Use_decl_annotations_
-VOID
-XskCancelNotify(
-    DEVICE_OBJECT *DeviceObject,
-    IRP *Irp
+NTSTATUS
+XskNotifySetIrpDeviceIoControl(
+    IRP *Irp,
+    IO_STACK_LOCATION *IrpSp
     )
 {
-    XSK *Xsk;
-    IO_STACK_LOCATION *IrpSp;
+    NTSTATUS Status;
 
-    UNREFERENCED_PARAMETER(DeviceObject);
+    Irp->IoStatus.Information = 0;
 
-    IoReleaseCancelSpinLock(DISPATCH_LEVEL);
+    switch (IrpSp->Parameters.DeviceIoControl.IoControlCode) {
+    case IOCTL_XSK_NOTIFY_SET_ADD:
+        Status = XskNotifySetAdd(Irp, IrpSp);
+        break;
+    case IOCTL_XSK_NOTIFY_SET_REMOVE:
+        Status = XskNotifySetRemove(Irp, IrpSp);
+        break;
+    case IOCTL_XSK_NOTIFY_SET_WAIT:
+        Status =
+            XskNotifySetWait(
+                IrpSp->FileObject->FsContext, IrpSp->Parameters.DeviceIoControl.Type3InputBuffer,
+                IrpSp->Parameters.DeviceIoControl.InputBufferLength, Irp->UserBuffer,
+                IrpSp->Parameters.DeviceIoControl.OutputBufferLength,
+                &Irp->IoStatus.Information);
+        break;
+    default:
+        Status = STATUS_NOT_SUPPORTED;
+        break;
+    }
 
-    IrpSp = IoGetCurrentIrpStackLocation(Irp);
-    Xsk = IrpSp->FileObject->FsContext;
+    return Status;
+}
 
-    KeAcquireSpinLockAtDpcLevel(&Xsk->Lock);
+static
+_Use_decl_annotations_
+NTSTATUS
+XskNotifySetIrpCleanup(
+    IRP *Irp,
+    IO_STACK_LOCATION *IrpSp
+    )
+{
+    XSK_NOTIFY_SET *NotifySet = IrpSp->FileObject->FsContext;
+
+    UNREFERENCED_PARAMETER(Irp);
+
+    TraceEnter(TRACE_XSK, "NotifySet=%p", NotifySet);
 
     //
-    // If the data path hasn't already dropped the IRP, reset the wait state
-    // here.
+    // Release the member sockets and wake any wait in progress.
     //
+    RtlAcquirePushLockExclusive(&NotifySet->Lock);
 
-    if (Xsk->IoWaitIrp == Irp) {
-        Xsk->IoWaitFlags = 0;
-        Xsk->IoWaitIrp = NULL;
+    NotifySet->Closing = TRUE;
+
+    while (!IsListEmpty(&NotifySet->Members)) {
+        XskNotifySetRemoveMember(
+            NotifySet,
+            CONTAINING_RECORD(NotifySet->Members.Flink, XSK_NOTIFY_SET_MEMBER, Link));
     }
 
-    KeReleaseSpinLock(&Xsk->Lock, Irp->CancelIrql);
+    (VOID)KeSetEvent(&NotifySet->Event, IO_NO_INCREMENT, FALSE);
 
-    Irp->IoStatus.Status = STATUS_CANCELLED;
+    RtlReleasePushLockExclusive(&NotifySet->Lock);
 
-    EventWriteXskNotifyAsyncComplete(&MICROSOFT_XDP_PROVIDER, Xsk, Irp, Irp->IoStatus.Status);
-    IoCompleteRequest(Irp, IO_NETWORK_INCREMENT);
+    TraceExitSuccess(TRACE_XSK);
+
+    return STATUS_SUCCESS;
 }
 
 static
-_Success_(return == STATUS_SUCCESS)
+_Use_decl_annotations_
 NTSTATUS
-XskNotify(
-    _In_ XSK *Xsk,
-    _In_opt_ VOID *InputBuffer,
-    _In_ ULONG InputBufferLength,
-    _Out_ ULONG_PTR *Information,
-    _Inout_opt_ IRP *Irp
+XskNotifySetIrpClose(
+    IRP *Irp,
+    IO_STACK_LOCATION *IrpSp
     )
 {
-    UINT32 TimeoutMilliseconds;
-    UINT32 ReadyFlags;
-    UINT32 InFlags;
-    UINT32 OutFlags = 0;
-    KIRQL OldIrql;
-    LARGE_INTEGER Timeout;
-    NTSTATUS Status;
-    XSK_IO_WAIT_FLAGS InternalFlags;
-    const UINT32 WaitMask = (XSK_NOTIFY_FLAG_WAIT_RX | XSK_NOTIFY_FLAG_WAIT_TX);
-
-    Status =
-        XskNotifyValidateParams(
-            Xsk, InputBuffer, InputBufferLength, &TimeoutMilliseconds, &InFlags);
-    if (Status != STATUS_SUCCESS) {
-        TraceError(TRACE_XSK, "Xsk=%p Notify failed: Invalid params", Xsk);
-        goto Exit;
-    }
+    XSK_NOTIFY_SET *NotifySet = IrpSp->FileObject->FsContext;
 
-    EventWriteXskNotifyStart(&MICROSOFT_XDP_PROVIDER, Xsk, Irp, InFlags, TimeoutMilliseconds);
+    UNREFERENCED_PARAMETER(Irp);
 
-    //
-    // Snap the XSK notification state before performing the poke and/or wait.
-    //
-    InternalFlags = ReadULongAcquire((ULONG *)&Xsk->IoWaitInternalFlags);
+    TraceInfo(TRACE_XSK, "NotifySet=%p", NotifySet);
 
-    if (InFlags & (XSK_NOTIFY_FLAG_POKE_RX | XSK_NOTIFY_FLAG_POKE_TX)) {
-        Status = XskPoke(Xsk, InFlags, TimeoutMilliseconds);
-        if (Status != STATUS_SUCCESS) {
-            TraceError(
-                TRACE_XSK, "Xsk=%p Notify failed: Poke failed Status=%!STATUS!",
-                Xsk, Status);
-            goto Exit;
-        }
-    }
+    ASSERT(IsListEmpty(&NotifySet->Members));
+    ExFreePoolWithTag(NotifySet, POOLTAG_NOTIFY);
 
-    if ((InFlags & (XSK_NOTIFY_FLAG_WAIT_RX | XSK_NOTIFY_FLAG_WAIT_TX)) == 0) {
-        //
-        // Not interested in waiting for IO.
-        //
-        ASSERT(Status == STATUS_SUCCESS);
-        goto Exit;
-    }
+    return STATUS_SUCCESS;
+}
 
-    //
-    // Opportunistic check for ready IO to avoid setting up a wait context.
-    //
-    ReadyFlags = XskQueryReadyIo(Xsk, InFlags);
-    if (ReadyFlags != 0) {
-        OutFlags |= XskWaitInFlagsToOutFlags(ReadyFlags);
-        ASSERT(Status == STATUS_SUCCESS);
-        goto Exit;
-    }
+#pragma warning(push)
+#pragma warning(disable:6101) // We don't set OutputBuffer in some paths
+BOOLEAN
+XskNotifySetFastIo(
+    _In_ XDP_FILE_OBJECT_HEADER *FileObjectHeader,
+    _In_opt_ VOID *InputBuffer,
+    _In_ ULONG InputBufferLength,
+    _Out_opt_ VOID *OutputBuffer,
+    _In_ ULONG OutputBufferLength,
+    _In_ ULONG IoControlCode,
+    _Out_ IO_STATUS_BLOCK *IoStatus
+    )
+{
+    XSK_NOTIFY_SET *NotifySet = CONTAINING_RECORD(FileObjectHeader, XSK_NOTIFY_SET, Header);
 
-    //
-    // Set up the wait context.
-    //
-    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
-    if (Xsk->State != XskActive) {
-        KeReleaseSpinLock(&Xsk->Lock, OldIrql);
-        TraceInfo(TRACE_XSK, "Xsk=%p Notify wait failed: XSK not bound", Xsk);
-        Status = STATUS_INVALID_DEVICE_STATE;
-        goto Exit;
-    }
-    if (Xsk->IoWaitFlags != 0) {
-        //
-        // There is currently a wait active. Only a single wait is allowed.
-        //
-        KeReleaseSpinLock(&Xsk->Lock, OldIrql);
-        TraceError(TRACE_XSK, "Xsk=%p Notify wait failed: Wait already active", Xsk);
-        Status = STATUS_INVALID_DEVICE_STATE;
-        goto Exit;
+    switch (IoControlCode) {
+    case IOCTL_XSK_NOTIFY_SET_WAIT:
+        IoStatus->Status =
+            XskNotifySetWait(
+                NotifySet, InputBuffer, InputBufferLength, OutputBuffer, OutputBufferLength,
+                &IoStatus->Information);
+        return TRUE;
     }
-    Xsk->IoWaitFlags = InFlags & WaitMask;
-    if (Irp != NULL) {
-        Xsk->IoWaitIrp = Irp;
-
-        //
-        // Mark the IRP as pending prior to enabling cancellation; once we mark
-        // an IRP as pending, we must return STATUS_PENDING to the IO manager.
-        //
-        IoMarkIrpPending(Irp);
-        Status = STATUS_PENDING;
-
-        //
-        // Enable cancellation and synchronize with the IO manager.
-        //
-        IoSetCancelRoutine(Irp, XskCancelNotify);
-        if (Irp->Cancel) {
-            if (IoSetCancelRoutine(Irp, NULL) != NULL) {
-                //
-                // The cancellation routine will not run; cancel the IRP here
-                // and bail.
-                //
-                Xsk->IoWaitIrp = NULL;
-                Xsk->IoWaitFlags = 0;
-                KeReleaseSpinLock(&Xsk->Lock, OldIrql);
-                Irp->IoStatus.Status = STATUS_CANCELLED;
-                EventWriteXskNotifyAsyncComplete(
-                    &MICROSOFT_XDP_PROVIDER, Xsk, Irp, Irp->IoStatus.Status);
-                IoCompleteRequest(Irp, IO_NETWORK_INCREMENT);
-            } else {
-                //
-                // The cancellation routine will run; bail.
-                //
-                KeReleaseSpinLock(&Xsk->Lock, OldIrql);
-            }
 
-            goto Exit;
-        }
-    } else {
-        KeClearEvent(&Xsk->IoWaitEvent);
-    }
-    KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+    return FALSE;
+}
+#pragma warning(pop)
 
-    //
-    // N.B. A memory barrier between the write of the wait event and the read of
-    // completed IO is needed in order to prevent a race condition when these
-    // operations are re-ordered. The race is between this thread and a thread
-    // completing IO. Memory barriers are also needed to protect against a
-    // similar race condition when the inverse of these operations are done
-    // during IO completion.
-    //
-    XdpBarrierBetweenReleaseAndAcquire();
+static
+FORCEINLINE
+BOOLEAN
+XskReceiveIsZeroCopyFrame(
+    _In_ XSK *Xsk,
+    _In_ XDP_FRAME *Frame,
+    _In_ const XDP_BUFFER_VIRTUAL_ADDRESS *Va,
+    _Out_ UINT64 *UmemAddress
+    )
+{
+    const UMEM *Umem = Xsk->Umem;
+    const XDP_BUFFER *Buffer = &Frame->Buffer;
+    UINT64 *PostedChunk;
 
     //
-    // Check for ready IO.
+    // A frame was received without a copy if its buffer was posted from this
+    // socket's fill ring and not yet delivered: the buffer starts at a posted
+    // chunk's data, and lies entirely within the chunk.
     //
-    ReadyFlags = XskQueryReadyIo(Xsk, InFlags);
-    if (ReadyFlags != 0) {
-        XskSignalReadyIo(Xsk, ReadyFlags);
+    if (!Xsk->Rx.Flags.ZeroCopy || Xsk->Rx.Xdp.FragmentRing != NULL) {
+        return FALSE;
     }
 
-    //
-    // If the notification state changed while processing this request, abandon
-    // the wait and allow the application to re-examine the shared ring flags.
-    //
-    if (InternalFlags != Xsk->IoWaitInternalFlags) {
-        XskSignalReadyIo(Xsk, InFlags & WaitMask);
-    }
+    *UmemAddress =
+        (UINT64)((UINT_PTR)Va->VirtualAddress - (UINT_PTR)Umem->Mapping.SystemAddress) -
+            Umem->Reg.Headroom;
 
-    if (Irp == NULL) {
-        //
-        // Wait for IO.
-        //
-        Timeout.QuadPart = -1 * RTL_MILLISEC_TO_100NANOSEC(TimeoutMilliseconds);
-        Status =
-            KeWaitForSingleObject(
-                &Xsk->IoWaitEvent, UserRequest, ExGetPreviousMode(), FALSE,
-                (TimeoutMilliseconds == XDP_INFINITE) ? NULL : &Timeout);
-    } else {
-        ASSERT(Status == STATUS_PENDING);
-        goto Exit;
+    if (*UmemAddress > Umem->Reg.TotalSize - Umem->Reg.ChunkSize ||
+        (UINT64)Buffer->DataOffset + Buffer->DataLength >
+            Umem->Reg.ChunkSize - Umem->Reg.Headroom ||
+        (UINT64)Buffer->DataOffset + Umem->Reg.Headroom > MAXUINT16) {
+        return FALSE;
     }
 
-    KeAcquireSpinLock(&Xsk->Lock, &OldIrql);
-    Xsk->IoWaitFlags = 0;
-    KeReleaseSpinLock(&Xsk->Lock, OldIrql);
+    PostedChunk = &Xsk->Rx.PostedChunks[*UmemAddress / Umem->Reg.ChunkSize];
+    if (*PostedChunk != *UmemAddress + 1) {
+        return FALSE;
+    }
 
     //
-    // Re-query ready IO regardless of the wait status.
+    // The chunk is delivered to the RX ring, so it is no longer posted.
     //
-    ReadyFlags = XskQueryReadyIo(Xsk, InFlags);
-    if (ReadyFlags != 0) {
-        Status = STATUS_SUCCESS;
-        OutFlags |= XskWaitInFlagsToOutFlags(ReadyFlags);
-    }
+    *PostedChunk = 0;
+    return TRUE;
+}
 
-Exit:
+static
+FORCEINLINE
+BOOLEAN
+XskReceiveConsumeFill(
+    _In_ XSK *Xsk,
+    _In_ UINT32 FillAvailable,
+    _Inout_ UINT32 *FillConsumed,
+    _Out_ UINT64 *UmemAddress
+    )
+{
+    UINT32 RingIndex;
 
     //
-    // This IOCTL is assumed to never pend for fast IO, and code elsewhere takes
-    // advantage of this assumption.
+    // Consume fill descriptors until a valid one is found.
     //
-    ASSERT(Irp != NULL || Status != STATUS_PENDING);
+    while (*FillConsumed < FillAvailable) {
+        RingIndex =
+            (ReadUInt32NoFence(&Xsk->Rx.FillRing.Shared->ConsumerIndex) + (*FillConsumed)++) &
+                Xsk->Rx.FillRing.Mask;
+        *UmemAddress = *(UINT64 *)XskKernelRingGetElement(&Xsk->Rx.FillRing, RingIndex);
+
+        if (*UmemAddress <= Xsk->Umem->Reg.TotalSize - Xsk->Umem->Reg.ChunkSize) {
+            return TRUE;
+        }
 
-    if (Status != STATUS_PENDING) {
-        *Information = OutFlags;
+        //
+        // Invalid FILL descriptor.
+        //
+        Xsk->Statistics.RxInvalidDescriptors++;
+        STAT_INC(XdpRxQueueGetStats(Xsk->Rx.Xdp.Queue), XskInvalidDescriptors);
     }
 
-    EventWriteXskNotifyStop(&MICROSOFT_XDP_PROVIDER, Xsk, Irp, OutFlags, Status);
-
-    return Status;
+    return FALSE;
 }
 
-#pragma warning(push)
-#pragma warning(disable:6101) // We don't set OutputBuffer in some paths
-BOOLEAN
-XskFastIo(
-    _In_ XDP_FILE_OBJECT_HEADER *FileObjectHeader,
-    _In_opt_ VOID *InputBuffer,
-    _In_ ULONG InputBufferLength,
-    _Out_opt_ VOID *OutputBuffer,
-    _In_ ULONG OutputBufferLength,
-    _In_ ULONG IoControlCode,
-    _Out_ IO_STATUS_BLOCK *IoStatus
+static
+FORCEINLINE
+VOID
+XskReceiveCopyMetadata(
+    _In_ XSK *Xsk,
+    _In_ XDP_FRAME *Frame,
+    _In_ UINT32 MetadataLength,
+    _In_ UINT64 UmemAddress
     )
 {
-    XSK *Xsk = CONTAINING_RECORD(FileObjectHeader, XSK, Header);
-
-    switch (IoControlCode) {
-    case IOCTL_XSK_NOTIFY:
-        IoStatus->Status =
-            XskNotify(Xsk, InputBuffer, InputBufferLength, &IoStatus->Information, NULL);
-        return TRUE;
+    XDP_BUFFER *Buffer = &Frame->Buffer;
+    XDP_BUFFER_VIRTUAL_ADDRESS *Va;
 
-    case IOCTL_XSK_GET_SOCKOPT:
-        return
-            XskFastGetSockopt(
-                FileObjectHeader, InputBuffer, InputBufferLength, OutputBuffer,
-                OutputBufferLength, IoStatus);
+    //
+    // Metadata preceding the frame's data is copied into the end of the UMEM
+    // chunk's headroom, immediately before the copied data. Metadata that does
+    // not fit within the headroom is not delivered.
+    //
+    if (MetadataLength == 0 || MetadataLength > Xsk->Umem->Reg.Headroom ||
+        XskGlobals.RxZeroCopy) {
+        return;
     }
 
-    return FALSE;
+    ASSERT(MetadataLength <= Buffer->DataOffset);
+    Va = XdpGetVirtualAddressExtension(Buffer, &Xsk->Rx.Xdp.VaExtension);
+
+    RtlCopyVolatileMemory(
+        Xsk->Umem->Mapping.SystemAddress + UmemAddress + Xsk->Umem->Reg.Headroom -
+            MetadataLength,
+        Va->VirtualAddress + Buffer->DataOffset - MetadataLength, MetadataLength);
 }
-#pragma warning(pop)
 
 static
 FORCEINLINE
-VOID
-XskReceiveSingleFrame(
+UINT32
+XskReceiveCopyFrame(
     _In_ XSK *Xsk,
-    _In_ UINT32 FrameIndex,
+    _In_ XDP_FRAME *Frame,
     _In_ UINT32 FragmentIndex,
-    _In_ UINT32 FillOffset,
-    _Inout_ UINT32 *CompletionOffset
+    _In_ UINT64 UmemAddress
     )
 {
     XDP_RING *FragmentRing = Xsk->Rx.Xdp.FragmentRing;
-    XDP_FRAME *Frame = XdpRingGetElement(Xsk->Rx.Xdp.FrameRing, FrameIndex);
     XDP_FRAME_FRAGMENT *Fragment;
     XDP_BUFFER *Buffer = &Frame->Buffer;
     XDP_BUFFER_VIRTUAL_ADDRESS *Va = XdpGetVirtualAddressExtension(Buffer, &Xsk->Rx.Xdp.VaExtension);
     UCHAR *UmemChunk;
-    UINT64 UmemAddress;
     UINT32 UmemOffset;
     UINT32 CopyLength;
-    UINT32 RingIndex;
-
-    XSK_FRAME_DESCRIPTOR *XskFrame;
-    XSK_BUFFER_DESCRIPTOR *XskBuffer;
-    XSK_BUFFER_ADDRESS XskBufferAddress;
-
-    RingIndex =
-        (ReadUInt32NoFence(&Xsk->Rx.FillRing.Shared->ConsumerIndex) + FillOffset) &
-            Xsk->Rx.FillRing.Mask;
-    UmemAddress = *(UINT64 *)XskKernelRingGetElement(&Xsk->Rx.FillRing, RingIndex);
-
-    if (UmemAddress > Xsk->Umem->Reg.TotalSize - Xsk->Umem->Reg.ChunkSize) {
-        //
-        // Invalid FILL descriptor.
-        //
-        Xsk->Statistics.RxInvalidDescriptors++;
-        STAT_INC(XdpRxQueueGetStats(Xsk->Rx.Xdp.Queue), XskInvalidDescriptors);
-        return;
-    }
 
     UmemChunk = Xsk->Umem->Mapping.SystemAddress + UmemAddress;
     UmemOffset = Xsk->Umem->Reg.Headroom;
@@ -5813,18 +7814,69 @@ XskReceiveSingleFrame(
         }
     }
 
+    return UmemOffset - Xsk->Umem->Reg.Headroom + CopyLength;
+}
+
+static
+FORCEINLINE
+XDP_BUFFER *
+XskReceiveGetFrameBuffer(
+    _In_ XSK *Xsk,
+    _In_ XDP_FRAME *Frame,
+    _In_ UINT32 FragmentIndex,
+    _In_ UINT32 BufferIndex
+    )
+{
+    XDP_RING *FragmentRing = Xsk->Rx.Xdp.FragmentRing;
+
+    if (BufferIndex == 0) {
+        return &Frame->Buffer;
+    }
+
+    return XdpRingGetElement(FragmentRing, (FragmentIndex + BufferIndex - 1) & FragmentRing->Mask);
+}
+
+static
+FORCEINLINE
+XSK_FRAME_DESCRIPTOR *
+XskReceiveProduceDescriptor(
+    _In_ XSK *Xsk,
+    _In_ UINT32 CompletionOffset,
+    _In_ UINT64 UmemAddress,
+    _In_ UINT32 DataOffset,
+    _In_ UINT32 DataLength
+    )
+{
+    XSK_FRAME_DESCRIPTOR *XskFrame;
+    XSK_BUFFER_DESCRIPTOR *XskBuffer;
+    XSK_BUFFER_ADDRESS XskBufferAddress;
+    UINT32 RingIndex;
+
     RingIndex =
-        (ReadUInt32NoFence(&Xsk->Rx.Ring.Shared->ProducerIndex) + *CompletionOffset) &
+        (ReadUInt32NoFence(&Xsk->Rx.Ring.Shared->ProducerIndex) + CompletionOffset) &
             Xsk->Rx.Ring.Mask;
     XskFrame = XskKernelRingGetElement(&Xsk->Rx.Ring, RingIndex);
     XskBuffer = &XskFrame->Buffer;
 
     XskBufferAddress.BaseAddress = UmemAddress;
-    ASSERT(Xsk->Umem->Reg.Headroom <= MAXUINT16);
-    XskBufferAddress.Offset = (UINT16)Xsk->Umem->Reg.Headroom;
+    ASSERT(DataOffset <= MAXUINT16);
+    XskBufferAddress.Offset = (UINT16)DataOffset;
     WriteUInt64NoFence(&XskBuffer->Address.AddressAndOffset, XskBufferAddress.AddressAndOffset);
-    WriteUInt32NoFence(&XskBuffer->Length, UmemOffset - Xsk->Umem->Reg.Headroom + CopyLength);
+    WriteUInt32NoFence(&XskBuffer->Length, DataLength);
+    WriteUInt32NoFence(&XskBuffer->Flags, XSK_BUFFER_DESCRIPTOR_FLAG_NONE);
+
+    return XskFrame;
+}
 
+static
+FORCEINLINE
+VOID
+XskReceiveCopyExtensions(
+    _In_ XSK *Xsk,
+    _In_ XDP_FRAME *Frame,
+    _In_ XSK_FRAME_DESCRIPTOR *XskFrame
+    )
+{
     if (Xsk->Rx.ExtensionFlags.Value != 0) {
         if (Xsk->Rx.LayoutExtensionOffset != 0) {
             const XDP_FRAME_LAYOUT *XdpLayout =
@@ -5858,9 +7910,10 @@ XskReceiveSingleFrame(
             ASSERT(Xsk->Rx.OriginalLengthExtensionOffset != 0);
             XSK_FRAME_ORIGINAL_LENGTH *XskOriginalLength =
                 RTL_PTR_ADD(XskFrame, Xsk->Rx.OriginalLengthExtensionOffset);
-            C_ASSERT(sizeof(XskOriginalLength->OriginalLength) == sizeof(Buffer->DataLength));
+            C_ASSERT(
+                sizeof(XskOriginalLength->OriginalLength) == sizeof(Frame->Buffer.DataLength));
             RtlCopyVolatileMemory(
-                &XskOriginalLength->OriginalLength, &Buffer->DataLength,
+                &XskOriginalLength->OriginalLength, &Frame->Buffer.DataLength,
                 sizeof(XskOriginalLength->OriginalLength));
         }
         if (Xsk->Rx.ExtensionFlags.Timestamp) {
@@ -5873,9 +7926,209 @@ XskReceiveSingleFrame(
             ASSERT(Xsk->Rx.TimestampExtensionOffset != 0);
             RtlCopyVolatileMemory(XskTimestamp, XdpTimestamp, sizeof(*XskTimestamp));
         }
+        if (Xsk->Rx.ExtensionFlags.Gro) {
+            const XDP_FRAME_GRO *XdpGro = XdpGetGroExtension(Frame, &Xsk->Rx.Xdp.GroExtension);
+            XDP_FRAME_GRO *XskGro = RTL_PTR_ADD(XskFrame, Xsk->Rx.GroExtensionOffset);
+            C_ASSERT(sizeof(*XskGro) == sizeof(*XdpGro));
+            ASSERT(Xsk->Rx.Xdp.GroExtension.Reserved != 0);
+            ASSERT(Xsk->Rx.GroExtensionOffset != 0);
+            RtlCopyVolatileMemory(XskGro, XdpGro, sizeof(*XskGro));
+        }
+    }
+}
+
+static
+FORCEINLINE
+BOOLEAN
+XskReceiveMultiBufferFrame(
+    _In_ XSK *Xsk,
+    _In_ XDP_FRAME *Frame,
+    _In_ UINT32 FragmentIndex,
+    _In_ UINT32 MetadataLength,
+    _In_ UINT32 RxAvailable,
+    _In_ UINT32 FillAvailable,
+    _Inout_ UINT32 *FillConsumed,
+    _Inout_ UINT32 *CompletionOffset
+    )
+{
+    const UINT32 ChunkCapacity = Xsk->Umem->Reg.ChunkSize - Xsk->Umem->Reg.Headroom;
+    XSK_FRAME_DESCRIPTOR *XskFrame = NULL;
+    XDP_BUFFER *Buffer;
+    UINT32 BufferCount = 1;
+    UINT32 BufferIndex = 0;
+    UINT32 BufferOffset = 0;
+    UINT64 FrameLength = 0;
+    UINT64 ChunkCount;
+
+    //
+    // Copy the frame into as many UMEM chunks as its data requires and produce
+    // a chain of RX descriptors, each but the last marked with
+    // XSK_BUFFER_DESCRIPTOR_FLAG_CONTINUED. Descriptor extensions are written
+    // to the first descriptor of the chain only.
+    //
+    ASSERT(ChunkCapacity > 0);
+
+    if (Xsk->Rx.Xdp.FragmentRing != NULL) {
+        BufferCount +=
+            XdpGetFragmentExtension(Frame, &Xsk->Rx.Xdp.FragmentExtension)->FragmentBufferCount;
+    }
+
+    for (UINT32 Index = 0; Index < BufferCount; Index++) {
+        FrameLength += XskReceiveGetFrameBuffer(Xsk, Frame, FragmentIndex, Index)->DataLength;
+    }
+
+    ChunkCount = max(1ui64, (FrameLength + ChunkCapacity - 1) / ChunkCapacity);
+
+    //
+    // A frame is delivered whole or not at all: drop it unless the entire
+    // chain fits within the remaining RX and fill descriptors.
+    //
+    if (ChunkCount > RxAvailable - *CompletionOffset ||
+        ChunkCount > FillAvailable - *FillConsumed) {
+        return FALSE;
+    }
+
+    for (UINT64 Chunk = 0; Chunk < ChunkCount; Chunk++) {
+        UINT64 UmemAddress;
+        UCHAR *UmemData;
+        UINT32 ChunkLength = 0;
+
+        if (!XskReceiveConsumeFill(Xsk, FillAvailable, FillConsumed, &UmemAddress)) {
+            if (XskFrame != NULL) {
+                //
+                // Invalid fill descriptors consumed the entries reserved for
+                // the rest of the frame, so the chain ends here.
+                //
+                Xsk->Statistics.RxTruncated++;
+                STAT_INC(XdpRxQueueGetStats(Xsk->Rx.Xdp.Queue), XskFramesTruncated);
+            }
+            break;
+        }
+
+        UmemData = Xsk->Umem->Mapping.SystemAddress + UmemAddress + Xsk->Umem->Reg.Headroom;
+
+        while (ChunkLength < ChunkCapacity && BufferIndex < BufferCount) {
+            UINT32 CopyLength;
+
+            Buffer = XskReceiveGetFrameBuffer(Xsk, Frame, FragmentIndex, BufferIndex);
+            CopyLength = min(Buffer->DataLength - BufferOffset, ChunkCapacity - ChunkLength);
+
+            if (!XskGlobals.RxZeroCopy) {
+                XDP_BUFFER_VIRTUAL_ADDRESS *Va =
+                    XdpGetVirtualAddressExtension(Buffer, &Xsk->Rx.Xdp.VaExtension);
+
+                RtlCopyVolatileMemory(
+                    UmemData + ChunkLength, Va->VirtualAddress + Buffer->DataOffset + BufferOffset,
+                    CopyLength);
+            }
+
+            ChunkLength += CopyLength;
+            BufferOffset += CopyLength;
+
+            if (BufferOffset == Buffer->DataLength) {
+                BufferIndex++;
+                BufferOffset = 0;
+            }
+        }
+
+        if (XskFrame != NULL) {
+            WriteUInt32NoFence(&XskFrame->Buffer.Flags, XSK_BUFFER_DESCRIPTOR_FLAG_CONTINUED);
+        }
+
+        XskFrame =
+            XskReceiveProduceDescriptor(
+                Xsk, *CompletionOffset, UmemAddress, Xsk->Umem->Reg.Headroom, ChunkLength);
+
+        if (Chunk == 0) {
+            XskReceiveCopyMetadata(Xsk, Frame, MetadataLength, UmemAddress);
+            XskReceiveCopyExtensions(Xsk, Frame, XskFrame);
+        }
+
+        ++*CompletionOffset;
+    }
+
+    return XskFrame != NULL;
+}
+
+static
+FORCEINLINE
+BOOLEAN
+XskReceiveIsUnexpectedCoalescedFrame(
+    _In_ XSK *Xsk,
+    _In_ XDP_FRAME *Frame
+    )
+{
+    //
+    // Sockets that have not enabled the GRO offload cannot split coalesced
+    // frames into datagrams, and the frames may exceed their chunk size, so
+    // coalesced frames are dropped rather than delivered to them.
+    //
+    return
+        !Xsk->Rx.ExtensionFlags.Gro && Xsk->Rx.Xdp.GroExtension.Reserved != 0 &&
+        XdpGetGroExtension(Frame, &Xsk->Rx.Xdp.GroExtension)->UDP.MessageSize != 0;
+}
+
+static
+FORCEINLINE
+BOOLEAN
+XskReceiveSingleFrame(
+    _In_ XSK *Xsk,
+    _In_ UINT32 FrameIndex,
+    _In_ UINT32 FragmentIndex,
+    _In_ UINT32 MetadataLength,
+    _In_ UINT32 RxAvailable,
+    _In_ UINT32 FillAvailable,
+    _Inout_ UINT32 *FillConsumed,
+    _Inout_ UINT32 *CompletionOffset
+    )
+{
+    XDP_FRAME *Frame = XdpRingGetElement(Xsk->Rx.Xdp.FrameRing, FrameIndex);
+    XDP_BUFFER *Buffer = &Frame->Buffer;
+    XDP_BUFFER_VIRTUAL_ADDRESS *Va = XdpGetVirtualAddressExtension(Buffer, &Xsk->Rx.Xdp.VaExtension);
+    XSK_FRAME_DESCRIPTOR *XskFrame;
+    UINT64 UmemAddress;
+    UINT32 DataOffset;
+    UINT32 DataLength;
+
+    if (XskReceiveIsUnexpectedCoalescedFrame(Xsk, Frame)) {
+        return FALSE;
+    }
+
+    if (XskReceiveIsZeroCopyFrame(Xsk, Frame, Va, &UmemAddress)) {
+        //
+        // The frame was received directly into a UMEM chunk this socket posted
+        // from its fill ring. Take the buffer back from the interface and
+        // deliver it in place, along with any metadata preceding the data.
+        //
+        XdpGetRxActionExtension(Frame, &Xsk->Rx.Xdp.RxActionExtension)->RxAction =
+            XDP_RX_ACTION_CONSUMED;
+        DataOffset = Xsk->Umem->Reg.Headroom + Buffer->DataOffset;
+        DataLength = Buffer->DataLength;
+    } else if (Xsk->Rx.Flags.MultiBuffer) {
+        return
+            XskReceiveMultiBufferFrame(
+                Xsk, Frame, FragmentIndex, MetadataLength, RxAvailable, FillAvailable,
+                FillConsumed, CompletionOffset);
+    } else {
+        if (!XskReceiveConsumeFill(Xsk, FillAvailable, FillConsumed, &UmemAddress)) {
+            //
+            // No fill descriptors remain, so the frame is dropped.
+            //
+            return FALSE;
+        }
+
+        DataOffset = Xsk->Umem->Reg.Headroom;
+        DataLength = XskReceiveCopyFrame(Xsk, Frame, FragmentIndex, UmemAddress);
+        XskReceiveCopyMetadata(Xsk, Frame, MetadataLength, UmemAddress);
     }
 
+    XskFrame =
+        XskReceiveProduceDescriptor(Xsk, *CompletionOffset, UmemAddress, DataOffset, DataLength);
+    XskReceiveCopyExtensions(Xsk, Frame, XskFrame);
+
     ++*CompletionOffset;
+
+    return TRUE;
 }
 
 static
@@ -5883,15 +8136,16 @@ VOID
 XskReceiveSubmitBatch(
     _In_ XSK *Xsk,
     _In_ UINT32 BatchCount,
+    _In_ UINT32 FramesDelivered,
     _In_ UINT32 RxFillConsumed,
     _In_ UINT32 RxProduced
     )
 {
-    if (RxProduced < BatchCount) {
+    if (FramesDelivered < BatchCount) {
         //
         // Dropped packets.
         //
-        UINT32 Dropped = BatchCount - RxProduced;
+        UINT32 Dropped = BatchCount - FramesDelivered;
         Xsk->Statistics.RxDropped += Dropped;
         STAT_ADD(XdpRxQueueGetStats(Xsk->Rx.Xdp.Queue), XskFramesDropped, Dropped);
     }
@@ -5906,20 +8160,40 @@ XskReceiveSubmitBatch(
         EventWriteXskRxPostBatch(
             &MICROSOFT_XDP_PROVIDER, Xsk,
             Xsk->Rx.Ring.Shared->ProducerIndex - RxProduced, RxProduced);
-        STAT_ADD(XdpRxQueueGetStats(Xsk->Rx.Xdp.Queue), XskFramesDelivered, RxProduced);
+        STAT_ADD(XdpRxQueueGetStats(Xsk->Rx.Xdp.Queue), XskFramesDelivered, FramesDelivered);
 
         //
         // N.B. See comment in XskNotify.
         //
         XdpBarrierBetweenReleaseAndAcquire();
 
-        if ((ReadUInt32Acquire(&Xsk->IoWaitFlags) & XSK_NOTIFY_FLAG_WAIT_RX) &&
-            (KeReadStateEvent(&Xsk->IoWaitEvent) == 0 || Xsk->IoWaitIrp != NULL)) {
+        if (XskHasReadyIoWaiter(Xsk, XSK_NOTIFY_FLAG_WAIT_RX)) {
             XskSignalReadyIo(Xsk, XSK_NOTIFY_FLAG_WAIT_RX);
         }
+
+        if (ReadBooleanNoFence(&Xsk->AdaptivePoll.Idle)) {
+            XskQueueAdaptivePollResume(Xsk);
+        }
     }
 }
 
+static
+FORCEINLINE
+UINT32
+XskReceiveReserve(
+    _In_ XSK *Xsk,
+    _In_ UINT32 FrameCount
+    )
+{
+    //
+    // In multi-buffer mode a frame may span any number of RX descriptors, so
+    // every free descriptor is reserved.
+    //
+    return
+        XskRingProdReserve(
+            &Xsk->Rx.Ring, Xsk->Rx.Flags.MultiBuffer ? Xsk->Rx.Ring.Size : FrameCount);
+}
+
 VOID
 XskReceive(
     _In_ XDP_REDIRECT_BATCH *Batch
@@ -5927,22 +8201,32 @@ XskReceive(
 {
     XSK *Xsk = Batch->Target;
     UINT32 ReservedCount;
+    UINT32 FillAvailable;
+    UINT32 FillConsumed = 0;
+    UINT32 FramesDelivered = 0;
     UINT32 RxCount = 0;
 
     if (!Xsk->Rx.Xdp.Flags.DatapathAttached || Xsk->Rx.Xdp.Queue != Batch->RxQueue) {
         goto Exit;
     }
 
-    ReservedCount = XskRingProdReserve(&Xsk->Rx.Ring, Batch->Count);
-    ReservedCount = XskRingConsPeek(&Xsk->Rx.FillRing, ReservedCount);
+    //
+    // Frames received into buffers posted by this socket do not consume fill
+    // descriptors, so every frame is attempted while RX descriptors remain.
+    //
+    ReservedCount = XskReceiveReserve(Xsk, Batch->Count);
+    FillAvailable = XskRingConsPeek(&Xsk->Rx.FillRing, ReservedCount);
 
-    for (UINT32 FillIndex = 0; FillIndex < ReservedCount; FillIndex++) {
-        XskReceiveSingleFrame(
-            Xsk, Batch->FrameIndexes[RxCount].FrameIndex,
-            Batch->FrameIndexes[RxCount].FragmentIndex, FillIndex, &RxCount);
+    for (UINT32 Index = 0; Index < Batch->Count && RxCount < ReservedCount; Index++) {
+        FramesDelivered +=
+            XskReceiveSingleFrame(
+                Xsk, Batch->FrameIndexes[Index].FrameIndex,
+                Batch->FrameIndexes[Index].FragmentIndex,
+                Batch->FrameIndexes[Index].MetadataLength, ReservedCount, FillAvailable,
+                &FillConsumed, &RxCount);
     }
 
-    XskReceiveSubmitBatch(Xsk, Batch->Count, ReservedCount, RxCount);
+    XskReceiveSubmitBatch(Xsk, Batch->Count, FramesDelivered, FillConsumed, RxCount);
 
 Exit:
     return;
@@ -5958,6 +8242,9 @@ XskReceiveBatchedExclusive(
     XDP_RING *FragmentRing = Xsk->Rx.Xdp.FragmentRing;
     UINT32 BatchCount;
     UINT32 ReservedCount;
+    UINT32 FillAvailable;
+    UINT32 FillConsumed = 0;
+    UINT32 FramesDelivered = 0;
     UINT32 RxCount = 0;
 
     if (!Xsk->Rx.Xdp.Flags.DatapathAttached) {
@@ -5966,8 +8253,8 @@ XskReceiveBatchedExclusive(
 
     BatchCount = FrameRing->ProducerIndex - FrameRing->ConsumerIndex;
 
-    ReservedCount = XskRingProdReserve(&Xsk->Rx.Ring, BatchCount);
-    ReservedCount = XskRingConsPeek(&Xsk->Rx.FillRing, ReservedCount);
+    ReservedCount = XskReceiveReserve(Xsk, BatchCount);
+    FillAvailable = XskRingConsPeek(&Xsk->Rx.FillRing, ReservedCount);
 
     for (UINT32 Index = 0; Index < BatchCount; Index++) {
         UINT32 FrameIndex = FrameRing->ConsumerIndex & FrameRing->Mask;
@@ -5985,8 +8272,11 @@ XskReceiveBatchedExclusive(
             FragmentIndex = FragmentRing->ConsumerIndex;
         }
 
-        if (Index < ReservedCount) {
-            XskReceiveSingleFrame(Xsk, FrameIndex, FragmentIndex, Index, &RxCount);
+        if (RxCount < ReservedCount) {
+            FramesDelivered +=
+                XskReceiveSingleFrame(
+                    Xsk, FrameIndex, FragmentIndex, 0, ReservedCount, FillAvailable,
+                    &FillConsumed, &RxCount);
         }
 
         FrameRing->ConsumerIndex++;
@@ -5997,11 +8287,100 @@ XskReceiveBatchedExclusive(
         }
     }
 
-    XskReceiveSubmitBatch(Xsk, BatchCount, ReservedCount, RxCount);
+    XskReceiveSubmitBatch(Xsk, BatchCount, FramesDelivered, FillConsumed, RxCount);
 
     return TRUE;
 }
 
+static
+BOOLEAN
+XskRxOverlapsPostedChunk(
+    _In_ const XSK *Xsk,
+    _In_ UINT64 UmemAddress
+    )
+{
+    const UINT64 ChunkSize = Xsk->Umem->Reg.ChunkSize;
+    const UINT32 Slot = (UINT32)(UmemAddress / ChunkSize);
+
+    //
+    // A chunk-sized buffer can only overlap buffers posted in its own slot or
+    // the adjacent slots.
+    //
+    for (UINT32 Index = (Slot > 0) ? Slot - 1 : Slot;
+        Index <= Slot + 1 && Index < Xsk->Rx.PostedChunkCount; Index++) {
+        UINT64 Posted = Xsk->Rx.PostedChunks[Index];
+
+        if (Posted != 0 && Posted - 1 < UmemAddress + ChunkSize &&
+            UmemAddress < Posted - 1 + ChunkSize) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+XskProvideRxBuffers(
+    _In_ VOID *Target,
+    _Inout_ XDP_RING *BufferRing
+    )
+{
+    XSK *Xsk = Target;
+    UINT32 FillAvailable;
+
+    if (!Xsk->Rx.Xdp.Flags.DatapathAttached) {
+        return;
+    }
+
+    //
+    // Post UMEM chunks from the fill ring to the interface. Ownership of each
+    // chunk passes to the interface until a frame received into it is
+    // delivered to the RX ring.
+    //
+    FillAvailable = XskRingConsPeek(&Xsk->Rx.FillRing, XdpRingFree(BufferRing));
+
+    for (UINT32 Index = 0; Index < FillAvailable; Index++) {
+        UINT32 RingIndex;
+        UINT64 UmemAddress;
+        XDP_RX_PROVIDED_BUFFER *Buffer;
+
+        RingIndex =
+            (ReadUInt32NoFence(&Xsk->Rx.FillRing.Shared->ConsumerIndex) + Index) &
+                Xsk->Rx.FillRing.Mask;
+        UmemAddress = *(UINT64 *)XskKernelRingGetElement(&Xsk->Rx.FillRing, RingIndex);
+
+        if (UmemAddress > Xsk->Umem->Reg.TotalSize - Xsk->Umem->Reg.ChunkSize) {
+            //
+            // Invalid FILL descriptor.
+            //
+            Xsk->Statistics.RxInvalidDescriptors++;
+            STAT_INC(XdpRxQueueGetStats(Xsk->Rx.Xdp.Queue), XskInvalidDescriptors);
+            continue;
+        }
+
+        if (XskRxOverlapsPostedChunk(Xsk, UmemAddress)) {
+            //
+            // The FILL descriptor overlaps a chunk already owned by the
+            // interface.
+            //
+            Xsk->Statistics.RxInvalidDescriptors++;
+            STAT_INC(XdpRxQueueGetStats(Xsk->Rx.Xdp.Queue), XskInvalidDescriptors);
+            continue;
+        }
+        Xsk->Rx.PostedChunks[UmemAddress / Xsk->Umem->Reg.ChunkSize] = UmemAddress + 1;
+
+        Buffer = XdpRingGetElement(BufferRing, BufferRing->ProducerIndex++ & BufferRing->Mask);
+        Buffer->VirtualAddress =
+            Xsk->Umem->Mapping.SystemAddress + UmemAddress + Xsk->Umem->Reg.Headroom;
+        Buffer->BufferLength = Xsk->Umem->Reg.ChunkSize - Xsk->Umem->Reg.Headroom;
+    }
+
+    if (FillAvailable > 0) {
+        XskRingConsRelease(&Xsk->Rx.FillRing, FillAvailable);
+    }
+}
+
 _Use_decl_annotations_
 NTSTATUS
 XskIrpDeviceIoControl(
@@ -15,6 +15,18 @@ XskReceiveBatchedExclusive(
     _In_ VOID *Target
     );
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+XskProvideRxBuffers(
+    _In_ VOID *Target,
+    _Inout_ XDP_RING *BufferRing
+    );
+
+VOID
+XskDereferenceRxBufferProvider(
+    _In_ VOID *Target
+    );
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 VOID
 XskFillTxCompletion(
@@ -65,6 +77,19 @@ XskFastIo(
     _Out_ IO_STATUS_BLOCK *IoStatus
     );
 
+XDP_FILE_CREATE_ROUTINE XskIrpCreateNotifySet;
+
+BOOLEAN
+XskNotifySetFastIo(
+    _In_ XDP_FILE_OBJECT_HEADER *FileObjectHeader,
+    _In_opt_ VOID *InputBuffer,
+    _In_ ULONG InputBufferLength,
+    _Out_opt_ VOID *OutputBuffer,
+    _In_ ULONG OutputBufferLength,
+    _In_ ULONG IoControlCode,
+    _Out_ IO_STATUS_BLOCK *IoStatus
+    );
+
 NTSTATUS
 XskStart(
     VOID
@@ -4,10 +4,16 @@
 //
 
 //
-// XSKMAP-specific implementation. Object lifetime, IRP / IOCTL dispatch, and
-// the global map read/write lock are all owned by the common XDP map code in
-// map.c; this file only provides the XSKMAP entry storage and the per-type
-// callbacks that map.c invokes.
+// XSKMAP-specific implementation. Object lifetime and IRP / IOCTL dispatch are
+// owned by the common XDP map code in map.c; this file only provides the XSKMAP
+// entry storage and the per-type callbacks that map.c invokes.
+//
+// Unlike other map types, XSKMAP entries are not protected by the global map
+// lock. Each entry is published with an atomic exchange and looked up with a
+// plain acquire load, so the data path never contends with other processors.
+// Readers remain at DISPATCH_LEVEL for the duration of each receive batch, and
+// the reference held by a replaced or deleted entry is released only after the
+// lifetime module has swept every processor (see xdplifetime.h).
 //
 
 #include "precomp.h"
@@ -19,21 +25,74 @@
 //
 #define XSKMAP_MAX_SIZE 128
 
+C_ASSERT(XDP_REDIRECT_MAX_FLOW_HASH_WIDTH <= XSKMAP_MAX_SIZE);
+
 typedef struct _XDP_XSKMAP {
     XDP_MAP Map;
 
     //
     // Fixed-size array of XSK handles (kernel pointers to XSK objects).
-    // NULL indicates an empty slot. Protected by the global map lock.
+    // NULL indicates an empty slot. Entries are published via atomic exchange
+    // and read locklessly by the data path.
     //
     VOID *Entries[XSKMAP_MAX_SIZE];
 } XDP_XSKMAP;
 
+//
+// An entry removed from the map, waiting for all data path readers to quiesce
+// before the XSK reference is released.
+//
+typedef struct _XDP_XSKMAP_RETIRED_ENTRY {
+    XDP_LIFETIME_ENTRY DeleteEntry;
+    VOID *XskKernelHandle;
+} XDP_XSKMAP_RETIRED_ENTRY;
+
 const SIZE_T XdpXskMapAllocationSize = sizeof(XDP_XSKMAP);
 
 static XDP_MAP_CLEANUP XdpXskMapCleanup;
 static XDP_MAP_INSERT XdpXskMapInsert;
 static XDP_MAP_DELETE XdpXskMapDelete;
+static XDP_LIFETIME_DELETE XdpXskMapRetiredEntryDelete;
+
+static
+_IRQL_requires_(PASSIVE_LEVEL)
+VOID
+XdpXskMapRetiredEntryDelete(
+    _In_ XDP_LIFETIME_ENTRY *Entry
+    )
+{
+    XDP_XSKMAP_RETIRED_ENTRY *Retired =
+        CONTAINING_RECORD(Entry, XDP_XSKMAP_RETIRED_ENTRY, DeleteEntry);
+
+    XskDereferenceDatapathHandle(Retired->XskKernelHandle);
+    ExFreePoolWithTag(Retired, XDP_POOLTAG_MAP);
+}
+
+//
+// Atomically replaces the entry at Key and defers the release of the previous
+// entry's reference until no data path reader can still observe it. The
+// caller provides the retirement record so that publication cannot fail.
+//
+static
+VOID
+XdpXskMapExchange(
+    _In_ XDP_XSKMAP *XskMap,
+    _In_ UINT32 Key,
+    _In_opt_ VOID *XskKernelHandle,
+    _In_ XDP_XSKMAP_RETIRED_ENTRY *Retired
+    )
+{
+    VOID *OldEntry;
+
+    OldEntry = InterlockedExchangePointer(&XskMap->Entries[Key], XskKernelHandle);
+
+    if (OldEntry != NULL) {
+        Retired->XskKernelHandle = OldEntry;
+        XdpLifetimeDelete(XdpXskMapRetiredEntryDelete, &Retired->DeleteEntry);
+    } else {
+        ExFreePoolWithTag(Retired, XDP_POOLTAG_MAP);
+    }
+}
 
 static
 VOID
@@ -43,6 +102,10 @@ XdpXskMapCleanup(
 {
     XDP_XSKMAP *XskMap = CONTAINING_RECORD(Map, XDP_XSKMAP, Map);
 
+    //
+    // The map is being freed, so no program can still reference it, and any
+    // data path reader has already quiesced.
+    //
     for (UINT32 i = 0; i < XSKMAP_MAX_SIZE; i++) {
         if (XskMap->Entries[i] != NULL) {
             XskDereferenceDatapathHandle(XskMap->Entries[i]);
@@ -63,8 +126,7 @@ XdpXskMapInsert(
     XDP_XSKMAP *XskMap = CONTAINING_RECORD(Map, XDP_XSKMAP, Map);
     UINT32 KeyValue;
     HANDLE XskKernelHandle = NULL;
-    VOID *OldEntry;
-    LOCK_STATE_EX LockState;
+    XDP_XSKMAP_RETIRED_ENTRY *Retired;
     NTSTATUS Status;
 
     Status = XdpMapReadUInt32FromMode(RequestorMode, Key, &KeyValue);
@@ -88,25 +150,25 @@ XdpXskMapInsert(
         goto Exit;
     }
 
-    //
-    // Insert the entry into the map, replacing any existing entry.
-    //
-    XdpMapAcquireWrite(&LockState);
-    OldEntry = XskMap->Entries[KeyValue];
-    XskMap->Entries[KeyValue] = XskKernelHandle;
-    XdpMapReleaseWrite(&LockState);
+    Retired = ExAllocatePoolZero(NonPagedPoolNx, sizeof(*Retired), XDP_POOLTAG_MAP);
+    if (Retired == NULL) {
+        Status = STATUS_NO_MEMORY;
+        goto Exit;
+    }
 
     //
-    // Release the old entry's reference, if any.
+    // Insert the entry into the map, replacing any existing entry.
     //
-    if (OldEntry != NULL) {
-        XskDereferenceDatapathHandle(OldEntry);
-    }
-
+    XdpXskMapExchange(XskMap, KeyValue, XskKernelHandle, Retired);
+    XskKernelHandle = NULL;
     Status = STATUS_SUCCESS;
 
 Exit:
 
+    if (XskKernelHandle != NULL) {
+        XskDereferenceDatapathHandle(XskKernelHandle);
+    }
+
     return Status;
 }
 
@@ -120,8 +182,7 @@ XdpXskMapDelete(
 {
     XDP_XSKMAP *XskMap = CONTAINING_RECORD(Map, XDP_XSKMAP, Map);
     UINT32 KeyValue;
-    VOID *OldEntry;
-    LOCK_STATE_EX LockState;
+    XDP_XSKMAP_RETIRED_ENTRY *Retired;
     NTSTATUS Status;
 
     Status = XdpMapReadUInt32FromMode(RequestorMode, Key, &KeyValue);
@@ -133,15 +194,13 @@ XdpXskMapDelete(
         return STATUS_INVALID_PARAMETER;
     }
 
-    XdpMapAcquireWrite(&LockState);
-    OldEntry = XskMap->Entries[KeyValue];
-    XskMap->Entries[KeyValue] = NULL;
-    XdpMapReleaseWrite(&LockState);
-
-    if (OldEntry != NULL) {
-        XskDereferenceDatapathHandle(OldEntry);
+    Retired = ExAllocatePoolZero(NonPagedPoolNx, sizeof(*Retired), XDP_POOLTAG_MAP);
+    if (Retired == NULL) {
+        return STATUS_NO_MEMORY;
     }
 
+    XdpXskMapExchange(XskMap, KeyValue, NULL, Retired);
+
     return STATUS_SUCCESS;
 }
 
@@ -169,7 +228,8 @@ XdpXskMapLookup(
     XskMap = CONTAINING_RECORD(Map, XDP_XSKMAP, Map);
 
     //
-    // Caller must hold the global map read lock.
+    // Pairs with the exchange in XdpXskMapExchange: the XSK referenced by the
+    // entry remains valid until the caller lowers IRQL below DISPATCH_LEVEL.
     //
-    return XskMap->Entries[Key];
+    return ReadPointerAcquire(&XskMap->Entries[Key]);
 }
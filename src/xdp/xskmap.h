@@ -22,9 +22,9 @@ extern const SIZE_T XdpXskMapAllocationSize;
 extern const XDP_MAP_TYPE_DISPATCH XdpXskMapTypeDispatch;
 
 //
-// Look up the XSK kernel handle stored at Key. Caller must hold the global
-// map read lock (see XdpMapAcquireRead). Returns NULL if no entry exists or
-// if Key is out of range.
+// Look up the XSK kernel handle stored at Key. The lookup is lock-free; the
+// returned handle remains valid while the caller stays at DISPATCH_LEVEL.
+// Returns NULL if no entry exists or if Key is out of range.
 //
 _IRQL_requires_(DISPATCH_LEVEL)
 VOID *
@@ -711,8 +711,10 @@ XdpGenericAttachInterface(
     Generic->Capabilities.CapabilitiesEx.RxChecksumSupported = TRUE;
     Generic->Capabilities.CapabilitiesEx.RxTimestampSupported = TRUE;
     Generic->Capabilities.CapabilitiesEx.TxTimestampSupported = TRUE;
+    Generic->Capabilities.CapabilitiesEx.RxGroSupported = TRUE;
+    Generic->Capabilities.CapabilitiesEx.RxFrameBoundsAdjustmentSupported = TRUE;
     Generic->Capabilities.CapabilitiesEx.Header.Size =
-        RTL_SIZEOF_THROUGH_FIELD(XDP_CAPABILITIES_EX, TxTimestampSupported);
+        RTL_SIZEOF_THROUGH_FIELD(XDP_CAPABILITIES_EX, RxFrameBoundsAdjustmentSupported);
 
     Status =
         XdpRegisterInterface(
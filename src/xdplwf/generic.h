@@ -13,6 +13,15 @@
 
 #define GENERIC_DATAPATH_RESTART_TIMEOUT_MS 1000
 
+//
+// Declares an MDL followed by storage for enough PFNs to describe a buffer of
+// the given size at any page offset.
+//
+#define DEFINE_MDL_AND_PFNS(_Name, _Size) \
+    MDL _Name; PFN_NUMBER _Name##Pfns[ADDRESS_AND_SIZE_TO_SPAN_PAGES(PAGE_SIZE - 1, (_Size))]
+C_ASSERT(__alignof(MDL) % __alignof(PFN_NUMBER) == 0);
+C_ASSERT(sizeof(MDL) % __alignof(PFN_NUMBER) == 0);
+
 // TODO: break circular dependency Filter->Generic->Filter.
 //       Add an interface context when creating an XDP binding?
 //       Or just make this opaque context?
@@ -22,6 +22,10 @@ typedef struct _XDP_LWF_OFFLOAD_SETTING_TASK_OFFLOAD {
         UINT32 MaxOffloadSize;
         UINT32 MinSegments;
     } Lso;
+    struct {
+        UINT32 MaxOffloadSize;
+        UINT32 MinSegments;
+    } Uso;
     XDP_LIFETIME_ENTRY DeleteEntry;
 } XDP_LWF_OFFLOAD_SETTING_TASK_OFFLOAD;
 
@@ -279,13 +279,35 @@ XdpOffloadUpdateTaskOffloadConfig(
     //
     NewOffload->Lso.MinSegments = max(1, NewOffload->Lso.MinSegments);
 
+    //
+    // Likewise for USO, require UDPv4 and UDPv6 and support for a final
+    // segment shorter than the MSS.
+    //
+    if (TaskOffload->Header.Revision >= NDIS_OFFLOAD_REVISION_6 &&
+        RTL_CONTAINS_FIELD(TaskOffload, TaskOffload->Header.Size, UdpSegmentation) &&
+        ((TaskOffload->UdpSegmentation.IPv4.Encapsulation & Encapsulation) == Encapsulation) &&
+        ((TaskOffload->UdpSegmentation.IPv6.Encapsulation & Encapsulation) == Encapsulation) &&
+        TaskOffload->UdpSegmentation.IPv4.SubMssFinalSegmentSupported &&
+        TaskOffload->UdpSegmentation.IPv6.SubMssFinalSegmentSupported) {
+        NewOffload->Uso.MaxOffloadSize =
+            min(TaskOffload->UdpSegmentation.IPv4.MaxOffLoadSize,
+                TaskOffload->UdpSegmentation.IPv6.MaxOffLoadSize);
+        NewOffload->Uso.MinSegments =
+            max(TaskOffload->UdpSegmentation.IPv4.MinSegmentCount,
+                TaskOffload->UdpSegmentation.IPv6.MinSegmentCount);
+    }
+
+    NewOffload->Uso.MinSegments = max(1, NewOffload->Uso.MinSegments);
+
     TraceInfo(
         TRACE_LWF,
         "Filter=%p updated task offload. "
         "Checksum.Enabled=%!BOOLEAN! Checksum.TcpOptions=%!BOOLEAN!"
-        "Lso.MaxOffloadSize=%u Lso.MinSegments=%u",
+        "Lso.MaxOffloadSize=%u Lso.MinSegments=%u "
+        "Uso.MaxOffloadSize=%u Uso.MinSegments=%u",
         Filter, NewOffload->Checksum.Enabled, NewOffload->Checksum.TcpOptions,
-        NewOffload->Lso.MaxOffloadSize, NewOffload->Lso.MinSegments);
+        NewOffload->Lso.MaxOffloadSize, NewOffload->Lso.MinSegments,
+        NewOffload->Uso.MaxOffloadSize, NewOffload->Uso.MinSegments);
 
     OldOffload = Filter->Offload.LowerEdge.TaskOffload;
     Filter->Offload.LowerEdge.TaskOffload = NewOffload;
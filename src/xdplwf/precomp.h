@@ -33,6 +33,8 @@
 #include <xdp/framechecksumextension.h>
 #include <xdp/frametimestampextension.h>
 #include <xdp/framefragment.h>
+#include <xdp/framegroextension.h>
+#include <xdp/framegsoextension.h>
 #include <xdp/frameinterfacecontext.h>
 #include <xdp/framelayout.h>
 #include <xdp/framelayoutextension.h>
@@ -53,6 +55,7 @@
 #include <xdprxqueue_internal.h>
 #include <xdpstatusconvert.h>
 #include <xdptimer.h>
+#include <xdptoeplitz.h>
 #include <xdptransport.h>
 #include <xdptxqueue_internal.h>
 #include <xdptrace.h>
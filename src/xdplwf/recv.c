@@ -12,6 +12,11 @@
 #define RECV_MAX_MAX_TX_BUFFERS 65536
 #define RECV_MAX_GSO_HEADER_SIZE (sizeof(ETHERNET_HEADER) + sizeof(IPV6_HEADER) + TH_MAX_LEN)
 #define RECV_MAX_GSO_PAYLOAD_SIZE MAXUINT16
+#define RECV_IPV4_FRAGMENT_MASK CONST_HTONS(0x3FFF)
+#define RECV_GRO_MAX_HEADER_LENGTH (sizeof(ETHERNET_HEADER) + sizeof(IPV6_HEADER) + sizeof(UDP_HDR))
+#define RECV_LINEARIZE_BUFFER_SIZE 0x10000
+#define RECV_LINEARIZE_BUFFER_DATA_SIZE \
+    (RECV_LINEARIZE_BUFFER_SIZE - FIELD_OFFSET(XDP_LWF_GENERIC_RX_LINEARIZE_BUFFER, Data))
 
 //
 // Rather than tracking the current lookaside via OIDs, which is subject to
@@ -23,15 +28,44 @@
 //
 #define RECV_TX_INSPECT_LOOKAHEAD (sizeof(ETHERNET_HEADER) + (0xF * sizeof(UINT32)))
 
-#define DEFINE_MDL_AND_PFNS(_Name, _Size) \
-    MDL _Name; PFN_NUMBER _Name##Pfns[ADDRESS_AND_SIZE_TO_SPAN_PAGES(PAGE_SIZE - 1, (_Size))]
-C_ASSERT(__alignof(MDL) % __alignof(PFN_NUMBER) == 0);
-C_ASSERT(sizeof(MDL) % __alignof(PFN_NUMBER) == 0);
-
 typedef struct _XDP_LWF_GENERIC_RX_FRAME_CONTEXT {
     NET_BUFFER *Nb;
+
+    //
+    // The number of consecutive NBs, starting with Nb, described by the frame.
+    // This exceeds one only for frames built by receive coalescing.
+    //
+    UINT32 NbCount;
+
+    //
+    // The data bounds of the frame's first buffer prior to inspection. Any
+    // head or tail adjustments made during inspection are applied to Nb.
+    //
+    UINT32 DataOffset;
+    UINT32 DataLength;
+
+    //
+    // For coalesced frames, a copy of the first datagram's headers prior to
+    // inspection. The remaining datagrams retain their original headers, so
+    // the frame is dropped if inspection rewrites these.
+    //
+    UINT32 GroHeaderLength;
+    UCHAR GroHeaders[RECV_GRO_MAX_HEADER_LENGTH];
 } XDP_LWF_GENERIC_RX_FRAME_CONTEXT;
 
+//
+// Tracks the most recent frame added to the XDP ring while it remains eligible
+// for UDP receive coalescing.
+//
+typedef struct _XDP_LWF_GENERIC_RX_GRO {
+    XDP_FRAME *Frame;
+    const UCHAR *Headers;
+    ULONG_PTR ChecksumInfo;
+    UINT32 HeaderLength;
+    UINT32 FrameLength;
+    UINT16 MessageSize;
+} XDP_LWF_GENERIC_RX_GRO;
+
 typedef struct _NBL_RX_TX_CONTEXT {
     XDP_LWF_GENERIC_RX_QUEUE *RxQueue;
     XDP_LWF_GENERIC_INJECTION_TYPE InjectionType;
@@ -176,6 +210,50 @@ XdpGenericReturnNetBufferLists(
     }
 }
 
+static
+VOID
+XdpGenericReceiveFreeLinearizeBuffers(
+    _Inout_ SINGLE_LIST_ENTRY *List
+    )
+{
+    while (List->Next != NULL) {
+        XDP_LWF_GENERIC_RX_LINEARIZE_BUFFER *LinearizeBuffer =
+            CONTAINING_RECORD(
+                PopEntryList(List), XDP_LWF_GENERIC_RX_LINEARIZE_BUFFER, Link);
+
+        ExFreePoolWithTag(LinearizeBuffer, POOLTAG_RECV);
+    }
+}
+
+static
+VOID
+XdpGenericReceiveRecycleLinearizeBuffers(
+    _Inout_ XDP_LWF_GENERIC_RX_QUEUE *RxQueue
+    )
+{
+    //
+    // Return pool-sized buffers to the free list, up to the pool limit. The
+    // limit is the frame ring size, which bounds the number of frames
+    // linearized between flushes, so a steady stream of discontiguous frames
+    // is served from the pool. The data path is serialized by the EC, so no
+    // synchronization is needed.
+    //
+    while (RxQueue->LinearizeInUseList.Next != NULL) {
+        XDP_LWF_GENERIC_RX_LINEARIZE_BUFFER *LinearizeBuffer =
+            CONTAINING_RECORD(
+                PopEntryList(&RxQueue->LinearizeInUseList),
+                XDP_LWF_GENERIC_RX_LINEARIZE_BUFFER, Link);
+
+        if (LinearizeBuffer->AllocationSize == RECV_LINEARIZE_BUFFER_SIZE &&
+            RxQueue->LinearizeFreeCount < RxQueue->LinearizePoolLimit) {
+            PushEntryList(&RxQueue->LinearizeFreeList, &LinearizeBuffer->Link);
+            RxQueue->LinearizeFreeCount++;
+        } else {
+            ExFreePoolWithTag(LinearizeBuffer, POOLTAG_RECV);
+        }
+    }
+}
+
 static
 VOID
 XdpGenericFlushReceive(
@@ -184,7 +262,7 @@ XdpGenericFlushReceive(
     )
 {
     XdpFlushReceive(XdpRxQueue);
-    RxQueue->FragmentBufferInUse = FALSE;
+    XdpGenericReceiveRecycleLinearizeBuffers(RxQueue);
 }
 
 static
@@ -275,12 +353,43 @@ XdpGenericReceiveLowResources(
     NdisAppendNblQueueToNblQueueFast(LowResourcesList, ReturnList);
 }
 
+_IRQL_requires_(DISPATCH_LEVEL)
+static
+NET_BUFFER_LIST *
+XdpGenericReceiveSplitRssChain(
+    _In_ XDP_LWF_GENERIC *Generic,
+    _In_ ULONG CurrentProcessor,
+    _In_ BOOLEAN TxInspect,
+    _In_ XDP_LWF_GENERIC_RSS_QUEUE *RssQueue,
+    _In_ NET_BUFFER_LIST *NetBufferLists
+    )
+{
+    NET_BUFFER_LIST *Nbl = NetBufferLists;
+    NET_BUFFER_LIST *NextNbl;
+
+    //
+    // Truncate the chain at the first NBL that maps to a different RSS queue,
+    // and return the remainder of the chain.
+    //
+    while ((NextNbl = Nbl->Next) != NULL) {
+        if (XdpGenericRssGetQueue(Generic, CurrentProcessor, TxInspect, NextNbl) != RssQueue) {
+            Nbl->Next = NULL;
+            return NextNbl;
+        }
+
+        Nbl = NextNbl;
+    }
+
+    return NULL;
+}
+
 _IRQL_requires_(DISPATCH_LEVEL)
 static
 VOID
 XdpGenericReceiveEnterEc(
     _In_ XDP_LWF_GENERIC *Generic,
     _Inout_ NET_BUFFER_LIST **NetBufferLists,
+    _Out_ NET_BUFFER_LIST **RemainingNetBufferLists,
     _In_ ULONG CurrentProcessor,
     _In_ BOOLEAN TxInspect,
     _In_ BOOLEAN TxWorker,
@@ -291,8 +400,8 @@ XdpGenericReceiveEnterEc(
     )
 {
     XDP_LWF_GENERIC_RX_QUEUE *CandidateRxQueue;
-    ULONG RssHash = NET_BUFFER_LIST_GET_HASH_VALUE(*NetBufferLists);
 
+    *RemainingNetBufferLists = NULL;
     *RssQueue = NULL;
     *RxQueue = NULL;
     *XdpRxQueue = NULL;
@@ -300,7 +409,7 @@ XdpGenericReceiveEnterEc(
     //
     // Find the target RSS queue based on the first NBL's RSS hash.
     //
-    *RssQueue = XdpGenericRssGetQueue(Generic, CurrentProcessor, TxInspect, RssHash);
+    *RssQueue = XdpGenericRssGetQueue(Generic, CurrentProcessor, TxInspect, *NetBufferLists);
     if (*RssQueue == NULL) {
         //
         // RSS is uninitialized, so pass the NBLs through. Note that the XDP
@@ -313,6 +422,17 @@ XdpGenericReceiveEnterEc(
         return;
     }
 
+    //
+    // Each NBL is steered by its own hash, so only the leading NBLs that map to
+    // the same RSS queue are processed in this EC. The TX inspect worker only
+    // processes NBLs that were already steered to its queue.
+    //
+    if (!TxWorker) {
+        *RemainingNetBufferLists =
+            XdpGenericReceiveSplitRssChain(
+                Generic, CurrentProcessor, TxInspect, *RssQueue, *NetBufferLists);
+    }
+
     *RxQueue = NULL;
 
     //
@@ -427,36 +547,50 @@ XdpGenericReceiveExitEc(
 }
 
 static
-BOOLEAN
-XdpGenericReceiveExpandFragmentBuffer(
-    _Inout_ XDP_LWF_GENERIC_RX_QUEUE *RxQueue
+XDP_LWF_GENERIC_RX_LINEARIZE_BUFFER *
+XdpGenericReceiveAllocateLinearizeBuffer(
+    _Inout_ XDP_LWF_GENERIC_RX_QUEUE *RxQueue,
+    _In_ UINT32 DataLength
     )
 {
-    UINT32 NewBufferSize;
-    UCHAR *NewBuffer;
+    XDP_LWF_GENERIC_RX_LINEARIZE_BUFFER *LinearizeBuffer;
+    UINT32 AllocationSize;
+
+    if (DataLength <= RECV_LINEARIZE_BUFFER_DATA_SIZE && RxQueue->LinearizeFreeList.Next != NULL) {
+        STAT_INC(&RxQueue->PcwStats, LinearizationPoolHits);
+        RxQueue->LinearizeFreeCount--;
+        return
+            CONTAINING_RECORD(
+                PopEntryList(&RxQueue->LinearizeFreeList),
+                XDP_LWF_GENERIC_RX_LINEARIZE_BUFFER, Link);
+    }
+
+    STAT_INC(&RxQueue->PcwStats, LinearizationPoolMisses);
 
     //
-    // Double the size of the fragment buffer, using 64KB as the base value.
-    // The size is all leading zero bits, followed by all ones, which limits
-    // the size to MAXUINT32.
+    // Allocate a pool-sized buffer so it can be recycled, unless the NB is
+    // too large, in which case the buffer is freed once inspected. The data
+    // path normally runs on the RSS processor, and nonpaged pool prefers the
+    // current processor's NUMA node, so pooled buffers are node-local.
     //
-    FRE_ASSERT(RxQueue->FragmentBufferSize < MAXUINT32);
-    NewBufferSize = (max(RxQueue->FragmentBufferSize, MAXUINT16) << 1) | 1;
-
-    NewBuffer =
-        ExAllocatePoolPriorityZero(NonPagedPoolNx, NewBufferSize, POOLTAG_RECV, LowPoolPriority);
-    if (NewBuffer == NULL) {
-        return FALSE;
+    if (DataLength <= RECV_LINEARIZE_BUFFER_DATA_SIZE) {
+        AllocationSize = RECV_LINEARIZE_BUFFER_SIZE;
+    } else if (!NT_SUCCESS(
+                RtlUInt32Add(
+                    DataLength, FIELD_OFFSET(XDP_LWF_GENERIC_RX_LINEARIZE_BUFFER, Data),
+                    &AllocationSize))) {
+        return NULL;
     }
 
-    if (RxQueue->FragmentBuffer != NULL) {
-        RtlCopyMemory(NewBuffer, RxQueue->FragmentBuffer, RxQueue->FragmentBufferSize);
-        ExFreePoolWithTag(RxQueue->FragmentBuffer, POOLTAG_RECV);
+    LinearizeBuffer =
+        ExAllocatePoolPriorityZero(
+            NonPagedPoolNxCacheAligned, AllocationSize, POOLTAG_RECV, LowPoolPriority);
+    if (LinearizeBuffer == NULL) {
+        return NULL;
     }
 
-    RxQueue->FragmentBuffer = NewBuffer;
-    RxQueue->FragmentBufferSize = NewBufferSize;
-    return TRUE;
+    LinearizeBuffer->AllocationSize = AllocationSize;
+    return LinearizeBuffer;
 }
 
 static
@@ -473,8 +607,7 @@ XdpGenericReceiveLinearizeNb(
     UINT32 MdlOffset = NET_BUFFER_CURRENT_MDL_OFFSET(Nb);
     UINT32 DataLength = NET_BUFFER_DATA_LENGTH(Nb);
     XDP_BUFFER_VIRTUAL_ADDRESS *SystemVa;
-
-    ASSERT(RxQueue->FragmentBufferInUse == FALSE);
+    XDP_LWF_GENERIC_RX_LINEARIZE_BUFFER *LinearizeBuffer;
 
     ASSERT(XdpRingFree(FrameRing) > 0);
     Frame = XdpRingGetElement(FrameRing, FrameRing->ProducerIndex & FrameRing->Mask);
@@ -482,39 +615,32 @@ XdpGenericReceiveLinearizeNb(
     Buffer = &Frame->Buffer;
     Buffer->DataLength = 0;
 
+    LinearizeBuffer = XdpGenericReceiveAllocateLinearizeBuffer(RxQueue, DataLength);
+    if (LinearizeBuffer == NULL) {
+        return FALSE;
+    }
+
+    //
+    // The buffer is referenced by the frame until the next flush.
+    //
+    PushEntryList(&RxQueue->LinearizeInUseList, &LinearizeBuffer->Link);
+
     //
-    // Walk the MDL chain, copying data and expanding the backing buffer as
-    // necessary.
+    // Walk the MDL chain, copying data into the contiguous buffer.
     //
     while (Mdl != NULL && DataLength > 0) {
         UCHAR *MdlBuffer;
         UINT32 CopyLength = min(Mdl->ByteCount - MdlOffset, DataLength);
 
-        if (!NT_SUCCESS(RtlUInt32Add(CopyLength, Buffer->DataLength, &Buffer->DataLength))) {
-            return FALSE;
-        }
-
         MdlBuffer = MmGetSystemAddressForMdlSafe(Mdl, LowPagePriority | MdlMappingNoExecute);
         if (MdlBuffer == NULL || XdpLwfFaultInject()) {
             return FALSE;
         }
 
-        //
-        // If the existing contiguous buffer is too small, attempt to expand it,
-        // which also copies any existing payload.
-        //
-        if (Buffer->DataLength > RxQueue->FragmentBufferSize) {
-            if (!XdpGenericReceiveExpandFragmentBuffer(RxQueue)) {
-                return FALSE;
-            }
-
-            ASSERT(Buffer->DataLength <= RxQueue->FragmentBufferSize);
-        }
-
         RtlCopyMemory(
-            RxQueue->FragmentBuffer + Buffer->DataLength - CopyLength,
-            MdlBuffer + MdlOffset, CopyLength);
+            LinearizeBuffer->Data + Buffer->DataLength, MdlBuffer + MdlOffset, CopyLength);
 
+        Buffer->DataLength += CopyLength;
         DataLength -= CopyLength;
         Mdl = Mdl->Next;
         MdlOffset = 0;
@@ -523,9 +649,8 @@ XdpGenericReceiveLinearizeNb(
     Buffer->DataOffset = 0;
     Buffer->BufferLength = Buffer->DataLength;
     SystemVa = XdpGetVirtualAddressExtension(Buffer, &RxQueue->BufferVaExtension);
-    SystemVa->VirtualAddress = RxQueue->FragmentBuffer;
+    SystemVa->VirtualAddress = LinearizeBuffer->Data;
 
-    RxQueue->FragmentBufferInUse = TRUE;
     return TRUE;
 }
 
@@ -1429,7 +1554,12 @@ XdpGenericReceivePreinspectNb(
 
     Buffer->DataOffset = NET_BUFFER_CURRENT_MDL_OFFSET(Nb);
     Buffer->DataLength = min(Mdl->ByteCount - Buffer->DataOffset, DataLength);
-    Buffer->BufferLength = Mdl->ByteCount;
+    //
+    // The MDL may hold other data after this NB, such as the next packet of a
+    // multi-packet receive buffer or upper layer data on the TX path, so the
+    // buffer ends with the NB.
+    //
+    Buffer->BufferLength = Buffer->DataOffset + Buffer->DataLength;
     DataLength -= Buffer->DataLength;
 
     *FlushNeeded = FALSE;
@@ -1513,19 +1643,10 @@ XdpGenericReceivePreinspectNb(
         //
         if (FragmentCount + 1ui32 > RxQueue->FragmentLimit) {
             //
-            // Generic XDP reserves a single contiguous buffer for
-            // linearization; if a NB contains more than the maximum number
-            // of fragments (MDLs), copy the contents of the entire MDL
-            // chain into one contiguous buffer.
+            // If a NB contains more than the maximum number of fragments
+            // (MDLs), copy the contents of the entire MDL chain into one
+            // contiguous buffer from the queue's linearization pool.
             //
-            // If the contiguous buffer is already in use, flush the queue
-            // first.
-            //
-            if (RxQueue->FragmentBufferInUse) {
-                *FlushNeeded = TRUE;
-                return;
-            }
-
             if (!XdpGenericReceiveLinearizeNb(RxQueue, Nb)) {
                 STAT_INC(&RxQueue->PcwStats, LinearizationFailures);
                 return;
@@ -1570,6 +1691,10 @@ XdpGenericReceivePreinspectNb(
     FragmentExtension = XdpGetFragmentExtension(Frame, &RxQueue->FragmentExtension);
     FragmentExtension->FragmentBufferCount = FragmentCount;
 
+    if (RxQueue->Flags.GroOffloadEnabled) {
+        XdpGetGroExtension(Frame, &RxQueue->FrameGroExtension)->UDP.MessageSize = 0;
+    }
+
     //
     // Store the original NB address so uninspected frames (e.g. those where
     // virtual mappings failed) can be identified and dropped later.
@@ -1577,6 +1702,9 @@ XdpGenericReceivePreinspectNb(
     InterfaceExtension =
         XdpGetFrameInterfaceContextExtension(Frame, &RxQueue->FrameInterfaceContextExtension);
     InterfaceExtension->Nb = Nb;
+    InterfaceExtension->NbCount = 1;
+    InterfaceExtension->DataOffset = Frame->Buffer.DataOffset;
+    InterfaceExtension->DataLength = Frame->Buffer.DataLength;
 
     //
     // The NB has successfully been converted to XDP descriptors, so commit
@@ -1588,6 +1716,247 @@ XdpGenericReceivePreinspectNb(
     *NbAddedToRing = TRUE;
 }
 
+static
+BOOLEAN
+XdpGenericReceiveGroParse(
+    _In_reads_bytes_(DataLength) const UCHAR *Data,
+    _In_ UINT32 DataLength,
+    _Out_ UINT32 *HeaderLength
+    )
+{
+    const ETHERNET_HEADER *Ethernet = (const ETHERNET_HEADER *)Data;
+    const UDP_HDR UNALIGNED *Udp;
+    UINT32 Layer4Offset;
+
+    //
+    // Only UDP datagrams without IP options or extension headers, whose IP
+    // and UDP lengths exactly describe the frame, are coalesced.
+    //
+    if (DataLength < sizeof(*Ethernet)) {
+        return FALSE;
+    }
+
+    switch (Ethernet->Type) {
+    case CONST_HTONS(ETHERNET_TYPE_IPV4):
+    {
+        const IPV4_HEADER UNALIGNED *Ipv4 = (const IPV4_HEADER UNALIGNED *)(Ethernet + 1);
+        Layer4Offset = sizeof(*Ethernet) + sizeof(*Ipv4);
+
+        if (DataLength < Layer4Offset + sizeof(*Udp) ||
+            Ipv4->Version != IPV4_VERSION ||
+            (((UINT32)Ipv4->HeaderLength) << 2) != sizeof(*Ipv4) ||
+            Ipv4->Protocol != IPPROTO_UDP ||
+            (Ipv4->FlagsAndOffset & RECV_IPV4_FRAGMENT_MASK) != 0 ||
+            ntohs(Ipv4->TotalLength) != DataLength - sizeof(*Ethernet)) {
+            return FALSE;
+        }
+        break;
+    }
+    case CONST_HTONS(ETHERNET_TYPE_IPV6):
+    {
+        const IPV6_HEADER UNALIGNED *Ipv6 = (const IPV6_HEADER UNALIGNED *)(Ethernet + 1);
+        Layer4Offset = sizeof(*Ethernet) + sizeof(*Ipv6);
+
+        if (DataLength < Layer4Offset + sizeof(*Udp) ||
+            Ipv6->NextHeader != IPPROTO_UDP ||
+            ntohs(Ipv6->PayloadLength) != DataLength - Layer4Offset) {
+            return FALSE;
+        }
+        break;
+    }
+    default:
+        return FALSE;
+    }
+
+    Udp = (const UDP_HDR UNALIGNED *)(Data + Layer4Offset);
+    if (ntohs(Udp->uh_ulen) != DataLength - Layer4Offset ||
+        DataLength == Layer4Offset + sizeof(*Udp)) {
+        return FALSE;
+    }
+
+    *HeaderLength = Layer4Offset + sizeof(*Udp);
+    return TRUE;
+}
+
+static
+BOOLEAN
+XdpGenericReceiveGroIsSameFlow(
+    _In_ const XDP_LWF_GENERIC_RX_GRO *Gro,
+    _In_ const UCHAR *Headers
+    )
+{
+    const ETHERNET_HEADER *Ethernet = (const ETHERNET_HEADER *)Gro->Headers;
+    const UDP_HDR UNALIGNED *GroUdp =
+        (const UDP_HDR UNALIGNED *)(Gro->Headers + Gro->HeaderLength - sizeof(UDP_HDR));
+    const UDP_HDR UNALIGNED *Udp =
+        (const UDP_HDR UNALIGNED *)(Headers + Gro->HeaderLength - sizeof(UDP_HDR));
+
+    if (!RtlEqualMemory(Gro->Headers, Headers, sizeof(*Ethernet)) ||
+        GroUdp->uh_sport != Udp->uh_sport || GroUdp->uh_dport != Udp->uh_dport) {
+        return FALSE;
+    }
+
+    //
+    // The Ethernet types are equal, so both datagrams share an IP version.
+    //
+    if (Ethernet->Type == CONST_HTONS(ETHERNET_TYPE_IPV4)) {
+        const IPV4_HEADER UNALIGNED *GroIpv4 = (const IPV4_HEADER UNALIGNED *)(Ethernet + 1);
+        const IPV4_HEADER UNALIGNED *Ipv4 =
+            (const IPV4_HEADER UNALIGNED *)(Headers + sizeof(*Ethernet));
+
+        return
+            RtlEqualMemory(&GroIpv4->SourceAddress, &Ipv4->SourceAddress, sizeof(IN_ADDR)) &&
+            RtlEqualMemory(
+                &GroIpv4->DestinationAddress, &Ipv4->DestinationAddress, sizeof(IN_ADDR));
+    } else {
+        const IPV6_HEADER UNALIGNED *GroIpv6 = (const IPV6_HEADER UNALIGNED *)(Ethernet + 1);
+        const IPV6_HEADER UNALIGNED *Ipv6 =
+            (const IPV6_HEADER UNALIGNED *)(Headers + sizeof(*Ethernet));
+
+        return
+            RtlEqualMemory(&GroIpv6->SourceAddress, &Ipv6->SourceAddress, sizeof(IN6_ADDR)) &&
+            RtlEqualMemory(
+                &GroIpv6->DestinationAddress, &Ipv6->DestinationAddress, sizeof(IN6_ADDR));
+    }
+}
+
+static
+VOID
+XdpGenericReceiveGroStart(
+    _In_ XDP_LWF_GENERIC_RX_QUEUE *RxQueue,
+    _Out_ XDP_LWF_GENERIC_RX_GRO *Gro,
+    _In_ NET_BUFFER_LIST *Nbl,
+    _In_ NET_BUFFER *Nb
+    )
+{
+    XDP_RING *FrameRing = RxQueue->FrameRing;
+    XDP_FRAME *Frame =
+        XdpRingGetElement(FrameRing, (FrameRing->ProducerIndex - 1) & FrameRing->Mask);
+    XDP_BUFFER *Buffer = &Frame->Buffer;
+    const UCHAR *Headers;
+    UINT32 HeaderLength;
+
+    Gro->Frame = NULL;
+
+    //
+    // Only single-NB NBLs with the entire datagram in the first buffer start
+    // a coalesced frame.
+    //
+    if (Nb != NET_BUFFER_LIST_FIRST_NB(Nbl) || NET_BUFFER_NEXT_NB(Nb) != NULL ||
+        XdpGetFragmentExtension(Frame, &RxQueue->FragmentExtension)->FragmentBufferCount != 0 ||
+        Buffer->DataLength != NET_BUFFER_DATA_LENGTH(Nb) ||
+        Buffer->DataLength >= RxQueue->GroMaximumFrameLength) {
+        return;
+    }
+
+    Headers =
+        XdpGetVirtualAddressExtension(Buffer, &RxQueue->BufferVaExtension)->VirtualAddress +
+            Buffer->DataOffset;
+
+    if (!XdpGenericReceiveGroParse(Headers, Buffer->DataLength, &HeaderLength) ||
+        Buffer->DataLength - HeaderLength > MAXUINT16) {
+        return;
+    }
+
+    Gro->Frame = Frame;
+    Gro->Headers = Headers;
+    Gro->ChecksumInfo = (ULONG_PTR)NET_BUFFER_LIST_INFO(Nbl, TcpIpChecksumNetBufferListInfo);
+    Gro->HeaderLength = HeaderLength;
+    Gro->FrameLength = Buffer->DataLength;
+    Gro->MessageSize = (UINT16)(Buffer->DataLength - HeaderLength);
+}
+
+static
+BOOLEAN
+XdpGenericReceiveCoalesceNb(
+    _In_ XDP_LWF_GENERIC_RX_QUEUE *RxQueue,
+    _Inout_ XDP_LWF_GENERIC_RX_GRO *Gro,
+    _In_ NET_BUFFER_LIST *Nbl,
+    _In_ NET_BUFFER *Nb
+    )
+{
+    XDP_RING *FragmentRing = RxQueue->FragmentRing;
+    XDP_FRAME *Frame = Gro->Frame;
+    XDP_FRAME_FRAGMENT *FragmentExtension =
+        XdpGetFragmentExtension(Frame, &RxQueue->FragmentExtension);
+    MDL *Mdl = NET_BUFFER_CURRENT_MDL(Nb);
+    UINT32 DataOffset = NET_BUFFER_CURRENT_MDL_OFFSET(Nb);
+    UINT32 DataLength = NET_BUFFER_DATA_LENGTH(Nb);
+    XDP_LWF_GENERIC_RX_FRAME_CONTEXT *InterfaceExtension;
+    UINT32 PayloadLength;
+    UINT32 HeaderLength;
+    XDP_BUFFER *Buffer;
+    UCHAR *Va;
+
+    ASSERT(Frame != NULL);
+
+    if (Nb != NET_BUFFER_LIST_FIRST_NB(Nbl) || NET_BUFFER_NEXT_NB(Nb) != NULL ||
+        NdisTestNblFlag(Nbl, NDIS_NBL_FLAGS_IS_LOOPBACK_PACKET) ||
+        Mdl->ByteCount - DataOffset < DataLength ||
+        DataLength <= Gro->HeaderLength) {
+        return FALSE;
+    }
+
+    PayloadLength = DataLength - Gro->HeaderLength;
+    if (PayloadLength > Gro->MessageSize ||
+        Gro->FrameLength + PayloadLength > RxQueue->GroMaximumFrameLength ||
+        FragmentExtension->FragmentBufferCount + 1ui32 > RxQueue->FragmentLimit ||
+        XdpRingFree(FragmentRing) == 0) {
+        return FALSE;
+    }
+
+    if (RxQueue->Flags.ChecksumOffloadEnabled &&
+        (ULONG_PTR)NET_BUFFER_LIST_INFO(Nbl, TcpIpChecksumNetBufferListInfo) !=
+            Gro->ChecksumInfo) {
+        return FALSE;
+    }
+
+    Va = MmGetSystemAddressForMdlSafe(Mdl, LowPagePriority | MdlMappingNoExecute);
+    if (Va == NULL ||
+        !XdpGenericReceiveGroParse(Va + DataOffset, DataLength, &HeaderLength) ||
+        HeaderLength != Gro->HeaderLength ||
+        !XdpGenericReceiveGroIsSameFlow(Gro, Va + DataOffset)) {
+        return FALSE;
+    }
+
+    //
+    // Append the datagram's payload to the frame as a fragment buffer. The
+    // frame is the most recent in the XDP ring, so its fragments are the last
+    // produced onto the fragment ring.
+    //
+    Buffer = XdpRingGetElement(FragmentRing, FragmentRing->ProducerIndex & FragmentRing->Mask);
+    Buffer->DataOffset = DataOffset + HeaderLength;
+    Buffer->DataLength = PayloadLength;
+    Buffer->BufferLength = Mdl->ByteCount;
+    XdpGetVirtualAddressExtension(Buffer, &RxQueue->BufferVaExtension)->VirtualAddress = Va;
+
+    FragmentRing->ProducerIndex++;
+    FragmentExtension->FragmentBufferCount++;
+    InterfaceExtension =
+        XdpGetFrameInterfaceContextExtension(Frame, &RxQueue->FrameInterfaceContextExtension);
+    if (InterfaceExtension->NbCount == 1) {
+        C_ASSERT(RECV_GRO_MAX_HEADER_LENGTH <= RTL_FIELD_SIZE(
+            XDP_LWF_GENERIC_RX_FRAME_CONTEXT, GroHeaders));
+        ASSERT(Gro->HeaderLength <= sizeof(InterfaceExtension->GroHeaders));
+        RtlCopyMemory(InterfaceExtension->GroHeaders, Gro->Headers, Gro->HeaderLength);
+        InterfaceExtension->GroHeaderLength = Gro->HeaderLength;
+    }
+    InterfaceExtension->NbCount++;
+    XdpGetGroExtension(Frame, &RxQueue->FrameGroExtension)->UDP.MessageSize = Gro->MessageSize;
+    Gro->FrameLength += PayloadLength;
+
+    //
+    // A short datagram ends the coalesced frame.
+    //
+    if (PayloadLength < Gro->MessageSize) {
+        Gro->Frame = NULL;
+    }
+
+    STAT_INC(&RxQueue->PcwStats, NbsCoalesced);
+
+    return TRUE;
+}
+
 static
 VOID
 XdpGenericReceivePreInspectNbs(
@@ -1600,6 +1969,17 @@ XdpGenericReceivePreInspectNbs(
 {
     BOOLEAN FlushNeeded = FALSE;
     BOOLEAN NbAddedToRing = FALSE;
+    XDP_LWF_GENERIC_RX_GRO Gro;
+
+    //
+    // Receive coalescing requires NBs be processed in batches, so it is
+    // disabled for low resources indications, and for TX inspection, where
+    // NBLs may contain multiple NBs.
+    //
+    BOOLEAN GroEnabled =
+        RxQueue->Flags.GroOffloadEnabled && !RxQueue->Flags.TxInspect && CanPend;
+
+    Gro.Frame = NULL;
 
     ASSERT(RxQueue->FrameRing->ConsumerIndex == RxQueue->FrameRing->InterfaceReserved);
     ASSERT(RxQueue->FrameRing->ConsumerIndex == RxQueue->FrameRing->ProducerIndex);
@@ -1618,10 +1998,17 @@ XdpGenericReceivePreInspectNbs(
     do {
         ASSERT(XdpRingFree(RxQueue->FrameRing) > 0);
 
-        XdpGenericReceivePreinspectNb(RxQueue, *Nbl, *Nb, &NbAddedToRing, &FlushNeeded);
-        *InspectionNeeded |= NbAddedToRing;
-        if (FlushNeeded) {
-            return;
+        if (Gro.Frame == NULL || !XdpGenericReceiveCoalesceNb(RxQueue, &Gro, *Nbl, *Nb)) {
+            XdpGenericReceivePreinspectNb(RxQueue, *Nbl, *Nb, &NbAddedToRing, &FlushNeeded);
+            *InspectionNeeded |= NbAddedToRing;
+            if (FlushNeeded) {
+                return;
+            }
+
+            Gro.Frame = NULL;
+            if (GroEnabled && NbAddedToRing) {
+                XdpGenericReceiveGroStart(RxQueue, &Gro, *Nbl, *Nb);
+            }
         }
 
         //
@@ -1638,6 +2025,79 @@ XdpGenericReceivePreInspectNbs(
     } while (*Nb != NULL && XdpRingFree(RxQueue->FrameRing) > 0 && CanPend);
 }
 
+static
+VOID
+XdpGenericReceiveApplyFrameAdjustments(
+    _In_ const XDP_LWF_GENERIC_RX_QUEUE *RxQueue,
+    _In_ const XDP_FRAME *Frame,
+    _In_ const XDP_LWF_GENERIC_RX_FRAME_CONTEXT *InterfaceExtension
+    )
+{
+    const XDP_BUFFER *Buffer = &Frame->Buffer;
+    NET_BUFFER *Nb = InterfaceExtension->Nb;
+    INT64 HeadDelta = (INT64)Buffer->DataOffset - InterfaceExtension->DataOffset;
+    INT64 TailDelta =
+        ((INT64)Buffer->DataOffset + Buffer->DataLength) -
+        ((INT64)InterfaceExtension->DataOffset + InterfaceExtension->DataLength);
+
+    //
+    // Programs may move the head and tail of the frame's first buffer within
+    // its MDL. Only the first buffer is adjusted, so coalesced frames carry
+    // head adjustments in their first NB alone.
+    //
+    if (HeadDelta > 0) {
+        NdisAdvanceNetBufferDataStart(Nb, (ULONG)HeadDelta, FALSE, NULL);
+    } else if (HeadDelta < 0) {
+        NDIS_STATUS NdisStatus;
+
+        //
+        // The MDL already holds the retreated data, so no allocation is needed.
+        // Data in front of frames on the TX path belongs to upper layers, so
+        // XDP does not allow their head to move backwards.
+        //
+        ASSERT(!RxQueue->Flags.TxInspect);
+        UNREFERENCED_PARAMETER(RxQueue);
+        NdisStatus = NdisRetreatNetBufferDataStart(Nb, (ULONG)-HeadDelta, 0, NULL);
+        ASSERT(NdisStatus == NDIS_STATUS_SUCCESS);
+        UNREFERENCED_PARAMETER(NdisStatus);
+    }
+
+    if (TailDelta != 0) {
+        NET_BUFFER_DATA_LENGTH(Nb) = (ULONG)((INT64)NET_BUFFER_DATA_LENGTH(Nb) + TailDelta);
+    }
+}
+
+static
+BOOLEAN
+XdpGenericReceiveIsCoalescedFrameIntact(
+    _In_ XDP_LWF_GENERIC_RX_QUEUE *RxQueue,
+    _In_ XDP_FRAME *Frame,
+    _In_ const XDP_LWF_GENERIC_RX_FRAME_CONTEXT *InterfaceExtension,
+    _In_ XDP_RX_ACTION RxAction
+    )
+{
+    const XDP_BUFFER *Buffer = &Frame->Buffer;
+
+    ASSERT(InterfaceExtension->NbCount > 1);
+
+    //
+    // Only the first datagram of a coalesced frame is visible to the program,
+    // so the frame cannot be transmitted, and its first datagram's bounds and
+    // headers must be unmodified, for the action to apply to every datagram.
+    //
+    if (RxAction == XDP_RX_ACTION_TX ||
+        Buffer->DataOffset != InterfaceExtension->DataOffset ||
+        Buffer->DataLength != InterfaceExtension->DataLength) {
+        return FALSE;
+    }
+
+    return
+        RtlEqualMemory(
+            XdpGetVirtualAddressExtension(Buffer, &RxQueue->BufferVaExtension)->VirtualAddress +
+                Buffer->DataOffset,
+            InterfaceExtension->GroHeaders, InterfaceExtension->GroHeaderLength);
+}
+
 static
 VOID
 XdpGenericReceivePostInspectNbs(
@@ -1667,6 +2127,8 @@ XdpGenericReceivePostInspectNbs(
         FrameRing->InterfaceReserved == FrameRing->ProducerIndex - 1);
 
     NET_BUFFER_LIST *CachedNextNbl = NULL;
+    XDP_RX_ACTION CoalescedRxAction = XDP_RX_ACTION_DROP;
+    UINT32 CoalescedNbsRemaining = 0;
 
     while (NbHead != NbTail) {
         XDP_FRAME *Frame;
@@ -1680,9 +2142,25 @@ XdpGenericReceivePostInspectNbs(
         InterfaceExtension =
             XdpGetFrameInterfaceContextExtension(Frame, &RxQueue->FrameInterfaceContextExtension);
 
-        if (FrameRing->InterfaceReserved != FrameRing->ProducerIndex &&
+        if (CoalescedNbsRemaining > 0) {
+            //
+            // This NB was coalesced into the preceding frame, so it shares
+            // that frame's action.
+            //
+            XdpRxAction = CoalescedRxAction;
+            CoalescedNbsRemaining--;
+        } else if (FrameRing->InterfaceReserved != FrameRing->ProducerIndex &&
             NbHead == InterfaceExtension->Nb) {
             XdpRxAction = XdpGetRxActionExtension(Frame, &RxQueue->RxActionExtension)->RxAction;
+            if (InterfaceExtension->NbCount > 1 && XdpRxAction != XDP_RX_ACTION_DROP &&
+                !XdpGenericReceiveIsCoalescedFrameIntact(
+                    RxQueue, Frame, InterfaceExtension, XdpRxAction)) {
+                XdpRxAction = XDP_RX_ACTION_DROP;
+            } else {
+                XdpGenericReceiveApplyFrameAdjustments(RxQueue, Frame, InterfaceExtension);
+            }
+            CoalescedRxAction = XdpRxAction;
+            CoalescedNbsRemaining = InterfaceExtension->NbCount - 1;
             FrameRing->InterfaceReserved++;
         } else {
             //
@@ -1695,12 +2173,6 @@ XdpGenericReceivePostInspectNbs(
             }
         }
 
-        //
-        // Currently XDP does not advance/retreat buffers, so there's no need to
-        // explicitly update the NB; however, the payload data may have already
-        // been rewritten.
-        //
-
         //
         // Handle the NBL based on the action of the first NB in the NBL. NBLs
         // with multiple NBs are only permitted on the NDIS send path, and we
@@ -1848,6 +2320,12 @@ XdpGenericReceiveInspect(
             RxQueue, PortNumber, CanPend, NblHead, NbHead, NextNb, PassList, DropList, TxList,
             &LowResourcesList);
 
+        //
+        // Inspection has consumed every frame, so no frame references a
+        // linearization buffer.
+        //
+        XdpGenericReceiveRecycleLinearizeBuffers(RxQueue);
+
         EventWriteGenericRxInspectRingStop(
             &MICROSOFT_XDP_PROVIDER, RxQueue, !CanPend, RxQueue->FrameRing->ProducerIndex,
             RxQueue->FrameRing->ConsumerIndex, RxQueue->FrameRing->InterfaceReserved,
@@ -1872,9 +2350,7 @@ XdpGenericReceive(
     BOOLEAN CanPend = !(XdpInspectFlags & XDP_LWF_GENERIC_INSPECT_FLAG_RESOURCES);
     BOOLEAN TxInspect = XdpInspectFlags & XDP_LWF_GENERIC_INSPECT_FLAG_TX;
     BOOLEAN TxWorker = XdpInspectFlags & XDP_LWF_GENERIC_INSPECT_FLAG_TX_WORKER;
-    XDP_LWF_GENERIC_RSS_QUEUE *RssQueue = NULL;
-    XDP_LWF_GENERIC_RX_QUEUE *RxQueue = NULL;
-    XDP_RX_QUEUE_HANDLE XdpRxQueue = NULL;
+    NET_BUFFER_LIST *RemainingNetBufferLists;
 
     EventWriteGenericRxInspectStart(&MICROSOFT_XDP_PROVIDER, Generic);
 
@@ -1888,44 +2364,59 @@ XdpGenericReceive(
 
     Processor = KeGetCurrentProcessorIndex();
 
-    //
-    // Attempt to enter the RX queue's EC for the implicit RSS queue. Either we
-    // successfully enter the EC and are provided with an XDP queue and NBLs to
-    // process, XOR we could not enter the EC (no XDP queue and all NBLs were
-    // redirected).
-    //
-    XdpGenericReceiveEnterEc(
-        Generic, &NetBufferLists, Processor, TxInspect, TxWorker, &RssQueue, &RxQueue,
-        &XdpRxQueue, PassList);
-    ASSERT((NetBufferLists != NULL) == (XdpRxQueue != NULL));
+    do {
+        XDP_LWF_GENERIC_RSS_QUEUE *RssQueue;
+        XDP_LWF_GENERIC_RX_QUEUE *RxQueue;
+        XDP_RX_QUEUE_HANDLE XdpRxQueue;
+        NBL_COUNTED_QUEUE RssTxList;
+
+        NdisInitializeNblCountedQueue(&RssTxList);
 
-    if (NetBufferLists != NULL) {
         //
-        // Perform XDP inspection on each frame within the NBL chain.
+        // Attempt to enter the RX queue's EC for the implicit RSS queue of the
+        // leading NBLs. Either we successfully enter the EC and are provided
+        // with an XDP queue and NBLs to process, XOR we could not enter the EC
+        // (no XDP queue and all leading NBLs were redirected).
         //
-        XdpGenericReceiveInspect(
-            RxQueue, XdpRxQueue, NetBufferLists, PortNumber, CanPend, PassList, DropList, TxList);
-    }
+        XdpGenericReceiveEnterEc(
+            Generic, &NetBufferLists, &RemainingNetBufferLists, Processor, TxInspect, TxWorker,
+            &RssQueue, &RxQueue, &XdpRxQueue, PassList);
+        ASSERT((NetBufferLists != NULL) == (XdpRxQueue != NULL));
 
-    if (XdpRxQueue != NULL) {
-        XdpGenericReceiveExitEc(RxQueue, TxWorker, PassList);
-    }
+        if (NetBufferLists != NULL) {
+            //
+            // Perform XDP inspection on each frame within the NBL chain.
+            //
+            XdpGenericReceiveInspect(
+                RxQueue, XdpRxQueue, NetBufferLists, PortNumber, CanPend, PassList, DropList,
+                &RssTxList);
+        }
 
-    if (RssQueue != NULL && !TxInspect) {
-        //
-        // Attempt to steal time from the RX path to ensure TX gets a chance to
-        // run. If this processor differs from the ideal TX processor, no time
-        // will be stolen.
-        //
-        XdpGenericTxFlushRss(RssQueue, Processor);
-    }
+        if (XdpRxQueue != NULL) {
+            XdpGenericReceiveExitEc(RxQueue, TxWorker, PassList);
+        }
 
-    if (!NdisIsNblCountedQueueEmpty(TxList)) {
-        if (!ExAcquireRundownProtectionEx(&RxQueue->NblRundown, (ULONG)TxList->NblCount)) {
-            XdpGenericRecvInjectReturnNbls(RxQueue, TxList);
-            ASSERT(NdisIsNblCountedQueueEmpty(TxList));
+        if (RssQueue != NULL && !TxInspect) {
+            //
+            // Attempt to steal time from the RX path to ensure TX gets a chance
+            // to run. If this processor differs from the ideal TX processor, no
+            // time will be stolen.
+            //
+            XdpGenericTxFlushRss(RssQueue, Processor);
+        }
+
+        if (!NdisIsNblCountedQueueEmpty(&RssTxList)) {
+            if (!ExAcquireRundownProtectionEx(&RxQueue->NblRundown, (ULONG)RssTxList.NblCount)) {
+                XdpGenericRecvInjectReturnNbls(RxQueue, &RssTxList);
+                ASSERT(NdisIsNblCountedQueueEmpty(&RssTxList));
+            } else {
+                NdisAppendNblChainToNblCountedQueue(
+                    TxList, NdisGetNblChainFromNblCountedQueue(&RssTxList));
+            }
         }
-    }
+
+        NetBufferLists = RemainingNetBufferLists;
+    } while (NetBufferLists != NULL);
 
     if (OldIrql != DISPATCH_LEVEL) {
         KeLowerIrql(OldIrql);
@@ -2390,6 +2881,11 @@ XdpGenericRxCreateQueue(
         XDP_FRAME_EXTENSION_TIMESTAMP_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
     XdpRxQueueRegisterExtensionVersion(Config, &ExtensionInfo);
 
+    XdpInitializeExtensionInfo(
+        &ExtensionInfo, XDP_FRAME_EXTENSION_GRO_NAME,
+        XDP_FRAME_EXTENSION_GRO_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+    XdpRxQueueRegisterExtensionVersion(Config, &ExtensionInfo);
+
     RxQueue->FragmentLimit = RECV_MAX_FRAGMENTS;
 
     XdpInitializeRxCapabilitiesDriverVa(&RxCapabilities);
@@ -2439,8 +2935,11 @@ XdpGenericRxActivateQueue(
 
     RxQueue->FrameRing = XdpRxQueueGetFrameRing(Config);
     RxQueue->FragmentRing = XdpRxQueueGetFragmentRing(Config);
+    RxQueue->LinearizePoolLimit = RxQueue->FrameRing->Mask + 1;
     RxQueue->Flags.ChecksumOffloadEnabled = XdpRxQueueIsChecksumOffloadEnabled(Config);
     RxQueue->Flags.TimestampOffloadEnabled = XdpRxQueueIsTimestampOffloadEnabled(Config);
+    RxQueue->Flags.GroOffloadEnabled = XdpRxQueueIsGroOffloadEnabled(Config);
+    RxQueue->GroMaximumFrameLength = XdpRxQueueGetGroMaximumFrameLength(Config);
 
     ASSERT(RxQueue->FrameRing->InterfaceReserved == RxQueue->FrameRing->ProducerIndex);
 
@@ -2484,6 +2983,13 @@ XdpGenericRxActivateQueue(
         XdpRxQueueGetExtension(Config, &ExtensionInfo, &RxQueue->FrameTimestampExtension);
     }
 
+    if (RxQueue->Flags.GroOffloadEnabled) {
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_GRO_NAME,
+            XDP_FRAME_EXTENSION_GRO_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        XdpRxQueueGetExtension(Config, &ExtensionInfo, &RxQueue->FrameGroExtension);
+    }
+
     WritePointerRelease(&RxQueue->XdpRxQueue, XdpRxQueue);
 
     return STATUS_SUCCESS;
@@ -2498,9 +3004,8 @@ XdpGenericRxDeleteQueueEntry(
     XDP_LWF_GENERIC_RX_QUEUE *RxQueue;
 
     RxQueue = CONTAINING_RECORD(Entry, XDP_LWF_GENERIC_RX_QUEUE, DeleteEntry);
-    if (RxQueue->FragmentBuffer != NULL) {
-        ExFreePoolWithTag(RxQueue->FragmentBuffer, POOLTAG_RECV);
-    }
+    XdpGenericReceiveFreeLinearizeBuffers(&RxQueue->LinearizeInUseList);
+    XdpGenericReceiveFreeLinearizeBuffers(&RxQueue->LinearizeFreeList);
     XdpGenericRxFreeNblCloneCache(
         (NET_BUFFER_LIST *)InterlockedFlushSList(&RxQueue->TxCloneNblSList));
     XdpGenericRxFreeNblCloneCache(RxQueue->TxCloneNblList);
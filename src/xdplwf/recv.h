@@ -7,6 +7,12 @@
 
 #include "ec.h"
 
+typedef struct _XDP_LWF_GENERIC_RX_LINEARIZE_BUFFER {
+    SINGLE_LIST_ENTRY Link;
+    UINT32 AllocationSize;
+    DECLSPEC_CACHEALIGN UCHAR Data[0];
+} XDP_LWF_GENERIC_RX_LINEARIZE_BUFFER;
+
 typedef struct _XDP_LWF_GENERIC_RX_QUEUE {
     XDP_RX_QUEUE_HANDLE XdpRxQueue;
     XDP_RING *FrameRing;
@@ -18,6 +24,7 @@ typedef struct _XDP_LWF_GENERIC_RX_QUEUE {
     XDP_EXTENSION FrameLayoutExtension;
     XDP_EXTENSION FrameChecksumExtension;
     XDP_EXTENSION FrameTimestampExtension;
+    XDP_EXTENSION FrameGroExtension;
     XDP_PCW_LWF_RX_QUEUE PcwStats;
     NDIS_HANDLE TxCloneNblPool;
     UINT32 TxCloneCacheLimit;
@@ -34,10 +41,16 @@ typedef struct _XDP_LWF_GENERIC_RX_QUEUE {
     // contending the lock.
     //
 
-    UCHAR *FragmentBuffer;
-    UINT32 FragmentBufferSize;
+    //
+    // Linearization buffers for NBs with more MDLs than the fragment limit.
+    // Buffers referenced by frames are recycled once the frames are flushed.
+    //
+    SINGLE_LIST_ENTRY LinearizeFreeList;
+    SINGLE_LIST_ENTRY LinearizeInUseList;
+    UINT32 LinearizeFreeCount;
+    UINT32 LinearizePoolLimit;
     UINT8 FragmentLimit;
-    UINT8 FragmentBufferInUse;
+    UINT32 GroMaximumFrameLength;
 
     KSPIN_LOCK EcLock;
 
@@ -72,6 +85,7 @@ typedef struct _XDP_LWF_GENERIC_RX_QUEUE {
         BOOLEAN TxInspectNeedFlush : 1;
         BOOLEAN ChecksumOffloadEnabled : 1;
         BOOLEAN TimestampOffloadEnabled : 1;
+        BOOLEAN GroOffloadEnabled : 1;
     } Flags;
     UINT32 QueueId;
     LIST_ENTRY Link;
@@ -6,6 +6,15 @@
 #include "precomp.h"
 #include "rss.tmh"
 
+//
+// The longest headers hashed in software: Ethernet, IPv4 with options, and a
+// TCP or UDP port pair.
+//
+#define RSS_MAX_HASH_HEADER_LENGTH \
+    (sizeof(ETHERNET_HEADER) + (0xF << 2) + 2 * sizeof(UINT16))
+
+#define RSS_IPV4_FRAGMENT_MASK CONST_HTONS(0x3FFF)
+
 static
 VOID
 XdpGenericRssFreeLifetimeIndirection(
@@ -34,6 +43,75 @@ XdpGenericRssFreeIndirection(
     }
 }
 
+static
+VOID
+XdpGenericRssCreateSoftwareHash(
+    _In_ XDP_LWF_GENERIC *Generic,
+    _In_ NDIS_RECEIVE_SCALE_PARAMETERS *RssParams,
+    _In_ ULONG RssParamsLength,
+    _Inout_ XDP_LWF_GENERIC_INDIRECTION_TABLE *IndirectionTable,
+    _Out_ XDP_TOEPLITZ_TABLE *Toeplitz
+    )
+{
+    XDP_LWF_GENERIC_INDIRECTION_TABLE *OldIndirectionTable;
+    BOOLEAN HashInfoUnchanged =
+        !!(RssParams->Flags & NDIS_RSS_PARAM_FLAG_HASH_INFO_UNCHANGED);
+    BOOLEAN HashKeyUnchanged =
+        !!(RssParams->Flags & NDIS_RSS_PARAM_FLAG_HASH_KEY_UNCHANGED);
+    ULONG HashType = 0;
+    BOOLEAN HasKey = FALSE;
+
+    //
+    // Track the hash configuration alongside the indirection table so frames
+    // indicated without an RSS hash can be hashed in software. Unchanged
+    // settings are inherited from the current indirection table.
+    //
+
+    if (HashInfoUnchanged || HashKeyUnchanged) {
+        RtlAcquirePushLockShared(&Generic->Lock);
+
+        OldIndirectionTable = Generic->Rss.IndirectionTable;
+        if (OldIndirectionTable != NULL && OldIndirectionTable->Toeplitz != NULL) {
+            if (HashInfoUnchanged) {
+                HashType = OldIndirectionTable->HashType;
+            }
+
+            if (HashKeyUnchanged) {
+                RtlCopyMemory(Toeplitz, OldIndirectionTable->Toeplitz, sizeof(*Toeplitz));
+                HasKey = TRUE;
+            }
+        }
+
+        RtlReleasePushLockShared(&Generic->Lock);
+    }
+
+    if (!HashInfoUnchanged &&
+        NDIS_RSS_HASH_FUNC_FROM_HASH_INFO(RssParams->HashInformation) ==
+            NdisHashFunctionToeplitz) {
+        HashType = NDIS_RSS_HASH_TYPE_FROM_HASH_INFO(RssParams->HashInformation);
+    }
+
+    if (!HashKeyUnchanged &&
+        RssParams->HashSecretKeySize > 0 &&
+        RssParams->HashSecretKeySize <= XDP_TOEPLITZ_MAX_KEY_SIZE &&
+        RssParams->HashSecretKeyOffset <= RssParamsLength &&
+        RssParams->HashSecretKeySize <= RssParamsLength - RssParams->HashSecretKeyOffset) {
+        XdpToeplitzInitializeTable(
+            Toeplitz, RTL_PTR_ADD(RssParams, RssParams->HashSecretKeyOffset),
+            RssParams->HashSecretKeySize);
+        HasKey = TRUE;
+    }
+
+    if (HashType != 0 && HasKey) {
+        IndirectionTable->HashType = HashType;
+        IndirectionTable->Toeplitz = Toeplitz;
+    }
+
+    TraceVerbose(
+        TRACE_GENERIC, "IfIndex=%u SoftwareHashType=0x%x",
+        Generic->IfIndex, IndirectionTable->HashType);
+}
+
 NTSTATUS
 XdpGenericRssCreateIndirection(
     _In_ XDP_LWF_GENERIC *Generic,
@@ -123,7 +201,9 @@ XdpGenericRssCreateIndirection(
         ExAllocatePoolZero(
             NonPagedPoolNxCacheAligned,
             sizeof(*NewIndirectionTable) +
-                EntryCount * sizeof(NewIndirectionTable->Entries[0]),
+                EntryCount * sizeof(NewIndirectionTable->Entries[0]) +
+                MaxProcessors * sizeof(NewIndirectionTable->ProcessorQueues[0]) +
+                (EntryCount > 1 ? sizeof(*NewIndirectionTable->Toeplitz) : 0),
             POOLTAG_RSS);
     if (NewIndirectionTable == NULL) {
         Status = STATUS_NO_MEMORY;
@@ -131,6 +211,15 @@ XdpGenericRssCreateIndirection(
     }
 
     NewIndirectionTable->IndirectionMask = EntryCount - 1;
+    NewIndirectionTable->ProcessorCount = MaxProcessors;
+    NewIndirectionTable->ProcessorQueues =
+        (UINT32 *)&NewIndirectionTable->Entries[EntryCount];
+
+    if (EntryCount > 1) {
+        XdpGenericRssCreateSoftwareHash(
+            Generic, RssParams, RssParamsLength, NewIndirectionTable,
+            (XDP_TOEPLITZ_TABLE *)&NewIndirectionTable->ProcessorQueues[MaxProcessors]);
+    }
 
     //
     // Figure out the new queue processor affinities.
@@ -163,6 +252,18 @@ XdpGenericRssCreateIndirection(
         NewIndirectionTable->Entries[Index].QueueIndex = QueueIndex;
     }
 
+    //
+    // Build the (processor -> queue) index. Processors absent from the
+    // indirection table remain mapped to queue 0.
+    //
+    for (ULONG QueueIndex = 0; QueueIndex < AssignedQueues; QueueIndex++) {
+        ULONG Processor = NewQueues[QueueIndex].IdealProcessor;
+
+        if (Processor < NewIndirectionTable->ProcessorCount) {
+            NewIndirectionTable->ProcessorQueues[Processor] = QueueIndex;
+        }
+    }
+
     Indirection->AssignedQueues = AssignedQueues;
     Indirection->NewIndirectionTable = NewIndirectionTable;
     Indirection->NewQueues = NewQueues;
@@ -261,13 +362,114 @@ XdpGenericRssGetQueueById(
     return &Generic->Rss.Queues[QueueId];
 }
 
+_IRQL_requires_(DISPATCH_LEVEL)
+static
+BOOLEAN
+XdpGenericRssSoftwareHash(
+    _In_ const XDP_LWF_GENERIC_INDIRECTION_TABLE *IndirectionTable,
+    _In_ NET_BUFFER_LIST *NetBufferList,
+    _Out_ UINT32 *RssHash
+    )
+{
+    NET_BUFFER *NetBuffer = NET_BUFFER_LIST_FIRST_NB(NetBufferList);
+    UCHAR Storage[RSS_MAX_HASH_HEADER_LENGTH];
+    UCHAR Input[XDP_TOEPLITZ_MAX_INPUT_SIZE];
+    UINT32 InputLength;
+    const UCHAR *Headers;
+    UINT32 HeadersLength = min(NetBuffer->DataLength, sizeof(Storage));
+    const ETHERNET_HEADER UNALIGNED *Ethernet;
+    UINT32 Layer4Offset;
+    BOOLEAN HashPorts;
+    BOOLEAN HashAddresses;
+    ULONG HashType = IndirectionTable->HashType;
+
+    //
+    // Compute the RSS hash as the NIC would: over the address pair, followed by
+    // the port pair if the transport's hash type is enabled.
+    //
+    // Frames with an in-band VLAN tag are not hashed; miniports normally strip
+    // the tag into the NBL's 802.1Q info. IPv6 extension headers are not
+    // parsed, so such frames are hashed over their addresses only.
+    //
+
+    if (HeadersLength < sizeof(*Ethernet)) {
+        return FALSE;
+    }
+
+    Headers = NdisGetDataBuffer(NetBuffer, HeadersLength, Storage, 1, 0);
+    if (Headers == NULL) {
+        return FALSE;
+    }
+
+    Ethernet = (const ETHERNET_HEADER UNALIGNED *)Headers;
+
+    switch (Ethernet->Type) {
+    case CONST_HTONS(ETHERNET_TYPE_IPV4):
+    {
+        const IPV4_HEADER UNALIGNED *Ipv4 = (const IPV4_HEADER UNALIGNED *)(Ethernet + 1);
+
+        if (HeadersLength < sizeof(*Ethernet) + sizeof(*Ipv4) ||
+            Ipv4->Version != IPV4_VERSION) {
+            return FALSE;
+        }
+
+        RtlCopyMemory(Input, &Ipv4->SourceAddress, sizeof(Ipv4->SourceAddress));
+        RtlCopyMemory(
+            Input + sizeof(Ipv4->SourceAddress), &Ipv4->DestinationAddress,
+            sizeof(Ipv4->DestinationAddress));
+        InputLength = sizeof(Ipv4->SourceAddress) + sizeof(Ipv4->DestinationAddress);
+        Layer4Offset = sizeof(*Ethernet) + (((UINT32)Ipv4->HeaderLength) << 2);
+        HashAddresses = !!(HashType & NDIS_HASH_IPV4);
+        HashPorts =
+            (Ipv4->FlagsAndOffset & RSS_IPV4_FRAGMENT_MASK) == 0 &&
+            ((Ipv4->Protocol == IPPROTO_TCP && (HashType & NDIS_HASH_TCP_IPV4)) ||
+                (Ipv4->Protocol == IPPROTO_UDP && (HashType & NDIS_HASH_UDP_IPV4)));
+        break;
+    }
+    case CONST_HTONS(ETHERNET_TYPE_IPV6):
+    {
+        const IPV6_HEADER UNALIGNED *Ipv6 = (const IPV6_HEADER UNALIGNED *)(Ethernet + 1);
+
+        if (HeadersLength < sizeof(*Ethernet) + sizeof(*Ipv6)) {
+            return FALSE;
+        }
+
+        RtlCopyMemory(Input, &Ipv6->SourceAddress, sizeof(Ipv6->SourceAddress));
+        RtlCopyMemory(
+            Input + sizeof(Ipv6->SourceAddress), &Ipv6->DestinationAddress,
+            sizeof(Ipv6->DestinationAddress));
+        InputLength = sizeof(Ipv6->SourceAddress) + sizeof(Ipv6->DestinationAddress);
+        Layer4Offset = sizeof(*Ethernet) + sizeof(*Ipv6);
+        HashAddresses = !!(HashType & (NDIS_HASH_IPV6 | NDIS_HASH_IPV6_EX));
+        HashPorts =
+            (Ipv6->NextHeader == IPPROTO_TCP &&
+                (HashType & (NDIS_HASH_TCP_IPV6 | NDIS_HASH_TCP_IPV6_EX))) ||
+            (Ipv6->NextHeader == IPPROTO_UDP &&
+                (HashType & (NDIS_HASH_UDP_IPV6 | NDIS_HASH_UDP_IPV6_EX)));
+        break;
+    }
+    default:
+        return FALSE;
+    }
+
+    if (HashPorts && HeadersLength >= Layer4Offset + 2 * sizeof(UINT16)) {
+        RtlCopyMemory(Input + InputLength, Headers + Layer4Offset, 2 * sizeof(UINT16));
+        InputLength += 2 * sizeof(UINT16);
+    } else if (!HashAddresses) {
+        return FALSE;
+    }
+
+    *RssHash = XdpToeplitzHash(IndirectionTable->Toeplitz, Input, InputLength);
+    return TRUE;
+}
+
 _IRQL_requires_(DISPATCH_LEVEL)
 XDP_LWF_GENERIC_RSS_QUEUE *
 XdpGenericRssGetQueue(
     _In_ XDP_LWF_GENERIC *Generic,
     _In_ ULONG CurrentProcessor,
     _In_ BOOLEAN TxInspect,
-    _In_ UINT32 RssHash
+    _In_ NET_BUFFER_LIST *NetBufferList
     )
 {
     XDP_LWF_GENERIC_RSS *Rss = &Generic->Rss;
@@ -276,47 +478,45 @@ XdpGenericRssGetQueue(
     RSS_INDIRECTION_ENTRY *IndirectionEntry;
     UINT32 IndirectionIndex;
     XDP_LWF_GENERIC_RSS_QUEUE *Queue;
+    UINT32 RssHash = NET_BUFFER_LIST_GET_HASH_VALUE(NetBufferList);
 
     IndirectionTable = ReadPointerNoFence(&Rss->IndirectionTable);
     Queues = ReadPointerNoFence(&Rss->Queues);
 
     if (IndirectionTable == NULL || Queues == NULL) {
         return NULL;
-    } else if (RssHash == 0 && IndirectionTable->IndirectionMask > 0 && !TxInspect) {
-        Queue = NULL;
+    }
 
+    if (RssHash == 0 && IndirectionTable->IndirectionMask > 0 &&
+        (IndirectionTable->Toeplitz == NULL ||
+            !XdpGenericRssSoftwareHash(IndirectionTable, NetBufferList, &RssHash)) &&
+        !TxInspect) {
         //
         // Some NIC vendors support RSS, but do not fill out the hash OOB fields.
-        // In this case, infer the queue from the current processor. For TX
-        // inspect, do not use the current CPU to infer the RSS queue ID since
-        // the NDIS send path is not RSS-affinitized.
+        // If the hash cannot be computed in software, infer the queue from the
+        // current processor. For TX inspect, do not use the current CPU to
+        // infer the RSS queue ID since the NDIS send path is not
+        // RSS-affinitized.
         //
-        // TODO: Optimize with (CPU -> queue) index.
+        // The (processor -> queue) index is published with the indirection
+        // table, so it is always consistent with the queue affinities.
+        // Processors not in the table map to queue 0.
         //
-        for (IndirectionIndex = 0;
-            IndirectionIndex <= IndirectionTable->IndirectionMask;
-            IndirectionIndex++) {
-            IndirectionEntry = &IndirectionTable->Entries[IndirectionIndex];
-            Queue = &Queues[IndirectionEntry->QueueIndex];
-            if (Queue->IdealProcessor == CurrentProcessor) {
-                return Queue;
-            }
+        if (CurrentProcessor < IndirectionTable->ProcessorCount) {
+            return &Queues[IndirectionTable->ProcessorQueues[CurrentProcessor]];
         }
 
-        //
-        // Assign to queue at index 0 if appropriate queue was not found.
-        //
         return &Queues[0];
-    } else {
-        //
-        // Normal case where RSS is supported and hash OOB is filled out.
-        //
-        IndirectionIndex = RssHash & IndirectionTable->IndirectionMask;
-        IndirectionEntry = &IndirectionTable->Entries[IndirectionIndex];
-        Queue = &Queues[IndirectionEntry->QueueIndex];
-
-        return Queue;
     }
+
+    //
+    // Normal case where RSS is supported and the hash is known.
+    //
+    IndirectionIndex = RssHash & IndirectionTable->IndirectionMask;
+    IndirectionEntry = &IndirectionTable->Entries[IndirectionIndex];
+    Queue = &Queues[IndirectionEntry->QueueIndex];
+
+    return Queue;
 }
 
 NDIS_STATUS
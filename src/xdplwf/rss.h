@@ -24,6 +24,19 @@ typedef struct _RSS_INDIRECTION_ENTRY {
 
 typedef struct _XDP_LWF_GENERIC_INDIRECTION_TABLE {
     ULONG IndirectionMask;
+    //
+    // Maps each processor index to the queue index affinitized to it, for
+    // NICs that do not indicate an RSS hash. Stored after the entries.
+    //
+    ULONG ProcessorCount;
+    UINT32 *ProcessorQueues;
+    //
+    // The NDIS hash types and precomputed secret key used to hash frames in
+    // software when the NIC does not indicate an RSS hash. Toeplitz is NULL
+    // if software hashing is unavailable.
+    //
+    ULONG HashType;
+    XDP_TOEPLITZ_TABLE *Toeplitz;
     XDP_LIFETIME_ENTRY DeleteEntry;
     RSS_INDIRECTION_ENTRY Entries[0];
 } XDP_LWF_GENERIC_INDIRECTION_TABLE;
@@ -52,7 +65,7 @@ XdpGenericRssGetQueue(
     _In_ XDP_LWF_GENERIC *Generic,
     _In_ ULONG CurrentProcessor,
     _In_ BOOLEAN TxInspect,
-    _In_ UINT32 RssHash
+    _In_ NET_BUFFER_LIST *NetBufferList
     );
 
 NDIS_STATUS
@@ -9,6 +9,22 @@
 #define MAX_TX_BUFFER_LENGTH 65536
 #define DEFAULT_TX_FRAME_COUNT 32
 #define MAX_TX_FRAME_COUNT 8096
+#define MAX_TX_MDL_CACHE_SIZE 4096
+
+//
+// Segmentation offload replicates the Ethernet, IP, and TCP or UDP headers
+// onto each segment. IPv4 headers may include options.
+//
+#define MAX_TX_GSO_HEADER_SIZE \
+    (sizeof(ETHERNET_HEADER) + (0xF * sizeof(UINT32)) + TH_MAX_LEN)
+#define MAX_TX_GSO_SOFTWARE_SEGMENTS 256
+
+//
+// The number of pages spanned by a cached partial MDL. Cached MDLs start on a
+// page boundary, so they may span one page beyond the largest TX buffer.
+//
+#define TX_MDL_CACHE_PAGES \
+    ADDRESS_AND_SIZE_TO_SPAN_PAGES(PAGE_SIZE - 1, MAX_TX_BUFFER_LENGTH)
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
 VOID
@@ -34,6 +50,22 @@ typedef struct _NBL_TX_CONTEXT {
     XDP_LWF_GENERIC_INJECTION_TYPE InjectionType;
     UINT64 BufferAddress;
     XDP_TX_FRAME_COMPLETION_CONTEXT CompletionContext;
+    XDP_LWF_GENERIC_TX_MDL *CachedMdl;
+
+    //
+    // Frames segmented in software are sent as one NBL per segment. Every
+    // segment references the frame's first NBL, which completes the frame
+    // after all of its segments have completed.
+    //
+    NET_BUFFER_LIST *GsoFrameNbl;
+    UINT32 GsoSegmentsOutstanding;
+    NDIS_STATUS GsoStatus;
+
+    struct {
+        UINT16 HeaderPadding; // Aligns L3+ headers to 4 bytes after the Ethernet header.
+        UCHAR Headers[MAX_TX_GSO_HEADER_SIZE];
+        DEFINE_MDL_AND_PFNS(HeaderMdl, MAX_TX_GSO_HEADER_SIZE);
+    } Gso;
 } NBL_TX_CONTEXT;
 
 C_ASSERT(
@@ -42,6 +74,9 @@ C_ASSERT(
 C_ASSERT(
     FIELD_OFFSET(NBL_TX_CONTEXT, InjectionType) ==
     FIELD_OFFSET(XDP_LWF_GENERIC_INJECTION_CONTEXT, InjectionType));
+C_ASSERT(
+   (FIELD_OFFSET(NBL_TX_CONTEXT, Gso.Headers) + sizeof(ETHERNET_HEADER)) %
+        TYPE_ALIGNMENT(UINT32) == 0);
 
 static
 NBL_TX_CONTEXT *
@@ -56,6 +91,56 @@ NblTxContext(
     return (NBL_TX_CONTEXT *)NET_BUFFER_LIST_CONTEXT_DATA_START(NetBufferList);
 }
 
+static
+MDL *
+NblTxMdl(
+    _In_ NET_BUFFER_LIST *NetBufferList
+    )
+{
+    return (MDL *)(NET_BUFFER_LIST_CONTEXT_DATA_START(NetBufferList) + sizeof(NBL_TX_CONTEXT));
+}
+
+static
+NET_BUFFER_LIST *
+XdpGenericTxAllocateNbl(
+    _In_ XDP_LWF_GENERIC_TX_QUEUE *TxQueue
+    )
+{
+    NET_BUFFER_LIST *Nbl;
+    NBL_TX_CONTEXT *Context;
+    NET_BUFFER *Nb;
+    MDL *Mdl;
+
+    Nbl = NdisAllocateNetBufferList(TxQueue->NblPool, TxQueue->NblContextSize, 0);
+    if (Nbl == NULL) {
+        return NULL;
+    }
+
+    Nbl->SourceHandle = TxQueue->NdisFilterHandle;
+    Mdl = NblTxMdl(Nbl);
+    MmInitializeMdl(Mdl, (VOID *)(PAGE_SIZE - 1), MAX_TX_BUFFER_LENGTH);
+    Nb = NET_BUFFER_LIST_FIRST_NB(Nbl);
+    NET_BUFFER_FIRST_MDL(Nb) = Mdl;
+    NET_BUFFER_CURRENT_MDL(Nb) = Mdl;
+
+    Context = NblTxContext(Nbl);
+    MmInitializeMdl(&Context->Gso.HeaderMdl, Context->Gso.Headers, sizeof(Context->Gso.Headers));
+    MmBuildMdlForNonPagedPool(&Context->Gso.HeaderMdl);
+
+    return Nbl;
+}
+
+static
+VOID
+XdpGenericTxClearOffloadInfo(
+    _Inout_ NET_BUFFER_LIST *Nbl
+    )
+{
+    NET_BUFFER_LIST_INFO(Nbl, TcpIpChecksumNetBufferListInfo) = NULL;
+    NET_BUFFER_LIST_INFO(Nbl, TcpLargeSendNetBufferListInfo) = NULL;
+    NET_BUFFER_LIST_INFO(Nbl, UdpSegmentationOffloadInfo) = NULL;
+}
+
 VOID
 XdpGenericSendInjectComplete(
     _In_ VOID *ClassificationResult,
@@ -150,6 +235,82 @@ XdpGenericTxGetNbls(
     return TxQueue->FrameCount - TxQueue->OutstandingCount;
 }
 
+static
+XDP_LWF_GENERIC_TX_MDL *
+XdpGenericTxGetCachedMdl(
+    _In_ XDP_LWF_GENERIC_TX_QUEUE *TxQueue,
+    _In_ const XDP_BUFFER *Buffer,
+    _In_ const XDP_BUFFER_MDL *BufferMdl
+    )
+{
+    MDL *SourceMdl = BufferMdl->Mdl;
+    SIZE_T DataOffset = BufferMdl->MdlOffset + Buffer->DataOffset;
+    SIZE_T PageIndex = (MmGetMdlByteOffset(SourceMdl) + DataOffset) >> PAGE_SHIFT;
+    SIZE_T SourceOffset;
+    XDP_LWF_GENERIC_TX_MDL *CachedMdl;
+
+    //
+    // Each cached MDL describes the source MDL from the start of the page
+    // containing the frame data, so every chunk within a page shares an entry.
+    // The first page of the source MDL may not be page aligned.
+    //
+    SourceOffset =
+        (PageIndex == 0) ? 0 : (PageIndex << PAGE_SHIFT) - MmGetMdlByteOffset(SourceMdl);
+    CachedMdl = &TxQueue->MdlCache[PageIndex & TxQueue->MdlCacheMask];
+
+    if (CachedMdl->SourceMdl != SourceMdl ||
+        CachedMdl->SourceSystemVa != SourceMdl->MappedSystemVa ||
+        CachedMdl->SourceOffset != SourceOffset) {
+        UCHAR *VirtualAddress;
+        SIZE_T Length;
+
+        //
+        // The entry describes another page, and it cannot be rebuilt until
+        // every frame referencing it has completed.
+        //
+        if (CachedMdl->OutstandingCount > 0) {
+            return NULL;
+        }
+
+        VirtualAddress = (UCHAR *)MmGetMdlVirtualAddress(SourceMdl) + SourceOffset;
+        Length =
+            min(MmGetMdlByteCount(SourceMdl) - SourceOffset,
+                TX_MDL_CACHE_PAGES * PAGE_SIZE - BYTE_OFFSET(VirtualAddress));
+        IoBuildPartialMdl(SourceMdl, CachedMdl->Mdl, VirtualAddress, (ULONG)Length);
+        // work around KDNIC bug: it touches the user StartVa in a system context.
+        CachedMdl->Mdl->StartVa =
+            (UCHAR *)CachedMdl->Mdl->MappedSystemVa - CachedMdl->Mdl->ByteOffset;
+        CachedMdl->SourceMdl = SourceMdl;
+        CachedMdl->SourceSystemVa = SourceMdl->MappedSystemVa;
+        CachedMdl->SourceOffset = SourceOffset;
+    }
+
+    ASSERT(
+        DataOffset - SourceOffset + Buffer->DataLength <=
+            MmGetMdlByteCount(CachedMdl->Mdl));
+
+    CachedMdl->OutstandingCount++;
+
+    return CachedMdl;
+}
+
+static
+VOID
+XdpGenericTxInvalidateMdlCache(
+    _In_ XDP_LWF_GENERIC_TX_QUEUE *TxQueue
+    )
+{
+    //
+    // A UMEM MDL may be freed once its datapath client is removed, and a new
+    // MDL can reuse both its address and its system VA. Forget every source
+    // so entries are rebuilt on next use; entries still referenced by
+    // outstanding frames are rebuilt only after those frames complete.
+    //
+    for (ULONG i = 0; i <= TxQueue->MdlCacheMask; i++) {
+        TxQueue->MdlCache[i].SourceMdl = NULL;
+    }
+}
+
 VOID
 XdpGenericBuildTxNbl(
     _In_ XDP_LWF_GENERIC_TX_QUEUE *TxQueue,
@@ -160,23 +321,55 @@ XdpGenericBuildTxNbl(
     )
 {
     NET_BUFFER *Nb = NET_BUFFER_LIST_FIRST_NB(Nbl);
-    MDL *Mdl = NET_BUFFER_FIRST_MDL(Nb);
-    IoBuildPartialMdl(
-        BufferMdl->Mdl, Mdl,
-        (UCHAR *)MmGetMdlVirtualAddress(BufferMdl->Mdl)
-            + BufferMdl->MdlOffset
-            + Buffer->DataOffset,
-        Buffer->DataLength);
-    // work around KDNIC bug: it touches the user StartVa in a system context.
-    Mdl->StartVa = (UCHAR *)Mdl->MappedSystemVa - Mdl->ByteOffset;
+    XDP_LWF_GENERIC_TX_MDL *CachedMdl = NULL;
+    MDL *Mdl;
+    UINT32 MdlOffset;
+    const UCHAR *FrameData;
+
+    if (TxQueue->MdlCache != NULL) {
+        CachedMdl = XdpGenericTxGetCachedMdl(TxQueue, Buffer, BufferMdl);
+    }
+
+    if (CachedMdl != NULL) {
+        //
+        // Reuse the cached partial MDL: only the NB offset and length change.
+        //
+        Mdl = CachedMdl->Mdl;
+        MdlOffset =
+            (UINT32)(BufferMdl->MdlOffset + Buffer->DataOffset - CachedMdl->SourceOffset);
+    } else {
+        Mdl = NblTxMdl(Nbl);
+        IoBuildPartialMdl(
+            BufferMdl->Mdl, Mdl,
+            (UCHAR *)MmGetMdlVirtualAddress(BufferMdl->Mdl)
+                + BufferMdl->MdlOffset
+                + Buffer->DataOffset,
+            Buffer->DataLength);
+        // work around KDNIC bug: it touches the user StartVa in a system context.
+        Mdl->StartVa = (UCHAR *)Mdl->MappedSystemVa - Mdl->ByteOffset;
+        MdlOffset = 0;
+    }
+
+    FrameData = RTL_PTR_ADD(Mdl->MappedSystemVa, MdlOffset);
+    NET_BUFFER_FIRST_MDL(Nb) = Mdl;
+    NET_BUFFER_CURRENT_MDL(Nb) = Mdl;
     NET_BUFFER_DATA_LENGTH(Nb) = Buffer->DataLength;
-    NET_BUFFER_DATA_OFFSET(Nb) = 0;
-    NET_BUFFER_CURRENT_MDL_OFFSET(Nb) = 0;
+    NET_BUFFER_DATA_OFFSET(Nb) = MdlOffset;
+    NET_BUFFER_CURRENT_MDL_OFFSET(Nb) = MdlOffset;
     NET_BUFFER_LIST_SET_HASH_VALUE(Nbl, TxQueue->RssQueue->RssHash);
     NET_BUFFER_LIST_STATUS(Nbl) = NDIS_STATUS_SUCCESS;
     NblTxContext(Nbl)->TxQueue = TxQueue;
     NblTxContext(Nbl)->InjectionType = XDP_LWF_GENERIC_INJECTION_SEND;
     NblTxContext(Nbl)->BufferAddress = BufferMdl->MdlOffset;
+    NblTxContext(Nbl)->CachedMdl = CachedMdl;
+    NblTxContext(Nbl)->GsoFrameNbl = NULL;
+
+    if (TxQueue->Flags.GsoEnabled) {
+        //
+        // NBLs may have carried segmentation offload OOBs for prior frames.
+        //
+        XdpGenericTxClearOffloadInfo(Nbl);
+    }
 
     if (TxQueue->Flags.ChecksumOffloadEnabled) {
         NDIS_TCP_IP_CHECKSUM_NET_BUFFER_LIST_INFO *ChecksumInfo =
@@ -208,7 +401,7 @@ XdpGenericBuildTxNbl(
             case XdpFrameLayer3TypeIPv4NoOptions:
             case XdpFrameLayer3TypeIPv4UnspecifiedOptions:
             case XdpFrameLayer3TypeIPv4WithOptions:
-                const IPV4_HEADER *Ipv4 = RTL_PTR_ADD(Mdl->MappedSystemVa, sizeof(ETHERNET_HEADER));
+                const IPV4_HEADER *Ipv4 = RTL_PTR_ADD(FrameData, sizeof(ETHERNET_HEADER));
 
                 if (Buffer->DataLength < sizeof(ETHERNET_HEADER) + sizeof(*Ipv4) ||
                     Ipv4->Version != IPV4_VERSION ||
@@ -224,7 +417,7 @@ XdpGenericBuildTxNbl(
                 break;
 
             case XdpFrameLayer3TypeIPv6NoExtensions:
-                const IPV6_HEADER *Ipv6 = RTL_PTR_ADD(Mdl->MappedSystemVa, sizeof(ETHERNET_HEADER));
+                const IPV6_HEADER *Ipv6 = RTL_PTR_ADD(FrameData, sizeof(ETHERNET_HEADER));
 
                 if (Buffer->DataLength < sizeof(ETHERNET_HEADER) + sizeof(*Ipv6) ||
                     Ipv6->Version != (IPV6_VERSION >> 4) ||
@@ -257,7 +450,7 @@ XdpGenericBuildTxNbl(
         if (FrameChecksum->Layer4 == XdpFrameTxChecksumActionRequired) {
             const UINT32 Layer4HeaderOffset =
                 FrameLayout->Layer2HeaderLength + FrameLayout->Layer3HeaderLength;
-            const VOID *Layer4Header = RTL_PTR_ADD(Mdl->MappedSystemVa, Layer4HeaderOffset);
+            const VOID *Layer4Header = RTL_PTR_ADD(FrameData, Layer4HeaderOffset);
 
             switch (FrameLayout->Layer4Type) {
             case XdpFrameLayer4TypeTcp:
@@ -316,6 +509,452 @@ InvalidOffload:
     }
 }
 
+//
+// Parameters shared by every segment of a frame requesting segmentation
+// offload. The headers are validated from a private copy, since the frame
+// buffer may be modified by the application at any time.
+//
+typedef struct _XDP_LWF_GENERIC_TX_GSO {
+    MDL *SourceMdl;
+    UCHAR *PayloadVa;
+    const UCHAR *Headers;
+    UINT32 HeaderLength;
+    UINT32 Layer4HeaderOffset;
+    UINT32 PayloadLength;
+    UINT32 Mss;
+    BOOLEAN IsIpv4;
+    BOOLEAN IsTcp;
+    UINT16 IpId;
+    UINT8 TcpFlags;
+    UINT32 TcpSeq;
+    UINT32 PseudoHeaderChecksum;
+} XDP_LWF_GENERIC_TX_GSO;
+
+static
+VOID
+XdpGenericTxBuildGsoSegmentNb(
+    _In_ const XDP_LWF_GENERIC_TX_GSO *Gso,
+    _In_ UINT32 PayloadOffset,
+    _In_ UINT32 PayloadLength,
+    _Inout_ NET_BUFFER_LIST *Nbl
+    )
+{
+    NBL_TX_CONTEXT *Context = NblTxContext(Nbl);
+    NET_BUFFER *Nb = NET_BUFFER_LIST_FIRST_NB(Nbl);
+    MDL *HeaderMdl = &Context->Gso.HeaderMdl;
+    MDL *PayloadMdl = NblTxMdl(Nbl);
+
+    if (Context->Gso.Headers != Gso->Headers) {
+        RtlCopyMemory(Context->Gso.Headers, Gso->Headers, Gso->HeaderLength);
+    }
+
+    HeaderMdl->ByteCount = Gso->HeaderLength;
+    HeaderMdl->Next = NULL;
+
+    if (PayloadLength > 0) {
+        IoBuildPartialMdl(
+            Gso->SourceMdl, PayloadMdl, Gso->PayloadVa + PayloadOffset, PayloadLength);
+        // work around KDNIC bug: it touches the user StartVa in a system context.
+        PayloadMdl->StartVa = (UCHAR *)PayloadMdl->MappedSystemVa - PayloadMdl->ByteOffset;
+        HeaderMdl->Next = PayloadMdl;
+    }
+
+    NET_BUFFER_FIRST_MDL(Nb) = HeaderMdl;
+    NET_BUFFER_CURRENT_MDL(Nb) = HeaderMdl;
+    NET_BUFFER_DATA_LENGTH(Nb) = Gso->HeaderLength + PayloadLength;
+    NET_BUFFER_DATA_OFFSET(Nb) = 0;
+    NET_BUFFER_CURRENT_MDL_OFFSET(Nb) = 0;
+}
+
+static
+VOID
+XdpGenericTxFixupGsoSegment(
+    _In_ const XDP_LWF_GENERIC_TX_GSO *Gso,
+    _In_ UINT32 SegmentIndex,
+    _In_ UINT32 PayloadLength,
+    _In_ BOOLEAN IsLastSegment,
+    _In_ BOOLEAN HardwareChecksum,
+    _Inout_ NET_BUFFER_LIST *Nbl
+    )
+{
+    NDIS_TCP_IP_CHECKSUM_NET_BUFFER_LIST_INFO *ChecksumInfo =
+        (NDIS_TCP_IP_CHECKSUM_NET_BUFFER_LIST_INFO *)
+            &NET_BUFFER_LIST_INFO(Nbl, TcpIpChecksumNetBufferListInfo);
+    NET_BUFFER *Nb = NET_BUFFER_LIST_FIRST_NB(Nbl);
+    UCHAR *Headers = NblTxContext(Nbl)->Gso.Headers;
+    const UINT32 Layer3HeaderLength = Gso->Layer4HeaderOffset - sizeof(ETHERNET_HEADER);
+    const UINT32 Layer4Length = Gso->HeaderLength - Gso->Layer4HeaderOffset + PayloadLength;
+    UINT16 *Layer4Checksum;
+
+    ChecksumInfo->Value = 0;
+
+    if (Gso->IsIpv4) {
+        IPV4_HEADER *Ipv4 = RTL_PTR_ADD(Headers, sizeof(ETHERNET_HEADER));
+
+        Ipv4->TotalLength = htons((UINT16)(Layer3HeaderLength + Layer4Length));
+        Ipv4->Identification = htons((UINT16)(Gso->IpId + SegmentIndex));
+        Ipv4->HeaderChecksum = 0;
+        ChecksumInfo->Transmit.IsIPv4 = TRUE;
+        ChecksumInfo->Transmit.IpHeaderChecksum = TRUE;
+    } else {
+        IPV6_HEADER *Ipv6 = RTL_PTR_ADD(Headers, sizeof(ETHERNET_HEADER));
+
+        Ipv6->PayloadLength = htons((UINT16)Layer4Length);
+        ChecksumInfo->Transmit.IsIPv6 = TRUE;
+    }
+
+    if (Gso->IsTcp) {
+        TCP_HDR *Tcp = RTL_PTR_ADD(Headers, Gso->Layer4HeaderOffset);
+
+        Tcp->th_seq = htonl(Gso->TcpSeq + SegmentIndex * Gso->Mss);
+        Tcp->th_flags =
+            IsLastSegment ? Gso->TcpFlags : (Gso->TcpFlags & ~(TH_FIN | TH_PSH));
+        Layer4Checksum = &Tcp->th_sum;
+        ChecksumInfo->Transmit.TcpChecksum = TRUE;
+        ChecksumInfo->Transmit.TcpHeaderOffset = Gso->Layer4HeaderOffset;
+    } else {
+        UDP_HDR *Udp = RTL_PTR_ADD(Headers, Gso->Layer4HeaderOffset);
+
+        Udp->uh_ulen = htons((UINT16)Layer4Length);
+        Layer4Checksum = &Udp->uh_sum;
+        ChecksumInfo->Transmit.UdpChecksum = TRUE;
+    }
+
+    *Layer4Checksum =
+        XdpChecksumFold(Gso->PseudoHeaderChecksum + htons((UINT16)Layer4Length));
+
+    if (!HardwareChecksum) {
+        if (Gso->IsIpv4) {
+            IPV4_HEADER *Ipv4 = RTL_PTR_ADD(Headers, sizeof(ETHERNET_HEADER));
+
+            Ipv4->HeaderChecksum =
+                XdpOffloadChecksumNb(Nb, Layer3HeaderLength, sizeof(ETHERNET_HEADER));
+        }
+
+        *Layer4Checksum = XdpOffloadChecksumNb(Nb, Layer4Length, Gso->Layer4HeaderOffset);
+        ChecksumInfo->Value = 0;
+    }
+}
+
+//
+// Builds the NBLs for a frame requesting segmentation offload. If the NIC
+// supports LSO or USO for the frame, a single NBL is sent with the offload
+// OOB; otherwise the frame is segmented in software into one NBL per segment.
+// Returns FALSE if the frame is invalid or cannot be segmented due to
+// insufficient resources; the caller retains the frame's NBL.
+//
+static
+_IRQL_requires_(DISPATCH_LEVEL)
+BOOLEAN
+XdpGenericBuildTxGsoNbls(
+    _In_ XDP_LWF_GENERIC_TX_QUEUE *TxQueue,
+    _In_ XDP_FRAME *Frame,
+    _In_ XDP_BUFFER *Buffer,
+    _In_ XDP_BUFFER_MDL *BufferMdl,
+    _Inout_ NET_BUFFER_LIST *Nbl,
+    _Inout_ NBL_COUNTED_QUEUE *Nbls
+    )
+{
+    const XDP_FRAME_LAYOUT *FrameLayout =
+        XdpGetLayoutExtension(Frame, &TxQueue->FrameLayoutExtension);
+    const XDP_LWF_OFFLOAD_SETTING_TASK_OFFLOAD *TaskOffload =
+        ReadPointerNoFence(&TxQueue->Generic->Filter->Offload.LowerEdge.TaskOffload);
+    NBL_TX_CONTEXT *FrameContext = NblTxContext(Nbl);
+    const UCHAR *FrameData;
+    XDP_LWF_GENERIC_TX_GSO Gso;
+    NET_BUFFER_LIST *SegmentNbl;
+    NET_BUFFER_LIST *SegmentTail;
+    UINT32 SegmentCount;
+    UINT8 IpProtocol = 0;
+    const UCHAR *IpSrc = NULL;
+    const UCHAR *IpDst = NULL;
+    UINT32 IpAddressLength = 0;
+    BOOLEAN UseHardware = FALSE;
+    BOOLEAN HardwareChecksum;
+
+    NET_BUFFER_LIST_SET_HASH_VALUE(Nbl, TxQueue->RssQueue->RssHash);
+    NET_BUFFER_LIST_STATUS(Nbl) = NDIS_STATUS_SUCCESS;
+    XdpGenericTxClearOffloadInfo(Nbl);
+    FrameContext->TxQueue = TxQueue;
+    FrameContext->InjectionType = XDP_LWF_GENERIC_INJECTION_SEND;
+    FrameContext->BufferAddress = BufferMdl->MdlOffset;
+    FrameContext->CachedMdl = NULL;
+    FrameContext->GsoFrameNbl = NULL;
+
+    if (TxQueue->Flags.TxCompletionContextEnabled) {
+        FrameContext->CompletionContext =
+            *XdpGetFrameTxCompletionContextExtension(
+                Frame, &TxQueue->FrameTxCompletionContextExtension);
+    }
+
+    RtlZeroMemory(&Gso, sizeof(Gso));
+    Gso.Mss = XdpGetGsoExtension(Frame, &TxQueue->FrameGsoExtension)->TCP.Mss;
+    Gso.Layer4HeaderOffset = FrameLayout->Layer2HeaderLength + FrameLayout->Layer3HeaderLength;
+    Gso.HeaderLength = Gso.Layer4HeaderOffset + FrameLayout->Layer4HeaderLength;
+    Gso.Headers = FrameContext->Gso.Headers;
+    Gso.SourceMdl = BufferMdl->Mdl;
+
+    ASSERT(Gso.Mss > 0);
+
+    if (FrameLayout->Layer2Type != XdpFrameLayer2TypeEthernet ||
+        FrameLayout->Layer2HeaderLength != sizeof(ETHERNET_HEADER) ||
+        Gso.HeaderLength > sizeof(FrameContext->Gso.Headers) ||
+        Gso.HeaderLength > Buffer->DataLength) {
+        goto Drop;
+    }
+
+    FrameData =
+        RTL_PTR_ADD(
+            BufferMdl->Mdl->MappedSystemVa, BufferMdl->MdlOffset + Buffer->DataOffset);
+    RtlCopyVolatileMemory(FrameContext->Gso.Headers, FrameData, Gso.HeaderLength);
+
+    switch (FrameLayout->Layer3Type) {
+    case XdpFrameLayer3TypeIPv4NoOptions:
+    case XdpFrameLayer3TypeIPv4UnspecifiedOptions:
+    case XdpFrameLayer3TypeIPv4WithOptions:
+        const IPV4_HEADER *Ipv4 = RTL_PTR_ADD(Gso.Headers, sizeof(ETHERNET_HEADER));
+
+        if (FrameLayout->Layer3HeaderLength < sizeof(*Ipv4) ||
+            Ipv4->Version != IPV4_VERSION ||
+            FrameLayout->Layer3HeaderLength != (Ipv4->HeaderLength << 2)) {
+            goto Drop;
+        }
+
+        Gso.IsIpv4 = TRUE;
+        Gso.IpId = ntohs(Ipv4->Identification);
+        IpProtocol = Ipv4->Protocol;
+        IpSrc = (const UCHAR *)&Ipv4->SourceAddress;
+        IpDst = (const UCHAR *)&Ipv4->DestinationAddress;
+        IpAddressLength = sizeof(IN_ADDR);
+        break;
+
+    case XdpFrameLayer3TypeIPv6NoExtensions:
+        const IPV6_HEADER *Ipv6 = RTL_PTR_ADD(Gso.Headers, sizeof(ETHERNET_HEADER));
+
+        if (FrameLayout->Layer3HeaderLength != sizeof(*Ipv6) ||
+            Ipv6->Version != (IPV6_VERSION >> 4)) {
+            goto Drop;
+        }
+
+        IpProtocol = Ipv6->NextHeader;
+        IpSrc = (const UCHAR *)&Ipv6->SourceAddress;
+        IpDst = (const UCHAR *)&Ipv6->DestinationAddress;
+        IpAddressLength = sizeof(IN6_ADDR);
+        break;
+
+    default:
+        goto Drop;
+    }
+
+    switch (FrameLayout->Layer4Type) {
+    case XdpFrameLayer4TypeTcp:
+        const TCP_HDR *Tcp = RTL_PTR_ADD(Gso.Headers, Gso.Layer4HeaderOffset);
+
+        if (IpProtocol != IPPROTO_TCP ||
+            FrameLayout->Layer4HeaderLength < sizeof(*Tcp) ||
+            FrameLayout->Layer4HeaderLength != (Tcp->th_len << 2)) {
+            goto Drop;
+        }
+
+        Gso.IsTcp = TRUE;
+        Gso.TcpSeq = ntohl(Tcp->th_seq);
+        Gso.TcpFlags = Tcp->th_flags;
+        break;
+
+    case XdpFrameLayer4TypeUdp:
+        if (IpProtocol != IPPROTO_UDP ||
+            FrameLayout->Layer4HeaderLength != sizeof(UDP_HDR)) {
+            goto Drop;
+        }
+        break;
+
+    default:
+        goto Drop;
+    }
+
+    Gso.PayloadLength = Buffer->DataLength - Gso.HeaderLength;
+    Gso.PayloadVa =
+        (UCHAR *)MmGetMdlVirtualAddress(BufferMdl->Mdl) + BufferMdl->MdlOffset +
+            Buffer->DataOffset + Gso.HeaderLength;
+    Gso.PseudoHeaderChecksum =
+        XdpPartialChecksum(IpSrc, IpAddressLength) +
+        XdpPartialChecksum(IpDst, IpAddressLength) +
+        (IpProtocol << 8);
+    SegmentCount = max(1, (Gso.PayloadLength + Gso.Mss - 1) / Gso.Mss);
+
+    //
+    // Every segment must fit within the interface MTU.
+    //
+    if (Gso.HeaderLength + min(Gso.PayloadLength, Gso.Mss) > TxQueue->Generic->Tx.Mtu) {
+        goto Drop;
+    }
+
+    if (!TxQueue->Flags.RxInject && TaskOffload != NULL && SegmentCount > 1) {
+        if (Gso.IsTcp) {
+            //
+            // LSOv2 does not support IPv4 options.
+            //
+            UseHardware =
+                Gso.PayloadLength <= TaskOffload->Lso.MaxOffloadSize &&
+                SegmentCount >= TaskOffload->Lso.MinSegments &&
+                (!Gso.IsIpv4 || FrameLayout->Layer3HeaderLength == sizeof(IPV4_HEADER));
+        } else {
+            UseHardware =
+                Gso.PayloadLength <= TaskOffload->Uso.MaxOffloadSize &&
+                SegmentCount >= TaskOffload->Uso.MinSegments;
+        }
+    }
+
+    if (UseHardware) {
+        UCHAR *Headers = FrameContext->Gso.Headers;
+        UINT16 *Layer4Checksum;
+
+        //
+        // The NIC replicates the headers onto each segment, filling in the
+        // lengths, IP header checksums, and L4 checksums.
+        //
+        if (Gso.IsIpv4) {
+            IPV4_HEADER *TxIpv4 = RTL_PTR_ADD(Headers, sizeof(ETHERNET_HEADER));
+            TxIpv4->TotalLength = 0;
+            TxIpv4->HeaderChecksum = 0;
+        } else {
+            IPV6_HEADER *TxIpv6 = RTL_PTR_ADD(Headers, sizeof(ETHERNET_HEADER));
+            TxIpv6->PayloadLength = 0;
+        }
+
+        if (Gso.IsTcp) {
+            NDIS_TCP_LARGE_SEND_OFFLOAD_NET_BUFFER_LIST_INFO LsoInfo = {0};
+            TCP_HDR *TxTcp = RTL_PTR_ADD(Headers, Gso.Layer4HeaderOffset);
+
+            Layer4Checksum = &TxTcp->th_sum;
+            LsoInfo.LsoV2Transmit.Type = NDIS_TCP_LARGE_SEND_OFFLOAD_V2_TYPE;
+            LsoInfo.LsoV2Transmit.TcpHeaderOffset = Gso.Layer4HeaderOffset;
+            LsoInfo.LsoV2Transmit.MSS = Gso.Mss;
+            LsoInfo.LsoV2Transmit.IPVersion =
+                Gso.IsIpv4 ?
+                    NDIS_TCP_LARGE_SEND_OFFLOAD_IPv4 : NDIS_TCP_LARGE_SEND_OFFLOAD_IPv6;
+            NET_BUFFER_LIST_INFO(Nbl, TcpLargeSendNetBufferListInfo) = LsoInfo.Value;
+        } else {
+            NDIS_UDP_SEGMENTATION_OFFLOAD_NET_BUFFER_LIST_INFO UsoInfo = {0};
+            UDP_HDR *TxUdp = RTL_PTR_ADD(Headers, Gso.Layer4HeaderOffset);
+
+            TxUdp->uh_ulen = 0;
+            Layer4Checksum = &TxUdp->uh_sum;
+            UsoInfo.Transmit.UdpHeaderOffset = Gso.Layer4HeaderOffset;
+            UsoInfo.Transmit.MSS = Gso.Mss;
+            UsoInfo.Transmit.IPVersion =
+                Gso.IsIpv4 ?
+                    NDIS_UDP_SEGMENTATION_OFFLOAD_IPV4 : NDIS_UDP_SEGMENTATION_OFFLOAD_IPV6;
+            NET_BUFFER_LIST_INFO(Nbl, UdpSegmentationOffloadInfo) = UsoInfo.Value;
+        }
+
+        *Layer4Checksum = XdpChecksumFold(Gso.PseudoHeaderChecksum);
+
+        XdpGenericTxBuildGsoSegmentNb(&Gso, 0, Gso.PayloadLength, Nbl);
+        NdisAppendSingleNblToNblCountedQueue(Nbls, Nbl);
+
+        return TRUE;
+    }
+
+    if (SegmentCount > MAX_TX_GSO_SOFTWARE_SEGMENTS) {
+        goto Drop;
+    }
+
+    //
+    // The frame's NBL carries the first segment; allocate the remainder up
+    // front so the frame is either sent in its entirety or not at all.
+    //
+    SegmentTail = Nbl;
+    for (UINT32 Index = 1; Index < SegmentCount; Index++) {
+        SegmentTail->Next = XdpGenericTxAllocateNbl(TxQueue);
+        if (SegmentTail->Next == NULL) {
+            while (Nbl->Next != NULL) {
+                NET_BUFFER_LIST *SegmentNbl = Nbl->Next;
+                Nbl->Next = SegmentNbl->Next;
+                NdisFreeNetBufferList(SegmentNbl);
+            }
+
+            goto Drop;
+        }
+        SegmentTail = SegmentTail->Next;
+    }
+    SegmentTail->Next = NULL;
+
+    HardwareChecksum =
+        !TxQueue->Flags.RxInject && TaskOffload != NULL && TaskOffload->Checksum.Enabled;
+
+    FrameContext->GsoSegmentsOutstanding = SegmentCount;
+    FrameContext->GsoStatus = NDIS_STATUS_SUCCESS;
+
+    SegmentNbl = Nbl;
+    for (UINT32 Index = 0; Index < SegmentCount; Index++) {
+        NET_BUFFER_LIST *NextNbl = SegmentNbl->Next;
+        const UINT32 PayloadOffset = Index * Gso.Mss;
+        const UINT32 PayloadLength = min(Gso.Mss, Gso.PayloadLength - PayloadOffset);
+
+        XdpGenericTxBuildGsoSegmentNb(&Gso, PayloadOffset, PayloadLength, SegmentNbl);
+        XdpGenericTxFixupGsoSegment(
+            &Gso, Index, PayloadLength, Index == SegmentCount - 1, HardwareChecksum,
+            SegmentNbl);
+
+        if (Index > 0) {
+            NBL_TX_CONTEXT *SegmentContext = NblTxContext(SegmentNbl);
+
+            NET_BUFFER_LIST_SET_HASH_VALUE(SegmentNbl, TxQueue->RssQueue->RssHash);
+            NET_BUFFER_LIST_STATUS(SegmentNbl) = NDIS_STATUS_SUCCESS;
+            SegmentContext->TxQueue = TxQueue;
+            SegmentContext->InjectionType = XDP_LWF_GENERIC_INJECTION_SEND;
+            SegmentContext->CachedMdl = NULL;
+        }
+
+        NblTxContext(SegmentNbl)->GsoFrameNbl = Nbl;
+        NdisAppendSingleNblToNblCountedQueue(Nbls, SegmentNbl);
+        SegmentNbl = NextNbl;
+    }
+
+    STAT_INC(&TxQueue->PcwStats, FramesSegmentedSoftware);
+
+    return TRUE;
+
+Drop:
+
+    STAT_INC(&TxQueue->PcwStats, FramesDroppedSegmentationOffload);
+    return FALSE;
+}
+
+static
+_IRQL_requires_(DISPATCH_LEVEL)
+VOID
+XdpGenericTxCompleteFrameInline(
+    _In_ XDP_LWF_GENERIC_TX_QUEUE *TxQueue,
+    _In_ XDP_FRAME *Frame
+    )
+{
+    XDP_RING *CompletionRing = TxQueue->CompletionRing;
+    XDP_BUFFER_MDL *BufferMdl = XdpGetMdlExtension(&Frame->Buffer, &TxQueue->BufferMdlExtension);
+    XDP_TX_FRAME_COMPLETION *Completion;
+
+    ASSERT(XdpRingFree(CompletionRing) > 0);
+    Completion =
+        XdpRingGetElement(
+            CompletionRing, CompletionRing->ProducerIndex++ & CompletionRing->Mask);
+    Completion->BufferAddress = BufferMdl->MdlOffset;
+
+    if (TxQueue->Flags.TxCompletionContextEnabled) {
+        XDP_TX_FRAME_COMPLETION_CONTEXT *FrameCompletionContext =
+            XdpGetFrameTxCompletionContextExtension(
+                Frame, &TxQueue->FrameTxCompletionContextExtension);
+        XDP_TX_FRAME_COMPLETION_CONTEXT *CompletionContext =
+            XdpGetTxCompletionContextExtension(
+                Completion, &TxQueue->TxCompletionContextExtension);
+        *CompletionContext = *FrameCompletionContext;
+    }
+
+    if (XdpRingFree(CompletionRing) == 0) {
+        XdpFlushTransmit(TxQueue->XdpTxQueue);
+    }
+}
+
 VOID
 XdpGenericCompleteTx(
     _In_ XDP_LWF_GENERIC_TX_QUEUE *TxQueue
@@ -336,10 +975,50 @@ XdpGenericCompleteTx(
     while (CompleteList != NULL) {
         NET_BUFFER_LIST *Nbl;
         XDP_TX_FRAME_COMPLETION *Completion;
+        MDL *Mdl;
 
         Nbl = CompleteList;
         CompleteList = CompleteList->Next;
 
+        //
+        // In lieu of calling MmPrepareMdlForReuse, assert our MDL did not get
+        // mapped by the memory manager: the original MDL should have been
+        // mapped by XDP itself, and the partial MDL inherited that mapping,
+        // precluding the need for it to be mapped by itself. Segmentation
+        // offload prepends a nonpaged header MDL, and may omit the payload.
+        //
+        ASSERT(Nbl->FirstNetBuffer->Next == NULL);
+        Mdl = Nbl->FirstNetBuffer->MdlChain;
+        if (Mdl == &NblTxContext(Nbl)->Gso.HeaderMdl) {
+            Mdl = Mdl->Next;
+        }
+        ASSERT(Mdl == NULL || Mdl->Next == NULL);
+        ASSERT(Mdl == NULL || (Mdl->MdlFlags & MDL_PARTIAL));
+        ASSERT(Mdl == NULL || (Mdl->MdlFlags & MDL_PARTIAL_HAS_BEEN_MAPPED) == 0);
+        UNREFERENCED_PARAMETER(Mdl);
+
+        if (NblTxContext(Nbl)->GsoFrameNbl != NULL) {
+            NET_BUFFER_LIST *FrameNbl = NblTxContext(Nbl)->GsoFrameNbl;
+
+            //
+            // Complete the frame once all of its segments have completed.
+            //
+            if (Nbl->Status != NDIS_STATUS_SUCCESS) {
+                NblTxContext(FrameNbl)->GsoStatus = Nbl->Status;
+            }
+
+            if (Nbl != FrameNbl) {
+                NdisFreeNetBufferList(Nbl);
+            }
+
+            if (--NblTxContext(FrameNbl)->GsoSegmentsOutstanding > 0) {
+                continue;
+            }
+
+            Nbl = FrameNbl;
+            Nbl->Status = NblTxContext(Nbl)->GsoStatus;
+        }
+
         Completion = XdpRingGetElement(Ring, Ring->ProducerIndex++ & Ring->Mask);
 
         ASSERT(TxQueue == NblTxContext(Nbl)->TxQueue);
@@ -362,16 +1041,9 @@ XdpGenericCompleteTx(
             Timestamp->Timestamp = NblTimestamp.Timestamp;
         }
 
-        //
-        // In lieu of calling MmPrepareMdlForReuse, assert our MDL did not get
-        // mapped by the memory manager: the original MDL should have been
-        // mapped by XDP itself, and the partial MDL inherited that mapping,
-        // precluding the need for it to be mapped by itself.
-        //
-        ASSERT(Nbl->FirstNetBuffer->Next == NULL);
-        ASSERT(Nbl->FirstNetBuffer->MdlChain->Next == NULL);
-        ASSERT(Nbl->FirstNetBuffer->MdlChain->MdlFlags & MDL_PARTIAL);
-        ASSERT((Nbl->FirstNetBuffer->MdlChain->MdlFlags & MDL_PARTIAL_HAS_BEEN_MAPPED) == 0);
+        if (NblTxContext(Nbl)->CachedMdl != NULL) {
+            NT_VERIFY(NblTxContext(Nbl)->CachedMdl->OutstandingCount-- > 0);
+        }
 
         if (Nbl->Status != NDIS_STATUS_SUCCESS) {
             STAT_INC(&TxQueue->PcwStats, FramesDroppedNic);
@@ -400,6 +1072,7 @@ XdpGenericInitiateTx(
     NBL_COUNTED_QUEUE Nbls;
     XDP_RING *FrameRing;
     ULONG NblsAvailable;
+    ULONG FramesPosted = 0;
 
     if (ReadPointerAcquire(&TxQueue->XdpTxQueue) == NULL) {
         return FALSE;
@@ -422,7 +1095,11 @@ XdpGenericInitiateTx(
 
     NdisInitializeNblCountedQueue(&Nbls);
 
-    while (Nbls.NblCount < NblsAvailable && XdpRingCount(FrameRing) > 0) {
+    //
+    // Each frame consumes exactly one NBL from the free list. Frames segmented
+    // in software allocate additional NBLs for their trailing segments.
+    //
+    while (FramesPosted < NblsAvailable && XdpRingCount(FrameRing) > 0) {
         NET_BUFFER_LIST *Nbl;
         XDP_FRAME *Frame;
         XDP_BUFFER *Buffer;
@@ -434,20 +1111,41 @@ XdpGenericInitiateTx(
 
         Nbl = TxQueue->FreeNbls;
         TxQueue->FreeNbls = TxQueue->FreeNbls->Next;
-        XdpGenericBuildTxNbl(TxQueue, Frame, Buffer, BufferMdl, Nbl);
 
-        NdisAppendSingleNblToNblCountedQueue(&Nbls, Nbl);
+        if (TxQueue->Flags.GsoEnabled &&
+            XdpGetGsoExtension(Frame, &TxQueue->FrameGsoExtension)->TCP.Mss > 0) {
+            if (!XdpGenericBuildTxGsoNbls(TxQueue, Frame, Buffer, BufferMdl, Nbl, &Nbls)) {
+                //
+                // Return the NBL and complete the frame without sending it.
+                //
+                Nbl->Next = TxQueue->FreeNbls;
+                TxQueue->FreeNbls = Nbl;
+                XdpGenericTxCompleteFrameInline(TxQueue, Frame);
+                FrameRing->ConsumerIndex++;
+                continue;
+            }
+        } else {
+            XdpGenericBuildTxNbl(TxQueue, Frame, Buffer, BufferMdl, Nbl);
+            NdisAppendSingleNblToNblCountedQueue(&Nbls, Nbl);
+        }
 
         EventWriteGenericTxEnqueue(
             &MICROSOFT_XDP_PROVIDER, TxQueue, FrameRing->ConsumerIndex,
             TxQueue->Stats.BatchesPosted);
 
         FrameRing->ConsumerIndex++;
+        FramesPosted++;
     }
 
-    ASSERT(Nbls.NblCount > 0);
+    if (XdpRingCount(TxQueue->CompletionRing) > 0) {
+        XdpFlushTransmit(TxQueue->XdpTxQueue);
+    }
+
+    if (FramesPosted == 0) {
+        return XdpRingCount(FrameRing) > 0;
+    }
 
-    TxQueue->OutstandingCount += (ULONG)Nbls.NblCount;
+    TxQueue->OutstandingCount += FramesPosted;
 
     EventWriteGenericTxPostBatchStart(
         &MICROSOFT_XDP_PROVIDER, TxQueue, TxQueue->Stats.BatchesPosted);
@@ -478,7 +1176,6 @@ XdpGenericDropTx(
     )
 {
     XDP_RING *FrameRing;
-    XDP_RING *CompletionRing;
     UINT32 Drops;
     const UINT32 MaxDrops = 1024;
 
@@ -487,7 +1184,6 @@ XdpGenericDropTx(
     }
 
     FrameRing = TxQueue->FrameRing;
-    CompletionRing = TxQueue->CompletionRing;
 
     if (XdpRingCount(FrameRing) == 0) {
         XdpFlushTransmit(TxQueue->XdpTxQueue);
@@ -495,36 +1191,12 @@ XdpGenericDropTx(
 
     for (Drops = 0; XdpRingCount(FrameRing) > 0 && Drops < MaxDrops; Drops++) {
         XDP_FRAME *Frame;
-        XDP_BUFFER *Buffer;
-        XDP_BUFFER_MDL *BufferMdl;
-        XDP_TX_FRAME_COMPLETION *Completion;
 
         Frame = XdpRingGetElement(FrameRing, FrameRing->ConsumerIndex++ & FrameRing->Mask);
-        Buffer = &Frame->Buffer;
-        BufferMdl = XdpGetMdlExtension(Buffer, &TxQueue->BufferMdlExtension);
-
-        ASSERT(XdpRingFree(CompletionRing) > 0);
-        Completion =
-            XdpRingGetElement(
-                CompletionRing, CompletionRing->ProducerIndex++ & CompletionRing->Mask);
-        Completion->BufferAddress = BufferMdl->MdlOffset;
-
-        if (TxQueue->Flags.TxCompletionContextEnabled) {
-            XDP_TX_FRAME_COMPLETION_CONTEXT *FrameCompletionContext =
-                XdpGetFrameTxCompletionContextExtension(
-                    Frame, &TxQueue->FrameTxCompletionContextExtension);
-            XDP_TX_FRAME_COMPLETION_CONTEXT *CompletionContext =
-                XdpGetTxCompletionContextExtension(
-                    Completion, &TxQueue->TxCompletionContextExtension);
-            *CompletionContext = *FrameCompletionContext;
-        }
-
-        if (XdpRingFree(CompletionRing) == 0) {
-            XdpFlushTransmit(TxQueue->XdpTxQueue);
-        }
+        XdpGenericTxCompleteFrameInline(TxQueue, Frame);
     }
 
-    if (XdpRingCount(CompletionRing) > 0) {
+    if (XdpRingCount(TxQueue->CompletionRing) > 0) {
         XdpFlushTransmit(TxQueue->XdpTxQueue);
     }
 
@@ -544,6 +1216,14 @@ XdpGenericTxPoll(
 
     if (TxQueue->NeedFlush) {
         TxQueue->NeedFlush = FALSE;
+
+        //
+        // XDP requests a flush whenever datapath clients are added or removed.
+        //
+        if (TxQueue->MdlCache != NULL) {
+            XdpGenericTxInvalidateMdlCache(TxQueue);
+        }
+
         XdpFlushTransmit(TxQueue->XdpTxQueue);
     }
 
@@ -789,6 +1469,7 @@ XdpGenericTxCreateQueue(
     XDP_EXTENSION_INFO ExtensionInfo;
     XDP_LWF_DATAPATH_BYPASS *Datapath = NULL;
     BOOLEAN NeedRestart = FALSE;
+    ULONG MdlCacheSize;
     XDP_HOOK_ID HookId = {
         .Layer      = XDP_HOOK_L2,
         .Direction  = XDP_HOOK_TX,
@@ -889,6 +1570,8 @@ XdpGenericTxCreateQueue(
         Status = STATUS_NO_MEMORY;
         goto Exit;
     }
+    TxQueue->NblContextSize = PoolParams.ContextSize;
+    TxQueue->NdisFilterHandle = Generic->NdisFilterHandle;
 
     Status =
         XdpRegQueryDwordValue(
@@ -905,28 +1588,64 @@ XdpGenericTxCreateQueue(
 
     for (ULONG Index = 0; Index < TxQueue->FrameCount; Index++) {
         NET_BUFFER_LIST *Nbl;
-        NET_BUFFER *Nb;
-        MDL *Mdl;
 
-        Nbl = NdisAllocateNetBufferList(TxQueue->NblPool, PoolParams.ContextSize, 0);
+        Nbl = XdpGenericTxAllocateNbl(TxQueue);
         if (Nbl == NULL) {
             Status = STATUS_NO_MEMORY;
             goto Exit;
         }
-        Nbl->SourceHandle = Generic->NdisFilterHandle;
-        Mdl = (MDL *)(NET_BUFFER_LIST_CONTEXT_DATA_START(Nbl) + sizeof(NBL_TX_CONTEXT));
-        MmInitializeMdl(Mdl, (VOID *)(PAGE_SIZE - 1), MAX_TX_BUFFER_LENGTH);
-        Nb = NET_BUFFER_LIST_FIRST_NB(Nbl);
-        NET_BUFFER_FIRST_MDL(Nb) = Mdl;
-        NET_BUFFER_CURRENT_MDL(Nb) = Mdl;
         Nbl->Next = TxQueue->FreeNbls;
         TxQueue->FreeNbls = Nbl;
     }
 
+    //
+    // Optionally cache partial MDLs per UMEM page rather than building one
+    // for each frame. The cache size must be a power of two; zero disables it.
+    //
+    Status =
+        XdpRegQueryDwordValue(
+            XDP_LWF_PARAMETERS_KEY, L"GenericTxMdlCacheSize", &MdlCacheSize);
+    if (!NT_SUCCESS(Status)) {
+        MdlCacheSize = 0;
+        Status = STATUS_SUCCESS;
+    } else if (MdlCacheSize > MAX_TX_MDL_CACHE_SIZE ||
+        (MdlCacheSize > 0 && !RTL_IS_POWER_OF_TWO(MdlCacheSize))) {
+        TraceWarn(
+            TRACE_GENERIC, "IfIndex=%u QueueId=%u Invalid TX MDL cache size. Disabling cache.",
+            Generic->IfIndex, QueueInfo->QueueId);
+        MdlCacheSize = 0;
+    }
+
+    if (MdlCacheSize > 0) {
+        UCHAR *MdlStorage;
+
+        C_ASSERT(sizeof(*TxQueue->MdlCache) % __alignof(MDL) == 0);
+        ASSERT(MdlSize % __alignof(MDL) == 0);
+
+        TxQueue->MdlCache =
+            ExAllocatePoolZero(
+                NonPagedPoolNx, MdlCacheSize * (sizeof(*TxQueue->MdlCache) + MdlSize),
+                POOLTAG_SEND);
+        if (TxQueue->MdlCache == NULL) {
+            Status = STATUS_NO_MEMORY;
+            goto Exit;
+        }
+
+        MdlStorage = (UCHAR *)&TxQueue->MdlCache[MdlCacheSize];
+
+        for (ULONG Index = 0; Index < MdlCacheSize; Index++) {
+            MDL *Mdl = (MDL *)(MdlStorage + Index * MdlSize);
+
+            MmInitializeMdl(Mdl, (VOID *)(PAGE_SIZE - 1), MAX_TX_BUFFER_LENGTH);
+            TxQueue->MdlCache[Index].Mdl = Mdl;
+        }
+
+        TxQueue->MdlCacheMask = MdlCacheSize - 1;
+    }
+
     InitializeSListHead(&TxQueue->NblComplete);
     TxQueue->Generic = Generic;
     TxQueue->QueueId = QueueInfo->QueueId;
-    TxQueue->NdisFilterHandle = Generic->NdisFilterHandle;
     TxQueue->RssQueue = RssQueue;
 
     TxQueue->Flags.RxInject = (HookId.Direction == XDP_HOOK_RX);
@@ -979,6 +1698,11 @@ XdpGenericTxCreateQueue(
         XDP_FRAME_EXTENSION_TIMESTAMP_VERSION_1, XDP_EXTENSION_TYPE_TX_FRAME_COMPLETION);
     XdpTxQueueRegisterExtensionVersion(Config, &ExtensionInfo);
 
+    XdpInitializeExtensionInfo(
+        &ExtensionInfo, XDP_FRAME_EXTENSION_GSO_NAME,
+        XDP_FRAME_EXTENSION_GSO_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+    XdpTxQueueRegisterExtensionVersion(Config, &ExtensionInfo);
+
     XdpInitializeTxCapabilitiesSystemMdl(&TxCapabilities);
     TxCapabilities.Header.Size = sizeof(TxCapabilities);
     TxCapabilities.OutOfOrderCompletionEnabled = TRUE;
@@ -986,6 +1710,11 @@ XdpGenericTxCreateQueue(
     TxCapabilities.MaximumFrameSize = Generic->Tx.Mtu;
     TxCapabilities.TransmitFrameCountHint = (UINT16)min(MAXUINT16, TxQueue->FrameCount);
     TxCapabilities.ChecksumOffload = TRUE;
+    //
+    // Segmentation is performed by the NIC if possible, and otherwise in
+    // software, so any frame fitting in a single buffer can be segmented.
+    //
+    TxCapabilities.MaximumSegmentationOffloadSize = MAX_TX_BUFFER_LENGTH;
     XdpTxQueueSetCapabilities(Config, &TxCapabilities);
 
     *InterfaceTxQueue = (XDP_INTERFACE_HANDLE)TxQueue;
@@ -1026,6 +1755,9 @@ Exit:
                 NdisFreeNetBufferListPool(TxQueue->NblPool);
                 TxQueue->NblPool = NULL;
             }
+            if (TxQueue->MdlCache != NULL) {
+                ExFreePoolWithTag(TxQueue->MdlCache, POOLTAG_SEND);
+            }
             if (TxQueue->PcwInstance != NULL) {
                 PcwCloseInstance(TxQueue->PcwInstance);
             }
@@ -1066,6 +1798,7 @@ XdpGenericTxActivateQueue(
     TxQueue->Flags.TxCompletionContextEnabled = XdpTxQueueIsTxCompletionContextEnabled(Config);
     TxQueue->Flags.ChecksumOffloadEnabled = XdpTxQueueIsChecksumOffloadEnabled(Config);
     TxQueue->Flags.TimestampOffloadEnabled = XdpTxQueueIsTimestampOffloadEnabled(Config);
+    TxQueue->Flags.GsoEnabled = XdpTxQueueIsSegmentationOffloadEnabled(Config);
 
     if (TxQueue->Flags.TxCompletionContextEnabled) {
         XdpInitializeExtensionInfo(
@@ -1099,6 +1832,18 @@ XdpGenericTxActivateQueue(
         XdpTxQueueGetExtension(Config, &ExtensionInfo, &TxQueue->CompletionTimestampExtension);
     }
 
+    if (TxQueue->Flags.GsoEnabled) {
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_LAYOUT_NAME,
+            XDP_FRAME_EXTENSION_LAYOUT_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        XdpTxQueueGetExtension(Config, &ExtensionInfo, &TxQueue->FrameLayoutExtension);
+
+        XdpInitializeExtensionInfo(
+            &ExtensionInfo, XDP_FRAME_EXTENSION_GSO_NAME,
+            XDP_FRAME_EXTENSION_GSO_VERSION_1, XDP_EXTENSION_TYPE_FRAME);
+        XdpTxQueueGetExtension(Config, &ExtensionInfo, &TxQueue->FrameGsoExtension);
+    }
+
     WritePointerRelease(&TxQueue->XdpTxQueue, XdpTxQueue);
 
     RtlReleasePushLockExclusive(&Generic->Lock);
@@ -1116,6 +1861,9 @@ XdpGenericFreeTxQueue(
 
     XdpEcCleanup(&TxQueue->Ec);
     XdpPcwCloseLwfTxQueue(TxQueue->PcwInstance);
+    if (TxQueue->MdlCache != NULL) {
+        ExFreePoolWithTag(TxQueue->MdlCache, POOLTAG_SEND);
+    }
     KeSetEvent(TxQueue->DeleteComplete, 0, FALSE);
     ExFreePoolWithTag(TxQueue, POOLTAG_SEND);
 }
@@ -14,6 +14,19 @@ typedef struct _XDP_LWF_GENERIC_TX_STATS {
     UINT64 BatchesPosted;
 } XDP_LWF_GENERIC_TX_STATS;
 
+//
+// A partial MDL describing a TX buffer MDL from a page boundary onward. Every
+// frame whose data starts within that page is sent using the same partial MDL,
+// so steady-state TX does not rebuild an MDL per frame.
+//
+typedef struct _XDP_LWF_GENERIC_TX_MDL {
+    MDL *SourceMdl;
+    VOID *SourceSystemVa;
+    SIZE_T SourceOffset;
+    ULONG OutstandingCount;
+    MDL *Mdl;
+} XDP_LWF_GENERIC_TX_MDL;
+
 typedef struct _XDP_LWF_GENERIC_TX_QUEUE {
     ULONG QueueId;
     LIST_ENTRY Link;
@@ -29,6 +42,7 @@ typedef struct _XDP_LWF_GENERIC_TX_QUEUE {
     XDP_EXTENSION TxCompletionContextExtension;
     XDP_EXTENSION FrameLayoutExtension;
     XDP_EXTENSION FrameChecksumExtension;
+    XDP_EXTENSION FrameGsoExtension;
     XDP_EXTENSION CompletionTimestampExtension;
 
     XDP_LWF_GENERIC_RSS_QUEUE *RssQueue;
@@ -42,6 +56,7 @@ typedef struct _XDP_LWF_GENERIC_TX_QUEUE {
         BOOLEAN TxCompletionContextEnabled : 1;
         BOOLEAN ChecksumOffloadEnabled : 1;
         BOOLEAN TimestampOffloadEnabled : 1;
+        BOOLEAN GsoEnabled : 1;
     } Flags;
 
     KEVENT *PauseComplete;
@@ -53,6 +68,9 @@ typedef struct _XDP_LWF_GENERIC_TX_QUEUE {
     SLIST_HEADER NblComplete;
     NET_BUFFER_LIST *FreeNbls;
     NDIS_HANDLE NblPool;
+    USHORT NblContextSize;
+    XDP_LWF_GENERIC_TX_MDL *MdlCache;
+    ULONG MdlCacheMask;
     PCW_INSTANCE *PcwInstance;
     XDP_LIFETIME_ENTRY DeleteEntry;
     KEVENT *DeleteComplete;
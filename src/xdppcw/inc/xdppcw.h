@@ -20,6 +20,8 @@ typedef struct _XDP_PCW_RX_QUEUE {
     UINT64 InspectFramesRedirected;
     UINT64 InspectFramesForwarded;
     UINT64 InspectFramesDiscontiguous;
+    UINT64 InspectFramesRateLimitConformed;
+    UINT64 InspectFramesRateLimitExceeded;
 } XDP_PCW_RX_QUEUE;
 
 typedef struct _XDP_PCW_LWF_RX_QUEUE {
@@ -32,20 +34,32 @@ typedef struct _XDP_PCW_LWF_RX_QUEUE {
     UINT64 ForwardingNbsRequested;
     UINT64 ForwardingNbsSent;
     UINT64 LoopbackNblsSkipped;
+    UINT64 NbsCoalesced;
+    UINT64 LinearizationPoolHits;
+    UINT64 LinearizationPoolMisses;
 } XDP_PCW_LWF_RX_QUEUE;
 
 typedef struct _XDP_PCW_TX_QUEUE {
     UINT64 XskInvalidDescriptors;
     UINT64 InjectionBatches;
     UINT64 QueueDepth;
+    UINT64 RedirectFramesQueued;
+    UINT64 RedirectFramesDropped;
 } XDP_PCW_TX_QUEUE;
 
 typedef struct _XDP_PCW_LWF_TX_QUEUE {
     UINT64 FramesDroppedPause;
     UINT64 FramesDroppedNic;
     UINT64 FramesInvalidChecksumOffload;
+    UINT64 FramesDroppedSegmentationOffload;
+    UINT64 FramesSegmentedSoftware;
 } XDP_PCW_LWF_TX_QUEUE;
 
+typedef struct _XDP_PCW_RATE_LIMIT_RULE {
+    UINT64 FramesConformed;
+    UINT64 FramesExceeded;
+} XDP_PCW_RATE_LIMIT_RULE;
+
 #define STAT_SET(_Stats, _Field, _Value) WriteUInt64NoFence(&((_Stats)->_Field), (_Value))
 #define STAT_ADD(_Stats, _Field, _Bias) STAT_SET(_Stats, _Field, ReadUInt64NoFence(&((_Stats)->_Field)) + (_Bias))
 #define STAT_INC(_Stats, _Field) STAT_ADD(_Stats, _Field, 1)
@@ -0,0 +1,40 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+#include "bpf_endian.h"
+#include "bpf_helpers.h"
+#include "net/if_ether.h"
+#include "xdp/ebpfhook.h"
+#include "vxlan.h"
+
+SEC("xdp/decap")
+int
+decap(xdp_md_t *ctx)
+{
+    VXLAN_ENCAP_HEADER *Outer;
+
+    //
+    // Strip the outer headers of IPv4 VXLAN frames and pass the inner frame;
+    // pass everything else unmodified.
+    //
+
+    if ((char *)ctx->data + sizeof(*Outer) + sizeof(ETHERNET_HEADER) > (char *)ctx->data_end) {
+        return XDP_PASS;
+    }
+
+    Outer = (VXLAN_ENCAP_HEADER *)ctx->data;
+    if (Outer->Ethernet.Type != htons(ETHERNET_TYPE_IPV4) ||
+        Outer->Ipv4[0] != htons(0x4500) ||
+        (Outer->Ipv4[4] & htons(0x00ff)) != htons(VXLAN_IP_PROTOCOL_UDP) ||
+        Outer->UdpDestinationPort != htons(VXLAN_UDP_PORT)) {
+        return XDP_PASS;
+    }
+
+    if (bpf_xdp_adjust_head(ctx, sizeof(*Outer)) < 0) {
+        return XDP_DROP;
+    }
+
+    return XDP_PASS;
+}
@@ -0,0 +1,74 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+#include "bpf_endian.h"
+#include "bpf_helpers.h"
+#include "net/if_ether.h"
+#include "xdp/ebpfhook.h"
+#include "vxlan.h"
+
+SEC("xdp/encap")
+int
+encap(xdp_md_t *ctx)
+{
+    VXLAN_ENCAP_HEADER Outer;
+    uint32_t InnerLength;
+    uint32_t Checksum = 0;
+
+    //
+    // Encapsulate the frame in VXLAN (VNI 1) between two fixed documentation
+    // addresses and bounce it back out the interface.
+    //
+
+    if ((char *)ctx->data + sizeof(ETHERNET_HEADER) > (char *)ctx->data_end) {
+        return XDP_DROP;
+    }
+
+    InnerLength = (uint32_t)((char *)ctx->data_end - (char *)ctx->data);
+
+    __builtin_memcpy(&Outer.Ethernet, ctx->data, sizeof(Outer.Ethernet));
+    Outer.Ethernet.Type = htons(ETHERNET_TYPE_IPV4);
+
+    Outer.Ipv4[0] = htons(0x4500);
+    Outer.Ipv4[1] = htons(sizeof(Outer) - sizeof(Outer.Ethernet) + InnerLength);
+    Outer.Ipv4[2] = 0;
+    Outer.Ipv4[3] = htons(0x4000);
+    Outer.Ipv4[4] = htons((64 << 8) | VXLAN_IP_PROTOCOL_UDP);
+    Outer.Ipv4[5] = 0;
+    Outer.Ipv4[6] = htons(0xc000); // 192.0.2.1
+    Outer.Ipv4[7] = htons(0x0201);
+    Outer.Ipv4[8] = htons(0xc633); // 198.51.100.1
+    Outer.Ipv4[9] = htons(0x6401);
+
+#pragma unroll
+    for (int i = 0; i < 10; i++) {
+        Checksum += Outer.Ipv4[i];
+    }
+    Checksum = (Checksum & 0xffff) + (Checksum >> 16);
+    Checksum = (Checksum & 0xffff) + (Checksum >> 16);
+    Outer.Ipv4[5] = (uint16_t)~Checksum;
+
+    Outer.UdpSourcePort = htons(49152);
+    Outer.UdpDestinationPort = htons(VXLAN_UDP_PORT);
+    Outer.UdpLength = htons(sizeof(Outer) - sizeof(Outer.Ethernet) - sizeof(Outer.Ipv4) + InnerLength);
+    Outer.UdpChecksum = 0;
+
+    Outer.Vxlan[0] = htons(0x0800);
+    Outer.Vxlan[1] = 0;
+    Outer.Vxlan[2] = 0;
+    Outer.Vxlan[3] = htons(0x0100);
+
+    if (bpf_xdp_adjust_head(ctx, -(int)sizeof(Outer)) < 0) {
+        return XDP_DROP;
+    }
+
+    if ((char *)ctx->data + sizeof(Outer) > (char *)ctx->data_end) {
+        return XDP_DROP;
+    }
+
+    __builtin_memcpy(ctx->data, &Outer, sizeof(Outer));
+
+    return XDP_TX;
+}
@@ -0,0 +1,29 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+#include "bpf_helpers.h"
+#include "xdp/ebpfhook.h"
+
+#define TAIL_LENGTH 4
+
+SEC("xdp/grow_tail")
+int
+grow_tail(xdp_md_t *ctx)
+{
+    //
+    // Trim the frame and grow it back to its original end, then attempt to
+    // grow it beyond its original end, which generic XDP must reject. Bounce
+    // the frame back out the interface if every adjustment behaved as
+    // expected; drop it otherwise.
+    //
+
+    if (bpf_xdp_adjust_tail(ctx, -TAIL_LENGTH) < 0 ||
+        bpf_xdp_adjust_tail(ctx, TAIL_LENGTH) < 0 ||
+        bpf_xdp_adjust_tail(ctx, TAIL_LENGTH) == 0) {
+        return XDP_DROP;
+    }
+
+    return XDP_TX;
+}
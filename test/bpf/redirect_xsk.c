@@ -0,0 +1,19 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+#include "bpf_endian.h"
+#include "bpf_helpers.h"
+#include "xdp/ebpfhook.h"
+
+SEC("xdp/redirect_xsk")
+int
+redirect_xsk(xdp_md_t *ctx)
+{
+    //
+    // Redirect every frame to the XSK at key 0 of the attached XSKMAP, or
+    // pass the frame up the stack if no XSK is present.
+    //
+    return bpf_xdp_redirect_map(ctx, 0, XDP_PASS);
+}
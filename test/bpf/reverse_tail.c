@@ -0,0 +1,45 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+#include "bpf_helpers.h"
+#include "xdp/ebpfhook.h"
+
+#define TAIL_LENGTH 4
+
+SEC("xdp/reverse_tail")
+int
+reverse_tail(xdp_md_t *ctx)
+{
+    uint8_t Tail[TAIL_LENGTH];
+    uint8_t Byte;
+    uint64_t Length;
+
+    //
+    // Reverse the trailing bytes of the frame, which may reside in any of its
+    // buffers, and bounce it back out the interface.
+    //
+
+    Length = bpf_xdp_get_buff_len(ctx);
+    if (Length < sizeof(Tail)) {
+        return XDP_DROP;
+    }
+
+    if (bpf_xdp_load_bytes(ctx, (uint32_t)(Length - sizeof(Tail)), Tail, sizeof(Tail)) < 0) {
+        return XDP_DROP;
+    }
+
+    Byte = Tail[0];
+    Tail[0] = Tail[3];
+    Tail[3] = Byte;
+    Byte = Tail[1];
+    Tail[1] = Tail[2];
+    Tail[2] = Byte;
+
+    if (bpf_xdp_store_bytes(ctx, (uint32_t)(Length - sizeof(Tail)), Tail, sizeof(Tail)) < 0) {
+        return XDP_DROP;
+    }
+
+    return XDP_TX;
+}
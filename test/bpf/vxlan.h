@@ -0,0 +1,25 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+#pragma once
+
+//
+// The outer headers of a VXLAN-encapsulated Ethernet frame: Ethernet, IPv4
+// without options, UDP and VXLAN. Fields are 16-bit words in network byte
+// order so the structure has no padding.
+//
+
+#define VXLAN_UDP_PORT 4789
+#define VXLAN_IP_PROTOCOL_UDP 17
+
+typedef struct _VXLAN_ENCAP_HEADER {
+    ETHERNET_HEADER Ethernet;
+    uint16_t Ipv4[10];
+    uint16_t UdpSourcePort;
+    uint16_t UdpDestinationPort;
+    uint16_t UdpLength;
+    uint16_t UdpChecksum;
+    uint16_t Vxlan[4];
+} VXLAN_ENCAP_HEADER;
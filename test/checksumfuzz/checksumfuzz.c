@@ -0,0 +1,92 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+//
+// This checksumfuzz harness verifies the internet checksum helpers in
+// xdpchecksum.h against a straightforward 16-bit scalar reference, at every
+// alignment and for every length up to the size of the fuzzer input.
+//
+
+#include <xdp/wincommon.h>
+#include <stdlib.h>
+#include <xdpassert.h>
+#include <xdpchecksum.h>
+
+static
+UINT16
+ReferenceChecksum(
+    _In_reads_bytes_(BufferLength) CONST UCHAR *Buffer,
+    _In_ UINT32 BufferLength
+    )
+{
+    UINT64 Checksum = 0;
+
+    while (BufferLength >= sizeof(UINT16)) {
+        Checksum += *(UNALIGNED CONST UINT16 *)Buffer;
+        Buffer += sizeof(UINT16);
+        BufferLength -= sizeof(UINT16);
+    }
+
+    if (BufferLength > 0) {
+        Checksum += *Buffer;
+    }
+
+    while ((Checksum >> 16) != 0) {
+        Checksum = (UINT16)Checksum + (Checksum >> 16);
+    }
+
+    return (UINT16)Checksum;
+}
+
+int
+LLVMFuzzerTestOneInput(
+    _In_ const UINT8 *Data,
+    _In_ SIZE_T Size
+    )
+{
+    UCHAR *Buffer;
+    UINT32 Offset;
+    UINT32 Length;
+    UINT16 Expected;
+    UINT64 Scalar;
+
+    if (Size < 1 || Size > MAXUINT16) {
+        return -1;
+    }
+
+    //
+    // The first input byte selects the buffer alignment and the remainder is
+    // checksummed. Copy the data into an exactly sized allocation so ASAN
+    // detects any over-read.
+    //
+    Offset = Data[0] % 16;
+    Length = (UINT32)Size - 1;
+
+    Buffer = malloc(Offset + Length);
+    if (Buffer == NULL) {
+        return 0;
+    }
+
+    RtlCopyMemory(Buffer + Offset, Data + 1, Length);
+
+    Expected = ReferenceChecksum(Buffer + Offset, Length);
+    Scalar = XdpChecksumAccumulateScalar(Buffer + Offset, Length, 0);
+
+    FRE_ASSERT(XdpPartialChecksum(Buffer + Offset, Length) == Expected);
+    FRE_ASSERT(XdpChecksumFold(XdpChecksumFold64(Scalar)) == Expected);
+
+    //
+    // Shorter prefixes exercise every combination of vector and scalar tail.
+    //
+    for (UINT32 PrefixLength = 0; PrefixLength < min(Length, 256); PrefixLength++) {
+        FRE_ASSERT(
+            XdpPartialChecksum(Buffer + Offset, PrefixLength) ==
+                ReferenceChecksum(Buffer + Offset, PrefixLength));
+    }
+
+    free(Buffer);
+
+    return 0;
+}
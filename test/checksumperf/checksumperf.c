@@ -0,0 +1,177 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+//
+// This checksumperf microbenchmark measures the throughput of the internet
+// checksum helpers in xdpchecksum.h for buffer sizes from 64 bytes to 64KB.
+// Each implementation is compared against the original 16-bit scalar loop.
+//
+
+#include <xdp/wincommon.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <xdpassert.h>
+#include <xdpchecksum.h>
+
+CONST CHAR *UsageText = "Usage: checksumperf [-Bytes <count>]";
+
+#define REQUIRE(expr) \
+    if (!(expr)) { printf("("#expr") failed line %d\n", __LINE__);  exit(1);}
+
+static const UINT32 BufferSizes[] = { 64, 256, 1024, 1500, 4096, 16384, 65536 };
+
+typedef
+UINT16
+CHECKSUM_ROUTINE(
+    _In_reads_bytes_(BufferLength) CONST UCHAR *Buffer,
+    _In_ UINT32 BufferLength
+    );
+
+VOID
+Usage(
+    CHAR *Error
+    )
+{
+    fprintf(stderr, "Error: %s\n%s", Error, UsageText);
+    exit(1);
+}
+
+static
+UINT16
+Checksum16(
+    _In_reads_bytes_(BufferLength) CONST UCHAR *Buffer,
+    _In_ UINT32 BufferLength
+    )
+{
+    //
+    // The original implementation: a 32-bit accumulator of 16-bit words.
+    //
+    UINT32 Checksum = 0;
+    CONST UINT16 *Buffer16 = (CONST UINT16 *)Buffer;
+
+    while (BufferLength >= sizeof(*Buffer16)) {
+        Checksum += *Buffer16++;
+        BufferLength -= sizeof(*Buffer16);
+    }
+
+    if (BufferLength > 0) {
+        Checksum += *(UCHAR *)Buffer16;
+    }
+
+    return XdpChecksumFold(Checksum);
+}
+
+static
+UINT16
+Checksum64(
+    _In_reads_bytes_(BufferLength) CONST UCHAR *Buffer,
+    _In_ UINT32 BufferLength
+    )
+{
+    UINT64 Checksum = XdpChecksumAccumulateScalar(Buffer, BufferLength, 0);
+
+    return XdpChecksumFold(XdpChecksumFold64(Checksum));
+}
+
+static
+UINT16
+ChecksumDefault(
+    _In_reads_bytes_(BufferLength) CONST UCHAR *Buffer,
+    _In_ UINT32 BufferLength
+    )
+{
+    return XdpPartialChecksum(Buffer, BufferLength);
+}
+
+static
+double
+Measure(
+    _In_ CHECKSUM_ROUTINE *Routine,
+    _In_reads_bytes_(BufferLength) CONST UCHAR *Buffer,
+    _In_ UINT32 BufferLength,
+    _In_ UINT64 Iterations
+    )
+{
+    LARGE_INTEGER Frequency;
+    LARGE_INTEGER Start;
+    LARGE_INTEGER End;
+    volatile UINT16 Result;
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Start);
+
+    for (UINT64 i = 0; i < Iterations; i++) {
+        Result = Routine(Buffer, BufferLength);
+    }
+
+    QueryPerformanceCounter(&End);
+    UNREFERENCED_PARAMETER(Result);
+
+    //
+    // Return the throughput in gigabytes per second.
+    //
+    return
+        (double)BufferLength * (double)Iterations * (double)Frequency.QuadPart /
+            (double)(End.QuadPart - Start.QuadPart) / 1000000000.0;
+}
+
+INT
+__cdecl
+main(
+    INT ArgC,
+    CHAR **ArgV
+    )
+{
+    UINT64 Bytes = 0x40000000;
+    UCHAR *Buffer;
+
+    for (INT i = 1; i < ArgC; i++) {
+        if (!_stricmp(ArgV[i], "-Bytes") && i + 1 < ArgC) {
+            Bytes = _strtoui64(ArgV[++i], NULL, 0);
+            if (Bytes == 0) {
+                Usage("Invalid -Bytes");
+            }
+        } else {
+            Usage("Invalid parameter");
+        }
+    }
+
+    //
+    // Offset the buffer by one byte so the vector loads are unaligned, as is
+    // typical for headers within a frame.
+    //
+    Buffer = malloc(BufferSizes[RTL_NUMBER_OF(BufferSizes) - 1] + 1);
+    REQUIRE(Buffer != NULL);
+
+    for (UINT32 i = 0; i < BufferSizes[RTL_NUMBER_OF(BufferSizes) - 1] + 1; i++) {
+        Buffer[i] = (UCHAR)rand();
+    }
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(BufferSizes); i++) {
+        UINT32 BufferLength = BufferSizes[i];
+        UINT64 Iterations = max(Bytes / BufferLength, 1);
+        UINT16 Expected = Checksum16(Buffer + 1, BufferLength);
+        double Scalar16;
+        double Scalar64;
+        double Default;
+
+        REQUIRE(Checksum64(Buffer + 1, BufferLength) == Expected);
+        REQUIRE(ChecksumDefault(Buffer + 1, BufferLength) == Expected);
+
+        Scalar16 = Measure(Checksum16, Buffer + 1, BufferLength, Iterations);
+        Scalar64 = Measure(Checksum64, Buffer + 1, BufferLength, Iterations);
+        Default = Measure(ChecksumDefault, Buffer + 1, BufferLength, Iterations);
+
+        printf(
+            "Bytes=%-6u Scalar16=%.2fGB/s Scalar64=%.2fGB/s XdpPartialChecksum=%.2fGB/s "
+            "Speedup=%.2fx\n",
+            BufferLength, Scalar16, Scalar64, Default, Default / Scalar16);
+    }
+
+    free(Buffer);
+
+    return 0;
+}
@@ -20,6 +20,7 @@
 #include <mstcpip.h>
 #include <functional>
 #include <lm.h>
+#include <pdh.h>
 #include <sddl.h>
 #include <string.h>
 
@@ -45,6 +46,7 @@
 
 #include <bpf/bpf.h>
 #include <bpf/libbpf.h>
+#include <ebpf_api.h>
 
 #include "cxplat.h"
 #include "cxplatvector.h"
@@ -155,6 +157,7 @@ FreeMem(
 template <typename T>
 using unique_malloc_ptr = wistd::unique_ptr<T, wil::function_deleter<decltype(&::FreeMem), ::FreeMem>>;
 using unique_bpf_object = wistd::unique_ptr<bpf_object, wil::function_deleter<decltype(&::bpf_object__close), ::bpf_object__close>>;
+using unique_bpf_link = wistd::unique_ptr<bpf_link, wil::function_deleter<decltype(&::bpf_link__destroy), ::bpf_link__destroy>>;
 
 //
 // Custom deleter for XDP program attachment that detaches the program
@@ -184,6 +187,7 @@ using unique_fnlwf_handle = wil::unique_any<FNLWF_HANDLE, decltype(::FnLwfClose)
 using unique_fnmp_filter_handle = wil::unique_any<FNMP_HANDLE, decltype(::MpTxFilterReset), ::MpTxFilterReset>;
 using unique_fnlwf_filter_handle = wil::unique_any<FNLWF_HANDLE, decltype(::LwfRxFilterReset), ::LwfRxFilterReset>;
 using unique_fnsock = wil::unique_any<FNSOCK_HANDLE, decltype(::FnSockClose), ::FnSockClose>;
+using unique_pdh_query = wil::unique_any<PDH_HQUERY, decltype(::PdhCloseQuery), ::PdhCloseQuery>;
 using unique_fnmp_task_offload_handle = wil::unique_any<FNMP_HANDLE, decltype(::MpTaskOffloadReset), ::MpTaskOffloadReset>;
 
 static
@@ -220,6 +224,8 @@ typedef struct {
     UINT16 TxFrameLayoutExtension;
     BOOLEAN TxFrameChecksumExtensionEnabled;
     UINT16 TxFrameChecksumExtension;
+    BOOLEAN TxFrameGsoExtensionEnabled;
+    UINT16 TxFrameGsoExtension;
     BOOLEAN RxFrameLayoutExtensionEnabled;
     UINT16 RxFrameLayoutExtension;
     BOOLEAN RxFrameChecksumExtensionEnabled;
@@ -1317,6 +1323,18 @@ EnableTxChecksumOffload(
     Socket->Extensions.TxFrameChecksumExtensionEnabled = TRUE;
 }
 
+static
+VOID
+EnableTxSegmentationOffload(
+    MY_SOCKET *Socket
+    )
+{
+    UINT32 Enabled = TRUE;
+    SetSockopt(Socket->Handle.get(), XSK_SOCKOPT_TX_OFFLOAD_GSO, &Enabled, sizeof(Enabled));
+    Socket->Extensions.TxFrameLayoutExtensionEnabled = TRUE;
+    Socket->Extensions.TxFrameGsoExtensionEnabled = TRUE;
+}
+
 static
 VOID
 EnableRxChecksumOffload(
@@ -1395,6 +1413,13 @@ XskSetupPreActivate(
             &Socket->Extensions.TxFrameChecksumExtension, &OptionLength);
     }
 
+    if (Socket->Extensions.TxFrameGsoExtensionEnabled) {
+        OptionLength = sizeof(Socket->Extensions.TxFrameGsoExtension);
+        GetSockopt(
+            Socket->Handle.get(), XSK_SOCKOPT_TX_FRAME_GSO_EXTENSION,
+            &Socket->Extensions.TxFrameGsoExtension, &OptionLength);
+    }
+
     if (Socket->Extensions.RxFrameLayoutExtensionEnabled) {
         OptionLength = sizeof(Socket->Extensions.RxFrameLayoutExtension);
         GetSockopt(
@@ -3026,6 +3051,103 @@ GenericRxAllQueueRedirect(
             PacketBufferLength));
 }
 
+VOID
+GenericRxRssSteering(
+    _In_ ADDRESS_FAMILY Af
+    )
+{
+    auto If = FnMpIf;
+    UINT16 LocalPort;
+    UINT16 RemotePort = htons(1234);
+    ETHERNET_ADDRESS LocalHw, RemoteHw;
+    INET_ADDR LocalIp, RemoteIp;
+    const UINT32 QueueCount = 2;
+    const UINT32 FramesPerQueue = 2;
+
+    auto Socket = CreateUdpSocket(Af, &If, &LocalPort);
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+
+    If.GetHwAddress(&LocalHw);
+    If.GetRemoteHwAddress(&RemoteHw);
+    if (Af == AF_INET) {
+        If.GetIpv4Address(&LocalIp.Ipv4);
+        If.GetRemoteIpv4Address(&RemoteIp.Ipv4);
+    } else {
+        If.GetIpv6Address(&LocalIp.Ipv6);
+        If.GetRemoteIpv6Address(&RemoteIp.Ipv6);
+    }
+
+    auto Xsk0 =
+        CreateAndActivateSocket(If.GetIfIndex(), If.GetQueueId(), TRUE, FALSE, XDP_GENERIC);
+    auto Xsk1 =
+        CreateAndActivateSocket(If.GetIfIndex(), If.GetQueueId() + 1, TRUE, FALSE, XDP_GENERIC);
+    MY_SOCKET *Xsks[QueueCount] = { &Xsk0, &Xsk1 };
+    wil::unique_handle ProgramHandles[QueueCount];
+
+    for (UINT32 Index = 0; Index < QueueCount; Index++) {
+        XDP_RULE Rule;
+        Rule.Match = XDP_MATCH_UDP_DST;
+        Rule.Pattern.Port = LocalPort;
+        Rule.Action = XDP_PROGRAM_ACTION_REDIRECT;
+        Rule.Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_XSK;
+        Rule.Redirect.Target = Xsks[Index]->Handle.get();
+
+        ProgramHandles[Index] =
+            CreateXdpProg(
+                If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId() + Index, XDP_GENERIC,
+                &Rule, 1);
+        SocketProduceRxFill(Xsks[Index], FramesPerQueue);
+    }
+
+    //
+    // Indicate a single NBL chain whose frames alternate between RSS queues.
+    // Each frame must be steered to its own queue, not the first frame's.
+    //
+    UCHAR Payloads[QueueCount][sizeof("GenericRxRssSteering0")] = {
+        "GenericRxRssSteering0", "GenericRxRssSteering1"
+    };
+    UCHAR PacketBuffers[QueueCount][UDP_HEADER_STORAGE + sizeof(Payloads[0])];
+    UINT32 PacketBufferLengths[QueueCount];
+    RX_FRAME Frame;
+
+    for (UINT32 Index = 0; Index < QueueCount; Index++) {
+        PacketBufferLengths[Index] = sizeof(PacketBuffers[Index]);
+        TEST_TRUE(
+            PktBuildUdpFrame(
+                PacketBuffers[Index], &PacketBufferLengths[Index], Payloads[Index],
+                sizeof(Payloads[Index]), &LocalHw, &RemoteHw, Af, &LocalIp, &RemoteIp,
+                LocalPort, RemotePort));
+    }
+
+    for (UINT32 Count = 0; Count < FramesPerQueue; Count++) {
+        for (UINT32 Index = 0; Index < QueueCount; Index++) {
+            RxInitializeFrame(
+                &Frame, If.GetQueueId() + Index, PacketBuffers[Index],
+                PacketBufferLengths[Index]);
+            TEST_HRESULT(MpRxEnqueueFrame(GenericMp, &Frame));
+        }
+    }
+
+    MpRxFlush(GenericMp);
+
+    for (UINT32 Index = 0; Index < QueueCount; Index++) {
+        MY_SOCKET *Xsk = Xsks[Index];
+        UINT32 ConsumerIndex = SocketConsumerReserve(&Xsk->Rings.Rx, FramesPerQueue);
+        TEST_EQUAL(
+            FramesPerQueue, XskRingConsumerReserve(&Xsk->Rings.Rx, MAXUINT32, &ConsumerIndex));
+
+        for (UINT32 Count = 0; Count < FramesPerQueue; Count++) {
+            auto RxDesc = SocketGetAndFreeRxDesc(Xsk, ConsumerIndex++);
+            TEST_EQUAL(PacketBufferLengths[Index], RxDesc->Length);
+            TEST_TRUE(
+                RtlEqualMemory(
+                    Xsk->Umem.Buffer.get() + RxDesc->Address.BaseAddress +
+                        RxDesc->Address.Offset,
+                    PacketBuffers[Index], PacketBufferLengths[Index]));
+        }
+    }
+}
+
 VOID
 GenericRxTcpControl(
     _In_ ADDRESS_FAMILY Af
@@ -4114,6 +4236,136 @@ GenericRxMultiSocket()
     }
 }
 
+VOID
+GenericRxSharedUmem()
+{
+    auto If = FnMpIf;
+    ADDRESS_FAMILY Af = AF_INET;
+    ETHERNET_ADDRESS LocalHw, RemoteHw;
+    INET_ADDR LocalIp, RemoteIp;
+    UCHAR UdpMatchPayload[] = "GenericRxSharedUmem";
+    struct {
+        MY_SOCKET Xsk;
+        UINT16 LocalPort;
+        UCHAR UdpFrame[UDP_HEADER_STORAGE + sizeof(UdpMatchPayload)];
+        UINT32 UdpFrameLength;
+    } Sockets[2];
+    XDP_RULE Rules[RTL_NUMBER_OF(Sockets)] = {};
+
+    //
+    // Routine Description:
+    //     Verify a socket can share the UMEM registered by another socket, and
+    //     both sockets receive into the same UMEM through their own fill rings.
+    //
+
+    If.GetHwAddress(&LocalHw);
+    If.GetRemoteHwAddress(&RemoteHw);
+    If.GetIpv4Address(&LocalIp.Ipv4);
+    If.GetRemoteIpv4Address(&RemoteIp.Ipv4);
+
+    Sockets[0].Xsk =
+        CreateAndActivateSocket(If.GetIfIndex(), If.GetQueueId(), TRUE, FALSE, XDP_GENERIC);
+    HANDLE UmemSocket = Sockets[0].Xsk.Handle.get();
+    UCHAR *UmemBuffer = Sockets[0].Xsk.Umem.Buffer.get();
+
+    //
+    // A socket without a UMEM has nothing to share.
+    //
+    auto NoUmemSocket = CreateSocket();
+    HANDLE NoUmemSocketHandle = NoUmemSocket.get();
+    auto &Shared = Sockets[1].Xsk;
+    Shared.Handle = CreateSocket();
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_BAD_COMMAND),
+        TrySetSockopt(
+            Shared.Handle.get(), XSK_SOCKOPT_SHARED_UMEM, &NoUmemSocketHandle,
+            sizeof(NoUmemSocketHandle)));
+
+    SetSockopt(Shared.Handle.get(), XSK_SOCKOPT_SHARED_UMEM, &UmemSocket, sizeof(UmemSocket));
+
+    //
+    // A socket can register or share only one UMEM.
+    //
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_BAD_COMMAND),
+        TrySetSockopt(
+            Shared.Handle.get(), XSK_SOCKOPT_SHARED_UMEM, &UmemSocket, sizeof(UmemSocket)));
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_BAD_COMMAND),
+        TrySetSockopt(
+            Shared.Handle.get(), XSK_SOCKOPT_UMEM_REG, &Sockets[0].Xsk.Umem.Reg,
+            sizeof(Sockets[0].Xsk.Umem.Reg)));
+
+    TEST_HRESULT(
+        XskBind(
+            Shared.Handle.get(), If.GetIfIndex(), If.GetQueueId(),
+            XSK_BIND_FLAG_RX | XSK_BIND_FLAG_GENERIC));
+    Shared.Umem.Reg = Sockets[0].Xsk.Umem.Reg;
+    ActivateSocket(&Shared, TRUE, FALSE);
+
+    //
+    // The sockets must post disjoint buffers, so skip the buffer the first
+    // socket will post.
+    //
+    SocketFreePop(&Shared);
+
+    for (UINT16 Index = 0; Index < RTL_NUMBER_OF(Sockets); Index++) {
+        Sockets[Index].LocalPort = htons(1000 + Index);
+        Sockets[Index].UdpFrameLength = sizeof(Sockets[Index].UdpFrame);
+        TEST_TRUE(
+            PktBuildUdpFrame(
+                Sockets[Index].UdpFrame, &Sockets[Index].UdpFrameLength, UdpMatchPayload,
+                sizeof(UdpMatchPayload), &LocalHw, &RemoteHw, Af, &LocalIp, &RemoteIp,
+                Sockets[Index].LocalPort, htons(2000)));
+
+        Rules[Index].Match = XDP_MATCH_UDP_DST;
+        Rules[Index].Pattern.Port = Sockets[Index].LocalPort;
+        Rules[Index].Action = XDP_PROGRAM_ACTION_REDIRECT;
+        Rules[Index].Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_XSK;
+        Rules[Index].Redirect.Target = Sockets[Index].Xsk.Handle.get();
+    }
+
+    wil::unique_handle ProgramHandle =
+        CreateXdpProg(
+            If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(), XDP_GENERIC,
+            Rules, RTL_NUMBER_OF(Rules));
+
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+    UINT64 RxAddresses[RTL_NUMBER_OF(Sockets)];
+
+    for (UINT16 Index = 0; Index < RTL_NUMBER_OF(Sockets); Index++) {
+        auto &Socket = Sockets[Index].Xsk;
+        DATA_BUFFER Buffer = {0};
+
+        SocketProduceRxFill(&Socket, 1);
+
+        Buffer.DataOffset = 0;
+        Buffer.DataLength = Sockets[Index].UdpFrameLength;
+        Buffer.BufferLength = Buffer.DataLength;
+        Buffer.VirtualAddress = Sockets[Index].UdpFrame;
+        RX_FRAME Frame;
+        RxInitializeFrame(&Frame, FnMpIf.GetQueueId(), &Buffer);
+        TEST_HRESULT(MpRxIndicateFrame(GenericMp, &Frame));
+
+        UINT32 ConsumerIndex = SocketConsumerReserve(&Socket.Rings.Rx, 1);
+
+        //
+        // Verify the frame was written into the shared UMEM.
+        //
+        TEST_EQUAL(1, XskRingConsumerReserve(&Socket.Rings.Rx, MAXUINT32, &ConsumerIndex));
+        auto RxDesc = SocketGetAndFreeRxDesc(&Socket, ConsumerIndex);
+        TEST_EQUAL(Buffer.DataLength, RxDesc->Length);
+        TEST_TRUE(
+            RtlEqualMemory(
+                UmemBuffer + RxDesc->Address.BaseAddress + RxDesc->Address.Offset,
+                Buffer.VirtualAddress + Buffer.DataOffset,
+                Buffer.DataLength));
+        RxAddresses[Index] = RxDesc->Address.BaseAddress;
+    }
+
+    TEST_NOT_EQUAL(RxAddresses[0], RxAddresses[1]);
+}
+
 VOID
 GenericRxMultiProgram()
 {
@@ -5148,6 +5400,87 @@ GenericRxTooManyFragments(
     GenericRxFragmentBuffer(Af, &Params);
 }
 
+static
+UINT64
+GetPerfCounterValue(
+    _In_z_ const WCHAR *CounterSet,
+    _In_z_ const WCHAR *Instance,
+    _In_z_ const WCHAR *Counter
+    )
+{
+    unique_pdh_query Query;
+    PDH_HCOUNTER CounterHandle;
+    PDH_RAW_COUNTER RawValue;
+    WCHAR CounterPath[256];
+
+    swprintf_s(CounterPath, L"\\%s(%s)\\%s", CounterSet, Instance, Counter);
+    TEST_EQUAL(NO_ERROR, PdhOpenQueryW(NULL, 0, &Query));
+    TEST_EQUAL(NO_ERROR, PdhAddEnglishCounterW(Query.get(), CounterPath, 0, &CounterHandle));
+    TEST_EQUAL(NO_ERROR, PdhCollectQueryData(Query.get()));
+    TEST_EQUAL(NO_ERROR, PdhGetRawCounterValue(CounterHandle, NULL, &RawValue));
+
+    return (UINT64)RawValue.FirstValue;
+}
+
+VOID
+GenericRxLinearizationPool()
+{
+    auto If = FnMpIf;
+    //
+    // Exceed the generic fragment limit to force linearization, and indicate
+    // more frames per batch than the former fixed pool size.
+    //
+    const UINT32 FrameLength = 128;
+    const UINT32 FrameCount = 16;
+    WCHAR Instance[64];
+
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+
+    XDP_RULE Rule = {};
+    Rule.Match = XDP_MATCH_ALL;
+    Rule.Action = XDP_PROGRAM_ACTION_DROP;
+    wil::unique_handle ProgramHandle =
+        CreateXdpProg(If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(), XDP_GENERIC, &Rule, 1);
+
+    swprintf_s(Instance, L"if_%u_queue_%u", If.GetIfIndex(), If.GetQueueId());
+
+    CxPlatVector<UCHAR> FrameData(FrameLength, 0xA5);
+    CxPlatVector<UINT32> SplitIndexes;
+    for (UINT32 Index = 1; Index < FrameLength; Index++) {
+        TEST_TRUE(SplitIndexes.push_back(Index));
+    }
+    CxPlatVector<DATA_BUFFER> Buffers =
+        GenericRxCreateSplitBuffers(
+            FrameData.data(), FrameLength, 0, 0, SplitIndexes.data(),
+            (UINT16)SplitIndexes.size());
+
+    //
+    // The first batch populates the pool, and every frame in the second batch
+    // is served from it.
+    //
+    UINT64 Hits = 0;
+    UINT64 Misses = 0;
+    for (UINT32 Batch = 0; Batch < 2; Batch++) {
+        Hits = GetPerfCounterValue(L"XDP LWF Receive Queue", Instance, L"Linearization Pool Hits");
+        Misses =
+            GetPerfCounterValue(L"XDP LWF Receive Queue", Instance, L"Linearization Pool Misses");
+
+        for (UINT32 i = 0; i < FrameCount; i++) {
+            RX_FRAME Frame;
+            RxInitializeFrame(&Frame, If.GetQueueId(), Buffers.data(), (UINT16)Buffers.size());
+            TEST_HRESULT(MpRxEnqueueFrame(GenericMp, &Frame));
+        }
+        TEST_HRESULT(TryMpRxFlush(GenericMp));
+    }
+
+    TEST_EQUAL(
+        Hits + FrameCount,
+        GetPerfCounterValue(L"XDP LWF Receive Queue", Instance, L"Linearization Pool Hits"));
+    TEST_EQUAL(
+        Misses,
+        GetPerfCounterValue(L"XDP LWF Receive Queue", Instance, L"Linearization Pool Misses"));
+}
+
 VOID
 GenericRxHeaderMultipleFragments(
     _In_ ADDRESS_FAMILY Af,
@@ -6113,6 +6446,59 @@ GenericRxEbpfAttach()
         AttachEbpfXdpProgram(If, "\\bpf\\pass.sys", "pass", XDP_FLAGS_REPLACE);
 }
 
+//
+// Loads an eBPF program and attaches it with an XSKMAP for bpf_xdp_redirect_map.
+// The program is detached when the returned link is destroyed.
+//
+static
+unique_bpf_link
+AttachEbpfXdpProgramWithXskMap(
+    _Out_ unique_bpf_object &BpfObject,
+    _In_ const TestInterface &If,
+    _In_ const CHAR *BpfRelativeFileName,
+    _In_ const CHAR *BpfProgramName,
+    _In_ HANDLE XskMap
+    )
+{
+    CHAR BpfAbsoluteFileName[MAX_PATH];
+    bpf_program *Program;
+    bpf_link *Link = NULL;
+    xdp_attach_params_t AttachParams = {0};
+    ebpf_result_t EbpfResult;
+
+    TEST_HRESULT(GetCurrentBinaryPath(BpfAbsoluteFileName, RTL_NUMBER_OF(BpfAbsoluteFileName)));
+    TEST_EQUAL(
+        0, strcat_s(BpfAbsoluteFileName, sizeof(BpfAbsoluteFileName), BpfRelativeFileName));
+
+    BpfObject.reset(bpf_object__open(BpfAbsoluteFileName));
+    TEST_NOT_NULL(BpfObject.get());
+    TEST_EQUAL(0, bpf_object__load(BpfObject.get()));
+
+    Program = bpf_object__find_program_by_name(BpfObject.get(), BpfProgramName);
+    TEST_NOT_NULL(Program);
+
+    AttachParams.ifindex = If.GetIfIndex();
+    AttachParams.xskmap = (uint64_t)(ULONG_PTR)XskMap;
+
+    //
+    // TODO: https://github.com/microsoft/ebpf-for-windows/issues/2133
+    // Retry while a previously attached program is still being torn down.
+    //
+    Stopwatch Watchdog(TEST_TIMEOUT_ASYNC_MS);
+    do {
+        EbpfResult =
+            ebpf_program_attach(
+                Program, &EBPF_ATTACH_TYPE_XDP, &AttachParams, sizeof(AttachParams), &Link);
+        if (EbpfResult == EBPF_SUCCESS) {
+            break;
+        }
+    } while (CxPlatSleep(2 * POLL_INTERVAL_MS), !Watchdog.IsExpired());
+
+    TEST_EQUAL(EBPF_SUCCESS, EbpfResult);
+
+    return unique_bpf_link(Link);
+}
+
 VOID
 GenericRxEbpfDrop()
 {
@@ -6297,26 +6683,98 @@ ProgTestRunRxEbpfPayload()
 }
 
 VOID
-GenericRxEbpfIfIndex()
+ProgTestRunRxEbpfEncapDecap()
 {
     auto If = FnMpIf;
-    unique_fnmp_handle GenericMp;
-    unique_fnlwf_handle FnLwf;
-    const UCHAR Payload[] = "GenericRxEbpfIfIndex";
-    UINT32 Zero = 0;
+    UINT16 LocalPort = 0, RemotePort = 0;
+    ETHERNET_ADDRESS LocalHw = {}, RemoteHw = {};
+    INET_ADDR LocalIp = {}, RemoteIp = {};
+    const UCHAR UdpPayload[] = "ProgTestRunRxEbpfEncapDecap";
+    CONST UINT32 EncapLength = sizeof(ETHERNET_HEADER) + sizeof(IPV4_HEADER) + sizeof(UDP_HDR) + 8;
+    CONST UINT32 Repeat = 10000;
+    bpf_test_run_opts Opts = {};
 
-    unique_xdp_program BpfProgram = AttachEbpfXdpProgram(If, "\\bpf\\selective_drop.sys", "selective_drop");
+    UCHAR UdpFrame[UDP_HEADER_STORAGE + sizeof(UdpPayload)];
+    UCHAR EncapFrame[sizeof(UdpFrame) + EncapLength];
+    UCHAR DecapFrame[sizeof(EncapFrame)];
+    UINT32 UdpFrameLength = sizeof(UdpFrame);
+    TEST_TRUE(
+        PktBuildUdpFrame(
+            UdpFrame, &UdpFrameLength, UdpPayload, sizeof(UdpPayload), &LocalHw,
+            &RemoteHw, AF_INET6, &LocalIp, &RemoteIp, LocalPort, RemotePort));
 
-    GenericMp = MpOpenGeneric(If.GetIfIndex());
-    FnLwf = LwfOpenDefault(If.GetIfIndex());
+    //
+    // Encapsulate the frame and verify the outer headers are prepended to the
+    // unmodified inner frame.
+    //
+    unique_xdp_program BpfProgram = AttachEbpfXdpProgram(If, "\\bpf\\encap.sys", "encap");
+    fd_t ProgFd = bpf_program__fd(bpf_object__find_program_by_name(BpfProgram.get(), "encap"));
 
-    // Get the interface_map fd.
-    fd_t interface_map_fd = bpf_object__find_map_fd_by_name(BpfProgram.get(), "interface_map");
-    TEST_NOT_EQUAL(interface_map_fd, ebpf_fd_invalid);
+    Opts.data_in = UdpFrame;
+    Opts.data_size_in = UdpFrameLength;
+    Opts.data_out = EncapFrame;
+    Opts.data_size_out = sizeof(EncapFrame);
+    Opts.repeat = Repeat;
 
-    // Update the interface_map with the interface index of the test interface.
-    UINT32 IfIndex = If.GetIfIndex();
-    TEST_NOT_EQUAL(IfIndex, IFI_UNSPECIFIED);
+    TEST_EQUAL(0, bpf_prog_test_run_opts(ProgFd, &Opts));
+    TEST_EQUAL(Opts.retval, XDP_TX);
+    TEST_EQUAL(Opts.data_size_out, UdpFrameLength + EncapLength);
+    TraceVerbose("encap: %u ns per frame", Opts.duration);
+
+    CONST ETHERNET_HEADER *OuterEthernet = (CONST ETHERNET_HEADER *)EncapFrame;
+    CONST IPV4_HEADER *OuterIp = (CONST IPV4_HEADER *)(OuterEthernet + 1);
+    CONST UDP_HDR *OuterUdp = (CONST UDP_HDR *)(OuterIp + 1);
+    TEST_EQUAL(OuterEthernet->Type, htons(ETHERNET_TYPE_IPV4));
+    TEST_EQUAL(OuterIp->Protocol, IPPROTO_UDP);
+    TEST_EQUAL(ntohs(OuterIp->TotalLength), Opts.data_size_out - sizeof(ETHERNET_HEADER));
+    TEST_EQUAL(OuterUdp->uh_dport, htons(4789));
+    TEST_EQUAL(memcmp(EncapFrame + EncapLength, UdpFrame, UdpFrameLength), 0);
+
+    BpfProgram.reset();
+
+    //
+    // Decapsulate the output of the encap program and verify the original
+    // frame is restored.
+    //
+    BpfProgram = AttachEbpfXdpProgram(If, "\\bpf\\decap.sys", "decap");
+    ProgFd = bpf_program__fd(bpf_object__find_program_by_name(BpfProgram.get(), "decap"));
+
+    Opts = {};
+    Opts.data_in = EncapFrame;
+    Opts.data_size_in = UdpFrameLength + EncapLength;
+    Opts.data_out = DecapFrame;
+    Opts.data_size_out = sizeof(DecapFrame);
+    Opts.repeat = Repeat;
+
+    TEST_EQUAL(0, bpf_prog_test_run_opts(ProgFd, &Opts));
+    TEST_EQUAL(Opts.retval, XDP_PASS);
+    TEST_EQUAL(Opts.data_size_out, UdpFrameLength);
+    TraceVerbose("decap: %u ns per frame", Opts.duration);
+
+    TEST_EQUAL(memcmp(DecapFrame, UdpFrame, UdpFrameLength), 0);
+}
+
+VOID
+GenericRxEbpfIfIndex()
+{
+    auto If = FnMpIf;
+    unique_fnmp_handle GenericMp;
+    unique_fnlwf_handle FnLwf;
+    const UCHAR Payload[] = "GenericRxEbpfIfIndex";
+    UINT32 Zero = 0;
+
+    unique_xdp_program BpfProgram = AttachEbpfXdpProgram(If, "\\bpf\\selective_drop.sys", "selective_drop");
+
+    GenericMp = MpOpenGeneric(If.GetIfIndex());
+    FnLwf = LwfOpenDefault(If.GetIfIndex());
+
+    // Get the interface_map fd.
+    fd_t interface_map_fd = bpf_object__find_map_fd_by_name(BpfProgram.get(), "interface_map");
+    TEST_NOT_EQUAL(interface_map_fd, ebpf_fd_invalid);
+
+    // Update the interface_map with the interface index of the test interface.
+    UINT32 IfIndex = If.GetIfIndex();
+    TEST_NOT_EQUAL(IfIndex, IFI_UNSPECIFIED);
 
     TEST_EQUAL(0, bpf_map_update_elem(interface_map_fd, &Zero, &IfIndex, BPF_ANY));
 
@@ -6384,9 +6842,9 @@ GenericRxEbpfFragments()
     Buffers[1].VirtualAddress = Payload + Buffers[0].BufferLength;
 
     //
-    // XDP-for-Windows has limited eBPF support for fragments: the first buffer
-    // is visible to eBPF programs, and the remaining fragments (if any) are
-    // inaccessible.
+    // Only the first buffer is visible to eBPF programs via direct packet
+    // access; the remaining fragments (if any) are accessible only via the
+    // load and store bytes helpers.
     //
     // Actions apply to the entire frame, not just to the first fragement.
     //
@@ -6404,6 +6862,100 @@ GenericRxEbpfFragments()
     MpTxFlush(GenericMp);
 }
 
+VOID
+GenericRxEbpfFragmentBytes()
+{
+    auto If = FnMpIf;
+    unique_fnmp_handle GenericMp;
+    const UINT32 Backfill = 3;
+    const UINT32 Trailer = 4;
+    const UINT32 TailLength = 4;
+    DATA_BUFFER Buffers[2] = {};
+    const UCHAR Payload[] = "123GenericRxEbpfFragmentBytes4321";
+    const UINT32 FrameLength = sizeof(Payload) - Backfill - Trailer;
+
+    unique_xdp_program BpfProgram = AttachEbpfXdpProgram(If, "\\bpf\\reverse_tail.sys", "reverse_tail");
+
+    GenericMp = MpOpenGeneric(If.GetIfIndex());
+
+    //
+    // Split the frame within its trailing bytes, so the program must load and
+    // store bytes beyond the first buffer.
+    //
+    Buffers[0].DataLength = FrameLength - TailLength / 2;
+    Buffers[0].DataOffset = Backfill;
+    Buffers[0].BufferLength = Backfill + Buffers[0].DataLength;
+    Buffers[0].VirtualAddress = Payload;
+    Buffers[1].DataLength = TailLength / 2;
+    Buffers[1].DataOffset = 0;
+    Buffers[1].BufferLength = Buffers[1].DataLength + Trailer;
+    Buffers[1].VirtualAddress = Payload + Buffers[0].BufferLength;
+
+    CxPlatVector<UCHAR> Expected(FrameLength, 0);
+    RtlCopyMemory(Expected.data(), Payload + Backfill, FrameLength);
+    for (UINT32 i = 0; i < TailLength; i++) {
+        Expected[FrameLength - TailLength + i] = Payload[Backfill + FrameLength - 1 - i];
+    }
+
+    CxPlatVector<UCHAR> Mask(FrameLength, 0xFF);
+    auto MpFilter = MpTxFilter(GenericMp, Expected.data(), Mask.data(), FrameLength);
+
+    RX_FRAME Frame;
+    RxInitializeFrame(&Frame, If.GetQueueId(), Buffers, RTL_NUMBER_OF(Buffers));
+    TEST_HRESULT(MpRxEnqueueFrame(GenericMp, &Frame));
+    MpRxFlush(GenericMp);
+
+    MpTxAllocateAndGetFrame(GenericMp, If.GetQueueId());
+    MpTxDequeueFrame(GenericMp, If.GetQueueId());
+    MpTxFlush(GenericMp);
+}
+
+VOID
+GenericRxEbpfAdjustTail()
+{
+    auto If = FnMpIf;
+    unique_fnmp_handle GenericMp;
+    const UINT32 Backfill = 3;
+    const UINT32 Trailer = 4;
+    const UINT32 TailLength = 4;
+    DATA_BUFFER Buffer = {};
+    const UCHAR Payload[] = "123GenericRxEbpfAdjustTail4321";
+    const UINT32 FrameLength = sizeof(Payload) - Backfill - Trailer;
+
+    unique_xdp_program BpfProgram = AttachEbpfXdpProgram(If, "\\bpf\\grow_tail.sys", "grow_tail");
+
+    GenericMp = MpOpenGeneric(If.GetIfIndex());
+
+    //
+    // The receive buffer holds bytes after the frame, which the program must
+    // not be able to claim by growing the frame's tail.
+    //
+    Buffer.DataOffset = Backfill;
+    Buffer.DataLength = FrameLength;
+    Buffer.BufferLength = sizeof(Payload);
+    Buffer.VirtualAddress = Payload;
+
+    //
+    // Trimming and regrowing the tail zeroes the regrown bytes.
+    //
+    CxPlatVector<UCHAR> Expected(FrameLength, 0);
+    RtlCopyMemory(Expected.data(), Payload + Backfill, FrameLength - TailLength);
+
+    CxPlatVector<UCHAR> Mask(FrameLength, 0xFF);
+    auto MpFilter = MpTxFilter(GenericMp, Expected.data(), Mask.data(), FrameLength);
+
+    RX_FRAME Frame;
+    RxInitializeFrame(&Frame, If.GetQueueId(), &Buffer);
+    TEST_HRESULT(MpRxEnqueueFrame(GenericMp, &Frame));
+    MpRxFlush(GenericMp);
+
+    auto MpTxFrame = MpTxAllocateAndGetFrame(GenericMp, If.GetQueueId());
+    TEST_EQUAL(1, MpTxFrame->BufferCount);
+    TEST_EQUAL(FrameLength, MpTxFrame->Buffers[0].DataLength);
+    MpTxDequeueFrame(GenericMp, If.GetQueueId());
+    MpTxFlush(GenericMp);
+}
+
 VOID
 GenericRxEbpfUnload()
 {
@@ -6525,6 +7077,255 @@ GenericTxSingleFrame()
     TEST_EQUAL(TxBuffer, *SocketGetTxCompDesc(&Xsk, ConsumerIndex));
 }
 
+VOID
+GenericTxFragmentsNotSupported()
+{
+    auto If = FnMpIf;
+    auto Xsk = CreateAndActivateSocket(If.GetIfIndex(), If.GetQueueId(), FALSE, TRUE, XDP_GENERIC);
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+
+    UINT64 Pattern = 0xA5CC7729CE99C16Aui64;
+    UINT64 Mask = ~0ui64;
+
+    auto MpFilter = MpTxFilter(GenericMp, &Pattern, &Mask, sizeof(Pattern));
+
+    //
+    // The generic data path does not support multi-buffer TX, so a chain of
+    // descriptors is dropped in its entirety, while a subsequent single-buffer
+    // frame is transmitted.
+    //
+    UCHAR Payload[] = "GenericTxFragmentsNotSupported";
+    UINT64 ChainBuffers[2];
+    UINT64 TxBuffer;
+    UINT32 TxFrameLength = sizeof(Pattern) + sizeof(Payload);
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(ChainBuffers); i++) {
+        ChainBuffers[i] = SocketFreePop(&Xsk);
+        RtlCopyMemory(Xsk.Umem.Buffer.get() + ChainBuffers[i], &Pattern, sizeof(Pattern));
+    }
+
+    TxBuffer = SocketFreePop(&Xsk);
+    UCHAR *TxFrame = Xsk.Umem.Buffer.get() + TxBuffer;
+    RtlCopyMemory(TxFrame, &Pattern, sizeof(Pattern));
+    RtlCopyMemory(TxFrame + sizeof(Pattern), Payload, sizeof(Payload));
+
+    UINT32 ProducerIndex;
+    TEST_EQUAL(3, XskRingProducerReserve(&Xsk.Rings.Tx, 3, &ProducerIndex));
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(ChainBuffers); i++) {
+        XSK_BUFFER_DESCRIPTOR *TxDesc = SocketGetTxDesc(&Xsk, ProducerIndex++);
+        TxDesc->Address.AddressAndOffset = ChainBuffers[i];
+        TxDesc->Length = sizeof(Pattern);
+        TxDesc->Flags =
+            (i + 1 < RTL_NUMBER_OF(ChainBuffers)) ?
+                XSK_BUFFER_DESCRIPTOR_FLAG_CONTINUED : XSK_BUFFER_DESCRIPTOR_FLAG_NONE;
+    }
+
+    XSK_BUFFER_DESCRIPTOR *TxDesc = SocketGetTxDesc(&Xsk, ProducerIndex++);
+    TxDesc->Address.AddressAndOffset = TxBuffer;
+    TxDesc->Length = TxFrameLength;
+    XskRingProducerSubmit(&Xsk.Rings.Tx, 3);
+
+    XSK_NOTIFY_RESULT_FLAGS NotifyResult;
+    NotifySocket(Xsk.Handle.get(), XSK_NOTIFY_FLAG_POKE_TX, 0, &NotifyResult);
+    TEST_EQUAL(0, NotifyResult);
+
+    auto MpTxFrame = MpTxAllocateAndGetFrame(GenericMp, 0);
+    TEST_EQUAL(1, MpTxFrame->BufferCount);
+
+    const DATA_BUFFER *MpTxBuffer = &MpTxFrame->Buffers[0];
+    TEST_EQUAL(TxFrameLength, MpTxBuffer->BufferLength);
+    TEST_TRUE(
+        RtlEqualMemory(
+            TxFrame, MpTxBuffer->VirtualAddress + MpTxBuffer->DataOffset, TxFrameLength));
+
+    MpTxDequeueFrame(GenericMp, 0);
+    MpTxFlush(GenericMp);
+
+    UINT32 ConsumerIndex = SocketConsumerReserve(&Xsk.Rings.Completion, 1);
+    TEST_EQUAL(1, XskRingConsumerReserve(&Xsk.Rings.Completion, MAXUINT32, &ConsumerIndex));
+    TEST_EQUAL(TxBuffer, *SocketGetTxCompDesc(&Xsk, ConsumerIndex));
+
+    XSK_STATISTICS Stats = {0};
+    UINT32 StatsSize = sizeof(Stats);
+    GetSockopt(Xsk.Handle.get(), XSK_SOCKOPT_STATISTICS, &Stats, &StatsSize);
+    TEST_EQUAL(2, Stats.TxInvalidDescriptors);
+}
+
+VOID
+GenericTxMdlCache()
+{
+    auto If = FnMpIf;
+    const BOOLEAN Rx = FALSE, Tx = TRUE;
+    const UINT32 ChunkSize = 1024;
+    const CHAR *MdlCacheSizeRegName = "GenericTxMdlCacheSize";
+    const DWORD MdlCacheSize = 2;
+
+    //
+    // Routine Description:
+    //     Verify generic TX with cached partial MDLs transmits the correct data
+    //     for frames sharing a UMEM page, frames whose cache entry is in use by
+    //     another page, frames reusing an entry after completion, and frames
+    //     sent from a new UMEM after the socket is replaced.
+    //
+
+    wil::unique_hkey XdpParametersKey;
+    TEST_EQUAL(
+        ERROR_SUCCESS,
+        RegCreateKeyExA(
+            HKEY_LOCAL_MACHINE,
+            "System\\CurrentControlSet\\Services\\Xdp\\Parameters",
+            0, NULL, REG_OPTION_VOLATILE, KEY_WRITE, NULL, &XdpParametersKey, NULL));
+    TEST_EQUAL(
+        ERROR_SUCCESS,
+        RegSetValueExA(
+            XdpParametersKey.get(), MdlCacheSizeRegName,
+            0, REG_DWORD, (BYTE *)&MdlCacheSize, sizeof(MdlCacheSize)));
+    auto RegValueScopeGuard = wil::scope_exit([&]
+    {
+        TEST_EQUAL(
+            ERROR_SUCCESS,
+            RegDeleteValueA(XdpParametersKey.get(), MdlCacheSizeRegName));
+    });
+
+    auto Xsk =
+        CreateAndBindSocket(
+            If.GetIfIndex(), If.GetQueueId(), Rx, Tx, XDP_GENERIC, XSK_BIND_FLAG_NONE, nullptr,
+            nullptr, ChunkSize);
+    ActivateSocket(&Xsk, Rx, Tx);
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+
+    UINT64 Pattern = 0xA5CC7729CE99C16Aui64;
+    UINT64 Mask = ~0ui64;
+
+    auto MpFilter = MpTxFilter(GenericMp, &Pattern, &Mask, sizeof(Pattern));
+
+    //
+    // The first two chunks share a page, the next chunk occupies the other
+    // cache entry, and the last chunk maps to the first entry while it is in
+    // use. Vary the offsets and lengths so each frame is distinct.
+    //
+    const UINT64 TxBuffers[] = {
+        0, ChunkSize, 4 * ChunkSize, 8 * ChunkSize
+    };
+
+    for (UINT32 Round = 0; Round < 2; Round++) {
+        UINT32 ProducerIndex;
+        TEST_EQUAL(
+            RTL_NUMBER_OF(TxBuffers),
+            XskRingProducerReserve(&Xsk.Rings.Tx, RTL_NUMBER_OF(TxBuffers), &ProducerIndex));
+
+        for (UINT32 Index = 0; Index < RTL_NUMBER_OF(TxBuffers); Index++) {
+            UINT16 FrameOffset = (UINT16)(Round * 64 + Index * 7);
+            UCHAR *TxFrame = Xsk.Umem.Buffer.get() + TxBuffers[Index] + FrameOffset;
+            UINT32 TxFrameLength = sizeof(Pattern) + 32 + Index * 16 + Round;
+            ASSERT(FrameOffset + TxFrameLength <= ChunkSize);
+
+            RtlCopyMemory(TxFrame, &Pattern, sizeof(Pattern));
+            for (UINT32 Byte = sizeof(Pattern); Byte < TxFrameLength; Byte++) {
+                TxFrame[Byte] = (UCHAR)(Round + Index + Byte);
+            }
+
+            XSK_BUFFER_DESCRIPTOR *TxDesc = SocketGetTxDesc(&Xsk, ProducerIndex++);
+            TxDesc->Address.BaseAddress = TxBuffers[Index];
+            TxDesc->Address.Offset = FrameOffset;
+            TxDesc->Length = TxFrameLength;
+        }
+
+        XskRingProducerSubmit(&Xsk.Rings.Tx, RTL_NUMBER_OF(TxBuffers));
+
+        XSK_NOTIFY_RESULT_FLAGS NotifyResult;
+        NotifySocket(Xsk.Handle.get(), XSK_NOTIFY_FLAG_POKE_TX, 0, &NotifyResult);
+        TEST_EQUAL(0, NotifyResult);
+
+        for (UINT32 Index = 0; Index < RTL_NUMBER_OF(TxBuffers); Index++) {
+            XSK_BUFFER_DESCRIPTOR *TxDesc =
+                SocketGetTxDesc(&Xsk, ProducerIndex - RTL_NUMBER_OF(TxBuffers) + Index);
+            auto MpTxFrame = MpTxAllocateAndGetFrame(GenericMp, Index);
+            TEST_EQUAL(1, MpTxFrame->BufferCount);
+
+            const DATA_BUFFER *MpTxBuffer = &MpTxFrame->Buffers[0];
+            TEST_EQUAL(TxDesc->Length, MpTxBuffer->DataLength);
+            TEST_TRUE(
+                RtlEqualMemory(
+                    Xsk.Umem.Buffer.get() + TxDesc->Address.BaseAddress +
+                        TxDesc->Address.Offset,
+                    MpTxBuffer->VirtualAddress + MpTxBuffer->DataOffset,
+                    TxDesc->Length));
+        }
+
+        for (UINT32 Index = 0; Index < RTL_NUMBER_OF(TxBuffers); Index++) {
+            MpTxDequeueFrame(GenericMp, 0);
+        }
+        MpTxFlush(GenericMp);
+
+        //
+        // Completions may arrive out of order; every buffer must be returned.
+        //
+        UINT32 ConsumerIndex =
+            SocketConsumerReserve(&Xsk.Rings.Completion, RTL_NUMBER_OF(TxBuffers));
+        UINT32 CompletedMask = 0;
+        for (UINT32 Index = 0; Index < RTL_NUMBER_OF(TxBuffers); Index++) {
+            UINT64 Completed = *SocketGetTxCompDesc(&Xsk, ConsumerIndex++);
+            for (UINT32 Buffer = 0; Buffer < RTL_NUMBER_OF(TxBuffers); Buffer++) {
+                if (Completed == TxBuffers[Buffer]) {
+                    CompletedMask |= 1 << Buffer;
+                }
+            }
+        }
+        TEST_EQUAL((1u << RTL_NUMBER_OF(TxBuffers)) - 1, CompletedMask);
+        XskRingConsumerRelease(&Xsk.Rings.Completion, RTL_NUMBER_OF(TxBuffers));
+    }
+
+    //
+    // Replace the socket and its UMEM. The cache is flushed when the datapath
+    // client changes, so the new socket's frames must not be sent from MDLs
+    // describing the old UMEM, even if the new UMEM MDL reuses its address.
+    //
+    Xsk.Handle.reset();
+    Xsk.Umem.Buffer.reset();
+
+    auto NewXsk =
+        CreateAndBindSocket(
+            If.GetIfIndex(), If.GetQueueId(), Rx, Tx, XDP_GENERIC, XSK_BIND_FLAG_NONE, nullptr,
+            nullptr, ChunkSize);
+    ActivateSocket(&NewXsk, Rx, Tx);
+
+    UCHAR *TxFrame = NewXsk.Umem.Buffer.get() + TxBuffers[0];
+    UINT32 TxFrameLength = sizeof(Pattern) + 32;
+    RtlCopyMemory(TxFrame, &Pattern, sizeof(Pattern));
+    for (UINT32 Byte = sizeof(Pattern); Byte < TxFrameLength; Byte++) {
+        TxFrame[Byte] = (UCHAR)~Byte;
+    }
+
+    UINT32 ProducerIndex;
+    TEST_EQUAL(1, XskRingProducerReserve(&NewXsk.Rings.Tx, 1, &ProducerIndex));
+    XSK_BUFFER_DESCRIPTOR *TxDesc = SocketGetTxDesc(&NewXsk, ProducerIndex);
+    TxDesc->Address.BaseAddress = TxBuffers[0];
+    TxDesc->Address.Offset = 0;
+    TxDesc->Length = TxFrameLength;
+    XskRingProducerSubmit(&NewXsk.Rings.Tx, 1);
+
+    XSK_NOTIFY_RESULT_FLAGS NotifyResult;
+    NotifySocket(NewXsk.Handle.get(), XSK_NOTIFY_FLAG_POKE_TX, 0, &NotifyResult);
+    TEST_EQUAL(0, NotifyResult);
+
+    auto MpTxFrame = MpTxAllocateAndGetFrame(GenericMp, 0);
+    TEST_EQUAL(1, MpTxFrame->BufferCount);
+    const DATA_BUFFER *MpTxBuffer = &MpTxFrame->Buffers[0];
+    TEST_EQUAL(TxFrameLength, MpTxBuffer->DataLength);
+    TEST_TRUE(
+        RtlEqualMemory(
+            TxFrame, MpTxBuffer->VirtualAddress + MpTxBuffer->DataOffset, TxFrameLength));
+
+    MpTxDequeueFrame(GenericMp, 0);
+    MpTxFlush(GenericMp);
+
+    UINT32 ConsumerIndex = SocketConsumerReserve(&NewXsk.Rings.Completion, 1);
+    TEST_EQUAL(TxBuffers[0], *SocketGetTxCompDesc(&NewXsk, ConsumerIndex));
+    XskRingConsumerRelease(&NewXsk.Rings.Completion, 1);
+}
+
 VOID
 GenericTxOutOfOrder()
 {
@@ -6700,23 +7501,144 @@ GenericTxPoke()
 }
 
 VOID
-GenericTxMtu()
+GenericXskPollModeAdaptive()
 {
     auto If = FnMpIf;
-    auto Xsk = CreateAndActivateSocket(If.GetIfIndex(), If.GetQueueId(), FALSE, TRUE, XDP_GENERIC);
+    auto Xsk = CreateAndBindSocket(If.GetIfIndex(), If.GetQueueId(), TRUE, TRUE, XDP_GENERIC);
     auto GenericMp = MpOpenGeneric(If.GetIfIndex());
-    const UINT32 TestMtu = 2048;
-    C_ASSERT(TestMtu != FNMP_DEFAULT_MTU);
-    C_ASSERT(TestMtu < DEFAULT_UMEM_CHUNK_SIZE);
+    const UINT32 IdleTimeoutMs = 20;
+    const UINT32 IdleWaitMs = IdleTimeoutMs * 10;
+    XSK_POLL_MODE PollMode;
+    UINT32 InvalidIdleTimeoutMs = 0;
 
-    auto MtuReset = MpSetMtu(If, GenericMp, TestMtu);
+    UINT64 Pattern = 0x2C6F1B94D3E8A057ui64;
+    UINT64 Mask = ~0ui64;
+    const UCHAR Payload[] = "GenericXskPollModeAdaptive";
+    UCHAR RxFrameBuffer[sizeof(Pattern) + sizeof(Payload)];
+
+    RtlCopyMemory(RxFrameBuffer, &Pattern, sizeof(Pattern));
+    RtlCopyMemory(RxFrameBuffer + sizeof(Pattern), Payload, sizeof(Payload));
+
+    auto MpFilter = MpTxFilter(GenericMp, &Pattern, &Mask, sizeof(Pattern));
 
     //
-    // The XSK TX path should be torn down after an MTU change.
+    // Adaptive polling requires an active socket and a non-zero idle timeout.
     //
-    Stopwatch Watchdog(MP_RESTART_TIMEOUT_MS);
-    do {
-        if (XskRingError(&Xsk.Rings.Tx)) {
+    PollMode = XSK_POLL_MODE_ADAPTIVE;
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_BAD_COMMAND),
+        TrySetSockopt(Xsk.Handle.get(), XSK_SOCKOPT_POLL_MODE, &PollMode, sizeof(PollMode)));
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER),
+        TrySetSockopt(
+            Xsk.Handle.get(), XSK_SOCKOPT_POLL_ADAPTIVE_IDLE_TIMEOUT, &InvalidIdleTimeoutMs,
+            sizeof(InvalidIdleTimeoutMs)));
+    SetSockopt(
+        Xsk.Handle.get(), XSK_SOCKOPT_POLL_ADAPTIVE_IDLE_TIMEOUT, &IdleTimeoutMs,
+        sizeof(IdleTimeoutMs));
+
+    ActivateSocket(&Xsk, TRUE, TRUE);
+    Xsk.RxProgram =
+        SocketAttachRxProgram(
+            If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(), XDP_GENERIC, Xsk.Handle.get());
+
+    auto ReceiveFrame = [&]() {
+        RX_FRAME Frame;
+
+        SocketProduceRxFill(&Xsk, 1);
+        RxInitializeFrame(&Frame, If.GetQueueId(), RxFrameBuffer, sizeof(RxFrameBuffer));
+        TEST_HRESULT(MpRxIndicateFrame(GenericMp, &Frame));
+
+        UINT32 ConsumerIndex = SocketConsumerReserve(&Xsk.Rings.Rx, 1);
+        auto RxDesc = SocketGetAndFreeRxDesc(&Xsk, ConsumerIndex);
+        TEST_EQUAL(sizeof(RxFrameBuffer), RxDesc->Length);
+        XskRingConsumerRelease(&Xsk.Rings.Rx, 1);
+    };
+
+    auto SendFrame = [&]() {
+        UINT64 TxBuffer = SocketFreePop(&Xsk);
+        UCHAR *TxFrame = Xsk.Umem.Buffer.get() + TxBuffer;
+        UINT32 ProducerIndex;
+        XSK_NOTIFY_RESULT_FLAGS NotifyResult;
+
+        RtlCopyMemory(TxFrame, RxFrameBuffer, sizeof(RxFrameBuffer));
+
+        TEST_EQUAL(1, XskRingProducerReserve(&Xsk.Rings.Tx, 1, &ProducerIndex));
+        XSK_BUFFER_DESCRIPTOR *TxDesc = SocketGetTxDesc(&Xsk, ProducerIndex);
+        TxDesc->Address.BaseAddress = TxBuffer;
+        TxDesc->Address.Offset = 0;
+        TxDesc->Length = sizeof(RxFrameBuffer);
+        XskRingProducerSubmit(&Xsk.Rings.Tx, 1);
+
+        NotifySocket(Xsk.Handle.get(), XSK_NOTIFY_FLAG_POKE_TX, 0, &NotifyResult);
+        TEST_EQUAL(0, NotifyResult);
+
+        MpTxAllocateAndGetFrame(GenericMp, 0);
+        MpTxDequeueFrame(GenericMp, 0);
+        MpTxFlush(GenericMp);
+
+        UINT32 ConsumerIndex = SocketConsumerReserve(&Xsk.Rings.Completion, 1);
+        TEST_EQUAL(TxBuffer, *SocketGetTxCompDesc(&Xsk, ConsumerIndex));
+        TEST_TRUE(Xsk.FreeDescriptors.push_back(TxBuffer));
+        XskRingConsumerRelease(&Xsk.Rings.Completion, 1);
+    };
+
+    //
+    // Enter adaptive polling; IO flows while busy polling.
+    //
+    SetSockopt(Xsk.Handle.get(), XSK_SOCKOPT_POLL_MODE, &PollMode, sizeof(PollMode));
+    ReceiveFrame();
+    SendFrame();
+
+    //
+    // Go idle for several timeouts so the socket stops busy polling. An idle
+    // socket with no outstanding sends requires TX pokes, and an RX frame
+    // re-arms busy polling.
+    //
+    CxPlatSleep(IdleWaitMs);
+    SocketProducerCheckNeedPoke(&Xsk.Rings.Tx, TRUE);
+    ReceiveFrame();
+
+    //
+    // Go idle again, then re-arm busy polling from the application via a TX
+    // poke.
+    //
+    CxPlatSleep(IdleWaitMs);
+    SendFrame();
+
+    //
+    // Leave adaptive polling while idle, then re-enter it and close the socket
+    // while the idle timer is armed.
+    //
+    CxPlatSleep(IdleWaitMs);
+    PollMode = XSK_POLL_MODE_DEFAULT;
+    SetSockopt(Xsk.Handle.get(), XSK_SOCKOPT_POLL_MODE, &PollMode, sizeof(PollMode));
+    ReceiveFrame();
+    SendFrame();
+
+    PollMode = XSK_POLL_MODE_ADAPTIVE;
+    SetSockopt(Xsk.Handle.get(), XSK_SOCKOPT_POLL_MODE, &PollMode, sizeof(PollMode));
+    ReceiveFrame();
+}
+
+VOID
+GenericTxMtu()
+{
+    auto If = FnMpIf;
+    auto Xsk = CreateAndActivateSocket(If.GetIfIndex(), If.GetQueueId(), FALSE, TRUE, XDP_GENERIC);
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+    const UINT32 TestMtu = 2048;
+    C_ASSERT(TestMtu != FNMP_DEFAULT_MTU);
+    C_ASSERT(TestMtu < DEFAULT_UMEM_CHUNK_SIZE);
+
+    auto MtuReset = MpSetMtu(If, GenericMp, TestMtu);
+
+    //
+    // The XSK TX path should be torn down after an MTU change.
+    //
+    Stopwatch Watchdog(MP_RESTART_TIMEOUT_MS);
+    do {
+        if (XskRingError(&Xsk.Rings.Tx)) {
             break;
         }
     } while (CxPlatSleep(POLL_INTERVAL_MS), !Watchdog.IsExpired());
@@ -7065,6 +7987,223 @@ GenericRxTimestampOffloadExtensions() {
             sizeof(XSK_FRAME_DESCRIPTOR) + sizeof(XDP_FRAME_TIMESTAMP));
 }
 
+VOID
+GenericRxZeroCopyNotSupported() {
+    auto If = FnMpIf;
+    const BOOLEAN Rx = TRUE, Tx = FALSE;
+    auto Xsk = CreateAndBindSocket(If.GetIfIndex(), If.GetQueueId(), Rx, Tx, XDP_GENERIC);
+
+    //
+    // Routine Description:
+    //     Verify zero-copy RX is rejected by generic XDP, which cannot receive
+    //     into buffers provided by the socket.
+    //
+
+    UINT32 Enabled = TRUE;
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED),
+        TrySetSockopt(Xsk.Handle.get(), XSK_SOCKOPT_RX_ZERO_COPY, &Enabled, sizeof(Enabled)));
+
+    //
+    // The failed attempt must not prevent regular copy mode RX.
+    //
+    ActivateSocket(&Xsk, Rx, Tx);
+}
+
+VOID
+GenericRxMultiBuffer() {
+    auto If = FnMpIf;
+    const BOOLEAN Rx = TRUE, Tx = FALSE;
+    const UINT32 ChunkSize = 1024;
+    auto Xsk =
+        CreateAndBindSocket(
+            If.GetIfIndex(), If.GetQueueId(), Rx, Tx, XDP_GENERIC, XSK_BIND_FLAG_NONE, nullptr,
+            nullptr, ChunkSize);
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+    UCHAR LargeFrame[2500];
+    UCHAR SmallFrame[64];
+
+    //
+    // Routine Description:
+    //     Verify multi-buffer RX delivers a fragmented frame larger than a UMEM
+    //     chunk as a chain of RX descriptors, followed by a small frame in a
+    //     single RX descriptor.
+    //
+
+    UINT32 Enabled = TRUE;
+    SetSockopt(Xsk.Handle.get(), XSK_SOCKOPT_RX_MULTI_BUFFER, &Enabled, sizeof(Enabled));
+    ActivateSocket(&Xsk, Rx, Tx);
+    Xsk.RxProgram =
+        SocketAttachRxProgram(
+            If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(), XDP_GENERIC, Xsk.Handle.get());
+
+    for (UINT32 Index = 0; Index < sizeof(LargeFrame); Index++) {
+        LargeFrame[Index] = (UCHAR)Index;
+    }
+    RtlFillMemory(SmallFrame, sizeof(SmallFrame), 0xAB);
+
+    DATA_BUFFER LargeBuffers[2] = {0};
+    LargeBuffers[0].DataLength = 1000;
+    LargeBuffers[0].BufferLength = LargeBuffers[0].DataLength;
+    LargeBuffers[0].VirtualAddress = LargeFrame;
+    LargeBuffers[1].DataLength = sizeof(LargeFrame) - LargeBuffers[0].DataLength;
+    LargeBuffers[1].BufferLength = LargeBuffers[1].DataLength;
+    LargeBuffers[1].VirtualAddress = LargeFrame + LargeBuffers[0].DataLength;
+
+    RX_FRAME Frame;
+    RxInitializeFrame(&Frame, If.GetQueueId(), LargeBuffers, RTL_NUMBER_OF(LargeBuffers));
+    TEST_HRESULT(MpRxEnqueueFrame(GenericMp, &Frame));
+    RxInitializeFrame(&Frame, If.GetQueueId(), SmallFrame, sizeof(SmallFrame));
+    TEST_HRESULT(MpRxEnqueueFrame(GenericMp, &Frame));
+
+    const UINT32 ExpectedLengths[] = {
+        ChunkSize, ChunkSize, sizeof(LargeFrame) - 2 * ChunkSize, sizeof(SmallFrame)
+    };
+    const UINT32 ExpectedFlags[] = {
+        XSK_BUFFER_DESCRIPTOR_FLAG_CONTINUED, XSK_BUFFER_DESCRIPTOR_FLAG_CONTINUED,
+        XSK_BUFFER_DESCRIPTOR_FLAG_NONE, XSK_BUFFER_DESCRIPTOR_FLAG_NONE
+    };
+    const UCHAR *ExpectedData[] = {
+        LargeFrame, LargeFrame + ChunkSize, LargeFrame + 2 * ChunkSize, SmallFrame
+    };
+
+    SocketProduceRxFill(&Xsk, RTL_NUMBER_OF(ExpectedLengths));
+    TEST_HRESULT(TryMpRxFlush(GenericMp));
+
+    UINT32 ConsumerIndex = SocketConsumerReserve(&Xsk.Rings.Rx, RTL_NUMBER_OF(ExpectedLengths));
+
+    for (UINT32 Index = 0; Index < RTL_NUMBER_OF(ExpectedLengths); Index++) {
+        auto RxDesc = SocketGetAndFreeRxDesc(&Xsk, ConsumerIndex++);
+
+        TEST_EQUAL(ExpectedLengths[Index], RxDesc->Length);
+        TEST_EQUAL(ExpectedFlags[Index], RxDesc->Flags);
+        TEST_TRUE(
+            RtlEqualMemory(
+                Xsk.Umem.Buffer.get() + RxDesc->Address.BaseAddress + RxDesc->Address.Offset,
+                ExpectedData[Index], RxDesc->Length));
+    }
+
+    XSK_STATISTICS Stats = {0};
+    UINT32 StatsSize = sizeof(Stats);
+    GetSockopt(Xsk.Handle.get(), XSK_SOCKOPT_STATISTICS, &Stats, &StatsSize);
+    TEST_EQUAL(0, Stats.RxTruncated);
+    TEST_EQUAL(0, Stats.RxDropped);
+}
+
+VOID
+GenericRxGroUdp(
+    ADDRESS_FAMILY Af
+    )
+{
+    auto If = FnMpIf;
+    const BOOLEAN Rx = TRUE, Tx = FALSE;
+    UINT16 LocalPort = htons(4321), RemotePort = htons(1234);
+    ETHERNET_ADDRESS LocalHw, RemoteHw;
+    INET_ADDR LocalIp, RemoteIp;
+    const UINT16 MessageSize = 100;
+    const UINT16 PayloadLengths[] = { MessageSize, MessageSize, MessageSize / 2, MessageSize };
+    UCHAR UdpFrames[RTL_NUMBER_OF(PayloadLengths)][UDP_HEADER_STORAGE + MessageSize];
+    UINT32 UdpFrameLengths[RTL_NUMBER_OF(PayloadLengths)];
+    UCHAR UdpPayload[MessageSize * RTL_NUMBER_OF(PayloadLengths)];
+
+    //
+    // Routine Description:
+    //     Verify consecutive UDP datagrams of one flow are coalesced into a
+    //     single RX frame described by the GRO extension, a short datagram ends
+    //     the coalesced frame, and the following datagram is delivered alone.
+    //
+
+    auto Xsk =
+        CreateAndBindSocket(If.GetIfIndex(), If.GetQueueId(), Rx, Tx, XDP_GENERIC);
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+
+    If.GetHwAddress(&LocalHw);
+    If.GetRemoteHwAddress(&RemoteHw);
+    if (Af == AF_INET) {
+        If.GetIpv4Address(&LocalIp.Ipv4);
+        If.GetRemoteIpv4Address(&RemoteIp.Ipv4);
+    } else {
+        If.GetIpv6Address(&LocalIp.Ipv6);
+        If.GetRemoteIpv6Address(&RemoteIp.Ipv6);
+    }
+
+    UINT16 GroExtension;
+    UINT32 OptionLength = sizeof(GroExtension);
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_NOT_FOUND),
+        TryGetSockopt(
+            Xsk.Handle.get(), XSK_SOCKOPT_RX_FRAME_GRO_EXTENSION, &GroExtension,
+            &OptionLength));
+
+    UINT32 Enabled = TRUE;
+    SetSockopt(Xsk.Handle.get(), XSK_SOCKOPT_RX_OFFLOAD_GRO, &Enabled, sizeof(Enabled));
+    ActivateSocket(&Xsk, Rx, Tx);
+
+    OptionLength = sizeof(GroExtension);
+    GetSockopt(
+        Xsk.Handle.get(), XSK_SOCKOPT_RX_FRAME_GRO_EXTENSION, &GroExtension, &OptionLength);
+    TEST_EQUAL(sizeof(GroExtension), OptionLength);
+
+    Xsk.RxProgram =
+        SocketAttachRxProgram(
+            If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(), XDP_GENERIC, Xsk.Handle.get());
+
+    for (UINT32 Index = 0; Index < sizeof(UdpPayload); Index++) {
+        UdpPayload[Index] = (UCHAR)Index;
+    }
+
+    const UCHAR *Payload = UdpPayload;
+    for (UINT32 Index = 0; Index < RTL_NUMBER_OF(PayloadLengths); Index++) {
+        UdpFrameLengths[Index] = sizeof(UdpFrames[Index]);
+        TEST_TRUE(
+            PktBuildUdpFrame(
+                UdpFrames[Index], &UdpFrameLengths[Index], Payload, PayloadLengths[Index],
+                &LocalHw, &RemoteHw, Af, &LocalIp, &RemoteIp, LocalPort, RemotePort));
+        Payload += PayloadLengths[Index];
+
+        RX_FRAME Frame;
+        RxInitializeFrame(&Frame, If.GetQueueId(), UdpFrames[Index], UdpFrameLengths[Index]);
+        TEST_HRESULT(MpRxEnqueueFrame(GenericMp, &Frame));
+    }
+
+    SocketProduceRxFill(&Xsk, 2);
+    TEST_HRESULT(TryMpRxFlush(GenericMp));
+
+    UINT32 ConsumerIndex = SocketConsumerReserve(&Xsk.Rings.Rx, 2);
+    const UINT32 TotalHdrLength = UdpFrameLengths[0] - PayloadLengths[0];
+    const UINT32 CoalescedPayloadLength =
+        PayloadLengths[0] + PayloadLengths[1] + PayloadLengths[2];
+
+    //
+    // The coalesced frame carries the first datagram's headers, followed by
+    // each datagram's payload.
+    //
+    XSK_FRAME_DESCRIPTOR *RxFrame = SocketGetRxFrameDesc(&Xsk, ConsumerIndex);
+    XDP_FRAME_GRO *Gro = (XDP_FRAME_GRO *)RTL_PTR_ADD(RxFrame, GroExtension);
+    auto RxDesc = SocketGetAndFreeRxDesc(&Xsk, ConsumerIndex++);
+    const UCHAR *RxData =
+        Xsk.Umem.Buffer.get() + RxDesc->Address.BaseAddress + RxDesc->Address.Offset;
+    TEST_EQUAL(MessageSize, Gro->UDP.MessageSize);
+    TEST_EQUAL(TotalHdrLength + CoalescedPayloadLength, RxDesc->Length);
+    TEST_TRUE(RtlEqualMemory(RxData, UdpFrames[0], TotalHdrLength));
+    TEST_TRUE(
+        RtlEqualMemory(RxData + TotalHdrLength, UdpPayload, CoalescedPayloadLength));
+
+    RxFrame = SocketGetRxFrameDesc(&Xsk, ConsumerIndex);
+    Gro = (XDP_FRAME_GRO *)RTL_PTR_ADD(RxFrame, GroExtension);
+    RxDesc = SocketGetAndFreeRxDesc(&Xsk, ConsumerIndex++);
+    RxData = Xsk.Umem.Buffer.get() + RxDesc->Address.BaseAddress + RxDesc->Address.Offset;
+    TEST_EQUAL(0, Gro->UDP.MessageSize);
+    TEST_EQUAL(UdpFrameLengths[3], RxDesc->Length);
+    TEST_TRUE(RtlEqualMemory(RxData, UdpFrames[3], RxDesc->Length));
+
+    XSK_STATISTICS Stats = {0};
+    UINT32 StatsSize = sizeof(Stats);
+    GetSockopt(Xsk.Handle.get(), XSK_SOCKOPT_STATISTICS, &Stats, &StatsSize);
+    TEST_EQUAL(0, Stats.RxTruncated);
+    TEST_EQUAL(0, Stats.RxDropped);
+}
+
 VOID
 GenericRxTimestampOffload() {
     auto If = FnMpIf;
@@ -7628,53 +8767,213 @@ GenericTxChecksumOffloadUdp(
 }
 
 VOID
-GenericRxChecksumOffloadUdp(
+GenericTxSegmentationOffloadUdp(
     ADDRESS_FAMILY Af
     )
 {
+    const BOOLEAN Rx = FALSE, Tx = TRUE;
+    auto If = FnMpIf;
+    UINT16 LocalPort, RemotePort;
+    ETHERNET_ADDRESS LocalHw, RemoteHw;
+    INET_ADDR LocalIp, RemoteIp;
+    const UINT16 Mss = 500;
+    const UINT32 SegmentCount = 3;
 
     //
     // Routine Description:
-    //     This test verifies the metadata that indicates RX checksum offloads were done for UDP.
-    //     It does so by injecting a UDP frame with a valid UDP checksum and verifying that
-    //     the metadata is correctly set by the miniport driver.
+    //     Verify a UDP frame requesting segmentation offload is transmitted as
+    //     a sequence of MSS-sized datagrams with valid lengths and checksums,
+    //     and its buffer is completed once.
     //
 
-    RxOffloadPreferences TestOffload = {0};
-    TestOffload.UdpChecksumSucceeded = TRUE;
-    auto Xsk = RxChecksumTestHelper(
-        &TestOffload, FALSE, FALSE, Af);
+    auto Xsk = CreateAndBindSocket(If.GetIfIndex(), If.GetQueueId(), Rx, Tx, XDP_GENERIC);
+    auto UdpSocket = CreateUdpSocket(Af, NULL, &LocalPort);
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
 
-    UINT32 ConsumerIndex;
-    TEST_EQUAL(1, XskRingConsumerReserve(&Xsk.Rings.Rx, 1, &ConsumerIndex));
+    RemotePort = htons(1234);
+    If.GetHwAddress(&LocalHw);
+    If.GetRemoteHwAddress(&RemoteHw);
+    if (Af == AF_INET) {
+        If.GetIpv4Address(&LocalIp.Ipv4);
+        If.GetRemoteIpv4Address(&RemoteIp.Ipv4);
+    } else {
+        If.GetIpv6Address(&LocalIp.Ipv6);
+        If.GetRemoteIpv6Address(&RemoteIp.Ipv6);
+    }
 
-    XSK_FRAME_DESCRIPTOR *RxDesc = SocketGetRxFrameDesc(&Xsk, ConsumerIndex++);
-    TEST_TRUE(Xsk.Extensions.RxFrameChecksumExtension != 0);
-    TEST_TRUE(Xsk.Extensions.RxFrameLayoutExtension != 0);
+    EnableTxSegmentationOffload(&Xsk);
+    ActivateSocket(&Xsk, Rx, Tx);
 
-    // Get and validate checksum metadata
-    XDP_FRAME_CHECKSUM *Checksum =
-        (XDP_FRAME_CHECKSUM *)RTL_PTR_ADD(RxDesc, Xsk.Extensions.RxFrameChecksumExtension);
-    XDP_FRAME_LAYOUT *Layout =
-        (XDP_FRAME_LAYOUT *)RTL_PTR_ADD(RxDesc, Xsk.Extensions.RxFrameLayoutExtension);
+    //
+    // The final segment is shorter than the MSS.
+    //
+    CxPlatVector<UCHAR> UdpPayload(Mss * SegmentCount - Mss / 2);
+    for (UINT32 Index = 0; Index < UdpPayload.size(); Index++) {
+        UdpPayload[Index] = (UCHAR)Index;
+    }
 
-    TEST_EQUAL(XdpFrameRxChecksumEvaluationNotChecked, Checksum->Layer3);
-    TEST_EQUAL(XdpFrameRxChecksumEvaluationSucceeded, Checksum->Layer4);
-    TEST_EQUAL(XdpFrameLayer4TypeUdp, Layout->Layer4Type);
+    UINT64 TxBuffer = SocketFreePop(&Xsk);
+    UCHAR *TxFrame = Xsk.Umem.Buffer.get() + TxBuffer;
+    UINT32 UdpFrameLength = Xsk.Umem.Reg.ChunkSize;
+    TEST_TRUE(
+        PktBuildUdpFrame(
+            TxFrame, &UdpFrameLength, UdpPayload.data(), (UINT16)UdpPayload.size(), &LocalHw,
+            &RemoteHw, Af, &LocalIp, &RemoteIp, LocalPort, RemotePort));
 
-    XskRingConsumerRelease(&Xsk.Rings.Rx, 1);
-}
+    const UINT32 UdpHdrOffset =
+        sizeof(ETHERNET_HEADER) + (Af == AF_INET6 ? sizeof(IPV6_HEADER) : sizeof(IPV4_HEADER));
+    const UINT32 TotalHdrSize = UdpHdrOffset + sizeof(UDP_HDR);
 
-VOID
-GenericTxChecksumOffloadConfig()
-{
-    const auto &If = FnMpIf;
-    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
-    const BOOLEAN Rx = FALSE, Tx = TRUE;
+    CxPlatVector<UCHAR> Mask(sizeof(ETHERNET_HEADER), 0xFF);
+    auto MpFilter = MpTxFilter(GenericMp, TxFrame, &Mask, sizeof(ETHERNET_HEADER));
 
-    auto Xsk = CreateAndBindSocket(If.GetIfIndex(), If.GetQueueId(), Rx, Tx, XDP_GENERIC);
-    EnableTxChecksumOffload(&Xsk);
-    ActivateSocket(&Xsk, Rx, Tx);
+    UINT32 ProducerIndex;
+    TEST_EQUAL(1, XskRingProducerReserve(&Xsk.Rings.Tx, 1, &ProducerIndex));
+
+    XSK_FRAME_DESCRIPTOR *TxDesc = SocketGetTxFrameDesc(&Xsk, ProducerIndex++);
+    TxDesc->Buffer.Address.AddressAndOffset = TxBuffer;
+    TxDesc->Buffer.Length = UdpFrameLength;
+    XDP_FRAME_LAYOUT *Layout =
+        (XDP_FRAME_LAYOUT *)RTL_PTR_ADD(TxDesc, Xsk.Extensions.TxFrameLayoutExtension);
+    Layout->Layer2Type = XdpFrameLayer2TypeEthernet;
+    Layout->Layer2HeaderLength = sizeof(ETHERNET_HEADER);
+    Layout->Layer3Type =
+        Af == AF_INET6 ?
+            XdpFrameLayer3TypeIPv6NoExtensions : XdpFrameLayer3TypeIPv4NoOptions;
+    Layout->Layer3HeaderLength = Af == AF_INET6 ? sizeof(IPV6_HEADER) : sizeof(IPV4_HEADER);
+    Layout->Layer4Type = XdpFrameLayer4TypeUdp;
+    Layout->Layer4HeaderLength = sizeof(UDP_HDR);
+    XDP_FRAME_GSO *Gso =
+        (XDP_FRAME_GSO *)RTL_PTR_ADD(TxDesc, Xsk.Extensions.TxFrameGsoExtension);
+    Gso->UDP.Mss = Mss;
+    XskRingProducerSubmit(&Xsk.Rings.Tx, 1);
+
+    XSK_NOTIFY_RESULT_FLAGS NotifyResult;
+    NotifySocket(Xsk.Handle.get(), XSK_NOTIFY_FLAG_POKE_TX, 0, &NotifyResult);
+    TEST_EQUAL(0, NotifyResult);
+
+    CxPlatVector<UCHAR> FinalPayload;
+
+    for (UINT32 Index = 0; Index < SegmentCount; Index++) {
+        CxPlatVector<UCHAR> FrameData;
+
+        auto MpTxFrame = MpTxAllocateAndGetFrame(GenericMp, Index);
+
+        for (UINT32 i = 0; i < MpTxFrame->BufferCount; i++) {
+            DATA_BUFFER *Buffer = &MpTxFrame->Buffers[i];
+            const UCHAR *PayloadStart = Buffer->VirtualAddress + Buffer->DataOffset;
+            FrameData.insert(
+                FrameData.end(), PayloadStart, PayloadStart + Buffer->DataLength);
+        }
+
+        TEST_TRUE(FrameData.size() > TotalHdrSize);
+        const UINT16 SegmentLength = (UINT16)(FrameData.size() - TotalHdrSize);
+        const IPV4_HEADER *Ipv4 = (const IPV4_HEADER *)&FrameData[sizeof(ETHERNET_HEADER)];
+        const IPV6_HEADER *Ipv6 = (const IPV6_HEADER *)&FrameData[sizeof(ETHERNET_HEADER)];
+        const UDP_HDR *Udp = (const UDP_HDR *)&FrameData[UdpHdrOffset];
+        const VOID *IpSrc;
+        const VOID *IpDst;
+        UINT8 IpAddressLength;
+
+        TEST_EQUAL(
+            Index < SegmentCount - 1 ? Mss : (UINT16)(UdpPayload.size() % Mss), SegmentLength);
+        TEST_EQUAL(htons((UINT16)(sizeof(*Udp) + SegmentLength)), Udp->uh_ulen);
+
+        if (Af == AF_INET) {
+            TEST_EQUAL(
+                htons((UINT16)(FrameData.size() - sizeof(ETHERNET_HEADER))), Ipv4->TotalLength);
+            IpSrc = &Ipv4->SourceAddress;
+            IpDst = &Ipv4->DestinationAddress;
+            IpAddressLength = sizeof(Ipv4->SourceAddress);
+
+            if (!MpTxFrame->Output.Checksum.Transmit.IpHeaderChecksum) {
+                TEST_EQUAL(0ui16, PktChecksum(0, Ipv4, sizeof(*Ipv4)));
+            }
+        } else {
+            TEST_EQUAL(htons((UINT16)(sizeof(*Udp) + SegmentLength)), Ipv6->PayloadLength);
+            IpSrc = &Ipv6->SourceAddress;
+            IpDst = &Ipv6->DestinationAddress;
+            IpAddressLength = sizeof(Ipv6->SourceAddress);
+        }
+
+        const UINT16 UdpPseudoHdrCsum =
+            PktPseudoHeaderChecksum(
+                IpSrc, IpDst, IpAddressLength, sizeof(*Udp) + SegmentLength, IPPROTO_UDP);
+
+        if (MpTxFrame->Output.Checksum.Transmit.UdpChecksum) {
+            TEST_EQUAL(UdpPseudoHdrCsum, Udp->uh_sum);
+        } else {
+            TEST_EQUAL(
+                0ui16, PktChecksum(UdpPseudoHdrCsum, Udp, sizeof(*Udp) + SegmentLength));
+        }
+
+        FinalPayload.insert(FinalPayload.end(), FrameData.begin() + TotalHdrSize, FrameData.end());
+    }
+
+    TEST_EQUAL(UdpPayload.size(), FinalPayload.size());
+    TEST_TRUE(RtlEqualMemory(UdpPayload.data(), FinalPayload.data(), FinalPayload.size()));
+
+    //
+    // The frame is completed only after all of its segments complete.
+    //
+    for (UINT32 Index = 0; Index < SegmentCount; Index++) {
+        MpTxDequeueFrame(GenericMp, 0);
+    }
+    MpTxFlush(GenericMp);
+
+    UINT32 ConsumerIndex = SocketConsumerReserve(&Xsk.Rings.Completion, 1);
+    TEST_EQUAL(TxBuffer, *SocketGetTxCompDesc(&Xsk, ConsumerIndex));
+    XskRingConsumerRelease(&Xsk.Rings.Completion, 1);
+}
+
+VOID
+GenericRxChecksumOffloadUdp(
+    ADDRESS_FAMILY Af
+    )
+{
+
+    //
+    // Routine Description:
+    //     This test verifies the metadata that indicates RX checksum offloads were done for UDP.
+    //     It does so by injecting a UDP frame with a valid UDP checksum and verifying that
+    //     the metadata is correctly set by the miniport driver.
+    //
+
+    RxOffloadPreferences TestOffload = {0};
+    TestOffload.UdpChecksumSucceeded = TRUE;
+    auto Xsk = RxChecksumTestHelper(
+        &TestOffload, FALSE, FALSE, Af);
+
+    UINT32 ConsumerIndex;
+    TEST_EQUAL(1, XskRingConsumerReserve(&Xsk.Rings.Rx, 1, &ConsumerIndex));
+
+    XSK_FRAME_DESCRIPTOR *RxDesc = SocketGetRxFrameDesc(&Xsk, ConsumerIndex++);
+    TEST_TRUE(Xsk.Extensions.RxFrameChecksumExtension != 0);
+    TEST_TRUE(Xsk.Extensions.RxFrameLayoutExtension != 0);
+
+    // Get and validate checksum metadata
+    XDP_FRAME_CHECKSUM *Checksum =
+        (XDP_FRAME_CHECKSUM *)RTL_PTR_ADD(RxDesc, Xsk.Extensions.RxFrameChecksumExtension);
+    XDP_FRAME_LAYOUT *Layout =
+        (XDP_FRAME_LAYOUT *)RTL_PTR_ADD(RxDesc, Xsk.Extensions.RxFrameLayoutExtension);
+
+    TEST_EQUAL(XdpFrameRxChecksumEvaluationNotChecked, Checksum->Layer3);
+    TEST_EQUAL(XdpFrameRxChecksumEvaluationSucceeded, Checksum->Layer4);
+    TEST_EQUAL(XdpFrameLayer4TypeUdp, Layout->Layer4Type);
+
+    XskRingConsumerRelease(&Xsk.Rings.Rx, 1);
+}
+
+VOID
+GenericTxChecksumOffloadConfig()
+{
+    const auto &If = FnMpIf;
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+    const BOOLEAN Rx = FALSE, Tx = TRUE;
+
+    auto Xsk = CreateAndBindSocket(If.GetIfIndex(), If.GetQueueId(), Rx, Tx, XDP_GENERIC);
+    EnableTxChecksumOffload(&Xsk);
+    ActivateSocket(&Xsk, Rx, Tx);
 
     auto PlainXsk = CreateAndActivateSocket(If.GetIfIndex(), If.GetQueueId(), Rx, Tx, XDP_GENERIC);
 
@@ -8127,6 +9426,186 @@ GenericXskWaitAsync(
     TEST_EQUAL(ERROR_OPERATION_ABORTED, GetLastError());
 }
 
+VOID
+GenericXskNotifySet()
+{
+    auto If = FnMpIf;
+    ADDRESS_FAMILY Af = AF_INET;
+    ETHERNET_ADDRESS LocalHw, RemoteHw;
+    INET_ADDR LocalIp, RemoteIp;
+    UCHAR UdpMatchPayload[] = "GenericXskNotifySet";
+    struct {
+        MY_SOCKET Xsk;
+        UINT16 LocalPort;
+        UCHAR UdpFrame[UDP_HEADER_STORAGE + sizeof(UdpMatchPayload)];
+        UINT32 UdpFrameLength;
+    } Sockets[2];
+    XDP_RULE Rules[RTL_NUMBER_OF(Sockets)] = {};
+    XSK_NOTIFY_SET_RESULT Results[RTL_NUMBER_OF(Sockets)];
+    UINT32 ReadyCount;
+    const UINT32 WaitTimeoutMs = 1000;
+    Stopwatch Timer;
+
+    If.GetHwAddress(&LocalHw);
+    If.GetRemoteHwAddress(&RemoteHw);
+    If.GetIpv4Address(&LocalIp.Ipv4);
+    If.GetRemoteIpv4Address(&RemoteIp.Ipv4);
+
+    for (UINT16 Index = 0; Index < RTL_NUMBER_OF(Sockets); Index++) {
+        Sockets[Index].Xsk =
+            CreateAndActivateSocket(If.GetIfIndex(), If.GetQueueId(), TRUE, FALSE, XDP_GENERIC);
+        Sockets[Index].LocalPort = htons(1000 + Index);
+        Sockets[Index].UdpFrameLength = sizeof(Sockets[Index].UdpFrame);
+        TEST_TRUE(
+            PktBuildUdpFrame(
+                Sockets[Index].UdpFrame, &Sockets[Index].UdpFrameLength, UdpMatchPayload,
+                sizeof(UdpMatchPayload), &LocalHw, &RemoteHw, Af, &LocalIp, &RemoteIp,
+                Sockets[Index].LocalPort, htons(2000)));
+
+        Rules[Index].Match = XDP_MATCH_UDP_DST;
+        Rules[Index].Pattern.Port = Sockets[Index].LocalPort;
+        Rules[Index].Action = XDP_PROGRAM_ACTION_REDIRECT;
+        Rules[Index].Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_XSK;
+        Rules[Index].Redirect.Target = Sockets[Index].Xsk.Handle.get();
+
+        SocketProduceRxFill(&Sockets[Index].Xsk, 1);
+    }
+
+    wil::unique_handle ProgramHandle =
+        CreateXdpProg(
+            If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(), XDP_GENERIC,
+            Rules, RTL_NUMBER_OF(Rules));
+
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+
+    wil::unique_handle NotifySet;
+    TEST_HRESULT(XskNotifySetCreate(&NotifySet));
+
+    for (UINT16 Index = 0; Index < RTL_NUMBER_OF(Sockets); Index++) {
+        TEST_HRESULT(
+            XskNotifySetAdd(
+                NotifySet.get(), Sockets[Index].Xsk.Handle.get(), XSK_NOTIFY_FLAG_WAIT_RX,
+                &Sockets[Index]));
+    }
+
+    //
+    // Verify a socket can belong to a single notification set and that only
+    // wait flags are accepted.
+    //
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_BAD_COMMAND),
+        XskNotifySetAdd(
+            NotifySet.get(), Sockets[0].Xsk.Handle.get(), XSK_NOTIFY_FLAG_WAIT_RX, NULL));
+    {
+        wil::unique_handle OtherNotifySet;
+        TEST_HRESULT(XskNotifySetCreate(&OtherNotifySet));
+        TEST_EQUAL(
+            HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER),
+            XskNotifySetAdd(
+                OtherNotifySet.get(), Sockets[0].Xsk.Handle.get(),
+                XSK_NOTIFY_FLAG_WAIT_RX | XSK_NOTIFY_FLAG_POKE_RX, NULL));
+        TEST_EQUAL(
+            HRESULT_FROM_WIN32(ERROR_BAD_COMMAND),
+            XskNotifySetAdd(
+                OtherNotifySet.get(), Sockets[0].Xsk.Handle.get(), XSK_NOTIFY_FLAG_WAIT_RX,
+                NULL));
+    }
+
+    //
+    // Verify the wait times out when no socket has IO available.
+    //
+    Timer.Reset();
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_TIMEOUT),
+        XskNotifySetWait(
+            NotifySet.get(), WaitTimeoutMs, Results, RTL_NUMBER_OF(Results), &ReadyCount));
+    Timer.ExpectElapsed(WaitTimeoutMs);
+
+    //
+    // On another thread, briefly delay execution to give the main test thread
+    // a chance to begin waiting. Then, produce RX on the second socket only.
+    //
+    struct DELAY_INDICATE_THREAD_CONTEXT {
+        UCHAR *Frame;
+        UINT32 FrameLength;
+        NET_IFINDEX IfIndex;
+        UINT32 QueueId;
+    } Ctx;
+    Ctx.Frame = Sockets[1].UdpFrame;
+    Ctx.FrameLength = Sockets[1].UdpFrameLength;
+    Ctx.IfIndex = If.GetIfIndex();
+    Ctx.QueueId = If.GetQueueId();
+
+    CxPlatAsyncT<const DELAY_INDICATE_THREAD_CONTEXT> Async([](const DELAY_INDICATE_THREAD_CONTEXT *Ctx) {
+        auto GenericMp = MpOpenGeneric(Ctx->IfIndex);
+        DATA_BUFFER Buffer = {0};
+        RX_FRAME Frame;
+
+        CxPlatSleep(10);
+
+        Buffer.DataLength = Ctx->FrameLength;
+        Buffer.BufferLength = Buffer.DataLength;
+        Buffer.VirtualAddress = Ctx->Frame;
+        RxInitializeFrame(&Frame, Ctx->QueueId, &Buffer);
+        TEST_HRESULT(MpRxIndicateFrame(GenericMp, &Frame));
+    }, &Ctx);
+
+    //
+    // Verify a single wait wakes up for IO on any member, and reports only the
+    // ready member.
+    //
+    Timer.Reset(TEST_TIMEOUT_ASYNC_MS);
+    TEST_HRESULT(
+        XskNotifySetWait(
+            NotifySet.get(), WaitTimeoutMs, Results, RTL_NUMBER_OF(Results), &ReadyCount));
+    TEST_FALSE(Timer.IsExpired());
+    TEST_TRUE(Async.WaitFor(TEST_TIMEOUT_ASYNC_MS));
+    TEST_EQUAL(1, ReadyCount);
+    TEST_EQUAL((VOID *)&Sockets[1], Results[0].Context);
+    TEST_EQUAL(XSK_NOTIFY_RESULT_FLAG_RX_AVAILABLE, Results[0].Flags);
+
+    //
+    // Verify the wait is level-triggered: the socket is reported until its RX
+    // ring is consumed.
+    //
+    TEST_HRESULT(
+        XskNotifySetWait(NotifySet.get(), 0, Results, RTL_NUMBER_OF(Results), &ReadyCount));
+    TEST_EQUAL(1, ReadyCount);
+    TEST_EQUAL((VOID *)&Sockets[1], Results[0].Context);
+
+    UINT32 ConsumerIndex = SocketConsumerReserve(&Sockets[1].Xsk.Rings.Rx, 1);
+    auto RxDesc = SocketGetAndFreeRxDesc(&Sockets[1].Xsk, ConsumerIndex);
+    TEST_EQUAL(Sockets[1].UdpFrameLength, RxDesc->Length);
+    XskRingConsumerRelease(&Sockets[1].Xsk.Rings.Rx, 1);
+
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_TIMEOUT),
+        XskNotifySetWait(NotifySet.get(), 0, Results, RTL_NUMBER_OF(Results), &ReadyCount));
+
+    //
+    // Verify removed sockets no longer satisfy the wait.
+    //
+    TEST_HRESULT(XskNotifySetRemove(NotifySet.get(), Sockets[1].Xsk.Handle.get()));
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_NOT_FOUND),
+        XskNotifySetRemove(NotifySet.get(), Sockets[1].Xsk.Handle.get()));
+
+    DATA_BUFFER Buffer = {0};
+    RX_FRAME Frame;
+    Buffer.DataLength = Sockets[1].UdpFrameLength;
+    Buffer.BufferLength = Buffer.DataLength;
+    Buffer.VirtualAddress = Sockets[1].UdpFrame;
+    RxInitializeFrame(&Frame, If.GetQueueId(), &Buffer);
+
+    SocketProduceRxFill(&Sockets[1].Xsk, 1);
+    TEST_HRESULT(MpRxIndicateFrame(GenericMp, &Frame));
+    SocketConsumerReserve(&Sockets[1].Xsk.Rings.Rx, 1);
+
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_TIMEOUT),
+        XskNotifySetWait(NotifySet.get(), 0, Results, RTL_NUMBER_OF(Results), &ReadyCount));
+}
+
 VOID
 GenericLwfDelayDetach(
     _In_ BOOLEAN Rx,
@@ -10362,7 +11841,7 @@ XskMapCreateInsertDelete()
 }
 
 VOID
-GenericRxXskMapRedirect(
+GenericRxEbpfXskMapRedirect(
     _In_ ADDRESS_FAMILY Af
     )
 {
@@ -10371,9 +11850,11 @@ GenericRxXskMapRedirect(
     UINT16 RemotePort = htons(1234);
     ETHERNET_ADDRESS LocalHw, RemoteHw;
     INET_ADDR LocalIp, RemoteIp;
+    unique_bpf_object BpfObject;
 
     auto Socket = CreateUdpSocket(Af, &If, &LocalPort);
     auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+    auto FnLwf = LwfOpenDefault(If.GetIfIndex());
 
     If.GetHwAddress(&LocalHw);
     If.GetRemoteHwAddress(&RemoteHw);
@@ -10390,36 +11871,124 @@ GenericRxXskMapRedirect(
             If.GetIfIndex(), If.GetQueueId(), TRUE, FALSE, XDP_GENERIC);
 
     //
-    // Create an XSKMAP and insert the XSK at the queue ID key.
+    // The redirect_xsk program redirects every frame to the XSK at key 0,
+    // falling back to XDP_PASS while the key is empty.
     //
     wil::unique_handle XskMap;
     TEST_HRESULT(XdpMapCreate(&XskMap, XDP_MAP_TYPE_XSKMAP));
-    UINT32 InsertKey = If.GetQueueId();
-    HANDLE InsertValue = Xsk.Handle.get();
-    TEST_HRESULT(XdpMapInsert(XskMap.get(), &InsertKey, &InsertValue));
-
-    //
-    // Create an XDP program with redirect-by-queue-id action.
-    //
-    XDP_RULE Rule;
-    Rule.Match = XDP_MATCH_UDP_DST;
-    Rule.Pattern.Port = LocalPort;
-    Rule.Action = XDP_PROGRAM_ACTION_REDIRECT;
-    Rule.Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_QUEUEID;
-    Rule.Redirect.Target = XskMap.get();
 
-    wil::unique_handle ProgramHandle =
-        CreateXdpProg(
-            If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(), XDP_GENERIC, &Rule, 1,
-            XDP_CREATE_PROGRAM_FLAG_ALL_QUEUES);
+    unique_bpf_link BpfLink =
+        AttachEbpfXdpProgramWithXskMap(
+            BpfObject, If, "\\bpf\\redirect_xsk.sys", "redirect_xsk", XskMap.get());
 
-    const UCHAR Payload[] = "GenericRxXskMapRedirect";
+    const UCHAR Payload[] = "GenericRxEbpfXskMapRedirect";
+    UINT16 PayloadLength = sizeof(Payload);
+    UCHAR PacketBuffer[UDP_HEADER_STORAGE + sizeof(Payload)];
+    UINT32 PacketBufferLength = sizeof(PacketBuffer);
+    TEST_TRUE(
+        PktBuildUdpFrame(
+            PacketBuffer, &PacketBufferLength, Payload, PayloadLength, &LocalHw,
+            &RemoteHw, Af, &LocalIp, &RemoteIp, LocalPort, RemotePort));
+
+    SocketProduceRxFill(&Xsk, 1);
+
+    //
+    // With no XSK in the map, the frame is passed.
+    //
+    CxPlatVector<UCHAR> Mask(PacketBufferLength, 0xFF);
+    auto LwfFilter = LwfRxFilter(FnLwf, PacketBuffer, Mask.data(), PacketBufferLength);
+
+    RX_FRAME Frame;
+    RxInitializeFrame(&Frame, If.GetQueueId(), PacketBuffer, PacketBufferLength);
+    TEST_HRESULT(MpRxIndicateFrame(GenericMp, &Frame));
+
+    LwfRxAllocateAndGetFrame(FnLwf, If.GetQueueId());
+    LwfRxDequeueFrame(FnLwf, If.GetQueueId());
+    LwfRxFlush(FnLwf);
+
+    //
+    // Once the XSK is inserted, the frame is redirected to it.
+    //
+    UINT32 InsertKey = 0;
+    HANDLE InsertValue = Xsk.Handle.get();
+    TEST_HRESULT(XdpMapInsert(XskMap.get(), &InsertKey, &InsertValue));
+
+    TEST_HRESULT(MpRxIndicateFrame(GenericMp, &Frame));
+
+    UINT32 ConsumerIndex = SocketConsumerReserve(&Xsk.Rings.Rx, 1);
+    auto RxDesc = SocketGetAndFreeRxDesc(&Xsk, ConsumerIndex);
+    TEST_EQUAL(PacketBufferLength, RxDesc->Length);
+    TEST_TRUE(
+        RtlEqualMemory(
+            Xsk.Umem.Buffer.get() + RxDesc->Address.BaseAddress + RxDesc->Address.Offset,
+            PacketBuffer,
+            PacketBufferLength));
+
+    UINT32 FrameLength = 0;
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_NOT_FOUND),
+        LwfRxGetFrame(FnLwf, If.GetQueueId(), &FrameLength, NULL));
+}
+
+VOID
+GenericRxXskMapRedirect(
+    _In_ ADDRESS_FAMILY Af
+    )
+{
+    auto If = FnMpIf;
+    UINT16 LocalPort;
+    UINT16 RemotePort = htons(1234);
+    ETHERNET_ADDRESS LocalHw, RemoteHw;
+    INET_ADDR LocalIp, RemoteIp;
+
+    auto Socket = CreateUdpSocket(Af, &If, &LocalPort);
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+
+    If.GetHwAddress(&LocalHw);
+    If.GetRemoteHwAddress(&RemoteHw);
+    if (Af == AF_INET) {
+        If.GetIpv4Address(&LocalIp.Ipv4);
+        If.GetRemoteIpv4Address(&RemoteIp.Ipv4);
+    } else {
+        If.GetIpv6Address(&LocalIp.Ipv6);
+        If.GetRemoteIpv6Address(&RemoteIp.Ipv6);
+    }
+
+    auto Xsk =
+        CreateAndActivateSocket(
+            If.GetIfIndex(), If.GetQueueId(), TRUE, FALSE, XDP_GENERIC);
+
+    //
+    // Create an XSKMAP and insert the XSK at the queue ID key.
+    //
+    wil::unique_handle XskMap;
+    TEST_HRESULT(XdpMapCreate(&XskMap, XDP_MAP_TYPE_XSKMAP));
+    UINT32 InsertKey = If.GetQueueId();
+    HANDLE InsertValue = Xsk.Handle.get();
+    TEST_HRESULT(XdpMapInsert(XskMap.get(), &InsertKey, &InsertValue));
+
+    //
+    // Create an XDP program with redirect-by-queue-id action.
+    //
+    XDP_RULE Rule;
+    Rule.Match = XDP_MATCH_UDP_DST;
+    Rule.Pattern.Port = LocalPort;
+    Rule.Action = XDP_PROGRAM_ACTION_REDIRECT;
+    Rule.Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_QUEUEID;
+    Rule.Redirect.Target = XskMap.get();
+
+    wil::unique_handle ProgramHandle =
+        CreateXdpProg(
+            If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(), XDP_GENERIC, &Rule, 1,
+            XDP_CREATE_PROGRAM_FLAG_ALL_QUEUES);
+
+    const UCHAR Payload[] = "GenericRxXskMapRedirect";
     UINT16 PayloadLength = sizeof(Payload);
     UCHAR PacketBuffer[UDP_HEADER_STORAGE + sizeof(Payload)];
     UINT32 PacketBufferLength = sizeof(PacketBuffer);
 
-    SocketProduceRxFill(&Xsk, 2);
-
+    SocketProduceRxFill(&Xsk, 2);
+
     //
     // Indicate a packet on the right RX queue.
     //
@@ -10445,6 +12014,234 @@ GenericRxXskMapRedirect(
             PacketBufferLength));
 }
 
+VOID
+GenericRxXskMapFlowHashRedirect(
+    _In_ ADDRESS_FAMILY Af
+    )
+{
+    auto If = FnMpIf;
+    UINT16 LocalPort;
+    ETHERNET_ADDRESS LocalHw, RemoteHw;
+    INET_ADDR LocalIp, RemoteIp;
+    const UINT32 FlowHashWidth = 4;
+    const UINT32 FlowCount = 16;
+
+    auto Socket = CreateUdpSocket(Af, &If, &LocalPort);
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+
+    If.GetHwAddress(&LocalHw);
+    If.GetRemoteHwAddress(&RemoteHw);
+    if (Af == AF_INET) {
+        If.GetIpv4Address(&LocalIp.Ipv4);
+        If.GetRemoteIpv4Address(&RemoteIp.Ipv4);
+    } else {
+        If.GetIpv6Address(&LocalIp.Ipv6);
+        If.GetRemoteIpv6Address(&RemoteIp.Ipv6);
+    }
+
+    auto Xsk =
+        CreateAndActivateSocket(
+            If.GetIfIndex(), If.GetQueueId(), TRUE, FALSE, XDP_GENERIC);
+
+    //
+    // Create an XSKMAP and insert the XSK at every key within the hash width.
+    //
+    wil::unique_handle XskMap;
+    TEST_HRESULT(XdpMapCreate(&XskMap, XDP_MAP_TYPE_XSKMAP));
+    HANDLE InsertValue = Xsk.Handle.get();
+    for (UINT32 InsertKey = 0; InsertKey < FlowHashWidth; InsertKey++) {
+        TEST_HRESULT(XdpMapInsert(XskMap.get(), &InsertKey, &InsertValue));
+    }
+
+    //
+    // The hash width must be within the XSKMAP's bounds.
+    //
+    XDP_RULE Rule;
+    Rule.Match = XDP_MATCH_UDP_DST;
+    Rule.Pattern.Port = LocalPort;
+    Rule.Action = XDP_PROGRAM_ACTION_REDIRECT;
+    Rule.Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_FLOW_HASH;
+    Rule.Redirect.Target = XskMap.get();
+
+    wil::unique_handle ProgramHandle;
+    Rule.Redirect.FlowHashWidth = 0;
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER),
+        TryCreateXdpProg(
+            ProgramHandle, If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(),
+            XDP_GENERIC, &Rule, 1));
+    Rule.Redirect.FlowHashWidth = XDP_REDIRECT_MAX_FLOW_HASH_WIDTH + 1;
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER),
+        TryCreateXdpProg(
+            ProgramHandle, If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(),
+            XDP_GENERIC, &Rule, 1));
+
+    //
+    // Create an XDP program that spreads flows across the populated keys.
+    //
+    Rule.Redirect.FlowHashWidth = FlowHashWidth;
+    ProgramHandle =
+        CreateXdpProg(
+            If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(), XDP_GENERIC, &Rule, 1);
+
+    const UCHAR Payload[] = "GenericRxXskMapFlowHashRedirect";
+    UCHAR PacketBuffer[UDP_HEADER_STORAGE + sizeof(Payload)];
+
+    SocketProduceRxFill(&Xsk, FlowCount);
+
+    //
+    // Indicate one packet on each of several flows. Every key within the hash
+    // width has an entry, so every packet is received by the XSK.
+    //
+    for (UINT32 i = 0; i < FlowCount; i++) {
+        UINT32 PacketBufferLength = sizeof(PacketBuffer);
+        UINT16 RemotePort = htons((UINT16)(1234 + i));
+        RX_FRAME Frame;
+
+        TEST_TRUE(
+            PktBuildUdpFrame(
+                PacketBuffer, &PacketBufferLength, Payload, sizeof(Payload), &LocalHw,
+                &RemoteHw, Af, &LocalIp, &RemoteIp, LocalPort, RemotePort));
+        RxInitializeFrame(&Frame, If.GetQueueId(), PacketBuffer, PacketBufferLength);
+        TEST_HRESULT(MpRxIndicateFrame(GenericMp, &Frame));
+
+        UINT32 ConsumerIndex = SocketConsumerReserve(&Xsk.Rings.Rx, 1);
+        auto RxDesc = SocketGetAndFreeRxDesc(&Xsk, ConsumerIndex);
+        TEST_EQUAL(PacketBufferLength, RxDesc->Length);
+        XskRingConsumerRelease(&Xsk.Rings.Rx, 1);
+    }
+}
+
+VOID
+GenericRxRedirectInterfaceTx()
+{
+    auto RxIf = FnMpIf;
+    auto TxIf = FnMp1QIf;
+    const UINT32 Backfill = 3;
+    const UINT32 Trailer = 4;
+    DATA_BUFFER Buffers[2] = {};
+    const UCHAR Payload[] = "123GenericRxRedirectInterfaceTx4321";
+    const UINT32 FrameLength = sizeof(Payload) - Backfill - Trailer;
+
+    auto RxGenericMp = MpOpenGeneric(RxIf.GetIfIndex());
+    auto TxGenericMp = MpOpenGeneric(TxIf.GetIfIndex());
+
+    XDP_RULE Rule = {};
+    Rule.Match = XDP_MATCH_ALL;
+    Rule.Action = XDP_PROGRAM_ACTION_REDIRECT;
+    Rule.Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_INTERFACE_TX;
+    Rule.Redirect.IfIndex = TxIf.GetIfIndex();
+    Rule.Redirect.QueueId = TxIf.GetQueueId();
+
+    //
+    // Forward all frames received on one interface to the XDP TX queue of
+    // another.
+    //
+    wil::unique_handle ProgramHandle =
+        CreateXdpProg(
+            RxIf.GetIfIndex(), &XdpInspectRxL2, RxIf.GetQueueId(), XDP_GENERIC, &Rule, 1);
+
+    //
+    // Split the received frame across two buffers; it is transmitted as a
+    // single buffer.
+    //
+    Buffers[0].DataLength = FrameLength / 2;
+    Buffers[0].DataOffset = Backfill;
+    Buffers[0].BufferLength = Backfill + Buffers[0].DataLength;
+    Buffers[0].VirtualAddress = Payload;
+    Buffers[1].DataLength = FrameLength - Buffers[0].DataLength;
+    Buffers[1].DataOffset = 0;
+    Buffers[1].BufferLength = Buffers[1].DataLength + Trailer;
+    Buffers[1].VirtualAddress = Payload + Buffers[0].BufferLength;
+
+    CxPlatVector<UCHAR> Mask(FrameLength, 0xFF);
+    auto MpFilter = MpTxFilter(TxGenericMp, Payload + Backfill, Mask.data(), FrameLength);
+
+    RX_FRAME Frame;
+    RxInitializeFrame(&Frame, RxIf.GetQueueId(), Buffers, RTL_NUMBER_OF(Buffers));
+    TEST_HRESULT(MpRxEnqueueFrame(RxGenericMp, &Frame));
+    MpRxFlush(RxGenericMp);
+
+    auto MpTxFrame = MpTxAllocateAndGetFrame(TxGenericMp, TxIf.GetQueueId());
+    TEST_EQUAL(1, MpTxFrame->BufferCount);
+    TEST_EQUAL(FrameLength, MpTxFrame->Buffers[0].DataLength);
+    MpTxDequeueFrame(TxGenericMp, TxIf.GetQueueId());
+    MpTxFlush(TxGenericMp);
+}
+
+VOID
+GenericRxRateLimit()
+{
+    auto If = FnMpIf;
+    const UINT32 BurstSize = 2;
+    const UINT32 FrameCount = BurstSize * 2;
+    const UCHAR Payload[] = "GenericRxRateLimitFrame";
+    const UINT32 FrameLength = sizeof(Payload);
+
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+
+    XDP_RULE Rule = {};
+    Rule.Match = XDP_MATCH_ALL;
+    Rule.Action = XDP_PROGRAM_ACTION_RATE_LIMIT;
+    Rule.RateLimit.FramesPerSecond = 1;
+    Rule.RateLimit.BurstSize = BurstSize;
+    Rule.RateLimit.ConformAction = XDP_PROGRAM_ACTION_L2FWD;
+
+    //
+    // Zero rates and terminal conform actions are invalid.
+    //
+    wil::unique_handle ProgramHandle;
+    Rule.RateLimit.FramesPerSecond = 0;
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER),
+        TryCreateXdpProg(
+            ProgramHandle, If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(),
+            XDP_GENERIC, &Rule, 1));
+    Rule.RateLimit.FramesPerSecond = 1;
+
+    Rule.RateLimit.ConformAction = XDP_PROGRAM_ACTION_DROP;
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER),
+        TryCreateXdpProg(
+            ProgramHandle, If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(),
+            XDP_GENERIC, &Rule, 1));
+    Rule.RateLimit.ConformAction = XDP_PROGRAM_ACTION_L2FWD;
+
+    ProgramHandle =
+        CreateXdpProg(
+            If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(), XDP_GENERIC, &Rule, 1);
+
+    //
+    // Ignore the Ethernet addresses, which are swapped by the conform action.
+    //
+    CxPlatVector<UCHAR> Mask(FrameLength, 0xFF);
+    RtlZeroMemory(Mask.data(), 2 * sizeof(ETHERNET_ADDRESS));
+    auto MpFilter = MpTxFilter(GenericMp, Payload, Mask.data(), FrameLength);
+
+    //
+    // Indicate more frames than the burst size in a single batch; at a rate of
+    // one frame per second, only the burst conforms and the rest are dropped.
+    //
+    for (UINT32 i = 0; i < FrameCount; i++) {
+        RX_FRAME Frame;
+        RxInitializeFrame(&Frame, If.GetQueueId(), Payload, FrameLength);
+        TEST_HRESULT(MpRxEnqueueFrame(GenericMp, &Frame));
+    }
+    MpRxFlush(GenericMp);
+
+    for (UINT32 i = 0; i < BurstSize; i++) {
+        auto MpTxFrame = MpTxAllocateAndGetFrame(GenericMp, i);
+        TEST_EQUAL(FrameLength, MpTxFrame->Buffers[0].DataLength);
+    }
+    MpTxVerifyNoFrame(GenericMp, BurstSize);
+
+    for (UINT32 i = 0; i < BurstSize; i++) {
+        MpTxDequeueFrame(GenericMp, 0);
+    }
+    MpTxFlush(GenericMp);
+}
+
 VOID
 GenericRxXskMapRedirectMiss()
 {
@@ -10520,6 +12317,555 @@ GenericRxXskMapRedirectMiss()
     TEST_EQUAL(0, XskRingConsumerReserve(&Xsk.Rings.Rx, MAXUINT32, &ConsumerIndex));
 }
 
+VOID
+QuicCidMapCreateInsertDelete()
+{
+    //
+    // Create a QUIC CID map, insert and replace an XSK, delete the entry, and
+    // close the map.
+    //
+    auto If = FnMpIf;
+
+    auto Xsk =
+        CreateAndActivateSocket(
+            If.GetIfIndex(), If.GetQueueId(), TRUE, FALSE, XDP_GENERIC);
+
+    wil::unique_handle CidMap;
+    TEST_HRESULT(XdpMapCreate(&CidMap, XDP_MAP_TYPE_QUIC_CID));
+    TEST_TRUE(CidMap.get() != NULL);
+
+    XDP_QUIC_CID_MAP_KEY Key = {0};
+    HANDLE Value = Xsk.Handle.get();
+
+    //
+    // Insert a CID, then insert it again to replace the entry.
+    //
+    Key.CidLength = 8;
+    RtlFillMemory(Key.CidData, Key.CidLength, 0x5a);
+    TEST_HRESULT(XdpMapInsert(CidMap.get(), &Key, &Value));
+    TEST_HRESULT(XdpMapInsert(CidMap.get(), &Key, &Value));
+
+    //
+    // Insert a CID of the maximum length.
+    //
+    Key.CidLength = XDP_QUIC_MAX_CID_LENGTH;
+    TEST_HRESULT(XdpMapInsert(CidMap.get(), &Key, &Value));
+
+    //
+    // Insert a CID exceeding the maximum length should fail.
+    //
+    Key.CidLength = XDP_QUIC_MAX_CID_LENGTH + 1;
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER),
+        XdpMapInsert(CidMap.get(), &Key, &Value));
+
+    //
+    // Insert enough CIDs to grow the table several times.
+    //
+    Key.CidLength = sizeof(UINT32);
+    for (UINT32 i = 0; i < 1024; i++) {
+        RtlCopyMemory(Key.CidData, &i, sizeof(i));
+        TEST_HRESULT(XdpMapInsert(CidMap.get(), &Key, &Value));
+    }
+
+    //
+    // Delete an existing CID.
+    //
+    Key.CidLength = 8;
+    RtlFillMemory(Key.CidData, Key.CidLength, 0x5a);
+    TEST_HRESULT(XdpMapDelete(CidMap.get(), &Key));
+
+    //
+    // Delete a CID that doesn't have an entry (should succeed).
+    //
+    TEST_HRESULT(XdpMapDelete(CidMap.get(), &Key));
+
+    //
+    // A QUIC CID map cannot be used with the queue ID redirect target type.
+    //
+    XDP_RULE Rule;
+    Rule.Match = XDP_MATCH_ALL;
+    Rule.Action = XDP_PROGRAM_ACTION_REDIRECT;
+    Rule.Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_QUEUEID;
+    Rule.Redirect.Target = CidMap.get();
+
+    wil::unique_handle ProgramHandle;
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER),
+        TryCreateXdpProg(
+            ProgramHandle, If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(),
+            XDP_GENERIC, &Rule, 1));
+
+    //
+    // The QUIC CID map match types require the QUIC CID map target type.
+    //
+    Rule.Match = XDP_MATCH_QUIC_FLOW_DST_CID_MAP;
+    Rule.Pattern.QuicFlow = {};
+    Rule.Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_XSK;
+    Rule.Redirect.Target = Xsk.Handle.get();
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER),
+        TryCreateXdpProg(
+            ProgramHandle, If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(),
+            XDP_GENERIC, &Rule, 1));
+}
+
+VOID
+GenericRxQuicCidMapRedirect(
+    _In_ ADDRESS_FAMILY Af
+    )
+{
+    auto If = FnMpIf;
+    UINT16 LocalPort;
+    UINT16 RemotePort = htons(1234);
+    ETHERNET_ADDRESS LocalHw, RemoteHw;
+    INET_ADDR LocalIp, RemoteIp;
+
+    auto Socket = CreateUdpSocket(Af, &If, &LocalPort);
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+
+    If.GetHwAddress(&LocalHw);
+    If.GetRemoteHwAddress(&RemoteHw);
+    if (Af == AF_INET) {
+        If.GetIpv4Address(&LocalIp.Ipv4);
+        If.GetRemoteIpv4Address(&RemoteIp.Ipv4);
+    } else {
+        If.GetIpv6Address(&LocalIp.Ipv6);
+        If.GetRemoteIpv6Address(&RemoteIp.Ipv6);
+    }
+
+    auto Xsk =
+        CreateAndActivateSocket(
+            If.GetIfIndex(), If.GetQueueId(), TRUE, FALSE, XDP_GENERIC);
+
+    const UCHAR Payload[20] = {
+        0x00, // IsLongHeader
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, // DestCid
+        0x00 // The rest
+    };
+
+    //
+    // Create a QUIC CID map and insert the XSK at a slice of the CID.
+    //
+    wil::unique_handle CidMap;
+    TEST_HRESULT(XdpMapCreate(&CidMap, XDP_MAP_TYPE_QUIC_CID));
+    XDP_QUIC_CID_MAP_KEY Key = {0};
+    Key.CidLength = 4;
+    RtlCopyMemory(Key.CidData, &Payload[1 + 2], Key.CidLength);
+    HANDLE InsertValue = Xsk.Handle.get();
+    TEST_HRESULT(XdpMapInsert(CidMap.get(), &Key, &InsertValue));
+
+    //
+    // Create an XDP program that redirects via the QUIC CID map.
+    //
+    XDP_RULE Rule;
+    Rule.Match = XDP_MATCH_QUIC_FLOW_DST_CID_MAP;
+    Rule.Pattern.QuicFlow = {};
+    Rule.Pattern.QuicFlow.UdpPort = LocalPort;
+    Rule.Pattern.QuicFlow.CidOffset = 2;
+    Rule.Pattern.QuicFlow.CidLength = 4;
+    Rule.Action = XDP_PROGRAM_ACTION_REDIRECT;
+    Rule.Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_QUIC_CID_MAP;
+    Rule.Redirect.Target = CidMap.get();
+
+    wil::unique_handle ProgramHandle =
+        CreateXdpProg(
+            If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(), XDP_GENERIC, &Rule, 1);
+
+    UCHAR PacketBuffer[UDP_HEADER_STORAGE + sizeof(Payload)];
+    UINT32 PacketBufferLength = sizeof(PacketBuffer);
+
+    SocketProduceRxFill(&Xsk, 2);
+
+    RX_FRAME Frame;
+    TEST_TRUE(
+        PktBuildUdpFrame(
+            PacketBuffer, &PacketBufferLength, Payload, sizeof(Payload), &LocalHw,
+            &RemoteHw, Af, &LocalIp, &RemoteIp, LocalPort, RemotePort));
+    RxInitializeFrame(&Frame, If.GetQueueId(), PacketBuffer, PacketBufferLength);
+    TEST_HRESULT(MpRxIndicateFrame(GenericMp, &Frame));
+
+    //
+    // Verify the packet is received by the XSK socket.
+    //
+    UINT32 ConsumerIndex = SocketConsumerReserve(&Xsk.Rings.Rx, 1);
+    auto RxDesc = SocketGetAndFreeRxDesc(&Xsk, ConsumerIndex);
+    TEST_EQUAL(PacketBufferLength, RxDesc->Length);
+    TEST_TRUE(
+        RtlEqualMemory(
+            Xsk.Umem.Buffer.get() + RxDesc->Address.BaseAddress + RxDesc->Address.Offset,
+            PacketBuffer,
+            PacketBufferLength));
+    XskRingConsumerRelease(&Xsk.Rings.Rx, 1);
+
+    //
+    // Delete the CID without updating the program. The rule no longer matches,
+    // so the packet is not redirected.
+    //
+    TEST_HRESULT(XdpMapDelete(CidMap.get(), &Key));
+    TEST_HRESULT(MpRxIndicateFrame(GenericMp, &Frame));
+
+    CxPlatSleep(TEST_TIMEOUT_ASYNC_MS * 2);
+    TEST_EQUAL(0, XskRingConsumerReserve(&Xsk.Rings.Rx, MAXUINT32, &ConsumerIndex));
+}
+
+VOID
+HashMapCreateInsertDelete()
+{
+    //
+    // Create a hash map, insert and replace flows, delete an entry, and close
+    // the map.
+    //
+    auto If = FnMpIf;
+
+    auto Xsk =
+        CreateAndActivateSocket(
+            If.GetIfIndex(), If.GetQueueId(), TRUE, FALSE, XDP_GENERIC);
+
+    wil::unique_handle HashMap;
+    TEST_HRESULT(XdpMapCreate(&HashMap, XDP_MAP_TYPE_HASH));
+    TEST_TRUE(HashMap.get() != NULL);
+
+    XDP_HASH_MAP_KEY Key = {0};
+    XDP_MAP_ACTION_VALUE Value = {0};
+
+    Key.AddressFamily = AF_INET;
+    Key.IpProtocol = IPPROTO_UDP;
+    Key.Tuple.SourceAddress.Ipv4.s_addr = htonl(0x0a000001);
+    Key.Tuple.DestinationAddress.Ipv4.s_addr = htonl(0x0a000002);
+    Key.Tuple.SourcePort = htons(1234);
+    Key.Tuple.DestinationPort = htons(443);
+
+    //
+    // Insert a redirect entry, then replace it with a drop entry.
+    //
+    Value.Action = XDP_PROGRAM_ACTION_REDIRECT;
+    Value.Xsk = Xsk.Handle.get();
+    TEST_HRESULT(XdpMapInsert(HashMap.get(), &Key, &Value));
+    Value.Action = XDP_PROGRAM_ACTION_DROP;
+    Value.Xsk = NULL;
+    TEST_HRESULT(XdpMapInsert(HashMap.get(), &Key, &Value));
+
+    //
+    // Invalid actions, protocols, and address families should fail.
+    //
+    Value.Action = XDP_PROGRAM_ACTION_L2FWD;
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER),
+        XdpMapInsert(HashMap.get(), &Key, &Value));
+    Value.Action = XDP_PROGRAM_ACTION_PASS;
+
+    Key.IpProtocol = IPPROTO_ICMP;
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER),
+        XdpMapInsert(HashMap.get(), &Key, &Value));
+    Key.IpProtocol = IPPROTO_TCP;
+
+    Key.AddressFamily = AF_UNSPEC;
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER),
+        XdpMapInsert(HashMap.get(), &Key, &Value));
+    Key.AddressFamily = AF_INET6;
+
+    //
+    // Insert enough flows to grow the table several times.
+    //
+    for (UINT32 i = 0; i < 1024; i++) {
+        Key.Tuple.SourcePort = htons((UINT16)(1024 + i));
+        TEST_HRESULT(XdpMapInsert(HashMap.get(), &Key, &Value));
+    }
+
+    //
+    // Delete an existing flow, then delete it again (should succeed).
+    //
+    TEST_HRESULT(XdpMapDelete(HashMap.get(), &Key));
+    TEST_HRESULT(XdpMapDelete(HashMap.get(), &Key));
+
+    //
+    // A hash map cannot be used with the LPM redirect target types.
+    //
+    XDP_RULE Rule;
+    Rule.Match = XDP_MATCH_ALL;
+    Rule.Action = XDP_PROGRAM_ACTION_REDIRECT;
+    Rule.Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_DST_ADDR;
+    Rule.Redirect.Target = HashMap.get();
+
+    wil::unique_handle ProgramHandle;
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER),
+        TryCreateXdpProg(
+            ProgramHandle, If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(),
+            XDP_GENERIC, &Rule, 1));
+}
+
+VOID
+LpmMapCreateInsertDelete()
+{
+    //
+    // Create an LPM map, insert prefixes of various lengths, delete a prefix,
+    // and close the map.
+    //
+    auto If = FnMpIf;
+
+    wil::unique_handle LpmMap;
+    TEST_HRESULT(XdpMapCreate(&LpmMap, XDP_MAP_TYPE_LPM));
+    TEST_TRUE(LpmMap.get() != NULL);
+
+    XDP_LPM_MAP_KEY Key = {0};
+    XDP_MAP_ACTION_VALUE Value = {0};
+    Value.Action = XDP_PROGRAM_ACTION_DROP;
+
+    //
+    // Insert every IPv4 and IPv6 prefix length, including the default route.
+    //
+    Key.AddressFamily = AF_INET;
+    Key.Address.Ipv4.s_addr = htonl(0x0a010203);
+    for (UINT8 i = 0; i <= 32; i++) {
+        Key.PrefixLength = i;
+        TEST_HRESULT(XdpMapInsert(LpmMap.get(), &Key, &Value));
+    }
+
+    Key.AddressFamily = AF_INET6;
+    RtlFillMemory(&Key.Address.Ipv6, sizeof(Key.Address.Ipv6), 0x20);
+    for (UINT8 i = 0; i <= 128; i++) {
+        Key.PrefixLength = i;
+        TEST_HRESULT(XdpMapInsert(LpmMap.get(), &Key, &Value));
+    }
+
+    //
+    // Prefixes longer than the address should fail.
+    //
+    Key.PrefixLength = 129;
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER),
+        XdpMapInsert(LpmMap.get(), &Key, &Value));
+
+    Key.AddressFamily = AF_INET;
+    Key.PrefixLength = 33;
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER),
+        XdpMapInsert(LpmMap.get(), &Key, &Value));
+
+    //
+    // Address bits beyond the prefix are ignored, so this deletes the /16
+    // prefix inserted above. Deleting it again should succeed.
+    //
+    Key.PrefixLength = 16;
+    Key.Address.Ipv4.s_addr = htonl(0x0a01ffff);
+    TEST_HRESULT(XdpMapDelete(LpmMap.get(), &Key));
+    TEST_HRESULT(XdpMapDelete(LpmMap.get(), &Key));
+
+    //
+    // An LPM map cannot be used with the hash map redirect target type.
+    //
+    XDP_RULE Rule;
+    Rule.Match = XDP_MATCH_ALL;
+    Rule.Action = XDP_PROGRAM_ACTION_REDIRECT;
+    Rule.Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_HASH_MAP_BY_FLOW;
+    Rule.Redirect.Target = LpmMap.get();
+
+    wil::unique_handle ProgramHandle;
+    TEST_EQUAL(
+        HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER),
+        TryCreateXdpProg(
+            ProgramHandle, If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(),
+            XDP_GENERIC, &Rule, 1));
+}
+
+VOID
+GenericRxHashMapRedirect(
+    _In_ ADDRESS_FAMILY Af
+    )
+{
+    auto If = FnMpIf;
+    UINT16 LocalPort;
+    UINT16 RemotePort = htons(1234);
+    ETHERNET_ADDRESS LocalHw, RemoteHw;
+    INET_ADDR LocalIp, RemoteIp;
+    const UCHAR Payload[] = "GenericRxHashMapRedirect";
+
+    auto Socket = CreateUdpSocket(Af, &If, &LocalPort);
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+
+    If.GetHwAddress(&LocalHw);
+    If.GetRemoteHwAddress(&RemoteHw);
+    if (Af == AF_INET) {
+        If.GetIpv4Address(&LocalIp.Ipv4);
+        If.GetRemoteIpv4Address(&RemoteIp.Ipv4);
+    } else {
+        If.GetIpv6Address(&LocalIp.Ipv6);
+        If.GetRemoteIpv6Address(&RemoteIp.Ipv6);
+    }
+
+    auto Xsk =
+        CreateAndActivateSocket(
+            If.GetIfIndex(), If.GetQueueId(), TRUE, FALSE, XDP_GENERIC);
+
+    //
+    // Create a hash map that redirects the flow to the XSK.
+    //
+    wil::unique_handle HashMap;
+    TEST_HRESULT(XdpMapCreate(&HashMap, XDP_MAP_TYPE_HASH));
+    XDP_HASH_MAP_KEY Key = {0};
+    Key.AddressFamily = (UINT8)Af;
+    Key.IpProtocol = IPPROTO_UDP;
+    RtlCopyMemory(&Key.Tuple.SourceAddress, &RemoteIp, sizeof(Key.Tuple.SourceAddress));
+    RtlCopyMemory(&Key.Tuple.DestinationAddress, &LocalIp, sizeof(Key.Tuple.DestinationAddress));
+    Key.Tuple.SourcePort = RemotePort;
+    Key.Tuple.DestinationPort = LocalPort;
+    XDP_MAP_ACTION_VALUE Value = {0};
+    Value.Action = XDP_PROGRAM_ACTION_REDIRECT;
+    Value.Xsk = Xsk.Handle.get();
+    TEST_HRESULT(XdpMapInsert(HashMap.get(), &Key, &Value));
+
+    //
+    // Create an XDP program that applies the hash map's actions to all UDP
+    // frames.
+    //
+    XDP_RULE Rule;
+    Rule.Match = XDP_MATCH_UDP;
+    Rule.Action = XDP_PROGRAM_ACTION_REDIRECT;
+    Rule.Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_HASH_MAP_BY_FLOW;
+    Rule.Redirect.Target = HashMap.get();
+
+    wil::unique_handle ProgramHandle =
+        CreateXdpProg(
+            If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(), XDP_GENERIC, &Rule, 1);
+
+    UCHAR PacketBuffer[UDP_HEADER_STORAGE + sizeof(Payload)];
+    UINT32 PacketBufferLength = sizeof(PacketBuffer);
+
+    SocketProduceRxFill(&Xsk, 2);
+
+    RX_FRAME Frame;
+    TEST_TRUE(
+        PktBuildUdpFrame(
+            PacketBuffer, &PacketBufferLength, Payload, sizeof(Payload), &LocalHw,
+            &RemoteHw, Af, &LocalIp, &RemoteIp, LocalPort, RemotePort));
+    RxInitializeFrame(&Frame, If.GetQueueId(), PacketBuffer, PacketBufferLength);
+    TEST_HRESULT(MpRxIndicateFrame(GenericMp, &Frame));
+
+    //
+    // Verify the packet is received by the XSK socket.
+    //
+    UINT32 ConsumerIndex = SocketConsumerReserve(&Xsk.Rings.Rx, 1);
+    auto RxDesc = SocketGetAndFreeRxDesc(&Xsk, ConsumerIndex);
+    TEST_EQUAL(PacketBufferLength, RxDesc->Length);
+    TEST_TRUE(
+        RtlEqualMemory(
+            Xsk.Umem.Buffer.get() + RxDesc->Address.BaseAddress + RxDesc->Address.Offset,
+            PacketBuffer,
+            PacketBufferLength));
+    XskRingConsumerRelease(&Xsk.Rings.Rx, 1);
+
+    //
+    // Replace the entry with a drop action without updating the program. The
+    // packet is no longer redirected.
+    //
+    Value.Action = XDP_PROGRAM_ACTION_DROP;
+    Value.Xsk = NULL;
+    TEST_HRESULT(XdpMapInsert(HashMap.get(), &Key, &Value));
+    TEST_HRESULT(MpRxIndicateFrame(GenericMp, &Frame));
+
+    CxPlatSleep(TEST_TIMEOUT_ASYNC_MS * 2);
+    TEST_EQUAL(0, XskRingConsumerReserve(&Xsk.Rings.Rx, MAXUINT32, &ConsumerIndex));
+}
+
+VOID
+GenericRxLpmMapRedirect(
+    _In_ ADDRESS_FAMILY Af
+    )
+{
+    auto If = FnMpIf;
+    UINT16 LocalPort;
+    UINT16 RemotePort = htons(1234);
+    ETHERNET_ADDRESS LocalHw, RemoteHw;
+    INET_ADDR LocalIp, RemoteIp;
+    const UCHAR Payload[] = "GenericRxLpmMapRedirect";
+
+    auto Socket = CreateUdpSocket(Af, &If, &LocalPort);
+    auto GenericMp = MpOpenGeneric(If.GetIfIndex());
+
+    If.GetHwAddress(&LocalHw);
+    If.GetRemoteHwAddress(&RemoteHw);
+    if (Af == AF_INET) {
+        If.GetIpv4Address(&LocalIp.Ipv4);
+        If.GetRemoteIpv4Address(&RemoteIp.Ipv4);
+    } else {
+        If.GetIpv6Address(&LocalIp.Ipv6);
+        If.GetRemoteIpv6Address(&RemoteIp.Ipv6);
+    }
+
+    auto Xsk =
+        CreateAndActivateSocket(
+            If.GetIfIndex(), If.GetQueueId(), TRUE, FALSE, XDP_GENERIC);
+
+    //
+    // Create an LPM map with a short prefix covering the remote address that
+    // redirects to the XSK.
+    //
+    wil::unique_handle LpmMap;
+    TEST_HRESULT(XdpMapCreate(&LpmMap, XDP_MAP_TYPE_LPM));
+    XDP_LPM_MAP_KEY Key = {0};
+    Key.AddressFamily = (UINT8)Af;
+    Key.PrefixLength = 8;
+    RtlCopyMemory(&Key.Address, &RemoteIp, sizeof(Key.Address));
+    XDP_MAP_ACTION_VALUE Value = {0};
+    Value.Action = XDP_PROGRAM_ACTION_REDIRECT;
+    Value.Xsk = Xsk.Handle.get();
+    TEST_HRESULT(XdpMapInsert(LpmMap.get(), &Key, &Value));
+
+    //
+    // Create an XDP program that applies the action of the longest prefix
+    // matching each UDP frame's source address.
+    //
+    XDP_RULE Rule;
+    Rule.Match = XDP_MATCH_UDP_DST;
+    Rule.Pattern.Port = LocalPort;
+    Rule.Action = XDP_PROGRAM_ACTION_REDIRECT;
+    Rule.Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_SRC_ADDR;
+    Rule.Redirect.Target = LpmMap.get();
+
+    wil::unique_handle ProgramHandle =
+        CreateXdpProg(
+            If.GetIfIndex(), &XdpInspectRxL2, If.GetQueueId(), XDP_GENERIC, &Rule, 1);
+
+    UCHAR PacketBuffer[UDP_HEADER_STORAGE + sizeof(Payload)];
+    UINT32 PacketBufferLength = sizeof(PacketBuffer);
+
+    SocketProduceRxFill(&Xsk, 2);
+
+    RX_FRAME Frame;
+    TEST_TRUE(
+        PktBuildUdpFrame(
+            PacketBuffer, &PacketBufferLength, Payload, sizeof(Payload), &LocalHw,
+            &RemoteHw, Af, &LocalIp, &RemoteIp, LocalPort, RemotePort));
+    RxInitializeFrame(&Frame, If.GetQueueId(), PacketBuffer, PacketBufferLength);
+    TEST_HRESULT(MpRxIndicateFrame(GenericMp, &Frame));
+
+    //
+    // Verify the packet is received by the XSK socket.
+    //
+    UINT32 ConsumerIndex = SocketConsumerReserve(&Xsk.Rings.Rx, 1);
+    auto RxDesc = SocketGetAndFreeRxDesc(&Xsk, ConsumerIndex);
+    TEST_EQUAL(PacketBufferLength, RxDesc->Length);
+    XskRingConsumerRelease(&Xsk.Rings.Rx, 1);
+
+    //
+    // Insert a host prefix for the remote address that passes frames to the
+    // host stack. The longer prefix takes precedence, so the packet is no
+    // longer redirected.
+    //
+    Key.PrefixLength = (Af == AF_INET) ? 32 : 128;
+    Value.Action = XDP_PROGRAM_ACTION_PASS;
+    Value.Xsk = NULL;
+    TEST_HRESULT(XdpMapInsert(LpmMap.get(), &Key, &Value));
+    TEST_HRESULT(MpRxIndicateFrame(GenericMp, &Frame));
+
+    CxPlatSleep(TEST_TIMEOUT_ASYNC_MS * 2);
+    TEST_EQUAL(0, XskRingConsumerReserve(&Xsk.Rings.Rx, MAXUINT32, &ConsumerIndex));
+}
+
 static
 HRESULT
 StartPktMonDropCapture(
@@ -31,6 +31,11 @@ GenericRxAllQueueRedirect(
     _In_ ADDRESS_FAMILY Af
     );
 
+VOID
+GenericRxRssSteering(
+    _In_ ADDRESS_FAMILY Af
+    );
+
 VOID
 GenericRxTcpControl(
     _In_ ADDRESS_FAMILY Af
@@ -64,6 +69,9 @@ GenericRxLowResources();
 VOID
 GenericRxMultiSocket();
 
+VOID
+GenericRxSharedUmem();
+
 VOID
 GenericRxMultiProgram();
 
@@ -90,6 +98,9 @@ GenericRxTooManyFragments(
     _In_ BOOLEAN IsUdp
     );
 
+VOID
+GenericRxLinearizationPool();
+
 VOID
 GenericRxHeaderFragments(
     _In_ ADDRESS_FAMILY Af,
@@ -178,21 +189,41 @@ GenericRxEbpfPayload();
 VOID
 ProgTestRunRxEbpfPayload();
 
+VOID
+ProgTestRunRxEbpfEncapDecap();
+
 VOID
 GenericRxEbpfIfIndex();
 
 VOID
 GenericRxEbpfFragments();
 
+VOID
+GenericRxEbpfFragmentBytes();
+
+VOID
+GenericRxEbpfAdjustTail();
+
 VOID
 GenericRxEbpfUnload();
 
+VOID
+GenericRxEbpfXskMapRedirect(
+    _In_ ADDRESS_FAMILY Af
+    );
+
 VOID
 GenericTxToRxInject();
 
 VOID
 GenericTxSingleFrame();
 
+VOID
+GenericTxFragmentsNotSupported();
+
+VOID
+GenericTxMdlCache();
+
 VOID
 GenericTxOutOfOrder();
 
@@ -202,6 +233,9 @@ GenericTxSharing();
 VOID
 GenericTxPoke();
 
+VOID
+GenericXskPollModeAdaptive();
+
 VOID
 GenericTxMtu();
 
@@ -217,6 +251,17 @@ GenericRxTimestampOffloadExtensions();
 VOID
 GenericRxTimestampOffload();
 
+VOID
+GenericRxZeroCopyNotSupported();
+
+VOID
+GenericRxMultiBuffer();
+
+VOID
+GenericRxGroUdp(
+    ADDRESS_FAMILY Af
+    );
+
 VOID
 GenericTxTimestampOffloadExtensions();
 
@@ -246,6 +291,11 @@ GenericTxChecksumOffloadUdp(
     ADDRESS_FAMILY Af
     );
 
+VOID
+GenericTxSegmentationOffloadUdp(
+    ADDRESS_FAMILY Af
+    );
+
 VOID
 GenericRxChecksumOffloadUdp(
     ADDRESS_FAMILY Af
@@ -272,6 +322,9 @@ GenericXskWaitAsync(
     _In_ BOOLEAN Tx
     );
 
+VOID
+GenericXskNotifySet();
+
 VOID
 GenericLwfDelayDetach(
     _In_ BOOLEAN Rx,
@@ -344,8 +397,43 @@ GenericRxXskMapRedirect(
 VOID
 GenericRxXskMapRedirectMiss();
 
+VOID
+GenericRxXskMapFlowHashRedirect(
+    _In_ ADDRESS_FAMILY Af
+    );
+
+VOID
+GenericRxRedirectInterfaceTx();
+
+VOID
+GenericRxRateLimit();
+
 VOID
 XskMapCreateInsertDelete();
 
+VOID
+QuicCidMapCreateInsertDelete();
+
+VOID
+GenericRxQuicCidMapRedirect(
+    _In_ ADDRESS_FAMILY Af
+    );
+
+VOID
+HashMapCreateInsertDelete();
+
+VOID
+LpmMapCreateInsertDelete();
+
+VOID
+GenericRxHashMapRedirect(
+    _In_ ADDRESS_FAMILY Af
+    );
+
+VOID
+GenericRxLpmMapRedirect(
+    _In_ ADDRESS_FAMILY Af
+    );
+
 VOID
 GenericPktMonRegistration();
@@ -143,6 +143,10 @@ public:
         ::GenericRxMultiSocket();
     }
 
+    TEST_METHOD_PRERELEASE(GenericRxSharedUmem) {
+        ::GenericRxSharedUmem();
+    }
+
     TEST_METHOD(GenericRxMultiProgram) {
         ::GenericRxMultiProgram();
     }
@@ -155,6 +159,14 @@ public:
         ::GenericTxSingleFrame();
     }
 
+    TEST_METHOD_PRERELEASE(GenericTxFragmentsNotSupported) {
+        ::GenericTxFragmentsNotSupported();
+    }
+
+    TEST_METHOD_PRERELEASE(GenericTxMdlCache) {
+        ::GenericTxMdlCache();
+    }
+
     TEST_METHOD(GenericTxOutOfOrder) {
         ::GenericTxOutOfOrder();
     }
@@ -167,6 +179,10 @@ public:
         ::GenericTxPoke();
     }
 
+    TEST_METHOD(GenericXskPollModeAdaptive) {
+        ::GenericXskPollModeAdaptive();
+    }
+
     TEST_METHOD(GenericTxMtu) {
         ::GenericTxMtu();
     }
@@ -187,6 +203,22 @@ public:
         ::GenericRxTimestampOffload();
     }
 
+    TEST_METHOD_PRERELEASE(GenericRxZeroCopyNotSupported) {
+        ::GenericRxZeroCopyNotSupported();
+    }
+
+    TEST_METHOD_PRERELEASE(GenericRxMultiBuffer) {
+        ::GenericRxMultiBuffer();
+    }
+
+    TEST_METHOD_PRERELEASE(GenericRxGroUdpV4) {
+        ::GenericRxGroUdp(AF_INET);
+    }
+
+    TEST_METHOD_PRERELEASE(GenericRxGroUdpV6) {
+        ::GenericRxGroUdp(AF_INET6);
+    }
+
     TEST_METHOD_PRERELEASE(GenericTxTimestampOffloadExtensions) {
         ::GenericTxTimestampOffloadExtensions();
     }
@@ -235,6 +267,14 @@ public:
         ::GenericTxChecksumOffloadUdp(AF_INET6);
     }
 
+    TEST_METHOD_PRERELEASE(GenericTxSegmentationOffloadUdpV4) {
+        ::GenericTxSegmentationOffloadUdp(AF_INET);
+    }
+
+    TEST_METHOD_PRERELEASE(GenericTxSegmentationOffloadUdpV6) {
+        ::GenericTxSegmentationOffloadUdp(AF_INET6);
+    }
+
     TEST_METHOD_PRERELEASE(GenericRxChecksumOffloadUdpV6) {
         ::GenericRxChecksumOffloadUdp(AF_INET6);
     }
@@ -271,6 +311,14 @@ public:
         GenericRxAllQueueRedirect(AF_INET6);
     }
 
+    TEST_METHOD(GenericRxRssSteeringV4) {
+        GenericRxRssSteering(AF_INET);
+    }
+
+    TEST_METHOD(GenericRxRssSteeringV6) {
+        GenericRxRssSteering(AF_INET6);
+    }
+
     TEST_METHOD(GenericRxMatchUdpV4) {
         GenericRxMatch(AF_INET, XDP_MATCH_UDP, TRUE);
     }
@@ -407,6 +455,10 @@ public:
         GenericXskWaitAsync(TRUE, TRUE);
     }
 
+    TEST_METHOD_PRERELEASE(GenericXskNotifySet) {
+        ::GenericXskNotifySet();
+    }
+
     TEST_METHOD(GenericLwfDelayDetachRx) {
         GenericLwfDelayDetach(TRUE, FALSE);
     }
@@ -475,6 +527,10 @@ public:
         GenericRxTooManyFragments(AF_INET6, FALSE);
     }
 
+    TEST_METHOD(GenericRxLinearizationPool) {
+        ::GenericRxLinearizationPool();
+    }
+
     TEST_METHOD(GenericRxUdpHeaderFragmentsV4) {
         GenericRxHeaderFragments(AF_INET, XDP_PROGRAM_ACTION_REDIRECT, TRUE);
     }
@@ -636,6 +692,10 @@ public:
         ::ProgTestRunRxEbpfPayload();
     }
 
+    TEST_METHOD_PRERELEASE(ProgTestRunRxEbpfEncapDecap) {
+        ::ProgTestRunRxEbpfEncapDecap();
+    }
+
     TEST_METHOD_PRERELEASE(GenericRxEbpfIfIndex) {
         ::GenericRxEbpfIfIndex();
     }
@@ -644,10 +704,26 @@ public:
         ::GenericRxEbpfFragments();
     }
 
+    TEST_METHOD_PRERELEASE(GenericRxEbpfFragmentBytes) {
+        ::GenericRxEbpfFragmentBytes();
+    }
+
+    TEST_METHOD_PRERELEASE(GenericRxEbpfAdjustTail) {
+        ::GenericRxEbpfAdjustTail();
+    }
+
     TEST_METHOD_PRERELEASE(GenericRxEbpfUnload) {
         ::GenericRxEbpfUnload();
     }
 
+    TEST_METHOD_PRERELEASE(GenericRxEbpfXskMapRedirectV4) {
+        ::GenericRxEbpfXskMapRedirect(AF_INET);
+    }
+
+    TEST_METHOD_PRERELEASE(GenericRxEbpfXskMapRedirectV6) {
+        ::GenericRxEbpfXskMapRedirect(AF_INET6);
+    }
+
     TEST_METHOD(GenericLoopbackV4) {
         GenericLoopback(AF_INET);
     }
@@ -736,6 +812,58 @@ public:
         ::GenericRxXskMapRedirectMiss();
     }
 
+    TEST_METHOD(GenericRxXskMapFlowHashRedirectV4) {
+        GenericRxXskMapFlowHashRedirect(AF_INET);
+    }
+
+    TEST_METHOD(GenericRxXskMapFlowHashRedirectV6) {
+        GenericRxXskMapFlowHashRedirect(AF_INET6);
+    }
+
+    TEST_METHOD(GenericRxRedirectInterfaceTx) {
+        ::GenericRxRedirectInterfaceTx();
+    }
+
+    TEST_METHOD(GenericRxRateLimit) {
+        ::GenericRxRateLimit();
+    }
+
+    TEST_METHOD(QuicCidMapCreateInsertDelete) {
+        ::QuicCidMapCreateInsertDelete();
+    }
+
+    TEST_METHOD(GenericRxQuicCidMapRedirectV4) {
+        GenericRxQuicCidMapRedirect(AF_INET);
+    }
+
+    TEST_METHOD(GenericRxQuicCidMapRedirectV6) {
+        GenericRxQuicCidMapRedirect(AF_INET6);
+    }
+
+    TEST_METHOD(HashMapCreateInsertDelete) {
+        ::HashMapCreateInsertDelete();
+    }
+
+    TEST_METHOD(LpmMapCreateInsertDelete) {
+        ::LpmMapCreateInsertDelete();
+    }
+
+    TEST_METHOD(GenericRxHashMapRedirectV4) {
+        GenericRxHashMapRedirect(AF_INET);
+    }
+
+    TEST_METHOD(GenericRxHashMapRedirectV6) {
+        GenericRxHashMapRedirect(AF_INET6);
+    }
+
+    TEST_METHOD(GenericRxLpmMapRedirectV4) {
+        GenericRxLpmMapRedirect(AF_INET);
+    }
+
+    TEST_METHOD(GenericRxLpmMapRedirectV6) {
+        GenericRxLpmMapRedirect(AF_INET6);
+    }
+
     TEST_METHOD(GenericPktMonRegistration) {
         ::GenericPktMonRegistration();
     }
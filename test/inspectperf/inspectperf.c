@@ -0,0 +1,759 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+//
+// This inspectperf microbenchmark measures the per-frame cost of XDP program
+// inspection as the number of rules grows, both with a linear rule scan and
+// with the compiled rule classifier. The inspected frame always matches the
+// final rule, which is the worst case for a linear scan.
+//
+// The cidmap mode instead measures a single QUIC CID map rule as the number
+// of CIDs in the map grows. The hashmap and lpm modes likewise measure a single
+// rule redirecting via a hash map keyed by 5-tuple or an LPM map keyed by
+// destination prefix, reporting both the insert and per-frame lookup costs as
+// the map grows to a million entries.
+//
+// The batch mode compares inspecting a ring of frames one at a time with
+// XdpInspect against XdpInspectBatch, which prefetches and parses headers for
+// several frames before evaluating rules. Frames are drawn from a buffer pool
+// larger than the CPU caches so header reads miss as they would on the RX
+// path.
+//
+
+#include "precomp.h"
+#include <programinspect.h>
+#include <malloc.h>
+#include <stdio.h>
+
+CONST CHAR *UsageText =
+"Usage: inspectperf [-Match udp|tuple|cid|prefix|cidmap|hashmap|lpm|batch|all] [-Iterations <count>]";
+
+#define REQUIRE(expr) \
+    if (!(expr)) { printf("("#expr") failed line %d\n", __LINE__);  exit(1);}
+
+#define INSPECTPERF_UDP_PORT 443
+#define INSPECTPERF_CID_LENGTH 8
+#define INSPECTPERF_BATCH_RULES 4
+#define INSPECTPERF_POOL_BUFFER_SIZE 2048
+#define INSPECTPERF_POOL_BUFFER_COUNT 0x8000
+
+typedef struct _XDP_FRAME_WITH_EXTENSIONS {
+    XDP_FRAME Frame;
+    XDP_BUFFER_VIRTUAL_ADDRESS BufferVirtualAddress;
+} XDP_FRAME_WITH_EXTENSIONS;
+
+C_ASSERT(
+    FIELD_OFFSET(XDP_FRAME_WITH_EXTENSIONS, BufferVirtualAddress) ==
+    RTL_SIZEOF_THROUGH_FIELD(XDP_FRAME_WITH_EXTENSIONS, Frame.Buffer));
+
+typedef struct _XDP_FRAME_RING {
+    XDP_RING Ring;
+    XDP_FRAME_WITH_EXTENSIONS Frames[1];
+} XDP_FRAME_RING;
+
+C_ASSERT(
+    FIELD_OFFSET(XDP_FRAME_RING, Frames) ==
+    RTL_SIZEOF_THROUGH_FIELD(XDP_FRAME_RING, Ring));
+
+typedef enum _INSPECTPERF_MATCH {
+    InspectPerfMatchUdp,
+    InspectPerfMatchTuple,
+    InspectPerfMatchCid,
+    InspectPerfMatchPrefix,
+    InspectPerfMatchCidMap,
+    InspectPerfMatchHashMap,
+    InspectPerfMatchLpm,
+    InspectPerfMatchBatch,
+    InspectPerfMatchMax,
+} INSPECTPERF_MATCH;
+
+static CONST CHAR *MatchNames[] = {
+    "udp",
+    "tuple",
+    "cid",
+    "prefix",
+    "cidmap",
+    "hashmap",
+    "lpm",
+    "batch",
+};
+
+C_ASSERT(RTL_NUMBER_OF(MatchNames) == InspectPerfMatchMax);
+
+static const UINT32 RuleCounts[] = { 1, 16, 256, 4096 };
+static const UINT32 CidMapEntryCounts[] = { 1, 16, 256, 4096, 65536 };
+static const UINT32 ActionMapEntryCounts[] = { 1, 256, 65536, 1048576 };
+static const UINT32 BatchRingSizes[] = { 32, 64, 256 };
+
+XDP_EXTENSION VirtualAddressExtension = {
+    .Reserved = FIELD_OFFSET(XDP_FRAME_WITH_EXTENSIONS, BufferVirtualAddress)
+};
+
+VOID
+Usage(
+    CHAR *Error
+    )
+{
+    fprintf(stderr, "Error: %s\n%s", Error, UsageText);
+    exit(1);
+}
+
+static
+VOID
+InitializeRule(
+    _Out_ XDP_RULE *Rule,
+    _In_ INSPECTPERF_MATCH Match,
+    _In_ UINT32 Index
+    )
+{
+    RtlZeroMemory(Rule, sizeof(*Rule));
+    Rule->Action = XDP_PROGRAM_ACTION_PASS;
+
+    switch (Match) {
+    case InspectPerfMatchUdp:
+        Rule->Match = XDP_MATCH_UDP_DST;
+        Rule->Pattern.Port = htons((UINT16)(1024 + Index));
+        break;
+
+    case InspectPerfMatchTuple:
+        Rule->Match = XDP_MATCH_IPV4_UDP_TUPLE;
+        Rule->Pattern.Tuple.SourceAddress.Ipv4.s_addr = htonl(0x0a000001);
+        Rule->Pattern.Tuple.DestinationAddress.Ipv4.s_addr = htonl(0x0a000002);
+        Rule->Pattern.Tuple.SourcePort = htons((UINT16)(1024 + Index));
+        Rule->Pattern.Tuple.DestinationPort = htons(INSPECTPERF_UDP_PORT);
+        break;
+
+    case InspectPerfMatchCid:
+        Rule->Match = XDP_MATCH_QUIC_FLOW_DST_CID;
+        Rule->Pattern.QuicFlow.UdpPort = htons(INSPECTPERF_UDP_PORT);
+        Rule->Pattern.QuicFlow.CidOffset = 0;
+        Rule->Pattern.QuicFlow.CidLength = INSPECTPERF_CID_LENGTH;
+        RtlCopyMemory(Rule->Pattern.QuicFlow.CidData, &Index, sizeof(Index));
+        break;
+
+    case InspectPerfMatchPrefix:
+        Rule->Match = XDP_MATCH_IPV4_DST_MASK;
+        Rule->Pattern.IpMask.Mask.Ipv4.s_addr = htonl(0xffffff00);
+        Rule->Pattern.IpMask.Address.Ipv4.s_addr = htonl(0x0a000000 | (Index << 8));
+        break;
+
+    default:
+        REQUIRE(FALSE);
+    }
+}
+
+static
+VOID
+InitializeFrame(
+    _Inout_ XDP_FRAME_RING *FrameRing,
+    _Out_writes_bytes_(BufferSize) UCHAR *Buffer,
+    _In_ UINT32 BufferSize,
+    _In_ INSPECTPERF_MATCH Match,
+    _In_ UINT32 RuleIndex
+    )
+{
+    const ETHERNET_ADDRESS EthSrc = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05};
+    const ETHERNET_ADDRESS EthDst = {0x00, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e};
+    INET_ADDR IpSrc = {0};
+    INET_ADDR IpDst = {0};
+    UINT16 PortSrc = htons(1024);
+    UINT16 PortDst = htons(INSPECTPERF_UDP_PORT);
+    UCHAR Payload[1 + XDP_QUIC_MAX_CID_LENGTH] = {0};
+    UINT32 FrameLength = BufferSize;
+    XDP_FRAME_WITH_EXTENSIONS *FrameExt = &FrameRing->Frames[0];
+
+    IpSrc.Ipv4.s_addr = htonl(0x0a000001);
+    IpDst.Ipv4.s_addr = htonl(0x0a000002);
+
+    //
+    // A QUIC short header with the destination CID immediately following the
+    // first byte.
+    //
+    Payload[0] = 0x40;
+
+    switch (Match) {
+    case InspectPerfMatchUdp:
+        PortDst = htons((UINT16)(1024 + RuleIndex));
+        break;
+
+    case InspectPerfMatchTuple:
+        PortSrc = htons((UINT16)(1024 + RuleIndex));
+        break;
+
+    case InspectPerfMatchCid:
+    case InspectPerfMatchCidMap:
+        RtlCopyMemory(&Payload[1], &RuleIndex, sizeof(RuleIndex));
+        break;
+
+    case InspectPerfMatchPrefix:
+        IpDst.Ipv4.s_addr = htonl(0x0a000001 | (RuleIndex << 8));
+        break;
+
+    case InspectPerfMatchHashMap:
+        IpSrc.Ipv4.s_addr = htonl(0x40000000 + RuleIndex);
+        break;
+
+    case InspectPerfMatchLpm:
+        IpDst.Ipv4.s_addr = htonl(0x40000001 + (RuleIndex << 8));
+        break;
+
+    default:
+        REQUIRE(FALSE);
+    }
+
+    REQUIRE(
+        PktBuildUdpFrame(
+            Buffer, &FrameLength, Payload, sizeof(Payload), &EthDst, &EthSrc, AF_INET,
+            &IpDst, &IpSrc, PortDst, PortSrc));
+
+    RtlZeroMemory(FrameRing, sizeof(*FrameRing));
+    FrameRing->Ring.ElementStride = sizeof(FrameRing->Frames[0]);
+    FrameRing->Ring.Mask = RTL_NUMBER_OF(FrameRing->Frames) - 1;
+    FrameExt->Frame.Buffer.DataOffset = 0;
+    FrameExt->Frame.Buffer.DataLength = FrameLength;
+    FrameExt->Frame.Buffer.BufferLength = BufferSize;
+    FrameExt->BufferVirtualAddress.VirtualAddress = Buffer;
+}
+
+static
+XDP_PROGRAM *
+AllocateProgram(
+    _In_ INSPECTPERF_MATCH Match,
+    _In_ UINT32 RuleCount
+    )
+{
+    XDP_PROGRAM *Program;
+    SIZE_T ClassifierOffset;
+    SIZE_T ClassifierSize;
+    SIZE_T AllocationSize;
+
+    ClassifierOffset = FIELD_OFFSET(XDP_PROGRAM, Rules) + (SIZE_T)RuleCount * sizeof(XDP_RULE);
+    REQUIRE(NT_SUCCESS(XdpProgramGetClassifierSize(RuleCount, &ClassifierSize)));
+    AllocationSize = ClassifierOffset + ClassifierSize;
+
+    Program = _aligned_malloc(AllocationSize, SYSTEM_CACHE_ALIGNMENT_SIZE);
+    REQUIRE(Program != NULL);
+    RtlZeroMemory(Program, AllocationSize);
+
+    for (UINT32 i = 0; i < RuleCount; i++) {
+        InitializeRule(&Program->Rules[i], Match, i);
+    }
+
+    //
+    // Drop frames matching the final rule so the benchmark can verify the
+    // expected rule was selected.
+    //
+    Program->Rules[RuleCount - 1].Action = XDP_PROGRAM_ACTION_DROP;
+    Program->RuleCount = RuleCount;
+    Program->Classifier = RTL_PTR_ADD(Program, ClassifierOffset);
+    XdpProgramInitializeClassifier(Program->Classifier, RuleCount);
+
+    return Program;
+}
+
+static
+double
+MeasureInspect(
+    _In_ XDP_PROGRAM *Program,
+    _In_ XDP_FRAME_RING *FrameRing,
+    _In_ UINT64 Iterations
+    )
+{
+    XDP_INSPECTION_CONTEXT InspectionContext = {0};
+    LARGE_INTEGER Frequency;
+    LARGE_INTEGER Start;
+    LARGE_INTEGER End;
+
+    //
+    // Warm up the caches and verify the final rule is matched.
+    //
+    REQUIRE(
+        XdpInspect(
+            Program, &InspectionContext, &FrameRing->Ring, 0, NULL, NULL, 0,
+            &VirtualAddressExtension) == XDP_RX_ACTION_DROP);
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Start);
+
+    for (UINT64 i = 0; i < Iterations; i++) {
+        XdpInspect(
+            Program, &InspectionContext, &FrameRing->Ring, 0, NULL, NULL, 0,
+            &VirtualAddressExtension);
+    }
+
+    QueryPerformanceCounter(&End);
+
+    return
+        (double)(End.QuadPart - Start.QuadPart) * 1000000000.0 /
+            (double)Frequency.QuadPart / (double)Iterations;
+}
+
+static
+VOID
+RunMatch(
+    _In_ INSPECTPERF_MATCH Match,
+    _In_ UINT64 Iterations
+    )
+{
+    XDP_FRAME_RING FrameRing;
+    UCHAR Buffer[UDP_HEADER_BACKFILL(AF_INET) + 1 + XDP_QUIC_MAX_CID_LENGTH];
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(RuleCounts); i++) {
+        UINT32 RuleCount = RuleCounts[i];
+        XDP_PROGRAM *Program = AllocateProgram(Match, RuleCount);
+        XDP_PROGRAM_CLASSIFIER *Classifier = Program->Classifier;
+        UINT64 RuleIterations = max(Iterations / RuleCount, 0x1000);
+        double LinearNs;
+        double ClassifiedNs;
+
+        InitializeFrame(&FrameRing, Buffer, sizeof(Buffer), Match, RuleCount - 1);
+
+        Program->Classifier = NULL;
+        LinearNs = MeasureInspect(Program, &FrameRing, RuleIterations);
+
+        Program->Classifier = Classifier;
+        XdpProgramCompileClassifier(Program);
+        ClassifiedNs = MeasureInspect(Program, &FrameRing, RuleIterations);
+
+        printf(
+            "Match=%-6s Rules=%-5u Segments=%u Linear=%.1fns/frame Classified=%.1fns/frame\n",
+            MatchNames[Match], RuleCount, Classifier->SegmentCount, LinearNs, ClassifiedNs);
+
+        _aligned_free(Program);
+    }
+}
+
+static
+VOID
+InsertCidMapEntry(
+    _Inout_ XDP_MAP_TABLE *Table,
+    _Inout_ XDP_MAP_TABLE_ENTRY *Entry,
+    _In_ UINT32 Index
+    )
+{
+    UINT32 BucketCount = XdpMapTableGetGrowthBucketCount(Table);
+    UINT8 Cid[INSPECTPERF_CID_LENGTH] = {0};
+
+    //
+    // Grow the table using the same policy as the driver's QUIC CID map.
+    //
+    if (BucketCount > 0) {
+        XDP_MAP_TABLE_ENTRY **OldBuckets = Table->Buckets;
+        XDP_MAP_TABLE_ENTRY **Buckets = calloc(BucketCount, sizeof(*Buckets));
+
+        REQUIRE(Buckets != NULL);
+        XdpMapTableRehash(Table, Buckets, BucketCount);
+        free(OldBuckets);
+    }
+
+    RtlCopyMemory(Cid, &Index, sizeof(Index));
+    XdpMapTableInitializeQuicCidKey(Entry->Key, Cid, sizeof(Cid));
+    Entry->Value.Action = XDP_PROGRAM_ACTION_REDIRECT;
+    Entry->Value.Target = Entry;
+    Entry->Hash = XdpMapTableHash(Table, Entry->Key);
+    XdpMapTableInsert(Table, Entry);
+}
+
+static
+VOID
+RunCidMap(
+    _In_ UINT64 Iterations
+    )
+{
+    XDP_FRAME_RING FrameRing;
+    UCHAR Buffer[UDP_HEADER_BACKFILL(AF_INET) + 1 + XDP_QUIC_MAX_CID_LENGTH];
+    XDP_MAP_TABLE Table;
+    XDP_MAP_TABLE_ENTRY *Entries;
+    XDP_PROGRAM *Program;
+    XDP_RULE *Rule;
+    SIZE_T ProgramSize = FIELD_OFFSET(XDP_PROGRAM, Rules) + sizeof(*Rule);
+    UINT32 EntryCount = 0;
+
+    Entries =
+        calloc(CidMapEntryCounts[RTL_NUMBER_OF(CidMapEntryCounts) - 1], sizeof(*Entries));
+    REQUIRE(Entries != NULL);
+
+    XdpMapTableInitialize(&Table, XDP_MAP_TABLE_QUIC_CID_KEY_LENGTH, rand());
+
+    Program = _aligned_malloc(ProgramSize, SYSTEM_CACHE_ALIGNMENT_SIZE);
+    REQUIRE(Program != NULL);
+    RtlZeroMemory(Program, ProgramSize);
+
+    //
+    // A single rule redirects every frame whose CID is found in the map.
+    //
+    Rule = &Program->Rules[0];
+    Rule->Match = XDP_MATCH_QUIC_FLOW_DST_CID_MAP;
+    Rule->Pattern.QuicFlow.UdpPort = htons(INSPECTPERF_UDP_PORT);
+    Rule->Pattern.QuicFlow.CidOffset = 0;
+    Rule->Pattern.QuicFlow.CidLength = INSPECTPERF_CID_LENGTH;
+    Rule->Action = XDP_PROGRAM_ACTION_REDIRECT;
+    Rule->Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_QUIC_CID_MAP;
+    Rule->Redirect.Target = &Table;
+    Program->RuleCount = 1;
+    Program->Classifier = NULL;
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(CidMapEntryCounts); i++) {
+        double MapNs;
+
+        while (EntryCount < CidMapEntryCounts[i]) {
+            InsertCidMapEntry(&Table, &Entries[EntryCount], EntryCount);
+            EntryCount++;
+        }
+
+        InitializeFrame(&FrameRing, Buffer, sizeof(Buffer), InspectPerfMatchCidMap, EntryCount - 1);
+        MapNs = MeasureInspect(Program, &FrameRing, Iterations);
+
+        printf(
+            "Match=%-6s Entries=%-5u Buckets=%u Map=%.1fns/frame\n",
+            MatchNames[InspectPerfMatchCidMap], EntryCount, Table.BucketMask + 1, MapNs);
+    }
+
+    _aligned_free(Program);
+    free(Table.Buckets);
+    free(Entries);
+}
+
+static
+VOID
+InsertActionMapEntry(
+    _Inout_ XDP_MAP_TABLE *Table,
+    _Inout_ XDP_MAP_TABLE_ENTRY *Entry
+    )
+{
+    UINT32 BucketCount = XdpMapTableGetGrowthBucketCount(Table);
+
+    //
+    // Grow the table using the same policy as the driver's hash and LPM maps.
+    //
+    if (BucketCount > 0) {
+        XDP_MAP_TABLE_ENTRY **OldBuckets = Table->Buckets;
+        XDP_MAP_TABLE_ENTRY **Buckets = calloc(BucketCount, sizeof(*Buckets));
+
+        REQUIRE(Buckets != NULL);
+        XdpMapTableRehash(Table, Buckets, BucketCount);
+        free(OldBuckets);
+    }
+
+    Entry->Value.Action = XDP_PROGRAM_ACTION_DROP;
+    Entry->Hash = XdpMapTableHash(Table, Entry->Key);
+    XdpMapTableInsert(Table, Entry);
+}
+
+static
+VOID
+RunActionMap(
+    _In_ INSPECTPERF_MATCH Match,
+    _In_ UINT64 Iterations
+    )
+{
+    XDP_FRAME_RING FrameRing;
+    UCHAR Buffer[UDP_HEADER_BACKFILL(AF_INET) + 1 + XDP_QUIC_MAX_CID_LENGTH];
+    XDP_MAP_TABLE HashTable;
+    XDP_LPM_TABLE *LpmTable;
+    XDP_MAP_TABLE *Table;
+    XDP_MAP_TABLE_ENTRY *Entries;
+    XDP_MAP_TABLE_ENTRY HostEntry = {0};
+    XDP_PROGRAM *Program;
+    XDP_RULE *Rule;
+    SIZE_T ProgramSize = FIELD_OFFSET(XDP_PROGRAM, Rules) + sizeof(*Rule);
+    LARGE_INTEGER Frequency;
+    UINT32 EntryCount = 0;
+
+    QueryPerformanceFrequency(&Frequency);
+
+    Entries =
+        calloc(ActionMapEntryCounts[RTL_NUMBER_OF(ActionMapEntryCounts) - 1], sizeof(*Entries));
+    REQUIRE(Entries != NULL);
+
+    LpmTable = calloc(1, sizeof(*LpmTable));
+    REQUIRE(LpmTable != NULL);
+
+    Program = _aligned_malloc(ProgramSize, SYSTEM_CACHE_ALIGNMENT_SIZE);
+    REQUIRE(Program != NULL);
+    RtlZeroMemory(Program, ProgramSize);
+
+    //
+    // A single rule applies the action of whichever map entry the frame's
+    // 5-tuple or destination address is found in.
+    //
+    Rule = &Program->Rules[0];
+    Rule->Match = XDP_MATCH_ALL;
+    Rule->Action = XDP_PROGRAM_ACTION_REDIRECT;
+    Program->RuleCount = 1;
+    Program->Classifier = NULL;
+
+    if (Match == InspectPerfMatchHashMap) {
+        XdpMapTableInitialize(&HashTable, sizeof(XDP_HASH_MAP_KEY), rand());
+        Table = &HashTable;
+        Rule->Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_HASH_MAP_BY_FLOW;
+        Rule->Redirect.Target = Table;
+    } else {
+        XdpLpmTableInitialize(LpmTable, rand());
+        Table = &LpmTable->Ipv4.Prefixes[24];
+        XdpLpmTableSetPrefixLength(&LpmTable->Ipv4, 24);
+        Rule->Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_LPM_MAP_BY_DST_ADDR;
+        Rule->Redirect.Target = LpmTable;
+
+        //
+        // A host route outside the measured prefixes makes every lookup probe
+        // the /32 table before matching a /24 prefix.
+        //
+        HostEntry.Key[0] = htonl(0x3f000001);
+        XdpLpmTableSetPrefixLength(&LpmTable->Ipv4, 32);
+        InsertActionMapEntry(&LpmTable->Ipv4.Prefixes[32], &HostEntry);
+    }
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(ActionMapEntryCounts); i++) {
+        UINT32 FirstEntry = EntryCount;
+        LARGE_INTEGER Start;
+        LARGE_INTEGER End;
+        double InsertNs;
+        double MapNs;
+
+        QueryPerformanceCounter(&Start);
+
+        while (EntryCount < ActionMapEntryCounts[i]) {
+            XDP_MAP_TABLE_ENTRY *Entry = &Entries[EntryCount];
+
+            if (Match == InspectPerfMatchHashMap) {
+                XDP_HASH_MAP_KEY *Key = (XDP_HASH_MAP_KEY *)Entry->Key;
+
+                Key->AddressFamily = AF_INET;
+                Key->IpProtocol = IPPROTO_UDP;
+                Key->Tuple.SourceAddress.Ipv4.s_addr = htonl(0x40000000 + EntryCount);
+                Key->Tuple.DestinationAddress.Ipv4.s_addr = htonl(0x0a000002);
+                Key->Tuple.SourcePort = htons(1024);
+                Key->Tuple.DestinationPort = htons(INSPECTPERF_UDP_PORT);
+            } else {
+                Entry->Key[0] = htonl(0x40000000 + (EntryCount << 8));
+            }
+
+            InsertActionMapEntry(Table, Entry);
+            EntryCount++;
+        }
+
+        QueryPerformanceCounter(&End);
+        InsertNs =
+            (double)(End.QuadPart - Start.QuadPart) * 1000000000.0 /
+                (double)Frequency.QuadPart / (double)(EntryCount - FirstEntry);
+
+        InitializeFrame(&FrameRing, Buffer, sizeof(Buffer), Match, EntryCount - 1);
+        MapNs = MeasureInspect(Program, &FrameRing, Iterations);
+
+        printf(
+            "Match=%-7s Entries=%-7u Buckets=%-7u Insert=%.1fns/entry Map=%.1fns/frame\n",
+            MatchNames[Match], EntryCount, Table->BucketMask + 1, InsertNs, MapNs);
+    }
+
+    _aligned_free(Program);
+    free(LpmTable->Ipv4.Prefixes[32].Buckets);
+    free(Table->Buckets);
+    free(LpmTable);
+    free(Entries);
+}
+
+static
+LONGLONG
+MeasureRing(
+    _In_ XDP_PROGRAM *Program,
+    _In_ XDP_FRAME_RING *FrameRing,
+    _In_ UCHAR *Pool,
+    _In_ const UINT32 *PoolOrder,
+    _In_ UINT64 Passes,
+    _In_ BOOLEAN Batched
+    )
+{
+    XDP_INSPECTION_CONTEXT InspectionContext = {0};
+    XDP_RX_ACTION Actions[XDP_INSPECT_BATCH_SIZE];
+    UINT32 RingSize = FrameRing->Ring.Mask + 1;
+    UINT32 PoolIndex = 0;
+    LONGLONG Ticks = 0;
+
+    for (UINT64 Pass = 0; Pass < Passes; Pass++) {
+        LARGE_INTEGER Start;
+        LARGE_INTEGER End;
+
+        //
+        // Refill the ring with the next buffers from the pool, as a NIC would
+        // between receive indications.
+        //
+        for (UINT32 i = 0; i < RingSize; i++) {
+            FrameRing->Frames[i].BufferVirtualAddress.VirtualAddress =
+                Pool + (SIZE_T)PoolOrder[PoolIndex] * INSPECTPERF_POOL_BUFFER_SIZE;
+            PoolIndex = (PoolIndex + 1) % INSPECTPERF_POOL_BUFFER_COUNT;
+        }
+
+        QueryPerformanceCounter(&Start);
+
+        if (Batched) {
+            for (UINT32 i = 0; i < RingSize; i += XDP_INSPECT_BATCH_SIZE) {
+                UINT32 FrameCount = min(RingSize - i, XDP_INSPECT_BATCH_SIZE);
+
+                XdpInspectBatch(
+                    Program, &InspectionContext, &FrameRing->Ring, i, FrameCount, NULL, NULL,
+                    0, &VirtualAddressExtension, Actions);
+
+                for (UINT32 j = 0; j < FrameCount; j++) {
+                    REQUIRE(Actions[j] == XDP_RX_ACTION_DROP);
+                }
+            }
+        } else {
+            for (UINT32 i = 0; i < RingSize; i++) {
+                REQUIRE(
+                    XdpInspect(
+                        Program, &InspectionContext, &FrameRing->Ring, i, NULL, NULL, 0,
+                        &VirtualAddressExtension) == XDP_RX_ACTION_DROP);
+            }
+        }
+
+        QueryPerformanceCounter(&End);
+        Ticks += End.QuadPart - Start.QuadPart;
+    }
+
+    return Ticks;
+}
+
+static
+VOID
+RunBatch(
+    _In_ UINT64 Iterations
+    )
+{
+    XDP_FRAME_RING *FrameRing;
+    UCHAR *Pool;
+    UINT32 *PoolOrder;
+    XDP_PROGRAM *Program;
+    UINT32 FrameLength;
+    LARGE_INTEGER Frequency;
+
+    QueryPerformanceFrequency(&Frequency);
+
+    //
+    // Every pool buffer holds the same frame, which matches the final rule.
+    //
+    Pool = malloc((SIZE_T)INSPECTPERF_POOL_BUFFER_COUNT * INSPECTPERF_POOL_BUFFER_SIZE);
+    REQUIRE(Pool != NULL);
+    PoolOrder = malloc(INSPECTPERF_POOL_BUFFER_COUNT * sizeof(*PoolOrder));
+    REQUIRE(PoolOrder != NULL);
+
+    FrameRing =
+        calloc(
+            1,
+            FIELD_OFFSET(XDP_FRAME_RING, Frames) +
+                sizeof(FrameRing->Frames[0]) * BatchRingSizes[RTL_NUMBER_OF(BatchRingSizes) - 1]);
+    REQUIRE(FrameRing != NULL);
+
+    InitializeFrame(
+        FrameRing, Pool, INSPECTPERF_POOL_BUFFER_SIZE, InspectPerfMatchUdp,
+        INSPECTPERF_BATCH_RULES - 1);
+    FrameLength = FrameRing->Frames[0].Frame.Buffer.DataLength;
+
+    for (UINT32 i = 0; i < INSPECTPERF_POOL_BUFFER_COUNT; i++) {
+        RtlCopyMemory(Pool + (SIZE_T)i * INSPECTPERF_POOL_BUFFER_SIZE, Pool, FrameLength);
+        PoolOrder[i] = i;
+    }
+
+    //
+    // Visit the pool in a random order to defeat hardware stride prefetching.
+    //
+    for (UINT32 i = INSPECTPERF_POOL_BUFFER_COUNT - 1; i > 0; i--) {
+        UINT32 j = rand() % (i + 1);
+        UINT32 Temp = PoolOrder[i];
+        PoolOrder[i] = PoolOrder[j];
+        PoolOrder[j] = Temp;
+    }
+
+    Program = AllocateProgram(InspectPerfMatchUdp, INSPECTPERF_BATCH_RULES);
+    Program->Classifier = NULL;
+    Program->BatchParse = TRUE;
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(BatchRingSizes); i++) {
+        UINT32 RingSize = BatchRingSizes[i];
+        UINT64 Passes = max(Iterations / RingSize, 0x100);
+        double ScalarNs;
+        double BatchedNs;
+
+        FrameRing->Ring.ElementStride = sizeof(FrameRing->Frames[0]);
+        FrameRing->Ring.Mask = RingSize - 1;
+
+        for (UINT32 j = 0; j < RingSize; j++) {
+            FrameRing->Frames[j].Frame.Buffer.DataOffset = 0;
+            FrameRing->Frames[j].Frame.Buffer.DataLength = FrameLength;
+            FrameRing->Frames[j].Frame.Buffer.BufferLength = INSPECTPERF_POOL_BUFFER_SIZE;
+        }
+
+        ScalarNs =
+            (double)MeasureRing(Program, FrameRing, Pool, PoolOrder, Passes, FALSE) *
+                1000000000.0 / (double)Frequency.QuadPart / (double)(Passes * RingSize);
+        BatchedNs =
+            (double)MeasureRing(Program, FrameRing, Pool, PoolOrder, Passes, TRUE) *
+                1000000000.0 / (double)Frequency.QuadPart / (double)(Passes * RingSize);
+
+        printf(
+            "Match=%-6s Ring=%-5u Scalar=%.1fns/frame Batched=%.1fns/frame Reduction=%.1f%%\n",
+            MatchNames[InspectPerfMatchBatch], RingSize, ScalarNs, BatchedNs,
+            (ScalarNs - BatchedNs) * 100.0 / ScalarNs);
+    }
+
+    _aligned_free(Program);
+    free(FrameRing);
+    free(PoolOrder);
+    free(Pool);
+}
+
+INT
+__cdecl
+main(
+    INT ArgC,
+    CHAR **ArgV
+    )
+{
+    INT Match = -1;
+    UINT64 Iterations = 0x1000000;
+
+    for (INT i = 1; i < ArgC; i++) {
+        if (!_stricmp(ArgV[i], "-Match") && i + 1 < ArgC) {
+            ++i;
+            if (!_stricmp(ArgV[i], "all")) {
+                Match = -1;
+                continue;
+            }
+            for (Match = 0; Match < InspectPerfMatchMax; Match++) {
+                if (!_stricmp(ArgV[i], MatchNames[Match])) {
+                    break;
+                }
+            }
+            if (Match == InspectPerfMatchMax) {
+                Usage("Invalid -Match");
+            }
+        } else if (!_stricmp(ArgV[i], "-Iterations") && i + 1 < ArgC) {
+            Iterations = _strtoui64(ArgV[++i], NULL, 0);
+            if (Iterations == 0) {
+                Usage("Invalid -Iterations");
+            }
+        } else {
+            Usage("Invalid parameter");
+        }
+    }
+
+    for (INT i = 0; i < InspectPerfMatchMax; i++) {
+        if (Match != -1 && Match != i) {
+            continue;
+        }
+
+        if (i == InspectPerfMatchCidMap) {
+            RunCidMap(Iterations);
+        } else if (i == InspectPerfMatchHashMap || i == InspectPerfMatchLpm) {
+            RunActionMap(i, Iterations);
+        } else if (i == InspectPerfMatchBatch) {
+            RunBatch(Iterations);
+        } else {
+            RunMatch(i, Iterations);
+        }
+    }
+
+    return 0;
+}
@@ -70,6 +70,12 @@ XDP_EXTENSION VirtualAddressExtension = {
     .Reserved = FIELD_OFFSET(XDP_BUFFER_WITH_EXTENSIONS, BufferVirtualAddress)
 };
 
+//
+// An all-zero Toeplitz key hashes every flow to zero, which suffices to fuzz
+// the flow hash input.
+//
+XDP_TOEPLITZ_TABLE FlowHashTable;
+
 #pragma warning(suppress:6262) // Using a LOT of stack space
 int
 LLVMFuzzerTestOneInput(
@@ -96,6 +102,11 @@ LLVMFuzzerTestOneInput(
     UINT32 FragmentRingIndex = 0;
     XDP_FRAME_WITH_EXTENSIONS *FrameExt = NULL;
     XDP_BUFFER *Buffer;
+    XDP_PROGRAM_CLASSIFIER *Classifier = NULL;
+    SIZE_T ClassifierSize;
+    XDP_RX_ACTION LinearAction;
+    XDP_RX_ACTION ClassifiedAction;
+    XDP_RX_ACTION BatchedAction;
 
     if (Size < sizeof(*Metadata)) {
         return -1;
@@ -176,8 +187,20 @@ LLVMFuzzerTestOneInput(
     }
 
     Program->RuleCount = RTL_NUMBER_OF(Metadata->Rules);
+    Program->Classifier = NULL;
+    Program->RateLimiters = NULL;
+    Program->FlowHashTable = &FlowHashTable;
 
     for (UINT32 i = 0; i < Program->RuleCount; i++) {
+        //
+        // Rate limit rules consume tokens on each inspection, so the repeated
+        // inspections below are not guaranteed to yield the same result.
+        //
+        if (Metadata->Rules[i].Action == XDP_PROGRAM_ACTION_RATE_LIMIT) {
+            Result = -1;
+            goto Exit;
+        }
+
         Status =
             XdpProgramValidateRule(
                 &Program->Rules[i], UserMode, &Metadata->Rules[i], Program->RuleCount, i);
@@ -188,14 +211,56 @@ LLVMFuzzerTestOneInput(
         }
     }
 
-    XdpInspect(
-        Program, &InspectionContext, &FrameRing.Ring, FrameRingIndex, FragmentRingOption,
-        &FragmentExtension, FragmentRingIndex, &VirtualAddressExtension);
+    LinearAction =
+        XdpInspect(
+            Program, &InspectionContext, &FrameRing.Ring, FrameRingIndex, FragmentRingOption,
+            &FragmentExtension, FragmentRingIndex, &VirtualAddressExtension);
+
+    //
+    // Inspect the frame again using the compiled classifier, which must yield
+    // the same result as the linear rule scan.
+    //
+    Status = XdpProgramGetClassifierSize(Program->RuleCount, &ClassifierSize);
+    if (!NT_SUCCESS(Status)) {
+        Result = -1;
+        goto Exit;
+    }
+
+    Classifier = malloc(ClassifierSize);
+    if (Classifier == NULL) {
+        Result = 0;
+        goto Exit;
+    }
+
+    XdpProgramInitializeClassifier(Classifier, Program->RuleCount);
+    Program->Classifier = Classifier;
+    XdpProgramCompileClassifier(Program);
+
+    ClassifiedAction =
+        XdpInspect(
+            Program, &InspectionContext, &FrameRing.Ring, FrameRingIndex, FragmentRingOption,
+            &FragmentExtension, FragmentRingIndex, &VirtualAddressExtension);
+
+    FRE_ASSERT(LinearAction == ClassifiedAction);
+
+    //
+    // Inspect the frame via the batched path, which parses headers before
+    // evaluating rules and must also yield the same result.
+    //
+    XdpInspectBatch(
+        Program, &InspectionContext, &FrameRing.Ring, FrameRingIndex, 1, FragmentRingOption,
+        &FragmentExtension, FragmentRingIndex, &VirtualAddressExtension, &BatchedAction);
+
+    FRE_ASSERT(LinearAction == BatchedAction);
 
     Result = 0;
 
 Exit:
 
+    if (Classifier != NULL) {
+        free(Classifier);
+    }
+
     for (UINT32 i = 0; i < RTL_NUMBER_OF(FragmentRing.Buffers); i++) {
         XDP_BUFFER_WITH_EXTENSIONS *BufferExt = &FragmentRing.Buffers[i];
 
@@ -30,11 +30,14 @@
 #include <xdpassert.h>
 #include <xdppcw.h>
 #include <xdprtl.h>
+#include <xdptoeplitz.h>
 
 #include <stubs/dispatch.h>
 #include <extensionset.h>
 #include <program.h>
+#include <maptable.h>
 #include <stubs/map.h>
 #include <stubs/rx.h>
+#include <stubs/txredirect.h>
 #include <stubs/xsk.h>
 #include <xdpp.h>
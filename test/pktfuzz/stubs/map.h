@@ -57,6 +57,57 @@ XdpXskMapLookup(
     return NULL;
 }
 
+inline
+VOID *
+XdpQuicCidMapLookup(
+    _In_ XDP_MAP *Map,
+    _In_reads_bytes_(CidLength) const UINT8 *Cid,
+    _In_ UINT8 CidLength
+    )
+{
+    //
+    // User-mode harnesses represent a QUIC CID map by its bare table.
+    //
+    UINT32 Key[XDP_MAP_TABLE_QUIC_CID_KEY_LENGTH / sizeof(UINT32)];
+    const XDP_MAP_TABLE_VALUE *Value;
+
+    XdpMapTableInitializeQuicCidKey(Key, Cid, CidLength);
+    Value = XdpMapTableLookup((const XDP_MAP_TABLE *)Map, Key);
+
+    return (Value != NULL) ? Value->Target : NULL;
+}
+
+inline
+const XDP_MAP_TABLE_VALUE *
+XdpHashMapLookup(
+    _In_ XDP_MAP *Map,
+    _In_ const XDP_HASH_MAP_KEY *Key
+    )
+{
+    //
+    // User-mode harnesses represent a hash map by its bare table.
+    //
+    return XdpMapTableLookup((const XDP_MAP_TABLE *)Map, (const UINT32 *)Key);
+}
+
+inline
+const XDP_MAP_TABLE_VALUE *
+XdpLpmMapLookup(
+    _In_ XDP_MAP *Map,
+    _In_ ADDRESS_FAMILY AddressFamily,
+    _In_ const XDP_INET_ADDR *Address
+    )
+{
+    //
+    // User-mode harnesses represent an LPM map by its bare table.
+    //
+    const XDP_LPM_TABLE *Table = (const XDP_LPM_TABLE *)Map;
+
+    return
+        XdpLpmTableLookup(
+            (AddressFamily == AF_INET) ? &Table->Ipv4 : &Table->Ipv6, (const UINT8 *)Address);
+}
+
 inline
 UINT32
 XdpRxQueueGetQueueIdFromInspectionContext(
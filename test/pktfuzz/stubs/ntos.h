@@ -39,6 +39,24 @@ ExFreePoolWithTag(
     free(P);
 }
 
+inline
+ULONGLONG
+KeQueryInterruptTime(
+    VOID
+    )
+{
+    return GetTickCount64() * 10000;
+}
+
+inline
+ULONG
+KeGetCurrentProcessorIndex(
+    VOID
+    )
+{
+    return GetCurrentProcessorNumber();
+}
+
 typedef CCHAR KPROCESSOR_MODE;
 
 typedef enum _MODE {
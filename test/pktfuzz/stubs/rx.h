@@ -9,3 +9,8 @@ XDP_PCW_RX_QUEUE *
 XdpRxQueueGetStatsFromInspectionContext(
     _In_ const XDP_INSPECTION_CONTEXT *Context
     );
+
+XDP_RX_QUEUE *
+XdpRxQueueFromRedirectContext(
+    _In_ XDP_REDIRECT_CONTEXT *RedirectContext
+    );
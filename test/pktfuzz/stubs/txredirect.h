@@ -0,0 +1,33 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+#pragma once
+
+typedef struct _XDP_TX_REDIRECT XDP_TX_REDIRECT;
+
+inline
+NTSTATUS
+XdpTxRedirectCreate(
+    _In_ UINT32 IfIndex,
+    _In_ UINT32 QueueId,
+    _Out_ XDP_TX_REDIRECT **TxRedirect
+    )
+{
+    UNREFERENCED_PARAMETER(IfIndex);
+    UNREFERENCED_PARAMETER(QueueId);
+
+    *TxRedirect = NULL;
+
+    return STATUS_NOT_SUPPORTED;
+}
+
+inline
+VOID
+XdpTxRedirectDereference(
+    _In_ XDP_TX_REDIRECT *TxRedirect
+    )
+{
+    DBG_UNREFERENCED_PARAMETER(TxRedirect);
+}
@@ -32,3 +32,8 @@ XskDereferenceDatapathHandle(
 
     ASSERT(XskHandle != NULL);
 }
+
+VOID
+XskReceive(
+    _In_ XDP_REDIRECT_BATCH *Batch
+    );
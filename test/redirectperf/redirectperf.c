@@ -0,0 +1,152 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+//
+// This redirectperf microbenchmark measures XDP redirect batching when
+// consecutive frames are redirected to different XSKs, as with XSKMAP fan-out
+// or per-flow QUIC CID redirects. Frames are assigned to targets round-robin,
+// which is the worst case for batching, and the benchmark reports the average
+// number of frames delivered per XskReceive call along with the per-frame
+// cost of XdpRedirect.
+//
+
+#include "precomp.h"
+#include <stdio.h>
+
+CONST CHAR *UsageText = "Usage: redirectperf [-Iterations <count>]";
+
+#define REQUIRE(expr) \
+    if (!(expr)) { printf("("#expr") failed line %d\n", __LINE__);  exit(1);}
+
+//
+// Number of frames indicated per receive batch, after which all pending
+// redirects are flushed.
+//
+#define REDIRECTPERF_RX_BATCH_SIZE 256
+
+typedef struct _REDIRECTPERF_TARGET {
+    volatile LONG64 ProducerIndex;
+    UINT64 FrameCount;
+    UINT64 BatchCount;
+} REDIRECTPERF_TARGET;
+
+static const UINT32 TargetCounts[] = { 1, 2, 4, 8, 16 };
+
+static XDP_REDIRECT_CONTEXT RedirectContext;
+
+VOID
+Usage(
+    CHAR *Error
+    )
+{
+    fprintf(stderr, "Error: %s\n%s", Error, UsageText);
+    exit(1);
+}
+
+XDP_RX_QUEUE *
+XdpRxQueueFromRedirectContext(
+    _In_ XDP_REDIRECT_CONTEXT *Context
+    )
+{
+    UNREFERENCED_PARAMETER(Context);
+
+    return NULL;
+}
+
+VOID
+XskReceive(
+    _In_ XDP_REDIRECT_BATCH *Batch
+    )
+{
+    REDIRECTPERF_TARGET *Target = Batch->Target;
+
+    //
+    // Approximate the fixed cost of publishing a batch to an XSK RX ring.
+    //
+    InterlockedAdd64(&Target->ProducerIndex, Batch->Count);
+    Target->FrameCount += Batch->Count;
+    Target->BatchCount++;
+}
+
+static
+VOID
+RunTargets(
+    _In_ UINT32 TargetCount,
+    _In_ UINT64 Iterations
+    )
+{
+    REDIRECTPERF_TARGET *Targets;
+    UINT64 RxBatches = max(Iterations / REDIRECTPERF_RX_BATCH_SIZE, 1);
+    UINT64 FrameCount = 0;
+    UINT64 BatchCount = 0;
+    LARGE_INTEGER Frequency;
+    LARGE_INTEGER Start;
+    LARGE_INTEGER End;
+    double RedirectNs;
+
+    Targets = calloc(TargetCount, sizeof(*Targets));
+    REQUIRE(Targets != NULL);
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Start);
+
+    for (UINT64 i = 0; i < RxBatches; i++) {
+        for (UINT32 FrameIndex = 0; FrameIndex < REDIRECTPERF_RX_BATCH_SIZE; FrameIndex++) {
+            XdpRedirect(
+                &RedirectContext, FrameIndex, 0, XDP_REDIRECT_TARGET_TYPE_XSK,
+                &Targets[FrameIndex % TargetCount]);
+        }
+
+        XdpFlushRedirect(&RedirectContext);
+    }
+
+    QueryPerformanceCounter(&End);
+
+    for (UINT32 i = 0; i < TargetCount; i++) {
+        REQUIRE(Targets[i].ProducerIndex == (LONG64)Targets[i].FrameCount);
+        FrameCount += Targets[i].FrameCount;
+        BatchCount += Targets[i].BatchCount;
+    }
+
+    REQUIRE(FrameCount == RxBatches * REDIRECTPERF_RX_BATCH_SIZE);
+
+    RedirectNs =
+        (double)(End.QuadPart - Start.QuadPart) * 1000000000.0 /
+            (double)Frequency.QuadPart / (double)FrameCount;
+
+    printf(
+        "Targets=%-3u Slots=%u Frames/Batch=%.1f Redirect=%.1fns/frame\n",
+        TargetCount, XDP_REDIRECT_BATCH_COUNT, (double)FrameCount / (double)BatchCount,
+        RedirectNs);
+
+    free(Targets);
+}
+
+INT
+__cdecl
+main(
+    INT ArgC,
+    CHAR **ArgV
+    )
+{
+    UINT64 Iterations = 0x4000000;
+
+    for (INT i = 1; i < ArgC; i++) {
+        if (!_stricmp(ArgV[i], "-Iterations") && i + 1 < ArgC) {
+            Iterations = _strtoui64(ArgV[++i], NULL, 0);
+            if (Iterations == 0) {
+                Usage("Invalid -Iterations");
+            }
+        } else {
+            Usage("Invalid parameter");
+        }
+    }
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(TargetCounts); i++) {
+        RunTargets(TargetCounts[i], Iterations);
+    }
+
+    return 0;
+}
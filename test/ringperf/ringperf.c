@@ -58,7 +58,7 @@ ProdRoutine(
             Frame->Buffer.Address.BaseAddress = ProdBaseAddress;
             Frame->Buffer.Address.Offset = 2;
             Frame->Buffer.Length = 3;
-            Frame->Buffer.Reserved = 0;
+            Frame->Buffer.Flags = 0;
         }
         XskRingProducerSubmit(&RingShared->Ring, ProdAvailable);
 
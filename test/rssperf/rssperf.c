@@ -0,0 +1,451 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+//
+// This rssperf microbenchmark measures generic XDP RSS queue selection for
+// NICs that do not indicate an RSS hash.
+//
+// When the queue is inferred from the current processor, it compares the
+// original scan of the indirection table against the (processor -> queue)
+// index published with the table, for tables of 2 to 128 entries.
+//
+// When the hash is computed in software, it verifies the Toeplitz helpers in
+// xdptoeplitz.h against the NDIS reference vectors and compares the
+// throughput of the bitwise and table-driven implementations.
+//
+
+#include <xdp/wincommon.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <xdpassert.h>
+#include <xdptoeplitz.h>
+
+CONST CHAR *UsageText = "Usage: rssperf [-Lookups <count>] [-Processors <count>]";
+
+#define REQUIRE(expr) \
+    if (!(expr)) { printf("("#expr") failed line %d\n", __LINE__);  exit(1);}
+
+//
+// Matches the largest NDIS RSS indirection table.
+//
+#define MAX_ENTRY_COUNT 128
+
+static const UINT32 EntryCounts[] = { 2, 4, 8, 16, 32, 64, 128 };
+
+//
+// The NDIS reference secret key and hash vectors, from "Verifying the RSS Hash
+// Calculation". Each input is the source address, destination address, source
+// port and destination port in network byte order. The address-only hash
+// covers the address pair, and the port hash covers the whole input.
+//
+static const UCHAR ReferenceKey[] = {
+    0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2, 0x41, 0x67,
+    0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0, 0xd0, 0xca, 0x2b, 0xcb,
+    0xae, 0x7b, 0x30, 0xb4, 0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30,
+    0xf2, 0x0c, 0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa,
+};
+
+typedef struct _REFERENCE_VECTOR {
+    UINT32 AddressLength;
+    UCHAR Input[XDP_TOEPLITZ_MAX_INPUT_SIZE];
+    UINT32 AddressHash;
+    UINT32 PortHash;
+} REFERENCE_VECTOR;
+
+#define PORT(Port) (UCHAR)((Port) >> 8), (UCHAR)(Port)
+
+static const REFERENCE_VECTOR ReferenceVectors[] = {
+    {
+        4,
+        { 66, 9, 149, 187, 161, 142, 100, 80, PORT(2794), PORT(1766) },
+        0x323e8fc2, 0x51ccc178
+    },
+    {
+        4,
+        { 199, 92, 111, 2, 65, 69, 140, 83, PORT(14230), PORT(4739) },
+        0xd718262a, 0xc626b0ea
+    },
+    {
+        4,
+        { 24, 19, 198, 95, 12, 22, 207, 184, PORT(12898), PORT(38024) },
+        0xd2d0a5de, 0x5c2b394a
+    },
+    {
+        4,
+        { 38, 27, 205, 30, 209, 142, 163, 6, PORT(48228), PORT(2217) },
+        0x82989176, 0xafc7327f
+    },
+    {
+        4,
+        { 153, 39, 163, 191, 202, 188, 127, 2, PORT(44251), PORT(1303) },
+        0x5d1809c5, 0x10e828a2
+    },
+    {
+        16,
+        {
+            // 3ffe:2501:200:1fff::7 -> 3ffe:2501:200:3::1
+            0x3f, 0xfe, 0x25, 0x01, 0x02, 0x00, 0x1f, 0xff,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07,
+            0x3f, 0xfe, 0x25, 0x01, 0x02, 0x00, 0x00, 0x03,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+            PORT(2794), PORT(1766)
+        },
+        0x2cc18cd5, 0x40207d3d
+    },
+    {
+        16,
+        {
+            // 3ffe:501:8::260:97ff:fe40:efab -> ff02::1
+            0x3f, 0xfe, 0x05, 0x01, 0x00, 0x08, 0x00, 0x00,
+            0x02, 0x60, 0x97, 0xff, 0xfe, 0x40, 0xef, 0xab,
+            0xff, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+            PORT(14230), PORT(4739)
+        },
+        0x0f0c461c, 0xdde51bbf
+    },
+    {
+        16,
+        {
+            // 3ffe:1900:4545:3:200:f8ff:fe21:67cf -> fe80::200:f8ff:fe21:67cf
+            0x3f, 0xfe, 0x19, 0x00, 0x45, 0x45, 0x00, 0x03,
+            0x02, 0x00, 0xf8, 0xff, 0xfe, 0x21, 0x67, 0xcf,
+            0xfe, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x02, 0x00, 0xf8, 0xff, 0xfe, 0x21, 0x67, 0xcf,
+            PORT(44251), PORT(38024)
+        },
+        0x4b61e985, 0x02d1feef
+    },
+};
+
+//
+// Hash input lengths: IPv4 and IPv6 address pairs, with and without ports.
+//
+static const UINT32 HashInputLengths[] = { 8, 12, 32, 36 };
+
+typedef struct _RSS_QUEUE {
+    ULONG RssHash;
+    ULONG IdealProcessor;
+} RSS_QUEUE;
+
+typedef struct _INDIRECTION_TABLE {
+    ULONG IndirectionMask;
+    ULONG ProcessorCount;
+    UINT32 *ProcessorQueues;
+    UINT32 Entries[MAX_ENTRY_COUNT];
+} INDIRECTION_TABLE;
+
+typedef
+RSS_QUEUE *
+GET_QUEUE_ROUTINE(
+    _In_ CONST INDIRECTION_TABLE *IndirectionTable,
+    _In_ RSS_QUEUE *Queues,
+    _In_ ULONG CurrentProcessor
+    );
+
+VOID
+Usage(
+    CHAR *Error
+    )
+{
+    fprintf(stderr, "Error: %s\n%s", Error, UsageText);
+    exit(1);
+}
+
+static
+RSS_QUEUE *
+GetQueueScan(
+    _In_ CONST INDIRECTION_TABLE *IndirectionTable,
+    _In_ RSS_QUEUE *Queues,
+    _In_ ULONG CurrentProcessor
+    )
+{
+    //
+    // The original implementation: scan the indirection table for a queue
+    // affinitized to the current processor.
+    //
+    for (UINT32 Index = 0; Index <= IndirectionTable->IndirectionMask; Index++) {
+        RSS_QUEUE *Queue = &Queues[IndirectionTable->Entries[Index]];
+
+        if (Queue->IdealProcessor == CurrentProcessor) {
+            return Queue;
+        }
+    }
+
+    return &Queues[0];
+}
+
+static
+RSS_QUEUE *
+GetQueueIndex(
+    _In_ CONST INDIRECTION_TABLE *IndirectionTable,
+    _In_ RSS_QUEUE *Queues,
+    _In_ ULONG CurrentProcessor
+    )
+{
+    if (CurrentProcessor < IndirectionTable->ProcessorCount) {
+        return &Queues[IndirectionTable->ProcessorQueues[CurrentProcessor]];
+    }
+
+    return &Queues[0];
+}
+
+static
+VOID
+CreateIndirection(
+    _Out_ INDIRECTION_TABLE *IndirectionTable,
+    _Out_writes_(ProcessorCount) RSS_QUEUE *Queues,
+    _Out_writes_(ProcessorCount) UINT32 *ProcessorQueues,
+    _In_ UINT32 EntryCount,
+    _In_ UINT32 ProcessorCount
+    )
+{
+    UINT32 AssignedQueues = 0;
+
+    //
+    // Mirror XdpGenericRssCreateIndirection: spread the entries across every
+    // other processor, so half the processors are absent from the table and
+    // take the scan's worst case.
+    //
+    RtlZeroMemory(IndirectionTable, sizeof(*IndirectionTable));
+    RtlZeroMemory(Queues, ProcessorCount * sizeof(*Queues));
+    RtlZeroMemory(ProcessorQueues, ProcessorCount * sizeof(*ProcessorQueues));
+
+    IndirectionTable->IndirectionMask = EntryCount - 1;
+    IndirectionTable->ProcessorCount = ProcessorCount;
+    IndirectionTable->ProcessorQueues = ProcessorQueues;
+
+    for (UINT32 Index = 0; Index < EntryCount; Index++) {
+        ULONG TargetProcessor = (Index * 2) % ProcessorCount;
+        UINT32 QueueIndex;
+
+        for (QueueIndex = 0; QueueIndex < AssignedQueues; QueueIndex++) {
+            if (Queues[QueueIndex].IdealProcessor == TargetProcessor) {
+                break;
+            }
+        }
+
+        if (QueueIndex == AssignedQueues) {
+            QueueIndex = AssignedQueues++;
+            Queues[QueueIndex].IdealProcessor = TargetProcessor;
+            Queues[QueueIndex].RssHash = Index;
+        }
+
+        IndirectionTable->Entries[Index] = QueueIndex;
+    }
+
+    for (UINT32 QueueIndex = 0; QueueIndex < AssignedQueues; QueueIndex++) {
+        ProcessorQueues[Queues[QueueIndex].IdealProcessor] = QueueIndex;
+    }
+}
+
+static
+double
+Measure(
+    _In_ GET_QUEUE_ROUTINE *Routine,
+    _In_ CONST INDIRECTION_TABLE *IndirectionTable,
+    _In_ RSS_QUEUE *Queues,
+    _In_ UINT32 ProcessorCount,
+    _In_ UINT64 Lookups
+    )
+{
+    LARGE_INTEGER Frequency;
+    LARGE_INTEGER Start;
+    LARGE_INTEGER End;
+    volatile RSS_QUEUE *Result;
+
+    //
+    // Call through a volatile pointer so neither lookup is hoisted out of the
+    // loop by the optimizer.
+    //
+    GET_QUEUE_ROUTINE *volatile GetQueue = Routine;
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Start);
+
+    for (UINT64 i = 0; i < Lookups; i++) {
+        Result = GetQueue(IndirectionTable, Queues, (ULONG)(i % ProcessorCount));
+    }
+
+    QueryPerformanceCounter(&End);
+    UNREFERENCED_PARAMETER(Result);
+
+    //
+    // Return the cost of a lookup in nanoseconds.
+    //
+    return
+        (double)(End.QuadPart - Start.QuadPart) * 1000000000.0 /
+            (double)Frequency.QuadPart / (double)Lookups;
+}
+
+static
+VOID
+VerifyToeplitz(
+    _In_ CONST XDP_TOEPLITZ_TABLE *Table
+    )
+{
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(ReferenceVectors); i++) {
+        CONST REFERENCE_VECTOR *Vector = &ReferenceVectors[i];
+        UINT32 AddressPairLength = Vector->AddressLength * 2;
+        UINT32 InputLength = AddressPairLength + 2 * sizeof(UINT16);
+
+        REQUIRE(
+            XdpToeplitzHashScalar(
+                ReferenceKey, sizeof(ReferenceKey), Vector->Input, AddressPairLength) ==
+                Vector->AddressHash);
+        REQUIRE(
+            XdpToeplitzHashScalar(
+                ReferenceKey, sizeof(ReferenceKey), Vector->Input, InputLength) ==
+                Vector->PortHash);
+        REQUIRE(XdpToeplitzHash(Table, Vector->Input, AddressPairLength) == Vector->AddressHash);
+        REQUIRE(XdpToeplitzHash(Table, Vector->Input, InputLength) == Vector->PortHash);
+    }
+
+    //
+    // Cross-check the implementations on random inputs of every length.
+    //
+    for (UINT32 i = 0; i < 10000; i++) {
+        UCHAR Input[XDP_TOEPLITZ_MAX_INPUT_SIZE];
+        UINT32 InputLength = i % (sizeof(Input) + 1);
+
+        for (UINT32 j = 0; j < InputLength; j++) {
+            Input[j] = (UCHAR)rand();
+        }
+
+        REQUIRE(
+            XdpToeplitzHash(Table, Input, InputLength) ==
+                XdpToeplitzHashScalar(ReferenceKey, sizeof(ReferenceKey), Input, InputLength));
+    }
+}
+
+static
+double
+MeasureToeplitz(
+    _In_opt_ CONST XDP_TOEPLITZ_TABLE *Table,
+    _In_ UINT32 InputLength,
+    _In_ UINT64 Hashes
+    )
+{
+    LARGE_INTEGER Frequency;
+    LARGE_INTEGER Start;
+    LARGE_INTEGER End;
+    UCHAR Input[XDP_TOEPLITZ_MAX_INPUT_SIZE];
+    volatile UINT32 Result;
+
+    for (UINT32 i = 0; i < sizeof(Input); i++) {
+        Input[i] = (UCHAR)rand();
+    }
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Start);
+
+    for (UINT64 i = 0; i < Hashes; i++) {
+        //
+        // Vary the input so each hash depends on the previous iteration.
+        //
+        Input[0] = (UCHAR)i;
+
+        if (Table != NULL) {
+            Result = XdpToeplitzHash(Table, Input, InputLength);
+        } else {
+            Result =
+                XdpToeplitzHashScalar(ReferenceKey, sizeof(ReferenceKey), Input, InputLength);
+        }
+    }
+
+    QueryPerformanceCounter(&End);
+    UNREFERENCED_PARAMETER(Result);
+
+    //
+    // Return the throughput in millions of hashes per second.
+    //
+    return
+        (double)Hashes * (double)Frequency.QuadPart /
+            (double)(End.QuadPart - Start.QuadPart) / 1000000.0;
+}
+
+INT
+__cdecl
+main(
+    INT ArgC,
+    CHAR **ArgV
+    )
+{
+    UINT64 Lookups = 100000000;
+    UINT32 ProcessorCount = 64;
+    INDIRECTION_TABLE IndirectionTable;
+    RSS_QUEUE *Queues;
+    UINT32 *ProcessorQueues;
+    XDP_TOEPLITZ_TABLE *Toeplitz;
+
+    for (INT i = 1; i < ArgC; i++) {
+        if (!_stricmp(ArgV[i], "-Lookups") && i + 1 < ArgC) {
+            Lookups = _strtoui64(ArgV[++i], NULL, 0);
+            if (Lookups == 0) {
+                Usage("Invalid -Lookups");
+            }
+        } else if (!_stricmp(ArgV[i], "-Processors") && i + 1 < ArgC) {
+            ProcessorCount = strtoul(ArgV[++i], NULL, 0);
+            if (ProcessorCount == 0) {
+                Usage("Invalid -Processors");
+            }
+        } else {
+            Usage("Invalid parameter");
+        }
+    }
+
+    Queues = malloc(ProcessorCount * sizeof(*Queues));
+    REQUIRE(Queues != NULL);
+    ProcessorQueues = malloc(ProcessorCount * sizeof(*ProcessorQueues));
+    REQUIRE(ProcessorQueues != NULL);
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(EntryCounts); i++) {
+        UINT32 EntryCount = EntryCounts[i];
+        double Scan;
+        double Index;
+
+        CreateIndirection(
+            &IndirectionTable, Queues, ProcessorQueues, EntryCount, ProcessorCount);
+
+        for (ULONG Processor = 0; Processor < ProcessorCount + 1; Processor++) {
+            REQUIRE(
+                GetQueueScan(&IndirectionTable, Queues, Processor) ==
+                    GetQueueIndex(&IndirectionTable, Queues, Processor));
+        }
+
+        Scan = Measure(GetQueueScan, &IndirectionTable, Queues, ProcessorCount, Lookups);
+        Index = Measure(GetQueueIndex, &IndirectionTable, Queues, ProcessorCount, Lookups);
+
+        printf(
+            "Entries=%-3u Processors=%u Scan=%.2fns Index=%.2fns Speedup=%.2fx\n",
+            EntryCount, ProcessorCount, Scan, Index, Scan / Index);
+    }
+
+    Toeplitz = malloc(sizeof(*Toeplitz));
+    REQUIRE(Toeplitz != NULL);
+    XdpToeplitzInitializeTable(Toeplitz, ReferenceKey, sizeof(ReferenceKey));
+
+    VerifyToeplitz(Toeplitz);
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(HashInputLengths); i++) {
+        UINT32 InputLength = HashInputLengths[i];
+        UINT64 Hashes = max(Lookups / 10, 1);
+        double Scalar;
+        double Table;
+
+        Scalar = MeasureToeplitz(NULL, InputLength, Hashes);
+        Table = MeasureToeplitz(Toeplitz, InputLength, Hashes);
+
+        printf(
+            "InputBytes=%-2u Scalar=%.2fMH/s Table=%.2fMH/s Speedup=%.2fx\n",
+            InputLength, Scalar, Table, Table / Scalar);
+    }
+
+    free(Toeplitz);
+    free(ProcessorQueues);
+    free(Queues);
+
+    return 0;
+}
@@ -720,7 +720,7 @@ AttachXdpProgram(
         rule.Match = XDP_MATCH_ALL;
 
         if (!(RandUlong() % 2)) {
-            rule.Match = RandUlong() % (XDP_MATCH_ICMPV6_ECHO_REPLY_IP_DST + 1);
+            rule.Match = RandUlong() % (XDP_MATCH_QUIC_FLOW_DST_CID_MAP + 1);
         }
 
         if (!(RandUlong() % 128)) {
@@ -756,6 +756,13 @@ AttachXdpProgram(
             //
             rule.Action = XDP_PROGRAM_ACTION_REDIRECT;
             rule.Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_QUEUEID;
+            if (RandUlong() % 2) {
+                //
+                // Spread flows across a random width, including invalid ones.
+                //
+                rule.Redirect.TargetType = XDP_REDIRECT_TARGET_TYPE_XSKMAP_BY_FLOW_HASH;
+                rule.Redirect.FlowHashWidth = RandUlong() % (XDP_REDIRECT_MAX_FLOW_HASH_WIDTH + 2);
+            }
             AcquireSRWLockShared(&Queue->xskMapLock);
             rule.Redirect.Target = Queue->xskMap;
             ReleaseSRWLockShared(&Queue->xskMapLock);
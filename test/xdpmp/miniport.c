@@ -281,6 +281,13 @@ MpInitialize(
         goto Exit;
     }
 
+    //
+    // XDPMP can receive directly into buffers posted by an RX buffer provider.
+    //
+    Adapter->Capabilities.CapabilitiesEx.RxBufferProviderSupported = TRUE;
+    Adapter->Capabilities.CapabilitiesEx.Header.Size =
+        RTL_SIZEOF_THROUGH_FIELD(XDP_CAPABILITIES_EX, RxBufferProviderSupported);
+
     RegistrationAttributes = &AdapterAttributes.RegistrationAttributes;
 
     RegistrationAttributes->Header.Type =
@@ -662,6 +669,12 @@ DriverEntry(
         XDP_FRAME_EXTENSION_RX_ACTION_VERSION_1,
         XDP_EXTENSION_TYPE_FRAME);
 
+    XdpInitializeExtensionInfo(
+        &MpSupportedXdpExtensions.Fragment,
+        XDP_FRAME_EXTENSION_FRAGMENT_NAME,
+        XDP_FRAME_EXTENSION_FRAGMENT_VERSION_1,
+        XDP_EXTENSION_TYPE_FRAME);
+
     MpGlobalContext.NdisVersion = NdisGetVersion();
     MpGlobalContext.Medium = NdisMedium802_3;
     MpGlobalContext.LinkSpeed = MAXULONG;
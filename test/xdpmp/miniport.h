@@ -58,6 +58,19 @@ typedef struct _ADAPTER_RX_QUEUE {
     XDP_EXTENSION BufferVaExtension;
     XDP_EXTENSION RxActionExtension;
 
+    //
+    // When an XDP buffer provider is enabled, the simulated hardware receives
+    // each frame into a provided buffer. ProviderHwDescriptors tracks the HW
+    // descriptor paired with each frame ring element, and provided buffers
+    // not consumed by XDP are stashed for reuse.
+    //
+    XDP_RING *ProviderRing;
+    XDP_RX_PROVIDED_BUFFER *ProviderStash;
+    UINT32 ProviderStashCount;
+    UINT32 ProviderStashSize;
+    UINT32 *ProviderHwDescriptors;
+    UINT32 ProviderPatternLength;
+
     HW_RING *HwRing;
     UCHAR *BufferArray;
     UINT32 *RecycleArray;
@@ -93,7 +106,9 @@ typedef struct _ADAPTER_TX_QUEUE {
 
     XDP_TX_QUEUE_HANDLE XdpTxQueue;
     XDP_RING *FrameRing;
+    XDP_RING *FragmentRing;
     XDP_EXTENSION BufferVaExtension;
+    XDP_EXTENSION FragmentExtension;
     UINT32 XdpHwDescriptorsAvailable;
 
     HW_RING *HwRing;
@@ -219,6 +234,7 @@ typedef struct _MINIPORT_SUPPORTED_XDP_EXTENSIONS {
     XDP_EXTENSION_INFO VirtualAddress;
     XDP_EXTENSION_INFO LogicalAddress;
     XDP_EXTENSION_INFO RxAction;
+    XDP_EXTENSION_INFO Fragment;
 } MINIPORT_SUPPORTED_XDP_EXTENSIONS;
 
 extern MINIPORT_SUPPORTED_XDP_EXTENSIONS MpSupportedXdpExtensions;
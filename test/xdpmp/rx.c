@@ -106,6 +106,91 @@ MpNdisReceive(
     Rq->Stats.RxBytes += DataLength;
 }
 
+static
+BOOLEAN
+MpReceiveProvideFrame(
+    _In_ ADAPTER_RX_QUEUE *Rq,
+    _In_ UINT32 HwRxDescriptor,
+    _In_ UINT32 FrameRingIndex,
+    _Inout_ XDP_FRAME *Frame
+    )
+{
+    XDP_BUFFER_VIRTUAL_ADDRESS *Va;
+    XDP_RX_PROVIDED_BUFFER ProvidedBuffer;
+
+    //
+    // Prefer buffers XDP returned to the interface over new provider buffers.
+    //
+    if (Rq->ProviderStashCount > 0) {
+        ProvidedBuffer = Rq->ProviderStash[--Rq->ProviderStashCount];
+    } else if (XdpRingCount(Rq->ProviderRing) > 0) {
+        ProvidedBuffer =
+            *(XDP_RX_PROVIDED_BUFFER *)XdpRingGetElement(
+                Rq->ProviderRing, Rq->ProviderRing->ConsumerIndex++ & Rq->ProviderRing->Mask);
+    } else {
+        return FALSE;
+    }
+
+    //
+    // XDPMP is a software device not capable of DMA, so simulate the hardware
+    // writing the packet content directly into the provided buffer.
+    //
+    if (Rq->ProviderPatternLength > 0) {
+        RtlCopyMemory(
+            ProvidedBuffer.VirtualAddress, Rq->PatternBuffer,
+            min(Rq->ProviderPatternLength, ProvidedBuffer.BufferLength));
+    }
+
+    Frame->Buffer.DataLength = min(Rq->DataLength, ProvidedBuffer.BufferLength);
+    Frame->Buffer.BufferLength = ProvidedBuffer.BufferLength;
+    Frame->Buffer.DataOffset = 0;
+
+    Va = XdpGetVirtualAddressExtension(&Frame->Buffer, &Rq->BufferVaExtension);
+    Va->VirtualAddress = ProvidedBuffer.VirtualAddress;
+
+    Rq->ProviderHwDescriptors[FrameRingIndex] = HwRxDescriptor;
+
+    return TRUE;
+}
+
+static
+VOID
+MpReceiveReclaimProvidedFrame(
+    _In_ ADAPTER_RX_QUEUE *Rq,
+    _In_ UINT32 HwRxDescriptor,
+    _Inout_ XDP_BUFFER *Buffer,
+    _Inout_ XDP_BUFFER_VIRTUAL_ADDRESS *Va,
+    _In_ XDP_RX_ACTION RxAction
+    )
+{
+    XDP_RX_PROVIDED_BUFFER *ProvidedBuffer;
+
+    //
+    // XDP did not consume the provided buffer, so the interface still owns it.
+    // Frames continuing on the regular receive or RX->TX paths are copied into
+    // the hardware descriptor's own buffer, and the provided buffer is stashed
+    // for the next received frame.
+    //
+    if (RxAction == XDP_RX_ACTION_PASS || RxAction == XDP_RX_ACTION_TX) {
+        UINT32 DataLength = min(Buffer->DataLength, Rq->BufferLength);
+
+        RtlCopyMemory(
+            Rq->BufferArray + HwRxDescriptor, Va->VirtualAddress + Buffer->DataOffset,
+            DataLength);
+        Buffer->DataLength = DataLength;
+        Buffer->DataOffset = 0;
+    }
+
+    ASSERT(Rq->ProviderStashCount < Rq->ProviderStashSize);
+    ProvidedBuffer = &Rq->ProviderStash[Rq->ProviderStashCount++];
+    ProvidedBuffer->VirtualAddress = Va->VirtualAddress;
+    ProvidedBuffer->BufferLength = Buffer->BufferLength;
+    ProvidedBuffer->Reserved = 0;
+
+    Buffer->BufferLength = Rq->BufferLength;
+    Va->VirtualAddress = Rq->BufferArray + HwRxDescriptor;
+}
+
 static
 UINT32
 MpReceiveProcessBatch(
@@ -136,7 +221,16 @@ MpReceiveProcessBatch(
         Buffer = &Frame->Buffer;
         Action = XdpGetRxActionExtension(Frame, &Rq->RxActionExtension);
         Va = XdpGetVirtualAddressExtension(Buffer, &Rq->BufferVaExtension);
-        HwRxDescriptor = (UINT32)(Va->VirtualAddress - Rq->BufferArray);
+
+        if (Rq->ProviderRing != NULL) {
+            HwRxDescriptor = Rq->ProviderHwDescriptors[FrameRingIndex];
+
+            if (Action->RxAction != XDP_RX_ACTION_CONSUMED) {
+                MpReceiveReclaimProvidedFrame(Rq, HwRxDescriptor, Buffer, Va, Action->RxAction);
+            }
+        } else {
+            HwRxDescriptor = (UINT32)(Va->VirtualAddress - Rq->BufferArray);
+        }
 
         switch (Action->RxAction) {
         case XDP_RX_ACTION_PASS:
@@ -164,6 +258,18 @@ MpReceiveProcessBatch(
             Rq->RxTxArray[Rq->RxTxIndex++] = FrameRingIndex;
             break;
 
+        case XDP_RX_ACTION_CONSUMED:
+            //
+            // XDP returned the provided buffer to its provider, so only the
+            // hardware descriptor remains to be recycled.
+            //
+            ASSERT(Rq->ProviderRing != NULL);
+            XdpAbsorbed++;
+            Rq->Stats.RxFrames++;
+            Rq->Stats.RxBytes += Buffer->DataLength;
+            MpReceiveRecycle(Rq, HwRxDescriptor);
+            break;
+
         default:
             ASSERT(FALSE);
             break;
@@ -237,9 +343,34 @@ MpReceiveUseXdpMultiFrameApi(
         while (FrameQuota-- > 0 && HwRingConsPeek(Rq->HwRing) > 0) {
             XDP_FRAME *Frame;
             XDP_BUFFER_VIRTUAL_ADDRESS *Va;
+            UINT32 FrameRingIndex;
 
             HwRxDescriptor = HwRingConsPopElement(Rq->HwRing);
 
+            if (Rq->ProviderRing != NULL) {
+                FrameRingIndex = FrameRing->ProducerIndex & FrameRing->Mask;
+                Frame = XdpRingGetElement(FrameRing, FrameRingIndex);
+
+                if (!MpReceiveProvideFrame(Rq, *HwRxDescriptor, FrameRingIndex, Frame)) {
+                    //
+                    // The provider has not supplied enough buffers. Drop the
+                    // frame and ask XDP to replenish the provider ring.
+                    //
+                    Rq->Stats.RxDrops++;
+                    MpReceiveRecycle(Rq, *HwRxDescriptor);
+                    Rq->NeedFlush = TRUE;
+                    continue;
+                }
+
+                FrameRing->ProducerIndex++;
+
+                if (XdpRingFree(FrameRing) == 0) {
+                    XdpAbsorbed += MpReceiveProcessBatch(Rq, &StartIndex, NblChain);
+                }
+
+                continue;
+            }
+
             if (Rq->PatternLength > 0) {
                 //
                 // Reinitialize packet content. This is disabled by default, but
@@ -494,6 +625,7 @@ MpInitializeReceiveQueue(
 
     Rq->PatternBuffer = Adapter->RxPattern;
     Rq->PatternLength = Adapter->RxPatternCopy ? PatternLength : 0;
+    Rq->ProviderPatternLength = PatternLength;
 
     for (UINT32 i = 0; i < Rq->NumBuffers; i++) {
         UINT32 *Descriptor = HwRingGetElement(Rq->HwRing, i & Rq->HwRing->Mask);
@@ -613,6 +745,73 @@ MpXdpCreateRxQueue(
     return STATUS_SUCCESS;
 }
 
+static
+_IRQL_requires_(PASSIVE_LEVEL)
+VOID
+MpXdpCleanupRxBufferProvider(
+    _Inout_ ADAPTER_RX_QUEUE *Rq
+    )
+{
+    if (Rq->ProviderHwDescriptors != NULL) {
+        ExFreePoolWithTag(Rq->ProviderHwDescriptors, POOLTAG_RXBUFFER);
+        Rq->ProviderHwDescriptors = NULL;
+    }
+
+    if (Rq->ProviderStash != NULL) {
+        ExFreePoolWithTag(Rq->ProviderStash, POOLTAG_RXBUFFER);
+        Rq->ProviderStash = NULL;
+    }
+
+    Rq->ProviderStashCount = 0;
+    Rq->ProviderStashSize = 0;
+    Rq->ProviderRing = NULL;
+}
+
+static
+_IRQL_requires_(PASSIVE_LEVEL)
+NTSTATUS
+MpXdpActivateRxBufferProvider(
+    _Inout_ ADAPTER_RX_QUEUE *Rq,
+    _In_ XDP_RING *ProviderRing
+    )
+{
+    NTSTATUS Status;
+    const UINT32 FrameCount = Rq->FrameRing->Mask + 1;
+
+    //
+    // Every frame in the frame ring may carry a provided buffer that XDP
+    // returns to the interface, so size the stash to match.
+    //
+    Rq->ProviderStash =
+        ExAllocatePoolZero(
+            NonPagedPoolNx, FrameCount * sizeof(*Rq->ProviderStash), POOLTAG_RXBUFFER);
+    if (Rq->ProviderStash == NULL) {
+        Status = STATUS_NO_MEMORY;
+        goto Exit;
+    }
+
+    Rq->ProviderHwDescriptors =
+        ExAllocatePoolZero(
+            NonPagedPoolNx, FrameCount * sizeof(*Rq->ProviderHwDescriptors), POOLTAG_RXBUFFER);
+    if (Rq->ProviderHwDescriptors == NULL) {
+        Status = STATUS_NO_MEMORY;
+        goto Exit;
+    }
+
+    Rq->ProviderStashSize = FrameCount;
+    Rq->ProviderStashCount = 0;
+    Rq->ProviderRing = ProviderRing;
+    Status = STATUS_SUCCESS;
+
+Exit:
+
+    if (!NT_SUCCESS(Status)) {
+        MpXdpCleanupRxBufferProvider(Rq);
+    }
+
+    return Status;
+}
+
 _IRQL_requires_(PASSIVE_LEVEL)
 NTSTATUS
 MpXdpActivateRxQueue(
@@ -623,6 +822,7 @@ MpXdpActivateRxQueue(
 {
     ADAPTER_QUEUE *AdapterQueue = (ADAPTER_QUEUE *)InterfaceRxQueue;
     ADAPTER_RX_QUEUE *Rq = &AdapterQueue->Rq;
+    NTSTATUS Status;
 
     ASSERT(Rq->XdpState == XDP_STATE_INACTIVE);
 
@@ -638,6 +838,13 @@ MpXdpActivateRxQueue(
     XdpRxQueueGetExtension(
         Config, &MpSupportedXdpExtensions.RxAction, &Rq->RxActionExtension);
 
+    if (XdpRxQueueIsBufferProviderEnabled(Config)) {
+        Status = MpXdpActivateRxBufferProvider(Rq, XdpRxQueueGetBufferProviderRing(Config));
+        if (!NT_SUCCESS(Status)) {
+            return Status;
+        }
+    }
+
     WriteUInt32Release((UINT32 *)&Rq->XdpState, XDP_STATE_ACTIVE);
 
     return STATUS_SUCCESS;
@@ -677,5 +884,7 @@ MpXdpDeleteRxQueue(
     Rq->DeleteComplete = NULL;
     Rq->XdpRxQueue = NULL;
     Rq->FrameRing = NULL;
+
+    MpXdpCleanupRxBufferProvider(Rq);
 }
 
@@ -10,6 +10,12 @@ typedef struct {
     UINT32 Length;
 } TX_HW_DESCRIPTOR;
 
+//
+// The simulated hardware gathers up to this many XDP fragment buffers into a
+// single TX descriptor.
+//
+#define MP_TX_MAX_FRAGMENTS 16
+
 #define MP_NBL_GET_REF_COUNT(Nbl)       ((ULONG *)&((Nbl)->MiniportReserved[0]))
 #define MP_NB_GET_OWNING_NBL(Nb)        ((NET_BUFFER_LIST **)&((Nb)->MiniportReserved[0]))
 #define MP_NB_GET_NB_QUEUE_LINK(Nb)     ((NET_BUFFER **)&((Nb)->MiniportReserved[1]))
@@ -125,14 +131,21 @@ MpTransmitProcessCompletions(
 
             case TxSourceXdpTx:
             {
+                XDP_FRAME *Frame;
+
                 ASSERT(XdpActive);
                 ASSERT((FrameRing->InterfaceReserved - FrameRing->ConsumerIndex) > 0);
-#if DBG
-                XDP_FRAME *Frame =
-                    XdpRingGetElement(
-                        FrameRing, FrameRing->ConsumerIndex & FrameRing->Mask);
+                Frame = XdpRingGetElement(FrameRing, FrameRing->ConsumerIndex & FrameRing->Mask);
                 ASSERT(ShadowDescriptor->Frame == Frame);
-#endif
+
+                if (Tq->FragmentRing != NULL) {
+                    //
+                    // Fragment buffers complete along with their frame.
+                    //
+                    Tq->FragmentRing->ConsumerIndex +=
+                        XdpGetFragmentExtension(Frame, &Tq->FragmentExtension)->FragmentBufferCount;
+                }
+
                 ++FrameRing->ConsumerIndex;
                 Tq->XdpHwDescriptorsAvailable++;
                 XdpFramesCompleted++;
@@ -250,6 +263,23 @@ MpTransmitProcessPosts(
                 //
                 HwDescriptor->LogicalAddress = (UINT64)(Va->VirtualAddress) + Frame->Buffer.DataOffset;
                 HwDescriptor->Length = Frame->Buffer.DataLength;
+
+                if (Tq->FragmentRing != NULL) {
+                    XDP_RING *FragmentRing = Tq->FragmentRing;
+                    UINT8 FragmentCount =
+                        XdpGetFragmentExtension(Frame, &Tq->FragmentExtension)->FragmentBufferCount;
+
+                    //
+                    // Simulate a gather DMA: the frame occupies one HW
+                    // descriptor spanning all of its buffers.
+                    //
+                    for (UINT8 i = 0; i < FragmentCount; i++) {
+                        XDP_BUFFER *Buffer =
+                            XdpRingGetElement(
+                                FragmentRing, FragmentRing->InterfaceReserved++ & FragmentRing->Mask);
+                        HwDescriptor->Length += Buffer->DataLength;
+                    }
+                }
 #if DBG
                 ShadowDescriptor->Frame = Frame;
 #endif
@@ -540,6 +570,7 @@ MpXdpCreateTxQueue(
     XdpInitializeTxCapabilitiesSystemVa(&TxCapabilities);
 
     TxCapabilities.TransmitFrameCountHint = (UINT16)(Tq->HwRing->Mask + 1);
+    TxCapabilities.MaximumFragments = MP_TX_MAX_FRAGMENTS;
 
     XdpTxQueueSetCapabilities(Config, &TxCapabilities);
 
@@ -574,6 +605,12 @@ MpXdpActivateTxQueue(
     XdpTxQueueGetExtension(
         Config, &MpSupportedXdpExtensions.VirtualAddress, &Tq->BufferVaExtension);
 
+    if (XdpTxQueueIsFragmentationEnabled(Config)) {
+        Tq->FragmentRing = XdpTxQueueGetFragmentRing(Config);
+        XdpTxQueueGetExtension(
+            Config, &MpSupportedXdpExtensions.Fragment, &Tq->FragmentExtension);
+    }
+
     WriteUInt32Release((UINT32 *)&Tq->XdpState, XDP_STATE_ACTIVE);
 
     return STATUS_SUCCESS;
@@ -616,4 +653,5 @@ MpXdpDeleteTxQueue(
     Tq->DeleteComplete = NULL;
     Tq->XdpTxQueue = NULL;
     Tq->FrameRing = NULL;
+    Tq->FragmentRing = NULL;
 }
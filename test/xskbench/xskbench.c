@@ -36,6 +36,7 @@
 #define DEFAULT_UDP_DEST_PORT 0
 #define DEFAULT_DURATION ULONG_MAX
 #define DEFAULT_TX_IO_SIZE 64
+#define DEFAULT_TX_FRAGS 1
 #define DEFAULT_LAT_COUNT 10000000
 #define DEFAULT_YIELD_COUNT 0
 #define DEFAULT_PRIORITY THREAD_PRIORITY_NORMAL
@@ -49,6 +50,11 @@ CHAR *HELP =
 "   -q <QUEUE_PARAMS> [-q QUEUE_PARAMS...] \n"
 "   -w                 Wait for IO completion\n"
 "                      Default: off (busy loop IO mode)\n"
+"   -wait_set          Wait for IO completion on all of the thread's queues\n"
+"                      at once using an AF_XDP notification set. Reports\n"
+"                      wakeups and notify syscalls per packet, for comparison\n"
+"                      with one -w thread per queue\n"
+"                      Default: off\n"
 "   -na <nodenumber>   The NUMA node affinity. -1 is any node\n"
 "                      Default: " STR_OF(DEFAULT_NODE_AFFINITY) "\n"
 "   -group <groupid>   The processor group. -1 is any group\n"
@@ -78,6 +84,16 @@ CHAR *HELP =
 "                      Default: " STR_OF(DEFAULT_UMEM_HEADROOM) "\n"
 "   -txio <txiosize>   The size (in bytes) of each IO in tx mode\n"
 "                      Default: " STR_OF(DEFAULT_TX_IO_SIZE) "\n"
+"   -frags <count>     The number of UMEM chunks each IO spans in tx mode.\n"
+"                      Each IO is split evenly across a chain of TX\n"
+"                      descriptors. Requires multi-buffer TX support\n"
+"                      Default: " STR_OF(DEFAULT_TX_FRAGS) "\n"
+"   -tx_gso <mss>      Request segmentation offload of each IO into segments\n"
+"                      of at most <mss> payload bytes in tx mode. The\n"
+"                      -tx_pattern must begin with Ethernet, IPv4 or IPv6,\n"
+"                      and TCP or UDP headers. Compare throughput with and\n"
+"                      without this option at a large -txio\n"
+"                      Default: 0 (off)\n"
 "   -b <iobatchsize>   The number of buffers to submit for IO at once\n"
 "                      Default: " STR_OF(DEFAULT_IO_BATCH) "\n"
 "   -ignore_needpoke   Ignore the NEED_POKE optimization mechanism\n"
@@ -86,7 +102,12 @@ CHAR *HELP =
 "                      - system:  The system default polling mode\n"
 "                      - busy:    The system aggressively polls\n"
 "                      - socket:  The socket polls\n"
+"                      - adaptive: The system polls aggressively while IO\n"
+"                                  is flowing and stops when idle\n"
 "                      Default: system\n"
+"   -poll_idle_ms <ms> The idle timeout of adaptive polling mode, or zero\n"
+"                      for the system default\n"
+"                      Default: 0\n"
 "   -xdp_mode <mode>   The XDP interface provider:\n"
 "                      - system:  The system determines the ideal XDP provider\n"
 "                      - generic: A generic XDP interface provider\n"
@@ -96,6 +117,17 @@ CHAR *HELP =
 "                      Default: off\n"
 "   -rx_inject         Inject TX and FWD frames onto the local RX path\n"
 "                      Default: off\n"
+"   -rx_zerocopy       Receive directly into UMEM buffers posted to the\n"
+"                      interface. Requires native XDP support\n"
+"                      Default: off\n"
+"   -rx_multibuffer    Receive frames larger than a UMEM chunk as chains of\n"
+"                      RX descriptors, validating each chain. Only valid in\n"
+"                      rx mode\n"
+"                      Default: off\n"
+"   -rx_gro            Coalesce consecutive UDP datagrams of a flow into a\n"
+"                      single RX frame, and report the average number of\n"
+"                      datagrams per frame. Only valid in rx mode\n"
+"                      Default: off\n"
 "   -tx_inspect        Inspect RX and FWD frames from the local TX path\n"
 "                      Default: off\n"
 "   -tx_pattern        Pattern for the leading bytes of TX, in hexadecimal.\n"
@@ -104,6 +136,12 @@ CHAR *HELP =
 "                      Default: \"\"\n"
 "   -lat_count         Number of latency samples to collect\n"
 "                      Default: " STR_OF(DEFAULT_LAT_COUNT) "\n"
+"   -lat_rate <pps>    The offered load in lat mode, in packets per second,\n"
+"                      or zero to send as fast as completions allow. Lat\n"
+"                      mode reports system CPU utilization alongside RTT\n"
+"                      percentiles, so runs at several rates compare the\n"
+"                      cost and latency of each polling mode\n"
+"                      Default: 0\n"
 "   -watchdog_usec     The datapath watchdog timeout in microseconds, or zero.\n"
 "                      Default: " STR_OF(DEFAULT_WATCHDOG_USEC) "\n"
 
@@ -124,9 +162,14 @@ CHAR *HELP =
 "Examples\n"
 "   xskbench.exe rx -i 6 -t -q -id 0\n"
 "   xskbench.exe rx -i 6 -t -ca 0x2 -q -id 0 -t -ca 0x4 -q -id 1\n"
+"   xskbench.exe rx -i 6 -t -q -id 0 -c 2048 -rx_multibuffer\n"
 "   xskbench.exe tx -i 6 -t -q -id 0 -q -id 1\n"
+"   xskbench.exe lat -i 6 -t -wait_set -q -id 0 -q -id 1 -q -id 2 -q -id 3\n"
+"   xskbench.exe tx -i 6 -t -q -id 0 -txio 9000 -frags 3\n"
 "   xskbench.exe fwd -i 6 -t -q -id 0 -y\n"
 "   xskbench.exe lat -i 6 -t -q -id 0 -ring_size 8\n"
+"   xskbench.exe lat -i 6 -t -q -id 0 -poll adaptive -lat_rate 1000\n"
+"   xskbench.exe lat -i 6 -t -q -id 0 -poll busy -lat_rate 100000\n"
 ;
 
 #define printf_error(...) \
@@ -174,6 +217,11 @@ typedef struct {
     ULONG umemchunksize;
     ULONG umemheadroom;
     ULONG txiosize;
+    ULONG txfrags;
+    UINT32 txGsoMss;
+    XDP_FRAME_LAYOUT txLayout;
+    UINT16 txLayoutExtension;
+    UINT16 txGsoExtension;
     ULONG iobatchsize;
     UINT32 ringsize;
     UCHAR *txPattern;
@@ -181,9 +229,12 @@ typedef struct {
     INT64 *latSamples;
     UINT32 latSamplesCount;
     UINT32 latIndex;
+    INT64 latIntervalQpc;
+    INT64 latNextTxQpc;
     INT64 watchdogIntervalQpc;
     LARGE_INTEGER watchdogLastQpc;
     XSK_POLL_MODE pollMode;
+    UINT32 pollIdleMs;
 
     struct {
         BOOLEAN periodicStats : 1;
@@ -192,6 +243,9 @@ typedef struct {
         BOOLEAN optimizePoking: 1;
         BOOLEAN rxInject : 1;
         BOOLEAN txInspect : 1;
+        BOOLEAN rxZeroCopy : 1;
+        BOOLEAN rxMultiBuffer : 1;
+        BOOLEAN rxGro : 1;
     } flags;
 
     double statsArray[STATS_ARRAY_SIZE];
@@ -200,6 +254,10 @@ typedef struct {
     ULONGLONG lastTick;
     ULONGLONG packetCount;
     ULONGLONG lastPacketCount;
+    ULONGLONG rxBufferCount;
+    ULONGLONG rxDatagramCount;
+    UINT16 rxGroExtension;
+    UINT32 rxChainLength;
     ULONGLONG lastRxDropCount;
     ULONGLONG pokesRequestedCount;
     ULONGLONG lastPokesRequestedCount;
@@ -223,8 +281,14 @@ typedef struct {
     UINT32 yieldCount;
     DWORD_PTR cpuAffinity;
     BOOLEAN wait;
+    BOOLEAN waitSet;
     INT priority;
 
+    HANDLE notifySet;
+    XSK_NOTIFY_SET_RESULT *notifyResults;
+    ULONGLONG notifySetWaitCount;
+    ULONGLONG notifySetReadyCount;
+
     UINT32 queueCount;
     MY_QUEUE *queues;
 } MY_THREAD;
@@ -238,6 +302,8 @@ BOOLEAN largePages = FALSE;
 MODE mode;
 CHAR *modestr;
 HANDLE periodicStatsEvent;
+ULONGLONG cpuIdleTime;
+ULONGLONG cpuTotalTime;
 
 UINT32
 RingPairReserve(
@@ -398,6 +464,62 @@ GetDescriptorPattern(
     }
 }
 
+_Success_(return)
+BOOLEAN
+GetPatternLayout(
+    _In_reads_bytes_(PatternLength) const UCHAR *Pattern,
+    _In_ UINT32 PatternLength,
+    _Out_ XDP_FRAME_LAYOUT *Layout
+    )
+{
+    UINT32 offset = 14;
+    UINT8 protocol;
+
+    ZeroMemory(Layout, sizeof(*Layout));
+
+    if (PatternLength < offset) {
+        return FALSE;
+    }
+
+    Layout->Layer2Type = XdpFrameLayer2TypeEthernet;
+    Layout->Layer2HeaderLength = (UINT8)offset;
+
+    if (Pattern[12] == 0x08 && Pattern[13] == 0x00) {
+        if (PatternLength < offset + 20 || (Pattern[offset] >> 4) != 4) {
+            return FALSE;
+        }
+        Layout->Layer3Type = XdpFrameLayer3TypeIPv4UnspecifiedOptions;
+        Layout->Layer3HeaderLength = (Pattern[offset] & 0xF) * 4;
+        protocol = Pattern[offset + 9];
+    } else if (Pattern[12] == 0x86 && Pattern[13] == 0xDD) {
+        if (PatternLength < offset + 40 || (Pattern[offset] >> 4) != 6) {
+            return FALSE;
+        }
+        Layout->Layer3Type = XdpFrameLayer3TypeIPv6NoExtensions;
+        Layout->Layer3HeaderLength = 40;
+        protocol = Pattern[offset + 6];
+    } else {
+        return FALSE;
+    }
+
+    offset += Layout->Layer3HeaderLength;
+
+    if (protocol == 6) { // TCP
+        if (PatternLength < offset + 20) {
+            return FALSE;
+        }
+        Layout->Layer4Type = XdpFrameLayer4TypeTcp;
+        Layout->Layer4HeaderLength = (Pattern[offset + 12] >> 4) * 4;
+    } else if (protocol == 17) { // UDP
+        Layout->Layer4Type = XdpFrameLayer4TypeUdp;
+        Layout->Layer4HeaderLength = 8;
+    } else {
+        return FALSE;
+    }
+
+    return PatternLength >= offset + Layout->Layer4HeaderLength;
+}
+
 _Success_(return)
 BOOLEAN
 ParseUInt64A(
@@ -480,36 +602,10 @@ SetupSock(
             sizeof(Queue->umemReg));
     ASSERT_FRE(res == S_OK);
 
-    printf_verbose("configuring fill ring with size %d\n", Queue->ringsize);
-    res =
-        XskSetSockopt(
-            Queue->sock, XSK_SOCKOPT_RX_FILL_RING_SIZE, &Queue->ringsize,
-            sizeof(Queue->ringsize));
-    ASSERT_FRE(res == S_OK);
-
-    printf_verbose("configuring completion ring with size %d\n", Queue->ringsize);
-    res =
-        XskSetSockopt(
-            Queue->sock, XSK_SOCKOPT_TX_COMPLETION_RING_SIZE, &Queue->ringsize,
-            sizeof(Queue->ringsize));
-    ASSERT_FRE(res == S_OK);
-
     if (Queue->flags.rx) {
-        printf_verbose("configuring rx ring with size %d\n", Queue->ringsize);
-        res =
-            XskSetSockopt(
-                Queue->sock, XSK_SOCKOPT_RX_RING_SIZE, &Queue->ringsize,
-                sizeof(Queue->ringsize));
-        ASSERT_FRE(res == S_OK);
         bindFlags |= XSK_BIND_FLAG_RX;
     }
     if (Queue->flags.tx) {
-        printf_verbose("configuring tx ring with size %d\n", Queue->ringsize);
-        res =
-            XskSetSockopt(
-                Queue->sock, XSK_SOCKOPT_TX_RING_SIZE, &Queue->ringsize,
-                sizeof(Queue->ringsize));
-        ASSERT_FRE(res == S_OK);
         bindFlags |= XSK_BIND_FLAG_TX;
     }
 
@@ -546,6 +642,81 @@ SetupSock(
     res = XskBind(Queue->sock, IfIndex, Queue->queueId, bindFlags);
     ASSERT_FRE(res == S_OK);
 
+    if (Queue->flags.rxZeroCopy) {
+        UINT32 enabled = TRUE;
+
+        //
+        // Zero-copy RX must be enabled after binding and before any RX rings
+        // are configured.
+        //
+        printf_verbose("configuring zero-copy rx\n");
+        res = XskSetSockopt(Queue->sock, XSK_SOCKOPT_RX_ZERO_COPY, &enabled, sizeof(enabled));
+        if (FAILED(res)) {
+            ABORT("err: XSK_SOCKOPT_RX_ZERO_COPY returned 0x%x\n", res);
+        }
+    }
+
+    if (Queue->flags.rxMultiBuffer) {
+        UINT32 enabled = TRUE;
+
+        printf_verbose("configuring multi-buffer rx\n");
+        res = XskSetSockopt(Queue->sock, XSK_SOCKOPT_RX_MULTI_BUFFER, &enabled, sizeof(enabled));
+        if (FAILED(res)) {
+            ABORT("err: XSK_SOCKOPT_RX_MULTI_BUFFER returned 0x%x\n", res);
+        }
+    }
+
+    if (Queue->flags.rxGro) {
+        UINT32 enabled = TRUE;
+
+        printf_verbose("configuring rx coalescing\n");
+        res = XskSetSockopt(Queue->sock, XSK_SOCKOPT_RX_OFFLOAD_GRO, &enabled, sizeof(enabled));
+        if (FAILED(res)) {
+            ABORT("err: XSK_SOCKOPT_RX_OFFLOAD_GRO returned 0x%x\n", res);
+        }
+    }
+
+    if (Queue->txGsoMss > 0) {
+        UINT32 enabled = TRUE;
+
+        printf_verbose("configuring tx segmentation offload\n");
+        res = XskSetSockopt(Queue->sock, XSK_SOCKOPT_TX_OFFLOAD_GSO, &enabled, sizeof(enabled));
+        if (FAILED(res)) {
+            ABORT("err: XSK_SOCKOPT_TX_OFFLOAD_GSO returned 0x%x\n", res);
+        }
+    }
+
+    printf_verbose("configuring fill ring with size %d\n", Queue->ringsize);
+    res =
+        XskSetSockopt(
+            Queue->sock, XSK_SOCKOPT_RX_FILL_RING_SIZE, &Queue->ringsize,
+            sizeof(Queue->ringsize));
+    ASSERT_FRE(res == S_OK);
+
+    printf_verbose("configuring completion ring with size %d\n", Queue->ringsize);
+    res =
+        XskSetSockopt(
+            Queue->sock, XSK_SOCKOPT_TX_COMPLETION_RING_SIZE, &Queue->ringsize,
+            sizeof(Queue->ringsize));
+    ASSERT_FRE(res == S_OK);
+
+    if (Queue->flags.rx) {
+        printf_verbose("configuring rx ring with size %d\n", Queue->ringsize);
+        res =
+            XskSetSockopt(
+                Queue->sock, XSK_SOCKOPT_RX_RING_SIZE, &Queue->ringsize,
+                sizeof(Queue->ringsize));
+        ASSERT_FRE(res == S_OK);
+    }
+    if (Queue->flags.tx) {
+        printf_verbose("configuring tx ring with size %d\n", Queue->ringsize);
+        res =
+            XskSetSockopt(
+                Queue->sock, XSK_SOCKOPT_TX_RING_SIZE, &Queue->ringsize,
+                sizeof(Queue->ringsize));
+        ASSERT_FRE(res == S_OK);
+    }
+
     printf_verbose("activating sock\n");
     res = XskActivate(Queue->sock, 0);
     ASSERT_FRE(res == S_OK);
@@ -568,11 +739,44 @@ SetupSock(
         XskRingInitialize(&Queue->txRing, &infoSet.Tx);
     }
 
+    if (Queue->txGsoMss > 0) {
+        UINT32 optionLength = sizeof(Queue->txLayoutExtension);
+        res =
+            XskGetSockopt(
+                Queue->sock, XSK_SOCKOPT_TX_FRAME_LAYOUT_EXTENSION, &Queue->txLayoutExtension,
+                &optionLength);
+        ASSERT_FRE(res == S_OK);
+
+        optionLength = sizeof(Queue->txGsoExtension);
+        res =
+            XskGetSockopt(
+                Queue->sock, XSK_SOCKOPT_TX_FRAME_GSO_EXTENSION, &Queue->txGsoExtension,
+                &optionLength);
+        ASSERT_FRE(res == S_OK);
+    }
+
+    if (Queue->flags.rxGro) {
+        UINT32 optionLength = sizeof(Queue->rxGroExtension);
+        res =
+            XskGetSockopt(
+                Queue->sock, XSK_SOCKOPT_RX_FRAME_GRO_EXTENSION, &Queue->rxGroExtension,
+                &optionLength);
+        ASSERT_FRE(res == S_OK);
+    }
+
     res =
         XskSetSockopt(
             Queue->sock, XSK_SOCKOPT_POLL_MODE, &Queue->pollMode, sizeof(Queue->pollMode));
     ASSERT_FRE(res == S_OK);
 
+    if (Queue->pollIdleMs != 0) {
+        res =
+            XskSetSockopt(
+                Queue->sock, XSK_SOCKOPT_POLL_ADAPTIVE_IDLE_TIMEOUT, &Queue->pollIdleMs,
+                sizeof(Queue->pollIdleMs));
+        ASSERT_FRE(res == S_OK);
+    }
+
     //
     // Free ring starts off with all UMEM descriptors.
     //
@@ -753,6 +957,53 @@ PrintFinalLatStats(
         Queue->latSamples[(UINT32)(Queue->latIndex * 0.999999)]);
 }
 
+VOID
+GetSystemCpuTimes(
+    ULONGLONG *IdleTime,
+    ULONGLONG *TotalTime
+    )
+{
+    FILETIME idle, kernel, user;
+    ULARGE_INTEGER idleTime, kernelTime, userTime;
+
+    ASSERT_FRE(GetSystemTimes(&idle, &kernel, &user));
+
+    idleTime.LowPart = idle.dwLowDateTime;
+    idleTime.HighPart = idle.dwHighDateTime;
+    kernelTime.LowPart = kernel.dwLowDateTime;
+    kernelTime.HighPart = kernel.dwHighDateTime;
+    userTime.LowPart = user.dwLowDateTime;
+    userTime.HighPart = user.dwHighDateTime;
+
+    //
+    // Kernel time includes idle time.
+    //
+    *IdleTime = idleTime.QuadPart;
+    *TotalTime = kernelTime.QuadPart + userTime.QuadPart;
+}
+
+VOID
+PrintFinalCpuStats(
+    ULONGLONG IdleTime,
+    ULONGLONG TotalTime
+    )
+{
+    ULONGLONG idleTime = IdleTime - cpuIdleTime;
+    ULONGLONG totalTime = TotalTime - cpuTotalTime;
+
+    if (totalTime == 0) {
+        return;
+    }
+
+    //
+    // System-wide utilization includes kernel busy polling, which does not run
+    // on the benchmark threads.
+    //
+    printf(
+        "cpu: %.1f%% of %lu processors\n",
+        100.0 * (totalTime - idleTime) / totalTime, GetActiveProcessorCount(ALL_PROCESSOR_GROUPS));
+}
+
 VOID
 PrintFinalStats(
     MY_QUEUE *Queue
@@ -816,8 +1067,19 @@ PrintFinalStats(
 
     stdDev = sqrt(stdDev / (numEntries - 1));
 
-    printf("%-3s[%d]: avg=%08.3f stddev=%08.3f min=%08.3f max=%08.3f Kpps\n",
-        modestr, Queue->queueId, avg, stdDev, min, max);
+    printf("%-3s[%d]: avg=%08.3f stddev=%08.3f min=%08.3f max=%08.3f Kpps%s\n",
+        modestr, Queue->queueId, avg, stdDev, min, max,
+        Queue->flags.rxZeroCopy ? " (zero-copy rx)" : "");
+
+    if (Queue->flags.rxMultiBuffer && Queue->packetCount > 0) {
+        printf("%-3s[%d]: avg=%.3f buffers per frame\n",
+            modestr, Queue->queueId, (double)Queue->rxBufferCount / Queue->packetCount);
+    }
+
+    if (Queue->flags.rxGro && Queue->packetCount > 0) {
+        printf("%-3s[%d]: avg=%.3f datagrams per frame\n",
+            modestr, Queue->queueId, (double)Queue->rxDatagramCount / Queue->packetCount);
+    }
 
     if (mode == ModeLat) {
         PrintFinalLatStats(Queue);
@@ -864,6 +1126,102 @@ NotifyDriver(
     }
 }
 
+VOID
+SetupNotifySet(
+    MY_THREAD *Thread,
+    XSK_NOTIFY_FLAGS WaitFlags
+    )
+{
+    HRESULT res;
+
+    if (!Thread->waitSet) {
+        return;
+    }
+
+    res = XskNotifySetCreate(&Thread->notifySet);
+    ASSERT_FRE(res == S_OK);
+
+    Thread->notifyResults = calloc(Thread->queueCount, sizeof(*Thread->notifyResults));
+    ASSERT_FRE(Thread->notifyResults != NULL);
+
+    for (UINT32 qIndex = 0; qIndex < Thread->queueCount; qIndex++) {
+        MY_QUEUE *queue = &Thread->queues[qIndex];
+
+        res = XskNotifySetAdd(Thread->notifySet, queue->sock, WaitFlags, queue);
+        ASSERT_FRE(res == S_OK);
+    }
+}
+
+VOID
+IdleThread(
+    MY_THREAD *Thread
+    )
+{
+    HRESULT res;
+    UINT32 readyCount;
+
+    if (!Thread->waitSet) {
+        for (UINT32 i = 0; i < Thread->yieldCount; i++) {
+            YieldProcessor();
+        }
+        return;
+    }
+
+    //
+    // None of the thread's queues made progress, so block until any of them
+    // has IO available. The next pass over the queues consumes it.
+    //
+    Thread->notifySetWaitCount++;
+    res =
+        XskNotifySetWait(
+            Thread->notifySet, WAIT_DRIVER_TIMEOUT_MS, Thread->notifyResults,
+            Thread->queueCount, &readyCount);
+    ASSERT_FRE(res == S_OK || res == HRESULT_FROM_WIN32(ERROR_TIMEOUT));
+
+    if (res == S_OK) {
+        Thread->notifySetReadyCount += readyCount;
+
+        for (UINT32 i = 0; i < readyCount; i++) {
+            MY_QUEUE *queue = Thread->notifyResults[i].Context;
+            printf_verbose(
+                "Notify set ready {queue:%d, flags:0x%x}\n",
+                queue->queueId, Thread->notifyResults[i].Flags);
+        }
+    }
+}
+
+VOID
+PrintFinalWaitStats(
+    MY_THREAD *Thread,
+    UINT32 ThreadIndex
+    )
+{
+    ULONGLONG packetCount = 0;
+    ULONGLONG syscallCount = Thread->notifySetWaitCount;
+
+    if (!Thread->wait && !Thread->waitSet) {
+        return;
+    }
+
+    for (UINT32 qIndex = 0; qIndex < Thread->queueCount; qIndex++) {
+        packetCount += Thread->queues[qIndex].packetCount;
+        syscallCount += Thread->queues[qIndex].pokesPerformedCount;
+    }
+
+    printf("%-3s thread[%u]: queues=%u %s notifySyscalls=%llu (%.3f per packet)",
+        modestr, ThreadIndex, Thread->queueCount, Thread->waitSet ? "wait_set" : "wait",
+        syscallCount, packetCount > 0 ? (double)syscallCount / packetCount : 0);
+
+    if (Thread->waitSet) {
+        printf(" setWaits=%llu readySocketsPerWait=%.3f",
+            Thread->notifySetWaitCount,
+            Thread->notifySetWaitCount > 0 ?
+                (double)Thread->notifySetReadyCount / Thread->notifySetWaitCount : 0);
+    }
+
+    printf("\n");
+}
+
 VOID
 UpdateWatchdog(
     MY_QUEUE *Queue
@@ -911,7 +1269,37 @@ WriteFillPackets(
     }
 }
 
-VOID
+UINT32
+GetRxDatagramCount(
+    MY_QUEUE *Queue,
+    const XSK_BUFFER_DESCRIPTOR *RxDesc
+    )
+{
+    const XDP_FRAME_GRO *gro = (const XDP_FRAME_GRO *)((UCHAR *)RxDesc + Queue->rxGroExtension);
+    const UCHAR *frame =
+        (UCHAR *)Queue->umemReg.Address + RxDesc->Address.BaseAddress + RxDesc->Address.Offset;
+    UINT32 headerLength;
+
+    if (gro->UDP.MessageSize == 0 || RxDesc->Length < 14) {
+        return 1;
+    }
+
+    //
+    // Coalesced frames carry the Ethernet, IP, and UDP headers of the first
+    // datagram, without IP options or extension headers.
+    //
+    if (frame[12] == 0x08 && frame[13] == 0x00) {
+        headerLength = 14 + 20 + 8;
+    } else {
+        headerLength = 14 + 40 + 8;
+    }
+
+    ASSERT_FRE(RxDesc->Length > headerLength);
+
+    return (RxDesc->Length - headerLength + gro->UDP.MessageSize - 1) / gro->UDP.MessageSize;
+}
+
+UINT32
 ReadRxPackets(
     MY_QUEUE *Queue,
     UINT32 RxConsumerIndex,
@@ -919,14 +1307,48 @@ ReadRxPackets(
     UINT32 Count
     )
 {
+    UINT32 frameCount = 0;
+
     for (UINT32 i = 0; i < Count; i++) {
         XSK_BUFFER_DESCRIPTOR *rxDesc = XskRingGetElement(&Queue->rxRing, RxConsumerIndex++);
         UINT64 *freeDesc = XskRingGetElement(&Queue->freeRing, FreeProducerIndex++);
 
         *freeDesc = rxDesc->Address.BaseAddress;
-        printf_verbose("Consuming RX entry   {address:%llu, offset:%llu, length:%d}\n",
-            rxDesc->Address.BaseAddress, rxDesc->Address.Offset, rxDesc->Length);
+        printf_verbose(
+            "Consuming RX entry   {address:%llu, offset:%llu, length:%d, flags:0x%x}\n",
+            rxDesc->Address.BaseAddress, rxDesc->Address.Offset, rxDesc->Length, rxDesc->Flags);
+
+        if (!Queue->flags.rxMultiBuffer) {
+            if (Queue->flags.rxGro) {
+                Queue->rxDatagramCount += GetRxDatagramCount(Queue, rxDesc);
+            }
+            frameCount++;
+            continue;
+        }
+
+        //
+        // Validate the chain: every buffer lies within its UMEM chunk, and every
+        // buffer except the last of a frame is completely filled. Chains may
+        // span batches, so the chain length is tracked across calls.
+        //
+        ASSERT_FRE(rxDesc->Address.Offset >= Queue->umemheadroom);
+        ASSERT_FRE(rxDesc->Address.Offset + rxDesc->Length <= Queue->umemchunksize);
+
+        Queue->rxBufferCount++;
+        Queue->rxChainLength++;
+
+        if (rxDesc->Flags & XSK_BUFFER_DESCRIPTOR_FLAG_CONTINUED) {
+            ASSERT_FRE(rxDesc->Address.Offset == Queue->umemheadroom);
+            ASSERT_FRE(rxDesc->Length == Queue->umemchunksize - Queue->umemheadroom);
+        } else {
+            ASSERT_FRE(rxDesc->Flags == XSK_BUFFER_DESCRIPTOR_FLAG_NONE);
+            printf_verbose("Consumed RX frame    {buffers:%u}\n", Queue->rxChainLength);
+            Queue->rxChainLength = 0;
+            frameCount++;
+        }
     }
+
+    return frameCount;
 }
 
 UINT32
@@ -945,12 +1367,11 @@ ProcessRx(
         RingPairReserve(
             &Queue->rxRing, &consumerIndex, &Queue->freeRing, &producerIndex, Queue->iobatchsize);
     if (available > 0) {
-        ReadRxPackets(Queue, consumerIndex, producerIndex, available);
+        Queue->packetCount += ReadRxPackets(Queue, consumerIndex, producerIndex, available);
         XskRingConsumerRelease(&Queue->rxRing, available);
         XskRingProducerSubmit(&Queue->freeRing, available);
 
         processed += available;
-        Queue->packetCount += available;
 
         UpdateWatchdog(Queue);
     } else {
@@ -1002,6 +1423,8 @@ DoRxMode(
         queue->lastTick = GetTickCount64();
     }
 
+    SetupNotifySet(Thread, XSK_NOTIFY_FLAG_WAIT_RX);
+
     printf("Receiving...\n");
     SetEvent(Thread->readyEvent);
 
@@ -1013,9 +1436,7 @@ DoRxMode(
         }
 
         if (!Processed) {
-            for (UINT32 i = 0; i < Thread->yieldCount; i++) {
-                YieldProcessor();
-            }
+            IdleThread(Thread);
         }
     }
 }
@@ -1028,6 +1449,10 @@ WriteTxPackets(
     UINT32 Count
     )
 {
+    UINT32 fragLength = Queue->txiosize / Queue->txfrags;
+
+    ASSERT_FRE(Count % Queue->txfrags == 0);
+
     for (UINT32 i = 0; i < Count; i++) {
         UINT64 *freeDesc = XskRingGetElement(&Queue->freeRing, FreeConsumerIndex++);
         XSK_BUFFER_DESCRIPTOR *txDesc = XskRingGetElement(&Queue->txRing, TxProducerIndex++);
@@ -1035,12 +1460,34 @@ WriteTxPackets(
         txDesc->Address.BaseAddress = *freeDesc;
         assert(Queue->umemReg.Headroom <= MAXUINT16);
         txDesc->Address.Offset = (UINT16)Queue->umemReg.Headroom;
-        txDesc->Length = Queue->txiosize;
+
+        //
+        // Each IO is a chain of txfrags descriptors; the last descriptor in
+        // the chain carries the remainder of the IO size.
+        //
+        if ((i + 1) % Queue->txfrags != 0) {
+            txDesc->Length = fragLength;
+            txDesc->Flags = XSK_BUFFER_DESCRIPTOR_FLAG_CONTINUED;
+        } else {
+            txDesc->Length = Queue->txiosize - fragLength * (Queue->txfrags - 1);
+            txDesc->Flags = XSK_BUFFER_DESCRIPTOR_FLAG_NONE;
+        }
+
+        if (Queue->txGsoMss > 0) {
+            XDP_FRAME_LAYOUT *layout =
+                (XDP_FRAME_LAYOUT *)((UCHAR *)txDesc + Queue->txLayoutExtension);
+            XDP_FRAME_GSO *gso =
+                (XDP_FRAME_GSO *)((UCHAR *)txDesc + Queue->txGsoExtension);
+
+            *layout = Queue->txLayout;
+            gso->TCP.Mss = Queue->txGsoMss;
+        }
         //
         // This benchmark does not write data into the TX packet.
         //
-        printf_verbose("Producing TX entry {address:%llu, offset:%llu, length:%d}\n",
-            txDesc->Address.BaseAddress, txDesc->Address.Offset, txDesc->Length);
+        printf_verbose("Producing TX entry {address:%llu, offset:%llu, length:%d, flags:%x}\n",
+            txDesc->Address.BaseAddress, txDesc->Address.Offset, txDesc->Length,
+            txDesc->Flags);
     }
 }
 
@@ -1073,16 +1520,22 @@ ProcessTx(
     UINT32 producerIndex;
     UINT32 processed = 0;
 
+    //
+    // Each IO consumes txfrags descriptors and completions, so always process
+    // whole IOs.
+    //
     available =
         RingPairReserve(
-            &Queue->compRing, &consumerIndex, &Queue->freeRing, &producerIndex, Queue->iobatchsize);
+            &Queue->compRing, &consumerIndex, &Queue->freeRing, &producerIndex,
+            Queue->iobatchsize * Queue->txfrags);
+    available -= available % Queue->txfrags;
     if (available > 0) {
         ReadCompletionPackets(Queue, consumerIndex, producerIndex, available);
         XskRingConsumerRelease(&Queue->compRing, available);
         XskRingProducerSubmit(&Queue->freeRing, available);
 
         processed += available;
-        Queue->packetCount += available;
+        Queue->packetCount += available / Queue->txfrags;
 
         if (XskRingProducerReserve(&Queue->txRing, MAXUINT32, &producerIndex) !=
                 Queue->txRing.Size) {
@@ -1096,7 +1549,9 @@ ProcessTx(
 
     available =
         RingPairReserve(
-            &Queue->freeRing, &consumerIndex, &Queue->txRing, &producerIndex, Queue->iobatchsize);
+            &Queue->freeRing, &consumerIndex, &Queue->txRing, &producerIndex,
+            Queue->iobatchsize * Queue->txfrags);
+    available -= available % Queue->txfrags;
     if (available > 0) {
         WriteTxPackets(Queue, consumerIndex, producerIndex, available);
         XskRingConsumerRelease(&Queue->freeRing, available);
@@ -1139,6 +1594,8 @@ DoTxMode(
         queue->lastTick = GetTickCount64();
     }
 
+    SetupNotifySet(Thread, XSK_NOTIFY_FLAG_WAIT_TX);
+
     printf("Sending...\n");
     SetEvent(Thread->readyEvent);
 
@@ -1150,9 +1607,7 @@ DoTxMode(
         }
 
         if (!Processed) {
-            for (UINT32 i = 0; i < Thread->yieldCount; i++) {
-                YieldProcessor();
-            }
+            IdleThread(Thread);
         }
 
     }
@@ -1297,6 +1752,8 @@ DoFwdMode(
         queue->lastTick = GetTickCount64();
     }
 
+    SetupNotifySet(Thread, XSK_NOTIFY_FLAG_WAIT_RX | XSK_NOTIFY_FLAG_WAIT_TX);
+
     printf("Forwarding...\n");
     SetEvent(Thread->readyEvent);
 
@@ -1308,9 +1765,7 @@ DoFwdMode(
         }
 
         if (!Processed) {
-            for (UINT32 i = 0; i < Thread->yieldCount; i++) {
-                YieldProcessor();
-            }
+            IdleThread(Thread);
         }
 
     }
@@ -1327,6 +1782,7 @@ ProcessLat(
     UINT32 consumerIndex;
     UINT32 producerIndex;
     UINT32 processed = 0;
+    UINT32 txBudget;
 
     //
     // Move frames from the RX ring to the RX fill ring, recording the timestamp
@@ -1390,13 +1846,28 @@ ProcessLat(
         }
     }
 
+    //
+    // If an offered load is specified, send a single frame per interval.
+    //
+    txBudget = Queue->iobatchsize;
+    if (Queue->latIntervalQpc > 0) {
+        LARGE_INTEGER NowQpc;
+        VERIFY(QueryPerformanceCounter(&NowQpc));
+
+        if (NowQpc.QuadPart < Queue->latNextTxQpc) {
+            txBudget = 0;
+        } else {
+            txBudget = 1;
+        }
+    }
+
     //
     // Move frames from the free ring to the TX ring, stamping the current time
     // onto each frame.
     //
     available =
         RingPairReserve(
-            &Queue->freeRing, &consumerIndex, &Queue->txRing, &producerIndex, Queue->iobatchsize);
+            &Queue->freeRing, &consumerIndex, &Queue->txRing, &producerIndex, txBudget);
     if (available > 0) {
         LARGE_INTEGER NowQpc;
         VERIFY(QueryPerformanceCounter(&NowQpc));
@@ -1425,6 +1896,7 @@ ProcessLat(
 
         processed += available;
         notifyFlags |= XSK_NOTIFY_FLAG_POKE_TX;
+        Queue->latNextTxQpc = NowQpc.QuadPart + Queue->latIntervalQpc;
     }
 
     if (Wait &&
@@ -1477,6 +1949,8 @@ DoLatMode(
         XskRingProducerSubmit(&queue->fillRing, available);
     }
 
+    SetupNotifySet(Thread, XSK_NOTIFY_FLAG_WAIT_RX | XSK_NOTIFY_FLAG_WAIT_TX);
+
     printf("Probing latency...\n");
     SetEvent(Thread->readyEvent);
 
@@ -1488,9 +1962,7 @@ DoLatMode(
         }
 
         if (!Processed) {
-            for (UINT32 i = 0; i < Thread->yieldCount; i++) {
-                YieldProcessor();
-            }
+            IdleThread(Thread);
         }
     }
 }
@@ -1530,6 +2002,7 @@ ParseQueueArgs(
     Queue->pollMode = XSK_POLL_MODE_DEFAULT;
     Queue->flags.optimizePoking = TRUE;
     Queue->txiosize = DEFAULT_TX_IO_SIZE;
+    Queue->txfrags = DEFAULT_TX_FRAGS;
     Queue->latSamplesCount = DEFAULT_LAT_COUNT;
     Queue->watchdogIntervalQpc = UsToQpc(DEFAULT_WATCHDOG_USEC);
 
@@ -1554,6 +2027,16 @@ ParseQueueArgs(
                 Usage();
             }
             Queue->txiosize = atoi(argv[i]);
+        } else if (!_stricmp(argv[i], "-frags")) {
+            if (++i >= argc) {
+                Usage();
+            }
+            Queue->txfrags = atoi(argv[i]);
+        } else if (!strcmp(argv[i], "-tx_gso")) {
+            if (++i >= argc) {
+                Usage();
+            }
+            Queue->txGsoMss = atoi(argv[i]);
         } else if (!strcmp(argv[i], "-u")) {
             if (++i >= argc) {
                 Usage();
@@ -1585,9 +2068,16 @@ ParseQueueArgs(
                 Queue->pollMode = XSK_POLL_MODE_BUSY;
             } else if (!_stricmp(argv[i], "socket")) {
                 Queue->pollMode = XSK_POLL_MODE_SOCKET;
+            } else if (!_stricmp(argv[i], "adaptive")) {
+                Queue->pollMode = XSK_POLL_MODE_ADAPTIVE;
             } else {
                 Usage();
             }
+        } else if (!_stricmp(argv[i], "-poll_idle_ms")) {
+            if (++i >= argc) {
+                Usage();
+            }
+            Queue->pollIdleMs = atoi(argv[i]);
         } else if (!_stricmp(argv[i], "-xdp_mode")) {
             if (++i >= argc) {
                 Usage();
@@ -1603,6 +2093,12 @@ ParseQueueArgs(
             }
         } else if (!strcmp(argv[i], "-rx_inject")) {
             Queue->flags.rxInject = TRUE;
+        } else if (!strcmp(argv[i], "-rx_zerocopy")) {
+            Queue->flags.rxZeroCopy = TRUE;
+        } else if (!strcmp(argv[i], "-rx_multibuffer")) {
+            Queue->flags.rxMultiBuffer = TRUE;
+        } else if (!strcmp(argv[i], "-rx_gro")) {
+            Queue->flags.rxGro = TRUE;
         } else if (!strcmp(argv[i], "-tx_inspect")) {
             Queue->flags.txInspect = TRUE;
         } else if (!strcmp(argv[i], "-tx_pattern")) {
@@ -1620,6 +2116,18 @@ ParseQueueArgs(
                 Usage();
             }
             Queue->latSamplesCount = atoi(argv[i]);
+        } else if (!strcmp(argv[i], "-lat_rate")) {
+            UINT32 rate;
+            LARGE_INTEGER FreqQpc;
+
+            if (++i >= argc) {
+                Usage();
+            }
+            rate = atoi(argv[i]);
+            if (rate > 0) {
+                VERIFY(QueryPerformanceFrequency(&FreqQpc));
+                Queue->latIntervalQpc = max(FreqQpc.QuadPart / rate, 1);
+            }
         } else if (!strcmp(argv[i], "-watchdog_usec")) {
             if (++i >= argc) {
                 Usage();
@@ -1643,6 +2151,33 @@ ParseQueueArgs(
     ASSERT_FRE(Queue->umemsize >= Queue->umemchunksize);
     ASSERT_FRE(Queue->umemchunksize >= Queue->umemheadroom);
     ASSERT_FRE(Queue->umemchunksize - Queue->umemheadroom >= Queue->txPatternLength);
+    ASSERT_FRE(Queue->txfrags > 0 && Queue->txfrags <= Queue->txiosize);
+
+    if (Queue->flags.rxMultiBuffer) {
+        ASSERT_FRE(mode == ModeRx);
+        ASSERT_FRE(Queue->umemchunksize > Queue->umemheadroom);
+    }
+
+    if (Queue->flags.rxGro) {
+        ASSERT_FRE(mode == ModeRx);
+        ASSERT_FRE(!Queue->flags.rxMultiBuffer);
+    }
+
+    if (Queue->txfrags > 1) {
+        ASSERT_FRE(mode == ModeTx);
+        ASSERT_FRE(
+            Queue->umemchunksize - Queue->umemheadroom >=
+                Queue->txiosize - (Queue->txiosize / Queue->txfrags) * (Queue->txfrags - 1));
+    }
+
+    if (Queue->txGsoMss > 0) {
+        ASSERT_FRE(mode == ModeTx);
+        ASSERT_FRE(Queue->txfrags == 1);
+        ASSERT_FRE(Queue->umemchunksize - Queue->umemheadroom >= Queue->txiosize);
+        if (!GetPatternLayout(Queue->txPattern, Queue->txPatternLength, &Queue->txLayout)) {
+            ABORT("err: -tx_gso requires a -tx_pattern with TCP or UDP headers\n");
+        }
+    }
 
     if (mode == ModeLat) {
         ASSERT_FRE(
@@ -1665,6 +2200,7 @@ ParseThreadArgs(
     BOOLEAN cpuAffinitySet = FALSE;
 
     Thread->wait = FALSE;
+    Thread->waitSet = FALSE;
     Thread->nodeAffinity = DEFAULT_NODE_AFFINITY;
     Thread->idealCpu = DEFAULT_IDEAL_CPU;
     Thread->cpuAffinity = DEFAULT_CPU_AFFINITY;
@@ -1699,6 +2235,8 @@ ParseThreadArgs(
             cpuAffinitySet = TRUE;
         } else if (!strcmp(argv[i], "-w")) {
             Thread->wait = TRUE;
+        } else if (!_stricmp(argv[i], "-wait_set")) {
+            Thread->waitSet = TRUE;
         } else if (!_stricmp(argv[i], "-yield")) {
             if (++i >= argc) {
                 Usage();
@@ -1719,7 +2257,11 @@ ParseThreadArgs(
     }
 
     if (Thread->wait && Thread->queueCount > 1) {
-        printf_error("Waiting with multiple sockets per thread is not supported\n");
+        printf_error("Waiting with multiple sockets per thread requires -wait_set\n");
+        Usage();
+    }
+
+    if (Thread->wait && Thread->waitSet) {
         Usage();
     }
 
@@ -1936,6 +2478,8 @@ main(
 {
     MY_THREAD *threads;
     UINT32 threadCount;
+    ULONGLONG idleTime;
+    ULONGLONG totalTime;
 
     ParseArgs(&threads, &threadCount, argc, argv);
 
@@ -1953,6 +2497,8 @@ main(
         WaitForSingleObject(threads[tIndex].readyEvent, INFINITE);
     }
 
+    GetSystemCpuTimes(&cpuIdleTime, &cpuTotalTime);
+
     while (duration-- > 0) {
         WaitForSingleObject(periodicStatsEvent, 1000);
         for (UINT32 tIndex = 0; tIndex < threadCount; tIndex++) {
@@ -1963,6 +2509,7 @@ main(
         }
     }
 
+    GetSystemCpuTimes(&idleTime, &totalTime);
     WriteBooleanNoFence(&done, TRUE);
 
     for (UINT32 tIndex = 0; tIndex < threadCount; tIndex++) {
@@ -1971,6 +2518,11 @@ main(
         for (UINT32 qIndex = 0; qIndex < Thread->queueCount; qIndex++) {
             PrintFinalStats(&Thread->queues[qIndex]);
         }
+        PrintFinalWaitStats(Thread, tIndex);
+    }
+
+    if (mode == ModeLat) {
+        PrintFinalCpuStats(idleTime, totalTime);
     }
 
     return 0;
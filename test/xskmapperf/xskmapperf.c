@@ -0,0 +1,370 @@
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+
+//
+// This xskmapperf microbenchmark measures XSKMAP lookup throughput under reader
+// contention. Reader threads perform batches of lookups against a shared
+// array of entries while a writer thread periodically replaces entries, and
+// the aggregate reader throughput is compared between two schemes:
+//
+// Lock: each batch holds a shared reader/writer lock, as the data path did
+//       with the global map lock. Writers take the lock exclusively.
+//
+// Rcu:  each batch performs plain acquire loads and then reports a quiescent
+//       state, mirroring a receive batch at DISPATCH_LEVEL. Writers exchange
+//       the entry and wait for every reader to pass a quiescent state before
+//       freeing the old entry, mirroring the lifetime module's processor sweep.
+//
+
+#include <xdp/wincommon.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <xdpassert.h>
+
+CONST CHAR *UsageText =
+"Usage: xskmapperf [-DurationMs <ms>] [-WriteIntervalUs <us>] [-MaxThreads <count>]";
+
+#define REQUIRE(expr) \
+    if (!(expr)) { printf("("#expr") failed line %d\n", __LINE__);  exit(1);}
+
+//
+// Matches XSKMAP_MAX_SIZE in the driver.
+//
+#define MAP_SIZE 128
+
+//
+// Number of lookups performed per read section, approximating one receive
+// batch.
+//
+#define LOOKUPS_PER_BATCH 64
+
+#define ENTRY_MAGIC 0x58534b4d
+
+#define MAX_THREADS 64
+
+static const UINT32 ThreadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+typedef enum _MAP_MODE {
+    MapModeLock,
+    MapModeRcu,
+} MAP_MODE;
+
+static CONST CHAR *ModeNames[] = { "Lock", "Rcu" };
+
+typedef struct _MAP_ENTRY {
+    UINT32 Magic;
+    UINT32 Key;
+} MAP_ENTRY;
+
+typedef struct DECLSPEC_CACHEALIGN _READER {
+    HANDLE Thread;
+    UINT32 Index;
+    UINT64 Lookups;
+
+    //
+    // Incremented by the reader after every batch. The writer observes each
+    // reader's counter to detect a grace period.
+    //
+    DECLSPEC_CACHEALIGN volatile UINT64 QuiescentCount;
+} READER;
+
+typedef struct DECLSPEC_CACHEALIGN _MAP {
+    SRWLOCK Lock;
+    DECLSPEC_CACHEALIGN MAP_ENTRY *Entries[MAP_SIZE];
+} MAP;
+
+static MAP Map;
+static MAP_MODE Mode;
+static READER Readers[MAX_THREADS];
+static UINT32 ReaderCount;
+static volatile BOOLEAN Stop;
+static UINT64 Writes;
+
+static UINT32 DurationMs = 1000;
+static UINT32 WriteIntervalUs = 100;
+static UINT32 MaxThreads = MAX_THREADS;
+
+VOID
+Usage(
+    CHAR *Error
+    )
+{
+    fprintf(stderr, "Error: %s\n%s", Error, UsageText);
+    exit(1);
+}
+
+static
+MAP_ENTRY *
+AllocateEntry(
+    _In_ UINT32 Key
+    )
+{
+    MAP_ENTRY *Entry = malloc(sizeof(*Entry));
+
+    REQUIRE(Entry != NULL);
+    Entry->Magic = ENTRY_MAGIC;
+    Entry->Key = Key;
+
+    return Entry;
+}
+
+static
+VOID
+FreeEntry(
+    _In_ MAP_ENTRY *Entry
+    )
+{
+    //
+    // Poison the entry so a reader that observes it after it is freed fails
+    // the validation below.
+    //
+    Entry->Magic = 0;
+    free(Entry);
+}
+
+static
+FORCEINLINE
+UINT32
+ReadEntry(
+    _In_opt_ CONST MAP_ENTRY *Entry,
+    _In_ UINT32 Key
+    )
+{
+    if (Entry == NULL) {
+        return 0;
+    }
+
+    REQUIRE(Entry->Magic == ENTRY_MAGIC && Entry->Key == Key);
+
+    return 1;
+}
+
+static
+DWORD
+WINAPI
+ReaderThread(
+    _In_ VOID *Context
+    )
+{
+    READER *Reader = Context;
+    UINT32 Key = Reader->Index;
+    UINT64 Lookups = 0;
+    UINT64 Hits = 0;
+
+    while (!ReadBooleanNoFence(&Stop)) {
+        if (Mode == MapModeLock) {
+            AcquireSRWLockShared(&Map.Lock);
+
+            for (UINT32 i = 0; i < LOOKUPS_PER_BATCH; i++) {
+                Key = (Key + 1) % MAP_SIZE;
+                Hits += ReadEntry(Map.Entries[Key], Key);
+            }
+
+            ReleaseSRWLockShared(&Map.Lock);
+        } else {
+            for (UINT32 i = 0; i < LOOKUPS_PER_BATCH; i++) {
+                Key = (Key + 1) % MAP_SIZE;
+                Hits += ReadEntry(ReadPointerAcquire((VOID **)&Map.Entries[Key]), Key);
+            }
+
+            //
+            // End of the read section: the reader no longer holds any entry.
+            //
+            WriteULong64Release(
+                &Reader->QuiescentCount, ReadULong64NoFence(&Reader->QuiescentCount) + 1);
+        }
+
+        Lookups += LOOKUPS_PER_BATCH;
+    }
+
+    //
+    // A reader that has exited holds no entries; report a final quiescent
+    // state so a concurrent writer's grace period can complete.
+    //
+    WriteULong64Release(&Reader->QuiescentCount, ReadULong64NoFence(&Reader->QuiescentCount) + 1);
+
+    REQUIRE(Hits <= Lookups);
+    Reader->Lookups = Lookups;
+
+    return 0;
+}
+
+static
+VOID
+WaitForGracePeriod(
+    VOID
+    )
+{
+    UINT64 Snapshot[MAX_THREADS];
+
+    //
+    // Every reader that might observe the old entry must complete its current
+    // batch.
+    //
+    for (UINT32 i = 0; i < ReaderCount; i++) {
+        Snapshot[i] = ReadULong64Acquire(&Readers[i].QuiescentCount);
+    }
+
+    for (UINT32 i = 0; i < ReaderCount; i++) {
+        while (ReadULong64Acquire(&Readers[i].QuiescentCount) == Snapshot[i]) {
+            YieldProcessor();
+        }
+    }
+}
+
+static
+DWORD
+WINAPI
+WriterThread(
+    _In_ VOID *Context
+    )
+{
+    LARGE_INTEGER Frequency;
+    LARGE_INTEGER Last;
+    LARGE_INTEGER Now;
+    UINT32 Key = 0;
+    UINT64 WriteCount = 0;
+
+    UNREFERENCED_PARAMETER(Context);
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Last);
+
+    while (!ReadBooleanAcquire(&Stop)) {
+        MAP_ENTRY *NewEntry;
+        MAP_ENTRY *OldEntry;
+
+        QueryPerformanceCounter(&Now);
+        if ((UINT64)(Now.QuadPart - Last.QuadPart) * 1000000 <
+                (UINT64)WriteIntervalUs * (UINT64)Frequency.QuadPart) {
+            YieldProcessor();
+            continue;
+        }
+        Last = Now;
+
+        Key = (Key + 7) % MAP_SIZE;
+        NewEntry = AllocateEntry(Key);
+
+        if (Mode == MapModeLock) {
+            AcquireSRWLockExclusive(&Map.Lock);
+            OldEntry = Map.Entries[Key];
+            Map.Entries[Key] = NewEntry;
+            ReleaseSRWLockExclusive(&Map.Lock);
+        } else {
+            OldEntry = InterlockedExchangePointer((VOID **)&Map.Entries[Key], NewEntry);
+            WaitForGracePeriod();
+        }
+
+        FreeEntry(OldEntry);
+        WriteCount++;
+    }
+
+    Writes = WriteCount;
+
+    return 0;
+}
+
+static
+double
+Measure(
+    _In_ MAP_MODE MapMode,
+    _In_ UINT32 ThreadCount
+    )
+{
+    HANDLE Writer;
+    UINT64 Lookups = 0;
+
+    Mode = MapMode;
+    ReaderCount = ThreadCount;
+    WriteBooleanRelease(&Stop, FALSE);
+    Writes = 0;
+
+    for (UINT32 i = 0; i < ThreadCount; i++) {
+        RtlZeroMemory(&Readers[i], sizeof(Readers[i]));
+        Readers[i].Index = i;
+        Readers[i].Thread = CreateThread(NULL, 0, ReaderThread, &Readers[i], 0, NULL);
+        REQUIRE(Readers[i].Thread != NULL);
+    }
+
+    Writer = CreateThread(NULL, 0, WriterThread, NULL, 0, NULL);
+    REQUIRE(Writer != NULL);
+
+    Sleep(DurationMs);
+    WriteBooleanRelease(&Stop, TRUE);
+
+    for (UINT32 i = 0; i < ThreadCount; i++) {
+        REQUIRE(WaitForSingleObject(Readers[i].Thread, INFINITE) == WAIT_OBJECT_0);
+        CloseHandle(Readers[i].Thread);
+        Lookups += Readers[i].Lookups;
+    }
+
+    REQUIRE(WaitForSingleObject(Writer, INFINITE) == WAIT_OBJECT_0);
+    CloseHandle(Writer);
+
+    //
+    // Return the aggregate reader throughput in millions of lookups per second.
+    //
+    return (double)Lookups / (double)DurationMs / 1000.0;
+}
+
+INT
+__cdecl
+main(
+    INT ArgC,
+    CHAR **ArgV
+    )
+{
+    SYSTEM_INFO SystemInfo;
+
+    for (INT i = 1; i < ArgC; i++) {
+        if (!_stricmp(ArgV[i], "-DurationMs") && i + 1 < ArgC) {
+            DurationMs = strtoul(ArgV[++i], NULL, 0);
+            if (DurationMs == 0) {
+                Usage("Invalid -DurationMs");
+            }
+        } else if (!_stricmp(ArgV[i], "-WriteIntervalUs") && i + 1 < ArgC) {
+            WriteIntervalUs = strtoul(ArgV[++i], NULL, 0);
+        } else if (!_stricmp(ArgV[i], "-MaxThreads") && i + 1 < ArgC) {
+            MaxThreads = strtoul(ArgV[++i], NULL, 0);
+            if (MaxThreads == 0 || MaxThreads > MAX_THREADS) {
+                Usage("Invalid -MaxThreads");
+            }
+        } else {
+            Usage("Invalid parameter");
+        }
+    }
+
+    GetSystemInfo(&SystemInfo);
+    printf(
+        "Processors=%u DurationMs=%u WriteIntervalUs=%u\n",
+        SystemInfo.dwNumberOfProcessors, DurationMs, WriteIntervalUs);
+
+    InitializeSRWLock(&Map.Lock);
+
+    for (UINT32 i = 0; i < MAP_SIZE; i++) {
+        Map.Entries[i] = AllocateEntry(i);
+    }
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(ThreadCounts) && ThreadCounts[i] <= MaxThreads; i++) {
+        double Throughput[RTL_NUMBER_OF(ModeNames)];
+
+        for (UINT32 m = 0; m < RTL_NUMBER_OF(ModeNames); m++) {
+            Throughput[m] = Measure((MAP_MODE)m, ThreadCounts[i]);
+            printf(
+                "Threads=%-2u Mode=%-4s Lookups=%.1fM/s Writes=%llu\n",
+                ThreadCounts[i], ModeNames[m], Throughput[m], Writes);
+        }
+
+        printf(
+            "Threads=%-2u Speedup=%.2fx\n",
+            ThreadCounts[i], Throughput[MapModeRcu] / Throughput[MapModeLock]);
+    }
+
+    for (UINT32 i = 0; i < MAP_SIZE; i++) {
+        FreeEntry(Map.Entries[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+param (
+    [Parameter(Mandatory = $false)]
+    [ValidateSet("Debug", "Release")]
+    [string]$Config = "Debug",
+
+    [Parameter(Mandatory = $false)]
+    [ValidateSet("x64", "arm64")]
+    [string]$Platform = "x64",
+
+    [Parameter(Mandatory = $false)]
+    [int]$Minutes = 0,
+
+    [Parameter(Mandatory = $false)]
+    [int]$Workers = 1,
+
+    [Parameter(Mandatory = $false)]
+    [string]$ComputerName = "",
+
+    [Parameter(Mandatory = $false)]
+    [System.Management.Automation.PSCredential]$Credential,
+
+    [Parameter(Mandatory = $false)]
+    [string]$RemoteRoot = "",
+
+    [Parameter(Mandatory = $false)]
+    [switch]$SkipDeploy
+)
+
+Set-StrictMode -Version 'Latest'
+$ErrorActionPreference = 'Stop'
+
+# Important paths.
+$RootDir = Split-Path $PSScriptRoot -Parent
+. $RootDir\tools\common.ps1
+
+$Forwarded = Invoke-XdpRemoteIfRequested -InvocationCommand $MyInvocation.MyCommand `
+    -BoundParameters $PSBoundParameters -Config $Config -Platform $Platform
+if ($Forwarded -is [array]) { $Forwarded = $Forwarded[-1] }
+if ($Forwarded) { return }
+$ArtifactsDir = Get-ArtifactBinPath -Config $Config -Platform $Platform
+$LogsDir = "$RootDir\artifacts\logs"
+
+# Ensure the output path exists.
+New-Item -ItemType Directory -Force -Path $LogsDir | Out-Null
+
+$Options = @()
+
+if ($Minutes -gt 0) {
+    $Options += "-max_total_time=$($Minutes * 60)"
+}
+
+if ($Workers -gt 1) {
+    $Options += "-jobs=$Workers"
+    $Options += "-workers=$Workers"
+}
+
+try {
+    Push-Location $LogsDir
+    $env:ASAN_SAVE_DUMPS="$pwd\asan.dmp"
+
+    Write-Verbose "$ArtifactsDir\test\checksumfuzz.exe $Options"
+    & $ArtifactsDir\test\checksumfuzz.exe $Options
+
+    if (!$?) {
+        Write-Error "checksumfuzz.exe failed: $LastExitCode"
+    }
+} catch {
+    Write-Error "checksumfuzz failed: $($_ | Out-String)"
+} finally {
+    Pop-Location
+}
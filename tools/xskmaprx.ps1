@@ -3,7 +3,8 @@
 .SYNOPSIS
 This script runs the xskmaprx sample as a smoke test: launches the sample,
 lets it create an XSKMAP and attach an XDP program for a few seconds, then
-terminates it.
+terminates it. The sample is run once in generic mode, then once in native
+mode with zero-copy RX, where it fails unless packets are received.
 
 .PARAMETER Config
     Specifies the build configuration to use.
@@ -72,18 +73,24 @@ try {
     Write-Verbose "Set-NetAdapterRss XDPMP -NumberOfReceiveQueues $QueueCount"
     Set-NetAdapterRss XDPMP -NumberOfReceiveQueues $QueueCount
 
-    $ArgList =
-        "-IfIndex", $IfIndex,
-        "-QueueCount", $QueueCount,
-        "-XdpMode", "Generic",
-        "-TimeoutSeconds", $TimeoutSeconds
-    Write-Verbose "$XskMapRx $ArgList"
-
-    # The sample exits cleanly on its own after -TimeoutSeconds. Wait for it
-    # and propagate its exit code.
-    $Process = Start-Process $XskMapRx -PassThru -ArgumentList $ArgList -NoNewWindow -Wait
-    if ($Process.ExitCode -ne 0) {
-        throw "xskmaprx exited with code $($Process.ExitCode)"
+    $ModeArgs = @(
+        @("-XdpMode", "Generic"),
+        @("-XdpMode", "Native", "-RxZeroCopy")
+    )
+
+    foreach ($Mode in $ModeArgs) {
+        $ArgList =
+            @("-IfIndex", $IfIndex,
+            "-QueueCount", $QueueCount,
+            "-TimeoutSeconds", $TimeoutSeconds) + $Mode
+        Write-Verbose "$XskMapRx $ArgList"
+
+        # The sample exits cleanly on its own after -TimeoutSeconds. Wait for
+        # it and propagate its exit code.
+        $Process = Start-Process $XskMapRx -PassThru -ArgumentList $ArgList -NoNewWindow -Wait
+        if ($Process.ExitCode -ne 0) {
+            throw "xskmaprx $Mode exited with code $($Process.ExitCode)"
+        }
     }
 } finally {
     & "$RootDir\tools\setup.ps1" -Uninstall xdpmp -Config $Config -Platform $Platform -ErrorAction 'Continue'